@@ -162,49 +162,410 @@ void mjd_string_prepend(char* param_ptr_string, const char* param_ptr_part) {
     }
 }
 
+/**********
+ * NUMBER FORMATTERS
+ *
+ * @doc Integers: two digits per division by 100 using a table of the 100 digit pairs "00".."99" (half the divisions of the digit-by-digit loop).
+ * @doc Floats: split into an uint32_t integer part and an uint32_t scaled fraction (rounded half up), then both are formatted as integers.
+ */
+static const char _digit_pairs[200 + 1] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+static const uint32_t _powers_of_10[MJD_FLOAT_STRING_MAX_DECIMALS + 1] =
+    { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+size_t mjd_uint32_to_string(uint32_t param_value, char * param_ptr_output) {
+    char digits[10]; // UINT32_MAX = 4294967295
+    char *ptr_first = digits + sizeof(digits);
+
+    while (param_value >= 100) {
+        const uint32_t idx_pair = (param_value % 100) * 2;
+        param_value /= 100;
+        ptr_first -= 2;
+        ptr_first[0] = _digit_pairs[idx_pair];
+        ptr_first[1] = _digit_pairs[idx_pair + 1];
+    }
+    if (param_value >= 10) {
+        ptr_first -= 2;
+        ptr_first[0] = _digit_pairs[param_value * 2];
+        ptr_first[1] = _digit_pairs[param_value * 2 + 1];
+    } else {
+        *--ptr_first = (char) ('0' + param_value);
+    }
+
+    const size_t len = (size_t) (digits + sizeof(digits) - ptr_first);
+    memcpy(param_ptr_output, ptr_first, len);
+    param_ptr_output[len] = '\0';
+    return len;
+}
+
+size_t mjd_int32_to_string(int32_t param_value, char * param_ptr_output) {
+    if (param_value < 0) {
+        param_ptr_output[0] = '-';
+        return 1 + mjd_uint32_to_string(0U - (uint32_t) param_value, param_ptr_output + 1); // @important Also correct for INT32_MIN
+    }
+    return mjd_uint32_to_string((uint32_t) param_value, param_ptr_output);
+}
+
+size_t mjd_float_to_fixed_string(float param_value, uint32_t param_decimals, char * param_ptr_output) {
+    size_t len = 0;
+
+    if (param_decimals > MJD_FLOAT_STRING_MAX_DECIMALS) {
+        param_decimals = MJD_FLOAT_STRING_MAX_DECIMALS;
+    }
+    if (isnan(param_value)) {
+        strcpy(param_ptr_output, "nan");
+        return 3;
+    }
+    if (signbit(param_value)) {
+        param_ptr_output[len++] = '-';
+        param_value = -param_value;
+    }
+    if (isinf(param_value)) {
+        strcpy(param_ptr_output + len, "inf");
+        return len + 3;
+    }
+    if (param_value >= 4294967040.0f) { // The largest float below 2^32
+        strcpy(param_ptr_output + len, "ovf");
+        return len + 3;
+    }
+
+    const uint32_t scale = _powers_of_10[param_decimals];
+    uint32_t int_part = (uint32_t) param_value;
+    uint32_t frac_part = (uint32_t) ((param_value - (float) int_part) * (float) scale + 0.5f);
+    if (frac_part >= scale) { // Rounding carried into the integer part (e.g. 9.996 => "10.00")
+        frac_part -= scale;
+        ++int_part;
+    }
+
+    len += mjd_uint32_to_string(int_part, param_ptr_output + len);
+    if (param_decimals > 0) {
+        param_ptr_output[len++] = '.';
+        for (uint32_t idx = param_decimals; idx > 0; idx--) { // Zero padded: exactly param_decimals digits
+            param_ptr_output[len + idx - 1] = (char) ('0' + (frac_part % 10));
+            frac_part /= 10;
+        }
+        len += param_decimals;
+    }
+    param_ptr_output[len] = '\0';
+    return len;
+}
+
+/**********
+ * STRING BUILDER (mjd_strbuf)
+ *
+ * @doc The hot path functions do not log: they are called in display & payload loops. A truncation is reported by the return value
+ *      and the sticky is_truncated flag.
+ */
+static esp_err_t _strbuf_append_fill(mjd_strbuf_t* param_ptr_strbuf, char param_char, size_t param_count) {
+    esp_err_t f_retval = ESP_OK;
+
+    const size_t available = param_ptr_strbuf->size - 1 - param_ptr_strbuf->len;
+    if (param_count > available) {
+        param_count = available;
+        param_ptr_strbuf->is_truncated = true;
+        f_retval = ESP_ERR_INVALID_SIZE;
+    }
+    memset(param_ptr_strbuf->ptr_buffer + param_ptr_strbuf->len, param_char, param_count);
+    param_ptr_strbuf->len += param_count;
+    param_ptr_strbuf->ptr_buffer[param_ptr_strbuf->len] = '\0';
+
+    return f_retval;
+}
+
+static esp_err_t _strbuf_append_padded(mjd_strbuf_t* param_ptr_strbuf, const char * param_ptr_chars, size_t param_len,
+                                       uint32_t param_min_width) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_min_width > param_len) {
+        f_retval = _strbuf_append_fill(param_ptr_strbuf, ' ', param_min_width - param_len);
+        if (f_retval != ESP_OK) {
+            // GOTO
+            goto cleanup;
+        }
+    }
+    f_retval = mjd_strbuf_append_n(param_ptr_strbuf, param_ptr_chars, param_len);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_strbuf_init(mjd_strbuf_t* param_ptr_strbuf, char * param_ptr_storage, size_t param_size) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_strbuf == NULL || param_ptr_storage == NULL || param_size == 0) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param (NULL storage or size 0) | err %i (%s)", __FUNCTION__, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    param_ptr_strbuf->ptr_buffer = param_ptr_storage;
+    param_ptr_strbuf->size = param_size;
+    mjd_strbuf_reset(param_ptr_strbuf);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+void mjd_strbuf_reset(mjd_strbuf_t* param_ptr_strbuf) {
+    param_ptr_strbuf->len = 0;
+    param_ptr_strbuf->is_truncated = false;
+    param_ptr_strbuf->ptr_buffer[0] = '\0';
+}
+
+esp_err_t mjd_strbuf_append_n(mjd_strbuf_t* param_ptr_strbuf, const char * param_ptr_chars, size_t param_len) {
+    esp_err_t f_retval = ESP_OK;
+
+    const size_t available = param_ptr_strbuf->size - 1 - param_ptr_strbuf->len;
+    if (param_len > available) {
+        param_len = available;
+        param_ptr_strbuf->is_truncated = true;
+        f_retval = ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(param_ptr_strbuf->ptr_buffer + param_ptr_strbuf->len, param_ptr_chars, param_len);
+    param_ptr_strbuf->len += param_len;
+    param_ptr_strbuf->ptr_buffer[param_ptr_strbuf->len] = '\0';
+
+    return f_retval;
+}
+
+esp_err_t mjd_strbuf_append(mjd_strbuf_t* param_ptr_strbuf, const char * param_ptr_string) {
+    if (param_ptr_string == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return mjd_strbuf_append_n(param_ptr_strbuf, param_ptr_string, strlen(param_ptr_string));
+}
+
+esp_err_t mjd_strbuf_append_char(mjd_strbuf_t* param_ptr_strbuf, char param_char) {
+    return _strbuf_append_fill(param_ptr_strbuf, param_char, 1);
+}
+
+/*
+ * @doc The existing chars shift right (one memmove of the current length); when the result does not fit then the tail is cut off.
+ */
+esp_err_t mjd_strbuf_prepend(mjd_strbuf_t* param_ptr_strbuf, const char * param_ptr_string) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_string == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const size_t capacity = param_ptr_strbuf->size - 1;
+    size_t len_part = strlen(param_ptr_string);
+    size_t len_keep = param_ptr_strbuf->len;
+
+    if (len_part > capacity) {
+        len_part = capacity;
+    }
+    if (len_keep > capacity - len_part) {
+        len_keep = capacity - len_part;
+    }
+    if (len_part + len_keep < strlen(param_ptr_string) + param_ptr_strbuf->len) {
+        param_ptr_strbuf->is_truncated = true;
+        f_retval = ESP_ERR_INVALID_SIZE;
+    }
+
+    memmove(param_ptr_strbuf->ptr_buffer + len_part, param_ptr_strbuf->ptr_buffer, len_keep);
+    memcpy(param_ptr_strbuf->ptr_buffer, param_ptr_string, len_part);
+    param_ptr_strbuf->len = len_part + len_keep;
+    param_ptr_strbuf->ptr_buffer[param_ptr_strbuf->len] = '\0';
+
+    return f_retval;
+}
+
+esp_err_t mjd_strbuf_repeat(mjd_strbuf_t* param_ptr_strbuf, const char * param_ptr_string, uint32_t param_count) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_string == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const size_t len = strlen(param_ptr_string);
+    if (len == 1) {
+        return _strbuf_append_fill(param_ptr_strbuf, param_ptr_string[0], param_count);
+    }
+    for (uint32_t idx = 0; idx < param_count && f_retval == ESP_OK; idx++) {
+        f_retval = mjd_strbuf_append_n(param_ptr_strbuf, param_ptr_string, len);
+    }
+
+    return f_retval;
+}
+
+esp_err_t mjd_strbuf_append_uint(mjd_strbuf_t* param_ptr_strbuf, uint32_t param_value, uint32_t param_min_width) {
+    char digits[MJD_NUMBER_STRING_MAX_SIZE];
+    const size_t len = mjd_uint32_to_string(param_value, digits);
+    return _strbuf_append_padded(param_ptr_strbuf, digits, len, param_min_width);
+}
+
+esp_err_t mjd_strbuf_append_int(mjd_strbuf_t* param_ptr_strbuf, int32_t param_value, uint32_t param_min_width) {
+    char digits[MJD_NUMBER_STRING_MAX_SIZE];
+    const size_t len = mjd_int32_to_string(param_value, digits);
+    return _strbuf_append_padded(param_ptr_strbuf, digits, len, param_min_width);
+}
+
+esp_err_t mjd_strbuf_append_float(mjd_strbuf_t* param_ptr_strbuf, float param_value, uint32_t param_min_width,
+                                  uint32_t param_decimals) {
+    char digits[MJD_NUMBER_STRING_MAX_SIZE];
+    const size_t len = mjd_float_to_fixed_string(param_value, param_decimals, digits);
+    return _strbuf_append_padded(param_ptr_strbuf, digits, len, param_min_width);
+}
+
 /**********
  * HEX STRINGS
+ *
+ * @doc The RN2483 LoRa commands `radio tx` and `radio rx` carry their payload as a hex string, so these functions are on the LoRa hot path.
+ *      The conversions are word-at-a-time (32-bit SWAR: SIMD Within A Register): 2 bytes <=> 4 hex chars per 32-bit register operation,
+ *      without sprintf()/strtoul() and without a branch per character.
+ *
+ * @important The SWAR lanes assume a little-endian CPU (ESP32 Xtensa LX6 and x86 hosts).
+ */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+#error "mjd.c: the SWAR hex string functions require a little-endian CPU"
+#endif
+
+/*
+ * @brief Encode 2 bytes into 4 uppercase hex chars (one 32-bit word, memory order).
+ *
+ * @doc Lane layout of the nibble word: [b0 >> 4, b0 & 0xF, b1 >> 4, b1 & 0xF]
+ *      ASCII: '0' + nibble, plus 7 more for the nibbles 10..15 ('A' - '9' - 1 == 7).
+ *      (nibble + 6) has bit 4 set exactly when nibble >= 10.
  */
+static inline uint32_t _hex_encode_2_bytes(uint32_t param_b0, uint32_t param_b1) {
+    const uint32_t bytes = param_b0 | (param_b1 << 16);
+    const uint32_t nibbles = ((bytes >> 4) & 0x000F000F) | ((bytes & 0x000F000F) << 8);
+    const uint32_t is_letter = ((nibbles + 0x06060606) >> 4) & 0x01010101;
+    return nibbles + 0x30303030 + (is_letter * 7);
+}
+
+/*
+ * @brief Decode 4 hex chars (one 32-bit word, memory order) into 2 bytes.
+ *
+ * @return true when all 4 chars are valid hex digits [0-9A-Fa-f].
+ *
+ * @doc Range check per lane for 7-bit values: (x + (0x80 - lo)) has bit 7 set when x >= lo.
+ *      Folding with 0x20 maps 'A'..'F' onto 'a'..'f' (and no other char lands in that range).
+ */
+static inline bool _hex_decode_4_chars(uint32_t param_chars, uint8_t *param_ptr_output) {
+    const uint32_t is_digit = (param_chars + 0x50505050) & ~(param_chars + 0x46464646);
+    const uint32_t folded = param_chars | 0x20202020;
+    const uint32_t is_letter = (folded + 0x1F1F1F1F) & ~(folded + 0x19191919);
+
+    if (((param_chars & 0x80808080) != 0) || (((is_digit | is_letter) & 0x80808080) != 0x80808080)) {
+        return false;
+    }
+
+    const uint32_t nibbles = (param_chars & 0x0F0F0F0F) + (((is_letter >> 7) & 0x01010101) * 9);
+    const uint32_t packed = (nibbles << 4) | (nibbles >> 8);
+    param_ptr_output[0] = (uint8_t) packed;
+    param_ptr_output[1] = (uint8_t) (packed >> 16);
+    return true;
+}
+
+/*
+ * @brief Encode a buffer; no NULL terminator, no logging (the shared core of the public functions).
+ */
+static void _hex_encode(const uint8_t * param_ptr_input, size_t param_len_input, char * param_ptr_output) {
+    uint32_t words[2];
+    size_t idx = 0;
+
+    // 4 bytes => 8 chars per iteration
+    for (; idx + 4 <= param_len_input; idx += 4) {
+        words[0] = _hex_encode_2_bytes(param_ptr_input[idx], param_ptr_input[idx + 1]);
+        words[1] = _hex_encode_2_bytes(param_ptr_input[idx + 2], param_ptr_input[idx + 3]);
+        memcpy(param_ptr_output + 2 * idx, words, sizeof(words)); // @important memcpy(): the output is not 32-bit aligned
+    }
+    // Tail: 0..3 bytes
+    for (; idx < param_len_input; idx++) {
+        words[0] = _hex_encode_2_bytes(param_ptr_input[idx], 0);
+        memcpy(param_ptr_output + 2 * idx, words, 2);
+    }
+}
 
 esp_err_t mjd_uint8s_to_hexstring(const uint8_t * param_ptr_input, size_t param_len_input, char * param_ptr_output) {
-    strcpy(param_ptr_output, "");
+    esp_err_t f_retval = ESP_OK;
 
-    uint32_t idx_src;
-    uint32_t idx_dst;
-    for (idx_src = 0, idx_dst = 0; idx_src < param_len_input; idx_src++, idx_dst += 2) {
-        sprintf((char*) param_ptr_output + idx_dst, "%02X", param_ptr_input[idx_src]);
+    if (param_ptr_output == NULL || (param_ptr_input == NULL && param_len_input > 0)) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param (NULL) | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
     }
-    param_ptr_output[idx_dst] = '\0';
+
+    _hex_encode(param_ptr_input, param_len_input, param_ptr_output);
+    param_ptr_output[2 * param_len_input] = '\0';
 
     ESP_LOGV(TAG, "mjd_uint8s_to_hexstring() param_ptr_input len=%u (HEXDUMP)", param_len_input);
     ESP_LOG_BUFFER_HEXDUMP(TAG, param_ptr_input, param_len_input, ESP_LOG_VERBOSE);
-    ESP_LOGV(TAG, "mjd_uint8s_to_hexstring() param_ptr_output len=%u (HEXDUMP)", strlen(param_ptr_output));
-    ESP_LOG_BUFFER_HEXDUMP(TAG, param_ptr_output, strlen(param_ptr_output) + 1, ESP_LOG_VERBOSE);  // +1 to see the \0
+    ESP_LOGV(TAG, "mjd_uint8s_to_hexstring() param_ptr_output len=%u (HEXDUMP)", 2 * param_len_input);
+    ESP_LOG_BUFFER_HEXDUMP(TAG, param_ptr_output, 2 * param_len_input + 1, ESP_LOG_VERBOSE);  // +1 to see the \0
 
-    return ESP_OK;
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
 }
 
 esp_err_t mjd_hexstring_to_uint8s(const char * param_ptr_input, size_t param_len_input, uint8_t * param_ptr_output) {
     esp_err_t f_retval = ESP_OK;
 
+    if (param_ptr_output == NULL || (param_ptr_input == NULL && param_len_input > 0)) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param (NULL) | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
     if (param_len_input % 2 != 0) {
-        ESP_LOGE(TAG, "%s(). ABORT. param_ptr_input has an uneven number of characters", __FUNCTION__);
+        f_retval = ESP_ERR_INVALID_SIZE;
+        ESP_LOGE(TAG, "%s(). ABORT. param_ptr_input has an uneven number of characters | err %i (%s)", __FUNCTION__, f_retval,
+                esp_err_to_name(f_retval));
         // GOTO
         goto cleanup;
     }
 
-    char hex_chars[3];
-    uint32_t idx_src, idx_dst;
-    for (idx_src = 0, idx_dst = 0; idx_src < param_len_input; idx_src += 2, idx_dst++) {
-        hex_chars[0] = *(param_ptr_input + idx_src);
-        hex_chars[1] = *(param_ptr_input + idx_src + 1);
-        hex_chars[2] = '\0';
-
-        param_ptr_output[idx_dst] = (uint8_t) strtoul(hex_chars, NULL, 16);
+    uint32_t chars;
+    size_t idx_src;
+    // 4 chars => 2 bytes per iteration
+    for (idx_src = 0; idx_src + 4 <= param_len_input; idx_src += 4) {
+        memcpy(&chars, param_ptr_input + idx_src, sizeof(chars)); // @important memcpy(): the input is not 32-bit aligned
+        if (_hex_decode_4_chars(chars, param_ptr_output + idx_src / 2) == false) {
+            f_retval = ESP_ERR_INVALID_ARG;
+            break;
+        }
+    }
+    // Tail: 0 or 2 chars (padded with "00" so the same word decoder applies)
+    if (f_retval == ESP_OK && idx_src < param_len_input) {
+        uint8_t tail[2];
+        chars = (uint32_t) (uint8_t) param_ptr_input[idx_src] | ((uint32_t) (uint8_t) param_ptr_input[idx_src + 1] << 8) | 0x30300000;
+        if (_hex_decode_4_chars(chars, tail) == false) {
+            f_retval = ESP_ERR_INVALID_ARG;
+        } else {
+            param_ptr_output[idx_src / 2] = tail[0];
+        }
+    }
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. param_ptr_input contains a non-hex character (near pos %u) | err %i (%s)", __FUNCTION__, idx_src,
+                f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
     }
 
     ESP_LOGV(TAG, "mjd_hexstring_to_uint8s() param_ptr_input len=%u (HEXDUMP)", param_len_input);
-    ESP_LOG_BUFFER_HEXDUMP(TAG, param_ptr_input, param_len_input + 1, ESP_LOG_VERBOSE);  // +1 to see the \0
+    ESP_LOG_BUFFER_HEXDUMP(TAG, param_ptr_input, param_len_input, ESP_LOG_VERBOSE);
     ESP_LOGV(TAG, "mjd_hexstring_to_uint8s() param_ptr_output len=%u (HEXDUMP)", param_len_input / 2);
     ESP_LOG_BUFFER_HEXDUMP(TAG, param_ptr_output, param_len_input / 2, ESP_LOG_VERBOSE);
 
@@ -220,8 +581,54 @@ esp_err_t mjd_string_to_hexstring(const char * param_ptr_input, size_t param_len
 }
 
 esp_err_t mjd_hexstring_to_string(const char * param_ptr_input, size_t param_len_input, char * param_ptr_output) {
+    esp_err_t f_retval = ESP_OK;
+
+    f_retval = mjd_hexstring_to_uint8s(param_ptr_input, param_len_input, (uint8_t *) param_ptr_output);
+    if (f_retval == ESP_OK) {
+        param_ptr_output[param_len_input / 2] = '\0';
+    }
 
-    return mjd_hexstring_to_uint8s(param_ptr_input, param_len_input, (uint8_t *) param_ptr_output);
+    return f_retval;
+}
+
+/*
+ * @brief Streaming encoder: hex-encode a buffer straight into the UART TX ring buffer.
+ *
+ * @doc Encodes in chunks of MJD_HEXSTRING_UART_CHUNK_BYTES input bytes via a small stack buffer, so the caller does not need
+ *      a 2*N+1 hex string buffer (e.g. 460+ bytes for a LoRa `radio tx` payload). No NULL terminator is written.
+ */
+#define MJD_HEXSTRING_UART_CHUNK_BYTES (32)
+
+esp_err_t mjd_uint8s_to_hexstring_uart(uart_port_t param_uart_num, const uint8_t * param_ptr_input, size_t param_len_input) {
+    esp_err_t f_retval = ESP_OK;
+
+    char chunk[2 * MJD_HEXSTRING_UART_CHUNK_BYTES];
+
+    if (param_ptr_input == NULL && param_len_input > 0) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param (NULL) | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    for (size_t idx = 0; idx < param_len_input; idx += MJD_HEXSTRING_UART_CHUNK_BYTES) {
+        size_t len_chunk = param_len_input - idx;
+        if (len_chunk > MJD_HEXSTRING_UART_CHUNK_BYTES) {
+            len_chunk = MJD_HEXSTRING_UART_CHUNK_BYTES;
+        }
+        _hex_encode(param_ptr_input + idx, len_chunk, chunk);
+        if (uart_write_bytes(param_uart_num, chunk, 2 * len_chunk) != (int) (2 * len_chunk)) {
+            f_retval = ESP_FAIL;
+            ESP_LOGE(TAG, "%s(). ABORT. uart_write_bytes() failed | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
 }
 
 /**********
@@ -178,9 +178,15 @@ void main_task(void *pvParameter) {
             if (MY_SSD1306_OLED_IS_USED == true) {
                 /////mjd_ssd1306_cmd_clear_screen(&ssd1306_config);
                 char str_line[80];
-                sprintf(str_line, "#%u:", j);
+                mjd_strbuf_t line_strbuf;
+                mjd_strbuf_init(&line_strbuf, str_line, sizeof(str_line));
+                mjd_strbuf_append_char(&line_strbuf, '#');
+                mjd_strbuf_append_uint(&line_strbuf, j, 0);
+                mjd_strbuf_append_char(&line_strbuf, ':');
                 mjd_ssd1306_cmd_write_line(&ssd1306_config, MJD_SSD1306_LINE_NR_1, str_line);
-                sprintf(str_line, "%6.2f cm", jsnsr04t_data.distance_cm);
+                mjd_strbuf_reset(&line_strbuf);
+                mjd_strbuf_append_float(&line_strbuf, jsnsr04t_data.distance_cm, 6, 2);
+                mjd_strbuf_append(&line_strbuf, " cm");
                 mjd_ssd1306_cmd_write_line(&ssd1306_config, MJD_SSD1306_LINE_NR_2, str_line);
             }
         } else {
@@ -190,7 +196,11 @@ void main_task(void *pvParameter) {
             if (MY_SSD1306_OLED_IS_USED == true) {
                 /////mjd_ssd1306_cmd_clear_screen(&ssd1306_config);
                 char str_line[80];
-                sprintf(str_line, "#%u cm:", j);
+                mjd_strbuf_t line_strbuf;
+                mjd_strbuf_init(&line_strbuf, str_line, sizeof(str_line));
+                mjd_strbuf_append_char(&line_strbuf, '#');
+                mjd_strbuf_append_uint(&line_strbuf, j, 0);
+                mjd_strbuf_append(&line_strbuf, " cm:");
                 mjd_ssd1306_cmd_write_line(&ssd1306_config, MJD_SSD1306_LINE_NR_1, str_line);
                 mjd_ssd1306_cmd_write_line(&ssd1306_config, MJD_SSD1306_LINE_NR_2, "ERROR");
             }
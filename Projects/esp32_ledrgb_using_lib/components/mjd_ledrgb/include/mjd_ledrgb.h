@@ -20,6 +20,16 @@ extern "C" {
 #define MY_RMT_CLK_DIV (4)
 #define MY_RMT_ONE_TICK_DURATION_NANOSEC (50.0)
 
+/**
+ * FRAME BUFFERS
+ *
+ * @doc The pixels are rendered (color sequence, brightness, gamma) into a frame buffer of 3 bytes per LED.
+ *      The RMT driver translates that frame buffer on the fly into RMT items while its channel memory drains (rmt_write_sample()
+ *      with a translator), so there is no buffer with 24 RMT items (96 bytes) per LED anymore.
+ * @doc Two frame buffers: the app renders the next frame while the RMT still transmits the previous one.
+ */
+#define MJD_LEDRGB_NBR_OF_FRAME_BUFFERS (2)
+
 /**
  * Data Definitions
  */
@@ -43,6 +53,11 @@ typedef enum {
 } mjd_ledrgb_strip_identifier_t;
 
 
+/**
+ * @brief A bit mask of LED Strips for the multi-strip functions, e.g. MJD_LEDRGB_STRIP_MASK(MJD_STRIP_1) | MJD_LEDRGB_STRIP_MASK(MJD_STRIP_2)
+ */
+#define MJD_LEDRGB_STRIP_MASK(strip_id) (1U << (strip_id))
+
 /**
  * @brief The list of each LED number of the LED strip/board.
  */
@@ -173,7 +188,7 @@ typedef struct {
 /**
  * @brief A Helper func to create a led object
  */
-inline mjd_ledrgb_led_t mjd_led_rgb(uint8_t r, uint8_t g, uint8_t b) {
+static inline mjd_ledrgb_led_t mjd_led_rgb(uint8_t r, uint8_t g, uint8_t b) {
     mjd_ledrgb_led_t led;
     led.r = r;
     led.g = g;
@@ -200,10 +215,12 @@ typedef struct {
         mjd_ledrgb_led_type_t led_type; /*!< The LED Type */
         uint32_t nbr_of_leds; /*!< The number of LED chips that are integrated in this LED Strip. */
         uint8_t relative_brightness; /*!< A percentage that is applied to all LED color values before sending the pixels to the LED Strip. 25% = good value for indoors */
+        bool is_gamma_corrected; /*!< Apply a gamma 2.8 curve to the color values (the perceived brightness becomes linear with the color value) */
 } mjd_ledrgb_config_t;
 
 #define MJD_LEDRGB_CONFIG_DEFAULT() { \
-    .relative_brightness = 25 \
+    .relative_brightness = 25, \
+    .is_gamma_corrected = false \
 }
 
 typedef struct {
@@ -213,17 +230,18 @@ typedef struct {
         mjd_ledrgb_led_type_t led_type; /*!< The LED Type */
         uint32_t nbr_of_leds; /*!< The number of LED chips that are integrated in this LED Strip */
         uint8_t relative_brightness; /*!< A percentage that is applied to all LED color values before sending the pixels to the LED Strip. 25% = good value for indoors */
+        bool is_gamma_corrected; /*!< Apply a gamma 2.8 curve to the color values */
         // Private
         bool is_init;
         mjd_ledrgb_color_sequence_t color_sequence; /*!< Which color sequence protocol is used. @source led_type */
         uint8_t nbr_of_colors; /*!< The number of colors that are integrated in each LED chip of this LED Strip. @source led_type */
         mjd_ledrgb_led_t *leds; /*!< The actual LED color values */
-        uint32_t len_transformation_buffer; /*!< 32bit! The length of the transformation buffer */
-        uint8_t *transformation_buffer; /*!< The buffer to transform the input color values to the device-specific values. It also applies the relative brightness */
+        uint8_t *color_lut; /*!< 256 entries: color value => transmitted value (gamma + relative brightness in 8-bit fixed point) */
+        uint32_t len_frame_buffer; /*!< 32bit! The length of each frame buffer (nbr_of_leds * nbr_of_colors) */
+        uint8_t *frame_buffers[MJD_LEDRGB_NBR_OF_FRAME_BUFFERS]; /*!< The device-specific color values (color sequence, brightness, gamma) */
+        uint8_t idx_back_frame_buffer; /*!< The frame buffer that is not being transmitted: the next frame is rendered in this one */
         rmt_channel_t rmt_channel; /*!< The RMT Channel to be used. @limitation Cannot use the same RMT Channel for multiple LED strips */
         rmt_item32_t rmt_item_pulse_pairs[MJD_RMT_PULSE_TYPE_MAX]; /*!< The elementary RMT Transmission pulses that are computed for this specific LED Strip */
-        uint32_t nbr_of_rmt_tx_items; /*!< 32bit! The number of RMT Transmission Items to be sent to the LED Strip */
-        rmt_item32_t *rmt_tx_items;/*!< The list of RMT Transmission Items to be sent to the LED Strip */
 } mjd_ledrgb_strip_t;
 
 /**
@@ -273,6 +291,79 @@ esp_err_t mjd_ledrgb_get_strip_nbr_of_leds(mjd_ledrgb_strip_identifier_t param_s
  */
 esp_err_t mjd_ledrgb_send_pixels_to_strip(mjd_ledrgb_strip_identifier_t param_strip_id);
 
+/**
+ * @brief Submit the pixels to the LED Strip without waiting for the end of the transmission (async).
+ *        The pixels are rendered into the back frame buffer, the function waits until the previous frame has been transmitted
+ *        and then starts the RMT transmission of the new frame.
+ *
+ * @important The LED color values can be changed right after the call (the frame buffer holds a copy).
+ *
+ * @param param_strip_id A reference to the LED Strip as used in mjd_ledrgb_init()
+ *
+ * @return
+ *     - ESP_OK Success
+ */
+esp_err_t mjd_ledrgb_submit_pixels_to_strip(mjd_ledrgb_strip_identifier_t param_strip_id);
+
+/**
+ * @brief Wait until the last frame that was submitted to the LED Strip has been transmitted (incl. the Treset latch pulse).
+ *
+ * @param param_strip_id      A reference to the LED Strip as used in mjd_ledrgb_init()
+ * @param param_ticks_to_wait The max wait time in RTOS ticks (portMAX_DELAY = forever)
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_TIMEOUT The transmission is still busy
+ */
+esp_err_t mjd_ledrgb_wait_strip_tx_done(mjd_ledrgb_strip_identifier_t param_strip_id, TickType_t param_ticks_to_wait);
+
+/**
+ * @brief Submit the pixels to several LED Strips with a single frame sync (async).
+ *        The frames of all strips are rendered, the function waits until the previous frame of ALL strips has been transmitted,
+ *        and then starts the RMT channels back to back so the strips transmit in parallel.
+ *
+ * @param param_strip_mask A bit mask of the LED Strips, see MJD_LEDRGB_STRIP_MASK()
+ *
+ * @return
+ *     - ESP_OK Success
+ */
+esp_err_t mjd_ledrgb_submit_pixels_to_strips(uint32_t param_strip_mask);
+
+/**
+ * @brief Wait until the last frame that was submitted to each LED Strip of the mask has been transmitted.
+ *
+ * @param param_strip_mask    A bit mask of the LED Strips, see MJD_LEDRGB_STRIP_MASK()
+ * @param param_ticks_to_wait The max wait time in RTOS ticks per LED Strip (portMAX_DELAY = forever)
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_TIMEOUT A transmission is still busy
+ */
+esp_err_t mjd_ledrgb_wait_strips_tx_done(uint32_t param_strip_mask, TickType_t param_ticks_to_wait);
+
+/**
+ * @brief Get the array of LED color values of a LED Strip (nbr_of_leds elements), e.g. to render effects in place.
+ *
+ * @important The array is owned by the component (valid until mjd_ledrgb_deinit()). Do not write it from 2 tasks at the same time.
+ *
+ * @param param_strip_id A reference to the LED Strip as used in mjd_ledrgb_init()
+ *
+ * @return
+ *     - A pointer to the LED color values
+ *     - NULL The strip is not initialized
+ */
+mjd_ledrgb_led_t * mjd_ledrgb_get_strip_leds(mjd_ledrgb_strip_identifier_t param_strip_id);
+
+/**
+ * @brief Change the relative brightness (percentage 0..100) of a LED Strip. It applies to the next frame.
+ *
+ * @param param_strip_id A reference to the LED Strip as used in mjd_ledrgb_init()
+ *
+ * @return
+ *     - ESP_OK Success
+ */
+esp_err_t mjd_ledrgb_set_strip_brightness(mjd_ledrgb_strip_identifier_t param_strip_id, uint8_t param_relative_brightness);
+
 /**
  * @brief A helper func to reset the pixels of each LED of the LED Strip to zero (white).
  *
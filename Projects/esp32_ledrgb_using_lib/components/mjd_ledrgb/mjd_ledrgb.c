@@ -27,9 +27,140 @@ static const mjd_ledrgb_strip_characteristics_t STRIP_CHARACTERISTICS[] =
             [MJD_LED_TYPE_TEST] =
                 { .color_sequence = MJD_COLOR_SEQUENCE_GRB, .T1high = 999, .T1low = 299, .T0high = 299, .T0low = 999, .Treset = 299999 } };
 
-static mjd_ledrgb_strip_t STRIPS[8] =
+// Gamma 2.8 correction curve | round((i/255)^2.8 * 255)
+static const uint8_t GAMMA_LUT[256] =
+    {
+              0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   1,
+              1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+              2,   3,   3,   3,   3,   3,   3,   3,   4,   4,   4,   4,   4,   5,   5,   5,
+              5,   6,   6,   6,   6,   7,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,
+             10,  10,  11,  11,  11,  12,  12,  13,  13,  13,  14,  14,  15,  15,  16,  16,
+             17,  17,  18,  18,  19,  19,  20,  20,  21,  21,  22,  22,  23,  24,  24,  25,
+             25,  26,  27,  27,  28,  29,  29,  30,  31,  32,  32,  33,  34,  35,  35,  36,
+             37,  38,  39,  39,  40,  41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  50,
+             51,  52,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,  64,  66,  67,  68,
+             69,  70,  72,  73,  74,  75,  77,  78,  79,  81,  82,  83,  85,  86,  87,  89,
+             90,  92,  93,  95,  96,  98,  99, 101, 102, 104, 105, 107, 109, 110, 112, 114,
+            115, 117, 119, 120, 122, 124, 126, 127, 129, 131, 133, 135, 137, 138, 140, 142,
+            144, 146, 148, 150, 152, 154, 156, 158, 160, 162, 164, 167, 169, 171, 173, 175,
+            177, 180, 182, 184, 186, 189, 191, 193, 196, 198, 200, 203, 205, 208, 210, 213,
+            215, 218, 220, 223, 225, 228, 231, 233, 236, 239, 241, 244, 247, 249, 252, 255 };
+
+static mjd_ledrgb_strip_t STRIPS[MJD_STRIP_IDENTIFIER_MAX] =
     { 0 };
 
+/**************************************
+ * PRIVATE.
+ *
+ */
+
+/*
+ * @brief Fill the color LUT of the strip: color value => transmitted value.
+ *
+ * @doc The relative brightness is applied in 8-bit fixed point (100% => 256) so the render loop is a table lookup per color byte.
+ */
+static void _compute_color_lut(mjd_ledrgb_strip_t *param_ptr_strip) {
+    const uint32_t scale = ((uint32_t) param_ptr_strip->relative_brightness * 256 + 50) / 100;
+
+    for (uint32_t value = 0; value < 256; value++) {
+        uint32_t base = (param_ptr_strip->is_gamma_corrected == true) ? GAMMA_LUT[value] : value;
+        param_ptr_strip->color_lut[value] = (base * scale + 128) >> 8;
+    }
+}
+
+/*
+ * @brief Render the LED color values into a frame buffer (color sequence + color LUT).
+ */
+static void _render_frame(const mjd_ledrgb_strip_t *param_ptr_strip, uint8_t *param_ptr_frame) {
+    const uint8_t *lut = param_ptr_strip->color_lut;
+    const mjd_ledrgb_led_t *ptr_led = param_ptr_strip->leds;
+    const mjd_ledrgb_led_t *ptr_end = ptr_led + param_ptr_strip->nbr_of_leds;
+
+    if (param_ptr_strip->color_sequence == MJD_COLOR_SEQUENCE_GRB) { // WS2812B
+        for (; ptr_led < ptr_end; ++ptr_led) {
+            *param_ptr_frame++ = lut[ptr_led->g];
+            *param_ptr_frame++ = lut[ptr_led->r];
+            *param_ptr_frame++ = lut[ptr_led->b];
+        }
+    } else { // MJD_COLOR_SEQUENCE_RGB For future new led strip types
+        for (; ptr_led < ptr_end; ++ptr_led) {
+            *param_ptr_frame++ = lut[ptr_led->r];
+            *param_ptr_frame++ = lut[ptr_led->g];
+            *param_ptr_frame++ = lut[ptr_led->b];
+        }
+    }
+}
+
+/*
+ * @brief RMT translator: frame buffer bytes => RMT items using the NRZ 1-Wire protocol. Shift bits out, MSB first!
+ *
+ * @doc The RMT driver calls it repeatedly (also from its ISR) with the remaining part of the frame buffer, each time to fill at most
+ *      wanted_num items of the RMT channel memory. The RMT driver appends the RMT End Marker itself.
+ * @doc The Treset pulse is added after the bits of the last byte: all LED chips synchronously latch the received data when the DIN port
+ *      receives a Reset signal. The last byte is kept back until there is room for its 8 bit items + the Treset item.
+ *
+ * @important IRAM + no logging: it runs in the RMT interrupt.
+ */
+static inline void IRAM_ATTR _rmt_translate(const mjd_ledrgb_strip_t *param_ptr_strip, const void *src, rmt_item32_t *dest, size_t src_size,
+                                            size_t wanted_num, size_t *translated_size, size_t *item_num) {
+    const uint8_t *ptr_src = (const uint8_t *) src;
+    const uint32_t bit0 = param_ptr_strip->rmt_item_pulse_pairs[MJD_RMT_PULSE_TYPE_BITVALUE_ZERO].val;
+    const uint32_t bit1 = param_ptr_strip->rmt_item_pulse_pairs[MJD_RMT_PULSE_TYPE_BITVALUE_ONE].val;
+    size_t size = 0;
+    size_t num = 0;
+
+    while (size < src_size && num + 8 <= wanted_num) {
+        const bool is_last_byte = (size + 1 == src_size);
+        if (is_last_byte == true && num + 8 + 1 > wanted_num) {
+            break;
+        }
+        const uint8_t input_byte = ptr_src[size];
+        for (uint8_t mask = 0x80; mask != 0; mask >>= 1) {
+            dest[num++].val = (input_byte & mask) ? bit1 : bit0;
+        }
+        ++size;
+        if (is_last_byte == true) {
+            dest[num++] = param_ptr_strip->rmt_item_pulse_pairs[MJD_RMT_PULSE_TYPE_RESET];
+        }
+    }
+
+    *translated_size = size;
+    *item_num = num;
+}
+
+/*
+ * @doc The translator callback of the RMT driver has no user context parameter, so there is one tiny wrapper per strip (= per RMT channel).
+ */
+#define _MJD_LEDRGB_DEFINE_TRANSLATOR(strip_idx) \
+    static void IRAM_ATTR _rmt_translator_strip_##strip_idx(const void *src, rmt_item32_t *dest, size_t src_size, size_t wanted_num, \
+                                                            size_t *translated_size, size_t *item_num) { \
+        _rmt_translate(&STRIPS[strip_idx], src, dest, src_size, wanted_num, translated_size, item_num); \
+    }
+
+_MJD_LEDRGB_DEFINE_TRANSLATOR(0)
+_MJD_LEDRGB_DEFINE_TRANSLATOR(1)
+_MJD_LEDRGB_DEFINE_TRANSLATOR(2)
+_MJD_LEDRGB_DEFINE_TRANSLATOR(3)
+_MJD_LEDRGB_DEFINE_TRANSLATOR(4)
+_MJD_LEDRGB_DEFINE_TRANSLATOR(5)
+_MJD_LEDRGB_DEFINE_TRANSLATOR(6)
+_MJD_LEDRGB_DEFINE_TRANSLATOR(7)
+
+static const sample_to_rmt_t RMT_TRANSLATORS[MJD_STRIP_IDENTIFIER_MAX] =
+    { _rmt_translator_strip_0, _rmt_translator_strip_1, _rmt_translator_strip_2, _rmt_translator_strip_3, _rmt_translator_strip_4,
+            _rmt_translator_strip_5, _rmt_translator_strip_6, _rmt_translator_strip_7 };
+
+/*
+ * @brief Check the strip_id and return the strip if it is initialized (else NULL).
+ */
+static mjd_ledrgb_strip_t * _get_init_strip(mjd_ledrgb_strip_identifier_t param_strip_id) {
+    if (param_strip_id >= MJD_STRIP_IDENTIFIER_MAX || STRIPS[param_strip_id].is_init != true) {
+        return NULL;
+    }
+    return &STRIPS[param_strip_id];
+}
+
 /**************************************
  * PUBLIC.
  *
@@ -76,6 +207,12 @@ esp_err_t mjd_ledrgb_init(mjd_ledrgb_config_t* ptr_param_config) {
         // GOTO
         goto cleanup;
     }
+    if (ptr_param_config->relative_brightness > 100) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "ABORT. relative_brightness > 100 | err %i (%s)", f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
 
     /**************************************************************************
      * Process config input data
@@ -94,11 +231,12 @@ esp_err_t mjd_ledrgb_init(mjd_ledrgb_config_t* ptr_param_config) {
     ptr_strip->led_type = ptr_param_config->led_type;
     ptr_strip->nbr_of_leds = ptr_param_config->nbr_of_leds;
     ptr_strip->relative_brightness = ptr_param_config->relative_brightness;
+    ptr_strip->is_gamma_corrected = ptr_param_config->is_gamma_corrected;
 
     /**************************************************************************
      * Compute derived data
      */
-    ptr_strip->rmt_channel = ptr_strip->strip_id;
+    ptr_strip->rmt_channel = (rmt_channel_t) ptr_strip->strip_id; // @doc Strip N uses RMT channel N
 
     mjd_ledrgb_strip_characteristics_t strip_characteristics = STRIP_CHARACTERISTICS[ptr_strip->led_type];
 
@@ -144,8 +282,30 @@ esp_err_t mjd_ledrgb_init(mjd_ledrgb_config_t* ptr_param_config) {
     /**************************************************************************
      * RMT INIT
      *
-     * TODO mem_block_num. 1. Maybe larger number required for larger LED strips?
-     * TODO mem_block_num. 2. Tune the number of blocks (max 8) depending on the actual number of RMT Channels used (=number of LED strips connected).
+     * mem_block_num 1 (64 items) is enough for any strip length: the translator refills the RMT channel memory while it drains.
+     * TODO mem_block_num. Tune the number of blocks (max 8) depending on the actual number of RMT Channels used (=number of LED strips connected).
+     *   DIVIDER examples for ABP clock freq of 80Mhz:
+     *                                  --DIVIDER---
+     *      80 Mhz: esp_clk_apb_freq() /        1  = 80000000 ticks/second  ERROR [@problem min=2]
+     *      40 Mhz: esp_clk_apb_freq() /        2  = 40000000 ticks/second  OK
+     *      10 Mhz: esp_clk_apb_freq() /        8  = 10000000 ticks/second  OK
+     *       5 Mhz: esp_clk_apb_freq() /       16  =  5000000 ticks/second  OK
+     *       1 Mhz: esp_clk_apb_freq() /       80  =  1000000 ticks/second  OK
+     *     100 Khz: esp_clk_apb_freq() /      800  =   100000 ticks/second  OK
+     *      10 Khz: esp_clk_apb_freq() /     8000  =    10000 ticks/second  OK
+     *    1.25 Khz: esp_clk_apb_freq() /    64000  =     1250 ticks/second  OK
+     *       1 Khz: esp_clk_apb_freq() /    80000  =     1000 ticks/second  ERROR [@problem max=65536]
+     *     100 Hz : esp_clk_apb_freq() /   800000  =      100 ticks/second  ERROR [@problem max=65536]
+     *      10 Hz : esp_clk_apb_freq() /  8000000  =       10 ticks/second  ERROR [@problem max=65536]
+     *       1 Hz : esp_clk_apb_freq() / 80000000  =        1 ticks/second  ERROR [@problem max=65536]
+     *
+     *       Kolban:
+     *       - The base clock runs by default at 80MHz. That means it ticks 80,000,000 times a second or 80,000 times a millisecond
+     *         or 80 times a microsecond or 0.08 times a nano second.
+     *         Flipping this around, our granularity of interval is 1/80,000,000 is 0.0000000125 seconds or 0.0000125 milliseconds
+     *         or 0.0125 microseconds or 12.5 nanoseconds. This is fast.
+     *       - About the clock divider value. If the base clock is 80MHz then a divisor of 80 gives us 1MHz.
+     *
      */
     rmt_config_t rmt_cfg =
         { 0 };
@@ -171,17 +331,45 @@ esp_err_t mjd_ledrgb_init(mjd_ledrgb_config_t* ptr_param_config) {
         // GOTO
         goto cleanup;
     }
+    f_retval = rmt_translator_init(rmt_cfg.channel, RMT_TRANSLATORS[ptr_strip->strip_id]);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "rmt_translator_init() err %i (%s)", f_retval, esp_err_to_name(f_retval));
+        rmt_driver_uninstall(rmt_cfg.channel);
+        // GOTO
+        goto cleanup;
+    }
 
     /*************************************************************************
      * Allocate storage
+     *      RAM per LED: 3 bytes (leds) + 2 * 3 bytes (frame_buffers). The RMT items are translated on the fly (no RAM per LED).
+     *      @important The frame buffers MUST be on the heap (not the stack!): the RMT ISR reads them.
      */
     ptr_strip->leds = (mjd_ledrgb_led_t*) calloc(ptr_strip->nbr_of_leds, sizeof(mjd_ledrgb_led_t));
+    ptr_strip->color_lut = (uint8_t*) calloc(256, sizeof(uint8_t));
 
-    ptr_strip->len_transformation_buffer = ptr_strip->nbr_of_leds * sizeof(mjd_ledrgb_led_t);
-    ptr_strip->transformation_buffer = (uint8_t*) calloc(ptr_strip->len_transformation_buffer, sizeof(uint8_t));
+    ptr_strip->len_frame_buffer = ptr_strip->nbr_of_leds * ptr_strip->nbr_of_colors;
+    for (uint32_t idx = 0; idx < MJD_LEDRGB_NBR_OF_FRAME_BUFFERS; idx++) {
+        ptr_strip->frame_buffers[idx] = (uint8_t*) calloc(ptr_strip->len_frame_buffer, sizeof(uint8_t));
+    }
+    ptr_strip->idx_back_frame_buffer = 0;
+
+    if (ptr_strip->leds == NULL || ptr_strip->color_lut == NULL || ptr_strip->frame_buffers[0] == NULL || ptr_strip->frame_buffers[1] == NULL) {
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "ABORT. calloc() failed | err %i (%s)", f_retval, esp_err_to_name(f_retval));
+        free(ptr_strip->leds);
+        ptr_strip->leds = NULL;
+        free(ptr_strip->color_lut);
+        ptr_strip->color_lut = NULL;
+        for (uint32_t idx = 0; idx < MJD_LEDRGB_NBR_OF_FRAME_BUFFERS; idx++) {
+            free(ptr_strip->frame_buffers[idx]);
+            ptr_strip->frame_buffers[idx] = NULL;
+        }
+        rmt_driver_uninstall(rmt_cfg.channel);
+        // GOTO
+        goto cleanup;
+    }
 
-    ptr_strip->nbr_of_rmt_tx_items = 2 + (8 * ptr_strip->len_transformation_buffer);
-    ptr_strip->rmt_tx_items = (rmt_item32_t*) calloc(ptr_strip->nbr_of_rmt_tx_items, sizeof(rmt_item32_t));
+    _compute_color_lut(ptr_strip);
 
     /**************************************************************************
      * Init := true
@@ -230,12 +418,21 @@ esp_err_t mjd_ledrgb_deinit(mjd_ledrgb_strip_identifier_t param_strip_id) {
 
     /**************************************************************************
      * FREE memory
+     *      @important The RMT ISR might still be reading the frame buffer that was submitted last.
      */
-    free(ptr_strip->transformation_buffer);
-    ptr_strip->len_transformation_buffer = 0;
+    rmt_wait_tx_done(ptr_strip->rmt_channel, portMAX_DELAY);
+
+    free(ptr_strip->leds);
+    ptr_strip->leds = NULL;
 
-    free(ptr_strip->rmt_tx_items);
-    ptr_strip->nbr_of_rmt_tx_items = 0;
+    free(ptr_strip->color_lut);
+    ptr_strip->color_lut = NULL;
+
+    for (uint32_t idx = 0; idx < MJD_LEDRGB_NBR_OF_FRAME_BUFFERS; idx++) {
+        free(ptr_strip->frame_buffers[idx]);
+        ptr_strip->frame_buffers[idx] = NULL;
+    }
+    ptr_strip->len_frame_buffer = 0;
 
     /**************************************************************************
      * RMT DRV UNINSTALL
@@ -303,6 +500,37 @@ esp_err_t mjd_ledrgb_send_pixels_to_strip(mjd_ledrgb_strip_identifier_t param_st
      */
     esp_err_t f_retval = ESP_OK;
 
+    /**************************************************************************
+     * MAIN
+     */
+    f_retval = mjd_ledrgb_submit_pixels_to_strip(param_strip_id);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+
+    f_retval = mjd_ledrgb_wait_strip_tx_done(param_strip_id, portMAX_DELAY);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+
+    /**************************************************************************
+     * LABEL cleanup
+     */
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_ledrgb_submit_pixels_to_strip(mjd_ledrgb_strip_identifier_t param_strip_id) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    /**************************************************************************
+     * Reuseable variables
+     */
+    esp_err_t f_retval = ESP_OK;
+
     /**************************************************************************
      * Check
      */
@@ -313,123 +541,229 @@ esp_err_t mjd_ledrgb_send_pixels_to_strip(mjd_ledrgb_strip_identifier_t param_st
         goto cleanup;
     }
 
-    mjd_ledrgb_strip_t *ptr_strip = &STRIPS[param_strip_id];
+    /**************************************************************************
+     * MAIN
+     */
+    f_retval = mjd_ledrgb_submit_pixels_to_strips(MJD_LEDRGB_STRIP_MASK(param_strip_id));
+
+    /**************************************************************************
+     * LABEL cleanup
+     */
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_ledrgb_submit_pixels_to_strips(uint32_t param_strip_mask) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    /**************************************************************************
+     * Reuseable variables
+     */
+    esp_err_t f_retval = ESP_OK;
+
+    /**************************************************************************
+     * Check
+     */
+    if (param_strip_mask == 0 || param_strip_mask >= MJD_LEDRGB_STRIP_MASK(MJD_STRIP_IDENTIFIER_MAX)) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "ABORT. param_strip_mask invalid (0x%X) | err %i (%s)", param_strip_mask, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    for (uint32_t idx = 0; idx < MJD_STRIP_IDENTIFIER_MAX; idx++) {
+        if ((param_strip_mask & MJD_LEDRGB_STRIP_MASK(idx)) != 0 && _get_init_strip(idx) == NULL) {
+            f_retval = ESP_FAIL;
+            ESP_LOGE(TAG, "ABORT. strip #%u not initialized | err %i (%s)", idx, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+    }
 
     /*************************************************************************
-     * Fill the .transformation_buffer (RGB to GRB)
+     * Render the next frame of each strip in its back frame buffer (the RMT might still be transmitting the front frame buffer)
      * @dep led strip's color sequence
-     * @dep led strip's relative_brightness
+     * @dep led strip's color LUT (relative_brightness, gamma)
      */
-    for (uint32_t i = 0; i < ptr_strip->nbr_of_leds; i++) {
-        if (ptr_strip->color_sequence == MJD_COLOR_SEQUENCE_GRB) { // WS2812B
-            ptr_strip->transformation_buffer[0 + (i * ptr_strip->nbr_of_colors)] = (double) ptr_strip->leds[i].g * ptr_strip->relative_brightness
-                    / 100.0;
-            ptr_strip->transformation_buffer[1 + (i * ptr_strip->nbr_of_colors)] = (double) ptr_strip->leds[i].r * ptr_strip->relative_brightness
-                    / 100.0;
-            ptr_strip->transformation_buffer[2 + (i * ptr_strip->nbr_of_colors)] = (double) ptr_strip->leds[i].b * ptr_strip->relative_brightness
-                    / 100.0;
-        } else if (ptr_strip->color_sequence == MJD_COLOR_SEQUENCE_RGB) { // For future new led strip types
-            ptr_strip->transformation_buffer[0 + (i * ptr_strip->nbr_of_colors)] = (double) ptr_strip->leds[i].r * ptr_strip->relative_brightness
-                    / 100.0;
-            ptr_strip->transformation_buffer[1 + (i * ptr_strip->nbr_of_colors)] = (double) ptr_strip->leds[i].g * ptr_strip->relative_brightness
-                    / 100.0;
-            ptr_strip->transformation_buffer[2 + (i * ptr_strip->nbr_of_colors)] = (double) ptr_strip->leds[i].b * ptr_strip->relative_brightness
-                    / 100.0;
-        } else {
-            ESP_LOGW(TAG, "Invalid color sequence (not grb");
+    for (uint32_t idx = 0; idx < MJD_STRIP_IDENTIFIER_MAX; idx++) {
+        if ((param_strip_mask & MJD_LEDRGB_STRIP_MASK(idx)) == 0) {
+            continue;
         }
+        mjd_ledrgb_strip_t *ptr_strip = &STRIPS[idx];
+        uint8_t *ptr_frame = ptr_strip->frame_buffers[ptr_strip->idx_back_frame_buffer];
+
+        _render_frame(ptr_strip, ptr_frame);
+
+        ESP_LOGD(TAG, "DEBUG strip #%u frame buffer #%u (len %u)", idx, ptr_strip->idx_back_frame_buffer, ptr_strip->len_frame_buffer);
+        ESP_LOG_BUFFER_HEX_LEVEL(TAG, ptr_frame, ptr_strip->len_frame_buffer, ESP_LOG_DEBUG);
     }
 
-    ESP_LOGD(TAG, "DEBUG transformation_buffer");
-    ESP_LOGD(TAG, "    ptr_strip->nbr_of_leds = %u", ptr_strip->nbr_of_leds);
-    ESP_LOGD(TAG, "    ptr_strip->nbr_of_colors = %u", ptr_strip->nbr_of_colors);
-    ESP_LOGD(TAG, "    ptr_strip->len_transformation_buffer = %u", ptr_strip->len_transformation_buffer);
-    ESP_LOGD(TAG, "    ESP_LOG_BUFFER_HEX_LEVEL()");
-    ESP_LOG_BUFFER_HEX_LEVEL(TAG, ptr_strip->transformation_buffer, ptr_strip->len_transformation_buffer, ESP_LOG_DEBUG);
+    /**************************************************************************
+     * Frame sync: wait until the previous frame of ALL strips has been transmitted
+     */
+    for (uint32_t idx = 0; idx < MJD_STRIP_IDENTIFIER_MAX; idx++) {
+        if ((param_strip_mask & MJD_LEDRGB_STRIP_MASK(idx)) == 0) {
+            continue;
+        }
+        f_retval = rmt_wait_tx_done(STRIPS[idx].rmt_channel, portMAX_DELAY);
+        if (f_retval != ESP_OK) {
+            ESP_LOGE(TAG, "rmt_wait_tx_done(strip #%u) err %i (%s)", idx, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+    }
 
-    // DEVTEMP: HALT
-    /////mjd_rtos_wait_forever();
+    /**************************************************************************
+     * RMT WRITE (async)
+     *      Start the RMT channels back to back (the RMT channels transmit in parallel), then swap the frame buffers.
+     */
+    for (uint32_t idx = 0; idx < MJD_STRIP_IDENTIFIER_MAX; idx++) {
+        if ((param_strip_mask & MJD_LEDRGB_STRIP_MASK(idx)) == 0) {
+            continue;
+        }
+        mjd_ledrgb_strip_t *ptr_strip = &STRIPS[idx];
+
+        f_retval = rmt_write_sample(ptr_strip->rmt_channel, ptr_strip->frame_buffers[ptr_strip->idx_back_frame_buffer],
+                ptr_strip->len_frame_buffer, false);
+        if (f_retval != ESP_OK) {
+            ESP_LOGE(TAG, "rmt_write_sample(strip #%u) err %i (%s)", idx, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
 
-    /*************************************************************************
-     * Fill RMT TX items using NRZ 1-Wire protocol.
-     *      Shift bits out, MSB first! Transform transformation_buffer bits to rmt_tx_items
-     *      8 bits in each buffer byte. 1 extra item for the trailing Treset pulses. 1 extra item for the trailing RMT End Markers.
-     *      @important rmt_tx_items MUST be on the heap (not the stack!)
-     *      @doc https://overiq.com/c-programming/101/pointer-basics-in-c/
+        ptr_strip->idx_back_frame_buffer = (ptr_strip->idx_back_frame_buffer + 1) % MJD_LEDRGB_NBR_OF_FRAME_BUFFERS;
+    }
+
+    /**************************************************************************
+     * LABEL cleanup
      */
-    rmt_item32_t *ptr_fill_rmt_item = ptr_strip->rmt_tx_items;
+    cleanup: ;
 
-    ESP_LOGD(TAG, "DEBUG (OK equal) Address of rmt_tx_items: %p | Address of ptr_fill_rmt_item %p", ptr_strip->rmt_tx_items, ptr_fill_rmt_item);
+    return f_retval;
+}
 
-    for (uint32_t j = 0; j < ptr_strip->len_transformation_buffer; j++) {
-        uint8_t input_byte = ptr_strip->transformation_buffer[j];
-        ESP_LOGD(TAG, "  j: %u | input_byte: %u", j, input_byte);
-        for (int8_t bit = 7; bit >= 0; --bit) {
-            uint8_t bitvalue = (input_byte >> bit) & 0x01;
-            *ptr_fill_rmt_item = ptr_strip->rmt_item_pulse_pairs[bitvalue]; // bitvalue~>array_index @important *ptr = indirection pointer
+esp_err_t mjd_ledrgb_wait_strips_tx_done(uint32_t param_strip_mask, TickType_t param_ticks_to_wait) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
 
-            ESP_LOGD(TAG, "    bit %u: ptr_strip->rmt_tx_items : [lvl0] %2u - %5i (%9.1f ns) | [lvl1] %2u - %5i (%9.1f ns) | value: %10u", bit,
-                    ptr_fill_rmt_item->level0, ptr_fill_rmt_item->duration0, ptr_fill_rmt_item->duration0 * MY_RMT_ONE_TICK_DURATION_NANOSEC,
-                    ptr_fill_rmt_item->level1, ptr_fill_rmt_item->duration1, ptr_fill_rmt_item->duration1 * MY_RMT_ONE_TICK_DURATION_NANOSEC,
-                    ptr_fill_rmt_item->val);
+    /**************************************************************************
+     * Reuseable variables
+     */
+    esp_err_t f_retval = ESP_OK;
+
+    /**************************************************************************
+     * Check
+     */
+    if (param_strip_mask == 0 || param_strip_mask >= MJD_LEDRGB_STRIP_MASK(MJD_STRIP_IDENTIFIER_MAX)) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "ABORT. param_strip_mask invalid (0x%X) | err %i (%s)", param_strip_mask, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
 
-            ++ptr_fill_rmt_item;
+    /**************************************************************************
+     * MAIN
+     */
+    for (uint32_t idx = 0; idx < MJD_STRIP_IDENTIFIER_MAX; idx++) {
+        if ((param_strip_mask & MJD_LEDRGB_STRIP_MASK(idx)) == 0) {
+            continue;
+        }
+        f_retval = mjd_ledrgb_wait_strip_tx_done(idx, param_ticks_to_wait);
+        if (f_retval != ESP_OK) {
+            // GOTO
+            goto cleanup;
         }
     }
 
-    // ADD pulse: Treset
-    //      @doc All LED chips synchronously send the received data to each led-segment when the DIN port receives a Reset signal.
-    ESP_LOGD(TAG, "Add rmt_item for TReset");
-    *ptr_fill_rmt_item = ptr_strip->rmt_item_pulse_pairs[MJD_RMT_PULSE_TYPE_RESET]; // @important *ptr = indirection pointer
+    /**************************************************************************
+     * LABEL cleanup
+     */
+    cleanup: ;
 
-    ESP_LOGD(TAG,
-            "    tReset: ptr_strip->rmt_item_pulse_pairs[RMT_PULSE_TYPE_RESET] : [lvl0] %2u - %5i (%9.1f ns) | [lvl1] %2u - %5i (%9.1f ns) | value: %10u",
-            ptr_fill_rmt_item->level0, ptr_fill_rmt_item->duration0, ptr_fill_rmt_item->duration0 * MY_RMT_ONE_TICK_DURATION_NANOSEC,
-            ptr_fill_rmt_item->level1, ptr_fill_rmt_item->duration1, ptr_fill_rmt_item->duration1 * MY_RMT_ONE_TICK_DURATION_NANOSEC,
-            ptr_fill_rmt_item->val);
+    return f_retval;
+}
 
-    ++ptr_fill_rmt_item;
+mjd_ledrgb_led_t * mjd_ledrgb_get_strip_leds(mjd_ledrgb_strip_identifier_t param_strip_id) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
 
-    // ADD Pulse: RMT End Marker
-    ESP_LOGD(TAG, "Add rmt_item for RMT End Marker");
-    *ptr_fill_rmt_item = ptr_strip->rmt_item_pulse_pairs[MJD_RMT_PULSE_TYPE_END_MARKER]; // @important *ptr = indirection pointer
+    mjd_ledrgb_strip_t *ptr_strip = _get_init_strip(param_strip_id);
 
-    ESP_LOGD(TAG,
-            "    tReset: ptr_strip->rmt_item_pulse_pairs[RMT_PULSE_TYPE_END_MARKER] : [lvl0] %2u - %5i (%9.1f ns) | [lvl1] %2u - %5i (%9.1f ns) | value: %10u",
-            ptr_fill_rmt_item->level0, ptr_fill_rmt_item->duration0, ptr_fill_rmt_item->duration0 * MY_RMT_ONE_TICK_DURATION_NANOSEC,
-            ptr_fill_rmt_item->level1, ptr_fill_rmt_item->duration1, ptr_fill_rmt_item->duration1 * MY_RMT_ONE_TICK_DURATION_NANOSEC,
-            ptr_fill_rmt_item->val);
+    if (ptr_strip == NULL) {
+        ESP_LOGE(TAG, "ABORT. param_strip_id invalid or strip not initialized");
+        return NULL;
+    }
 
-    ++ptr_fill_rmt_item;
+    return ptr_strip->leds;
+}
 
-    //
-    ESP_LOGD(TAG, "DEBUG param_ptr_led_strip->rmt_tx_items");
-    ESP_LOGD(TAG, "    sizeof(rmt_item32_t)            = %u", sizeof(rmt_item32_t));
-    ESP_LOGD(TAG, "    ptr_strip->nbr_of_rmt_tx_items  = %u", ptr_strip->nbr_of_rmt_tx_items);
-    ESP_LOGD(TAG, "    ESP_LOG_BUFFER_HEX_LEVEL()");
-    ESP_LOG_BUFFER_HEX_LEVEL(TAG, ptr_strip->rmt_tx_items, ptr_strip->nbr_of_rmt_tx_items, ESP_LOG_DEBUG);
-    ESP_LOGD(TAG, "  ptr_strip->nbr_of_rmt_tx_items = %u", ptr_strip->nbr_of_rmt_tx_items);
-    rmt_item32_t *ptr_report_rmt_item = ptr_strip->rmt_tx_items; // Create a temporary pointer (=pointing to the beginning of the item array)
-    for (uint32_t i = 0; i < ptr_strip->nbr_of_rmt_tx_items; i++) {
-        ESP_LOGD(TAG, "  %4u :: [lvl0] %2u - %5i (%9.1f ns) | [lvl1] %2u - %5i (%9.1f ns) | value: %10u", i, ptr_report_rmt_item->level0,
-                ptr_report_rmt_item->duration0, ptr_report_rmt_item->duration0 * MY_RMT_ONE_TICK_DURATION_NANOSEC, ptr_report_rmt_item->level1,
-                ptr_report_rmt_item->duration1, ptr_report_rmt_item->duration1 * MY_RMT_ONE_TICK_DURATION_NANOSEC, ptr_report_rmt_item->val);
-        ptr_report_rmt_item++; // Advance ptr
+esp_err_t mjd_ledrgb_wait_strip_tx_done(mjd_ledrgb_strip_identifier_t param_strip_id, TickType_t param_ticks_to_wait) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    /**************************************************************************
+     * Reuseable variables
+     */
+    esp_err_t f_retval = ESP_OK;
+
+    /**************************************************************************
+     * Check
+     */
+    mjd_ledrgb_strip_t *ptr_strip = _get_init_strip(param_strip_id);
+
+    if (ptr_strip == NULL) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "ABORT. param_strip_id invalid or strip not initialized | err %i (%s)", f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
     }
 
     /**************************************************************************
-     * RMT WRITE
+     * MAIN
      */
-    f_retval = rmt_write_items(ptr_strip->rmt_channel, ptr_strip->rmt_tx_items, ptr_strip->nbr_of_rmt_tx_items,
-    true);
-    if (f_retval != ESP_OK) {
-        ESP_LOGE(TAG, "rmt_write_items(CH1) err %i (%s)", f_retval, esp_err_to_name(f_retval));
+    f_retval = rmt_wait_tx_done(ptr_strip->rmt_channel, param_ticks_to_wait);
+    if (f_retval != ESP_OK && f_retval != ESP_ERR_TIMEOUT) {
+        ESP_LOGE(TAG, "rmt_wait_tx_done() err %i (%s)", f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    /**************************************************************************
+     * LABEL cleanup
+     */
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_ledrgb_set_strip_brightness(mjd_ledrgb_strip_identifier_t param_strip_id, uint8_t param_relative_brightness) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    /**************************************************************************
+     * Reuseable variables
+     */
+    esp_err_t f_retval = ESP_OK;
+
+    /**************************************************************************
+     * Check
+     */
+    mjd_ledrgb_strip_t *ptr_strip = _get_init_strip(param_strip_id);
+
+    if (ptr_strip == NULL) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "ABORT. param_strip_id invalid or strip not initialized | err %i (%s)", f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (param_relative_brightness > 100) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "ABORT. param_relative_brightness > 100 | err %i (%s)", f_retval, esp_err_to_name(f_retval));
         // GOTO
         goto cleanup;
     }
 
-    //    memset(param_ptr_led_strip->leds, 0, param_ptr_led_strip->len_leds * sizeof(led_t));
-    //    digitalLeds_updatePixels(param_ptr_led_strip);
+    /**************************************************************************
+     * MAIN
+     */
+    ptr_strip->relative_brightness = param_relative_brightness;
+    _compute_color_lut(ptr_strip);
 
     /**************************************************************************
      * LABEL cleanup
@@ -592,7 +926,7 @@ esp_err_t mjd_ledrgb_set_strip_leds_one_color(mjd_ledrgb_strip_identifier_t para
     /**************************************************************************
      * MAIN
      */
-    for (uint8_t i = 0; i < ptr_strip->nbr_of_leds; i++) {
+    for (uint32_t i = 0; i < ptr_strip->nbr_of_leds; i++) {
         ptr_strip->leds[i] = param_led_color;
     }
 
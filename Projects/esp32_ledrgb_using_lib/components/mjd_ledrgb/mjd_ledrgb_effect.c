@@ -0,0 +1,402 @@
+/*
+ * Goto README.md for instructions
+ */
+
+#include "esp_timer.h"
+
+// Component header file(s)
+#include "mjd.h"
+#include "mjd_ledrgb.h"
+#include "mjd_ledrgb_effect.h"
+
+/*
+ * Logging
+ */
+static const char TAG[] = "mjd_ledrgb_effect";
+
+/*
+ * Data definitions
+ */
+const mjd_ledrgb_led_t mjd_ledrgb_palette_rainbow[MJD_LEDRGB_PALETTE_SIZE] =
+    {
+            { 255, 0, 0 }, { 255, 96, 0 }, { 255, 191, 0 }, { 223, 255, 0 }, { 128, 255, 0 }, { 32, 255, 0 }, { 0, 255, 64 }, { 0, 255, 159 },
+            { 0, 255, 255 }, { 0, 159, 255 }, { 0, 64, 255 }, { 32, 0, 255 }, { 128, 0, 255 }, { 223, 0, 255 }, { 255, 0, 191 }, { 255, 0, 96 } };
+
+const mjd_ledrgb_led_t mjd_ledrgb_palette_heat[MJD_LEDRGB_PALETTE_SIZE] =
+    {
+            { 0, 0, 0 }, { 51, 0, 0 }, { 102, 0, 0 }, { 153, 0, 0 }, { 204, 0, 0 }, { 255, 0, 0 }, { 255, 51, 0 }, { 255, 102, 0 },
+            { 255, 153, 0 }, { 255, 204, 0 }, { 255, 255, 0 }, { 255, 255, 51 }, { 255, 255, 102 }, { 255, 255, 153 }, { 255, 255, 204 },
+            { 255, 255, 255 } };
+
+typedef struct {
+        volatile bool is_running; /*!< Cleared by the engine task when it exits */
+        volatile bool is_stop_requested;
+        uint32_t strip_mask; /*!< The strips that have an effect */
+        mjd_ledrgb_effect_t effects[MJD_STRIP_IDENTIFIER_MAX];
+        uint32_t start_frame_nbrs[MJD_STRIP_IDENTIFIER_MAX]; /*!< The engine frame nbr when the effect was set (= frame 0 of the effect) */
+        uint32_t frame_nbr;
+        mjd_ledrgb_effect_engine_stats_t stats;
+        TaskHandle_t task_handle;
+        esp_timer_handle_t timer_handle;
+} mjd_ledrgb_effect_engine_t;
+
+static mjd_ledrgb_effect_engine_t ENGINE =
+    { 0 };
+
+/*
+ * @important The effects are set by the app task and read by the engine task (maybe on the other core).
+ */
+static portMUX_TYPE engine_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+/**************************************
+ * PRIVATE.
+ *
+ */
+
+/*
+ * @brief Blend 2 colors. param_weight 0 => color a, 256 => color b.
+ */
+static inline mjd_ledrgb_led_t _blend(mjd_ledrgb_led_t param_a, mjd_ledrgb_led_t param_b, uint32_t param_weight) {
+    const uint32_t weight_a = 256 - param_weight;
+    mjd_ledrgb_led_t led;
+    led.r = (param_a.r * weight_a + param_b.r * param_weight + 128) >> 8;
+    led.g = (param_a.g * weight_a + param_b.g * param_weight + 128) >> 8;
+    led.b = (param_a.b * weight_a + param_b.b * param_weight + 128) >> 8;
+    return led;
+}
+
+static void _render_solid(const mjd_ledrgb_effect_t* param_ptr_effect, mjd_ledrgb_led_t* param_ptr_leds, uint32_t param_nbr_of_leds) {
+    for (uint32_t idx = 0; idx < param_nbr_of_leds; idx++) {
+        param_ptr_leds[idx] = param_ptr_effect->color_a;
+    }
+}
+
+/*
+ * Triangle wave: color_a => color_b in period_frames, then back to color_a.
+ */
+static void _render_fade(const mjd_ledrgb_effect_t* param_ptr_effect, uint32_t param_frame_nbr, mjd_ledrgb_led_t* param_ptr_leds,
+                         uint32_t param_nbr_of_leds) {
+    const uint32_t period = (param_ptr_effect->period_frames == 0) ? 1 : param_ptr_effect->period_frames;
+    const uint32_t phase = param_frame_nbr % (2 * period);
+    const uint32_t position = (phase <= period) ? phase : (2 * period - phase);
+
+    const mjd_ledrgb_led_t led = _blend(param_ptr_effect->color_a, param_ptr_effect->color_b, (position * 256) / period);
+    for (uint32_t idx = 0; idx < param_nbr_of_leds; idx++) {
+        param_ptr_leds[idx] = led;
+    }
+}
+
+static void _render_chase(const mjd_ledrgb_effect_t* param_ptr_effect, uint32_t param_frame_nbr, mjd_ledrgb_led_t* param_ptr_leds,
+                          uint32_t param_nbr_of_leds) {
+    const uint32_t period = (param_ptr_effect->period_frames == 0) ? 1 : param_ptr_effect->period_frames;
+    const uint32_t head = (param_frame_nbr / period) % param_nbr_of_leds;
+
+    for (uint32_t idx = 0; idx < param_nbr_of_leds; idx++) {
+        // The segment ends at the head and wraps around the end of the strip
+        const uint32_t distance = (head + param_nbr_of_leds - idx) % param_nbr_of_leds;
+        param_ptr_leds[idx] = (distance < param_ptr_effect->length) ? param_ptr_effect->color_a : param_ptr_effect->color_b;
+    }
+}
+
+/*
+ * The palette is cyclic: the last color blends into the first color.
+ */
+static void _render_palette(const mjd_ledrgb_effect_t* param_ptr_effect, uint32_t param_frame_nbr, mjd_ledrgb_led_t* param_ptr_leds,
+                            uint32_t param_nbr_of_leds) {
+    const mjd_ledrgb_led_t *palette = param_ptr_effect->ptr_palette;
+    const uint32_t length = (param_ptr_effect->length == 0) ? param_nbr_of_leds : param_ptr_effect->length;
+    const uint32_t offset = (param_ptr_effect->period_frames == 0) ? 0 : (param_frame_nbr / param_ptr_effect->period_frames) % length;
+
+    for (uint32_t idx = 0; idx < param_nbr_of_leds; idx++) {
+        // 8-bit fixed point position in the palette
+        const uint32_t position = (((idx + offset) % length) * MJD_LEDRGB_PALETTE_SIZE * 256) / length;
+        const uint32_t entry = position >> 8;
+        param_ptr_leds[idx] = _blend(palette[entry], palette[(entry + 1) % MJD_LEDRGB_PALETTE_SIZE], position & 0xFF);
+    }
+}
+
+/*
+ * The esp_timer callback runs in the esp_timer task: only wake up the engine task.
+ */
+static void _engine_timer_callback(void* arg) {
+    xTaskNotifyGive(ENGINE.task_handle);
+}
+
+static void _engine_task(void *pvParameter) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    while (1) {
+        // The notification count > 1 means that timer ticks were missed (the frame took longer than the frame period)
+        uint32_t nbr_of_ticks = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (ENGINE.is_stop_requested == true) {
+            break;
+        }
+        if (nbr_of_ticks == 0) {
+            continue;
+        }
+        ENGINE.stats.nbr_of_dropped_frames += nbr_of_ticks - 1;
+
+        mjd_ledrgb_effect_engine_render_frame();
+    }
+
+    ENGINE.is_running = false;
+
+    /********************************************************************************
+     * Task Delete
+     * @doc Passing NULL will end the current task
+     */
+    vTaskDelete(NULL);
+}
+
+/**************************************
+ * PUBLIC.
+ *
+ */
+esp_err_t mjd_ledrgb_effect_render(const mjd_ledrgb_effect_t* param_ptr_effect, uint32_t param_frame_nbr, mjd_ledrgb_led_t* param_ptr_leds,
+                                   uint32_t param_nbr_of_leds) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_effect == NULL || param_ptr_leds == NULL || param_nbr_of_leds == 0 || param_ptr_effect->type >= MJD_LEDRGB_EFFECT_MAX) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (param_ptr_effect->type == MJD_LEDRGB_EFFECT_PALETTE && param_ptr_effect->ptr_palette == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. ptr_palette is NULL | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    switch (param_ptr_effect->type) {
+    case MJD_LEDRGB_EFFECT_SOLID:
+        _render_solid(param_ptr_effect, param_ptr_leds, param_nbr_of_leds);
+        break;
+    case MJD_LEDRGB_EFFECT_FADE:
+        _render_fade(param_ptr_effect, param_frame_nbr, param_ptr_leds, param_nbr_of_leds);
+        break;
+    case MJD_LEDRGB_EFFECT_CHASE:
+        _render_chase(param_ptr_effect, param_frame_nbr, param_ptr_leds, param_nbr_of_leds);
+        break;
+    case MJD_LEDRGB_EFFECT_PALETTE:
+        _render_palette(param_ptr_effect, param_frame_nbr, param_ptr_leds, param_nbr_of_leds);
+        break;
+    default: // MJD_LEDRGB_EFFECT_NONE
+        break;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_ledrgb_effect_set(mjd_ledrgb_strip_identifier_t param_strip_id, const mjd_ledrgb_effect_t* param_ptr_effect) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (mjd_ledrgb_get_strip_leds(param_strip_id) == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Strip not initialized | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (param_ptr_effect != NULL && (param_ptr_effect->type >= MJD_LEDRGB_EFFECT_MAX
+            || (param_ptr_effect->type == MJD_LEDRGB_EFFECT_PALETTE && param_ptr_effect->ptr_palette == NULL))) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid effect | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    portENTER_CRITICAL(&engine_spinlock);
+    if (param_ptr_effect == NULL || param_ptr_effect->type == MJD_LEDRGB_EFFECT_NONE) {
+        ENGINE.strip_mask &= ~MJD_LEDRGB_STRIP_MASK(param_strip_id);
+    } else {
+        ENGINE.effects[param_strip_id] = *param_ptr_effect;
+        ENGINE.start_frame_nbrs[param_strip_id] = ENGINE.frame_nbr;
+        ENGINE.strip_mask |= MJD_LEDRGB_STRIP_MASK(param_strip_id);
+    }
+    portEXIT_CRITICAL(&engine_spinlock);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_ledrgb_effect_engine_render_frame(void) {
+    esp_err_t f_retval = ESP_OK;
+
+    mjd_ledrgb_effect_t effects[MJD_STRIP_IDENTIFIER_MAX];
+    uint32_t start_frame_nbrs[MJD_STRIP_IDENTIFIER_MAX];
+    uint32_t strip_mask;
+    uint32_t frame_nbr;
+
+    // @important Copy under lock: the app can change the effects while the frame is being rendered.
+    portENTER_CRITICAL(&engine_spinlock);
+    strip_mask = ENGINE.strip_mask;
+    frame_nbr = ENGINE.frame_nbr++;
+    memcpy(effects, ENGINE.effects, sizeof(effects));
+    memcpy(start_frame_nbrs, ENGINE.start_frame_nbrs, sizeof(start_frame_nbrs));
+    portEXIT_CRITICAL(&engine_spinlock);
+
+    if (strip_mask == 0) {
+        // GOTO
+        goto cleanup;
+    }
+
+    for (uint32_t idx = 0; idx < MJD_STRIP_IDENTIFIER_MAX; idx++) {
+        if ((strip_mask & MJD_LEDRGB_STRIP_MASK(idx)) == 0) {
+            continue;
+        }
+        uint32_t nbr_of_leds = 0;
+        mjd_ledrgb_led_t *ptr_leds = mjd_ledrgb_get_strip_leds(idx);
+        if (ptr_leds == NULL || mjd_ledrgb_get_strip_nbr_of_leds(idx, &nbr_of_leds) != ESP_OK) {
+            f_retval = ESP_ERR_INVALID_STATE;
+            ESP_LOGE(TAG, "%s(). ABORT. Strip #%u not initialized | err %i (%s)", __FUNCTION__, idx, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+        mjd_ledrgb_effect_render(&effects[idx], frame_nbr - start_frame_nbrs[idx], ptr_leds, nbr_of_leds);
+    }
+
+    f_retval = mjd_ledrgb_submit_pixels_to_strips(strip_mask);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+
+    ++ENGINE.stats.nbr_of_frames;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_ledrgb_effect_engine_start(const mjd_ledrgb_effect_engine_config_t* param_ptr_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_config == NULL || param_ptr_config->fps == 0 || param_ptr_config->fps > MJD_LEDRGB_EFFECT_ENGINE_MAX_FPS) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid config (fps 1..%u) | err %i (%s)", __FUNCTION__, MJD_LEDRGB_EFFECT_ENGINE_MAX_FPS, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (ENGINE.is_running == true) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. The engine is already running | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    ENGINE.is_stop_requested = false;
+    ENGINE.is_running = true;
+
+    /**********
+     * TASK
+     *  @important For stability (RMT + Wifi etc.): always use xTaskCreatePinnedToCore(APP_CPU_NUM)
+     */
+    BaseType_t xReturned = xTaskCreatePinnedToCore(&_engine_task, "mjd_ledrgb_effect", param_ptr_config->task_stack_size, NULL,
+            param_ptr_config->task_priority, &ENGINE.task_handle, APP_CPU_NUM);
+    if (xReturned != pdPASS) {
+        ENGINE.is_running = false;
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "%s(). ABORT. xTaskCreatePinnedToCore() failed | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    /**********
+     * TIMER: the fixed frame rate
+     */
+    const esp_timer_create_args_t timer_args =
+        { .callback = &_engine_timer_callback, .arg = NULL, .dispatch_method = ESP_TIMER_TASK, .name = "mjd_ledrgb_effect" };
+
+    f_retval = esp_timer_create(&timer_args, &ENGINE.timer_handle);
+    if (f_retval == ESP_OK) {
+        f_retval = esp_timer_start_periodic(ENGINE.timer_handle, 1000000 / param_ptr_config->fps);
+    }
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. esp_timer failed | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        if (ENGINE.timer_handle != NULL) {
+            esp_timer_delete(ENGINE.timer_handle);
+            ENGINE.timer_handle = NULL;
+        }
+        ENGINE.is_stop_requested = true;
+        xTaskNotifyGive(ENGINE.task_handle);
+        // GOTO
+        goto cleanup;
+    }
+
+    ESP_LOGI(TAG, "Effect engine started: %u FPS", param_ptr_config->fps);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_ledrgb_effect_engine_stop(void) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (ENGINE.is_running != true) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. The engine is not running | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    if (ENGINE.timer_handle != NULL) {
+        esp_timer_stop(ENGINE.timer_handle);
+        esp_timer_delete(ENGINE.timer_handle);
+        ENGINE.timer_handle = NULL;
+    }
+
+    ENGINE.is_stop_requested = true;
+    xTaskNotifyGive(ENGINE.task_handle);
+
+    // Wait for the task to finish its last frame
+    for (uint32_t idx = 0; idx < 100 && ENGINE.is_running == true; idx++) {
+        vTaskDelay(RTOS_DELAY_10MILLISEC);
+    }
+    if (ENGINE.is_running == true) {
+        f_retval = ESP_ERR_TIMEOUT;
+        ESP_LOGE(TAG, "%s(). ABORT. The engine task did not stop | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    ESP_LOGI(TAG, "Effect engine stopped: %u frames | %u dropped", ENGINE.stats.nbr_of_frames, ENGINE.stats.nbr_of_dropped_frames);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_ledrgb_effect_engine_get_stats(mjd_ledrgb_effect_engine_stats_t* param_ptr_stats) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_stats == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    *param_ptr_stats = ENGINE.stats;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
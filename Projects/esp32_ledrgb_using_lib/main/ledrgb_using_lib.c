@@ -1,5 +1,8 @@
+#include "esp_timer.h"
+
 #include "mjd.h"
 #include "mjd_ledrgb.h"
+#include "mjd_ledrgb_effect.h"
 
 /*
  * Logging
@@ -18,6 +21,11 @@ static const char TAG[] = "myapp";
 #define MYAPP_RTOS_TASK_STACK_SIZE_LARGE (8192)
 #define MYAPP_RTOS_TASK_PRIORITY_NORMAL (RTOS_TASK_PRIORITY_NORMAL)
 
+/*
+ * Benchmark
+ */
+#define MYAPP_BENCHMARK_NBR_OF_FRAMES (500)
+
 /*
  * FUNCS
  */
@@ -573,6 +581,38 @@ void do_strip_sequences() {
     mjd_ledrgb_reset_strip(strip_id);
     vTaskDelay(RTOS_DELAY_1SEC);
 
+    /*************************************************************************
+     * EFFECT ENGINE: the effects are rendered at a fixed frame rate by the engine task (no busy loop in the app)
+     *
+     */
+    ESP_LOGI(TAG, "EFFECT ENGINE: rainbow palette, chase, fade (5 seconds each)");
+    {
+        mjd_ledrgb_effect_engine_config_t engine_config = MJD_LEDRGB_EFFECT_ENGINE_CONFIG_DEFAULT();
+        engine_config.fps = 50;
+
+        mjd_ledrgb_effect_t effect =
+            { .type = MJD_LEDRGB_EFFECT_PALETTE, .ptr_palette = mjd_ledrgb_palette_rainbow, .period_frames = 5 };
+        mjd_ledrgb_effect_set(strip_id, &effect);
+        mjd_ledrgb_effect_engine_start(&engine_config);
+        vTaskDelay(RTOS_DELAY_5SEC);
+
+        effect = (mjd_ledrgb_effect_t ) { .type = MJD_LEDRGB_EFFECT_CHASE, .color_a = MJD_RGB_BLUE, .color_b = mjd_led_rgb(0, 0, 0),
+                        .period_frames = 4, .length = 3 };
+        mjd_ledrgb_effect_set(strip_id, &effect);
+        vTaskDelay(RTOS_DELAY_5SEC);
+
+        effect = (mjd_ledrgb_effect_t ) { .type = MJD_LEDRGB_EFFECT_FADE, .color_a = mjd_led_rgb(0, 0, 0), .color_b = MJD_RGB_WHITE,
+                        .period_frames = 50 };
+        mjd_ledrgb_effect_set(strip_id, &effect);
+        vTaskDelay(RTOS_DELAY_5SEC);
+
+        mjd_ledrgb_effect_engine_stop();
+        mjd_ledrgb_effect_set(strip_id, NULL);
+    }
+
+    mjd_ledrgb_reset_strip(strip_id);
+    vTaskDelay(RTOS_DELAY_1SEC);
+
     // DEVTEMP: HALT
     /////mjd_rtos_wait_forever();
 
@@ -582,6 +622,44 @@ void do_strip_sequences() {
     ESP_LOGD(TAG, "END %s()", __FUNCTION__);
 }
 
+/*
+ * @brief Frames per second of the blocking send and of the async submit (the next frame is rendered while the RMT transmits the previous one).
+ *
+ * @doc The wire time of a frame is the upper limit: 24 bits * 1.25us per LED + Treset. For 16 LEDs that is +-770us (+-1300 FPS).
+ */
+void do_benchmark(mjd_ledrgb_strip_identifier_t param_strip_id) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    uint32_t nbr_of_leds = 0;
+    mjd_ledrgb_get_strip_nbr_of_leds(param_strip_id, &nbr_of_leds);
+
+    int64_t start_us;
+    int64_t elapsed_us;
+
+    // Blocking: render + transmit + wait, frame after frame
+    start_us = esp_timer_get_time();
+    for (uint32_t frame = 0; frame < MYAPP_BENCHMARK_NBR_OF_FRAMES; ++frame) {
+        mjd_ledrgb_set_strip_led(param_strip_id, frame % nbr_of_leds, mjd_led_rgb(frame & 0xFF, 0, 0), false);
+        mjd_ledrgb_send_pixels_to_strip(param_strip_id);
+    }
+    elapsed_us = esp_timer_get_time() - start_us;
+    ESP_LOGI(TAG, "BENCHMARK mjd_ledrgb_send_pixels_to_strip():   %u frames in %u us => %u FPS", MYAPP_BENCHMARK_NBR_OF_FRAMES,
+            (uint32_t ) elapsed_us, (uint32_t ) (MYAPP_BENCHMARK_NBR_OF_FRAMES * 1000000LL / elapsed_us));
+
+    // Async: the render of frame N+1 overlaps the transmission of frame N
+    start_us = esp_timer_get_time();
+    for (uint32_t frame = 0; frame < MYAPP_BENCHMARK_NBR_OF_FRAMES; ++frame) {
+        mjd_ledrgb_set_strip_led(param_strip_id, frame % nbr_of_leds, mjd_led_rgb(0, frame & 0xFF, 0), false);
+        mjd_ledrgb_submit_pixels_to_strip(param_strip_id);
+    }
+    mjd_ledrgb_wait_strip_tx_done(param_strip_id, portMAX_DELAY);
+    elapsed_us = esp_timer_get_time() - start_us;
+    ESP_LOGI(TAG, "BENCHMARK mjd_ledrgb_submit_pixels_to_strip(): %u frames in %u us => %u FPS", MYAPP_BENCHMARK_NBR_OF_FRAMES,
+            (uint32_t ) elapsed_us, (uint32_t ) (MYAPP_BENCHMARK_NBR_OF_FRAMES * 1000000LL / elapsed_us));
+
+    mjd_ledrgb_reset_strip(param_strip_id);
+}
+
 /*
  * TASKS
  */
@@ -617,7 +695,9 @@ void main_task(void *pvParameter) {
     config.nbr_of_leds = 16; // 1..4..8..16..30..60..120
     config.relative_brightness = 50;
     config.gpio_num = MY_1WIRE_GPIO_NUM;
+    uint32_t free_heap_before_init = esp_get_free_heap_size();
     mjd_ledrgb_init(&config);
+    uint32_t free_heap_after_init = esp_get_free_heap_size();
 
 /*
     ESP_LOGI(TAG, "Product: BTF-LIGHTING WS2813 led pixel strip, DC 5V, length 1m, 30 pixels/strip/m, IP30");
@@ -629,6 +709,15 @@ void main_task(void *pvParameter) {
     mjd_ledrgb_init(&config);
 */
 
+    /*
+     * BENCHMARK
+     *      RAM: the heap used by mjd_ledrgb_init() (incl. the RMT driver and the 256 bytes color LUT) / nbr_of_leds.
+     */
+    ESP_LOGI(TAG, "BENCHMARK RAM: mjd_ledrgb_init() used %u bytes heap for %u LEDs => %u bytes per LED",
+            free_heap_before_init - free_heap_after_init, config.nbr_of_leds,
+            (free_heap_before_init - free_heap_after_init) / config.nbr_of_leds);
+    do_benchmark(config.strip_id);
+
     loop_this: ;
     do_strip_sequences();
     goto loop_this;
@@ -194,3 +194,75 @@ lwmqtt_err_t esp_lwmqtt_network_write(void *ref, uint8_t *buffer, size_t len, si
 
   return LWMQTT_SUCCESS;
 }
+
+lwmqtt_err_t esp_lwmqtt_doorbell_open(esp_lwmqtt_doorbell_t *doorbell) {
+  // create socket
+  doorbell->socket = lwip_socket(AF_INET, SOCK_DGRAM, 0);
+  if (doorbell->socket < 0) {
+    return LWMQTT_NETWORK_FAILED_CONNECT;
+  }
+
+  // bind to an ephemeral port of the loopback interface
+  struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = 0, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+  int r = lwip_bind_r(doorbell->socket, (struct sockaddr *)&addr, sizeof(addr));
+  if (r < 0) {
+    lwip_close_r(doorbell->socket);
+    return LWMQTT_NETWORK_FAILED_CONNECT;
+  }
+
+  // get assigned port
+  socklen_t addr_len = sizeof(addr);
+  r = lwip_getsockname_r(doorbell->socket, (struct sockaddr *)&addr, &addr_len);
+  if (r < 0) {
+    lwip_close_r(doorbell->socket);
+    return LWMQTT_NETWORK_FAILED_CONNECT;
+  }
+
+  // send datagrams to itself
+  r = lwip_connect_r(doorbell->socket, (struct sockaddr *)&addr, addr_len);
+  if (r < 0) {
+    lwip_close_r(doorbell->socket);
+    return LWMQTT_NETWORK_FAILED_CONNECT;
+  }
+
+  return LWMQTT_SUCCESS;
+}
+
+void esp_lwmqtt_doorbell_ring(esp_lwmqtt_doorbell_t *doorbell) {
+  // send one byte (a full receive buffer already means that the doorbell rings)
+  uint8_t b = 0;
+  lwip_send_r(doorbell->socket, &b, 1, MSG_DONTWAIT);
+}
+
+void esp_lwmqtt_doorbell_clear(esp_lwmqtt_doorbell_t *doorbell) {
+  // receive until empty
+  uint8_t buf[8];
+  while (lwip_recv_r(doorbell->socket, buf, sizeof(buf), MSG_DONTWAIT) > 0) {
+  }
+}
+
+lwmqtt_err_t esp_lwmqtt_select(int socket, esp_lwmqtt_doorbell_t *doorbell, bool *available, bool *rung,
+                               uint32_t timeout) {
+  // prepare set
+  fd_set set;
+  FD_ZERO(&set);
+  FD_SET(doorbell->socket, &set);
+  int max_fd = doorbell->socket;
+  if (socket >= 0) {
+    FD_SET(socket, &set);
+    max_fd = socket > max_fd ? socket : max_fd;
+  }
+
+  // wait for data or ring
+  struct timeval t = {.tv_sec = timeout / 1000, .tv_usec = (timeout % 1000) * 1000};
+  int result = lwip_select(max_fd + 1, &set, NULL, NULL, timeout == ESP_LWMQTT_WAIT_FOREVER ? NULL : &t);
+  if (result < 0) {
+    return LWMQTT_NETWORK_FAILED_READ;
+  }
+
+  // set what happened
+  *available = socket >= 0 && FD_ISSET(socket, &set);
+  *rung = FD_ISSET(doorbell->socket, &set);
+
+  return LWMQTT_SUCCESS;
+}
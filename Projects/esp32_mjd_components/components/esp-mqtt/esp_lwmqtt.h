@@ -62,4 +62,41 @@ lwmqtt_err_t esp_lwmqtt_network_read(void *ref, uint8_t *buf, size_t len, size_t
  */
 lwmqtt_err_t esp_lwmqtt_network_write(void *ref, uint8_t *buf, size_t len, size_t *sent, uint32_t timeout);
 
+/**
+ * The timeout of esp_lwmqtt_select() that blocks until an event occurs.
+ */
+#define ESP_LWMQTT_WAIT_FOREVER UINT32_MAX
+
+/**
+ * The doorbell wakes up a task that blocks in esp_lwmqtt_select() (a udp socket on the loopback interface that sends
+ * datagrams to itself, the same approach as the control socket of esp_http_server).
+ */
+typedef struct {
+  int socket;
+} esp_lwmqtt_doorbell_t;
+
+/**
+ * Create the doorbell socket.
+ */
+lwmqtt_err_t esp_lwmqtt_doorbell_open(esp_lwmqtt_doorbell_t *doorbell);
+
+/**
+ * Wake up the waiting task. Never blocks and can be called from any task.
+ */
+void esp_lwmqtt_doorbell_ring(esp_lwmqtt_doorbell_t *doorbell);
+
+/**
+ * Consume all pending rings.
+ */
+void esp_lwmqtt_doorbell_clear(esp_lwmqtt_doorbell_t *doorbell);
+
+/**
+ * Will wait until data is available on the socket, the doorbell rings or the timeout has been reached.
+ *
+ * @param socket - The socket of the connection or -1 to only wait for the doorbell.
+ * @param timeout - The timeout in milliseconds or ESP_LWMQTT_WAIT_FOREVER.
+ */
+lwmqtt_err_t esp_lwmqtt_select(int socket, esp_lwmqtt_doorbell_t *doorbell, bool *available, bool *rung,
+                               uint32_t timeout);
+
 #endif  // ESP_LWMQTT_H
@@ -12,6 +12,8 @@
 
 #include "esp_lwmqtt.h"
 #include "esp_mqtt.h"
+#include "esp_mqtt_inbox.h"
+#include "esp_mqtt_loop.h"
 
 #define ESP_MQTT_LOG_TAG "esp_mqtt"
 
@@ -23,16 +25,12 @@ static SemaphoreHandle_t esp_mqtt_main_mutex = NULL;
 
 #define ESP_MQTT_UNLOCK_MAIN() xSemaphoreGive(esp_mqtt_main_mutex)
 
-static SemaphoreHandle_t esp_mqtt_select_mutex = NULL;
-
-#define ESP_MQTT_LOCK_SELECT() \
-  do {                         \
-  } while (xSemaphoreTake(esp_mqtt_select_mutex, portMAX_DELAY) != pdPASS)
-
-#define ESP_MQTT_UNLOCK_SELECT() xSemaphoreGive(esp_mqtt_select_mutex)
+static SemaphoreHandle_t esp_mqtt_exit_semaphore = NULL;
 
 static TaskHandle_t esp_mqtt_task = NULL;
 
+static esp_lwmqtt_doorbell_t esp_mqtt_doorbell = {.socket = -1};
+
 static size_t esp_mqtt_buffer_size;
 static uint32_t esp_mqtt_command_timeout;
 
@@ -52,11 +50,13 @@ static struct {
 } esp_mqtt_lwt_config = {0};
 
 static bool esp_mqtt_running = false;
-static bool esp_mqtt_connected = false;
-static bool esp_mqtt_error = false;
+static volatile bool esp_mqtt_connected = false;
+static volatile bool esp_mqtt_error = false;
+static volatile bool esp_mqtt_stopping = false;
 
 static esp_mqtt_status_callback_t esp_mqtt_status_callback = NULL;
 static esp_mqtt_message_callback_t esp_mqtt_message_callback = NULL;
+static esp_mqtt_borrow_callback_t esp_mqtt_borrow_callback = NULL;
 
 static lwmqtt_client_t esp_mqtt_client;
 
@@ -72,14 +72,33 @@ static esp_lwmqtt_timer_t esp_mqtt_timer1, esp_mqtt_timer2;
 static void *esp_mqtt_write_buffer;
 static void *esp_mqtt_read_buffer;
 
-static QueueHandle_t esp_mqtt_event_queue = NULL;
+static esp_mqtt_inbox_t esp_mqtt_inbox;
+static esp_mqtt_inbox_t esp_mqtt_outbox;
+static uint32_t esp_mqtt_outbox_dropped = 0;
 
-typedef struct {
-  lwmqtt_string_t topic;
-  lwmqtt_message_t message;
-} esp_mqtt_event_t;
+static void esp_mqtt_free_resources() {
+  // free buffers
+  free(esp_mqtt_write_buffer);
+  free(esp_mqtt_read_buffer);
+  esp_mqtt_write_buffer = NULL;
+  esp_mqtt_read_buffer = NULL;
 
-void esp_mqtt_init(esp_mqtt_status_callback_t scb, esp_mqtt_message_callback_t mcb, size_t buffer_size,
+  // delete mutex and semaphore
+  if (esp_mqtt_main_mutex != NULL) {
+    vSemaphoreDelete(esp_mqtt_main_mutex);
+    esp_mqtt_main_mutex = NULL;
+  }
+  if (esp_mqtt_exit_semaphore != NULL) {
+    vSemaphoreDelete(esp_mqtt_exit_semaphore);
+    esp_mqtt_exit_semaphore = NULL;
+  }
+
+  // free message slots
+  esp_mqtt_inbox_deinit(&esp_mqtt_inbox);
+  esp_mqtt_inbox_deinit(&esp_mqtt_outbox);
+}
+
+bool esp_mqtt_init(esp_mqtt_status_callback_t scb, esp_mqtt_message_callback_t mcb, size_t buffer_size,
                    int command_timeout) {
   // set callbacks
   esp_mqtt_status_callback = scb;
@@ -91,14 +110,48 @@ void esp_mqtt_init(esp_mqtt_status_callback_t scb, esp_mqtt_message_callback_t m
   esp_mqtt_write_buffer = malloc((size_t)buffer_size);
   esp_mqtt_read_buffer = malloc((size_t)buffer_size);
 
-  // create mutexes
+  // create mutex and semaphore
   esp_mqtt_main_mutex = xSemaphoreCreateMutex();
-  esp_mqtt_select_mutex = xSemaphoreCreateMutex();
+  esp_mqtt_exit_semaphore = xSemaphoreCreateBinary();
 
-  // create queue
-  esp_mqtt_event_queue = xQueueCreate(CONFIG_ESP_MQTT_EVENT_QUEUE_SIZE, sizeof(esp_mqtt_event_t *));
+  if (esp_mqtt_write_buffer == NULL || esp_mqtt_read_buffer == NULL || esp_mqtt_main_mutex == NULL ||
+      esp_mqtt_exit_semaphore == NULL) {
+    ESP_LOGE(ESP_MQTT_LOG_TAG, "esp_mqtt_init: cannot allocate buffers of %u bytes", (uint32_t)buffer_size);
+    esp_mqtt_free_resources();
+    return false;
+  }
+
+  // allocate inbound and outbound message slots (a message never exceeds the buffers)
+  size_t slot_size = buffer_size;
+  if (CONFIG_ESP_MQTT_INBOX_SLOT_SIZE > 0 && CONFIG_ESP_MQTT_INBOX_SLOT_SIZE < buffer_size) {
+    slot_size = CONFIG_ESP_MQTT_INBOX_SLOT_SIZE;
+  }
+  size_t outbox_slot_size = buffer_size;
+  if (CONFIG_ESP_MQTT_OUTBOX_SLOT_SIZE > 0 && CONFIG_ESP_MQTT_OUTBOX_SLOT_SIZE < buffer_size) {
+    outbox_slot_size = CONFIG_ESP_MQTT_OUTBOX_SLOT_SIZE;
+  }
+  if (!esp_mqtt_inbox_init(&esp_mqtt_inbox, CONFIG_ESP_MQTT_EVENT_QUEUE_SIZE, slot_size, false) ||
+      !esp_mqtt_inbox_init(&esp_mqtt_outbox, CONFIG_ESP_MQTT_OUTBOX_SIZE, outbox_slot_size, true)) {
+    esp_mqtt_free_resources();
+    return false;
+  }
+
+  return true;
 }
 
+void esp_mqtt_set_borrow_callback(esp_mqtt_borrow_callback_t bcb) {
+  // acquire mutex
+  ESP_MQTT_LOCK_MAIN();
+
+  // set callback
+  esp_mqtt_borrow_callback = bcb;
+
+  // release mutex
+  ESP_MQTT_UNLOCK_MAIN();
+}
+
+void esp_mqtt_get_inbox_stats(esp_mqtt_inbox_stats_t *stats) { esp_mqtt_inbox_get_stats(&esp_mqtt_inbox, stats); }
+
 #if defined(CONFIG_ESP_MQTT_TLS_ENABLE)
 bool esp_mqtt_tls(bool enable, bool verify, const uint8_t *ca_buf, size_t ca_len) {
   // acquire mutex
@@ -132,51 +185,77 @@ bool esp_mqtt_tls(bool enable, bool verify, const uint8_t *ca_buf, size_t ca_len
 
   return true;
 }
+
+void esp_mqtt_tls_get_stats(esp_tls_lwmqtt_stats_t *stats) {
+  // acquire mutex
+  ESP_MQTT_LOCK_MAIN();
+
+  // copy statistics
+  *stats = esp_mqtt_tls_network.stats;
+
+  // release mutex
+  ESP_MQTT_UNLOCK_MAIN();
+}
 #endif
 
 static void esp_mqtt_message_handler(lwmqtt_client_t *client, void *ref, lwmqtt_string_t topic, lwmqtt_message_t msg) {
-  // create message
-  esp_mqtt_event_t *evt = malloc(sizeof(esp_mqtt_event_t));
-
-  // copy topic with additional null termination
-  evt->topic.len = topic.len;
-  evt->topic.data = malloc((size_t)topic.len + 1);
-  memcpy(evt->topic.data, topic.data, (size_t)topic.len);
-  evt->topic.data[topic.len] = 0;
-
-  // copy message with additional null termination
-  evt->message.retained = msg.retained;
-  evt->message.qos = msg.qos;
-  evt->message.payload_len = msg.payload_len;
-  evt->message.payload = malloc((size_t)msg.payload_len + 1);
-  memcpy(evt->message.payload, msg.payload, (size_t)msg.payload_len);
-  evt->message.payload[msg.payload_len] = 0;
-
-  // queue event
-  if (xQueueSend(esp_mqtt_event_queue, &evt, 0) != pdTRUE) {
-    ESP_LOGE(ESP_MQTT_LOG_TAG, "xQueueSend: queue is full, dropping message");
-    free(evt->topic.data);
-    free(evt->message.payload);
-    free(evt);
+  // copy message into a free inbox slot and queue it (no allocation)
+  esp_mqtt_inbox_put(&esp_mqtt_inbox, topic, msg, 0);
+}
+
+static void esp_mqtt_dispatch_message(esp_mqtt_message_t *msg, void *ref) {
+  // lend message to the borrow callback if existing
+  if (esp_mqtt_borrow_callback) {
+    esp_mqtt_borrow_callback(msg);
+    return;
+  }
+
+  // call callback if existing
+  if (esp_mqtt_message_callback) {
+    esp_mqtt_message_callback(msg->topic, msg->payload, msg->payload_len);
   }
 }
 
 static void esp_mqtt_dispatch_events() {
-  // prepare event
-  esp_mqtt_event_t *evt = NULL;
-
-  // receive next event
-  while (xQueueReceive(esp_mqtt_event_queue, &evt, 0) == pdTRUE) {
-    // call callback if existing
-    if (esp_mqtt_message_callback) {
-      esp_mqtt_message_callback(evt->topic.data, evt->message.payload, evt->message.payload_len);
-    }
+  // dispatch queued messages (the slots are released afterwards unless retained)
+  esp_mqtt_inbox_dispatch(&esp_mqtt_inbox, esp_mqtt_dispatch_message, NULL);
+}
+
+static int esp_mqtt_socket() {
+#if defined(CONFIG_ESP_MQTT_TLS_ENABLE)
+  if (esp_mqtt_use_tls) {
+    return esp_mqtt_tls_network.socket.fd;
+  }
+#endif
+
+  return esp_mqtt_network.socket;
+}
+
+static lwmqtt_err_t esp_mqtt_peek(void *ref, size_t *available) {
+#if defined(CONFIG_ESP_MQTT_TLS_ENABLE)
+  if (esp_mqtt_use_tls) {
+    return esp_tls_lwmqtt_network_peek(&esp_mqtt_tls_network, available, esp_mqtt_command_timeout);
+  }
+#endif
+
+  return esp_lwmqtt_network_peek(&esp_mqtt_network, available);
+}
+
+static bool esp_mqtt_process_wait(int socket, uint32_t timeout, bool *available) {
+  // block until data is available, the doorbell rings or the timeout has been reached
+  bool rung = false;
+  lwmqtt_err_t err = esp_lwmqtt_select(socket, &esp_mqtt_doorbell, available, &rung, timeout);
+  if (err != LWMQTT_SUCCESS) {
+    ESP_LOGE(ESP_MQTT_LOG_TAG, "esp_lwmqtt_select: %d", err);
+    return false;
+  }
 
-    // free data
-    free(evt->topic.data);
-    free(evt->message.payload);
-    free(evt);
+  // consume rings
+  if (rung) {
+    esp_lwmqtt_doorbell_clear(&esp_mqtt_doorbell);
   }
+
+  return true;
 }
 
 static bool esp_mqtt_process_connect() {
@@ -218,9 +297,6 @@ static bool esp_mqtt_process_connect() {
   // release mutex
   ESP_MQTT_UNLOCK_MAIN();
 
-  // acquire select mutex
-  ESP_MQTT_LOCK_SELECT();
-
   // wait for connection
   bool connected = false;
 
@@ -234,17 +310,14 @@ static bool esp_mqtt_process_connect() {
   err = esp_lwmqtt_network_wait(&esp_mqtt_network, &connected, esp_mqtt_command_timeout);
 #endif
 
+  // acquire mutex
+  ESP_MQTT_LOCK_MAIN();
+
   if (err != LWMQTT_SUCCESS) {
     ESP_LOGE(ESP_MQTT_LOG_TAG, "esp_lwmqtt_network_wait: %d", err);
     return false;
   }
 
-  // release select mutex
-  ESP_MQTT_UNLOCK_SELECT();
-
-  // acquire mutex
-  ESP_MQTT_LOCK_MAIN();
-
   // return if not connected
   if (!connected) {
     return false;
@@ -277,8 +350,16 @@ static bool esp_mqtt_process_connect() {
 }
 
 static void esp_mqtt_process(void *p) {
+  // the delay between connection attempts (doubles after each failure)
+  uint32_t delay = CONFIG_ESP_MQTT_RECONNECT_DELAY_MIN;
+
   // connection loop
   for (;;) {
+    // check for stop
+    if (esp_mqtt_stopping) {
+      break;
+    }
+
     // log attempt
     ESP_LOGI(ESP_MQTT_LOG_TAG, "esp_mqtt_process: begin connection attempt");
 
@@ -304,104 +385,70 @@ static void esp_mqtt_process(void *p) {
     ESP_MQTT_UNLOCK_MAIN();
 
     // log fail
-    ESP_LOGW(ESP_MQTT_LOG_TAG, "esp_mqtt_process: connection attempt failed");
+    ESP_LOGW(ESP_MQTT_LOG_TAG, "esp_mqtt_process: connection attempt failed, retry in %u ms", delay);
+
+    // wait for the delay or a stop (the doorbell)
+    bool available = false;
+    if (!esp_mqtt_process_wait(-1, delay, &available)) {
+      vTaskDelay(delay / portTICK_PERIOD_MS);
+    }
 
-    // delay loop by 1s and yield to other processes
-    vTaskDelay(1000 / portTICK_PERIOD_MS);
+    // increase delay
+    delay = delay * 2 > CONFIG_ESP_MQTT_RECONNECT_DELAY_MAX ? CONFIG_ESP_MQTT_RECONNECT_DELAY_MAX : delay * 2;
   }
 
   // call callback if existing
-  if (esp_mqtt_status_callback) {
+  if (esp_mqtt_connected && esp_mqtt_status_callback) {
     esp_mqtt_status_callback(ESP_MQTT_STATUS_CONNECTED);
   }
 
-  // yield loop
-  for (;;) {
-    // check for error
-    if (esp_mqtt_error) {
+  // event loop: the task only wakes up for incoming data, a ring (publish, stop, error) or a due keep alive
+  while (esp_mqtt_connected) {
+    // check for error or stop
+    if (esp_mqtt_error || esp_mqtt_stopping) {
       break;
     }
 
-    // acquire select mutex
-    ESP_MQTT_LOCK_SELECT();
-
-    // block until data is available
+    // block until there is work
     bool available = false;
-
-    lwmqtt_err_t err;
-#if defined(CONFIG_ESP_MQTT_TLS_ENABLE)
-    if (esp_mqtt_use_tls) {
-      err = esp_tls_lwmqtt_network_select(&esp_mqtt_tls_network, &available, esp_mqtt_command_timeout);
-    } else {
-      err = esp_lwmqtt_network_select(&esp_mqtt_network, &available, esp_mqtt_command_timeout);
+    if (!esp_mqtt_process_wait(esp_mqtt_socket(), esp_mqtt_loop_timeout(&esp_mqtt_client), &available)) {
+      break;
     }
-#else
-    err = esp_lwmqtt_network_select(&esp_mqtt_network, &available, esp_mqtt_command_timeout);
-#endif
 
-    if (err != LWMQTT_SUCCESS) {
-      ESP_LOGE(ESP_MQTT_LOG_TAG, "esp_lwmqtt_network_select: %d", err);
-      ESP_MQTT_UNLOCK_SELECT();
+    // check for error or stop
+    if (esp_mqtt_error || esp_mqtt_stopping) {
       break;
     }
 
-    // release select mutex
-    ESP_MQTT_UNLOCK_SELECT();
-
     // acquire mutex
     ESP_MQTT_LOCK_MAIN();
 
-    // process data if available
-    if (available) {
-      // get available bytes
-      size_t available_bytes = 0;
-
-#if defined(CONFIG_ESP_MQTT_TLS_ENABLE)
-      if (esp_mqtt_use_tls) {
-        err = esp_tls_lwmqtt_network_peek(&esp_mqtt_tls_network, &available_bytes, esp_mqtt_command_timeout);
-      } else {
-        err = esp_lwmqtt_network_peek(&esp_mqtt_network, &available_bytes);
-      }
-#else
-      err = esp_lwmqtt_network_peek(&esp_mqtt_network, &available_bytes);
-#endif
-
-      if (err != LWMQTT_SUCCESS) {
-        ESP_LOGE(ESP_MQTT_LOG_TAG, "esp_lwmqtt_network_peek: %d", err);
-        ESP_MQTT_UNLOCK_MAIN();
-        break;
-      }
-
-      // yield client only if there is still data to read since select might unblock because of incoming ack packets
-      // that are already handled until we get to this point
-      if (available_bytes > 0) {
-        err = lwmqtt_yield(&esp_mqtt_client, available_bytes, esp_mqtt_command_timeout);
-        if (err != LWMQTT_SUCCESS) {
-          ESP_LOGE(ESP_MQTT_LOG_TAG, "lwmqtt_yield: %d", err);
-          ESP_MQTT_UNLOCK_MAIN();
-          break;
-        }
-      }
-    }
-
-    // do mqtt background work
-    err = lwmqtt_keep_alive(&esp_mqtt_client, esp_mqtt_command_timeout);
-    if (err != LWMQTT_SUCCESS) {
-      ESP_LOGE(ESP_MQTT_LOG_TAG, "lwmqtt_keep_alive: %d", err);
-      ESP_MQTT_UNLOCK_MAIN();
-      break;
-    }
+    // read all available packets, publish the queued messages and keep alive
+    lwmqtt_err_t err =
+        esp_mqtt_loop_process(&esp_mqtt_client, esp_mqtt_peek, NULL, &esp_mqtt_outbox, esp_mqtt_command_timeout);
 
     // release mutex
     ESP_MQTT_UNLOCK_MAIN();
 
     // dispatch queued events
     esp_mqtt_dispatch_events();
+
+    if (err != LWMQTT_SUCCESS) {
+      break;
+    }
   }
 
   // acquire mutex
   ESP_MQTT_LOCK_MAIN();
 
+  // attempt to properly disconnect a connected client when stopped
+  if (esp_mqtt_stopping && esp_mqtt_connected) {
+    lwmqtt_err_t err = lwmqtt_disconnect(&esp_mqtt_client, esp_mqtt_command_timeout);
+    if (err != LWMQTT_SUCCESS) {
+      ESP_LOGE(ESP_MQTT_LOG_TAG, "lwmqtt_disconnect: %d", err);
+    }
+  }
+
 // disconnect network
 #if defined(CONFIG_ESP_MQTT_TLS_ENABLE)
   if (esp_mqtt_use_tls) {
@@ -413,18 +460,35 @@ static void esp_mqtt_process(void *p) {
   esp_lwmqtt_network_disconnect(&esp_mqtt_network);
 #endif
 
+  // drop unsent messages: their publishers return false
+  uint32_t dropped = 0;
+  esp_mqtt_message_t *msg;
+  while ((msg = esp_mqtt_inbox_take(&esp_mqtt_outbox)) != NULL) {
+    esp_mqtt_message_complete(msg, LWMQTT_NETWORK_FAILED_WRITE);
+    dropped++;
+  }
+  if (dropped > 0) {
+    esp_mqtt_outbox_dropped += dropped;
+    ESP_LOGW(ESP_MQTT_LOG_TAG, "esp_mqtt_process: dropped %u unsent messages (%u in total)", dropped,
+             esp_mqtt_outbox_dropped);
+  }
+
   // set local flags
+  bool stopped = esp_mqtt_stopping;
   esp_mqtt_connected = false;
   esp_mqtt_running = false;
   esp_mqtt_error = false;
+  esp_mqtt_stopping = false;
 
   // release mutex
   ESP_MQTT_UNLOCK_MAIN();
 
   ESP_LOGI(ESP_MQTT_LOG_TAG, "esp_mqtt_process: exit task");
 
-  // call callback if existing
-  if (esp_mqtt_status_callback) {
+  // signal a waiting esp_mqtt_stop() or call callback if existing
+  if (stopped) {
+    xSemaphoreGive(esp_mqtt_exit_semaphore);
+  } else if (esp_mqtt_status_callback) {
     esp_mqtt_status_callback(ESP_MQTT_STATUS_DISCONNECTED);
   }
 
@@ -535,6 +599,17 @@ bool esp_mqtt_start(const char *host, const char *port, const char *client_id, c
     esp_mqtt_config.password = strdup(password);
   }
 
+  // open doorbell once
+  if (esp_mqtt_doorbell.socket < 0) {
+    lwmqtt_err_t err = esp_lwmqtt_doorbell_open(&esp_mqtt_doorbell);
+    if (err != LWMQTT_SUCCESS) {
+      esp_mqtt_doorbell.socket = -1;
+      ESP_LOGE(ESP_MQTT_LOG_TAG, "esp_lwmqtt_doorbell_open: %d", err);
+      ESP_MQTT_UNLOCK_MAIN();
+      return false;
+    }
+  }
+
   // create mqtt thread
   ESP_LOGI(ESP_MQTT_LOG_TAG, "esp_mqtt_start: create task");
   BaseType_t ret = xTaskCreatePinnedToCore(esp_mqtt_process, "esp_mqtt", CONFIG_ESP_MQTT_TASK_STACK_SIZE, NULL,
@@ -572,12 +647,16 @@ bool esp_mqtt_subscribe(const char *topic, int qos) {
     esp_mqtt_error = true;
     ESP_LOGE(ESP_MQTT_LOG_TAG, "lwmqtt_subscribe_one: %d", err);
     ESP_MQTT_UNLOCK_MAIN();
+    esp_lwmqtt_doorbell_ring(&esp_mqtt_doorbell);
     return false;
   }
 
   // release mutex
   ESP_MQTT_UNLOCK_MAIN();
 
+  // let the process task dispatch messages that have been received meanwhile
+  esp_lwmqtt_doorbell_ring(&esp_mqtt_doorbell);
+
   return true;
 }
 
@@ -598,23 +677,23 @@ bool esp_mqtt_unsubscribe(const char *topic) {
     esp_mqtt_error = true;
     ESP_LOGE(ESP_MQTT_LOG_TAG, "lwmqtt_unsubscribe_one: %d", err);
     ESP_MQTT_UNLOCK_MAIN();
+    esp_lwmqtt_doorbell_ring(&esp_mqtt_doorbell);
     return false;
   }
 
   // release mutex
   ESP_MQTT_UNLOCK_MAIN();
 
+  // let the process task dispatch messages that have been received meanwhile
+  esp_lwmqtt_doorbell_ring(&esp_mqtt_doorbell);
+
   return true;
 }
 
 bool esp_mqtt_publish(const char *topic, uint8_t *payload, size_t len, int qos, bool retained) {
-  // acquire mutex
-  ESP_MQTT_LOCK_MAIN();
-
   // check if still connected
   if (!esp_mqtt_connected) {
     ESP_LOGW(ESP_MQTT_LOG_TAG, "esp_mqtt_publish: not connected");
-    ESP_MQTT_UNLOCK_MAIN();
     return false;
   }
 
@@ -625,63 +704,69 @@ bool esp_mqtt_publish(const char *topic, uint8_t *payload, size_t len, int qos,
   message.payload = payload;
   message.payload_len = len;
 
-  // publish message
-  lwmqtt_err_t err = lwmqtt_publish(&esp_mqtt_client, lwmqtt_string(topic), message, esp_mqtt_command_timeout);
-  if (err != LWMQTT_SUCCESS) {
-    esp_mqtt_error = true;
-    ESP_LOGE(ESP_MQTT_LOG_TAG, "lwmqtt_publish: %d", err);
+  // publish directly if called by a callback (the process task cannot wait for itself)
+  if (xTaskGetCurrentTaskHandle() == esp_mqtt_task) {
+    ESP_MQTT_LOCK_MAIN();
+    lwmqtt_err_t err = lwmqtt_publish(&esp_mqtt_client, lwmqtt_string(topic), message, esp_mqtt_command_timeout);
     ESP_MQTT_UNLOCK_MAIN();
+    if (err != LWMQTT_SUCCESS) {
+      esp_mqtt_error = true;
+      ESP_LOGE(ESP_MQTT_LOG_TAG, "lwmqtt_publish: %d", err);
+      return false;
+    }
+    return true;
+  }
+
+  // queue message for the process task (waits for a free slot up to the command timeout)
+  esp_mqtt_message_t *msg = esp_mqtt_inbox_put_tracked(&esp_mqtt_outbox, lwmqtt_string(topic), message,
+                                                       esp_mqtt_command_timeout / portTICK_PERIOD_MS);
+  if (msg == NULL) {
+    ESP_LOGE(ESP_MQTT_LOG_TAG, "esp_mqtt_publish: outbox full or message too big");
     return false;
   }
 
-  // release mutex
-  ESP_MQTT_UNLOCK_MAIN();
+  // wake up process task
+  esp_lwmqtt_doorbell_ring(&esp_mqtt_doorbell);
+
+  // wait until the message has been sent and acknowledged (the queued messages before it take up to a command timeout
+  // each)
+  lwmqtt_err_t err = LWMQTT_SUCCESS;
+  uint32_t timeout = (CONFIG_ESP_MQTT_OUTBOX_SIZE + 1) * esp_mqtt_command_timeout;
+  if (!esp_mqtt_message_wait(msg, timeout / portTICK_PERIOD_MS, &err)) {
+    ESP_LOGE(ESP_MQTT_LOG_TAG, "esp_mqtt_publish: no result within %u ms", timeout);
+    return false;
+  }
+  if (err != LWMQTT_SUCCESS) {
+    ESP_LOGE(ESP_MQTT_LOG_TAG, "esp_mqtt_publish: %d", err);
+    return false;
+  }
 
   return true;
 }
 
 void esp_mqtt_stop() {
-  // acquire mutexes
+  // acquire mutex
   ESP_MQTT_LOCK_MAIN();
-  ESP_MQTT_LOCK_SELECT();
 
   // return immediately if not running anymore
   if (!esp_mqtt_running) {
-    ESP_MQTT_UNLOCK_SELECT();
     ESP_MQTT_UNLOCK_MAIN();
     return;
   }
 
-  // attempt to properly disconnect a connected client
-  if (esp_mqtt_connected) {
-    lwmqtt_err_t err = lwmqtt_disconnect(&esp_mqtt_client, esp_mqtt_command_timeout);
-    if (err != LWMQTT_SUCCESS) {
-      ESP_LOGE(ESP_MQTT_LOG_TAG, "lwmqtt_disconnect: %d", err);
-    }
+  // ask the process task to disconnect and exit
+  esp_mqtt_stopping = true;
 
-    // set flag
-    esp_mqtt_connected = false;
-  }
+  // release mutex
+  ESP_MQTT_UNLOCK_MAIN();
 
-// disconnect network
-#if defined(CONFIG_ESP_MQTT_TLS_ENABLE)
-  if (esp_mqtt_use_tls) {
-    esp_tls_lwmqtt_network_disconnect(&esp_mqtt_tls_network);
-  } else {
-    esp_lwmqtt_network_disconnect(&esp_mqtt_network);
+  // return immediately if called by a callback (the process task exits when the callback returns)
+  if (xTaskGetCurrentTaskHandle() == esp_mqtt_task) {
+    return;
   }
-#else
-  esp_lwmqtt_network_disconnect(&esp_mqtt_network);
-#endif
-
-  // kill mqtt task
-  ESP_LOGI(ESP_MQTT_LOG_TAG, "esp_mqtt_stop: deleting task");
-  vTaskDelete(esp_mqtt_task);
 
-  // set flag
-  esp_mqtt_running = false;
-
-  // release mutexes
-  ESP_MQTT_UNLOCK_SELECT();
-  ESP_MQTT_UNLOCK_MAIN();
+  // wake up process task and wait until it has exited
+  ESP_LOGI(ESP_MQTT_LOG_TAG, "esp_mqtt_stop: waiting for task");
+  esp_lwmqtt_doorbell_ring(&esp_mqtt_doorbell);
+  xSemaphoreTake(esp_mqtt_exit_semaphore, portMAX_DELAY);
 }
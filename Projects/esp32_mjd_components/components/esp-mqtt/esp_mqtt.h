@@ -4,6 +4,14 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include <sdkconfig.h>
+
+#include "esp_mqtt_inbox.h"
+
+#if defined(CONFIG_ESP_MQTT_TLS_ENABLE)
+#include "esp_tls_lwmqtt.h"
+#endif
+
 /**
  * The statuses emitted by the status callback.
  */
@@ -19,6 +27,14 @@ typedef void (*esp_mqtt_status_callback_t)(esp_mqtt_status_t);
  */
 typedef void (*esp_mqtt_message_callback_t)(const char *topic, uint8_t *payload, size_t len);
 
+/**
+ * The borrow callback.
+ *
+ * The message lives in a preallocated inbox slot and is valid until the callback returns. Call
+ * `esp_mqtt_message_retain()` to keep it longer and `esp_mqtt_message_release()` when done with it.
+ */
+typedef void (*esp_mqtt_borrow_callback_t)(esp_mqtt_message_t *msg);
+
 /**
  * Initialize the MQTT management system.
  *
@@ -28,10 +44,27 @@ typedef void (*esp_mqtt_message_callback_t)(const char *topic, uint8_t *payload,
  * @param mcb - The message callback.
  * @param buffer_size - The read and write buffer size.
  * @param command_timeout - The command timeout.
+ * @return Whether the buffers and the message slots could be allocated (nothing is left allocated if not).
  */
-void esp_mqtt_init(esp_mqtt_status_callback_t scb, esp_mqtt_message_callback_t mcb, size_t buffer_size,
+bool esp_mqtt_init(esp_mqtt_status_callback_t scb, esp_mqtt_message_callback_t mcb, size_t buffer_size,
                    int command_timeout);
 
+/**
+ * Set the borrow callback. It replaces the message callback: the message is handed over without copies.
+ *
+ * Note: Should be called before `esp_mqtt_start`.
+ *
+ * @param bcb - The borrow callback (NULL = use the message callback again).
+ */
+void esp_mqtt_set_borrow_callback(esp_mqtt_borrow_callback_t bcb);
+
+/**
+ * Get the statistics of the inbound message slots (received, dispatched, dropped).
+ *
+ * @param stats - The statistics.
+ */
+void esp_mqtt_get_inbox_stats(esp_mqtt_inbox_stats_t *stats);
+
 #if defined(CONFIG_ESP_MQTT_TLS_ENABLE)
 /**
  * Configure TLS connection.
@@ -47,6 +80,14 @@ void esp_mqtt_init(esp_mqtt_status_callback_t scb, esp_mqtt_message_callback_t m
  * @return Whether TLS configuration was successful.
  */
 bool esp_mqtt_tls(bool enable, bool verify, const uint8_t *ca_buf, size_t ca_len);
+
+/**
+ * Get the TLS handshake statistics: the duration of the phases of the last handshake and the number of full, resumed and
+ * failed handshakes.
+ *
+ * @param stats - The statistics.
+ */
+void esp_mqtt_tls_get_stats(esp_tls_lwmqtt_stats_t *stats);
 #endif
 
 /**
@@ -64,8 +105,9 @@ void esp_mqtt_lwt(const char *topic, const char *payload, int qos, bool retained
 /**
  * Start the MQTT process.
  *
- * The background process will attempt to connect to the specified broker once a second until a connection can be
- * established. This process can be interrupted by calling `esp_mqtt_stop();`. If a connection has been established,
+ * The background process will attempt to connect to the specified broker until a connection can be established. The
+ * delay between the attempts starts at `CONFIG_ESP_MQTT_RECONNECT_DELAY_MIN` and doubles up to
+ * `CONFIG_ESP_MQTT_RECONNECT_DELAY_MAX`. This process can be interrupted by calling `esp_mqtt_stop();`. If a connection has been established,
  * the status callback will be called with `ESP_MQTT_STATUS_CONNECTED`. From that moment on the functions
  * `esp_mqtt_subscribe`, `esp_mqtt_unsubscribe` and `esp_mqtt_publish` can be used to interact with the broker.
  *
@@ -109,24 +151,27 @@ bool esp_mqtt_unsubscribe(const char *topic);
 /**
  * Publish bytes payload to specified topic.
  *
- * When false is returned the current operation failed and any subsequent interactions will also fail. This can be used
- * to handle errors early. As soon as the background process unblocks the error will be detected, the connection closed
- * and the status callback invoked with `ESP_MQTT_STATUS_DISCONNECTED`. That callback then can simply call
- * `esp_mqtt_start()` to attempt an reconnection.
+ * The message is copied into a slot of the outbox and sent by the background process, which is woken up immediately.
+ * The call returns when the message has been sent and, for qos 1 and 2, acknowledged by the broker. It waits up to the
+ * command timeout for a free slot while all `CONFIG_ESP_MQTT_OUTBOX_SIZE` slots are in use. When the background
+ * process fails to send the message, or the connection is lost before, false is returned; the connection is closed and
+ * the status callback invoked with `ESP_MQTT_STATUS_DISCONNECTED`. Called from a callback the message is published
+ * directly.
  *
  * @param topic - The topic.
  * @param payload - The payload.
  * @param len - The payload length.
  * @param qos - The qos level.
  * @param retained - The retained flag.
- * @return Whether the operation was successful.
+ * @return Whether the message has been delivered (false = not connected, outbox full, message too big or not sent).
  */
 bool esp_mqtt_publish(const char *topic, uint8_t *payload, size_t len, int qos, bool retained);
 
 /**
  * Stop the MQTT process.
  *
- * Will stop initial connection attempts or disconnect any active connection.
+ * Will stop initial connection attempts or disconnect any active connection. Blocks until the background process has
+ * exited, unless called from a callback.
  */
 void esp_mqtt_stop();
 
@@ -0,0 +1,238 @@
+#include <esp_log.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_mqtt_inbox.h"
+
+#define ESP_MQTT_INBOX_LOG_TAG "esp_mqtt"
+
+bool esp_mqtt_inbox_init(esp_mqtt_inbox_t *inbox, uint32_t num_slots, size_t slot_size, bool tracked) {
+  // reset inbox
+  memset(inbox, 0, sizeof(esp_mqtt_inbox_t));
+
+  // check arguments
+  if (num_slots == 0) {
+    ESP_LOGE(ESP_MQTT_INBOX_LOG_TAG, "esp_mqtt_inbox_init: invalid number of slots");
+    return false;
+  }
+
+  // a slot is the message header followed by the topic and payload bytes (8 byte aligned)
+  inbox->num_slots = num_slots;
+  inbox->slot_size = slot_size;
+  inbox->slot_stride = (sizeof(esp_mqtt_message_t) + slot_size + 7) & ~((size_t)7);
+  inbox->tracked = tracked;
+
+  // allocate all slots at once
+  inbox->storage = calloc(num_slots, inbox->slot_stride);
+  inbox->free_queue = xQueueCreate(num_slots, sizeof(esp_mqtt_message_t *));
+  inbox->ready_queue = xQueueCreate(num_slots, sizeof(esp_mqtt_message_t *));
+  if (inbox->storage == NULL || inbox->free_queue == NULL || inbox->ready_queue == NULL) {
+    ESP_LOGE(ESP_MQTT_INBOX_LOG_TAG, "esp_mqtt_inbox_init: cannot allocate %u slots of %u bytes", num_slots,
+             (uint32_t)slot_size);
+    esp_mqtt_inbox_deinit(inbox);
+    return false;
+  }
+
+  // fill free queue
+  for (uint32_t i = 0; i < num_slots; i++) {
+    esp_mqtt_message_t *msg = (esp_mqtt_message_t *)(inbox->storage + i * inbox->slot_stride);
+    msg->inbox = inbox;
+
+    // create the semaphore of a tracked slot
+    if (tracked) {
+      msg->done = xSemaphoreCreateBinary();
+      if (msg->done == NULL) {
+        ESP_LOGE(ESP_MQTT_INBOX_LOG_TAG, "esp_mqtt_inbox_init: cannot create the semaphores of %u slots", num_slots);
+        esp_mqtt_inbox_deinit(inbox);
+        return false;
+      }
+    }
+
+    xQueueSend(inbox->free_queue, &msg, 0);
+  }
+
+  inbox->stats.min_free_slots = num_slots;
+
+  return true;
+}
+
+void esp_mqtt_inbox_deinit(esp_mqtt_inbox_t *inbox) {
+  // give back the queued messages
+  if (inbox->ready_queue != NULL) {
+    esp_mqtt_inbox_dispatch(inbox, NULL, NULL);
+    vQueueDelete(inbox->ready_queue);
+  }
+
+  // delete free queue
+  if (inbox->free_queue != NULL) {
+    vQueueDelete(inbox->free_queue);
+  }
+
+  // delete semaphores and free slots
+  if (inbox->storage != NULL) {
+    for (uint32_t i = 0; i < inbox->num_slots; i++) {
+      esp_mqtt_message_t *msg = (esp_mqtt_message_t *)(inbox->storage + i * inbox->slot_stride);
+      if (msg->done != NULL) {
+        vSemaphoreDelete(msg->done);
+      }
+    }
+    free(inbox->storage);
+  }
+
+  // reset inbox
+  memset(inbox, 0, sizeof(esp_mqtt_inbox_t));
+}
+
+static esp_mqtt_message_t *esp_mqtt_inbox_queue(esp_mqtt_inbox_t *inbox, lwmqtt_string_t topic, lwmqtt_message_t msg,
+                                                TickType_t timeout, bool tracked) {
+  // count message (the outbox is shared by the publisher tasks)
+  __atomic_add_fetch(&inbox->stats.received, 1, __ATOMIC_RELAXED);
+
+  // check size (topic and payload are null terminated)
+  size_t size = (size_t)topic.len + msg.payload_len + 2;
+  if (size > inbox->slot_size) {
+    uint32_t dropped = __atomic_add_fetch(&inbox->stats.dropped_too_big, 1, __ATOMIC_RELAXED);
+    ESP_LOGW(ESP_MQTT_INBOX_LOG_TAG,
+             "esp_mqtt_inbox_put: message of %u bytes too big for a slot of %u bytes, dropping message (%u dropped)",
+             (uint32_t)size, (uint32_t)inbox->slot_size, dropped);
+    return NULL;
+  }
+
+  // take free slot
+  esp_mqtt_message_t *slot = NULL;
+  if (xQueueReceive(inbox->free_queue, &slot, timeout) != pdTRUE) {
+    uint32_t dropped = __atomic_add_fetch(&inbox->stats.dropped_full, 1, __ATOMIC_RELAXED);
+    ESP_LOGW(ESP_MQTT_INBOX_LOG_TAG, "esp_mqtt_inbox_put: all %u slots in use, dropping message (%u dropped)",
+             inbox->num_slots, dropped);
+    return NULL;
+  }
+
+  // update low water mark
+  uint32_t free_slots = (uint32_t)uxQueueMessagesWaiting(inbox->free_queue);
+  uint32_t min_free_slots = __atomic_load_n(&inbox->stats.min_free_slots, __ATOMIC_RELAXED);
+  while (free_slots < min_free_slots &&
+         !__atomic_compare_exchange_n(&inbox->stats.min_free_slots, &min_free_slots, free_slots, false,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+  }
+
+  // copy topic with additional null termination
+  uint8_t *data = (uint8_t *)(slot + 1);
+  slot->topic = (char *)data;
+  slot->topic_len = (size_t)topic.len;
+  memcpy(slot->topic, topic.data, (size_t)topic.len);
+  slot->topic[topic.len] = 0;
+
+  // copy payload with additional null termination
+  slot->payload = data + topic.len + 1;
+  slot->payload_len = msg.payload_len;
+  memcpy(slot->payload, msg.payload, msg.payload_len);
+  slot->payload[msg.payload_len] = 0;
+
+  slot->qos = (int)msg.qos;
+  slot->retained = msg.retained;
+
+  // clear a completion of the previous message that nobody waited for (it was given before the slot was released)
+  slot->completed = false;
+  slot->result = LWMQTT_SUCCESS;
+  if (slot->done != NULL) {
+    xSemaphoreTake(slot->done, 0);
+  }
+
+  // the inbox holds the first reference until the message is dispatched, a waiting task the second one
+  slot->refs = tracked ? 2 : 1;
+
+  // queue slot (cannot fail: the ready queue has room for all slots)
+  xQueueSend(inbox->ready_queue, &slot, 0);
+
+  return slot;
+}
+
+bool esp_mqtt_inbox_put(esp_mqtt_inbox_t *inbox, lwmqtt_string_t topic, lwmqtt_message_t msg, TickType_t timeout) {
+  return esp_mqtt_inbox_queue(inbox, topic, msg, timeout, false) != NULL;
+}
+
+esp_mqtt_message_t *esp_mqtt_inbox_put_tracked(esp_mqtt_inbox_t *inbox, lwmqtt_string_t topic, lwmqtt_message_t msg,
+                                               TickType_t timeout) {
+  // check inbox
+  if (!inbox->tracked) {
+    ESP_LOGE(ESP_MQTT_INBOX_LOG_TAG, "esp_mqtt_inbox_put_tracked: the slots are not tracked");
+    return NULL;
+  }
+
+  return esp_mqtt_inbox_queue(inbox, topic, msg, timeout, true);
+}
+
+esp_mqtt_message_t *esp_mqtt_inbox_take(esp_mqtt_inbox_t *inbox) {
+  // receive next message
+  esp_mqtt_message_t *msg = NULL;
+  if (xQueueReceive(inbox->ready_queue, &msg, 0) != pdTRUE) {
+    return NULL;
+  }
+
+  // count message
+  __atomic_add_fetch(&inbox->stats.dispatched, 1, __ATOMIC_RELAXED);
+
+  return msg;
+}
+
+uint32_t esp_mqtt_inbox_dispatch(esp_mqtt_inbox_t *inbox, esp_mqtt_inbox_callback_t cb, void *ref) {
+  // prepare message
+  esp_mqtt_message_t *msg = NULL;
+  uint32_t num = 0;
+
+  // take next message
+  while ((msg = esp_mqtt_inbox_take(inbox)) != NULL) {
+    num++;
+
+    // lend message to callback
+    if (cb) {
+      cb(msg, ref);
+    }
+
+    // drop reference of the inbox
+    esp_mqtt_message_release(msg);
+  }
+
+  return num;
+}
+
+void esp_mqtt_message_complete(esp_mqtt_message_t *msg, lwmqtt_err_t result) {
+  // set result
+  msg->result = result;
+  __atomic_store_n(&msg->completed, true, __ATOMIC_RELEASE);
+
+  // wake up the waiting task (if it gave up, the slot clears the semaphore before it is used again)
+  if (msg->done != NULL) {
+    xSemaphoreGive(msg->done);
+  }
+
+  // drop reference of the consumer
+  esp_mqtt_message_release(msg);
+}
+
+bool esp_mqtt_message_wait(esp_mqtt_message_t *msg, TickType_t timeout, lwmqtt_err_t *result) {
+  // wait for the result
+  if (!__atomic_load_n(&msg->completed, __ATOMIC_ACQUIRE)) {
+    xSemaphoreTake(msg->done, timeout);
+  }
+
+  // get result
+  bool completed = __atomic_load_n(&msg->completed, __ATOMIC_ACQUIRE);
+  *result = msg->result;
+
+  // drop reference of the waiting task
+  esp_mqtt_message_release(msg);
+
+  return completed;
+}
+
+void esp_mqtt_message_retain(esp_mqtt_message_t *msg) { __atomic_add_fetch(&msg->refs, 1, __ATOMIC_RELAXED); }
+
+void esp_mqtt_message_release(esp_mqtt_message_t *msg) {
+  // give slot back when the last reference is gone
+  if (__atomic_sub_fetch(&msg->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+    xQueueSend(msg->inbox->free_queue, &msg, 0);
+  }
+}
+
+void esp_mqtt_inbox_get_stats(esp_mqtt_inbox_t *inbox, esp_mqtt_inbox_stats_t *stats) { *stats = inbox->stats; }
@@ -0,0 +1,156 @@
+#ifndef ESP_MQTT_INBOX_H
+#define ESP_MQTT_INBOX_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <lwmqtt.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * An inbound message.
+ *
+ * The topic and the payload are null terminated and live in a preallocated inbox slot. The message is borrowed by the
+ * callback: it is valid until the callback returns, unless the callback calls `esp_mqtt_message_retain()` and later
+ * `esp_mqtt_message_release()` (from any task) to give the slot back. The message must not be modified.
+ */
+typedef struct esp_mqtt_message_t {
+  char *topic;
+  size_t topic_len;
+  uint8_t *payload;
+  size_t payload_len;
+  int qos;
+  bool retained;
+
+  // private
+  uint32_t refs;
+  bool completed;
+  lwmqtt_err_t result;
+  SemaphoreHandle_t done;
+  struct esp_mqtt_inbox_t *inbox;
+} esp_mqtt_message_t;
+
+/**
+ * The inbox statistics.
+ */
+typedef struct {
+  uint32_t received;
+  uint32_t dispatched;
+  uint32_t dropped_full;
+  uint32_t dropped_too_big;
+  uint32_t min_free_slots;
+} esp_mqtt_inbox_stats_t;
+
+/**
+ * A fixed set of message slots that are allocated once. A received message is copied once from the read buffer into a
+ * free slot, the slot is queued and given back to the free queue when the last reference is released. A message that
+ * arrives when all slots are in use is dropped and counted.
+ *
+ * The same structure queues the outbound messages of the publishers for the process task (the outbox). Its slots are
+ * tracked: each one has a semaphore the publisher waits on until the process task completes the message.
+ */
+typedef struct esp_mqtt_inbox_t {
+  uint8_t *storage;
+  size_t slot_size;
+  size_t slot_stride;
+  uint32_t num_slots;
+  bool tracked;
+  QueueHandle_t free_queue;
+  QueueHandle_t ready_queue;
+  esp_mqtt_inbox_stats_t stats;
+} esp_mqtt_inbox_t;
+
+/**
+ * The callback that borrows a dispatched message.
+ */
+typedef void (*esp_mqtt_inbox_callback_t)(esp_mqtt_message_t *msg, void *ref);
+
+/**
+ * Initialize the inbox: allocates all slots at once.
+ *
+ * @param inbox - The inbox.
+ * @param num_slots - The number of slots (= the max number of queued and retained messages).
+ * @param slot_size - The max topic length + payload length + 2 (null terminations) of a message.
+ * @param tracked - Whether the slots get a semaphore for `esp_mqtt_inbox_put_tracked()`.
+ * @return Whether the allocation was successful (nothing is left allocated if not).
+ */
+bool esp_mqtt_inbox_init(esp_mqtt_inbox_t *inbox, uint32_t num_slots, size_t slot_size, bool tracked);
+
+/**
+ * Release the queued messages and free the inbox.
+ *
+ * Note: The retained messages must have been released before.
+ *
+ * @param inbox - The inbox.
+ */
+void esp_mqtt_inbox_deinit(esp_mqtt_inbox_t *inbox);
+
+/**
+ * Copy a message into a free slot and queue it.
+ *
+ * @param timeout - The ticks to wait for a free slot (0 = never blocks).
+ * @return Whether the message was queued (false = no free slot or the message does not fit in a slot).
+ */
+bool esp_mqtt_inbox_put(esp_mqtt_inbox_t *inbox, lwmqtt_string_t topic, lwmqtt_message_t msg, TickType_t timeout);
+
+/**
+ * Copy a message into a free slot and queue it like `esp_mqtt_inbox_put()`, and keep a reference for the calling task:
+ * it waits with `esp_mqtt_message_wait()` until the consumer calls `esp_mqtt_message_complete()`.
+ *
+ * Note: The inbox must have been initialized as tracked.
+ *
+ * @param timeout - The ticks to wait for a free slot (0 = never blocks).
+ * @return The message or NULL if it was not queued.
+ */
+esp_mqtt_message_t *esp_mqtt_inbox_put_tracked(esp_mqtt_inbox_t *inbox, lwmqtt_string_t topic, lwmqtt_message_t msg,
+                                               TickType_t timeout);
+
+/**
+ * Take the next queued message. Never blocks.
+ *
+ * @return The message (the caller owns the reference and releases it) or NULL if none is queued.
+ */
+esp_mqtt_message_t *esp_mqtt_inbox_take(esp_mqtt_inbox_t *inbox);
+
+/**
+ * Hand all queued messages to the callback and release them afterwards.
+ *
+ * @return The number of dispatched messages.
+ */
+uint32_t esp_mqtt_inbox_dispatch(esp_mqtt_inbox_t *inbox, esp_mqtt_inbox_callback_t cb, void *ref);
+
+/**
+ * Set the result of a taken message, wake up its waiting task (if tracked) and release it.
+ *
+ * @param result - The result, e.g. of the publish.
+ */
+void esp_mqtt_message_complete(esp_mqtt_message_t *msg, lwmqtt_err_t result);
+
+/**
+ * Wait until a tracked message has been completed and release it.
+ *
+ * Note: Waits on the semaphore of the message slot (the task notification of the caller is not used).
+ *
+ * @param timeout - The ticks to wait.
+ * @param result - The result of the consumer.
+ * @return Whether the message has been completed within the timeout.
+ */
+bool esp_mqtt_message_wait(esp_mqtt_message_t *msg, TickType_t timeout, lwmqtt_err_t *result);
+
+/**
+ * Keep a borrowed message after the callback returned.
+ */
+void esp_mqtt_message_retain(esp_mqtt_message_t *msg);
+
+/**
+ * Give a retained message back to its inbox.
+ */
+void esp_mqtt_message_release(esp_mqtt_message_t *msg);
+
+/**
+ * Get a copy of the inbox statistics.
+ */
+void esp_mqtt_inbox_get_stats(esp_mqtt_inbox_t *inbox, esp_mqtt_inbox_stats_t *stats);
+
+#endif  // ESP_MQTT_INBOX_H
@@ -0,0 +1,78 @@
+#include <esp_log.h>
+
+#include "esp_mqtt_loop.h"
+
+#define ESP_MQTT_LOOP_LOG_TAG "esp_mqtt"
+
+uint32_t esp_mqtt_loop_timeout(lwmqtt_client_t *client) {
+  // wait for events only if keep alive is disabled
+  if (client->keep_alive_interval == 0) {
+    return ESP_MQTT_LOOP_WAIT_FOREVER;
+  }
+
+  // wake up when the keep alive timer expires (ping due or pong missing)
+  int32_t left = client->timer_get(client->keep_alive_timer);
+  if (left <= 0) {
+    return 0;
+  }
+
+  return (uint32_t)left;
+}
+
+lwmqtt_err_t esp_mqtt_loop_process(lwmqtt_client_t *client, esp_mqtt_loop_peek_t peek, void *ref,
+                                   esp_mqtt_inbox_t *outbox, uint32_t timeout) {
+  // read available packets, peek again since more data might have arrived (or be buffered by tls) meanwhile
+  for (int i = 0; i < ESP_MQTT_LOOP_MAX_READS; i++) {
+    // get available bytes
+    size_t available = 0;
+    lwmqtt_err_t err = peek(ref, &available);
+    if (err != LWMQTT_SUCCESS) {
+      ESP_LOGE(ESP_MQTT_LOOP_LOG_TAG, "esp_mqtt_loop_process: peek: %d", err);
+      return err;
+    }
+
+    // stop if nothing is left
+    if (available == 0) {
+      break;
+    }
+
+    // handle all packets of the available bytes
+    err = lwmqtt_yield(client, available, timeout);
+    if (err != LWMQTT_SUCCESS) {
+      ESP_LOGE(ESP_MQTT_LOOP_LOG_TAG, "lwmqtt_yield: %d", err);
+      return err;
+    }
+  }
+
+  // publish queued messages
+  esp_mqtt_message_t *msg;
+  while ((msg = esp_mqtt_inbox_take(outbox)) != NULL) {
+    // prepare message
+    lwmqtt_string_t topic = {.len = (uint16_t)msg->topic_len, .data = msg->topic};
+    lwmqtt_message_t message;
+    message.qos = (lwmqtt_qos_t)msg->qos;
+    message.retained = msg->retained;
+    message.payload = msg->payload;
+    message.payload_len = msg->payload_len;
+
+    // publish message (waits for the acknowledgement of qos 1 and 2, received messages are queued meanwhile)
+    lwmqtt_err_t err = lwmqtt_publish(client, topic, message, timeout);
+
+    // hand the result to the publisher and give slot back
+    esp_mqtt_message_complete(msg, err);
+
+    if (err != LWMQTT_SUCCESS) {
+      ESP_LOGE(ESP_MQTT_LOOP_LOG_TAG, "lwmqtt_publish: %d", err);
+      return err;
+    }
+  }
+
+  // do mqtt background work
+  lwmqtt_err_t err = lwmqtt_keep_alive(client, timeout);
+  if (err != LWMQTT_SUCCESS) {
+    ESP_LOGE(ESP_MQTT_LOOP_LOG_TAG, "lwmqtt_keep_alive: %d", err);
+    return err;
+  }
+
+  return LWMQTT_SUCCESS;
+}
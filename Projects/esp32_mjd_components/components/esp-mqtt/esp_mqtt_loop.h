@@ -0,0 +1,49 @@
+#ifndef ESP_MQTT_LOOP_H
+#define ESP_MQTT_LOOP_H
+
+#include <lwmqtt.h>
+#include <stdint.h>
+
+#include "esp_mqtt_inbox.h"
+
+/**
+ * The timeout that waits until an event occurs.
+ */
+#define ESP_MQTT_LOOP_WAIT_FOREVER UINT32_MAX
+
+/**
+ * The max number of reads per wakeup (each read handles all packets that are available at that moment).
+ */
+#define ESP_MQTT_LOOP_MAX_READS 8
+
+/**
+ * The callback that sets available to the amount of data that can be read without blocking.
+ */
+typedef lwmqtt_err_t (*esp_mqtt_loop_peek_t)(void *ref, size_t *available);
+
+/**
+ * Get the time until the process task has work to do if no event occurs (the next keep alive action).
+ *
+ * The process task blocks on the socket and on the doorbell for this time: there are no periodic wakeups.
+ *
+ * @param client - The connected client.
+ * @return The timeout in milliseconds (0 = now) or ESP_MQTT_LOOP_WAIT_FOREVER if keep alive is disabled.
+ */
+uint32_t esp_mqtt_loop_timeout(lwmqtt_client_t *client);
+
+/**
+ * Do the work of one wakeup: read all available packets (the received messages are queued by the client callback),
+ * publish the queued outbound messages (each one is completed with the result of its publish, which includes the
+ * acknowledgement of qos 1 and 2) and send a ping if due.
+ *
+ * @param client - The connected client.
+ * @param peek - The peek callback of the network.
+ * @param ref - The network reference passed to the peek callback.
+ * @param outbox - The outbound messages.
+ * @param timeout - The command timeout in milliseconds.
+ * @return An error if the connection is broken.
+ */
+lwmqtt_err_t esp_mqtt_loop_process(lwmqtt_client_t *client, esp_mqtt_loop_peek_t peek, void *ref,
+                                   esp_mqtt_inbox_t *outbox, uint32_t timeout);
+
+#endif  // ESP_MQTT_LOOP_H
@@ -1,14 +1,157 @@
+#include <esp_attr.h>
+#include <esp_timer.h>
 #include <lwip/netdb.h>
 #include <string.h>  // needed
+#include <time.h>
 
 // mbed TLS documentation: https://tls.mbed.org
 
 #include "esp_tls_lwmqtt.h"
+#include "esp_tls_lwmqtt_session.h"
+
+#define ESP_TLS_LWMQTT_LOG_TAG "esp_mqtt"
+
+#if defined(CONFIG_ESP_MQTT_TLS_SESSION_RESUMPTION)
+// the last session (RTC slow memory: survives a deep sleep)
+static RTC_DATA_ATTR esp_tls_lwmqtt_session_t esp_tls_lwmqtt_session;
+#endif
+
+#if defined(CONFIG_ESP_MQTT_TLS_PREFER_ECDSA)
+// ecdhe-ecdsa first (p-256: a smaller certificate and a cheaper signature check than rsa 2048), then ecdhe-rsa and rsa
+static const int esp_tls_lwmqtt_ciphersuites[] = {MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+                                                  MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA256,
+                                                  MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA,
+                                                  MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+                                                  MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA256,
+                                                  MBEDTLS_TLS_RSA_WITH_AES_128_GCM_SHA256,
+                                                  MBEDTLS_TLS_RSA_WITH_AES_128_CBC_SHA256,
+                                                  0};
+#if defined(MBEDTLS_ECP_C)
+static const mbedtls_ecp_group_id esp_tls_lwmqtt_curves[] = {MBEDTLS_ECP_DP_SECP256R1, MBEDTLS_ECP_DP_SECP384R1,
+                                                             MBEDTLS_ECP_DP_NONE};
+#endif
+#endif
+
+#if defined(CONFIG_ESP_MQTT_TLS_SESSION_RESUMPTION)
+static void esp_tls_lwmqtt_session_load(esp_tls_lwmqtt_network_t *network, const char *host, const char *port) {
+  // check cached session
+  if (!esp_tls_lwmqtt_session_usable(&esp_tls_lwmqtt_session, host, port, (int64_t)time(NULL),
+                                     CONFIG_ESP_MQTT_TLS_SESSION_MAX_AGE)) {
+    return;
+  }
+
+  // prepare session (the ticket is copied by mbedtls_ssl_set_session)
+  mbedtls_ssl_session session;
+  mbedtls_ssl_session_init(&session);
+  session.ciphersuite = esp_tls_lwmqtt_session.ciphersuite;
+  session.compression = esp_tls_lwmqtt_session.compression;
+  session.verify_result = esp_tls_lwmqtt_session.verify_result;
+  session.id_len = esp_tls_lwmqtt_session.id_len;
+  memcpy(session.id, esp_tls_lwmqtt_session.id, sizeof(session.id));
+  memcpy(session.master, esp_tls_lwmqtt_session.master, sizeof(session.master));
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+  session.ticket = (esp_tls_lwmqtt_session.ticket_len > 0) ? esp_tls_lwmqtt_session.ticket : NULL;
+  session.ticket_len = esp_tls_lwmqtt_session.ticket_len;
+  session.ticket_lifetime = esp_tls_lwmqtt_session.lifetime;
+#endif
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+  session.mfl_code = esp_tls_lwmqtt_session.mfl_code;
+#endif
+#if defined(MBEDTLS_SSL_TRUNCATED_HMAC)
+  session.trunc_hmac = esp_tls_lwmqtt_session.trunc_hmac;
+#endif
+#if defined(MBEDTLS_SSL_ENCRYPT_THEN_MAC)
+  session.encrypt_then_mac = esp_tls_lwmqtt_session.encrypt_then_mac;
+#endif
+
+  // offer session
+  int ret = mbedtls_ssl_set_session(&network->ssl, &session);
+  if (ret != 0) {
+    ESP_LOGW(ESP_TLS_LWMQTT_LOG_TAG, "esp_tls_lwmqtt_session_load: mbedtls_ssl_set_session: -0x%x", -ret);
+  }
+
+  // wipe copy (not freed: the ticket belongs to the record)
+  memset(&session, 0, sizeof(session));
+}
+
+static void esp_tls_lwmqtt_session_save(esp_tls_lwmqtt_network_t *network, const char *host, const char *port) {
+  // get session copy
+  mbedtls_ssl_session session;
+  mbedtls_ssl_session_init(&session);
+  int ret = mbedtls_ssl_get_session(&network->ssl, &session);
+  if (ret != 0) {
+    esp_tls_lwmqtt_session_clear(&esp_tls_lwmqtt_session);
+    mbedtls_ssl_session_free(&session);
+    return;
+  }
+
+  // fill record
+  esp_tls_lwmqtt_session_clear(&esp_tls_lwmqtt_session);
+  esp_tls_lwmqtt_session.ciphersuite = session.ciphersuite;
+  esp_tls_lwmqtt_session.compression = session.compression;
+  esp_tls_lwmqtt_session.verify_result = session.verify_result;
+  esp_tls_lwmqtt_session.id_len = (uint8_t)session.id_len;
+  memcpy(esp_tls_lwmqtt_session.id, session.id, sizeof(esp_tls_lwmqtt_session.id));
+  memcpy(esp_tls_lwmqtt_session.master, session.master, sizeof(esp_tls_lwmqtt_session.master));
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+  // a ticket that does not fit is dropped (the session id can still be resumed)
+  if (session.ticket != NULL && session.ticket_len <= ESP_TLS_LWMQTT_SESSION_TICKET_MAX_LEN) {
+    memcpy(esp_tls_lwmqtt_session.ticket, session.ticket, session.ticket_len);
+    esp_tls_lwmqtt_session.ticket_len = (uint16_t)session.ticket_len;
+    esp_tls_lwmqtt_session.lifetime = session.ticket_lifetime;
+  }
+#endif
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+  esp_tls_lwmqtt_session.mfl_code = session.mfl_code;
+#endif
+#if defined(MBEDTLS_SSL_TRUNCATED_HMAC)
+  esp_tls_lwmqtt_session.trunc_hmac = (uint8_t)session.trunc_hmac;
+#endif
+#if defined(MBEDTLS_SSL_ENCRYPT_THEN_MAC)
+  esp_tls_lwmqtt_session.encrypt_then_mac = (uint8_t)session.encrypt_then_mac;
+#endif
+  esp_tls_lwmqtt_session_seal(&esp_tls_lwmqtt_session, host, port, (int64_t)time(NULL));
+
+  // free copy
+  mbedtls_ssl_session_free(&session);
+}
+#endif
+
+static void esp_tls_lwmqtt_add_step_time(esp_tls_lwmqtt_timing_t *timing, int state, uint32_t us) {
+  // attribute the time of a handshake step to its phase
+  switch (state) {
+    case MBEDTLS_SSL_HELLO_REQUEST:
+    case MBEDTLS_SSL_CLIENT_HELLO:
+    case MBEDTLS_SSL_SERVER_HELLO:
+      timing->hello_us += us;
+      break;
+    case MBEDTLS_SSL_SERVER_CERTIFICATE:
+      timing->certificate_us += us;
+      break;
+    case MBEDTLS_SSL_SERVER_KEY_EXCHANGE:
+    case MBEDTLS_SSL_CERTIFICATE_REQUEST:
+    case MBEDTLS_SSL_SERVER_HELLO_DONE:
+    case MBEDTLS_SSL_CLIENT_CERTIFICATE:
+    case MBEDTLS_SSL_CLIENT_KEY_EXCHANGE:
+    case MBEDTLS_SSL_CERTIFICATE_VERIFY:
+      timing->key_exchange_us += us;
+      break;
+    default:
+      timing->finished_us += us;
+      break;
+  }
+  timing->handshake_us += us;
+}
 
 lwmqtt_err_t esp_tls_lwmqtt_network_connect(esp_tls_lwmqtt_network_t *network, char *host, char *port) {
   // disconnect if not already the case
   esp_tls_lwmqtt_network_disconnect(network);
 
+  // reset timing
+  esp_tls_lwmqtt_timing_t *timing = &network->stats.last;
+  memset(timing, 0, sizeof(esp_tls_lwmqtt_timing_t));
+  int64_t start = esp_timer_get_time();
+
   // initialize support structures
   mbedtls_net_init(&network->socket);
   mbedtls_ssl_init(&network->ssl);
@@ -30,7 +173,9 @@ lwmqtt_err_t esp_tls_lwmqtt_network_connect(esp_tls_lwmqtt_network_t *network, c
   }
 
   // connect socket
+  int64_t connect_start = esp_timer_get_time();
   ret = mbedtls_net_connect(&network->socket, host, port, MBEDTLS_NET_PROTO_TCP);
+  timing->connect_us = (uint32_t)(esp_timer_get_time() - connect_start);
   if (ret != 0) {
     return LWMQTT_NETWORK_FAILED_CONNECT;
   }
@@ -51,6 +196,19 @@ lwmqtt_err_t esp_tls_lwmqtt_network_connect(esp_tls_lwmqtt_network_t *network, c
   // set rng callback
   mbedtls_ssl_conf_rng(&network->conf, mbedtls_ctr_drbg_random, &network->ctr_drbg);
 
+#if defined(CONFIG_ESP_MQTT_TLS_PREFER_ECDSA)
+  // prefer ecdsa suites and the p-256 curve
+  mbedtls_ssl_conf_ciphersuites(&network->conf, esp_tls_lwmqtt_ciphersuites);
+#if defined(MBEDTLS_ECP_C)
+  mbedtls_ssl_conf_curves(&network->conf, esp_tls_lwmqtt_curves);
+#endif
+#endif
+
+#if defined(CONFIG_ESP_MQTT_TLS_SESSION_RESUMPTION) && defined(MBEDTLS_SSL_SESSION_TICKETS)
+  // ask for a session ticket
+  mbedtls_ssl_conf_session_tickets(&network->conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+
   // setup ssl context
   ret = mbedtls_ssl_setup(&network->ssl, &network->conf);
   if (ret != 0) {
@@ -76,16 +234,58 @@ lwmqtt_err_t esp_tls_lwmqtt_network_connect(esp_tls_lwmqtt_network_t *network, c
     }
   }
 
-  // perform handshake
-  ret = mbedtls_ssl_handshake(&network->ssl);
+#if defined(CONFIG_ESP_MQTT_TLS_SESSION_RESUMPTION)
+  // offer the cached session
+  esp_tls_lwmqtt_session_load(network, host, port);
+#endif
+
+  timing->setup_us = (uint32_t)(esp_timer_get_time() - start) - timing->connect_us;
+
+  // perform handshake step by step (same as mbedtls_ssl_handshake) to time the phases
+  bool key_exchange = false;
+  while (network->ssl.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+    int state = network->ssl.state;
+    int64_t step_start = esp_timer_get_time();
+    ret = mbedtls_ssl_handshake_step(&network->ssl);
+    esp_tls_lwmqtt_add_step_time(timing, state, (uint32_t)(esp_timer_get_time() - step_start));
+    key_exchange = key_exchange || state == MBEDTLS_SSL_CLIENT_KEY_EXCHANGE;
+    if (ret != 0) {
+      break;
+    }
+  }
   if (ret != 0) {
     if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
       ESP_LOGE("mbedtls_ssl_handshake", "ERORR: -0x%x", -ret);
     }
+    network->stats.failed_handshakes++;
+
+#if defined(CONFIG_ESP_MQTT_TLS_SESSION_RESUMPTION)
+    // do not offer the session again
+    esp_tls_lwmqtt_session_clear(&esp_tls_lwmqtt_session);
+#endif
 
     return LWMQTT_NETWORK_FAILED_CONNECT;
   }
 
+  // a resumed session skips the key exchange
+  timing->resumed = !key_exchange;
+  if (timing->resumed) {
+    network->stats.resumed_handshakes++;
+  } else {
+    network->stats.full_handshakes++;
+  }
+
+#if defined(CONFIG_ESP_MQTT_TLS_SESSION_RESUMPTION)
+  // save the (new) session
+  esp_tls_lwmqtt_session_save(network, host, port);
+#endif
+
+  ESP_LOGD(ESP_TLS_LWMQTT_LOG_TAG,
+           "esp_tls_lwmqtt_network_connect: %s handshake %u us (connect %u, setup %u, hello %u, certificate %u, "
+           "key exchange %u, finished %u)",
+           timing->resumed ? "resumed" : "full", timing->handshake_us, timing->connect_us, timing->setup_us,
+           timing->hello_us, timing->certificate_us, timing->key_exchange_us, timing->finished_us);
+
   return LWMQTT_SUCCESS;
 }
 
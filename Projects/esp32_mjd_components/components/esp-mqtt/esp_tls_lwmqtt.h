@@ -12,6 +12,32 @@
 #include <mbedtls/ssl.h>
 #include <sdkconfig.h>
 
+/**
+ * The duration of the phases of the last connection.
+ *
+ * A resumed handshake skips the certificate and the key exchange phases.
+ */
+typedef struct {
+  uint32_t connect_us;       // dns lookup and tcp connect
+  uint32_t setup_us;         // rng seed, ca certificate parsing and configuration
+  uint32_t hello_us;         // client hello and server hello (1 round trip)
+  uint32_t certificate_us;   // server certificate parsing and chain verification
+  uint32_t key_exchange_us;  // server key exchange signature check and client key exchange (ecdh)
+  uint32_t finished_us;      // change cipher spec, session ticket and finished messages
+  uint32_t handshake_us;     // all handshake phases
+  bool resumed;
+} esp_tls_lwmqtt_timing_t;
+
+/**
+ * The handshake statistics.
+ */
+typedef struct {
+  esp_tls_lwmqtt_timing_t last;
+  uint32_t full_handshakes;
+  uint32_t resumed_handshakes;
+  uint32_t failed_handshakes;
+} esp_tls_lwmqtt_stats_t;
+
 /**
  * The tls lwmqtt network object for the esp platform.
  */
@@ -25,10 +51,14 @@ typedef struct {
   uint8_t *ca_buf;
   size_t ca_len;
   bool verify;
+  esp_tls_lwmqtt_stats_t stats;
 } esp_tls_lwmqtt_network_t;
 
 /**
  * Initiate a connection to the specified remote host.
+ *
+ * With CONFIG_ESP_MQTT_TLS_SESSION_RESUMPTION the last session with the same host and port is resumed (session ticket or
+ * session id) and the new session is saved in RTC memory, so it survives a deep sleep.
  */
 lwmqtt_err_t esp_tls_lwmqtt_network_connect(esp_tls_lwmqtt_network_t *network, char *host, char *port);
 
@@ -0,0 +1,70 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "esp_tls_lwmqtt_session.h"
+
+#define ESP_TLS_LWMQTT_SESSION_MAGIC 0x544c5331  // "TLS1"
+
+static uint32_t esp_tls_lwmqtt_session_fnv1a(uint32_t hash, const uint8_t *buf, size_t len) {
+  // FNV-1a 32 bit
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ buf[i]) * 16777619u;
+  }
+
+  return hash;
+}
+
+static uint32_t esp_tls_lwmqtt_session_host_hash(const char *host, const char *port) {
+  // hash "host:port"
+  uint32_t hash = esp_tls_lwmqtt_session_fnv1a(2166136261u, (const uint8_t *)host, strlen(host));
+  hash = esp_tls_lwmqtt_session_fnv1a(hash, (const uint8_t *)":", 1);
+  return esp_tls_lwmqtt_session_fnv1a(hash, (const uint8_t *)port, strlen(port));
+}
+
+static uint32_t esp_tls_lwmqtt_session_checksum(const esp_tls_lwmqtt_session_t *session) {
+  // everything after the checksum field (the unused part of the ticket buffer is excluded)
+  const uint8_t *start = (const uint8_t *)&session->host_hash;
+  size_t len = offsetof(esp_tls_lwmqtt_session_t, ticket) - offsetof(esp_tls_lwmqtt_session_t, host_hash);
+  size_t ticket_len = session->ticket_len;
+  if (ticket_len > ESP_TLS_LWMQTT_SESSION_TICKET_MAX_LEN) {
+    ticket_len = ESP_TLS_LWMQTT_SESSION_TICKET_MAX_LEN;
+  }
+
+  uint32_t hash = esp_tls_lwmqtt_session_fnv1a(2166136261u, start, len);
+  return esp_tls_lwmqtt_session_fnv1a(hash, session->ticket, ticket_len);
+}
+
+void esp_tls_lwmqtt_session_seal(esp_tls_lwmqtt_session_t *session, const char *host, const char *port, int64_t now) {
+  // bind record
+  session->host_hash = esp_tls_lwmqtt_session_host_hash(host, port);
+  session->saved_at = now;
+
+  // seal record
+  session->checksum = esp_tls_lwmqtt_session_checksum(session);
+  session->magic = ESP_TLS_LWMQTT_SESSION_MAGIC;
+}
+
+bool esp_tls_lwmqtt_session_usable(const esp_tls_lwmqtt_session_t *session, const char *host, const char *port,
+                                   int64_t now, uint32_t max_age) {
+  // check seal
+  if (session->magic != ESP_TLS_LWMQTT_SESSION_MAGIC || session->ticket_len > ESP_TLS_LWMQTT_SESSION_TICKET_MAX_LEN ||
+      session->id_len > sizeof(session->id) || session->checksum != esp_tls_lwmqtt_session_checksum(session)) {
+    return false;
+  }
+
+  // check broker
+  if (session->host_hash != esp_tls_lwmqtt_session_host_hash(host, port)) {
+    return false;
+  }
+
+  // check age (the clock may have been set backwards)
+  if (session->lifetime > 0 && session->lifetime < max_age) {
+    max_age = session->lifetime;
+  }
+  return now >= session->saved_at && now - session->saved_at < (int64_t)max_age;
+}
+
+void esp_tls_lwmqtt_session_clear(esp_tls_lwmqtt_session_t *session) {
+  // wipe the master secret too
+  memset(session, 0, sizeof(esp_tls_lwmqtt_session_t));
+}
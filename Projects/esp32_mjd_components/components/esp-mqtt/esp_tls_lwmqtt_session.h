@@ -0,0 +1,63 @@
+#ifndef ESP_TLS_LWMQTT_SESSION_H
+#define ESP_TLS_LWMQTT_SESSION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(CONFIG_ESP_MQTT_TLS_SESSION_TICKET_MAX_LEN)
+#define ESP_TLS_LWMQTT_SESSION_TICKET_MAX_LEN CONFIG_ESP_MQTT_TLS_SESSION_TICKET_MAX_LEN
+#else
+#define ESP_TLS_LWMQTT_SESSION_TICKET_MAX_LEN 256
+#endif
+
+/**
+ * A TLS session that can be resumed, in a self-contained record (no pointers) so it can live in RTC memory and survive a
+ * deep sleep. It holds the session id, the master secret and the session ticket of the server.
+ *
+ * The record is bound to the host and port and sealed with a checksum: a record of another broker, an expired or a
+ * half-written record is never used.
+ */
+typedef struct {
+  uint32_t magic;
+  uint32_t checksum;
+  uint32_t host_hash;
+  int64_t saved_at;   // seconds (wall clock)
+  uint32_t lifetime;  // seconds (the ticket lifetime hint, 0 = none)
+
+  // session
+  int32_t ciphersuite;
+  int32_t compression;
+  uint32_t verify_result;
+  uint8_t id_len;
+  uint8_t id[32];
+  uint8_t master[48];
+  uint8_t mfl_code;
+  uint8_t trunc_hmac;
+  uint8_t encrypt_then_mac;
+  uint16_t ticket_len;
+  uint8_t ticket[ESP_TLS_LWMQTT_SESSION_TICKET_MAX_LEN];
+} esp_tls_lwmqtt_session_t;
+
+/**
+ * Bind the filled in record to the host and port and seal it.
+ *
+ * @param now - The current time in seconds.
+ */
+void esp_tls_lwmqtt_session_seal(esp_tls_lwmqtt_session_t *session, const char *host, const char *port, int64_t now);
+
+/**
+ * Check whether the record can be used to resume a session with the host and port.
+ *
+ * @param now - The current time in seconds.
+ * @param max_age - The max age of the session in seconds (the lifetime hint of the ticket may be shorter).
+ * @return Whether the record is sealed, of the same host and port and not expired.
+ */
+bool esp_tls_lwmqtt_session_usable(const esp_tls_lwmqtt_session_t *session, const char *host, const char *port,
+                                   int64_t now, uint32_t max_age);
+
+/**
+ * Invalidate the record.
+ */
+void esp_tls_lwmqtt_session_clear(esp_tls_lwmqtt_session_t *session);
+
+#endif  // ESP_TLS_LWMQTT_SESSION_H
@@ -7,6 +7,7 @@
 #include <float.h>
 #include <inttypes.h>
 #include <limits.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -22,6 +23,7 @@
 // This header file is generated by 'make menuconfig' and derived from the config file 'sdkconfig'
 #include "sdkconfig.h"
 
+#include "esp_attr.h"
 #include "esp_event_loop.h"
 #include "esp_clk.h"
 #include "esp_log.h"
@@ -114,9 +116,71 @@ esp_err_t mjd_word_to_binary_string(uint16_t input_word, char * output_string);
  */
 bool mjd_string_starts_with(const char *str, const char *pre);
 bool mjd_string_ends_with(const char *str, const char *post);
-char * mjd_string_repeat(const char * s, int n);
+char * mjd_string_repeat(const char * s, int n); // @important Returns a malloc'd string (the caller must free() it). Use mjd_strbuf_repeat() in loops.
 void mjd_string_prepend(char* param_ptr_string, const char* param_ptr_part);
 
+/**********
+ * NUMBER FORMATTERS (no printf)
+ *
+ * @doc Write the decimal representation + a NULL terminator into param_ptr_output and return the number of chars (excl. the NULL terminator).
+ *      The output buffer must be at least MJD_NUMBER_STRING_MAX_SIZE bytes.
+ * @doc mjd_float_to_fixed_string() is fixed-point: it does not use newlib's float printf path (which is large and slow on the ESP32).
+ *      Supported range: |value| < 4294967040 (uint32_t integer part), max MJD_FLOAT_STRING_MAX_DECIMALS decimals. Out of range => "ovf".
+ *      Rounds half up (printf rounds an exact tie such as 0.125 to even).
+ *
+ * @example mjd_float_to_fixed_string(-3.14159, 2, buf) => "-3.14" (returns 5)
+ */
+#define MJD_NUMBER_STRING_MAX_SIZE   (24)
+#define MJD_FLOAT_STRING_MAX_DECIMALS (6)
+
+size_t mjd_uint32_to_string(uint32_t param_value, char * param_ptr_output);
+size_t mjd_int32_to_string(int32_t param_value, char * param_ptr_output);
+size_t mjd_float_to_fixed_string(float param_value, uint32_t param_decimals, char * param_ptr_output);
+
+/**********
+ * STRING BUILDER (mjd_strbuf)
+ *
+ * @doc A bounded string builder on caller-provided storage (a stack array, a static buffer or a pooled block). It never calls malloc().
+ *      The string is always NULL terminated. The length is tracked so appends do not strlen() the whole string again.
+ * @doc When an operation does not fit then the output is truncated at the capacity, is_truncated is set (sticky until the next reset)
+ *      and the function returns ESP_ERR_INVALID_SIZE.
+ *
+ * @example
+ *      char storage[32];
+ *      mjd_strbuf_t strbuf;
+ *      mjd_strbuf_init(&strbuf, storage, sizeof(storage));
+ *      mjd_strbuf_append(&strbuf, "#");
+ *      mjd_strbuf_append_uint(&strbuf, 12, 0);
+ *      mjd_strbuf_append(&strbuf, " ");
+ *      mjd_strbuf_append_float(&strbuf, 23.456, 6, 2);   // "%6.2f" => "#12  23.46"
+ *      mjd_ssd1306_cmd_write_line(&ssd1306_config, MJD_SSD1306_LINE_NR_1, mjd_strbuf_c_str(&strbuf));
+ */
+typedef struct {
+    char * ptr_buffer;  /*!< Caller-provided storage */
+    size_t size;        /*!< Size of the storage in bytes (incl. the NULL terminator) */
+    size_t len;         /*!< Current string length (excl. the NULL terminator) */
+    bool is_truncated;  /*!< An operation did not fit since the last reset */
+} mjd_strbuf_t;
+
+esp_err_t mjd_strbuf_init(mjd_strbuf_t* param_ptr_strbuf, char * param_ptr_storage, size_t param_size);
+void mjd_strbuf_reset(mjd_strbuf_t* param_ptr_strbuf);
+esp_err_t mjd_strbuf_append(mjd_strbuf_t* param_ptr_strbuf, const char * param_ptr_string);
+esp_err_t mjd_strbuf_append_n(mjd_strbuf_t* param_ptr_strbuf, const char * param_ptr_chars, size_t param_len);
+esp_err_t mjd_strbuf_append_char(mjd_strbuf_t* param_ptr_strbuf, char param_char);
+esp_err_t mjd_strbuf_prepend(mjd_strbuf_t* param_ptr_strbuf, const char * param_ptr_string);
+esp_err_t mjd_strbuf_repeat(mjd_strbuf_t* param_ptr_strbuf, const char * param_ptr_string, uint32_t param_count);
+esp_err_t mjd_strbuf_append_uint(mjd_strbuf_t* param_ptr_strbuf, uint32_t param_value, uint32_t param_min_width);
+esp_err_t mjd_strbuf_append_int(mjd_strbuf_t* param_ptr_strbuf, int32_t param_value, uint32_t param_min_width);
+esp_err_t mjd_strbuf_append_float(mjd_strbuf_t* param_ptr_strbuf, float param_value, uint32_t param_min_width, uint32_t param_decimals);
+
+static inline const char * mjd_strbuf_c_str(const mjd_strbuf_t* param_ptr_strbuf) {
+    return param_ptr_strbuf->ptr_buffer;
+}
+
+static inline size_t mjd_strbuf_len(const mjd_strbuf_t* param_ptr_strbuf) {
+    return param_ptr_strbuf->len;
+}
+
 /**********
  * HEX STRINGS
  */
@@ -129,7 +193,8 @@ esp_err_t mjd_uint8s_to_hexstring(const uint8_t * param_ptr_input, size_t param_
 
 /*
  * @example "00010E0FF0F1FEFF" = [0 0x00, 1 0x01, 14 0x0e, 15 0x0f, 240 0xf0, 241 0xf1, 254 0xfe, 255 0xff] => "00010E0FF0F1FEFF"
- * @dep param_ptr_output must point to an array of uint8 at least HALF the size of the param_ptr_input buffer PLUS 1
+ * @dep param_ptr_output must point to an array of uint8 at least HALF the size of the param_ptr_input buffer
+ * @return ESP_ERR_INVALID_SIZE for an uneven number of characters, ESP_ERR_INVALID_ARG for a non-hex character (upper and lower case are accepted)
  */
 esp_err_t mjd_hexstring_to_uint8s(const char * param_ptr_input, size_t param_len_input, uint8_t * param_ptr_output);
 
@@ -141,10 +206,17 @@ esp_err_t mjd_string_to_hexstring(const char * param_ptr_input, size_t param_len
 
 /*
  * @example "414243" => "ABC"
- * @dep param_ptr_output must point to an array of chars at least HALF the size of the param_ptr_input buffer PLUS 1
+ * @dep param_ptr_output must point to an array of at least (param_len_input / 2) + 1 chars
+ * @important The NULL terminator is written at param_ptr_output[param_len_input / 2]
  */
 esp_err_t mjd_hexstring_to_string(const char * param_ptr_input, size_t param_len_input, char * param_ptr_output);
 
+/*
+ * @brief Streaming variant of mjd_uint8s_to_hexstring(): writes the hex chars directly to the UART (no NULL terminator, no output buffer)
+ * @example [0x41, 0x42] => uart_write_bytes("4142")
+ */
+esp_err_t mjd_uint8s_to_hexstring_uart(uart_port_t param_uart_num, const uint8_t * param_ptr_input, size_t param_len_input);
+
 /**********
  * CRYPTO
  */
@@ -243,6 +315,96 @@ void mjd_log_mcu_boot_count();
 uint32_t mjd_get_mcu_boot_count();
 void mjd_log_wakeup_details();
 
+/**********
+ * ESP32: RTC MEMORY SAMPLE RING (deep sleep batching)
+ *
+ * @doc A ring of fixed-size records in RTC slow memory. It survives a deep sleep (not a power cycle, a reset or a flash), so a node can
+ *      take a measurement at each wakeup and send a batch of them in 1 uplink: the WiFi connect costs far more energy than a measurement.
+ * @doc The header is protected by a CRC32 and carries the layout version of the app's record. mjd_rtc_ring_init() starts an empty ring
+ *      after a cold boot, when the CRC is wrong, or when the version, the record size or the capacity changed (a new firmware).
+ * @doc When the ring is full the oldest record is overwritten (nbr_of_dropped).
+ * @doc The timestamps are seconds of a clock that runs during the deep sleep, e.g. time(NULL): the RTC keeps the system time.
+ *      esp_timer_get_time() restarts at 0 after each wakeup.
+ *
+ * @example
+ *      MJD_RTC_RING_DEFINE_STORAGE(_samples_storage, sizeof(my_sample_t), 32);
+ *      mjd_rtc_ring_t *ptr_ring = (mjd_rtc_ring_t *) _samples_storage;
+ *      mjd_rtc_ring_init(ptr_ring, sizeof(my_sample_t), 32, MY_SAMPLE_VERSION, NULL);
+ *      mjd_rtc_ring_push(ptr_ring, time(NULL), &sample);
+ *      if (mjd_rtc_ring_evaluate_policy(ptr_ring, &policy, time(NULL), sample.temperature) != MJD_RTC_UPLINK_NOT_NEEDED) {
+ *          ... start WiFi, read the records with mjd_rtc_ring_peek(), publish them ...
+ *          mjd_rtc_ring_uplink_done(ptr_ring, nbr_of_records_sent, sample.temperature, time(NULL));
+ *      }
+ *      esp_deep_sleep_start();
+ */
+#define MJD_RTC_RING_MAGIC (0x474E5252) /*!< "RRNG" */
+
+#define MJD_RTC_RING_FLAG_HAS_REFERENCE (0x0001) /*!< reference_value is set (there was an uplink) */
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;                   /*!< The layout version of the app's record */
+    uint16_t record_size;
+    uint16_t nbr_of_records;            /*!< Capacity */
+    uint16_t head;                      /*!< The slot of the oldest record */
+    uint16_t count;
+    uint16_t flags;
+    uint32_t nbr_of_pushed;             /*!< Since the ring was created */
+    uint32_t nbr_of_dropped;            /*!< Overwritten before they were sent */
+    uint32_t nbr_of_uplinks;
+    uint32_t last_uplink_timestamp_s;
+    float reference_value;              /*!< The value at the last uplink (the value-change policy) */
+    uint32_t crc32;                     /*!< crc32_le() of the fields above */
+} mjd_rtc_ring_t;
+
+/*
+ * @doc A slot is the timestamp + the record, padded to 4 bytes (RTC slow memory is accessed per 32-bit word).
+ */
+#define MJD_RTC_RING_SLOT_SIZE(record_size) (sizeof(uint32_t) + (((record_size) + 3) & ~((size_t) 3)))
+
+#define MJD_RTC_RING_STORAGE_SIZE(record_size, nbr_of_records) \
+    (sizeof(mjd_rtc_ring_t) + MJD_RTC_RING_SLOT_SIZE(record_size) * (nbr_of_records))
+
+#define MJD_RTC_RING_DEFINE_STORAGE(name, record_size, nbr_of_records) \
+    static RTC_DATA_ATTR uint32_t name[MJD_RTC_RING_STORAGE_SIZE(record_size, nbr_of_records) / sizeof(uint32_t)]
+
+/*
+ * @doc The thresholds that decide when to turn on the radio. A threshold of 0 is disabled.
+ */
+typedef struct {
+    uint32_t max_records;               /*!< Uplink when this many records are buffered */
+    uint32_t max_age_s;                 /*!< Uplink when the oldest record is this old */
+    float value_change_threshold;       /*!< Uplink when |value - the value at the last uplink| >= this (and when there was no uplink yet) */
+} mjd_rtc_uplink_policy_t;
+
+#define MJD_RTC_UPLINK_POLICY_DEFAULT() { \
+    .max_records = 12, \
+    .max_age_s = 3600, \
+    .value_change_threshold = 0, \
+}
+
+typedef enum {
+    MJD_RTC_UPLINK_NOT_NEEDED = 0,
+    MJD_RTC_UPLINK_RING_FULL,           /*!< The next push overwrites the oldest record */
+    MJD_RTC_UPLINK_COUNT,
+    MJD_RTC_UPLINK_AGE,
+    MJD_RTC_UPLINK_VALUE_CHANGE,
+} mjd_rtc_uplink_reason_t;
+
+esp_err_t mjd_rtc_ring_init(mjd_rtc_ring_t* param_ptr_ring, uint32_t param_record_size, uint32_t param_nbr_of_records,
+                            uint16_t param_version, bool * param_ptr_is_restored);
+esp_err_t mjd_rtc_ring_clear(mjd_rtc_ring_t* param_ptr_ring);
+esp_err_t mjd_rtc_ring_push(mjd_rtc_ring_t* param_ptr_ring, uint32_t param_timestamp_s, const void * param_ptr_record);
+esp_err_t mjd_rtc_ring_peek(const mjd_rtc_ring_t* param_ptr_ring, uint32_t param_idx, void * param_ptr_record,
+                            uint32_t * param_ptr_timestamp_s);
+uint32_t mjd_rtc_ring_count(const mjd_rtc_ring_t* param_ptr_ring);
+mjd_rtc_uplink_reason_t mjd_rtc_ring_evaluate_policy(const mjd_rtc_ring_t* param_ptr_ring, const mjd_rtc_uplink_policy_t* param_ptr_policy,
+                                                     uint32_t param_now_s, float param_value);
+esp_err_t mjd_rtc_ring_uplink_done(mjd_rtc_ring_t* param_ptr_ring, uint32_t param_nbr_of_records, float param_reference_value,
+                                   uint32_t param_now_s);
+const char * mjd_rtc_uplink_reason_to_name(mjd_rtc_uplink_reason_t param_reason);
+void mjd_rtc_ring_log(const mjd_rtc_ring_t* param_ptr_ring);
+
 /**********
  * ESP32 cJSON
  */
@@ -6,6 +6,7 @@
 // Component header file(s)
 #include "mjd.h"
 #include "mjd_ads1115.h"
+#include "mjd_trace.h"
 
 /*
  * Logging
@@ -151,7 +152,9 @@ static esp_err_t _read_register(const mjd_ads1115_config_t* param_ptr_config, mj
         goto cleanup;
     }
 
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_I2C_TRANSACTION);
     f_retval = i2c_master_cmd_begin(param_ptr_config->i2c_port_num, handle, param_ptr_config->i2c_timeout);
+    MJD_TRACE_END(MJD_TRACE_PROBE_I2C_TRANSACTION);
     if (f_retval != ESP_OK) {
         ESP_LOGE(TAG, "%s(). ABORT. Receive response i2c_master_cmd_begin() err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
         i2c_cmd_link_delete(handle);
@@ -233,7 +236,9 @@ static esp_err_t _write_register(const mjd_ads1115_config_t* param_ptr_config, m
         goto cleanup;
     }
 
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_I2C_TRANSACTION);
     f_retval = i2c_master_cmd_begin(param_ptr_config->i2c_port_num, handle, param_ptr_config->i2c_timeout);
+    MJD_TRACE_END(MJD_TRACE_PROBE_I2C_TRANSACTION);
     if (f_retval != ESP_OK) {
         ESP_LOGE(TAG, "%s(). ABORT. Receive response i2c_master_cmd_begin() err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
         i2c_cmd_link_delete(handle);
@@ -20,4 +20,6 @@ COMPONENT_PRIV_INCLUDEDIRS :=
 #	By default, the integer version is used in the API!
 #	==> If the user needs the floating point version, the user has to uncomment the macro BME280_FLOAT_ENABLE in file bme280_defs.h 
 #	    or add that DEFINE to the compiler flags (CFLAGS).
+#	==> mjd_bme280 keeps the floating point version of the Bosch driver (MJD_BME280_COMPENSATION_FLOAT)
+#	    and implements the integer versions itself (MJD_BME280_COMPENSATION_INT32 | MJD_BME280_COMPENSATION_INT64) so the mode can be selected at runtime.
 CFLAGS += -DBME280_FLOAT_ENABLE
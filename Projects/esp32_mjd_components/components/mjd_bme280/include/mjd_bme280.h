@@ -27,13 +27,60 @@ extern "C" {
 /**
  * Data structs
  */
+
+/*
+ * @doc Compensation modes: how the raw ADC values are converted to meteo values (BME280 data sheet chapter 4.2.3 and appendix 8).
+ *  MJD_BME280_COMPENSATION_FLOAT: double precision floating point (Bosch driver). The ESP32 FPU is single precision: doubles are emulated in software.
+ *  MJD_BME280_COMPENSATION_INT32: 32-bit integers only. Pressure resolution 1 Pa.
+ *  MJD_BME280_COMPENSATION_INT64: 32-bit integers + 64-bit integers for the pressure. Pressure resolution 0.01 Pa. The recommended integer mode.
+ */
+typedef enum {
+    MJD_BME280_COMPENSATION_FLOAT = 0,
+    MJD_BME280_COMPENSATION_INT32,
+    MJD_BME280_COMPENSATION_INT64,
+    MJD_BME280_COMPENSATION_MAX,
+} mjd_bme280_compensation_t;
+
+/*
+ * NORMAL MODE (continuous sampling)
+ *
+ * @doc In normal mode the sensor cycles by itself between a measurement and a standby period (data sheet chapter 3.3.4).
+ *      Output data rate = 1 / (measurement time + standby time). The IIR filter (register 0xF5) suppresses short disturbances
+ *      such as a slamming door or wind blowing into the sensor (data sheet chapter 3.4.4).
+ * @doc The sampling task reads the 8 data registers 0xF7..0xFE in ONE I2C burst read per sample: the sensor locks the data registers
+ *      during a burst read so pressure, temperature and humidity always belong to the same measurement (data sheet chapter 4).
+ * @doc The samples are stored in a FreeRTOS queue (the sample ring buffer). The newest sample is dropped when the queue is full.
+ */
+#define MJD_BME280_SAMPLING_DEFAULT_QUEUE_LENGTH (16)
+
+typedef struct {
+    uint32_t nbr_of_samples; /*!< The number of successful burst reads (queued + dropped) */
+    uint32_t nbr_of_read_errors; /*!< The number of failed burst reads (I2C errors) */
+    uint32_t nbr_of_dropped_samples; /*!< The sample queue was full: the consumer does not keep up */
+    uint32_t expected_period_us; /*!< The max measurement time + the standby time */
+    uint32_t min_interval_us; /*!< The smallest interval between 2 consecutive samples */
+    uint32_t max_interval_us; /*!< The largest interval between 2 consecutive samples */
+    float achieved_rate_hz; /*!< (nbr_of_samples - 1) / (timestamp last sample - timestamp first sample) */
+} mjd_bme280_sampling_stats_t;
+
 typedef struct {
     bool manage_i2c_driver;
     i2c_port_t i2c_port_num;
     uint8_t i2c_slave_addr;
     gpio_num_t i2c_scl_gpio_num;
     gpio_num_t i2c_sda_gpio_num;
+    mjd_bme280_compensation_t compensation;
     struct bme280_dev bme280_device;
+    struct bme280_settings normal_mode_settings; /*!< Normal mode: osr_p, osr_t, osr_h, filter, standby_time */
+    uint32_t sampling_queue_length; /*!< Normal mode: the number of samples that the sample queue can hold */
+    volatile bool is_sampling; /*!< Private: normal mode sampling is active (cleared by the sampling task when it exits) */
+    volatile bool is_sampling_stop_requested; /*!< Private */
+    TaskHandle_t sampling_task_handle; /*!< Private */
+    QueueHandle_t sampling_queue_handle; /*!< Private */
+    uint32_t sampling_sample_nbr; /*!< Private */
+    int64_t sampling_first_time_us; /*!< Private */
+    int64_t sampling_last_time_us; /*!< Private */
+    mjd_bme280_sampling_stats_t sampling_stats; /*!< Private: use mjd_bme280_get_sampling_stats() */
 } mjd_bme280_config_t;
 
 /*
@@ -59,26 +106,85 @@ typedef struct {
  *  #define BME280_FILTER_COEFF_8                 (0x03)
  *  #define BME280_FILTER_COEFF_16                (0x04)
  *
- *  TODO Standby time???
+ * @doc Standby time macros (normal mode only)
+ *  #define BME280_STANDBY_TIME_1_MS              (0x00)  0.5 ms
+ *  #define BME280_STANDBY_TIME_62_5_MS           (0x01)
+ *  #define BME280_STANDBY_TIME_125_MS            (0x02)
+ *  #define BME280_STANDBY_TIME_250_MS            (0x03)
+ *  #define BME280_STANDBY_TIME_500_MS            (0x04)
+ *  #define BME280_STANDBY_TIME_1000_MS           (0x05)
+ *  #define BME280_STANDBY_TIME_10_MS             (0x06)
+ *  #define BME280_STANDBY_TIME_20_MS             (0x07)
+ *
+ * @doc The default normal mode settings are the "indoor navigation" settings of the data sheet chapter 3.5.3 with a slower
+ *      standby time: osr_p x4 (not x16), osr_t x1, osr_h x1, IIR filter 4, standby 62.5 ms => 78.7 ms (12.7 Hz).
  */
 #define MJD_BME280_CONFIG_DEFAULT() { \
     .manage_i2c_driver = true,  \
     .i2c_port_num = I2C_NUM_0,  \
-    .i2c_slave_addr = 0x76  \
+    .i2c_slave_addr = 0x76,  \
+    .compensation = MJD_BME280_COMPENSATION_FLOAT,  \
+    .normal_mode_settings = { \
+        .osr_p = BME280_OVERSAMPLING_4X,  \
+        .osr_t = BME280_OVERSAMPLING_1X,  \
+        .osr_h = BME280_OVERSAMPLING_1X,  \
+        .filter = BME280_FILTER_COEFF_4,  \
+        .standby_time = BME280_STANDBY_TIME_62_5_MS  \
+    },  \
+    .sampling_queue_length = MJD_BME280_SAMPLING_DEFAULT_QUEUE_LENGTH  \
 };
 
+/*
+ * @doc The fixed-point fields are set in all compensation modes.
+ * @important The double fields are only set in MJD_BME280_COMPENSATION_FLOAT (the integer modes do not use any floating point code).
+ */
 typedef struct {
     double humidity_percent;
     double pressure_hpascal;
     double temperature_celsius;
+    uint32_t humidity_percent_q10;      /*!< Unit 1/1024 %RH. 47445 = 46.333 %RH */
+    uint32_t pressure_centipascal;      /*!< Unit 0.01 Pa. 9638620 = 96386.20 Pa = 963.8620 hPa */
+    int32_t temperature_centicelsius;   /*!< Unit 0.01 degree Celsius. 5123 = 51.23 C */
 } mjd_bme280_data_t;
 
+/*
+ * NORMAL MODE: 1 sample = 1 burst read
+ */
+typedef struct {
+    int64_t timestamp_us; /*!< esp_timer_get_time() right after the burst read */
+    uint32_t sample_nbr; /*!< 1, 2, 3... A gap in the numbers = samples that were dropped because the queue was full */
+    mjd_bme280_data_t data;
+} mjd_bme280_sample_t;
+
 /**
  * Function declarations
  */
 esp_err_t mjd_bme280_init(mjd_bme280_config_t* ptr_param_config);
 esp_err_t mjd_bme280_deinit(mjd_bme280_config_t* ptr_param_config);
 esp_err_t mjd_bme280_read_forced(mjd_bme280_config_t* ptr_param_config, mjd_bme280_data_t* ptr_param_data);
+esp_err_t mjd_bme280_compensate(mjd_bme280_compensation_t param_compensation, struct bme280_calib_data* ptr_param_calib_data,
+                                const struct bme280_uncomp_data* ptr_param_uncomp_data, mjd_bme280_data_t* ptr_param_data);
+
+/*
+ * NORMAL MODE (continuous sampling)
+ *
+ * @brief mjd_bme280_start_sampling() writes config.normal_mode_settings, puts the sensor in normal mode and starts a task on the APP CPU
+ *        that reads 1 sample per period. Receive the samples with mjd_bme280_receive_sample().
+ *
+ * @important mjd_bme280_read_forced() is not allowed while sampling is active.
+ */
+uint32_t mjd_bme280_get_normal_mode_period_us(const struct bme280_settings* ptr_param_settings);
+esp_err_t mjd_bme280_start_sampling(mjd_bme280_config_t* ptr_param_config);
+esp_err_t mjd_bme280_stop_sampling(mjd_bme280_config_t* ptr_param_config);
+
+/*
+ * @brief 1 sample: 1 burst read of the data registers, compensate, timestamp, queue.
+ *        The sampling task calls it once per period; an app without the sampling task (or a unit test) can call it directly.
+ */
+esp_err_t mjd_bme280_sampling_read_burst(mjd_bme280_config_t* ptr_param_config);
+esp_err_t mjd_bme280_receive_sample(mjd_bme280_config_t* ptr_param_config, mjd_bme280_sample_t* ptr_param_sample,
+                                    TickType_t param_ticks_to_wait);
+esp_err_t mjd_bme280_get_sampling_stats(mjd_bme280_config_t* ptr_param_config, mjd_bme280_sampling_stats_t* ptr_param_stats);
 
 #ifdef __cplusplus
 }
@@ -3,15 +3,26 @@
  *
  */
 
+#include "esp_timer.h"
+
 // Component header file(s)
 #include "mjd.h"
 #include "mjd_bme280.h"
+#include "mjd_trace.h"
 
 /*
  * Logging
  */
 static const char TAG[] = "mjd_bme280";
 
+/*
+ * NORMAL MODE: the sampling task
+ */
+#define MJD_BME280_SAMPLING_TASK_STACK_SIZE (3072)
+#define MJD_BME280_SAMPLING_TASK_PRIORITY   (RTOS_TASK_PRIORITY_NORMAL)
+
+static portMUX_TYPE bme280_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
 /*********************************************************************************
  * Bosch driver interface functions
  */
@@ -79,7 +90,9 @@ int8_t BME280_I2C_read(uint8_t dev_id, uint8_t reg_addr, uint8_t *reg_data, uint
     i2c_master_read_byte(cmd, reg_data + len - 1, I2C_MASTER_NACK);
     i2c_master_stop(cmd);
 
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_I2C_TRANSACTION);
     esp_retval = i2c_master_cmd_begin(bme280_current_i2c_port, cmd, RTOS_DELAY_100MILLISEC);
+    MJD_TRACE_END(MJD_TRACE_PROBE_I2C_TRANSACTION);
     if (esp_retval == ESP_OK) {
         f_retval = BME280_OK;  // = defined in the Bosch driver
     } else {
@@ -138,7 +151,9 @@ int8_t BME280_I2C_write(uint8_t dev_id, uint8_t reg_addr, uint8_t *reg_data, uin
     i2c_master_write_byte(cmd, reg_addr, true);
     i2c_master_write(cmd, reg_data, len, true);
     i2c_master_stop(cmd);
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_I2C_TRANSACTION);
     esp_retval = i2c_master_cmd_begin(bme280_current_i2c_port, cmd, RTOS_DELAY_100MILLISEC);
+    MJD_TRACE_END(MJD_TRACE_PROBE_I2C_TRANSACTION);
     if (esp_retval == ESP_OK) {
         f_retval = BME280_OK;  // = defined in the Bosch driver
     } else {
@@ -156,6 +171,154 @@ int8_t BME280_I2C_write(uint8_t dev_id, uint8_t reg_addr, uint8_t *reg_data, uin
     return (int8_t) f_retval;
 }
 
+/*********************************************************************************
+ * Integer compensation (BME280 data sheet chapter 4.2.3 + appendix 8.2)
+ *
+ * @doc The Bosch driver is compiled with BME280_FLOAT_ENABLE so its integer compensation functions are not available.
+ *      These are the same fixed-point formulas (the integer version of the Bosch driver bme280.c).
+ * @doc t_fine carries the fine temperature to the pressure and humidity compensation.
+ */
+
+/*
+ * Unit 0.01 degree Celsius. Range -4000..8500.
+ */
+static int32_t _compensate_temperature_int32(const struct bme280_uncomp_data *ptr_param_uncomp_data,
+                                             struct bme280_calib_data *ptr_param_calib_data) {
+    int32_t var1;
+    int32_t var2;
+    int32_t temperature;
+
+    var1 = (int32_t) ((ptr_param_uncomp_data->temperature / 8) - ((int32_t) ptr_param_calib_data->dig_T1 * 2));
+    var1 = (var1 * ((int32_t) ptr_param_calib_data->dig_T2)) / 2048;
+    var2 = (int32_t) ((ptr_param_uncomp_data->temperature / 16) - ((int32_t) ptr_param_calib_data->dig_T1));
+    var2 = (((var2 * var2) / 4096) * ((int32_t) ptr_param_calib_data->dig_T3)) / 16384;
+    ptr_param_calib_data->t_fine = var1 + var2;
+    temperature = (ptr_param_calib_data->t_fine * 5 + 128) / 256;
+
+    if (temperature < -4000) {
+        temperature = -4000;
+    } else if (temperature > 8500) {
+        temperature = 8500;
+    }
+
+    return temperature;
+}
+
+/*
+ * Unit 1 Pa. Range 30000..110000.
+ */
+static uint32_t _compensate_pressure_int32(const struct bme280_uncomp_data *ptr_param_uncomp_data,
+                                           const struct bme280_calib_data *ptr_param_calib_data) {
+    int32_t var1;
+    int32_t var2;
+    int32_t var3;
+    int32_t var4;
+    uint32_t var5;
+    uint32_t pressure;
+
+    var1 = (((int32_t) ptr_param_calib_data->t_fine) / 2) - (int32_t) 64000;
+    var2 = (((var1 / 4) * (var1 / 4)) / 2048) * ((int32_t) ptr_param_calib_data->dig_P6);
+    var2 = var2 + ((var1 * ((int32_t) ptr_param_calib_data->dig_P5)) * 2);
+    var2 = (var2 / 4) + (((int32_t) ptr_param_calib_data->dig_P4) * 65536);
+    var3 = (ptr_param_calib_data->dig_P3 * (((var1 / 4) * (var1 / 4)) / 8192)) / 8;
+    var4 = (((int32_t) ptr_param_calib_data->dig_P2) * var1) / 2;
+    var1 = (var3 + var4) / 262144;
+    var1 = (((32768 + var1)) * ((int32_t) ptr_param_calib_data->dig_P1)) / 32768;
+    if (var1 == 0) {
+        return 30000; // Avoid a division by zero (invalid calibration data)
+    }
+
+    var5 = (uint32_t) ((uint32_t) 1048576) - ptr_param_uncomp_data->pressure;
+    pressure = ((uint32_t) (var5 - (uint32_t) (var2 / 4096))) * 3125;
+    if (pressure < 0x80000000) {
+        pressure = (pressure << 1) / ((uint32_t) var1);
+    } else {
+        pressure = (pressure / (uint32_t) var1) * 2;
+    }
+    var1 = (((int32_t) ptr_param_calib_data->dig_P9) * ((int32_t) (((pressure / 8) * (pressure / 8)) / 8192))) / 4096;
+    var2 = (((int32_t) (pressure / 4)) * ((int32_t) ptr_param_calib_data->dig_P8)) / 8192;
+    pressure = (uint32_t) ((int32_t) pressure + ((var1 + var2 + ptr_param_calib_data->dig_P7) / 16));
+
+    if (pressure < 30000) {
+        pressure = 30000;
+    } else if (pressure > 110000) {
+        pressure = 110000;
+    }
+
+    return pressure;
+}
+
+/*
+ * Unit 0.01 Pa. Range 3000000..11000000.
+ */
+static uint32_t _compensate_pressure_int64(const struct bme280_uncomp_data *ptr_param_uncomp_data,
+                                           const struct bme280_calib_data *ptr_param_calib_data) {
+    int64_t var1;
+    int64_t var2;
+    int64_t var4;
+    uint32_t pressure;
+
+    var1 = ((int64_t) ptr_param_calib_data->t_fine) - 128000;
+    var2 = var1 * var1 * (int64_t) ptr_param_calib_data->dig_P6;
+    var2 = var2 + ((var1 * (int64_t) ptr_param_calib_data->dig_P5) * 131072);
+    var2 = var2 + (((int64_t) ptr_param_calib_data->dig_P4) * 34359738368);
+    var1 = ((var1 * var1 * (int64_t) ptr_param_calib_data->dig_P3) / 256) + ((var1 * ((int64_t) ptr_param_calib_data->dig_P2) * 4096));
+    var1 = (((int64_t) 140737488355328) + var1) * ((int64_t) ptr_param_calib_data->dig_P1) / 8589934592;
+    if (var1 == 0) {
+        return 3000000; // Avoid a division by zero (invalid calibration data)
+    }
+
+    var4 = 1048576 - (int64_t) ptr_param_uncomp_data->pressure;
+    var4 = (((var4 * 2147483648) - var2) * 3125) / var1;
+    var1 = (((int64_t) ptr_param_calib_data->dig_P9) * (var4 / 8192) * (var4 / 8192)) / 33554432;
+    var2 = (((int64_t) ptr_param_calib_data->dig_P8) * var4) / 524288;
+    var4 = ((var4 + var1 + var2) / 256) + (((int64_t) ptr_param_calib_data->dig_P7) * 16);
+    pressure = (uint32_t) (((var4 / 2) * 100) / 128);
+
+    if (pressure < 3000000) {
+        pressure = 3000000;
+    } else if (pressure > 11000000) {
+        pressure = 11000000;
+    }
+
+    return pressure;
+}
+
+/*
+ * Unit 1/1024 %RH. Range 0..102400.
+ */
+static uint32_t _compensate_humidity_int32(const struct bme280_uncomp_data *ptr_param_uncomp_data,
+                                           const struct bme280_calib_data *ptr_param_calib_data) {
+    int32_t var1;
+    int32_t var2;
+    int32_t var3;
+    int32_t var4;
+    int32_t var5;
+    uint32_t humidity;
+
+    var1 = ptr_param_calib_data->t_fine - ((int32_t) 76800);
+    var2 = (int32_t) (ptr_param_uncomp_data->humidity * 16384);
+    var3 = (int32_t) (((int32_t) ptr_param_calib_data->dig_H4) * 1048576);
+    var4 = ((int32_t) ptr_param_calib_data->dig_H5) * var1;
+    var5 = (((var2 - var3) - var4) + (int32_t) 16384) / 32768;
+    var2 = (var1 * ((int32_t) ptr_param_calib_data->dig_H6)) / 1024;
+    var3 = (var1 * ((int32_t) ptr_param_calib_data->dig_H3)) / 2048;
+    var4 = ((var2 * (var3 + (int32_t) 32768)) / 1024) + (int32_t) 2097152;
+    var2 = ((var4 * ((int32_t) ptr_param_calib_data->dig_H2)) + 8192) / 16384;
+    var3 = var5 * var2;
+    var4 = ((var3 / 32768) * (var3 / 32768)) / 128;
+    var5 = var3 - ((var4 * ((int32_t) ptr_param_calib_data->dig_H1)) / 16);
+    var5 = (var5 < 0 ? 0 : var5);
+    var5 = (var5 > 419430400 ? 419430400 : var5);
+    humidity = (uint32_t) (var5 / 4096);
+
+    if (humidity > 102400) {
+        humidity = 102400;
+    }
+
+    return humidity;
+}
+
 /*********************************************************************************
  * PUBLIC.
  */
@@ -293,12 +456,22 @@ esp_err_t mjd_bme280_read_forced(mjd_bme280_config_t* ptr_param_config, mjd_bme2
     int32_t com_rslt;
     uint8_t sensor_mode = 255;
 
+    if (ptr_param_config->is_sampling == true) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. Normal mode sampling is active | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
     /*
      * Reset receive values
      */
     ptr_param_data->humidity_percent = 0.0;
     ptr_param_data->pressure_hpascal = 0.0;
     ptr_param_data->temperature_celsius = 0.0;
+    ptr_param_data->humidity_percent_q10 = 0;
+    ptr_param_data->pressure_centipascal = 0;
+    ptr_param_data->temperature_centicelsius = 0;
 
     /*
      * Pointer (reused in this func)
@@ -448,21 +621,28 @@ esp_err_t mjd_bme280_read_forced(mjd_bme280_config_t* ptr_param_config, mjd_bme2
      */
     ESP_LOGD(TAG, "do bme280_get_sensor_data()");
 
-    struct bme280_data compensated_data =
+    // @doc Same as bme280_get_sensor_data() but the compensation mode is selected at runtime.
+    uint8_t reg_data[BME280_P_T_H_DATA_LEN] =
+        { 0 }; // @important = { 0 }
+    struct bme280_uncomp_data uncomp_data =
         { 0 }; // @important = { 0 }
 
-    com_rslt = bme280_get_sensor_data(BME280_ALL, &compensated_data, ptr_bme280_device);
+    com_rslt = bme280_get_regs(BME280_DATA_ADDR, reg_data, BME280_P_T_H_DATA_LEN, ptr_bme280_device);
     if (com_rslt != BME280_OK) {
-        ESP_LOGE(TAG, "ABORT. bme280_get_sensor_data() failed - rr %i", com_rslt);
+        ESP_LOGE(TAG, "ABORT. bme280_get_regs(BME280_DATA_ADDR) failed - err %i", com_rslt);
         f_retval = ESP_FAIL;
         // LABEL
         goto cleanup;
     }
+    bme280_parse_sensor_data(reg_data, &uncomp_data);
 
-    // transfer received values to my data store
-    ptr_param_data->humidity_percent = compensated_data.humidity; // Percent
-    ptr_param_data->pressure_hpascal = compensated_data.pressure / 100; // Pascal => HPa
-    ptr_param_data->temperature_celsius = compensated_data.temperature; // Celsius
+    // compensate sensor values & transfer values to my data store
+    f_retval = mjd_bme280_compensate(ptr_param_config->compensation, &ptr_bme280_device->calib_data, &uncomp_data, ptr_param_data);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "ABORT. mjd_bme280_compensate() failed - err %i", f_retval);
+        // LABEL
+        goto cleanup;
+    }
 
     /*
      * DEBUG SENSOR MODE (after reading sensor data).
@@ -484,3 +664,379 @@ esp_err_t mjd_bme280_read_forced(mjd_bme280_config_t* ptr_param_config, mjd_bme2
 
     return f_retval;
 }
+
+/*********************************************************************************
+ * PUBLIC.
+ *
+ * @brief Compensate the raw ADC values of the sensor (temperature, pressure, humidity).
+ *
+ * @doc The calibration data is updated: t_fine (the fine temperature).
+ * @doc Max deviation of the integer modes versus MJD_BME280_COMPENSATION_FLOAT (host test, -20..+60 C): temperature 0.02 C,
+ *      pressure 6 Pa (INT32) | 0.05 Pa (INT64), humidity 0.01 %RH. The sensor accuracy is +-1 C, +-100 Pa, +-3 %RH.
+ */
+esp_err_t mjd_bme280_compensate(mjd_bme280_compensation_t param_compensation, struct bme280_calib_data* ptr_param_calib_data,
+                                const struct bme280_uncomp_data* ptr_param_uncomp_data, mjd_bme280_data_t* ptr_param_data) {
+    esp_err_t f_retval = ESP_OK;
+    struct bme280_data compensated_data =
+        { 0 }; // @important = { 0 }
+
+    if (ptr_param_calib_data == NULL || ptr_param_uncomp_data == NULL || ptr_param_data == NULL
+            || param_compensation >= MJD_BME280_COMPENSATION_MAX) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    switch (param_compensation) {
+    case MJD_BME280_COMPENSATION_FLOAT:
+        bme280_compensate_data(BME280_ALL, ptr_param_uncomp_data, &compensated_data, ptr_param_calib_data);
+        ptr_param_data->humidity_percent = compensated_data.humidity; // Percent
+        ptr_param_data->pressure_hpascal = compensated_data.pressure / 100; // Pascal => HPa
+        ptr_param_data->temperature_celsius = compensated_data.temperature; // Celsius
+        ptr_param_data->humidity_percent_q10 = (uint32_t) (compensated_data.humidity * 1024 + 0.5);
+        ptr_param_data->pressure_centipascal = (uint32_t) (compensated_data.pressure * 100 + 0.5);
+        ptr_param_data->temperature_centicelsius = (int32_t) lround(compensated_data.temperature * 100);
+        break;
+    case MJD_BME280_COMPENSATION_INT32:
+        ptr_param_data->temperature_centicelsius = _compensate_temperature_int32(ptr_param_uncomp_data, ptr_param_calib_data);
+        ptr_param_data->pressure_centipascal = _compensate_pressure_int32(ptr_param_uncomp_data, ptr_param_calib_data) * 100;
+        ptr_param_data->humidity_percent_q10 = _compensate_humidity_int32(ptr_param_uncomp_data, ptr_param_calib_data);
+        break;
+    case MJD_BME280_COMPENSATION_INT64:
+        ptr_param_data->temperature_centicelsius = _compensate_temperature_int32(ptr_param_uncomp_data, ptr_param_calib_data);
+        ptr_param_data->pressure_centipascal = _compensate_pressure_int64(ptr_param_uncomp_data, ptr_param_calib_data);
+        ptr_param_data->humidity_percent_q10 = _compensate_humidity_int32(ptr_param_uncomp_data, ptr_param_calib_data);
+        break;
+    default:
+        break;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*********************************************************************************
+ * NORMAL MODE (continuous sampling)
+ */
+
+/**************************************
+ * PUBLIC.
+ *
+ * @brief The normal mode period = the max measurement time + the standby time (BME280 data sheet chapter 9.1 + 9.2).
+ *
+ * @doc t_measure,max = 1.25 + [2.3 * T_oversampling] + [2.3 * P_oversampling + 0.575] + [2.3 * H_oversampling + 0.575] millisec.
+ *      A term is 0 when that measurement is skipped (BME280_NO_OVERSAMPLING).
+ */
+uint32_t mjd_bme280_get_normal_mode_period_us(const struct bme280_settings* ptr_param_settings) {
+    // Index = the register value of the oversampling setting | standby time
+    static const uint32_t OVERSAMPLING_FACTORS[] =
+        { 0, 1, 2, 4, 8, 16, 16, 16 };
+    static const uint32_t STANDBY_TIMES_US[] =
+        { 500, 62500, 125000, 250000, 500000, 1000000, 10000, 20000 };
+
+    uint32_t period_us = 1250 + STANDBY_TIMES_US[ptr_param_settings->standby_time & 0x07];
+
+    period_us += 2300 * OVERSAMPLING_FACTORS[ptr_param_settings->osr_t & 0x07];
+    if (ptr_param_settings->osr_p != BME280_NO_OVERSAMPLING) {
+        period_us += 2300 * OVERSAMPLING_FACTORS[ptr_param_settings->osr_p & 0x07] + 575;
+    }
+    if (ptr_param_settings->osr_h != BME280_NO_OVERSAMPLING) {
+        period_us += 2300 * OVERSAMPLING_FACTORS[ptr_param_settings->osr_h & 0x07] + 575;
+    }
+
+    return period_us;
+}
+
+/**************************************
+ * PRIVATE STATIC.
+ *
+ * @brief Normal mode: the task that reads 1 sample per normal mode period
+ *
+ * @doc vTaskDelayUntil() keeps the sampling grid fixed: the duration of the I2C burst read does not add up.
+ * @doc The period is rounded up to RTOS ticks so a sample is never read twice.
+ */
+static void _sampling_task(void *pvParameter) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    mjd_bme280_config_t* ptr_config = (mjd_bme280_config_t*) pvParameter;
+
+    const uint32_t period_ms = (ptr_config->sampling_stats.expected_period_us + 999) / 1000;
+    TickType_t period_ticks = (period_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+    TickType_t last_wake_time = xTaskGetTickCount();
+
+    if (period_ticks == 0) {
+        period_ticks = 1;
+    }
+
+    while (ptr_config->is_sampling_stop_requested == false) {
+        vTaskDelayUntil(&last_wake_time, period_ticks);
+        mjd_bme280_sampling_read_burst(ptr_config);
+    }
+
+    ptr_config->is_sampling = false;
+
+    /********************************************************************************
+     * Task Delete
+     * @doc Passing NULL will end the current task
+     */
+    vTaskDelete(NULL);
+}
+
+/**************************************
+ * PUBLIC.
+ *
+ */
+esp_err_t mjd_bme280_sampling_read_burst(mjd_bme280_config_t* ptr_param_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    int32_t com_rslt;
+
+    uint8_t reg_data[BME280_P_T_H_DATA_LEN] =
+        { 0 }; // @important = { 0 }
+    struct bme280_uncomp_data uncomp_data =
+        { 0 }; // @important = { 0 }
+    mjd_bme280_sample_t sample =
+        { 0 }; // @important = { 0 }
+
+    if (ptr_param_config->sampling_queue_handle == NULL) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. Normal mode sampling is not started | err %i (%s)", __FUNCTION__, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // @important 1 burst read 0xF7..0xFE (press_msb .. hum_lsb)
+    com_rslt = bme280_get_regs(BME280_DATA_ADDR, reg_data, BME280_P_T_H_DATA_LEN, &ptr_param_config->bme280_device);
+    sample.timestamp_us = esp_timer_get_time();
+    if (com_rslt != BME280_OK) {
+        portENTER_CRITICAL(&bme280_spinlock);
+        ++ptr_param_config->sampling_stats.nbr_of_read_errors;
+        portEXIT_CRITICAL(&bme280_spinlock);
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). ABORT. bme280_get_regs(BME280_DATA_ADDR) failed - err %i", __FUNCTION__, com_rslt);
+        // GOTO
+        goto cleanup;
+    }
+    bme280_parse_sensor_data(reg_data, &uncomp_data);
+
+    f_retval = mjd_bme280_compensate(ptr_param_config->compensation, &ptr_param_config->bme280_device.calib_data, &uncomp_data,
+            &sample.data);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. mjd_bme280_compensate() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    portENTER_CRITICAL(&bme280_spinlock);
+    mjd_bme280_sampling_stats_t* ptr_stats = &ptr_param_config->sampling_stats;
+    if (ptr_stats->nbr_of_samples == 0) {
+        ptr_param_config->sampling_first_time_us = sample.timestamp_us;
+    } else {
+        const uint32_t interval_us = (uint32_t) (sample.timestamp_us - ptr_param_config->sampling_last_time_us);
+        if (ptr_stats->nbr_of_samples == 1 || interval_us < ptr_stats->min_interval_us) {
+            ptr_stats->min_interval_us = interval_us;
+        }
+        if (interval_us > ptr_stats->max_interval_us) {
+            ptr_stats->max_interval_us = interval_us;
+        }
+    }
+    ptr_param_config->sampling_last_time_us = sample.timestamp_us;
+    ++ptr_stats->nbr_of_samples;
+    sample.sample_nbr = ++ptr_param_config->sampling_sample_nbr;
+    portEXIT_CRITICAL(&bme280_spinlock);
+
+    if (xQueueSend(ptr_param_config->sampling_queue_handle, &sample, 0) != pdTRUE) {
+        portENTER_CRITICAL(&bme280_spinlock);
+        ++ptr_param_config->sampling_stats.nbr_of_dropped_samples;
+        portEXIT_CRITICAL(&bme280_spinlock);
+        f_retval = ESP_ERR_NO_MEM;
+        // GOTO
+        goto cleanup;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_bme280_start_sampling(mjd_bme280_config_t* ptr_param_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    int32_t com_rslt;
+
+    struct bme280_dev *ptr_bme280_device = &(ptr_param_config->bme280_device);  // @important Use &(p->v)
+
+    if (ptr_bme280_device->chip_id != BME280_CHIP_ID || ptr_param_config->is_sampling == true) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. The component is not init'd or normal mode sampling is already active | err %i (%s)", __FUNCTION__,
+                f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (ptr_param_config->sampling_queue_length == 0 || ptr_param_config->compensation >= MJD_BME280_COMPENSATION_MAX) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. sampling_queue_length 0 or invalid compensation | err %i (%s)", __FUNCTION__, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // @IMPORTANT SAVE the I2C Port Num for later use in the Bosch read and write interface functions!
+    bme280_current_i2c_port = ptr_param_config->i2c_port_num;
+
+    /*
+     * Sensor settings: oversampling, IIR filter, standby time
+     * @doc The Bosch driver puts the sensor in sleep mode before writing the config register 0xF5 (data sheet chapter 5.4.6).
+     */
+    ptr_bme280_device->settings = ptr_param_config->normal_mode_settings;
+    com_rslt = bme280_set_sensor_settings(BME280_ALL_SETTINGS_SEL, ptr_bme280_device);
+    if (com_rslt != BME280_OK) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). ABORT. bme280_set_sensor_settings() failed - err %i", __FUNCTION__, com_rslt);
+        // GOTO
+        goto cleanup;
+    }
+
+    ptr_param_config->sampling_queue_handle = xQueueCreate(ptr_param_config->sampling_queue_length, sizeof(mjd_bme280_sample_t));
+    if (ptr_param_config->sampling_queue_handle == NULL) {
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "%s(). ABORT. xQueueCreate() failed | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    portENTER_CRITICAL(&bme280_spinlock);
+    memset(&ptr_param_config->sampling_stats, 0, sizeof(ptr_param_config->sampling_stats));
+    ptr_param_config->sampling_stats.expected_period_us = mjd_bme280_get_normal_mode_period_us(&ptr_param_config->normal_mode_settings);
+    ptr_param_config->sampling_sample_nbr = 0;
+    ptr_param_config->sampling_first_time_us = 0;
+    ptr_param_config->sampling_last_time_us = 0;
+    portEXIT_CRITICAL(&bme280_spinlock);
+
+    com_rslt = bme280_set_sensor_mode(BME280_NORMAL_MODE, ptr_bme280_device);
+    if (com_rslt != BME280_OK) {
+        vQueueDelete(ptr_param_config->sampling_queue_handle);
+        ptr_param_config->sampling_queue_handle = NULL;
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). ABORT. bme280_set_sensor_mode(BME280_NORMAL_MODE) failed - err %i", __FUNCTION__, com_rslt);
+        // GOTO
+        goto cleanup;
+    }
+
+    ptr_param_config->is_sampling_stop_requested = false;
+    ptr_param_config->is_sampling = true;
+
+    /**********
+     * TASK
+     *  @important For stability (I2C + Wifi etc.): always use xTaskCreatePinnedToCore(APP_CPU_NUM)
+     */
+    BaseType_t xReturned = xTaskCreatePinnedToCore(&_sampling_task, "mjd_bme280_sampling", MJD_BME280_SAMPLING_TASK_STACK_SIZE,
+            ptr_param_config, MJD_BME280_SAMPLING_TASK_PRIORITY, &ptr_param_config->sampling_task_handle, APP_CPU_NUM);
+    if (xReturned != pdPASS) {
+        ptr_param_config->is_sampling = false;
+        bme280_set_sensor_mode(BME280_SLEEP_MODE, ptr_bme280_device);
+        vQueueDelete(ptr_param_config->sampling_queue_handle);
+        ptr_param_config->sampling_queue_handle = NULL;
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "%s(). ABORT. xTaskCreatePinnedToCore() failed | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    ESP_LOGI(TAG, "Normal mode sampling started: 1 sample every %u microsec", ptr_param_config->sampling_stats.expected_period_us);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_bme280_stop_sampling(mjd_bme280_config_t* ptr_param_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    int32_t com_rslt;
+
+    if (ptr_param_config->is_sampling != true) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. Normal mode sampling is not active | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    ptr_param_config->is_sampling_stop_requested = true;
+
+    // Wait for the task to read its last sample (max 1 normal mode period + margin)
+    for (uint32_t idx = 0; idx < 200 && ptr_param_config->is_sampling == true; idx++) {
+        vTaskDelay(RTOS_DELAY_10MILLISEC);
+    }
+    if (ptr_param_config->is_sampling == true) {
+        f_retval = ESP_ERR_TIMEOUT;
+        ESP_LOGE(TAG, "%s(). ABORT. The sampling task did not stop | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    com_rslt = bme280_set_sensor_mode(BME280_SLEEP_MODE, &ptr_param_config->bme280_device);
+    if (com_rslt != BME280_OK) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). bme280_set_sensor_mode(BME280_SLEEP_MODE) failed - err %i", __FUNCTION__, com_rslt);
+        // Continue: delete the sample queue
+    }
+
+    vQueueDelete(ptr_param_config->sampling_queue_handle);
+    ptr_param_config->sampling_queue_handle = NULL;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_bme280_receive_sample(mjd_bme280_config_t* ptr_param_config, mjd_bme280_sample_t* ptr_param_sample,
+                                    TickType_t param_ticks_to_wait) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (ptr_param_config->sampling_queue_handle == NULL) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. Normal mode sampling is not started | err %i (%s)", __FUNCTION__, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    if (xQueueReceive(ptr_param_config->sampling_queue_handle, ptr_param_sample, param_ticks_to_wait) != pdTRUE) {
+        f_retval = ESP_ERR_TIMEOUT;
+        // GOTO
+        goto cleanup;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_bme280_get_sampling_stats(mjd_bme280_config_t* ptr_param_config, mjd_bme280_sampling_stats_t* ptr_param_stats) {
+    esp_err_t f_retval = ESP_OK;
+    int64_t elapsed_us;
+
+    portENTER_CRITICAL(&bme280_spinlock);
+    *ptr_param_stats = ptr_param_config->sampling_stats;
+    elapsed_us = ptr_param_config->sampling_last_time_us - ptr_param_config->sampling_first_time_us;
+    portEXIT_CRITICAL(&bme280_spinlock);
+
+    ptr_param_stats->achieved_rate_hz = 0.0f;
+    if (ptr_param_stats->nbr_of_samples > 1 && elapsed_us > 0) {
+        ptr_param_stats->achieved_rate_hz = (float) (ptr_param_stats->nbr_of_samples - 1) * 1000000.0f / (float) elapsed_us;
+    }
+
+    return f_retval;
+}
@@ -27,6 +27,41 @@ extern "C" {
 /**
  * Data structs
  */
+
+/*
+ * @doc Compensation modes: how the raw ADC values are converted to meteo values (Bosch driver).
+ *  MJD_BMP280_COMPENSATION_FLOAT: double precision floating point. The ESP32 FPU is single precision: doubles are emulated in software.
+ *  MJD_BMP280_COMPENSATION_INT32: 32-bit integers only. Pressure resolution 1 Pa.
+ *  MJD_BMP280_COMPENSATION_INT64: 32-bit integers + 64-bit integers for the pressure. Pressure resolution 1/256 Pa. The recommended integer mode.
+ */
+typedef enum {
+    MJD_BMP280_COMPENSATION_FLOAT = 0,
+    MJD_BMP280_COMPENSATION_INT32,
+    MJD_BMP280_COMPENSATION_INT64,
+    MJD_BMP280_COMPENSATION_MAX,
+} mjd_bmp280_compensation_t;
+
+/*
+ * NORMAL MODE (continuous sampling)
+ *
+ * @doc In normal mode the sensor cycles by itself between a measurement and a standby period (data sheet chapter 3.6.3).
+ *      The oversampling is set by bmp280_work_mode and the IIR filter by bmp280_filter_coefficient (data sheet chapter 3.3.3).
+ * @doc The sampling task reads the 6 data registers 0xF7..0xFC in ONE I2C burst read per sample: the sensor locks the data registers
+ *      during a burst read so pressure and temperature always belong to the same measurement (data sheet chapter 3.9).
+ * @doc The samples are stored in a FreeRTOS queue (the sample ring buffer). The newest sample is dropped when the queue is full.
+ */
+#define MJD_BMP280_SAMPLING_DEFAULT_QUEUE_LENGTH (16)
+
+typedef struct {
+    uint32_t nbr_of_samples; /*!< The number of successful burst reads (queued + dropped) */
+    uint32_t nbr_of_read_errors; /*!< The number of failed burst reads (I2C errors) */
+    uint32_t nbr_of_dropped_samples; /*!< The sample queue was full: the consumer does not keep up */
+    uint32_t expected_period_us; /*!< The max measurement time + the standby time */
+    uint32_t min_interval_us; /*!< The smallest interval between 2 consecutive samples */
+    uint32_t max_interval_us; /*!< The largest interval between 2 consecutive samples */
+    float achieved_rate_hz; /*!< (nbr_of_samples - 1) / (timestamp last sample - timestamp first sample) */
+} mjd_bmp280_sampling_stats_t;
+
 typedef struct {
     bool manage_i2c_driver;
     i2c_port_t i2c_port_num;
@@ -35,6 +70,18 @@ typedef struct {
     gpio_num_t i2c_sda_gpio_num;
     u8 bmp280_work_mode;
     u8 bmp280_filter_coefficient;
+    mjd_bmp280_compensation_t compensation;
+    u8 bmp280_standby_durn; /*!< Normal mode: the standby time between 2 measurements */
+    uint32_t sampling_queue_length; /*!< Normal mode: the number of samples that the sample queue can hold */
+    struct bmp280_t bmp280_device; /*!< Private: normal mode. The Bosch driver keeps a pointer to it */
+    volatile bool is_sampling; /*!< Private: normal mode sampling is active (cleared by the sampling task when it exits) */
+    volatile bool is_sampling_stop_requested; /*!< Private */
+    TaskHandle_t sampling_task_handle; /*!< Private */
+    QueueHandle_t sampling_queue_handle; /*!< Private */
+    uint32_t sampling_sample_nbr; /*!< Private */
+    int64_t sampling_first_time_us; /*!< Private */
+    int64_t sampling_last_time_us; /*!< Private */
+    mjd_bmp280_sampling_stats_t sampling_stats; /*!< Private: use mjd_bmp280_get_sampling_stats() */
 } mjd_bmp280_config_t;
 
 /*
@@ -51,26 +98,75 @@ typedef struct {
  *   #define BMP280_FILTER_COEFF_4                 (0x02)
  *   #define BMP280_FILTER_COEFF_8                 (0x03)
  *   #define BMP280_FILTER_COEFF_16                (0x04)
+ *
+ * @doc bmp280_standby_durn STANDBY TIME DEFINITION (normal mode only)
+ *   #define BMP280_STANDBY_TIME_1_MS              (0x00)  0.5 ms
+ *   #define BMP280_STANDBY_TIME_63_MS             (0x01)  62.5 ms
+ *   #define BMP280_STANDBY_TIME_125_MS            (0x02)
+ *   #define BMP280_STANDBY_TIME_250_MS            (0x03)
+ *   #define BMP280_STANDBY_TIME_500_MS            (0x04)
+ *   #define BMP280_STANDBY_TIME_1000_MS           (0x05)
+ *   #define BMP280_STANDBY_TIME_2000_MS           (0x06)
+ *   #define BMP280_STANDBY_TIME_4000_MS           (0x07)
  */
 #define MJD_BMP280_CONFIG_DEFAULT() { \
     .manage_i2c_driver = true,  \
     .i2c_port_num = I2C_NUM_0,  \
     .i2c_slave_addr = 0x76,  \
     .bmp280_work_mode = BMP280_ULTRA_LOW_POWER_MODE,  \
-    .bmp280_filter_coefficient = BMP280_FILTER_COEFF_OFF  \
+    .bmp280_filter_coefficient = BMP280_FILTER_COEFF_OFF,  \
+    .compensation = MJD_BMP280_COMPENSATION_FLOAT,  \
+    .bmp280_standby_durn = BMP280_STANDBY_TIME_63_MS,  \
+    .sampling_queue_length = MJD_BMP280_SAMPLING_DEFAULT_QUEUE_LENGTH  \
 };
 
+/*
+ * @doc The fixed-point fields are set in all compensation modes.
+ * @important The double fields are only set in MJD_BMP280_COMPENSATION_FLOAT (the integer modes do not use any floating point code).
+ */
 typedef struct {
     double pressure_hpascal;
     double temperature_celsius;
+    uint32_t pressure_centipascal;      /*!< Unit 0.01 Pa. 9638620 = 96386.20 Pa = 963.8620 hPa */
+    int32_t temperature_centicelsius;   /*!< Unit 0.01 degree Celsius. 5123 = 51.23 C */
 } mjd_bmp280_data_t;
 
+/*
+ * NORMAL MODE: 1 sample = 1 burst read
+ */
+typedef struct {
+    int64_t timestamp_us; /*!< esp_timer_get_time() right after the burst read */
+    uint32_t sample_nbr; /*!< 1, 2, 3... A gap in the numbers = samples that were dropped because the queue was full */
+    mjd_bmp280_data_t data;
+} mjd_bmp280_sample_t;
+
 /**
  * Function declarations
  */
 esp_err_t mjd_bmp280_init(const mjd_bmp280_config_t* config);
 esp_err_t mjd_bmp280_deinit(const mjd_bmp280_config_t* config);
 esp_err_t mjd_bmp280_read_forced(const mjd_bmp280_config_t* config, mjd_bmp280_data_t* data);
+esp_err_t mjd_bmp280_compensate(mjd_bmp280_compensation_t compensation, s32 uncomp_pressure, s32 uncomp_temperature, mjd_bmp280_data_t* data);
+
+/*
+ * NORMAL MODE (continuous sampling)
+ *
+ * @brief mjd_bmp280_start_sampling() writes the work mode, the filter coefficient and the standby time, puts the sensor in normal mode
+ *        and starts a task on the APP CPU that reads 1 sample per period. Receive the samples with mjd_bmp280_receive_sample().
+ *
+ * @important mjd_bmp280_read_forced() is not allowed while sampling is active.
+ */
+uint32_t mjd_bmp280_get_normal_mode_period_us(u8 oversamp_pressure, u8 oversamp_temperature, u8 standby_durn);
+esp_err_t mjd_bmp280_start_sampling(mjd_bmp280_config_t* config);
+esp_err_t mjd_bmp280_stop_sampling(mjd_bmp280_config_t* config);
+
+/*
+ * @brief 1 sample: 1 burst read of the data registers, compensate, timestamp, queue.
+ *        The sampling task calls it once per period; an app without the sampling task (or a unit test) can call it directly.
+ */
+esp_err_t mjd_bmp280_sampling_read_burst(mjd_bmp280_config_t* config);
+esp_err_t mjd_bmp280_receive_sample(mjd_bmp280_config_t* config, mjd_bmp280_sample_t* sample, TickType_t ticks_to_wait);
+esp_err_t mjd_bmp280_get_sampling_stats(mjd_bmp280_config_t* config, mjd_bmp280_sampling_stats_t* stats);
 
 #ifdef __cplusplus
 }
@@ -3,15 +3,26 @@
  *
  */
 
+#include "esp_timer.h"
+
 // Component header file(s)
 #include "mjd.h"
 #include "mjd_bmp280.h"
+#include "mjd_trace.h"
 
 /*
  * Logging
  */
 static const char TAG[] = "mjd_bmp280";
 
+/*
+ * NORMAL MODE: the sampling task
+ */
+#define MJD_BMP280_SAMPLING_TASK_STACK_SIZE (3072)
+#define MJD_BMP280_SAMPLING_TASK_PRIORITY   (RTOS_TASK_PRIORITY_NORMAL)
+
+static portMUX_TYPE bmp280_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
 /*********************************************************************************
  * Bosch driver interface functions
  */
@@ -58,7 +69,9 @@ s8 BMP280_I2C_bus_write(u8 dev_addr, u8 reg_addr, u8 *reg_data, u8 cnt) {
     i2c_master_write_byte(cmd, reg_addr, true);
     i2c_master_write(cmd, reg_data, cnt, true);
     i2c_master_stop(cmd);
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_I2C_TRANSACTION);
     esp_retval = i2c_master_cmd_begin(bmp280_current_i2c_port, cmd, RTOS_DELAY_100MILLISEC);
+    MJD_TRACE_END(MJD_TRACE_PROBE_I2C_TRANSACTION);
     if (esp_retval == ESP_OK) {
         f_retval = SUCCESS;  // SUCCES 0 = defined in the Bosch driver
     } else {
@@ -108,7 +121,9 @@ s8 BMP280_I2C_bus_read(u8 dev_addr, u8 reg_addr, u8 *reg_data, u8 cnt) {
     i2c_master_read_byte(cmd, reg_data + cnt - 1, I2C_MASTER_NACK);
     i2c_master_stop(cmd);
 
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_I2C_TRANSACTION);
     esp_retval = i2c_master_cmd_begin(bmp280_current_i2c_port, cmd, RTOS_DELAY_100MILLISEC);
+    MJD_TRACE_END(MJD_TRACE_PROBE_I2C_TRANSACTION);
     if (esp_retval == ESP_OK) {
         f_retval = SUCCESS;  // SUCCES = defined in the Bosch driver
     } else {
@@ -251,11 +266,20 @@ esp_err_t mjd_bmp280_read_forced(const mjd_bmp280_config_t* config, mjd_bmp280_d
     u8 filter_coeff = 255;
     u8 power_mode = 255;
 
+    if (config->is_sampling == true) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. Normal mode sampling is active | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
     /*
      * Reset receive values
      */
     data->pressure_hpascal = 0.0;
     data->temperature_celsius = 0.0;
+    data->pressure_centipascal = 0;
+    data->temperature_centicelsius = 0;
 
     /* STEP 1: INIT.
      * Init Bosch driver
@@ -455,8 +479,12 @@ esp_err_t mjd_bmp280_read_forced(const mjd_bmp280_config_t* config, mjd_bmp280_d
     }
 
     // compensate sensor values & transfer values to my data store
-    data->pressure_hpascal = bmp280_compensate_pressure_double(v_uncomp_pressure_s32) / 100; // Pascal => HPa
-    data->temperature_celsius = bmp280_compensate_temperature_double(v_uncomp_temperature_s32);
+    f_retval = mjd_bmp280_compensate(config->compensation, v_uncomp_pressure_s32, v_uncomp_temperature_s32, data);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "ABORT. mjd_bmp280_compensate() failed err %i", f_retval);
+        // LABEL
+        goto cleanup;
+    }
 
     /* STEP *LAST: go to sleep
      * Deinit Bosch driver
@@ -501,3 +529,387 @@ esp_err_t mjd_bmp280_read_forced(const mjd_bmp280_config_t* config, mjd_bmp280_d
 
     return f_retval;
 }
+
+/*********************************************************************************
+ * PUBLIC.
+ *
+ * @brief Compensate the raw ADC values of the sensor (pressure, temperature) using the Bosch driver.
+ *
+ * @important The Bosch driver must be initialized (bmp280_init()): it holds the calibration data.
+ * @doc The temperature is compensated first: it sets t_fine (the fine temperature) for the pressure compensation.
+ */
+esp_err_t mjd_bmp280_compensate(mjd_bmp280_compensation_t compensation, s32 uncomp_pressure, s32 uncomp_temperature, mjd_bmp280_data_t* data) {
+    esp_err_t f_retval = ESP_OK;
+    double temperature_celsius;
+    double pressure_pascal;
+
+    if (data == NULL || compensation >= MJD_BMP280_COMPENSATION_MAX) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    switch (compensation) {
+    case MJD_BMP280_COMPENSATION_FLOAT:
+        temperature_celsius = bmp280_compensate_temperature_double(uncomp_temperature);
+        pressure_pascal = bmp280_compensate_pressure_double(uncomp_pressure);
+        data->pressure_hpascal = pressure_pascal / 100; // Pascal => HPa
+        data->temperature_celsius = temperature_celsius;
+        data->pressure_centipascal = (uint32_t) (pressure_pascal * 100 + 0.5);
+        data->temperature_centicelsius = (int32_t) lround(temperature_celsius * 100);
+        break;
+    case MJD_BMP280_COMPENSATION_INT32:
+        data->temperature_centicelsius = bmp280_compensate_temperature_int32(uncomp_temperature);
+        data->pressure_centipascal = bmp280_compensate_pressure_int32(uncomp_pressure) * 100;
+        break;
+    case MJD_BMP280_COMPENSATION_INT64:
+        // Q24.8 Pa => 0.01 Pa (rounded)
+        data->temperature_centicelsius = bmp280_compensate_temperature_int32(uncomp_temperature);
+        data->pressure_centipascal = (uint32_t) ((((uint64_t) bmp280_compensate_pressure_int64(uncomp_pressure)) * 100 + 128) >> 8);
+        break;
+    default:
+        break;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*********************************************************************************
+ * NORMAL MODE (continuous sampling)
+ */
+
+/**************************************
+ * PUBLIC.
+ *
+ * @brief The normal mode period = the max measurement time + the standby time (BMP280 data sheet chapter 3.8.1 + 3.6.3).
+ *
+ * @doc t_measure,max = 1.25 + [2.3 * T_oversampling] + [2.3 * P_oversampling + 0.575] millisec.
+ *      A term is 0 when that measurement is skipped (BMP280_OVERSAMP_SKIPPED).
+ */
+uint32_t mjd_bmp280_get_normal_mode_period_us(u8 oversamp_pressure, u8 oversamp_temperature, u8 standby_durn) {
+    // Index = the register value of the oversampling setting | standby time
+    static const uint32_t OVERSAMPLING_FACTORS[] =
+        { 0, 1, 2, 4, 8, 16, 16, 16 };
+    static const uint32_t STANDBY_TIMES_US[] =
+        { 500, 62500, 125000, 250000, 500000, 1000000, 2000000, 4000000 };
+
+    uint32_t period_us = 1250 + STANDBY_TIMES_US[standby_durn & 0x07];
+
+    period_us += 2300 * OVERSAMPLING_FACTORS[oversamp_temperature & 0x07];
+    if (oversamp_pressure != BMP280_OVERSAMP_SKIPPED) {
+        period_us += 2300 * OVERSAMPLING_FACTORS[oversamp_pressure & 0x07] + 575;
+    }
+
+    return period_us;
+}
+
+/**************************************
+ * PRIVATE STATIC.
+ *
+ * @brief Normal mode: the task that reads 1 sample per normal mode period
+ *
+ * @doc vTaskDelayUntil() keeps the sampling grid fixed: the duration of the I2C burst read does not add up.
+ * @doc The period is rounded up to RTOS ticks so a sample is never read twice.
+ */
+static void _sampling_task(void *pvParameter) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    mjd_bmp280_config_t* config = (mjd_bmp280_config_t*) pvParameter;
+
+    const uint32_t period_ms = (config->sampling_stats.expected_period_us + 999) / 1000;
+    TickType_t period_ticks = (period_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+    TickType_t last_wake_time = xTaskGetTickCount();
+
+    if (period_ticks == 0) {
+        period_ticks = 1;
+    }
+
+    while (config->is_sampling_stop_requested == false) {
+        vTaskDelayUntil(&last_wake_time, period_ticks);
+        mjd_bmp280_sampling_read_burst(config);
+    }
+
+    config->is_sampling = false;
+
+    /********************************************************************************
+     * Task Delete
+     * @doc Passing NULL will end the current task
+     */
+    vTaskDelete(NULL);
+}
+
+/**************************************
+ * PUBLIC.
+ *
+ */
+esp_err_t mjd_bmp280_sampling_read_burst(mjd_bmp280_config_t* config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    s32 com_rslt;
+    s32 v_uncomp_pressure_s32 = 0;
+    s32 v_uncomp_temperature_s32 = 0;
+    mjd_bmp280_sample_t sample =
+        { 0 }; // @important = { 0 }
+
+    if (config->sampling_queue_handle == NULL) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. Normal mode sampling is not started | err %i (%s)", __FUNCTION__, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // @important 1 burst read 0xF7..0xFC (press_msb .. temp_xlsb)
+    com_rslt = bmp280_read_uncomp_pressure_temperature(&v_uncomp_pressure_s32, &v_uncomp_temperature_s32);
+    sample.timestamp_us = esp_timer_get_time();
+    if (com_rslt != SUCCESS) {
+        portENTER_CRITICAL(&bmp280_spinlock);
+        ++config->sampling_stats.nbr_of_read_errors;
+        portEXIT_CRITICAL(&bmp280_spinlock);
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). ABORT. bmp280_read_uncomp_pressure_temperature() failed err %i", __FUNCTION__, com_rslt);
+        // GOTO
+        goto cleanup;
+    }
+
+    f_retval = mjd_bmp280_compensate(config->compensation, v_uncomp_pressure_s32, v_uncomp_temperature_s32, &sample.data);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. mjd_bmp280_compensate() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    portENTER_CRITICAL(&bmp280_spinlock);
+    mjd_bmp280_sampling_stats_t* ptr_stats = &config->sampling_stats;
+    if (ptr_stats->nbr_of_samples == 0) {
+        config->sampling_first_time_us = sample.timestamp_us;
+    } else {
+        const uint32_t interval_us = (uint32_t) (sample.timestamp_us - config->sampling_last_time_us);
+        if (ptr_stats->nbr_of_samples == 1 || interval_us < ptr_stats->min_interval_us) {
+            ptr_stats->min_interval_us = interval_us;
+        }
+        if (interval_us > ptr_stats->max_interval_us) {
+            ptr_stats->max_interval_us = interval_us;
+        }
+    }
+    config->sampling_last_time_us = sample.timestamp_us;
+    ++ptr_stats->nbr_of_samples;
+    sample.sample_nbr = ++config->sampling_sample_nbr;
+    portEXIT_CRITICAL(&bmp280_spinlock);
+
+    if (xQueueSend(config->sampling_queue_handle, &sample, 0) != pdTRUE) {
+        portENTER_CRITICAL(&bmp280_spinlock);
+        ++config->sampling_stats.nbr_of_dropped_samples;
+        portEXIT_CRITICAL(&bmp280_spinlock);
+        f_retval = ESP_ERR_NO_MEM;
+        // GOTO
+        goto cleanup;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_bmp280_start_sampling(mjd_bmp280_config_t* config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    s32 com_rslt;
+
+    if (config->is_sampling == true) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. Normal mode sampling is already active | err %i (%s)", __FUNCTION__, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (config->sampling_queue_length == 0 || config->compensation >= MJD_BMP280_COMPENSATION_MAX) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. sampling_queue_length 0 or invalid compensation | err %i (%s)", __FUNCTION__, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // SAVE the I2C Port Num for later use in the Bosch read and write interface functions!
+    bmp280_current_i2c_port = config->i2c_port_num;
+
+    /*
+     * Init Bosch driver: chip id + calibration data
+     *   @important The Bosch driver keeps a pointer to the struct so it must outlive this func (config->bmp280_device).
+     */
+    memset(&config->bmp280_device, 0, sizeof(config->bmp280_device));
+    config->bmp280_device.bus_write = BMP280_I2C_bus_write;
+    config->bmp280_device.bus_read = BMP280_I2C_bus_read;
+    config->bmp280_device.delay_msec = BMP280_delay_millisec;
+    config->bmp280_device.dev_addr = config->i2c_slave_addr;
+    com_rslt = bmp280_init(&config->bmp280_device);
+    if (com_rslt != SUCCESS) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). ABORT. bmp280_init() failed err %i", __FUNCTION__, com_rslt);
+        // GOTO
+        goto cleanup;
+    }
+
+    /*
+     * Sensor settings: oversampling (work mode), IIR filter, standby time
+     * @doc Write the config register 0xF5 in sleep mode: writes in normal mode might be ignored (data sheet chapter 4.3.5).
+     */
+    com_rslt = bmp280_set_work_mode(config->bmp280_work_mode);
+    if (com_rslt == SUCCESS) {
+        com_rslt = bmp280_set_filter(config->bmp280_filter_coefficient);
+    }
+    if (com_rslt == SUCCESS) {
+        com_rslt = bmp280_set_standby_durn(config->bmp280_standby_durn);
+    }
+    if (com_rslt != SUCCESS) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). ABORT. bmp280_set_work_mode() | bmp280_set_filter() | bmp280_set_standby_durn() failed err %i",
+                __FUNCTION__, com_rslt);
+        // GOTO
+        goto cleanup;
+    }
+
+    config->sampling_queue_handle = xQueueCreate(config->sampling_queue_length, sizeof(mjd_bmp280_sample_t));
+    if (config->sampling_queue_handle == NULL) {
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "%s(). ABORT. xQueueCreate() failed | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    portENTER_CRITICAL(&bmp280_spinlock);
+    memset(&config->sampling_stats, 0, sizeof(config->sampling_stats));
+    config->sampling_stats.expected_period_us = mjd_bmp280_get_normal_mode_period_us(config->bmp280_device.oversamp_pressure,
+            config->bmp280_device.oversamp_temperature, config->bmp280_standby_durn);
+    config->sampling_sample_nbr = 0;
+    config->sampling_first_time_us = 0;
+    config->sampling_last_time_us = 0;
+    portEXIT_CRITICAL(&bmp280_spinlock);
+
+    com_rslt = bmp280_set_power_mode(BMP280_NORMAL_MODE);
+    if (com_rslt != SUCCESS) {
+        vQueueDelete(config->sampling_queue_handle);
+        config->sampling_queue_handle = NULL;
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). ABORT. bmp280_set_power_mode(BMP280_NORMAL_MODE) failed err %i", __FUNCTION__, com_rslt);
+        // GOTO
+        goto cleanup;
+    }
+
+    config->is_sampling_stop_requested = false;
+    config->is_sampling = true;
+
+    /**********
+     * TASK
+     *  @important For stability (I2C + Wifi etc.): always use xTaskCreatePinnedToCore(APP_CPU_NUM)
+     */
+    BaseType_t xReturned = xTaskCreatePinnedToCore(&_sampling_task, "mjd_bmp280_sampling", MJD_BMP280_SAMPLING_TASK_STACK_SIZE,
+            config, MJD_BMP280_SAMPLING_TASK_PRIORITY, &config->sampling_task_handle, APP_CPU_NUM);
+    if (xReturned != pdPASS) {
+        config->is_sampling = false;
+        bmp280_set_power_mode(BMP280_SLEEP_MODE);
+        vQueueDelete(config->sampling_queue_handle);
+        config->sampling_queue_handle = NULL;
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "%s(). ABORT. xTaskCreatePinnedToCore() failed | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    ESP_LOGI(TAG, "Normal mode sampling started: 1 sample every %u microsec", config->sampling_stats.expected_period_us);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_bmp280_stop_sampling(mjd_bmp280_config_t* config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    s32 com_rslt;
+
+    if (config->is_sampling != true) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. Normal mode sampling is not active | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    config->is_sampling_stop_requested = true;
+
+    // Wait for the task to read its last sample (the longest standby time is 4 seconds)
+    for (uint32_t idx = 0; idx < 500 && config->is_sampling == true; idx++) {
+        vTaskDelay(RTOS_DELAY_10MILLISEC);
+    }
+    if (config->is_sampling == true) {
+        f_retval = ESP_ERR_TIMEOUT;
+        ESP_LOGE(TAG, "%s(). ABORT. The sampling task did not stop | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    com_rslt = bmp280_set_power_mode(BMP280_SLEEP_MODE);
+    if (com_rslt != SUCCESS) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). bmp280_set_power_mode(BMP280_SLEEP_MODE) failed err %i", __FUNCTION__, com_rslt);
+        // Continue: delete the sample queue
+    }
+
+    vQueueDelete(config->sampling_queue_handle);
+    config->sampling_queue_handle = NULL;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_bmp280_receive_sample(mjd_bmp280_config_t* config, mjd_bmp280_sample_t* sample, TickType_t ticks_to_wait) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (config->sampling_queue_handle == NULL) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. Normal mode sampling is not started | err %i (%s)", __FUNCTION__, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    if (xQueueReceive(config->sampling_queue_handle, sample, ticks_to_wait) != pdTRUE) {
+        f_retval = ESP_ERR_TIMEOUT;
+        // GOTO
+        goto cleanup;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_bmp280_get_sampling_stats(mjd_bmp280_config_t* config, mjd_bmp280_sampling_stats_t* stats) {
+    esp_err_t f_retval = ESP_OK;
+    int64_t elapsed_us;
+
+    portENTER_CRITICAL(&bmp280_spinlock);
+    *stats = config->sampling_stats;
+    elapsed_us = config->sampling_last_time_us - config->sampling_first_time_us;
+    portEXIT_CRITICAL(&bmp280_spinlock);
+
+    stats->achieved_rate_hz = 0.0f;
+    if (stats->nbr_of_samples > 1 && elapsed_us > 0) {
+        stats->achieved_rate_hz = (float) (stats->nbr_of_samples - 1) * 1000000.0f / (float) elapsed_us;
+    }
+
+    return f_retval;
+}
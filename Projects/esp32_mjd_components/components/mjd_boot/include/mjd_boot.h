@@ -0,0 +1,161 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+#ifndef __MJD_BOOT_H__
+#define __MJD_BOOT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Includes: system, own
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+/**********
+ * SETTINGS
+ */
+#define MJD_BOOT_MAX_PARALLEL_INITS (8)
+#define MJD_BOOT_PARALLEL_TASK_STACK_SIZE (4096) /*!< The default stack of a parallel init task */
+#define MJD_BOOT_CORE_ANY (-1)                   /*!< Alternate the cores: init #0 on PRO_CPU, #1 on APP_CPU, ... */
+
+/**********
+ * PHASES
+ *
+ * @doc A phase is a named time span of the boot: [start_us, end_us] of esp_timer_get_time(), i.e. the time since the start of the app
+ *      (the ROM + 2nd stage bootloader time before it is not included).
+ *
+ * @important The name is not copied: use a string literal (or a string that lives until the report).
+ */
+typedef enum {
+    MJD_BOOT_PHASE_KIND_SERIAL = 0, /*!< mjd_boot_phase_begin/end() in the boot task */
+    MJD_BOOT_PHASE_KIND_GROUP,      /*!< mjd_boot_run_parallel(): the whole group */
+    MJD_BOOT_PHASE_KIND_PARALLEL,   /*!< mjd_boot_run_parallel(): 1 init of the group */
+    MJD_BOOT_PHASE_KIND_LAZY,       /*!< mjd_boot_lazy_ensure(): the init ran at the first use */
+    MJD_BOOT_PHASE_KIND_MARK,       /*!< mjd_boot_mark(): a milestone, e.g. "first reading" (no duration) */
+} mjd_boot_phase_kind_t;
+
+typedef struct {
+    const char *name;
+    mjd_boot_phase_kind_t kind;
+    int16_t group_idx;   /*!< PARALLEL: the index of its GROUP phase, else -1 */
+    uint8_t core_id;
+    bool is_ended;
+    esp_err_t retval;
+    int64_t start_us;
+    int64_t end_us;
+} mjd_boot_phase_t;
+
+/**********
+ * PARALLEL INIT
+ *
+ * @doc Independent inits (e.g. sensors on different I2C ports, the WiFi driver, the SD card) run each in their own task, spread over
+ *      both cores. mjd_boot_run_parallel() returns when all of them are done.
+ */
+typedef esp_err_t (*mjd_boot_init_fn_t)(void * param_ptr_arg);
+
+typedef struct {
+    const char *name;
+    mjd_boot_init_fn_t init_fn;
+    void *ptr_arg;
+    int core_id;         /*!< PRO_CPU_NUM, APP_CPU_NUM or MJD_BOOT_CORE_ANY */
+    uint32_t stack_size; /*!< 0 = MJD_BOOT_PARALLEL_TASK_STACK_SIZE */
+    esp_err_t retval;    /*!< Output: the result of init_fn */
+} mjd_boot_init_t;
+
+#define MJD_BOOT_INIT(param_name, param_init_fn, param_ptr_arg) { \
+    .name = (param_name), \
+    .init_fn = (param_init_fn), \
+    .ptr_arg = (param_ptr_arg), \
+    .core_id = MJD_BOOT_CORE_ANY, \
+    .stack_size = 0, \
+    .retval = ESP_OK, \
+}
+
+/**
+ * @brief The boot time delta of a parallel group.
+ */
+typedef struct {
+    uint64_t wall_us;       /*!< The duration of the group */
+    uint64_t serial_sum_us; /*!< The sum of the init durations: the boot time when they run one after the other */
+    int64_t saved_us;       /*!< serial_sum_us - wall_us */
+    uint32_t nbr_of_errors;
+} mjd_boot_parallel_result_t;
+
+/**********
+ * LAZY INIT
+ *
+ * @doc The init of a driver runs at its first use instead of at boot: mjd_boot_lazy_ensure() runs init_fn once (the first caller),
+ *      the other tasks that call it meanwhile wait until it is done. A failed init runs again at the next call (e.g. a sensor that
+ *      was not connected yet). The init is recorded as a LAZY phase: the boot report shows when it actually happened.
+ */
+typedef enum {
+    MJD_BOOT_LAZY_STATE_NOT_STARTED = 0,
+    MJD_BOOT_LAZY_STATE_RUNNING,
+    MJD_BOOT_LAZY_STATE_DONE,
+} mjd_boot_lazy_state_t;
+
+typedef struct {
+    const char *name;
+    mjd_boot_init_fn_t init_fn;
+    void *ptr_arg;
+    volatile mjd_boot_lazy_state_t state;
+    TaskHandle_t owner;   /*!< The task that runs init_fn (a recursive call is an error, not a deadlock) */
+    uint32_t nbr_of_attempts;
+} mjd_boot_lazy_t;
+
+#define MJD_BOOT_LAZY_INITIALIZER(param_name, param_init_fn, param_ptr_arg) { \
+    .name = (param_name), \
+    .init_fn = (param_init_fn), \
+    .ptr_arg = (param_ptr_arg), \
+    .state = MJD_BOOT_LAZY_STATE_NOT_STARTED, \
+    .owner = NULL, \
+    .nbr_of_attempts = 0, \
+}
+
+/**
+ * @brief Time a serial init: MJD_BOOT_PHASE("bme280", mjd_bme280_init(&config)) evaluates to the esp_err_t of the expression.
+ */
+#define MJD_BOOT_PHASE(param_name, param_expr) ({ \
+    int32_t _mjd_boot_phase_idx = mjd_boot_phase_begin(param_name); \
+    esp_err_t _mjd_boot_phase_retval = (param_expr); \
+    mjd_boot_phase_end(_mjd_boot_phase_idx, _mjd_boot_phase_retval); \
+    _mjd_boot_phase_retval; \
+})
+
+/**
+ * Function declarations
+ *
+ * @important The phase table holds CONFIG_MJD_BOOT_MAX_PHASES phases: the next ones are dropped (and counted).
+ */
+int32_t mjd_boot_phase_begin(const char * param_ptr_name);
+void mjd_boot_phase_end(int32_t param_phase_idx, esp_err_t param_retval);
+esp_err_t mjd_boot_phase_run(const char * param_ptr_name, mjd_boot_init_fn_t param_init_fn, void * param_ptr_arg);
+void mjd_boot_mark(const char * param_ptr_name);
+
+esp_err_t mjd_boot_run_parallel(const char * param_ptr_group_name, mjd_boot_init_t * param_ptr_inits, uint32_t param_nbr_of_inits,
+                                mjd_boot_parallel_result_t* param_ptr_result);
+
+esp_err_t mjd_boot_lazy_ensure(mjd_boot_lazy_t* param_ptr_lazy);
+bool mjd_boot_lazy_is_done(const mjd_boot_lazy_t* param_ptr_lazy);
+
+uint32_t mjd_boot_get_phases(mjd_boot_phase_t * param_ptr_phases, uint32_t param_max_nbr_of_phases);
+uint32_t mjd_boot_get_nbr_of_dropped(void);
+esp_err_t mjd_boot_export_csv(char * param_ptr_buf, size_t param_size, size_t * param_ptr_len);
+void mjd_boot_log_report(void);
+void mjd_boot_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_BOOT_H__ */
@@ -0,0 +1,462 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+
+#include "esp_timer.h"
+
+// Component header file(s)
+#include "mjd.h"
+#include "mjd_boot.h"
+
+/**********
+ * Logging
+ */
+static const char TAG[] = "mjd_boot";
+
+/*
+ * @important The phases are recorded from several tasks on both cores (parallel inits, lazy inits). The critical section only covers
+ *            the table updates, never an init function or a log line.
+ */
+static portMUX_TYPE _boot_spinlock = portMUX_INITIALIZER_UNLOCKED;
+#define _BOOT_LOCK()   portENTER_CRITICAL(&_boot_spinlock)
+#define _BOOT_UNLOCK() portEXIT_CRITICAL(&_boot_spinlock)
+
+static mjd_boot_phase_t _phases[CONFIG_MJD_BOOT_MAX_PHASES];
+static uint32_t _nbr_of_phases = 0;
+static uint32_t _nbr_of_dropped = 0;
+
+static const char * const _kind_names[] = {
+        [MJD_BOOT_PHASE_KIND_SERIAL] = "serial",
+        [MJD_BOOT_PHASE_KIND_GROUP] = "group",
+        [MJD_BOOT_PHASE_KIND_PARALLEL] = "parallel",
+        [MJD_BOOT_PHASE_KIND_LAZY] = "lazy",
+        [MJD_BOOT_PHASE_KIND_MARK] = "mark",
+    };
+
+/**********
+ * PRIVATE
+ */
+static int32_t _phase_begin(const char * param_ptr_name, mjd_boot_phase_kind_t param_kind, int32_t param_group_idx) {
+    int32_t idx = -1;
+    int64_t now_us = esp_timer_get_time();
+
+    _BOOT_LOCK();
+    if (_nbr_of_phases < CONFIG_MJD_BOOT_MAX_PHASES) {
+        idx = (int32_t) _nbr_of_phases++;
+        mjd_boot_phase_t *ptr_phase = &_phases[idx];
+        ptr_phase->name = (param_ptr_name != NULL) ? param_ptr_name : "?";
+        ptr_phase->kind = param_kind;
+        ptr_phase->group_idx = (int16_t) param_group_idx;
+        ptr_phase->core_id = (uint8_t) xPortGetCoreID();
+        ptr_phase->is_ended = false;
+        ptr_phase->retval = ESP_OK;
+        ptr_phase->start_us = now_us;
+        ptr_phase->end_us = now_us;
+    } else {
+        _nbr_of_dropped++;
+    }
+    _BOOT_UNLOCK();
+
+    return idx;
+}
+
+static esp_err_t _run_init(const char * param_ptr_name, mjd_boot_phase_kind_t param_kind, int32_t param_group_idx,
+                           mjd_boot_init_fn_t param_init_fn, void * param_ptr_arg) {
+    int32_t idx = _phase_begin(param_ptr_name, param_kind, param_group_idx);
+    esp_err_t retval = param_init_fn(param_ptr_arg);
+    mjd_boot_phase_end(idx, retval);
+
+    if (retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). init \"%s\" failed | err %i (%s)", __FUNCTION__, param_ptr_name, retval, esp_err_to_name(retval));
+    }
+    return retval;
+}
+
+/*
+ * @brief The boot time delta of the group param_group_idx (from a snapshot of the table).
+ */
+static void _get_group_result(const mjd_boot_phase_t * param_ptr_phases, uint32_t param_nbr_of_phases, int32_t param_group_idx,
+                              mjd_boot_parallel_result_t* param_ptr_result) {
+    memset(param_ptr_result, 0, sizeof(*param_ptr_result));
+    param_ptr_result->wall_us = param_ptr_phases[param_group_idx].end_us - param_ptr_phases[param_group_idx].start_us;
+    for (uint32_t idx = 0; idx < param_nbr_of_phases; idx++) {
+        const mjd_boot_phase_t *ptr_phase = &param_ptr_phases[idx];
+        if (ptr_phase->kind != MJD_BOOT_PHASE_KIND_PARALLEL || ptr_phase->group_idx != param_group_idx) {
+            continue;
+        }
+        param_ptr_result->serial_sum_us += ptr_phase->end_us - ptr_phase->start_us;
+        if (ptr_phase->retval != ESP_OK) {
+            param_ptr_result->nbr_of_errors++;
+        }
+    }
+    param_ptr_result->saved_us = (int64_t) param_ptr_result->serial_sum_us - (int64_t) param_ptr_result->wall_us;
+}
+
+#ifdef ESP_PLATFORM
+typedef struct {
+    mjd_boot_init_t *ptr_init;
+    int32_t group_idx;
+    EventGroupHandle_t event_group;
+    EventBits_t bit;
+} _parallel_context_t;
+
+static void _parallel_task(void * param_ptr_arg) {
+    _parallel_context_t *ptr_context = param_ptr_arg;
+    mjd_boot_init_t *ptr_init = ptr_context->ptr_init;
+
+    ptr_init->retval = _run_init(ptr_init->name, MJD_BOOT_PHASE_KIND_PARALLEL, ptr_context->group_idx, ptr_init->init_fn,
+            ptr_init->ptr_arg);
+    xEventGroupSetBits(ptr_context->event_group, ptr_context->bit);
+
+    vTaskDelete(NULL);
+}
+#endif
+
+/**********
+ * PUBLIC: PHASES
+ */
+
+/*
+ * @brief Start a phase. @return The phase index for mjd_boot_phase_end(), -1 = the table is full (the phase is not recorded).
+ */
+int32_t mjd_boot_phase_begin(const char * param_ptr_name) {
+    return _phase_begin(param_ptr_name, MJD_BOOT_PHASE_KIND_SERIAL, -1);
+}
+
+void mjd_boot_phase_end(int32_t param_phase_idx, esp_err_t param_retval) {
+    int64_t now_us = esp_timer_get_time();
+
+    if (param_phase_idx < 0 || param_phase_idx >= CONFIG_MJD_BOOT_MAX_PHASES) {
+        return;
+    }
+    _BOOT_LOCK();
+    _phases[param_phase_idx].end_us = now_us;
+    _phases[param_phase_idx].retval = param_retval;
+    _phases[param_phase_idx].is_ended = true;
+    _BOOT_UNLOCK();
+}
+
+/*
+ * @brief Run param_init_fn(param_ptr_arg) as a serial phase.
+ */
+esp_err_t mjd_boot_phase_run(const char * param_ptr_name, mjd_boot_init_fn_t param_init_fn, void * param_ptr_arg) {
+    if (param_init_fn == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return _run_init(param_ptr_name, MJD_BOOT_PHASE_KIND_SERIAL, -1, param_init_fn, param_ptr_arg);
+}
+
+/*
+ * @brief A milestone, e.g. "first reading" or "first MQTT publish": the boot report shows the time since the start of the app.
+ */
+void mjd_boot_mark(const char * param_ptr_name) {
+    int32_t idx = _phase_begin(param_ptr_name, MJD_BOOT_PHASE_KIND_MARK, -1);
+
+    mjd_boot_phase_end(idx, ESP_OK);
+}
+
+/**********
+ * PUBLIC: PARALLEL INIT
+ */
+
+/*
+ * @brief Run the inits in parallel, 1 task per init pinned to param_ptr_inits[i].core_id, and wait until all of them are done.
+ *        param_ptr_inits[i].retval = the result of each init.
+ *
+ * @return ESP_OK, or the error of the first init that failed (the other inits still ran).
+ *
+ * @important An init function must return (use the timeouts of the drivers): the group waits for all of them.
+ * @doc The host build (no RTOS tasks) runs the inits one after the other: saved_us is 0 there.
+ */
+esp_err_t mjd_boot_run_parallel(const char * param_ptr_group_name, mjd_boot_init_t * param_ptr_inits, uint32_t param_nbr_of_inits,
+                                mjd_boot_parallel_result_t* param_ptr_result) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    int32_t group_idx;
+
+    if (param_ptr_inits == NULL || param_nbr_of_inits == 0 || param_nbr_of_inits > MJD_BOOT_MAX_PARALLEL_INITS) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param (1..%u inits) | err %i (%s)", __FUNCTION__, MJD_BOOT_MAX_PARALLEL_INITS, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    for (uint32_t idx = 0; idx < param_nbr_of_inits; idx++) {
+        if (param_ptr_inits[idx].init_fn == NULL) {
+            f_retval = ESP_ERR_INVALID_ARG;
+            ESP_LOGE(TAG, "%s(). ABORT. Init #%u has no init_fn | err %i (%s)", __FUNCTION__, idx, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+    }
+
+    group_idx = _phase_begin(param_ptr_group_name, MJD_BOOT_PHASE_KIND_GROUP, -1);
+
+#ifdef ESP_PLATFORM
+    _parallel_context_t contexts[MJD_BOOT_MAX_PARALLEL_INITS];
+    EventBits_t all_bits = 0;
+    EventGroupHandle_t event_group = xEventGroupCreate();
+    if (event_group == NULL) {
+        ESP_LOGW(TAG, "%s(). xEventGroupCreate() failed: run the inits serially", __FUNCTION__);
+    }
+
+    for (uint32_t idx = 0; idx < param_nbr_of_inits; idx++) {
+        mjd_boot_init_t *ptr_init = &param_ptr_inits[idx];
+        int core_id = (ptr_init->core_id == MJD_BOOT_CORE_ANY) ? (int) (idx % portNUM_PROCESSORS) : ptr_init->core_id;
+
+        contexts[idx].ptr_init = ptr_init;
+        contexts[idx].group_idx = group_idx;
+        contexts[idx].event_group = event_group;
+        contexts[idx].bit = (EventBits_t) 1 << idx;
+        if (event_group != NULL
+                && xTaskCreatePinnedToCore(_parallel_task, ptr_init->name,
+                        (ptr_init->stack_size > 0) ? ptr_init->stack_size : MJD_BOOT_PARALLEL_TASK_STACK_SIZE, &contexts[idx],
+                        RTOS_TASK_PRIORITY_NORMAL, NULL, core_id) == pdPASS) {
+            all_bits |= contexts[idx].bit;
+        } else {
+            ESP_LOGW(TAG, "%s(). No task for init \"%s\": run it in the calling task", __FUNCTION__, ptr_init->name);
+            ptr_init->retval = _run_init(ptr_init->name, MJD_BOOT_PHASE_KIND_PARALLEL, group_idx, ptr_init->init_fn, ptr_init->ptr_arg);
+        }
+    }
+    if (all_bits != 0) {
+        xEventGroupWaitBits(event_group, all_bits, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+    if (event_group != NULL) {
+        vEventGroupDelete(event_group);
+    }
+#else
+    for (uint32_t idx = 0; idx < param_nbr_of_inits; idx++) {
+        mjd_boot_init_t *ptr_init = &param_ptr_inits[idx];
+        ptr_init->retval = _run_init(ptr_init->name, MJD_BOOT_PHASE_KIND_PARALLEL, group_idx, ptr_init->init_fn, ptr_init->ptr_arg);
+    }
+#endif
+
+    for (uint32_t idx = 0; idx < param_nbr_of_inits; idx++) {
+        if (param_ptr_inits[idx].retval != ESP_OK && f_retval == ESP_OK) {
+            f_retval = param_ptr_inits[idx].retval;
+        }
+    }
+    mjd_boot_phase_end(group_idx, f_retval);
+
+    if (param_ptr_result != NULL) {
+        if (group_idx >= 0) {
+            _BOOT_LOCK();
+            _get_group_result(_phases, _nbr_of_phases, group_idx, param_ptr_result);
+            _BOOT_UNLOCK();
+        } else {
+            memset(param_ptr_result, 0, sizeof(*param_ptr_result));
+        }
+        ESP_LOGI(TAG, "parallel \"%s\": %u inits in %" PRIu64 " us instead of %" PRIu64 " us (saved %" PRIi64 " us)", param_ptr_group_name,
+                param_nbr_of_inits, param_ptr_result->wall_us, param_ptr_result->serial_sum_us, param_ptr_result->saved_us);
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/**********
+ * PUBLIC: LAZY INIT
+ */
+
+/*
+ * @brief Make sure the init of param_ptr_lazy ran successfully: call it right before each use of the driver.
+ *        Costs a flag check (under the spinlock) after the first successful init.
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_STATE The init function itself called mjd_boot_lazy_ensure() of the same lazy init
+ *     - The error of the init function (the next call tries again)
+ */
+esp_err_t mjd_boot_lazy_ensure(mjd_boot_lazy_t* param_ptr_lazy) {
+    esp_err_t f_retval = ESP_OK;
+
+    TaskHandle_t current_task = xTaskGetCurrentTaskHandle();
+
+    if (param_ptr_lazy == NULL || param_ptr_lazy->init_fn == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    for (;;) {
+        _BOOT_LOCK();
+        mjd_boot_lazy_state_t state = param_ptr_lazy->state;
+        if (state == MJD_BOOT_LAZY_STATE_NOT_STARTED) {
+            param_ptr_lazy->state = MJD_BOOT_LAZY_STATE_RUNNING;
+            param_ptr_lazy->owner = current_task;
+            param_ptr_lazy->nbr_of_attempts++;
+        }
+        bool is_recursive = (state == MJD_BOOT_LAZY_STATE_RUNNING && param_ptr_lazy->owner == current_task);
+        _BOOT_UNLOCK();
+
+        if (state == MJD_BOOT_LAZY_STATE_DONE) {
+            // GOTO
+            goto cleanup;
+        }
+        if (state == MJD_BOOT_LAZY_STATE_NOT_STARTED) {
+            break;
+        }
+        if (is_recursive == true) {
+            f_retval = ESP_ERR_INVALID_STATE;
+            ESP_LOGE(TAG, "%s(). ABORT. Recursive lazy init \"%s\" | err %i (%s)", __FUNCTION__, param_ptr_lazy->name, f_retval,
+                    esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+        // Another task runs the init
+        vTaskDelay(1);
+    }
+
+    f_retval = _run_init(param_ptr_lazy->name, MJD_BOOT_PHASE_KIND_LAZY, -1, param_ptr_lazy->init_fn, param_ptr_lazy->ptr_arg);
+
+    _BOOT_LOCK();
+    param_ptr_lazy->state = (f_retval == ESP_OK) ? MJD_BOOT_LAZY_STATE_DONE : MJD_BOOT_LAZY_STATE_NOT_STARTED;
+    param_ptr_lazy->owner = NULL;
+    _BOOT_UNLOCK();
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+bool mjd_boot_lazy_is_done(const mjd_boot_lazy_t* param_ptr_lazy) {
+    return (param_ptr_lazy->state == MJD_BOOT_LAZY_STATE_DONE);
+}
+
+/**********
+ * PUBLIC: REPORT
+ */
+
+/*
+ * @brief Copy the recorded phases (in the order they started). @return The number of phases copied.
+ */
+uint32_t mjd_boot_get_phases(mjd_boot_phase_t * param_ptr_phases, uint32_t param_max_nbr_of_phases) {
+    uint32_t nbr;
+
+    _BOOT_LOCK();
+    nbr = (_nbr_of_phases < param_max_nbr_of_phases) ? _nbr_of_phases : param_max_nbr_of_phases;
+    memcpy(param_ptr_phases, _phases, nbr * sizeof(mjd_boot_phase_t));
+    _BOOT_UNLOCK();
+
+    return nbr;
+}
+
+uint32_t mjd_boot_get_nbr_of_dropped(void) {
+    return _nbr_of_dropped;
+}
+
+/*
+ * @brief Export the phases as CSV (a header line + 1 line per phase), e.g. to store it in a file or to publish it via MQTT.
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_SIZE The buffer is too small: it holds the lines that fit
+ */
+esp_err_t mjd_boot_export_csv(char * param_ptr_buf, size_t param_size, size_t * param_ptr_len) {
+    esp_err_t f_retval = ESP_OK;
+
+    size_t len = 0;
+    int n;
+
+    if (param_ptr_buf == NULL || param_size == 0) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    param_ptr_buf[0] = '\0';
+
+    n = snprintf(param_ptr_buf, param_size, "idx,name,kind,group,core,start_us,end_us,duration_us,retval\n");
+    if (n < 0 || (size_t) n >= param_size) {
+        param_ptr_buf[0] = '\0';
+        f_retval = ESP_ERR_INVALID_SIZE;
+        // GOTO
+        goto cleanup;
+    }
+    len = n;
+
+    for (uint32_t idx = 0;; idx++) {
+        mjd_boot_phase_t phase;
+        _BOOT_LOCK();
+        bool is_valid = (idx < _nbr_of_phases);
+        if (is_valid == true) {
+            phase = _phases[idx];
+        }
+        _BOOT_UNLOCK();
+        if (is_valid == false) {
+            break;
+        }
+
+        n = snprintf(&param_ptr_buf[len], param_size - len, "%u,%s,%s,%i,%u,%" PRIi64 ",%" PRIi64 ",%" PRIi64 ",%i\n", idx, phase.name,
+                _kind_names[phase.kind], phase.group_idx, phase.core_id, phase.start_us, phase.end_us, phase.end_us - phase.start_us,
+                phase.retval);
+        if (n < 0 || (size_t) n >= param_size - len) {
+            param_ptr_buf[len] = '\0'; // @important Only complete lines
+            f_retval = ESP_ERR_INVALID_SIZE;
+            // GOTO
+            goto cleanup;
+        }
+        len += n;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    if (param_ptr_len != NULL) {
+        *param_ptr_len = len;
+    }
+
+    return f_retval;
+}
+
+/*
+ * @brief Log the boot profile: 1 line per phase, the time saved per parallel group and the milestones.
+ */
+void mjd_boot_log_report(void) {
+    static mjd_boot_phase_t phases[CONFIG_MJD_BOOT_MAX_PHASES]; // @important static: not on the stack of the caller
+    uint32_t nbr_of_phases = mjd_boot_get_phases(phases, CONFIG_MJD_BOOT_MAX_PHASES);
+    int64_t end_us = 0;
+
+    ESP_LOGI(TAG, "BOOT PROFILE: %u phases (%u dropped). Times in ms since the start of the app", nbr_of_phases, _nbr_of_dropped);
+    ESP_LOGI(TAG, "  %2s %-26s %-8s %4s %9s %9s  %s", "#", "phase", "kind", "core", "start", "duration", "result");
+    for (uint32_t idx = 0; idx < nbr_of_phases; idx++) {
+        const mjd_boot_phase_t *ptr_phase = &phases[idx];
+        ESP_LOGI(TAG, "  %2u %s%-*s %-8s %4u %9.1f %9.1f  %s", idx, (ptr_phase->kind == MJD_BOOT_PHASE_KIND_PARALLEL) ? "  " : "",
+                (ptr_phase->kind == MJD_BOOT_PHASE_KIND_PARALLEL) ? 24 : 26, ptr_phase->name, _kind_names[ptr_phase->kind],
+                ptr_phase->core_id, ptr_phase->start_us / 1000.0, (ptr_phase->end_us - ptr_phase->start_us) / 1000.0,
+                (ptr_phase->is_ended == false) ? "(running)" : esp_err_to_name(ptr_phase->retval));
+        if (ptr_phase->end_us > end_us) {
+            end_us = ptr_phase->end_us;
+        }
+    }
+
+    for (uint32_t idx = 0; idx < nbr_of_phases; idx++) {
+        if (phases[idx].kind == MJD_BOOT_PHASE_KIND_GROUP) {
+            mjd_boot_parallel_result_t result;
+            _get_group_result(phases, nbr_of_phases, idx, &result);
+            ESP_LOGI(TAG, "  parallel %s: %.1f ms instead of %.1f ms serial => saved %.1f ms", phases[idx].name, result.wall_us / 1000.0,
+                    result.serial_sum_us / 1000.0, result.saved_us / 1000.0);
+        } else if (phases[idx].kind == MJD_BOOT_PHASE_KIND_MARK) {
+            ESP_LOGI(TAG, "  boot to %s: %.1f ms", phases[idx].name, phases[idx].start_us / 1000.0);
+        }
+    }
+    ESP_LOGI(TAG, "  end of the last phase: %.1f ms", end_us / 1000.0);
+}
+
+/*
+ * @brief Clear the phase table (e.g. to profile the wake-up path after a deep sleep separately).
+ */
+void mjd_boot_reset(void) {
+    _BOOT_LOCK();
+    memset(_phases, 0, sizeof(_phases));
+    _nbr_of_phases = 0;
+    _nbr_of_dropped = 0;
+    _BOOT_UNLOCK();
+}
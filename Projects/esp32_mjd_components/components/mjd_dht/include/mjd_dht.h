@@ -0,0 +1,99 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+#ifndef __MJD_DHT_H__
+#define __MJD_DHT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Includes: system, own
+ */
+#include "mjd.h"
+
+/*
+ * Sensor settings
+ *
+ * @doc DHT11, DHT22 (AM2302) of Aosong: custom 1-Wire protocol.
+ *      The MCU pulls the data line LOW for 18 millisec (the start signal) and releases it (the pullup pulls it HIGH).
+ *      The sensor responds with LOW 80us + HIGH 80us and sends 40 bits MSB first: LOW 50us + HIGH 26-28us (bit 0) or HIGH 70us (bit 1).
+ *      Data: humidity (2 bytes) + temperature (2 bytes) + checksum (1 byte = the low byte of the sum of the 4 data bytes).
+ * @doc The start signal is timed by a one-shot esp_timer and the pulse train is captured by the RMT RX peripheral:
+ *      no busy-waiting and no critical sections. Each sensor has its own GPIO and RMT channel so sensors can be read concurrently.
+ */
+#define MJD_DHT_NBR_OF_BITS (40)
+#define MJD_DHT_MAX_NBR_OF_SENSORS (RMT_CHANNEL_MAX)
+
+/**
+ * Data structs
+ */
+typedef enum {
+    MJD_DHT_TYPE_DHT11 = 0,
+    MJD_DHT_TYPE_DHT22, /*!< Also AM2302 */
+    MJD_DHT_TYPE_MAX
+} mjd_dht_type_t;
+
+typedef struct {
+        mjd_dht_type_t type;
+        gpio_num_t gpio_num; /*!< The data pin of the sensor (with an external pullup resistor) */
+        rmt_channel_t rmt_channel; /*!< A dedicated RMT channel per sensor */
+} mjd_dht_config_t;
+
+#define MJD_DHT_CONFIG_DEFAULT() { \
+    .type = MJD_DHT_TYPE_DHT22, \
+    .gpio_num = GPIO_NUM_MAX, \
+    .rmt_channel = RMT_CHANNEL_MAX, \
+}
+
+typedef struct {
+        float humidity_percent;
+        float temperature_celsius;
+} mjd_dht_data_t;
+
+/**
+ * Function declarations
+ */
+esp_err_t mjd_dht_init(const mjd_dht_config_t* param_ptr_config);
+esp_err_t mjd_dht_deinit(const mjd_dht_config_t* param_ptr_config);
+
+/**
+ * @brief Read one sensor (one attempt, no retries).
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_TIMEOUT No pulse train received
+ *     - MJD_ERR_INVALID_DATA Not enough data bits
+ *     - MJD_ERR_CHECKSUM
+ */
+esp_err_t mjd_dht_read(const mjd_dht_config_t* param_ptr_config, mjd_dht_data_t* param_ptr_data);
+
+/**
+ * @brief Read several sensors concurrently: one start signal for all of them, the RMT channels capture the pulse trains in parallel.
+ *
+ * @param param_ptr_retvals The result per sensor (see mjd_dht_read())
+ *
+ * @return
+ *     - ESP_OK All sensors have been read
+ *     - ESP_FAIL At least one sensor failed (see param_ptr_retvals)
+ *     - ESP_ERR_INVALID_ARG
+ */
+esp_err_t mjd_dht_read_multiple(const mjd_dht_config_t* param_ptr_configs, uint32_t param_nbr_of_sensors, mjd_dht_data_t* param_ptr_datas,
+                                esp_err_t* param_ptr_retvals);
+
+/**
+ * @brief Decode the RMT RX items of one pulse train (pure function).
+ *
+ * @doc The data bits are the last MJD_DHT_NBR_OF_BITS HIGH pulses of the frame, so it does not matter
+ *      if the capture starts with the released line, the response LOW or the response HIGH.
+ */
+esp_err_t mjd_dht_decode_items(mjd_dht_type_t param_type, const rmt_item32_t* param_ptr_items, size_t param_nbr_of_items,
+                               mjd_dht_data_t* param_ptr_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_DHT_H__ */
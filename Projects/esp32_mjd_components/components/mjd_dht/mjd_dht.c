@@ -0,0 +1,359 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+
+/*
+ * Includes: system, own
+ */
+#include "esp_timer.h"
+
+#include "mjd_dht.h"
+#include "mjd_trace.h"
+
+/*
+ * Logging
+ */
+static const char TAG[] = "mjd_dht";
+
+/*
+ * Sensor settings
+ */
+#define MJD_DHT_START_SIGNAL_US        (18 * 1000) // DHT11: min 18 millisec. DHT22: 1..20 millisec.
+#define MJD_DHT_BIT_THRESHOLD_US       (48)        // HIGH 26-28us = bit 0, HIGH 70us = bit 1
+#define MJD_DHT_MAX_HIGH_US            (100)       // A longer HIGH level is the idle line (not a bit)
+#define MJD_DHT_RMT_IDLE_THRESHOLD_US  (1000)      // The receive process stops 1 millisec after the last edge
+#define MJD_DHT_RMT_RX_BUFFER_SIZE     (1000)
+
+/*
+ * PRIVATE DATA TYPES
+ */
+typedef struct {
+    const mjd_dht_config_t* ptr_configs;
+    uint32_t nbr_of_sensors;
+} mjd_dht_start_signal_t;
+
+/**************************************
+ * PRIVATE STATIC.
+ *
+ * @brief The one-shot esp_timer callback that ends the start signal: arm the RMT receivers and release the data lines.
+ *
+ * @doc The sensor responds 20-40us after the release. The RMT receiver is armed first so it captures the full pulse train.
+ */
+static void _start_signal_end_callback(void* param_ptr_arg) {
+    const mjd_dht_start_signal_t* ptr_start_signal = (const mjd_dht_start_signal_t*) param_ptr_arg;
+
+    for (uint32_t idx = 0; idx < ptr_start_signal->nbr_of_sensors; idx++) {
+        rmt_rx_start(ptr_start_signal->ptr_configs[idx].rmt_channel, true);
+        gpio_set_direction(ptr_start_signal->ptr_configs[idx].gpio_num, GPIO_MODE_INPUT);
+    }
+}
+
+/*********************************************************************************
+ * PUBLIC.
+ *
+ * @brief RMT receiver initialization
+ *
+ * @doc RMT source clock = APB Clock 80Mhz. If we divide the base clock by 80 (giving 1Mhz) then the granularity unit becomes 1 microsecond.
+ *
+ *********************************************************************************/
+esp_err_t mjd_dht_init(const mjd_dht_config_t* param_ptr_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_config == NULL || param_ptr_config->type >= MJD_DHT_TYPE_MAX || param_ptr_config->gpio_num >= GPIO_NUM_MAX
+            || param_ptr_config->rmt_channel >= RMT_CHANNEL_MAX) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid config | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // GPIO: the data line idles HIGH (external pullup + internal pullup)
+    f_retval = gpio_set_direction(param_ptr_config->gpio_num, GPIO_MODE_INPUT);
+    if (f_retval == ESP_OK) {
+        f_retval = gpio_pullup_en(param_ptr_config->gpio_num);
+    }
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. gpio_set_direction() | gpio_pullup_en() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // RMT
+    rmt_config_t rmt_rx =
+        { 0 };
+    rmt_rx.gpio_num = param_ptr_config->gpio_num;
+    rmt_rx.channel = param_ptr_config->rmt_channel;
+    rmt_rx.rmt_mode = RMT_MODE_RX;
+    rmt_rx.clk_div = esp_clk_apb_freq() / 1000000; // 1 tick = 1 MICROsec
+    rmt_rx.mem_block_num = 1; // 64 items: the frame has +-43 items
+    rmt_rx.rx_config.filter_en = false;
+    rmt_rx.rx_config.filter_ticks_thresh = 0;
+    rmt_rx.rx_config.idle_threshold = MJD_DHT_RMT_IDLE_THRESHOLD_US;
+    f_retval = rmt_config(&rmt_rx);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. rmt_config() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    f_retval = rmt_driver_install(rmt_rx.channel, MJD_DHT_RMT_RX_BUFFER_SIZE, 0);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. rmt_driver_install() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_dht_deinit(const mjd_dht_config_t* param_ptr_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    f_retval = rmt_driver_uninstall(param_ptr_config->rmt_channel);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. rmt_driver_uninstall() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*********************************************************************************
+ * PUBLIC.
+ *
+ * @brief Decode the pulse train
+ *
+ * @rules
+ *      HIGH <= MJD_DHT_BIT_THRESHOLD_US : bitvalue=0
+ *      HIGH >  MJD_DHT_BIT_THRESHOLD_US : bitvalue=1
+ *      HIGH >  MJD_DHT_MAX_HIGH_US      : the idle line (skipped)
+ *      duration 0                       : the end marker of the RMT frame
+ *********************************************************************************/
+esp_err_t mjd_dht_decode_items(mjd_dht_type_t param_type, const rmt_item32_t* param_ptr_items, size_t param_nbr_of_items,
+                               mjd_dht_data_t* param_ptr_data) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    uint32_t high_durations_us[MJD_DHT_NBR_OF_BITS]; // Ring buffer: the last 40 HIGH pulses
+    uint32_t nbr_of_highs = 0;
+    uint8_t bytes[MJD_DHT_NBR_OF_BITS / 8] =
+        { 0 };
+
+    param_ptr_data->humidity_percent = 0.0;
+    param_ptr_data->temperature_celsius = 0.0;
+
+    // DEBUG Dump
+    ESP_LOGD(TAG, "  nbr_of_items = %u", param_nbr_of_items);
+    for (size_t idx = 0; idx < param_nbr_of_items; idx++) {
+        ESP_LOGV(TAG, "  %2u :: [level 0]: %1d - %5d us, [level 1]: %1d - %5d us", idx, param_ptr_items[idx].level0,
+                param_ptr_items[idx].duration0, param_ptr_items[idx].level1, param_ptr_items[idx].duration1);
+    }
+
+    for (size_t idx = 0; idx < param_nbr_of_items * 2; idx++) {
+        const rmt_item32_t* ptr_item = &param_ptr_items[idx / 2];
+        uint32_t level = (idx % 2 == 0) ? ptr_item->level0 : ptr_item->level1;
+        uint32_t duration_us = (idx % 2 == 0) ? ptr_item->duration0 : ptr_item->duration1;
+
+        if (duration_us == 0) {
+            break; // End marker
+        }
+        if (level == 1 && duration_us <= MJD_DHT_MAX_HIGH_US) {
+            high_durations_us[nbr_of_highs % MJD_DHT_NBR_OF_BITS] = duration_us;
+            ++nbr_of_highs;
+        }
+    }
+
+    if (nbr_of_highs < MJD_DHT_NBR_OF_BITS) {
+        f_retval = MJD_ERR_INVALID_DATA;
+        ESP_LOGE(TAG, "%s(). ABORT. Not enough data bits (%u) | err %i (%s)", __FUNCTION__, nbr_of_highs, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // The oldest of the last 40 HIGH pulses is at [nbr_of_highs % 40]
+    for (uint32_t idx_bit = 0; idx_bit < MJD_DHT_NBR_OF_BITS; idx_bit++) {
+        uint32_t duration_us = high_durations_us[(nbr_of_highs + idx_bit) % MJD_DHT_NBR_OF_BITS];
+        bytes[idx_bit / 8] = (bytes[idx_bit / 8] << 1) | ((duration_us > MJD_DHT_BIT_THRESHOLD_US) ? 1 : 0);
+    }
+
+    if (((bytes[0] + bytes[1] + bytes[2] + bytes[3]) & 0xFF) != bytes[4]) {
+        f_retval = MJD_ERR_CHECKSUM;
+        ESP_LOGE(TAG, "%s(). ABORT. Checksum failure %02X %02X %02X %02X %02X | err %i (%s)", __FUNCTION__, bytes[0], bytes[1], bytes[2],
+                bytes[3], bytes[4], f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    if (param_type == MJD_DHT_TYPE_DHT22) {
+        // Unit 0.1. Temperature bit15 = sign (1 => negative)
+        param_ptr_data->humidity_percent = 0.1 * ((bytes[0] << 8) | bytes[1]);
+        param_ptr_data->temperature_celsius = 0.1 * (((bytes[2] & 0x7F) << 8) | bytes[3]);
+        if ((bytes[2] & 0x80) != 0) {
+            param_ptr_data->temperature_celsius = -param_ptr_data->temperature_celsius;
+        }
+    } else {
+        // Integral byte + decimal byte. Temperature decimal byte bit7 = sign (1 => negative, DHT11 V1.3)
+        param_ptr_data->humidity_percent = bytes[0] + (0.1 * bytes[1]);
+        param_ptr_data->temperature_celsius = bytes[2] + (0.1 * (bytes[3] & 0x7F));
+        if ((bytes[3] & 0x80) != 0) {
+            param_ptr_data->temperature_celsius = -param_ptr_data->temperature_celsius;
+        }
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*********************************************************************************
+ * PUBLIC.
+ *
+ * @brief Read several sensors concurrently
+ *
+ * @doc 1. Pull all data lines LOW.
+ *      2. A one-shot esp_timer ends the start signal after MJD_DHT_START_SIGNAL_US (it arms the RMT receivers and releases the lines).
+ *      3. The task sleeps in xRingbufferReceive() while the RMT receivers capture the pulse trains.
+ *      4. Stop the RMT receivers, release the data lines and drain the ring buffers.
+ *********************************************************************************/
+esp_err_t mjd_dht_read_multiple(const mjd_dht_config_t* param_ptr_configs, uint32_t param_nbr_of_sensors, mjd_dht_data_t* param_ptr_datas,
+                                esp_err_t* param_ptr_retvals) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    RingbufHandle_t rbs[MJD_DHT_MAX_NBR_OF_SENSORS] =
+        { NULL };
+    esp_timer_handle_t timer_handle = NULL;
+    mjd_dht_start_signal_t start_signal =
+        { .ptr_configs = param_ptr_configs, .nbr_of_sensors = param_nbr_of_sensors };
+
+    if (param_ptr_configs == NULL || param_ptr_datas == NULL || param_ptr_retvals == NULL || param_nbr_of_sensors == 0
+            || param_nbr_of_sensors > MJD_DHT_MAX_NBR_OF_SENSORS) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param (nbr_of_sensors 1..%u) | err %i (%s)", __FUNCTION__, MJD_DHT_MAX_NBR_OF_SENSORS, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // 1. Pull the data lines LOW
+    for (uint32_t idx = 0; idx < param_nbr_of_sensors; idx++) {
+        const mjd_dht_config_t* ptr_config = &param_ptr_configs[idx];
+
+        param_ptr_datas[idx].humidity_percent = 0.0;
+        param_ptr_datas[idx].temperature_celsius = 0.0;
+        param_ptr_retvals[idx] = ESP_OK;
+
+        rmt_rx_stop(ptr_config->rmt_channel);
+        if (rmt_get_ringbuf_handle(ptr_config->rmt_channel, &rbs[idx]) != ESP_OK || rbs[idx] == NULL) {
+            param_ptr_retvals[idx] = MJD_ERR_ESP_RMT;
+            ESP_LOGE(TAG, "%s(). rmt_get_ringbuf_handle() sensor #%u | err %i (%s)", __FUNCTION__, idx, param_ptr_retvals[idx],
+                    esp_err_to_name(param_ptr_retvals[idx]));
+            continue;
+        }
+
+        gpio_set_direction(ptr_config->gpio_num, GPIO_MODE_OUTPUT);
+        gpio_set_level(ptr_config->gpio_num, 0);
+    }
+
+    // 2. The start signal
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_RMT_SENSOR_READ);
+    const esp_timer_create_args_t timer_args =
+        { .callback = &_start_signal_end_callback, .arg = &start_signal, .dispatch_method = ESP_TIMER_TASK, .name = "mjd_dht" };
+
+    f_retval = esp_timer_create(&timer_args, &timer_handle);
+    if (f_retval == ESP_OK) {
+        f_retval = esp_timer_start_once(timer_handle, MJD_DHT_START_SIGNAL_US);
+    }
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. esp_timer failed | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        for (uint32_t idx = 0; idx < param_nbr_of_sensors; idx++) {
+            param_ptr_retvals[idx] = f_retval;
+        }
+        // GOTO
+        goto cleanup;
+    }
+
+    // 3. Collect the pulse trains
+    for (uint32_t idx = 0; idx < param_nbr_of_sensors; idx++) {
+        size_t rx_size = 0;
+        rmt_item32_t* ptr_items;
+
+        if (param_ptr_retvals[idx] != ESP_OK) {
+            continue;
+        }
+        ptr_items = (rmt_item32_t*) xRingbufferReceive(rbs[idx], &rx_size, RTOS_DELAY_100MILLISEC);
+        if (ptr_items == NULL) {
+            param_ptr_retvals[idx] = ESP_ERR_TIMEOUT;
+            ESP_LOGE(TAG, "%s(). xRingbufferReceive() sensor #%u | err %i (%s)", __FUNCTION__, idx, param_ptr_retvals[idx],
+                    esp_err_to_name(param_ptr_retvals[idx]));
+            continue;
+        }
+        param_ptr_retvals[idx] = mjd_dht_decode_items(param_ptr_configs[idx].type, ptr_items, rx_size / sizeof(rmt_item32_t),
+                &param_ptr_datas[idx]);
+        vRingbufferReturnItem(rbs[idx], (void*) ptr_items);
+    }
+    MJD_TRACE_END(MJD_TRACE_PROBE_RMT_SENSOR_READ);
+
+    for (uint32_t idx = 0; idx < param_nbr_of_sensors; idx++) {
+        if (param_ptr_retvals[idx] != ESP_OK) {
+            f_retval = ESP_FAIL;
+        }
+    }
+
+    // LABEL
+    cleanup: ;
+
+    if (timer_handle != NULL) {
+        esp_timer_stop(timer_handle); // The start signal did not end yet (error handling)
+        esp_timer_delete(timer_handle);
+    }
+    if (f_retval != ESP_ERR_INVALID_ARG) {
+        for (uint32_t idx = 0; idx < param_nbr_of_sensors; idx++) {
+            size_t rx_size = 0;
+            void* ptr_stale;
+
+            rmt_rx_stop(param_ptr_configs[idx].rmt_channel);
+            gpio_set_direction(param_ptr_configs[idx].gpio_num, GPIO_MODE_INPUT); // Always release the data line
+
+            // Drain the trailing frames (line noise after the pulse train) so the next read starts with an empty ring buffer
+            while (rbs[idx] != NULL && (ptr_stale = xRingbufferReceive(rbs[idx], &rx_size, 0)) != NULL) {
+                vRingbufferReturnItem(rbs[idx], ptr_stale);
+            }
+        }
+    }
+
+    return f_retval;
+}
+
+/*********************************************************************************
+ * PUBLIC.
+ *
+ * @brief Read one sensor
+ *********************************************************************************/
+esp_err_t mjd_dht_read(const mjd_dht_config_t* param_ptr_config, mjd_dht_data_t* param_ptr_data) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    esp_err_t sensor_retval = ESP_OK;
+
+    f_retval = mjd_dht_read_multiple(param_ptr_config, 1, param_ptr_data, &sensor_retval);
+    if (f_retval != ESP_ERR_INVALID_ARG) {
+        f_retval = sensor_retval;
+    }
+
+    return f_retval;
+}
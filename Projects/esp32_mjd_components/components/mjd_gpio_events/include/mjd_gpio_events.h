@@ -0,0 +1,98 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+#ifndef __MJD_GPIO_EVENTS_H__
+#define __MJD_GPIO_EVENTS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mjd_gpio_events_core.h"
+
+/**********
+ * SETTINGS
+ *
+ * @important The hardware timer must not be used by another component:
+ *            TIMER_GROUP_0 TIMER_0 = mjd_mlx90393, TIMER_GROUP_0 TIMER_1 = mjd_ads1115, TIMER_GROUP_1 TIMER_1 = mjd_wifi_sniffer.
+ */
+#define MJD_GPIO_EVENTS_TIMER_GROUP_ID   (TIMER_GROUP_1) // TODO Move this to KConfig.
+#define MJD_GPIO_EVENTS_TIMER_ID         (TIMER_0) // TODO Move this to KConfig.
+#define MJD_GPIO_EVENTS_TICK_US          (1000)  /*!< The debounce resolution: the timer ISR checks the settling pins every ... */
+
+#define MJD_GPIO_EVENTS_MAX_PINS         (8)
+#define MJD_GPIO_EVENTS_MAX_SUBSCRIBERS  (8)
+
+/**
+ * @brief The configuration of an input pin.
+ */
+typedef struct {
+    gpio_num_t gpio_num;
+    gpio_pullup_t pull_up_en;
+    gpio_pulldown_t pull_down_en;
+    uint32_t debounce_ms; /*!< The level must be stable for ... after the last edge. 0 = no debouncing (still 1 tick resolution) */
+} mjd_gpio_events_pin_config_t;
+
+#define MJD_GPIO_EVENTS_PIN_CONFIG_DEFAULT() { \
+    .gpio_num = GPIO_NUM_MAX, \
+    .pull_up_en = GPIO_PULLUP_DISABLE, \
+    .pull_down_en = GPIO_PULLDOWN_DISABLE, \
+    .debounce_ms = 50 \
+}
+
+/**
+ * @brief The statistics of a subscriber.
+ */
+typedef struct {
+    uint32_t nbr_of_events_queued;
+    uint32_t nbr_of_events_dropped; /*!< The queue of the subscriber was full */
+} mjd_gpio_events_subscriber_stats_t;
+
+/**
+ * @brief The configuration of a subscriber.
+ */
+typedef struct {
+    uint64_t pin_bit_mask;   /*!< The pins of interest: (1ULL << GPIO_NUM_14) | ... */
+    gpio_int_type_t edge;    /*!< GPIO_INTR_POSEDGE GPIO_INTR_NEGEDGE GPIO_INTR_ANYEDGE */
+    uint32_t queue_length;   /*!< Events buffered for the subscriber task. Rounded up to a power of 2 */
+} mjd_gpio_events_subscriber_config_t;
+
+#define MJD_GPIO_EVENTS_SUBSCRIBER_CONFIG_DEFAULT() { \
+    .pin_bit_mask = 0, \
+    .edge = GPIO_INTR_ANYEDGE, \
+    .queue_length = 16 \
+}
+
+/**
+ * @brief A subscriber. Owned by the app (static memory); initialize it with mjd_gpio_events_subscribe(). All fields are Private.
+ *
+ * @rule 1 subscriber = 1 consumer task (the event queue is single producer - single consumer).
+ */
+typedef struct {
+    mjd_gpio_events_subscriber_config_t config;
+    mjd_gpio_events_queue_t queue;         /*!< Private: filled by the timer ISR */
+    SemaphoreHandle_t wakeup_semaphore;    /*!< Private: given by the timer ISR after queueing (the events themselves are in the queue) */
+    mjd_gpio_events_subscriber_stats_t stats;
+} mjd_gpio_events_subscriber_t;
+
+/**
+ * Function declarations
+ */
+esp_err_t mjd_gpio_events_init(void);
+esp_err_t mjd_gpio_events_deinit(void);
+esp_err_t mjd_gpio_events_add_pin(const mjd_gpio_events_pin_config_t* param_ptr_pin_config);
+esp_err_t mjd_gpio_events_remove_pin(gpio_num_t param_gpio_num);
+esp_err_t mjd_gpio_events_get_pin_stats(gpio_num_t param_gpio_num, mjd_gpio_events_pin_stats_t* param_ptr_stats);
+
+esp_err_t mjd_gpio_events_subscribe(mjd_gpio_events_subscriber_t* param_ptr_subscriber, const mjd_gpio_events_subscriber_config_t* param_ptr_config);
+esp_err_t mjd_gpio_events_unsubscribe(mjd_gpio_events_subscriber_t* param_ptr_subscriber);
+esp_err_t mjd_gpio_events_receive(mjd_gpio_events_subscriber_t* param_ptr_subscriber, mjd_gpio_events_event_t* param_ptr_event,
+                                  TickType_t param_ticks_to_wait);
+esp_err_t mjd_gpio_events_get_subscriber_stats(mjd_gpio_events_subscriber_t* param_ptr_subscriber, mjd_gpio_events_subscriber_stats_t* param_ptr_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_GPIO_EVENTS_H__ */
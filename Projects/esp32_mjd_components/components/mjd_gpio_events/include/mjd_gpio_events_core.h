@@ -0,0 +1,91 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+#ifndef __MJD_GPIO_EVENTS_CORE_H__
+#define __MJD_GPIO_EVENTS_CORE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * DEBOUNCER + EVENT QUEUE
+ *
+ * @doc Pure logic (no GPIO, no timer, no RTOS) so the host tests can drive it with simulated edges and time:
+ *      - The GPIO ISR calls mjd_gpio_events_debounce_edge() for every raw edge (only a timestamp + a counter: no level read).
+ *      - The timer ISR calls mjd_gpio_events_debounce_tick() every tick with the current level of the pin.
+ *        When the pin has been quiet for debounce_us the burst of edges is settled:
+ *        level changed = 1 event (timestamp of the first edge), level unchanged = a glitch (no event).
+ *      - The timer ISR pushes the event in the queue of every interested subscriber: mjd_gpio_events_queue_push().
+ * @doc The queue is a lock-free ring buffer for 1 producer (the timer ISR) and 1 consumer (the subscriber task):
+ *      the producer only writes head, the consumer only writes tail. No critical section, the ISR never blocks.
+ */
+
+/**
+ * @brief A debounced edge.
+ */
+typedef struct {
+    gpio_num_t gpio_num;
+    uint8_t level;                   /*!< The stable level after the edge: 1 = rising edge, 0 = falling edge */
+    uint16_t nbr_of_coalesced_edges; /*!< The bounces that were merged into this event */
+    uint32_t sequence;               /*!< Per pin, +1 per debounced event: a gap = events that this subscriber did not receive (filtered or dropped) */
+    int64_t timestamp_us;            /*!< esp_timer_get_time() of the FIRST edge of the burst (not the time it settled) */
+} mjd_gpio_events_event_t;
+
+/**
+ * @brief The statistics of a pin.
+ */
+typedef struct {
+    uint32_t nbr_of_edges;           /*!< Raw edges seen by the GPIO ISR */
+    uint32_t nbr_of_events;          /*!< Debounced events */
+    uint32_t nbr_of_coalesced_edges; /*!< Edges merged into an event (bounces) or dropped as a glitch (a pulse shorter than debounce_ms) */
+    uint32_t nbr_of_glitches;        /*!< Bursts that settled at the previous level (no event) */
+} mjd_gpio_events_pin_stats_t;
+
+/**
+ * @brief The debouncer of 1 pin. All fields are Private except stats.
+ */
+typedef struct {
+    gpio_num_t gpio_num;
+    uint32_t debounce_us;
+    uint8_t stable_level;
+    bool is_settling;           /*!< Private: edges seen, waiting for debounce_us of silence */
+    uint32_t nbr_of_burst_edges; /*!< Private */
+    int64_t first_edge_us;      /*!< Private */
+    int64_t last_edge_us;       /*!< Private */
+    uint32_t sequence;          /*!< Private */
+    mjd_gpio_events_pin_stats_t stats;
+} mjd_gpio_events_debounce_t;
+
+/**
+ * @brief The event queue of 1 subscriber. All fields are Private.
+ */
+typedef struct {
+    mjd_gpio_events_event_t *ptr_events; /*!< capacity slots */
+    uint32_t capacity;                   /*!< A power of 2 */
+    volatile uint32_t head;              /*!< Written by the producer only: free running, slot = head & (capacity - 1) */
+    volatile uint32_t tail;              /*!< Written by the consumer only */
+} mjd_gpio_events_queue_t;
+
+/**
+ * Function declarations
+ */
+void mjd_gpio_events_debounce_init(mjd_gpio_events_debounce_t* param_ptr_debounce, gpio_num_t param_gpio_num, uint32_t param_debounce_us,
+                                   uint8_t param_initial_level);
+void mjd_gpio_events_debounce_edge(mjd_gpio_events_debounce_t* param_ptr_debounce, int64_t param_now_us);
+bool mjd_gpio_events_debounce_tick(mjd_gpio_events_debounce_t* param_ptr_debounce, uint8_t param_level, int64_t param_now_us,
+                                   mjd_gpio_events_event_t* param_ptr_event);
+bool mjd_gpio_events_is_edge_wanted(gpio_int_type_t param_edge, const mjd_gpio_events_event_t* param_ptr_event);
+
+uint32_t mjd_gpio_events_queue_get_capacity(uint32_t param_queue_length);
+esp_err_t mjd_gpio_events_queue_init(mjd_gpio_events_queue_t* param_ptr_queue, mjd_gpio_events_event_t* param_ptr_storage, uint32_t param_capacity);
+bool mjd_gpio_events_queue_push(mjd_gpio_events_queue_t* param_ptr_queue, const mjd_gpio_events_event_t* param_ptr_event);
+bool mjd_gpio_events_queue_pop(mjd_gpio_events_queue_t* param_ptr_queue, mjd_gpio_events_event_t* param_ptr_event);
+uint32_t mjd_gpio_events_queue_get_count(const mjd_gpio_events_queue_t* param_ptr_queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_GPIO_EVENTS_CORE_H__ */
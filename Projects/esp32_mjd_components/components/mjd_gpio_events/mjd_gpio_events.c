@@ -0,0 +1,684 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+#include "driver/timer.h"
+#include "esp_intr_alloc.h"
+#include "esp_timer.h"
+#include "soc/timer_group_struct.h"
+
+// Component header file(s)
+#include "mjd.h"
+#include "mjd_gpio_events.h"
+
+/*
+ * Logging
+ */
+static const char TAG[] = "mjd_gpio_events";
+
+/*
+ * Timer settings
+ *  @doc APB 80MHz / 80 = 1MHz: the counter counts microseconds.
+ */
+#define MY_TIMER_DIVIDER (80)
+
+/*
+ * The hub
+ *  @important The pins, the debouncers and the subscriber table are shared by the GPIO ISR, the timer ISR and the API (tasks):
+ *             they are guarded by _gpio_events_spinlock (the ISR's may run on the other core).
+ *             The API functions are serialized by _gpio_events_service_semaphore.
+ */
+static portMUX_TYPE _gpio_events_spinlock = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t _gpio_events_service_semaphore = NULL;
+
+static uint32_t _gpio_events_init_count = 0;
+static bool _gpio_events_is_isr_service_owner = false;
+static intr_handle_t _gpio_events_timer_isr_handle = NULL;
+
+static bool _gpio_events_pin_is_used[MJD_GPIO_EVENTS_MAX_PINS];
+static mjd_gpio_events_debounce_t _gpio_events_pins[MJD_GPIO_EVENTS_MAX_PINS];
+static uint32_t _gpio_events_settling_mask = 0; // @doc bit = pin slot with a burst of edges that has not settled yet
+static mjd_gpio_events_subscriber_t *_gpio_events_subscribers[MJD_GPIO_EVENTS_MAX_SUBSCRIBERS];
+
+#define MY_SERVICE_LOCK()     xSemaphoreTake(_gpio_events_service_semaphore, portMAX_DELAY)
+#define MY_SERVICE_UNLOCK()   xSemaphoreGive(_gpio_events_service_semaphore)
+
+/*
+ * @important The init count is changed inside both locks (init, deinit). Read it with this function inside the service lock:
+ *            a deinit cannot run between the check and the work of an API function.
+ */
+static uint32_t _get_init_count(void) {
+    uint32_t init_count;
+
+    portENTER_CRITICAL(&_gpio_events_spinlock);
+    init_count = _gpio_events_init_count;
+    portEXIT_CRITICAL(&_gpio_events_spinlock);
+
+    return init_count;
+}
+
+static void _set_init_count(uint32_t param_init_count) {
+    portENTER_CRITICAL(&_gpio_events_spinlock);
+    _gpio_events_init_count = param_init_count;
+    portEXIT_CRITICAL(&_gpio_events_spinlock);
+}
+
+/**************************************
+ * INTERRUPTS
+ *
+ */
+static inline timg_dev_t * _timer_group_dev(void) {
+    return (MJD_GPIO_EVENTS_TIMER_GROUP_ID == TIMER_GROUP_0) ? &TIMERG0 : &TIMERG1;
+}
+
+/*
+ * @brief Run the timer only while a pin is settling: no timer interrupts when the inputs are quiet.
+ * @important Call it inside _gpio_events_spinlock.
+ */
+static inline void IRAM_ATTR _timer_set_running(bool param_is_running) {
+    _timer_group_dev()->hw_timer[MJD_GPIO_EVENTS_TIMER_ID].config.enable = (param_is_running == true) ? 1 : 0;
+}
+
+/*
+ * @brief GPIO ISR (any edge): timestamp + count the raw edge. The level is read by the timer ISR after the pin settled.
+ */
+static void IRAM_ATTR _gpio_isr_handler(void* arg) {
+    uint32_t slot = (uint32_t) (uintptr_t) arg;
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL_ISR(&_gpio_events_spinlock);
+    mjd_gpio_events_debounce_edge(&_gpio_events_pins[slot], now_us);
+    if (_gpio_events_settling_mask == 0) {
+        _timer_set_running(true);
+    }
+    _gpio_events_settling_mask |= (1UL << slot);
+    portEXIT_CRITICAL_ISR(&_gpio_events_spinlock);
+}
+
+/*
+ * @brief Timer ISR (every MJD_GPIO_EVENTS_TICK_US while a pin is settling): debounce + queue the events for the subscribers.
+ */
+static void IRAM_ATTR _timer_isr(void* arg) {
+    timg_dev_t *ptr_timg = _timer_group_dev();
+    int64_t now_us = esp_timer_get_time();
+    mjd_gpio_events_event_t event;
+    SemaphoreHandle_t wakeup_semaphores[MJD_GPIO_EVENTS_MAX_SUBSCRIBERS];
+    uint32_t nbr_of_wakeups = 0;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    // Clear the interrupt + re-arm the alarm (auto reload)
+    if (MJD_GPIO_EVENTS_TIMER_ID == TIMER_0) {
+        ptr_timg->int_clr_timers.t0 = 1;
+    } else {
+        ptr_timg->int_clr_timers.t1 = 1;
+    }
+    ptr_timg->hw_timer[MJD_GPIO_EVENTS_TIMER_ID].config.alarm_en = TIMER_ALARM_EN;
+
+    portENTER_CRITICAL_ISR(&_gpio_events_spinlock);
+    for (uint32_t slot = 0; slot < MJD_GPIO_EVENTS_MAX_PINS; slot++) {
+        if ((_gpio_events_settling_mask & (1UL << slot)) == 0) {
+            continue;
+        }
+        mjd_gpio_events_debounce_t *ptr_pin = &_gpio_events_pins[slot];
+        bool is_event = mjd_gpio_events_debounce_tick(ptr_pin, gpio_get_level(ptr_pin->gpio_num), now_us, &event);
+        if (ptr_pin->is_settling == false) {
+            _gpio_events_settling_mask &= ~(1UL << slot);
+        }
+        if (is_event == false) {
+            continue;
+        }
+        for (uint32_t i = 0; i < MJD_GPIO_EVENTS_MAX_SUBSCRIBERS; i++) {
+            mjd_gpio_events_subscriber_t *ptr_subscriber = _gpio_events_subscribers[i];
+            if (ptr_subscriber == NULL || (ptr_subscriber->config.pin_bit_mask & (1ULL << event.gpio_num)) == 0
+                    || mjd_gpio_events_is_edge_wanted(ptr_subscriber->config.edge, &event) == false) {
+                continue;
+            }
+            if (mjd_gpio_events_queue_push(&ptr_subscriber->queue, &event) == true) {
+                ptr_subscriber->stats.nbr_of_events_queued++;
+                // @doc Copy the handle inside the spinlock: mjd_gpio_events_unsubscribe() may clear the slot right after it
+                uint32_t j;
+                for (j = 0; j < nbr_of_wakeups; j++) {
+                    if (wakeup_semaphores[j] == ptr_subscriber->wakeup_semaphore) {
+                        break;
+                    }
+                }
+                if (j == nbr_of_wakeups) {
+                    wakeup_semaphores[nbr_of_wakeups++] = ptr_subscriber->wakeup_semaphore;
+                }
+            } else {
+                ptr_subscriber->stats.nbr_of_events_dropped++;
+            }
+        }
+    }
+    if (_gpio_events_settling_mask == 0) {
+        _timer_set_running(false);
+    }
+    portEXIT_CRITICAL_ISR(&_gpio_events_spinlock);
+
+    // @important Outside the spinlock, from the local copies (never the subscriber table).
+    //            mjd_gpio_events_unsubscribe() waits for this ISR before it deletes the semaphore (see there).
+    for (uint32_t j = 0; j < nbr_of_wakeups; j++) {
+        xSemaphoreGiveFromISR(wakeup_semaphores[j], &xHigherPriorityTaskWoken);
+    }
+    if (xHigherPriorityTaskWoken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+/*********************************************************************************
+ * PUBLIC.
+ *
+ */
+
+/*
+ * @brief Init the hub. Reference counted: every component that uses the hub calls init + deinit.
+ *
+ * @doc The GPIO ISR service is installed once for all pins. A service that was already installed by the app is reused.
+ */
+esp_err_t mjd_gpio_events_init(void) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    // MUTEX
+    if (!_gpio_events_service_semaphore) {
+        _gpio_events_service_semaphore = xSemaphoreCreateMutex();
+        if (!_gpio_events_service_semaphore) {
+            f_retval = ESP_FAIL;
+            ESP_LOGE(TAG, "%s(). ABORT. xSemaphoreCreateMutex() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+    }
+
+    MY_SERVICE_LOCK();
+
+    if (_get_init_count() > 0) {
+        _set_init_count(_get_init_count() + 1);
+        // GOTO
+        goto unlock;
+    }
+
+    // ISR SERVICE
+    // @doc ESP_INTR_FLAG_LEVEL1 Accept a Level 1 interrupt vector (lowest priority)
+    f_retval = gpio_install_isr_service(ESP_INTR_FLAG_LEVEL1);
+    if (f_retval == ESP_OK) {
+        _gpio_events_is_isr_service_owner = true;
+    } else if (f_retval == ESP_ERR_INVALID_STATE) {
+        ESP_LOGW(TAG, "%s(). The GPIO ISR service was already installed (reused)", __FUNCTION__);
+        _gpio_events_is_isr_service_owner = false;
+        f_retval = ESP_OK;
+    } else {
+        ESP_LOGE(TAG, "%s(). ABORT. gpio_install_isr_service() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto unlock;
+    }
+
+    // TIMER: auto reload alarm every tick, paused until the first edge
+    timer_config_t tconfig = {};
+    tconfig.divider = MY_TIMER_DIVIDER;
+    tconfig.counter_dir = TIMER_COUNT_UP;
+    tconfig.counter_en = TIMER_PAUSE;
+    tconfig.alarm_en = TIMER_ALARM_EN;
+    tconfig.intr_type = TIMER_INTR_LEVEL;
+    tconfig.auto_reload = true;
+    f_retval = timer_init(MJD_GPIO_EVENTS_TIMER_GROUP_ID, MJD_GPIO_EVENTS_TIMER_ID, &tconfig);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. timer_init() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto undo_isr_service;
+    }
+    timer_set_counter_value(MJD_GPIO_EVENTS_TIMER_GROUP_ID, MJD_GPIO_EVENTS_TIMER_ID, 00000000ULL);
+    timer_set_alarm_value(MJD_GPIO_EVENTS_TIMER_GROUP_ID, MJD_GPIO_EVENTS_TIMER_ID, MJD_GPIO_EVENTS_TICK_US);
+    timer_enable_intr(MJD_GPIO_EVENTS_TIMER_GROUP_ID, MJD_GPIO_EVENTS_TIMER_ID);
+    f_retval = timer_isr_register(MJD_GPIO_EVENTS_TIMER_GROUP_ID, MJD_GPIO_EVENTS_TIMER_ID, _timer_isr, NULL, ESP_INTR_FLAG_LEVEL1,
+            &_gpio_events_timer_isr_handle);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. timer_isr_register() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto undo_timer;
+    }
+
+    portENTER_CRITICAL(&_gpio_events_spinlock);
+    _gpio_events_settling_mask = 0;
+    _gpio_events_init_count = 1;
+    portEXIT_CRITICAL(&_gpio_events_spinlock);
+
+    // GOTO (OK)
+    goto unlock;
+
+    // LABEL: undo the steps of a failed init (the hub stays not init'd)
+    undo_timer: ;
+    timer_disable_intr(MJD_GPIO_EVENTS_TIMER_GROUP_ID, MJD_GPIO_EVENTS_TIMER_ID);
+    timer_pause(MJD_GPIO_EVENTS_TIMER_GROUP_ID, MJD_GPIO_EVENTS_TIMER_ID);
+
+    // LABEL
+    undo_isr_service: ;
+    if (_gpio_events_is_isr_service_owner == true) {
+        gpio_uninstall_isr_service(); // @returns void
+        _gpio_events_is_isr_service_owner = false;
+    }
+
+    // LABEL
+    unlock: ;
+    MY_SERVICE_UNLOCK();
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_gpio_events_deinit(void) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (_gpio_events_service_semaphore == NULL) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. The hub was not init'd | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    MY_SERVICE_LOCK();
+
+    if (_get_init_count() == 0) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. The hub was not init'd | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto unlock;
+    }
+    _set_init_count(_get_init_count() - 1);
+    if (_get_init_count() > 0) {
+        // GOTO
+        goto unlock;
+    }
+
+    // TIMER
+    timer_pause(MJD_GPIO_EVENTS_TIMER_GROUP_ID, MJD_GPIO_EVENTS_TIMER_ID);
+    timer_disable_intr(MJD_GPIO_EVENTS_TIMER_GROUP_ID, MJD_GPIO_EVENTS_TIMER_ID);
+    esp_intr_free(_gpio_events_timer_isr_handle);
+    _gpio_events_timer_isr_handle = NULL;
+
+    // PINS
+    for (uint32_t slot = 0; slot < MJD_GPIO_EVENTS_MAX_PINS; slot++) {
+        if (_gpio_events_pin_is_used[slot] == true) {
+            gpio_isr_handler_remove(_gpio_events_pins[slot].gpio_num);
+            portENTER_CRITICAL(&_gpio_events_spinlock);
+            _gpio_events_pin_is_used[slot] = false;
+            portEXIT_CRITICAL(&_gpio_events_spinlock);
+        }
+    }
+    portENTER_CRITICAL(&_gpio_events_spinlock);
+    _gpio_events_settling_mask = 0;
+    portEXIT_CRITICAL(&_gpio_events_spinlock);
+
+    // ISR SERVICE
+    if (_gpio_events_is_isr_service_owner == true) {
+        gpio_uninstall_isr_service(); // @returns void
+        _gpio_events_is_isr_service_owner = false;
+    }
+
+    // LABEL
+    unlock: ;
+    MY_SERVICE_UNLOCK();
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*
+ * @brief Add an input pin: it is configured for any edge interrupts and debounced by the hub.
+ */
+esp_err_t mjd_gpio_events_add_pin(const mjd_gpio_events_pin_config_t* param_ptr_pin_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    uint32_t slot;
+
+    if (param_ptr_pin_config == NULL || param_ptr_pin_config->gpio_num < 0 || param_ptr_pin_config->gpio_num >= GPIO_NUM_MAX) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid args | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (_gpio_events_service_semaphore == NULL) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. Call mjd_gpio_events_init() first | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    MY_SERVICE_LOCK();
+
+    if (_get_init_count() == 0) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. Call mjd_gpio_events_init() first | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto unlock;
+    }
+
+    for (slot = 0; slot < MJD_GPIO_EVENTS_MAX_PINS; slot++) {
+        if (_gpio_events_pin_is_used[slot] == true && _gpio_events_pins[slot].gpio_num == param_ptr_pin_config->gpio_num) {
+            f_retval = ESP_ERR_INVALID_STATE;
+            ESP_LOGE(TAG, "%s(). ABORT. GPIO#%i was already added | err %i (%s)", __FUNCTION__, param_ptr_pin_config->gpio_num, f_retval,
+                    esp_err_to_name(f_retval));
+            // GOTO
+            goto unlock;
+        }
+    }
+    for (slot = 0; slot < MJD_GPIO_EVENTS_MAX_PINS; slot++) {
+        if (_gpio_events_pin_is_used[slot] == false) {
+            break;
+        }
+    }
+    if (slot == MJD_GPIO_EVENTS_MAX_PINS) {
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "%s(). ABORT. Max %u pins | err %i (%s)", __FUNCTION__, MJD_GPIO_EVENTS_MAX_PINS, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto unlock;
+    }
+
+    // GPIO
+    gpio_config_t io_conf = { 0 };
+    io_conf.pin_bit_mask = (1ULL << param_ptr_pin_config->gpio_num);
+    io_conf.mode = GPIO_MODE_INPUT;
+    io_conf.pull_up_en = param_ptr_pin_config->pull_up_en;
+    io_conf.pull_down_en = param_ptr_pin_config->pull_down_en;
+    io_conf.intr_type = GPIO_INTR_ANYEDGE; // @doc Both edges: the hub debounces and the subscribers filter
+    f_retval = gpio_config(&io_conf);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. gpio_config() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto unlock;
+    }
+
+    portENTER_CRITICAL(&_gpio_events_spinlock);
+    mjd_gpio_events_debounce_init(&_gpio_events_pins[slot], param_ptr_pin_config->gpio_num, param_ptr_pin_config->debounce_ms * 1000,
+            gpio_get_level(param_ptr_pin_config->gpio_num));
+    _gpio_events_pin_is_used[slot] = true;
+    portEXIT_CRITICAL(&_gpio_events_spinlock);
+
+    f_retval = gpio_isr_handler_add(param_ptr_pin_config->gpio_num, _gpio_isr_handler, (void *) (uintptr_t) slot);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. gpio_isr_handler_add() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        portENTER_CRITICAL(&_gpio_events_spinlock);
+        _gpio_events_pin_is_used[slot] = false;
+        portEXIT_CRITICAL(&_gpio_events_spinlock);
+        // GOTO
+        goto unlock;
+    }
+
+    ESP_LOGI(TAG, "%s(). GPIO#%i debounce %u ms (slot %u)", __FUNCTION__, param_ptr_pin_config->gpio_num, param_ptr_pin_config->debounce_ms,
+            slot);
+
+    // LABEL
+    unlock: ;
+    MY_SERVICE_UNLOCK();
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_gpio_events_remove_pin(gpio_num_t param_gpio_num) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    uint32_t slot;
+
+    if (_gpio_events_service_semaphore == NULL) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. Call mjd_gpio_events_init() first | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    MY_SERVICE_LOCK();
+
+    if (_get_init_count() == 0) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. Call mjd_gpio_events_init() first | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto unlock;
+    }
+
+    for (slot = 0; slot < MJD_GPIO_EVENTS_MAX_PINS; slot++) {
+        if (_gpio_events_pin_is_used[slot] == true && _gpio_events_pins[slot].gpio_num == param_gpio_num) {
+            break;
+        }
+    }
+    if (slot == MJD_GPIO_EVENTS_MAX_PINS) {
+        f_retval = ESP_ERR_NOT_FOUND;
+        ESP_LOGE(TAG, "%s(). ABORT. GPIO#%i was not added | err %i (%s)", __FUNCTION__, param_gpio_num, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto unlock;
+    }
+
+    gpio_set_intr_type(param_gpio_num, GPIO_INTR_DISABLE);
+    gpio_isr_handler_remove(param_gpio_num);
+
+    portENTER_CRITICAL(&_gpio_events_spinlock);
+    _gpio_events_pin_is_used[slot] = false;
+    _gpio_events_settling_mask &= ~(1UL << slot);
+    portEXIT_CRITICAL(&_gpio_events_spinlock);
+
+    // LABEL
+    unlock: ;
+    MY_SERVICE_UNLOCK();
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_gpio_events_get_pin_stats(gpio_num_t param_gpio_num, mjd_gpio_events_pin_stats_t* param_ptr_stats) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_ERR_NOT_FOUND;
+
+    portENTER_CRITICAL(&_gpio_events_spinlock);
+    for (uint32_t slot = 0; slot < MJD_GPIO_EVENTS_MAX_PINS; slot++) {
+        if (_gpio_events_pin_is_used[slot] == true && _gpio_events_pins[slot].gpio_num == param_gpio_num) {
+            *param_ptr_stats = _gpio_events_pins[slot].stats;
+            f_retval = ESP_OK;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&_gpio_events_spinlock);
+
+    return f_retval;
+}
+
+/*
+ * @brief Subscribe to the debounced events of a set of pins.
+ *
+ * @important The subscriber struct must outlive the subscription (static memory). The queue storage is allocated here (once).
+ */
+esp_err_t mjd_gpio_events_subscribe(mjd_gpio_events_subscriber_t* param_ptr_subscriber, const mjd_gpio_events_subscriber_config_t* param_ptr_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    mjd_gpio_events_event_t *ptr_storage = NULL;
+    uint32_t i;
+
+    if (param_ptr_subscriber == NULL || param_ptr_config == NULL || param_ptr_config->pin_bit_mask == 0 || param_ptr_config->queue_length == 0
+            || (param_ptr_config->edge != GPIO_INTR_POSEDGE && param_ptr_config->edge != GPIO_INTR_NEGEDGE
+                    && param_ptr_config->edge != GPIO_INTR_ANYEDGE)) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid args | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (_gpio_events_service_semaphore == NULL) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. Call mjd_gpio_events_init() first | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    MY_SERVICE_LOCK();
+
+    if (_get_init_count() == 0) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. Call mjd_gpio_events_init() first | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto unlock;
+    }
+
+    for (i = 0; i < MJD_GPIO_EVENTS_MAX_SUBSCRIBERS; i++) {
+        if (_gpio_events_subscribers[i] == NULL) {
+            break;
+        }
+    }
+    if (i == MJD_GPIO_EVENTS_MAX_SUBSCRIBERS) {
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "%s(). ABORT. Max %u subscribers | err %i (%s)", __FUNCTION__, MJD_GPIO_EVENTS_MAX_SUBSCRIBERS, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto unlock;
+    }
+
+    memset(param_ptr_subscriber, 0, sizeof(*param_ptr_subscriber));
+    param_ptr_subscriber->config = *param_ptr_config;
+
+    uint32_t capacity = mjd_gpio_events_queue_get_capacity(param_ptr_config->queue_length);
+    ptr_storage = malloc(capacity * sizeof(mjd_gpio_events_event_t));
+    if (ptr_storage == NULL) {
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "%s(). ABORT. malloc() queue of %u events | err %i (%s)", __FUNCTION__, capacity, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto unlock;
+    }
+    f_retval = mjd_gpio_events_queue_init(&param_ptr_subscriber->queue, ptr_storage, capacity);
+    if (f_retval != ESP_OK) {
+        free(ptr_storage);
+        // GOTO
+        goto unlock;
+    }
+
+    // @doc Binary semaphores created using xSemaphoreCreateBinary() are created in a state such that the semaphore must first be 'given' before it can be 'taken'!
+    param_ptr_subscriber->wakeup_semaphore = xSemaphoreCreateBinary();
+    if (param_ptr_subscriber->wakeup_semaphore == NULL) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). ABORT. xSemaphoreCreateBinary() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        free(ptr_storage);
+        // GOTO
+        goto unlock;
+    }
+
+    portENTER_CRITICAL(&_gpio_events_spinlock);
+    _gpio_events_subscribers[i] = param_ptr_subscriber;
+    portEXIT_CRITICAL(&_gpio_events_spinlock);
+
+    // LABEL
+    unlock: ;
+    MY_SERVICE_UNLOCK();
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_gpio_events_unsubscribe(mjd_gpio_events_subscriber_t* param_ptr_subscriber) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_ERR_NOT_FOUND;
+
+    if (_gpio_events_service_semaphore == NULL) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. The hub was not init'd | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    MY_SERVICE_LOCK();
+
+    for (uint32_t i = 0; i < MJD_GPIO_EVENTS_MAX_SUBSCRIBERS; i++) {
+        if (_gpio_events_subscribers[i] == param_ptr_subscriber) {
+            portENTER_CRITICAL(&_gpio_events_spinlock);
+            _gpio_events_subscribers[i] = NULL;
+            portEXIT_CRITICAL(&_gpio_events_spinlock);
+            f_retval = ESP_OK;
+            break;
+        }
+    }
+    if (f_retval == ESP_OK) {
+        // @important A timer ISR that is running right now may have copied the semaphore handle before the slot was cleared
+        //            and still give it: wait 1 tick (>> the duration of the ISR) before deleting it
+        vTaskDelay(1);
+        vSemaphoreDelete(param_ptr_subscriber->wakeup_semaphore);
+        param_ptr_subscriber->wakeup_semaphore = NULL;
+        free(param_ptr_subscriber->queue.ptr_events);
+        param_ptr_subscriber->queue.ptr_events = NULL;
+    }
+
+    MY_SERVICE_UNLOCK();
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*
+ * @brief Receive the next event of the subscriber (FIFO).
+ *
+ * @return
+ *     - ESP_OK An event
+ *     - ESP_ERR_TIMEOUT No event within param_ticks_to_wait
+ */
+esp_err_t mjd_gpio_events_receive(mjd_gpio_events_subscriber_t* param_ptr_subscriber, mjd_gpio_events_event_t* param_ptr_event,
+                                  TickType_t param_ticks_to_wait) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_subscriber == NULL || param_ptr_event == NULL || param_ptr_subscriber->wakeup_semaphore == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid args | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // @doc The semaphore is only a wakeup: an event queued between the pop and the take gives it again, so nothing is missed.
+    //      A give for an event that was already popped makes the next take return at once with an empty queue: try again.
+    while (mjd_gpio_events_queue_pop(&param_ptr_subscriber->queue, param_ptr_event) == false) {
+        if (xSemaphoreTake(param_ptr_subscriber->wakeup_semaphore, param_ticks_to_wait) != pdTRUE) {
+            f_retval = ESP_ERR_TIMEOUT;
+            // GOTO
+            goto cleanup;
+        }
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_gpio_events_get_subscriber_stats(mjd_gpio_events_subscriber_t* param_ptr_subscriber, mjd_gpio_events_subscriber_stats_t* param_ptr_stats) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_subscriber == NULL || param_ptr_stats == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid args | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    portENTER_CRITICAL(&_gpio_events_spinlock);
+    *param_ptr_stats = param_ptr_subscriber->stats;
+    portEXIT_CRITICAL(&_gpio_events_spinlock);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
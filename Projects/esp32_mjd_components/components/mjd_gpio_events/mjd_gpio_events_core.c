@@ -0,0 +1,174 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+
+// Component header file(s)
+#include "mjd.h"
+#include "mjd_gpio_events_core.h"
+
+/*
+ * Logging
+ */
+static const char TAG[] = "mjd_gpio_events_core";
+
+/**************************************
+ * DEBOUNCER
+ *
+ * @important IRAM_ATTR: called from the GPIO ISR and the timer ISR.
+ */
+void mjd_gpio_events_debounce_init(mjd_gpio_events_debounce_t* param_ptr_debounce, gpio_num_t param_gpio_num, uint32_t param_debounce_us,
+                                   uint8_t param_initial_level) {
+    memset(param_ptr_debounce, 0, sizeof(*param_ptr_debounce));
+    param_ptr_debounce->gpio_num = param_gpio_num;
+    param_ptr_debounce->debounce_us = param_debounce_us;
+    param_ptr_debounce->stable_level = param_initial_level;
+}
+
+/*
+ * @brief A raw edge (GPIO ISR). Each edge restarts the debounce window.
+ */
+void IRAM_ATTR mjd_gpio_events_debounce_edge(mjd_gpio_events_debounce_t* param_ptr_debounce, int64_t param_now_us) {
+    if (param_ptr_debounce->is_settling == false) {
+        param_ptr_debounce->is_settling = true;
+        param_ptr_debounce->first_edge_us = param_now_us;
+        param_ptr_debounce->nbr_of_burst_edges = 0;
+    }
+    param_ptr_debounce->last_edge_us = param_now_us;
+    param_ptr_debounce->nbr_of_burst_edges++;
+    param_ptr_debounce->stats.nbr_of_edges++;
+}
+
+/*
+ * @brief The periodic check (timer ISR).
+ *
+ * @param param_level The current level of the pin.
+ *
+ * @return true when the burst settled at a new level: param_ptr_event has been filled.
+ */
+bool IRAM_ATTR mjd_gpio_events_debounce_tick(mjd_gpio_events_debounce_t* param_ptr_debounce, uint8_t param_level, int64_t param_now_us,
+                                             mjd_gpio_events_event_t* param_ptr_event) {
+    if (param_ptr_debounce->is_settling == false) {
+        return false;
+    }
+    if (param_now_us - param_ptr_debounce->last_edge_us < (int64_t) param_ptr_debounce->debounce_us) {
+        return false;
+    }
+
+    param_ptr_debounce->is_settling = false;
+
+    if (param_level == param_ptr_debounce->stable_level) {
+        // A pulse shorter than the debounce window (noise, a contact that bounced back)
+        param_ptr_debounce->stats.nbr_of_glitches++;
+        param_ptr_debounce->stats.nbr_of_coalesced_edges += param_ptr_debounce->nbr_of_burst_edges;
+        return false;
+    }
+
+    param_ptr_debounce->stable_level = param_level;
+    param_ptr_debounce->sequence++;
+    param_ptr_debounce->stats.nbr_of_events++;
+    param_ptr_debounce->stats.nbr_of_coalesced_edges += param_ptr_debounce->nbr_of_burst_edges - 1;
+
+    param_ptr_event->gpio_num = param_ptr_debounce->gpio_num;
+    param_ptr_event->level = param_level;
+    param_ptr_event->nbr_of_coalesced_edges = (param_ptr_debounce->nbr_of_burst_edges - 1 > UINT16_MAX) ?
+            UINT16_MAX : (uint16_t) (param_ptr_debounce->nbr_of_burst_edges - 1);
+    param_ptr_event->sequence = param_ptr_debounce->sequence;
+    param_ptr_event->timestamp_us = param_ptr_debounce->first_edge_us;
+
+    return true;
+}
+
+bool IRAM_ATTR mjd_gpio_events_is_edge_wanted(gpio_int_type_t param_edge, const mjd_gpio_events_event_t* param_ptr_event) {
+    switch (param_edge) {
+    case GPIO_INTR_POSEDGE:
+        return (param_ptr_event->level == 1);
+    case GPIO_INTR_NEGEDGE:
+        return (param_ptr_event->level == 0);
+    case GPIO_INTR_ANYEDGE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**************************************
+ * EVENT QUEUE (single producer - single consumer)
+ *
+ * @doc head and tail are free running counters: count = head - tail (also correct after the uint32 wrap).
+ * @doc The release store of head publishes the slot that was written before it; the acquire load of head by the consumer sees that slot.
+ */
+
+/*
+ * @brief The capacity for the requested queue length: the next power of 2 (min 2).
+ */
+uint32_t mjd_gpio_events_queue_get_capacity(uint32_t param_queue_length) {
+    uint32_t capacity = 2;
+
+    while (capacity < param_queue_length && capacity < (1UL << 16)) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+esp_err_t mjd_gpio_events_queue_init(mjd_gpio_events_queue_t* param_ptr_queue, mjd_gpio_events_event_t* param_ptr_storage, uint32_t param_capacity) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_queue == NULL || param_ptr_storage == NULL || param_capacity < 2 || (param_capacity & (param_capacity - 1)) != 0) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid args (capacity %u must be a power of 2) | err %i (%s)", __FUNCTION__, param_capacity, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    param_ptr_queue->ptr_events = param_ptr_storage;
+    param_ptr_queue->capacity = param_capacity;
+    param_ptr_queue->head = 0;
+    param_ptr_queue->tail = 0;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*
+ * @brief Producer (timer ISR). Never blocks.
+ *
+ * @return false when the queue is full (the event is dropped).
+ */
+bool IRAM_ATTR mjd_gpio_events_queue_push(mjd_gpio_events_queue_t* param_ptr_queue, const mjd_gpio_events_event_t* param_ptr_event) {
+    uint32_t head = param_ptr_queue->head;
+    uint32_t tail = __atomic_load_n(&param_ptr_queue->tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail >= param_ptr_queue->capacity) {
+        return false;
+    }
+    param_ptr_queue->ptr_events[head & (param_ptr_queue->capacity - 1)] = *param_ptr_event;
+    __atomic_store_n(&param_ptr_queue->head, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+/*
+ * @brief Consumer (the subscriber task).
+ *
+ * @return false when the queue is empty.
+ */
+bool mjd_gpio_events_queue_pop(mjd_gpio_events_queue_t* param_ptr_queue, mjd_gpio_events_event_t* param_ptr_event) {
+    uint32_t tail = param_ptr_queue->tail;
+    uint32_t head = __atomic_load_n(&param_ptr_queue->head, __ATOMIC_ACQUIRE);
+
+    if (head == tail) {
+        return false;
+    }
+    *param_ptr_event = param_ptr_queue->ptr_events[tail & (param_ptr_queue->capacity - 1)];
+    __atomic_store_n(&param_ptr_queue->tail, tail + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+uint32_t mjd_gpio_events_queue_get_count(const mjd_gpio_events_queue_t* param_ptr_queue) {
+    return __atomic_load_n(&param_ptr_queue->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&param_ptr_queue->tail, __ATOMIC_ACQUIRE);
+}
@@ -8,19 +8,22 @@
 extern "C" {
 #endif
 
+#include "mjd_gpio_events.h"
+
 /**
  * Data structs
  */
 typedef struct {
     bool is_init;
     gpio_num_t data_gpio_num;
-    SemaphoreHandle_t gpio_isr_mux;
+    uint32_t debounce_ms;                    /*!< Handled by mjd_gpio_events */
+    mjd_gpio_events_subscriber_t subscriber; /*!< Private */
 } mjd_hcsr501_config_t;
 
 #define MJD_HCSR501_CONFIG_DEFAULT() { \
     .is_init = false, \
     .data_gpio_num = GPIO_NUM_0, \
-    .gpio_isr_mux = NULL \
+    .debounce_ms = 50 \
 }
 
 /**
@@ -28,6 +31,7 @@ typedef struct {
  */
 esp_err_t mjd_hcsr501_init(mjd_hcsr501_config_t* ptr_param_config);
 esp_err_t mjd_hcsr501_deinit(mjd_hcsr501_config_t* ptr_param_config);
+esp_err_t mjd_hcsr501_wait_for_detection(mjd_hcsr501_config_t* ptr_param_config, mjd_gpio_events_event_t* param_ptr_event, TickType_t param_ticks_to_wait);
 
 #ifdef __cplusplus
 }
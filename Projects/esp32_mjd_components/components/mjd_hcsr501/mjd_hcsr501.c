@@ -12,22 +12,6 @@
  */
 static const char TAG[] = "mjd_hcsr501";
 
-/*
- * INTERRUPT
- */
-static SemaphoreHandle_t _hcsr501_config_gpio_isr_mux;
-
-void IRAM_ATTR sensor_gpio_isr_handler(void* arg) {
-    // @param pxHigherPriorityTaskWoken to pdTRUE if giving the semaphore caused a task to unblock, and the unblocked task has a priority higher than the currently running task.
-    //        If xSemaphoreGiveFromISR() sets this value to pdTRUE then a context switch should be requested before the interrupt is exited.
-    //        portYIELD_FROM_ISR() wakes up the imu_task immediately (instead of on next FreeRTOS tick).
-    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-    xSemaphoreGiveFromISR(_hcsr501_config_gpio_isr_mux, &xHigherPriorityTaskWoken);
-    if (xHigherPriorityTaskWoken == pdTRUE) {
-        portYIELD_FROM_ISR();
-    }
-}
-
 /*********************************************************************************
  * PUBLIC.
  *
@@ -50,46 +34,37 @@ esp_err_t mjd_hcsr501_init(mjd_hcsr501_config_t* param_ptr_config) {
     // todo Production: increase it to 60 seconds
     vTaskDelay(RTOS_DELAY_5SEC);
 
-    // Semaphore
-    // !Clone locally (so the ISR can reference the semaphore handle).
-    // @doc Binary semaphores created using xSemaphoreCreateBinary() are created in a state such that the semaphore must first be 'given' before it can be 'taken'!
-    // @doc The required RAM is automatically allocated from the FreeRTOS heap (opposed the local stack!).
-    param_ptr_config->gpio_isr_mux = xSemaphoreCreateBinary();
-    if (param_ptr_config->gpio_isr_mux == NULL) {
-        f_retval = ESP_FAIL;
-        ESP_LOGE(TAG, "ABORT. xSemaphoreCreateBinary() failed (insufficient FreeRTOS heap available) | err %i %s", f_retval,
-                esp_err_to_name(f_retval));
+    // HUB (1 GPIO ISR service for all components)
+    f_retval = mjd_gpio_events_init();
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "ABORT. mjd_gpio_events_init() failed | err %i %s", f_retval, esp_err_to_name(f_retval));
         // GOTO
         goto cleanup;
     }
-    _hcsr501_config_gpio_isr_mux = param_ptr_config->gpio_isr_mux;
 
     // GPIO
-    //   @doc GPIO_INTR_POSEDGE = GPIO interrupt type: rising edge (LOW->HIGH)
-    gpio_config_t io_conf = { 0 };
-    io_conf.pin_bit_mask = (1ULL << param_ptr_config->data_gpio_num);
-    io_conf.mode = GPIO_MODE_INPUT;
-    io_conf.pull_up_en = GPIO_PULLUP_ENABLE; // @important HC-SR501 data pin
-    io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
-    io_conf.intr_type = GPIO_INTR_POSEDGE; // @validvalues GPIO_INTR_DISABLE GPIO_INTR_ANYEDGE GPIO_INTR_NEGEDGE GPIO_INTR_POSEDGE
-    f_retval = gpio_config(&io_conf);
+    //   @doc Subscribe to GPIO_INTR_POSEDGE = rising edge (LOW->HIGH) = motion detected
+    mjd_gpio_events_pin_config_t pin_config = MJD_GPIO_EVENTS_PIN_CONFIG_DEFAULT();
+    pin_config.gpio_num = param_ptr_config->data_gpio_num;
+    pin_config.pull_up_en = GPIO_PULLUP_ENABLE; // @important HC-SR501 data pin
+    pin_config.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    pin_config.debounce_ms = param_ptr_config->debounce_ms;
+    f_retval = mjd_gpio_events_add_pin(&pin_config);
     if (f_retval != ESP_OK) {
-        ESP_LOGE(TAG, "ABORT. gpio_config() failed | err %i %s", f_retval, esp_err_to_name(f_retval));
+        ESP_LOGE(TAG, "ABORT. mjd_gpio_events_add_pin() failed | err %i %s", f_retval, esp_err_to_name(f_retval));
+        mjd_gpio_events_deinit();
         // GOTO
         goto cleanup;
     }
 
-    // ISR
-    // @doc ESP_INTR_FLAG_LEVEL1 Accept a Level 1 interrupt vector (lowest priority)
-    f_retval = gpio_install_isr_service(ESP_INTR_FLAG_LEVEL1);
+    mjd_gpio_events_subscriber_config_t subscriber_config = MJD_GPIO_EVENTS_SUBSCRIBER_CONFIG_DEFAULT();
+    subscriber_config.pin_bit_mask = (1ULL << param_ptr_config->data_gpio_num);
+    subscriber_config.edge = GPIO_INTR_POSEDGE;
+    f_retval = mjd_gpio_events_subscribe(&param_ptr_config->subscriber, &subscriber_config);
     if (f_retval != ESP_OK) {
-        ESP_LOGE(TAG, "ABORT. gpio_install_isr_service() failed | err %i %s", f_retval, esp_err_to_name(f_retval));
-        // GOTO
-        goto cleanup;
-    }
-    f_retval = gpio_isr_handler_add(param_ptr_config->data_gpio_num, sensor_gpio_isr_handler, NULL);
-    if (f_retval != ESP_OK) {
-        ESP_LOGE(TAG, "ABORT. gpio_isr_handler_add() failed | err %i %s", f_retval, esp_err_to_name(f_retval));
+        ESP_LOGE(TAG, "ABORT. mjd_gpio_events_subscribe() failed | err %i %s", f_retval, esp_err_to_name(f_retval));
+        mjd_gpio_events_remove_pin(param_ptr_config->data_gpio_num);
+        mjd_gpio_events_deinit();
         // GOTO
         goto cleanup;
     }
@@ -116,18 +91,25 @@ esp_err_t mjd_hcsr501_deinit(mjd_hcsr501_config_t* param_ptr_config) {
         goto cleanup;
     }
 
-    // ISR
-    f_retval = gpio_isr_handler_remove(param_ptr_config->data_gpio_num);
+    // HUB
+    f_retval = mjd_gpio_events_unsubscribe(&param_ptr_config->subscriber);
     if (f_retval != ESP_OK) {
-        ESP_LOGE(TAG, "ABORT. gpio_isr_handler_remove() failed | err %i %s", f_retval, esp_err_to_name(f_retval));
+        ESP_LOGE(TAG, "ABORT. mjd_gpio_events_unsubscribe() failed | err %i %s", f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    f_retval = mjd_gpio_events_remove_pin(param_ptr_config->data_gpio_num);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "ABORT. mjd_gpio_events_remove_pin() failed | err %i %s", f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    f_retval = mjd_gpio_events_deinit();
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "ABORT. mjd_gpio_events_deinit() failed | err %i %s", f_retval, esp_err_to_name(f_retval));
         // GOTO
         goto cleanup;
     }
-    gpio_uninstall_isr_service(); // @returns void
-
-    // SEMAPHORE
-    param_ptr_config->gpio_isr_mux = NULL;
-    _hcsr501_config_gpio_isr_mux = param_ptr_config->gpio_isr_mux;
 
     // Mark OK
     param_ptr_config->is_init = false;
@@ -137,3 +119,31 @@ esp_err_t mjd_hcsr501_deinit(mjd_hcsr501_config_t* param_ptr_config) {
 
     return f_retval;
 }
+
+/*
+ * @brief Block until the sensor detects motion (a debounced rising edge).
+ *
+ * @doc The detections are queued: none are lost when the app task is busy for a while.
+ *
+ * @return
+ *     - ESP_OK param_ptr_event = the detection (timestamp_us = the time of the rising edge)
+ *     - ESP_ERR_TIMEOUT No detection within param_ticks_to_wait
+ */
+esp_err_t mjd_hcsr501_wait_for_detection(mjd_hcsr501_config_t* param_ptr_config, mjd_gpio_events_event_t* param_ptr_event, TickType_t param_ticks_to_wait) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_config->is_init == false) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "ABORT. mjd_hcsr501_wait_for_detection() component was not init'd | err %i %s", f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    f_retval = mjd_gpio_events_receive(&param_ptr_config->subscriber, param_ptr_event, param_ticks_to_wait);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
@@ -0,0 +1,168 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+#ifndef __MJD_HTTP_H__
+#define __MJD_HTTP_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Includes: system, own
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#include "mjd_http_parser.h"
+
+/**********
+ * SETTINGS
+ */
+#define MJD_HTTP_HOST_MAX_LEN (63)
+#define MJD_HTTP_TX_HEAD_BUFFER_SIZE (512) /*!< The request line + the headers of 1 request */
+#define MJD_HTTP_MAX_PIPELINE_DEPTH (16)
+
+/**
+ * @brief The configuration of a client. 1 client = 1 server (host:port) = max 1 open connection.
+ */
+typedef struct {
+    const char *host;          /*!< A host name or an IPv4 address */
+    uint16_t port;
+    uint32_t timeout_ms;       /*!< The connect, send and receive timeout */
+    bool is_keep_alive;        /*!< Reuse the connection for the next request (HTTP/1.1 persistent connection) */
+    uint32_t pipeline_depth;   /*!< mjd_http_post_pipelined(): the max number of requests in flight (1..MJD_HTTP_MAX_PIPELINE_DEPTH) */
+} mjd_http_config_t;
+
+#define MJD_HTTP_CONFIG_DEFAULT() { \
+    .host = NULL, \
+    .port = 80, \
+    .timeout_ms = 10000, \
+    .is_keep_alive = true, \
+    .pipeline_depth = 4, \
+}
+
+/**
+ * @brief The metrics of the last request.
+ *
+ * @doc The heap churn is measured with the free heap (ESP32) or the allocated bytes of malloc (Linux) before the request,
+ *      after the response head and after the body: the peak is what the request needed on top, the delta is what it did not give back.
+ */
+typedef struct {
+    uint64_t connect_us;       /*!< 0 = the connection was reused */
+    uint64_t ttfb_us;          /*!< Time to first byte: from sending the request until the first byte of the response */
+    uint64_t total_us;         /*!< Until the last byte of the body */
+    uint64_t bytes_sent;
+    uint64_t bytes_received;   /*!< The raw bytes (head + framing + body) */
+    bool is_reused;
+    int32_t heap_peak_bytes;
+    int32_t heap_delta_bytes;
+    int status_code;
+} mjd_http_request_stats_t;
+
+/**
+ * @brief The cumulative counters of a client.
+ */
+typedef struct {
+    uint32_t nbr_of_requests;
+    uint32_t nbr_of_connects;
+    uint32_t nbr_of_reuses;
+    uint32_t nbr_of_stale_retries; /*!< A reused connection that the server had closed meanwhile (the request was sent again) */
+    uint32_t nbr_of_errors;
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+} mjd_http_stats_t;
+
+/**
+ * @brief The client. The caller owns the memory (static, stack or heap): the client itself never allocates.
+ *
+ * @important The fields are private: use the functions.
+ */
+typedef struct {
+    mjd_http_config_t config;
+    char host[MJD_HTTP_HOST_MAX_LEN + 1];
+    int socket;                           /*!< -1 = not connected */
+    uint32_t nbr_of_requests_on_connection;
+    mjd_http_parser_t parser;
+    bool is_response_pending;             /*!< A response (head or body) was not read completely */
+    uint8_t rx_buffer[CONFIG_MJD_HTTP_RX_BUFFER_SIZE];
+    size_t rx_pos;
+    size_t rx_len;
+    char tx_head[MJD_HTTP_TX_HEAD_BUFFER_SIZE];
+    int64_t request_start_us;
+    int64_t request_sent_us;
+    int64_t heap_in_use_start;
+    mjd_http_request_stats_t last_request_stats;
+    mjd_http_stats_t stats;
+} mjd_http_client_t;
+
+/**
+ * @brief A request body of mjd_http_post_pipelined().
+ */
+typedef struct {
+    const void *ptr_data;
+    size_t len;
+} mjd_http_body_t;
+
+/**
+ * @brief The download callback of mjd_http_download(): called for each filled buffer. Return false to stop the download.
+ */
+typedef bool (*mjd_http_download_cb_t)(const uint8_t * param_ptr_data, size_t param_len, void * param_ptr_arg);
+
+/**
+ * @brief The result of mjd_http_benchmark().
+ */
+typedef struct {
+    uint32_t nbr_of_requests;
+    uint32_t nbr_of_errors;
+    uint32_t nbr_of_connects;
+    uint64_t bytes_received;   /*!< The body bytes */
+    uint64_t total_us;
+    float kbytes_per_sec;      /*!< The body bytes / the total time (connects included) */
+    uint64_t ttfb_min_us;
+    uint64_t ttfb_avg_us;
+    uint64_t ttfb_max_us;
+    int32_t heap_peak_max_bytes;
+    int32_t heap_delta_sum_bytes; /*!< > 0 = a leak (or a cache that grows) */
+} mjd_http_benchmark_result_t;
+
+/**
+ * Function declarations
+ *
+ * @important A client is for 1 task.
+ * @important mjd_http_get() returns after the response head: read the body with mjd_http_read() until it returns 0 bytes.
+ *            A body that is not read completely is discarded by closing the connection at the next request.
+ */
+esp_err_t mjd_http_init(mjd_http_client_t* param_ptr_client, const mjd_http_config_t* param_ptr_config);
+esp_err_t mjd_http_deinit(mjd_http_client_t* param_ptr_client);
+
+esp_err_t mjd_http_get(mjd_http_client_t* param_ptr_client, const char * param_ptr_path, int64_t param_range_start,
+                       int64_t param_range_end, mjd_http_response_t* param_ptr_response);
+esp_err_t mjd_http_read(mjd_http_client_t* param_ptr_client, uint8_t * param_ptr_buf, size_t param_len, size_t * param_ptr_len);
+
+esp_err_t mjd_http_download_range(mjd_http_client_t* param_ptr_client, const char * param_ptr_path, uint64_t param_offset,
+                                  uint8_t * param_ptr_buf, size_t param_len, size_t * param_ptr_received);
+esp_err_t mjd_http_download(mjd_http_client_t* param_ptr_client, const char * param_ptr_path, uint8_t * param_ptr_buf,
+                            size_t param_buf_size, mjd_http_download_cb_t param_cb, void * param_ptr_arg);
+
+esp_err_t mjd_http_post_pipelined(mjd_http_client_t* param_ptr_client, const char * param_ptr_path, const char * param_ptr_content_type,
+                                  const mjd_http_body_t * param_ptr_bodies, uint32_t param_nbr_of_bodies, int * param_ptr_status_codes);
+
+esp_err_t mjd_http_benchmark(mjd_http_client_t* param_ptr_client, const char * param_ptr_path, uint32_t param_nbr_of_requests,
+                             uint8_t * param_ptr_buf, size_t param_buf_size, mjd_http_benchmark_result_t* param_ptr_result);
+void mjd_http_log_benchmark(const char * param_ptr_label, const mjd_http_benchmark_result_t* param_ptr_result);
+
+esp_err_t mjd_http_get_last_request_stats(const mjd_http_client_t* param_ptr_client, mjd_http_request_stats_t* param_ptr_stats);
+esp_err_t mjd_http_get_stats(const mjd_http_client_t* param_ptr_client, mjd_http_stats_t* param_ptr_stats);
+void mjd_http_log_stats(const mjd_http_client_t* param_ptr_client);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_HTTP_H__ */
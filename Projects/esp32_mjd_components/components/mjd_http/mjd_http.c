@@ -0,0 +1,909 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+
+#include <errno.h>
+
+#include "lwip/netdb.h"
+#include "lwip/sockets.h"
+
+#include "esp_timer.h"
+
+#ifndef ESP_PLATFORM
+#include <malloc.h>
+#endif
+
+// Component header file(s)
+#include "mjd.h"
+#include "mjd_http.h"
+
+/**********
+ * Logging
+ */
+static const char TAG[] = "mjd_http";
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL (0) // lwip: no SIGPIPE
+#endif
+
+/*
+ * @doc The discard buffer of the responses that are not returned to the caller (pipelined POST).
+ */
+#define _DISCARD_BUFFER_SIZE (64)
+
+/**********
+ * PRIVATE: CLOCK + HEAP
+ *
+ * @doc The host backend (unit tests, benchmarks against the local stand-in server) uses the real monotonic clock and the malloc
+ *      counters of glibc: the simulated esp_timer_get_time() of the shims does not advance while waiting for a socket.
+ */
+static int64_t _now_us(void) {
+#ifdef ESP_PLATFORM
+    return esp_timer_get_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+static int64_t _heap_in_use(void) {
+#ifdef ESP_PLATFORM
+    return -(int64_t) esp_get_free_heap_size();
+#else
+    return (int64_t) mallinfo2().uordblks;
+#endif
+}
+
+static void _sample_heap(mjd_http_client_t* param_ptr_client) {
+    int64_t delta = _heap_in_use() - param_ptr_client->heap_in_use_start;
+
+    if (delta > param_ptr_client->last_request_stats.heap_peak_bytes) {
+        param_ptr_client->last_request_stats.heap_peak_bytes = (int32_t) delta;
+    }
+    param_ptr_client->last_request_stats.heap_delta_bytes = (int32_t) delta;
+}
+
+/**********
+ * PRIVATE: CONNECTION
+ */
+static void _close(mjd_http_client_t* param_ptr_client) {
+    if (param_ptr_client->socket >= 0) {
+        close(param_ptr_client->socket);
+    }
+    param_ptr_client->socket = -1;
+    param_ptr_client->nbr_of_requests_on_connection = 0;
+    param_ptr_client->is_response_pending = false;
+    param_ptr_client->rx_pos = 0;
+    param_ptr_client->rx_len = 0;
+}
+
+static esp_err_t _connect(mjd_http_client_t* param_ptr_client) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    struct addrinfo hints = { 0 };
+    struct addrinfo *ptr_addrinfo = NULL;
+    char port[8];
+    struct timeval timeout;
+    int nodelay = 1;
+    int64_t start_us = _now_us();
+
+    _close(param_ptr_client);
+
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(port, sizeof(port), "%u", param_ptr_client->config.port);
+    if (getaddrinfo(param_ptr_client->host, port, &hints, &ptr_addrinfo) != 0 || ptr_addrinfo == NULL) {
+        f_retval = ESP_ERR_NOT_FOUND;
+        ESP_LOGE(TAG, "%s(). ABORT. getaddrinfo() failed | host %s | err %i (%s)", __FUNCTION__, param_ptr_client->host, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    param_ptr_client->socket = socket(ptr_addrinfo->ai_family, ptr_addrinfo->ai_socktype, 0);
+    if (param_ptr_client->socket < 0) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). ABORT. socket() failed | errno %i | err %i (%s)", __FUNCTION__, errno, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    timeout.tv_sec = param_ptr_client->config.timeout_ms / 1000;
+    timeout.tv_usec = (param_ptr_client->config.timeout_ms % 1000) * 1000;
+    setsockopt(param_ptr_client->socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(param_ptr_client->socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    // @doc The request head and its body are separate sends: do not let Nagle wait for the ACK of the head.
+    setsockopt(param_ptr_client->socket, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    if (connect(param_ptr_client->socket, ptr_addrinfo->ai_addr, ptr_addrinfo->ai_addrlen) != 0) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). ABORT. connect() failed | %s:%u | errno %i | err %i (%s)", __FUNCTION__, param_ptr_client->host,
+                param_ptr_client->config.port, errno, f_retval, esp_err_to_name(f_retval));
+        _close(param_ptr_client);
+        // GOTO
+        goto cleanup;
+    }
+
+    param_ptr_client->stats.nbr_of_connects++;
+    param_ptr_client->last_request_stats.connect_us += _now_us() - start_us;
+
+    // LABEL
+    cleanup: ;
+
+    if (ptr_addrinfo != NULL) {
+        freeaddrinfo(ptr_addrinfo);
+    }
+
+    return f_retval;
+}
+
+/*
+ * @brief Is the idle connection still open? A server closes an idle keep-alive connection after its own timeout (5s..2min),
+ *        the FIN is already in the receive queue then: a non-blocking peek sees it without waiting.
+ */
+static bool _is_connection_alive(mjd_http_client_t* param_ptr_client) {
+    uint8_t byte;
+    int len = recv(param_ptr_client->socket, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+
+    if (len < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+    return false; // 0 = closed by the server, > 0 = unexpected bytes (not in sync with the requests)
+}
+
+/*
+ * @brief Reuse the open connection when possible, else connect.
+ */
+static esp_err_t _ensure_connection(mjd_http_client_t* param_ptr_client, bool * param_ptr_is_reused) {
+    *param_ptr_is_reused = false;
+
+    if (param_ptr_client->is_response_pending == true) {
+        ESP_LOGD(TAG, "%s(). The previous response was not read completely: close the connection", __FUNCTION__);
+        _close(param_ptr_client);
+    }
+    if (param_ptr_client->socket >= 0 && param_ptr_client->rx_pos == param_ptr_client->rx_len
+            && _is_connection_alive(param_ptr_client) == true) {
+        *param_ptr_is_reused = true;
+        return ESP_OK;
+    }
+    return _connect(param_ptr_client);
+}
+
+static esp_err_t _send_all(mjd_http_client_t* param_ptr_client, const void * param_ptr_data, size_t param_len) {
+    const uint8_t *ptr = param_ptr_data;
+
+    while (param_len > 0) {
+        int len = send(param_ptr_client->socket, ptr, param_len, MSG_NOSIGNAL);
+        if (len <= 0) {
+            ESP_LOGD(TAG, "%s(). send() failed | errno %i", __FUNCTION__, errno);
+            return ESP_FAIL;
+        }
+        ptr += len;
+        param_len -= len;
+        param_ptr_client->last_request_stats.bytes_sent += len;
+        param_ptr_client->stats.bytes_sent += len;
+    }
+    return ESP_OK;
+}
+
+/*
+ * @brief Receive into param_ptr_buf.
+ *
+ * @return The number of bytes. 0 = the server closed the connection. -1 = a timeout or an error.
+ */
+static int _recv(mjd_http_client_t* param_ptr_client, uint8_t * param_ptr_buf, size_t param_len) {
+    int len = recv(param_ptr_client->socket, param_ptr_buf, param_len, 0);
+
+    if (len < 0) {
+        ESP_LOGE(TAG, "%s(). recv() failed (timeout?) | errno %i", __FUNCTION__, errno);
+        return -1;
+    }
+    if (len > 0) {
+        if (param_ptr_client->last_request_stats.ttfb_us == 0) {
+            param_ptr_client->last_request_stats.ttfb_us = _now_us() - param_ptr_client->request_sent_us;
+        }
+        param_ptr_client->last_request_stats.bytes_received += len;
+        param_ptr_client->stats.bytes_received += len;
+    }
+    return len;
+}
+
+/*
+ * @brief Append the next bytes of the connection to the rx buffer.
+ */
+static int _recv_into_rx_buffer(mjd_http_client_t* param_ptr_client) {
+    if (param_ptr_client->rx_pos == param_ptr_client->rx_len) {
+        param_ptr_client->rx_pos = 0;
+        param_ptr_client->rx_len = 0;
+    } else if (param_ptr_client->rx_pos > 0) {
+        memmove(param_ptr_client->rx_buffer, &param_ptr_client->rx_buffer[param_ptr_client->rx_pos],
+                param_ptr_client->rx_len - param_ptr_client->rx_pos);
+        param_ptr_client->rx_len -= param_ptr_client->rx_pos;
+        param_ptr_client->rx_pos = 0;
+    }
+
+    int len = _recv(param_ptr_client, &param_ptr_client->rx_buffer[param_ptr_client->rx_len],
+            sizeof(param_ptr_client->rx_buffer) - param_ptr_client->rx_len);
+    if (len > 0) {
+        param_ptr_client->rx_len += len;
+    }
+    return len;
+}
+
+/**********
+ * PRIVATE: REQUEST + RESPONSE
+ */
+static void _start_request(mjd_http_client_t* param_ptr_client) {
+    memset(&param_ptr_client->last_request_stats, 0, sizeof(param_ptr_client->last_request_stats));
+    param_ptr_client->request_start_us = _now_us();
+    param_ptr_client->request_sent_us = param_ptr_client->request_start_us;
+    param_ptr_client->heap_in_use_start = _heap_in_use();
+}
+
+static void _finish_request(mjd_http_client_t* param_ptr_client) {
+    _sample_heap(param_ptr_client);
+    param_ptr_client->last_request_stats.total_us = _now_us() - param_ptr_client->request_start_us;
+    param_ptr_client->last_request_stats.status_code = param_ptr_client->parser.response.status_code;
+    param_ptr_client->is_response_pending = false;
+    if (param_ptr_client->config.is_keep_alive == false || param_ptr_client->parser.response.is_keep_alive == false) {
+        _close(param_ptr_client);
+    }
+}
+
+/*
+ * @brief The request head. param_content_length < 0 = no body.
+ */
+static esp_err_t _format_head(mjd_http_client_t* param_ptr_client, const char * param_ptr_method, const char * param_ptr_path,
+                              int64_t param_range_start, int64_t param_range_end, const char * param_ptr_content_type,
+                              int64_t param_content_length, size_t * param_ptr_len) {
+    char *ptr = param_ptr_client->tx_head;
+    size_t size = sizeof(param_ptr_client->tx_head);
+    int len;
+
+    len = snprintf(ptr, size, "%s %s HTTP/1.1\r\nHost: %s", param_ptr_method, param_ptr_path, param_ptr_client->host);
+    if (len > 0 && param_ptr_client->config.port != 80 && (size_t) len < size) {
+        len += snprintf(ptr + len, size - len, ":%u", param_ptr_client->config.port);
+    }
+    if (len > 0 && param_range_start >= 0 && (size_t) len < size) {
+        if (param_range_end >= param_range_start) {
+            len += snprintf(ptr + len, size - len, "\r\nRange: bytes=%" PRIi64 "-%" PRIi64, param_range_start, param_range_end);
+        } else {
+            len += snprintf(ptr + len, size - len, "\r\nRange: bytes=%" PRIi64 "-", param_range_start);
+        }
+    }
+    if (len > 0 && param_content_length >= 0 && (size_t) len < size) {
+        len += snprintf(ptr + len, size - len, "\r\nContent-Type: %s\r\nContent-Length: %" PRIi64,
+                (param_ptr_content_type != NULL) ? param_ptr_content_type : "application/octet-stream", param_content_length);
+    }
+    if (len > 0 && param_ptr_client->config.is_keep_alive == false && (size_t) len < size) {
+        len += snprintf(ptr + len, size - len, "\r\nConnection: close");
+    }
+    if (len > 0 && (size_t) len < size) {
+        len += snprintf(ptr + len, size - len, "\r\n\r\n");
+    }
+    if (len <= 0 || (size_t) len >= size) {
+        ESP_LOGE(TAG, "%s(). ABORT. The request head does not fit in %u bytes (path too long?)", __FUNCTION__, size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *param_ptr_len = (size_t) len;
+    return ESP_OK;
+}
+
+/*
+ * @brief Receive + parse until the end of the response head.
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_STATE The server closed the connection before the first byte of the response (a stale keep-alive connection)
+ *     - ESP_ERR_INVALID_RESPONSE
+ *     - ESP_ERR_TIMEOUT
+ */
+static esp_err_t _read_head(mjd_http_client_t* param_ptr_client, bool param_is_head_request) {
+    esp_err_t f_retval = ESP_OK;
+
+    mjd_http_parser_init(&param_ptr_client->parser, param_is_head_request);
+    param_ptr_client->is_response_pending = true;
+
+    while (param_ptr_client->parser.is_head_complete == false) {
+        if (param_ptr_client->rx_pos < param_ptr_client->rx_len) {
+            const uint8_t *ptr_body;
+            size_t body_len, consumed;
+            f_retval = mjd_http_parser_execute(&param_ptr_client->parser, &param_ptr_client->rx_buffer[param_ptr_client->rx_pos],
+                    param_ptr_client->rx_len - param_ptr_client->rx_pos, 0, &consumed, &ptr_body, &body_len);
+            param_ptr_client->rx_pos += consumed;
+            if (f_retval != ESP_OK) {
+                return f_retval;
+            }
+            continue;
+        }
+
+        bool is_first_byte = (param_ptr_client->parser.state == MJD_HTTP_PARSER_STATE_STATUS_LINE
+                && param_ptr_client->parser.line_len == 0);
+        int len = _recv_into_rx_buffer(param_ptr_client);
+        if (len < 0) {
+            return ESP_ERR_TIMEOUT;
+        }
+        if (len == 0) {
+            return (is_first_byte == true) ? ESP_ERR_INVALID_STATE : ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+
+    _sample_heap(param_ptr_client);
+    if (mjd_http_parser_is_done(&param_ptr_client->parser) == true) {
+        _finish_request(param_ptr_client);
+    }
+
+    return ESP_OK;
+}
+
+/**********
+ * PUBLIC
+ */
+
+/*
+ * @brief Init the client. It does not connect yet: the first request does.
+ */
+esp_err_t mjd_http_init(mjd_http_client_t* param_ptr_client, const mjd_http_config_t* param_ptr_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_client == NULL || param_ptr_config == NULL || param_ptr_config->host == NULL
+            || strlen(param_ptr_config->host) > MJD_HTTP_HOST_MAX_LEN || param_ptr_config->pipeline_depth == 0
+            || param_ptr_config->pipeline_depth > MJD_HTTP_MAX_PIPELINE_DEPTH) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param (host, pipeline_depth) | err %i (%s)", __FUNCTION__, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    memset(param_ptr_client, 0, sizeof(*param_ptr_client));
+    param_ptr_client->config = *param_ptr_config;
+    strcpy(param_ptr_client->host, param_ptr_config->host);
+    param_ptr_client->config.host = param_ptr_client->host;
+    param_ptr_client->socket = -1;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_http_deinit(mjd_http_client_t* param_ptr_client) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    if (param_ptr_client == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    _close(param_ptr_client);
+
+    return ESP_OK;
+}
+
+/*
+ * @brief Send a GET request and read the response head. The body follows with mjd_http_read().
+ *
+ * @param param_range_start -1 = the whole resource, else the first byte of a Range request
+ * @param param_range_end   The last byte (inclusive) of the Range request, -1 = until the end
+ *
+ * @doc A reused connection that the server closed in the meantime is detected before sending (a peek) or, when the FIN crosses
+ *      the request, because the response is empty: the request is sent again once on a new connection (GET is idempotent).
+ */
+esp_err_t mjd_http_get(mjd_http_client_t* param_ptr_client, const char * param_ptr_path, int64_t param_range_start,
+                       int64_t param_range_end, mjd_http_response_t* param_ptr_response) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    size_t head_len;
+    bool is_reused = false;
+
+    if (param_ptr_client == NULL || param_ptr_path == NULL || param_ptr_response == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    _start_request(param_ptr_client);
+    param_ptr_client->stats.nbr_of_requests++;
+
+    f_retval = _format_head(param_ptr_client, "GET", param_ptr_path, param_range_start, param_range_end, NULL, -1, &head_len);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+
+    for (uint32_t attempt = 0; attempt < 2; attempt++) {
+        f_retval = _ensure_connection(param_ptr_client, &is_reused);
+        if (f_retval != ESP_OK) {
+            // GOTO
+            goto cleanup;
+        }
+
+        param_ptr_client->request_sent_us = _now_us();
+        f_retval = _send_all(param_ptr_client, param_ptr_client->tx_head, head_len);
+        if (f_retval == ESP_OK) {
+            f_retval = _read_head(param_ptr_client, false);
+        }
+        if (f_retval != ESP_OK && is_reused == true && (f_retval == ESP_FAIL || f_retval == ESP_ERR_INVALID_STATE)) {
+            ESP_LOGD(TAG, "%s(). The reused connection was stale: send the request again on a new connection", __FUNCTION__);
+            param_ptr_client->stats.nbr_of_stale_retries++;
+            _close(param_ptr_client);
+            continue;
+        }
+        break;
+    }
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. The request failed | GET %s | err %i (%s)", __FUNCTION__, param_ptr_path, f_retval,
+                esp_err_to_name(f_retval));
+        _close(param_ptr_client);
+        // GOTO
+        goto cleanup;
+    }
+
+    param_ptr_client->last_request_stats.is_reused = is_reused;
+    param_ptr_client->last_request_stats.status_code = param_ptr_client->parser.response.status_code;
+    if (is_reused == true) {
+        param_ptr_client->stats.nbr_of_reuses++;
+    }
+    param_ptr_client->nbr_of_requests_on_connection++;
+    *param_ptr_response = param_ptr_client->parser.response;
+
+    // LABEL
+    cleanup: ;
+
+    if (f_retval != ESP_OK && param_ptr_client != NULL) {
+        param_ptr_client->stats.nbr_of_errors++;
+    }
+
+    return f_retval;
+}
+
+/*
+ * @brief Read the next bytes of the body into param_ptr_buf: it returns when the buffer is full or at the end of the body.
+ *        *param_ptr_len = 0: the body is complete.
+ *
+ * @doc The raw body bytes (Content-Length, chunk data) are received directly into param_ptr_buf: no copy via the rx buffer.
+ */
+esp_err_t mjd_http_read(mjd_http_client_t* param_ptr_client, uint8_t * param_ptr_buf, size_t param_len, size_t * param_ptr_len) {
+    esp_err_t f_retval = ESP_OK;
+
+    size_t total = 0;
+
+    if (param_ptr_client == NULL || param_ptr_buf == NULL || param_len == 0 || param_ptr_len == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    while (param_ptr_client->is_response_pending == true && total < param_len
+            && mjd_http_parser_is_done(&param_ptr_client->parser) == false) {
+        // 1. The bytes that are already in the rx buffer
+        if (param_ptr_client->rx_pos < param_ptr_client->rx_len) {
+            const uint8_t *ptr_body;
+            size_t body_len, consumed;
+            f_retval = mjd_http_parser_execute(&param_ptr_client->parser, &param_ptr_client->rx_buffer[param_ptr_client->rx_pos],
+                    param_ptr_client->rx_len - param_ptr_client->rx_pos, param_len - total, &consumed, &ptr_body, &body_len);
+            param_ptr_client->rx_pos += consumed;
+            if (f_retval != ESP_OK) {
+                // GOTO
+                goto cleanup;
+            }
+            if (body_len > 0) {
+                memcpy(&param_ptr_buf[total], ptr_body, body_len);
+                total += body_len;
+            }
+            continue;
+        }
+
+        // 2. Receive: the raw body bytes directly into the caller's buffer, the framing via the rx buffer
+        size_t raw_len = mjd_http_parser_get_raw_body_len(&param_ptr_client->parser);
+        int len;
+        if (raw_len > 0) {
+            len = _recv(param_ptr_client, &param_ptr_buf[total], (raw_len < param_len - total) ? raw_len : param_len - total);
+            if (len > 0) {
+                mjd_http_parser_skip_body(&param_ptr_client->parser, len);
+                total += len;
+            }
+        } else {
+            len = _recv_into_rx_buffer(param_ptr_client);
+        }
+        if (len < 0) {
+            f_retval = ESP_ERR_TIMEOUT;
+            // GOTO
+            goto cleanup;
+        }
+        if (len == 0) {
+            f_retval = mjd_http_parser_finish_on_close(&param_ptr_client->parser);
+            if (f_retval != ESP_OK) {
+                ESP_LOGE(TAG, "%s(). The server closed the connection before the end of the body", __FUNCTION__);
+                // GOTO
+                goto cleanup;
+            }
+            param_ptr_client->parser.response.is_keep_alive = false;
+        }
+    }
+
+    if (param_ptr_client->is_response_pending == true) {
+        _sample_heap(param_ptr_client);
+        if (mjd_http_parser_is_done(&param_ptr_client->parser) == true) {
+            _finish_request(param_ptr_client);
+        }
+    }
+
+    // LABEL
+    cleanup: ;
+
+    if (f_retval != ESP_OK && param_ptr_client != NULL && param_ptr_len != NULL) {
+        ESP_LOGE(TAG, "%s(). ABORT. err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        param_ptr_client->stats.nbr_of_errors++;
+        _close(param_ptr_client);
+    }
+    if (param_ptr_len != NULL) {
+        *param_ptr_len = total;
+    }
+
+    return f_retval;
+}
+
+/*
+ * @brief Download param_len bytes from param_offset into param_ptr_buf (a Range request). *param_ptr_received < param_len: the end
+ *        of the resource.
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_NOT_SUPPORTED The server does not support Range requests (200 instead of 206) and param_offset > 0
+ *     - ESP_ERR_INVALID_RESPONSE Another status code
+ */
+esp_err_t mjd_http_download_range(mjd_http_client_t* param_ptr_client, const char * param_ptr_path, uint64_t param_offset,
+                                  uint8_t * param_ptr_buf, size_t param_len, size_t * param_ptr_received) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    mjd_http_response_t response;
+    size_t len;
+
+    if (param_ptr_client == NULL || param_ptr_buf == NULL || param_len == 0 || param_ptr_received == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    *param_ptr_received = 0;
+
+    f_retval = mjd_http_get(param_ptr_client, param_ptr_path, (int64_t) param_offset, (int64_t) (param_offset + param_len - 1), &response);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+    if (response.status_code == 416) {
+        // Range Not Satisfiable: param_offset is past the end of the resource
+        // GOTO
+        goto cleanup;
+    }
+    if (response.status_code == 200 && param_offset > 0) {
+        f_retval = ESP_ERR_NOT_SUPPORTED;
+        ESP_LOGE(TAG, "%s(). ABORT. The server ignored the Range header (200) | err %i (%s)", __FUNCTION__, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (response.status_code != 200 && response.status_code != 206) {
+        f_retval = ESP_ERR_INVALID_RESPONSE;
+        ESP_LOGE(TAG, "%s(). ABORT. HTTP status %i | err %i (%s)", __FUNCTION__, response.status_code, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    do {
+        f_retval = mjd_http_read(param_ptr_client, &param_ptr_buf[*param_ptr_received], param_len - *param_ptr_received, &len);
+        if (f_retval != ESP_OK) {
+            // GOTO
+            goto cleanup;
+        }
+        *param_ptr_received += len;
+    } while (len > 0 && *param_ptr_received < param_len);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*
+ * @brief Download the whole resource through param_ptr_buf: param_cb is called for each filled buffer (the last one can be partial).
+ */
+esp_err_t mjd_http_download(mjd_http_client_t* param_ptr_client, const char * param_ptr_path, uint8_t * param_ptr_buf,
+                            size_t param_buf_size, mjd_http_download_cb_t param_cb, void * param_ptr_arg) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    mjd_http_response_t response;
+    size_t len;
+
+    if (param_ptr_client == NULL || param_ptr_buf == NULL || param_buf_size == 0 || param_cb == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    f_retval = mjd_http_get(param_ptr_client, param_ptr_path, -1, -1, &response);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+    if (response.status_code != 200) {
+        f_retval = ESP_ERR_INVALID_RESPONSE;
+        ESP_LOGE(TAG, "%s(). ABORT. HTTP status %i | err %i (%s)", __FUNCTION__, response.status_code, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    for (;;) {
+        f_retval = mjd_http_read(param_ptr_client, param_ptr_buf, param_buf_size, &len);
+        if (f_retval != ESP_OK || len == 0) {
+            break;
+        }
+        if (param_cb(param_ptr_buf, len, param_ptr_arg) == false) {
+            ESP_LOGD(TAG, "%s(). Stopped by the callback", __FUNCTION__);
+            break;
+        }
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*
+ * @brief POST the bodies to param_ptr_path, pipelined: up to config.pipeline_depth requests are in flight on the connection
+ *        (sensor data batches: 1 round trip for N requests instead of N).
+ *        param_ptr_status_codes[i] = the HTTP status of body i, 0 = not sent or no response.
+ *
+ * @doc A server that closes the connection after a response (Connection: close, e.g. its max requests per connection) did not
+ *      process the requests that were pipelined after it: they are sent again on a new connection.
+ * @important A connection that fails without such a response is not retried (a POST is not idempotent): the call returns an error,
+ *            the status codes tell which bodies were accepted.
+ */
+esp_err_t mjd_http_post_pipelined(mjd_http_client_t* param_ptr_client, const char * param_ptr_path, const char * param_ptr_content_type,
+                                  const mjd_http_body_t * param_ptr_bodies, uint32_t param_nbr_of_bodies, int * param_ptr_status_codes) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    uint8_t discard[_DISCARD_BUFFER_SIZE];
+    uint32_t next_send = 0;
+    uint32_t next_recv = 0;
+    bool is_reused = false;
+    bool is_first_on_connection = true;
+
+    if (param_ptr_client == NULL || param_ptr_path == NULL || param_ptr_bodies == NULL || param_nbr_of_bodies == 0
+            || param_ptr_status_codes == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    memset(param_ptr_status_codes, 0, param_nbr_of_bodies * sizeof(int));
+    _start_request(param_ptr_client);
+
+    f_retval = _ensure_connection(param_ptr_client, &is_reused);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+    if (is_reused == true) {
+        param_ptr_client->stats.nbr_of_reuses++;
+    }
+
+    while (next_recv < param_nbr_of_bodies) {
+        if (param_ptr_client->socket < 0) {
+            f_retval = _connect(param_ptr_client);
+            if (f_retval != ESP_OK) {
+                // GOTO
+                goto cleanup;
+            }
+            is_reused = false;
+            is_first_on_connection = true;
+            next_send = next_recv;
+        }
+
+        // Fill the pipeline. @important Without keep-alive the server closes after each response: 1 request in flight.
+        uint32_t depth = (param_ptr_client->config.is_keep_alive == true) ? param_ptr_client->config.pipeline_depth : 1;
+        while (next_send < param_nbr_of_bodies && next_send - next_recv < depth) {
+            size_t head_len;
+            f_retval = _format_head(param_ptr_client, "POST", param_ptr_path, -1, -1, param_ptr_content_type,
+                    (int64_t) param_ptr_bodies[next_send].len, &head_len);
+            if (f_retval != ESP_OK) {
+                // GOTO
+                goto cleanup;
+            }
+            if (next_send == next_recv) {
+                param_ptr_client->request_sent_us = _now_us();
+            }
+            if (_send_all(param_ptr_client, param_ptr_client->tx_head, head_len) != ESP_OK
+                    || _send_all(param_ptr_client, param_ptr_bodies[next_send].ptr_data, param_ptr_bodies[next_send].len) != ESP_OK) {
+                break; // @doc The server closed the connection: the responses that are in flight tell where to continue
+            }
+            param_ptr_client->stats.nbr_of_requests++;
+            param_ptr_client->nbr_of_requests_on_connection++;
+            next_send++;
+        }
+
+        // The oldest response
+        f_retval = _read_head(param_ptr_client, false);
+        if (f_retval == ESP_ERR_INVALID_STATE && is_reused == true && is_first_on_connection == true) {
+            ESP_LOGD(TAG, "%s(). The reused connection was stale: send the requests again on a new connection", __FUNCTION__);
+            param_ptr_client->stats.nbr_of_stale_retries++;
+            _close(param_ptr_client);
+            continue;
+        }
+        if (f_retval != ESP_OK) {
+            ESP_LOGE(TAG, "%s(). ABORT. No response to POST #%u | err %i (%s)", __FUNCTION__, next_recv, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+        is_first_on_connection = false;
+
+        size_t len;
+        do {
+            f_retval = mjd_http_read(param_ptr_client, discard, sizeof(discard), &len);
+            if (f_retval != ESP_OK) {
+                // GOTO
+                goto cleanup;
+            }
+        } while (len > 0);
+
+        param_ptr_status_codes[next_recv] = param_ptr_client->parser.response.status_code;
+        next_recv++;
+        // _finish_request() closed the socket when the server said Connection: close: the next loop reconnects
+    }
+
+    // LABEL
+    cleanup: ;
+
+    if (f_retval != ESP_OK && param_ptr_client != NULL) {
+        param_ptr_client->stats.nbr_of_errors++;
+        _close(param_ptr_client);
+    }
+
+    return f_retval;
+}
+
+/*
+ * @brief GET param_ptr_path param_nbr_of_requests times and read the bodies through param_ptr_buf. Measures the throughput (KB/s),
+ *        the time to first byte and the heap churn per request.
+ *
+ * @doc config.is_keep_alive = false measures the cost of a new TCP connection per request.
+ */
+esp_err_t mjd_http_benchmark(mjd_http_client_t* param_ptr_client, const char * param_ptr_path, uint32_t param_nbr_of_requests,
+                             uint8_t * param_ptr_buf, size_t param_buf_size, mjd_http_benchmark_result_t* param_ptr_result) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    uint64_t ttfb_sum_us = 0;
+    uint32_t nbr_of_connects_start;
+    int64_t start_us;
+
+    if (param_ptr_client == NULL || param_ptr_path == NULL || param_nbr_of_requests == 0 || param_ptr_buf == NULL || param_buf_size == 0
+            || param_ptr_result == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    memset(param_ptr_result, 0, sizeof(*param_ptr_result));
+    param_ptr_result->ttfb_min_us = UINT64_MAX;
+    nbr_of_connects_start = param_ptr_client->stats.nbr_of_connects;
+    start_us = _now_us();
+
+    for (uint32_t idx = 0; idx < param_nbr_of_requests; idx++) {
+        mjd_http_response_t response;
+        esp_err_t retval;
+        size_t len;
+
+        param_ptr_result->nbr_of_requests++;
+        retval = mjd_http_get(param_ptr_client, param_ptr_path, -1, -1, &response);
+        if (retval == ESP_OK && response.status_code != 200) {
+            ESP_LOGE(TAG, "%s(). HTTP status %i", __FUNCTION__, response.status_code);
+            retval = ESP_ERR_INVALID_RESPONSE;
+        }
+        while (retval == ESP_OK) {
+            retval = mjd_http_read(param_ptr_client, param_ptr_buf, param_buf_size, &len);
+            if (len == 0) {
+                break;
+            }
+            param_ptr_result->bytes_received += len;
+        }
+        if (retval != ESP_OK) {
+            param_ptr_result->nbr_of_errors++;
+            continue;
+        }
+
+        const mjd_http_request_stats_t *ptr_stats = &param_ptr_client->last_request_stats;
+        ttfb_sum_us += ptr_stats->ttfb_us;
+        if (ptr_stats->ttfb_us < param_ptr_result->ttfb_min_us) {
+            param_ptr_result->ttfb_min_us = ptr_stats->ttfb_us;
+        }
+        if (ptr_stats->ttfb_us > param_ptr_result->ttfb_max_us) {
+            param_ptr_result->ttfb_max_us = ptr_stats->ttfb_us;
+        }
+        if (ptr_stats->heap_peak_bytes > param_ptr_result->heap_peak_max_bytes) {
+            param_ptr_result->heap_peak_max_bytes = ptr_stats->heap_peak_bytes;
+        }
+        param_ptr_result->heap_delta_sum_bytes += ptr_stats->heap_delta_bytes;
+    }
+
+    param_ptr_result->total_us = _now_us() - start_us;
+    param_ptr_result->nbr_of_connects = param_ptr_client->stats.nbr_of_connects - nbr_of_connects_start;
+    if (param_ptr_result->nbr_of_requests > param_ptr_result->nbr_of_errors) {
+        param_ptr_result->ttfb_avg_us = ttfb_sum_us / (param_ptr_result->nbr_of_requests - param_ptr_result->nbr_of_errors);
+    } else {
+        param_ptr_result->ttfb_min_us = 0;
+    }
+    if (param_ptr_result->total_us > 0) {
+        param_ptr_result->kbytes_per_sec = (float) ((double) param_ptr_result->bytes_received / 1024.0
+                / ((double) param_ptr_result->total_us / 1000000.0));
+    }
+    if (param_ptr_result->nbr_of_errors > 0) {
+        f_retval = ESP_FAIL;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+void mjd_http_log_benchmark(const char * param_ptr_label, const mjd_http_benchmark_result_t* param_ptr_result) {
+    ESP_LOGI(TAG, "%s: HTTP benchmark", param_ptr_label);
+    ESP_LOGI(TAG, "  requests: %u (errors %u, connects %u)", param_ptr_result->nbr_of_requests, param_ptr_result->nbr_of_errors,
+            param_ptr_result->nbr_of_connects);
+    ESP_LOGI(TAG, "  body bytes: %" PRIu64 " in %" PRIu64 " ms => %.1f KB/s", param_ptr_result->bytes_received,
+            param_ptr_result->total_us / 1000, param_ptr_result->kbytes_per_sec);
+    ESP_LOGI(TAG, "  TTFB us: min %" PRIu64 " | avg %" PRIu64 " | max %" PRIu64, param_ptr_result->ttfb_min_us,
+            param_ptr_result->ttfb_avg_us, param_ptr_result->ttfb_max_us);
+    ESP_LOGI(TAG, "  heap churn: peak %i bytes | delta sum %i bytes", param_ptr_result->heap_peak_max_bytes,
+            param_ptr_result->heap_delta_sum_bytes);
+}
+
+esp_err_t mjd_http_get_last_request_stats(const mjd_http_client_t* param_ptr_client, mjd_http_request_stats_t* param_ptr_stats) {
+    if (param_ptr_client == NULL || param_ptr_stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *param_ptr_stats = param_ptr_client->last_request_stats;
+    return ESP_OK;
+}
+
+esp_err_t mjd_http_get_stats(const mjd_http_client_t* param_ptr_client, mjd_http_stats_t* param_ptr_stats) {
+    if (param_ptr_client == NULL || param_ptr_stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *param_ptr_stats = param_ptr_client->stats;
+    return ESP_OK;
+}
+
+void mjd_http_log_stats(const mjd_http_client_t* param_ptr_client) {
+    const mjd_http_stats_t *ptr_stats = &param_ptr_client->stats;
+
+    ESP_LOGI(TAG, "HTTP client %s:%u", param_ptr_client->host, param_ptr_client->config.port);
+    ESP_LOGI(TAG, "  requests: %u | connects: %u | reuses: %u | stale retries: %u | errors: %u", ptr_stats->nbr_of_requests,
+            ptr_stats->nbr_of_connects, ptr_stats->nbr_of_reuses, ptr_stats->nbr_of_stale_retries, ptr_stats->nbr_of_errors);
+    ESP_LOGI(TAG, "  bytes sent: %" PRIu64 " | bytes received: %" PRIu64, ptr_stats->bytes_sent, ptr_stats->bytes_received);
+}
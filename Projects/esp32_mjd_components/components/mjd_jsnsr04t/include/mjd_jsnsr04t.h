@@ -13,16 +13,56 @@ extern "C" {
  * Includes: system, own
  */
 #include "mjd.h"
+#include "esp_timer.h"
 
 /*
  * Sensor settings
+ *
+ *   @doc The speed of sound in dry air is 331.3 m/s at 0 degrees Celsius and increases with +-0.606 m/s per degree Celsius.
+ *        The default 0.0342 cm/microsec (+-17.6 degrees Celsius) is used until mjd_jsnsr04t_set_temperature() is called.
+ *   @doc Datasheet: reserve a minimum period of 60 millisec between 2 pings (the echo of the previous ping must have faded).
  */
+#define MJD_JSNSR04T_DEFAULT_SPEED_OF_SOUND_CM_PER_US  (0.0342f)
+#define MJD_JSNSR04T_MIN_PING_PERIOD_MS                (60)
+#define MJD_JSNSR04T_FILTER_MAX_WINDOW_SIZE            (15)
 
 /**
  * Data structs
  *
  */
 
+/*
+ * FILTER: streaming median with Hampel outlier rejection
+ *
+ *   @doc A new sample is an outlier when it deviates more than hampel_k * 1.4826 * MAD from the median of the window
+ *        (MAD = the median of the absolute deviations from the median; 1.4826 * MAD estimates the standard deviation).
+ *        hampel_min_deviation_cm is the floor of that threshold (the MAD of a steady water level is often 0).
+ *   @doc An outlier is counted and dropped (it does not enter the window). When more than half a window of consecutive samples are outliers
+ *        then the level really changed: those samples are accepted so the median follows the step in +-window_size/2 samples.
+ *   @doc The filter is a pure function of its samples (no RMT, no RTOS) so it can be unit tested with recorded echo traces.
+ */
+typedef struct {
+        uint32_t window_size; /*!< The number of samples of the median window [1..MJD_JSNSR04T_FILTER_MAX_WINDOW_SIZE] */
+        float hampel_k; /*!< The outlier threshold in scaled MADs. 3.0 is the classic Hampel identifier */
+        float hampel_min_deviation_cm; /*!< The minimum outlier threshold (cm) */
+        float samples_cm[MJD_JSNSR04T_FILTER_MAX_WINDOW_SIZE]; /*!< Private: the window (ring buffer) */
+        uint32_t idx_next_sample; /*!< Private */
+        uint32_t nbr_of_samples; /*!< Private: the number of samples in the window */
+        uint32_t nbr_of_consecutive_outliers; /*!< Private */
+        uint32_t nbr_of_accepted; /*!< Statistics: the total number of accepted samples */
+        uint32_t nbr_of_outliers; /*!< Statistics: the total number of rejected samples */
+} mjd_jsnsr04t_filter_t;
+
+/*
+ * CONTINUOUS RANGING statistics
+ */
+typedef struct {
+        uint32_t nbr_of_pings; /*!< The number of trigger pulses sent by the ping timer */
+        uint32_t nbr_of_echoes; /*!< The number of echo pulses received */
+        uint32_t nbr_of_invalid_echoes; /*!< Echo pulses that were not valid (RMT items, out of range) */
+        uint32_t nbr_of_outliers; /*!< Valid echo pulses that were rejected by the filter */
+} mjd_jsnsr04t_ranging_stats_t;
+
 /*
  * CONFIG
  *
@@ -37,7 +77,20 @@ typedef struct {
         double distance_sensor_to_artifact_cm; /*!< The distance (cm) between the sensor and the artifact to be monitored. Typical for a stilling well setup. This distance is subtracted from the actual measurement. Also used to circumvent the dead measurement zone of the sensor (+-25cm). */
         uint32_t nbr_of_errors; /*!< Runtime Statistics: the total number of errors when interacting with the sensor */
         uint32_t nbr_of_samples; /*!< How many samples to read to come to one weighted measurement? */
-        double max_range_allowed_in_samples_cm; /*<! Reject a set of measurements if the range is higher than this prop. Statistics Dispersion Range outlier detection method */
+        double max_range_allowed_in_samples_cm; /*<! Reject a set of measurements if the range of the accepted samples (outliers are already dropped by the filter) is higher than this prop. Statistics Dispersion Range outlier detection method */
+        float filter_hampel_k; /*!< See mjd_jsnsr04t_filter_t */
+        float filter_hampel_min_deviation_cm; /*!< See mjd_jsnsr04t_filter_t */
+        uint32_t ranging_window_size; /*!< Continuous ranging: the median window of the filter (nbr of pings) */
+        uint32_t ranging_ping_period_ms; /*!< Continuous ranging: the period of the ping timer [MJD_JSNSR04T_MIN_PING_PERIOD_MS..] */
+        float speed_of_sound_cm_per_us; /*!< Private: use mjd_jsnsr04t_set_temperature() */
+        int64_t last_ping_time_us; /*!< Private: enforce MJD_JSNSR04T_MIN_PING_PERIOD_MS between pings */
+        volatile bool is_ranging; /*!< Private: continuous ranging is active (cleared by the ranging task when it exits) */
+        volatile bool is_ranging_stop_requested; /*!< Private */
+        esp_timer_handle_t ranging_timer_handle; /*!< Private */
+        TaskHandle_t ranging_task_handle; /*!< Private */
+        mjd_jsnsr04t_filter_t ranging_filter; /*!< Private */
+        mjd_jsnsr04t_ranging_stats_t ranging_stats; /*!< Private: use mjd_jsnsr04t_get_ranging_stats() */
+        double ranging_distance_cm; /*!< Private: use mjd_jsnsr04t_get_ranging_data() */
 } mjd_jsnsr04t_config_t;
 
 #define MJD_JSNSR04T_CONFIG_DEFAULT() { \
@@ -50,6 +103,11 @@ typedef struct {
     .nbr_of_errors = 0, \
     .nbr_of_samples = 5, \
     .max_range_allowed_in_samples_cm = 10.0, \
+    .filter_hampel_k = 3.0, \
+    .filter_hampel_min_deviation_cm = 2.0, \
+    .ranging_window_size = 5, \
+    .ranging_ping_period_ms = MJD_JSNSR04T_MIN_PING_PERIOD_MS, \
+    .speed_of_sound_cm_per_us = MJD_JSNSR04T_DEFAULT_SPEED_OF_SOUND_CM_PER_US, \
 }
 
 /*
@@ -76,6 +134,56 @@ esp_err_t mjd_jsnsr04t_init(mjd_jsnsr04t_config_t* param_ptr_config);
 esp_err_t mjd_jsnsr04t_deinit(mjd_jsnsr04t_config_t* param_ptr_config);
 esp_err_t mjd_jsnsr04t_get_measurement(mjd_jsnsr04t_config_t* param_ptr_config, mjd_jsnsr04t_data_t* param_ptr_data);
 
+/**
+ * @brief Temperature compensation: set the air temperature (e.g. of a co-located DS18B20 or BME280 sensor).
+ *        It can be called at any time, also during continuous ranging.
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Temperature out of range [-40..85]
+ */
+esp_err_t mjd_jsnsr04t_set_temperature(mjd_jsnsr04t_config_t* param_ptr_config, float param_degrees_celsius);
+
+/**
+ * @brief Streaming median + Hampel filter (see mjd_jsnsr04t_filter_t).
+ *
+ * mjd_jsnsr04t_filter_add() always returns the median of the window in param_ptr_median_cm (also when the sample is an outlier).
+ *
+ * @return
+ *     - ESP_OK The sample is accepted
+ *     - ESP_ERR_INVALID_RESPONSE The sample is an outlier
+ */
+esp_err_t mjd_jsnsr04t_filter_init(mjd_jsnsr04t_filter_t* param_ptr_filter, uint32_t param_window_size, float param_hampel_k,
+                                   float param_hampel_min_deviation_cm);
+esp_err_t mjd_jsnsr04t_filter_add(mjd_jsnsr04t_filter_t* param_ptr_filter, float param_sample_cm, float* param_ptr_median_cm);
+
+/**
+ * @brief Continuous ranging: the RMT RX channel stays armed, a periodic esp_timer sends a ping every ranging_ping_period_ms
+ *        and a task on the APP CPU feeds each echo into the filter. Read the latest filtered distance with mjd_jsnsr04t_get_ranging_data().
+ *
+ * @important mjd_jsnsr04t_get_measurement() is not allowed while continuous ranging is active.
+ */
+esp_err_t mjd_jsnsr04t_start_ranging(mjd_jsnsr04t_config_t* param_ptr_config);
+esp_err_t mjd_jsnsr04t_stop_ranging(mjd_jsnsr04t_config_t* param_ptr_config);
+
+/**
+ * @brief Receive one echo from the armed RMT RX channel and feed it into the filter.
+ *        The ranging task calls it in a loop; an app without the ranging task (or a unit test) can call it directly.
+ *
+ * @return
+ *     - ESP_OK The echo is accepted
+ *     - ESP_ERR_TIMEOUT No echo within param_ticks_to_wait
+ *     - ESP_ERR_INVALID_RESPONSE Invalid echo or outlier
+ */
+esp_err_t mjd_jsnsr04t_ranging_receive_echo(mjd_jsnsr04t_config_t* param_ptr_config, TickType_t param_ticks_to_wait);
+
+/**
+ * @brief The latest filtered distance (the median of the window, distance_sensor_to_artifact_cm subtracted).
+ *        data_received is false until the first echo has been accepted.
+ */
+esp_err_t mjd_jsnsr04t_get_ranging_data(mjd_jsnsr04t_config_t* param_ptr_config, mjd_jsnsr04t_data_t* param_ptr_data);
+esp_err_t mjd_jsnsr04t_get_ranging_stats(mjd_jsnsr04t_config_t* param_ptr_config, mjd_jsnsr04t_ranging_stats_t* param_ptr_stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,6 +7,7 @@
  * Includes: system, own
  */
 #include "mjd_jsnsr04t.h"
+#include "mjd_trace.h"
 
 /*
  * Logging
@@ -18,7 +19,30 @@ static const char TAG[] = "mjd_jsnsr04t";
  */
 #define MJD_JSNSR04T_MINIMUM_SUPPORTED_DISTANCE_CM         (25.0)
 #define MJD_JSNSR04T_MAXIMUM_SUPPORTED_DISTANCE_CM         (350.0)
-// Spinlock for protecting concurrent register-level access
+#define MJD_JSNSR04T_MINIMUM_SUPPORTED_TEMPERATURE_CELSIUS (-40.0f)
+#define MJD_JSNSR04T_MAXIMUM_SUPPORTED_TEMPERATURE_CELSIUS (85.0f)
+
+// The scale factor of the MAD for normally distributed data (1 / the 75th percentile of the standard normal distribution)
+#define MJD_JSNSR04T_MAD_SCALE_FACTOR (1.4826f)
+
+/*
+ * RMT settings
+ *
+ *   @doc Single shot: the receive process stops after 60 millisec without an edge (the sensor gives up after 60 millisec).
+ *   @doc Continuous ranging: the RX channel stays armed and the pings follow each other after ranging_ping_period_ms (min 60 millisec)
+ *        so the receive process must stop before the next echo arrives. 25 millisec covers the max distance 350cm at -40 degrees Celsius (+-23 millisec).
+ *        A longer echo pulse (no obstacle: 38 millisec) is cut and rejected as out of range.
+ */
+#define MJD_JSNSR04T_RMT_IDLE_THRESHOLD_SINGLE_US          (60 * 1000)
+#define MJD_JSNSR04T_RMT_IDLE_THRESHOLD_RANGING_US         (25 * 1000)
+
+/*
+ * Continuous ranging task
+ */
+#define MJD_JSNSR04T_RANGING_TASK_STACK_SIZE               (3072)
+#define MJD_JSNSR04T_RANGING_TASK_PRIORITY                 (RTOS_TASK_PRIORITY_NORMAL)
+
+// Spinlock for protecting concurrent register-level access, and the continuous ranging data (ranging task <=> app task)
 static portMUX_TYPE jsnsr04t_spinlock = portMUX_INITIALIZER_UNLOCKED;
 
 /*
@@ -93,6 +117,12 @@ esp_err_t mjd_jsnsr04t_log_config(mjd_jsnsr04t_config_t param_config) {
             param_config.distance_sensor_to_artifact_cm);
     ESP_LOGI(TAG, "  %32s = %u", "(uint32_t) nbr_of_errors", param_config.nbr_of_errors);
     ESP_LOGI(TAG, "  %32s = %u", "(uint32_t) nbr_of_samples", param_config.nbr_of_samples);
+    ESP_LOGI(TAG, "  %32s = %f", "(double) max_range_allowed_in_samples_cm", param_config.max_range_allowed_in_samples_cm);
+    ESP_LOGI(TAG, "  %32s = %f", "(float) filter_hampel_k", param_config.filter_hampel_k);
+    ESP_LOGI(TAG, "  %32s = %f", "(float) filter_hampel_min_deviation_cm", param_config.filter_hampel_min_deviation_cm);
+    ESP_LOGI(TAG, "  %32s = %u", "(uint32_t) ranging_window_size", param_config.ranging_window_size);
+    ESP_LOGI(TAG, "  %32s = %u", "(uint32_t) ranging_ping_period_ms", param_config.ranging_ping_period_ms);
+    ESP_LOGI(TAG, "  %32s = %f", "(float) speed_of_sound_cm_per_us", param_config.speed_of_sound_cm_per_us);
 
     return f_retval;
 }
@@ -171,6 +201,13 @@ esp_err_t mjd_jsnsr04t_init(mjd_jsnsr04t_config_t* param_ptr_config) {
         goto cleanup;
     }
 
+    // A config struct that was not initialized with MJD_JSNSR04T_CONFIG_DEFAULT()
+    if (param_ptr_config->speed_of_sound_cm_per_us <= 0.0f) {
+        param_ptr_config->speed_of_sound_cm_per_us = MJD_JSNSR04T_DEFAULT_SPEED_OF_SOUND_CM_PER_US;
+    }
+    param_ptr_config->last_ping_time_us = 0;
+    param_ptr_config->is_ranging = false;
+
     /*
      * GPIO's
      */
@@ -214,7 +251,7 @@ esp_err_t mjd_jsnsr04t_init(mjd_jsnsr04t_config_t* param_ptr_config) {
 
     // When no edge is detected on the input signal for longer than idle_thres channel clock cycles, then the receive process stops.
     // // =60 MILLIsec, = 60*1000 MICROsec (1 tick = 1 MICROsec). @doc uint16_t [0..65535]. @dependency My logical clock of 1Mhz.
-    const int JSNSR04T_RMT_TIMEOUT_US = 60 * 1000;
+    const int JSNSR04T_RMT_TIMEOUT_US = MJD_JSNSR04T_RMT_IDLE_THRESHOLD_SINGLE_US;
 
     rmt_config_t rx_config =
                 { 0 };
@@ -248,35 +285,293 @@ esp_err_t mjd_jsnsr04t_init(mjd_jsnsr04t_config_t* param_ptr_config) {
     return f_retval;
 }
 
+
 esp_err_t mjd_jsnsr04t_deinit(mjd_jsnsr04t_config_t* param_ptr_config) {
     ESP_LOGD(TAG, "%s()", __FUNCTION__);
 
     esp_err_t f_retval = ESP_OK;
 
-    // NULL
+    if (param_ptr_config->is_ranging == true) {
+        f_retval = mjd_jsnsr04t_stop_ranging(param_ptr_config);
+        if (f_retval != ESP_OK) {
+            ESP_LOGE(TAG, "%s(). ABORT. mjd_jsnsr04t_stop_ranging() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+    }
 
     // Mark init'd false
     param_ptr_config->is_init = false;
 
     // LABEL
-    /////cleanup: ;
+    cleanup: ;
 
     return f_retval;
 }
 
-/*
+/**************************************
  * PRIVATE STATIC.
  *
- * @brief Get ONE raw measurement
+ * @brief The median of a small array of values (insertion sort in place, max MJD_JSNSR04T_FILTER_MAX_WINDOW_SIZE values).
+ */
+static float _median_in_place(float* param_ptr_values, uint32_t param_nbr_of_values) {
+    for (uint32_t i = 1; i < param_nbr_of_values; i++) {
+        float value = param_ptr_values[i];
+        uint32_t j = i;
+        while (j > 0 && param_ptr_values[j - 1] > value) {
+            param_ptr_values[j] = param_ptr_values[j - 1];
+            j--;
+        }
+        param_ptr_values[j] = value;
+    }
+
+    if ((param_nbr_of_values % 2) == 1) {
+        return param_ptr_values[param_nbr_of_values / 2];
+    }
+    return (param_ptr_values[param_nbr_of_values / 2 - 1] + param_ptr_values[param_nbr_of_values / 2]) / 2.0f;
+}
+
+/**************************************
+ * PUBLIC.
+ *
+ * @brief Streaming median + Hampel filter
+ *
+ * @doc The samples of the window are always stored in samples_cm[0..nbr_of_samples-1] (ring buffer, the oldest one is overwritten).
+ */
+esp_err_t mjd_jsnsr04t_filter_init(mjd_jsnsr04t_filter_t* param_ptr_filter, uint32_t param_window_size, float param_hampel_k,
+                                   float param_hampel_min_deviation_cm) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_filter == NULL || param_window_size == 0 || param_window_size > MJD_JSNSR04T_FILTER_MAX_WINDOW_SIZE
+            || param_hampel_k <= 0.0f || param_hampel_min_deviation_cm < 0.0f) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param (window_size 1..%u, hampel_k > 0, hampel_min_deviation_cm >= 0) | err %i (%s)", __FUNCTION__,
+                MJD_JSNSR04T_FILTER_MAX_WINDOW_SIZE, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    memset(param_ptr_filter, 0, sizeof(*param_ptr_filter));
+    param_ptr_filter->window_size = param_window_size;
+    param_ptr_filter->hampel_k = param_hampel_k;
+    param_ptr_filter->hampel_min_deviation_cm = param_hampel_min_deviation_cm;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_jsnsr04t_filter_add(mjd_jsnsr04t_filter_t* param_ptr_filter, float param_sample_cm, float* param_ptr_median_cm) {
+    esp_err_t f_retval = ESP_OK;
+
+    float values[MJD_JSNSR04T_FILTER_MAX_WINDOW_SIZE];
+    bool is_outlier = false;
+
+    if (param_ptr_filter == NULL || param_ptr_filter->window_size == 0) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. The filter has not been init'd | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // Hampel identifier. The MAD of less than 3 samples is meaningless.
+    if (param_ptr_filter->nbr_of_samples >= 3) {
+        const uint32_t nbr_of_samples = param_ptr_filter->nbr_of_samples;
+
+        memcpy(values, param_ptr_filter->samples_cm, nbr_of_samples * sizeof(float));
+        float median_cm = _median_in_place(values, nbr_of_samples);
+        for (uint32_t idx = 0; idx < nbr_of_samples; idx++) {
+            values[idx] = fabsf(values[idx] - median_cm);
+        }
+        float mad_cm = _median_in_place(values, nbr_of_samples);
+        float threshold_cm = fmaxf(param_ptr_filter->hampel_k * MJD_JSNSR04T_MAD_SCALE_FACTOR * mad_cm,
+                param_ptr_filter->hampel_min_deviation_cm);
+
+        is_outlier = (fabsf(param_sample_cm - median_cm) > threshold_cm);
+    }
+
+    if (is_outlier == true) {
+        ++param_ptr_filter->nbr_of_consecutive_outliers;
+    } else {
+        param_ptr_filter->nbr_of_consecutive_outliers = 0;
+    }
+
+    // More than half a window of consecutive outliers: the level really changed (accept them until the median follows)
+    if (is_outlier == true && param_ptr_filter->nbr_of_consecutive_outliers <= param_ptr_filter->window_size / 2) {
+        ++param_ptr_filter->nbr_of_outliers;
+        f_retval = ESP_ERR_INVALID_RESPONSE;
+    } else {
+        param_ptr_filter->samples_cm[param_ptr_filter->idx_next_sample] = param_sample_cm;
+        param_ptr_filter->idx_next_sample = (param_ptr_filter->idx_next_sample + 1) % param_ptr_filter->window_size;
+        if (param_ptr_filter->nbr_of_samples < param_ptr_filter->window_size) {
+            ++param_ptr_filter->nbr_of_samples;
+        }
+        ++param_ptr_filter->nbr_of_accepted;
+    }
+
+    if (param_ptr_median_cm != NULL) {
+        memcpy(values, param_ptr_filter->samples_cm, param_ptr_filter->nbr_of_samples * sizeof(float));
+        *param_ptr_median_cm = _median_in_place(values, param_ptr_filter->nbr_of_samples);
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/**************************************
+ * PUBLIC.
+ *
+ * @brief Temperature compensation of the speed of sound
+ *
+ * @doc c(T) = 331.3 + 0.606 * T m/s (dry air). m/s => cm/microsec: * 100 / 1000000.
+ */
+esp_err_t mjd_jsnsr04t_set_temperature(mjd_jsnsr04t_config_t* param_ptr_config, float param_degrees_celsius) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_degrees_celsius < MJD_JSNSR04T_MINIMUM_SUPPORTED_TEMPERATURE_CELSIUS
+            || param_degrees_celsius > MJD_JSNSR04T_MAXIMUM_SUPPORTED_TEMPERATURE_CELSIUS) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Temperature out of range (%f) | err %i (%s)", __FUNCTION__, param_degrees_celsius, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    param_ptr_config->speed_of_sound_cm_per_us = (331.3f + 0.606f * param_degrees_celsius) / 10000.0f;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/**************************************
+ * PRIVATE STATIC.
+ *
+ * @brief Convert the RMT items of one echo to a distance
  *
- * @doc Speed of sound = 0.0342cm per microsecond
  * @doc The duration is the time it takes to transmit and receive the ultrasonic signal (so the distance is related to half that time measurement).
  * @doc Minimum stable distance =  25cm
  * @doc Maximum stable distance = 350cm
+ * @important LOG_DEBUG (not LOG_ERROR): continuous ranging calls it for each ping. The caller decides.
+ */
+static esp_err_t _convert_echo_items(const mjd_jsnsr04t_config_t* param_ptr_config, const rmt_item32_t* param_ptr_items,
+                                     uint32_t param_nbr_of_items, mjd_jsnsr04t_raw_data_t* param_ptr_raw_data) {
+    esp_err_t f_retval = ESP_OK;
+
+    param_ptr_raw_data->data_received = false;
+    param_ptr_raw_data->is_an_error = false;
+    param_ptr_raw_data->raw = 0;
+    param_ptr_raw_data->distance_cm = 0.0;
+
+    // Check RMT nbr_of_items
+    if (param_nbr_of_items != 1) {
+        f_retval = ESP_ERR_INVALID_RESPONSE;
+        ESP_LOGD(TAG, "%s(). ABORT. RMT nbr_of_items != 1 (%u) | err %i (%s)", __FUNCTION__, param_nbr_of_items, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // Check RMT first_item level0
+    if (param_ptr_items->level0 != 1) {
+        f_retval = ESP_ERR_INVALID_RESPONSE;
+        ESP_LOGD(TAG, "%s(). ABORT. RMT ptr_rx_item->level0 != 1 (%u) | err %i (%s)", __FUNCTION__, param_ptr_items->level0, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // COMPUTE
+    param_ptr_raw_data->data_received = true;
+    param_ptr_raw_data->raw = param_ptr_items->duration0; // Unit=microseconds
+    param_ptr_raw_data->distance_cm = (param_ptr_raw_data->raw * param_ptr_config->speed_of_sound_cm_per_us) / 2.0; // @uses Speed of sound
+
+    if (param_ptr_raw_data->distance_cm < MJD_JSNSR04T_MINIMUM_SUPPORTED_DISTANCE_CM
+            || param_ptr_raw_data->distance_cm > MJD_JSNSR04T_MAXIMUM_SUPPORTED_DISTANCE_CM) {
+        f_retval = ESP_ERR_INVALID_RESPONSE;
+        ESP_LOGD(TAG, "%s(). ABORT. Out Of Range: distance_cm [%f..%f] (%f) | err %i (%s)", __FUNCTION__,
+                MJD_JSNSR04T_MINIMUM_SUPPORTED_DISTANCE_CM, MJD_JSNSR04T_MAXIMUM_SUPPORTED_DISTANCE_CM, param_ptr_raw_data->distance_cm,
+                f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // ADJUST with distance_sensor_to_artifact_cm (default 0cm).
+    if (param_ptr_config->distance_sensor_to_artifact_cm != 0.0) {
+        param_ptr_raw_data->distance_cm -= param_ptr_config->distance_sensor_to_artifact_cm;
+        if (param_ptr_raw_data->distance_cm <= 0.0) {
+            f_retval = ESP_ERR_INVALID_RESPONSE;
+            ESP_LOGD(TAG, "%s(). ABORT. Invalid value: adjusted distance <= 0 (subtracted sensor_artifact_cm) (%f) | err %i (%s)",
+                    __FUNCTION__, param_ptr_raw_data->distance_cm, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+    }
+
+    // LABEL
+    cleanup: ;
+
+    if (f_retval != ESP_OK) {
+        param_ptr_raw_data->distance_cm = 0.0;
+        param_ptr_raw_data->is_an_error = true;
+    }
+
+    return f_retval;
+}
+
+/**************************************
+ * PRIVATE STATIC.
+ *
+ * @brief Send one ping: trigger_gpio level:=1 for at least 25 MICROsec
+ *
+ * @important Use ets_delay_us(). Do not use vTaskDelay() https://docs.espressif.com/projects/esp-idf/en/latest/api-guides/freertos-smp.html?highlight=vtaskdelay
+ */
+static void _send_ping(mjd_jsnsr04t_config_t* param_ptr_config) {
+    portENTER_CRITICAL(&jsnsr04t_spinlock);
+    gpio_set_level(param_ptr_config->trigger_gpio_num, 1);
+    ets_delay_us(25);
+    gpio_set_level(param_ptr_config->trigger_gpio_num, 0);
+    portEXIT_CRITICAL(&jsnsr04t_spinlock);
+
+    param_ptr_config->last_ping_time_us = esp_timer_get_time();
+}
+
+/**************************************
+ * PRIVATE STATIC.
+ *
+ * @brief Keep trigger_gpio level:=0 until MJD_JSNSR04T_MIN_PING_PERIOD_MS have passed since the previous ping (the full period before the first ping).
+ *
+ * @doc The wait is outside the critical section (only the trigger pulse itself is timing critical).
+ */
+static void _wait_ping_period(mjd_jsnsr04t_config_t* param_ptr_config) {
+    int64_t wait_us = MJD_JSNSR04T_MIN_PING_PERIOD_MS * 1000;
+
+    gpio_set_level(param_ptr_config->trigger_gpio_num, 0);
+
+    if (param_ptr_config->last_ping_time_us != 0) {
+        wait_us -= esp_timer_get_time() - param_ptr_config->last_ping_time_us;
+    }
+    if (wait_us > 0) {
+        ets_delay_us(wait_us);
+    }
+}
+
+/*
+ * PRIVATE STATIC.
+ *
+ * @brief Get ONE raw measurement
+ *
  * @doc Reserve a minimum period of 60 millisec between measurements (avoid signal overlap, do not process the retured ultrasonic signal of the previous measurement).
  * @doc If no obstacle is detected, the output pin will give a 38 millisec high level signal (38 millisec = 6.5 meter which is out of range).
  * @doc If the sensor does not receive an echo within 60 millisec (range too big or too close or no object range) then the signal goes LOW after 60 millisec.
- * @important Use ets_delay_us(). Do not use vTaskDelay() https://docs.espressif.com/projects/esp-idf/en/latest/api-guides/freertos-smp.html?highlight=vtaskdelay
  *
  */
 static esp_err_t _get_one_measurement(mjd_jsnsr04t_config_t* param_ptr_config, mjd_jsnsr04t_raw_data_t* param_ptr_raw_data) {
@@ -313,17 +608,13 @@ static esp_err_t _get_one_measurement(mjd_jsnsr04t_config_t* param_ptr_config, m
 
     /*
      * # SENSOR CMD Start Measurement:
-     *      1. trigger_gpio level:=0 for at least 60 MILLIsec
+     *      1. trigger_gpio level:=0 for at least 60 MILLIsec (since the previous ping)
      *      2. trigger_gpio level:=1 for at least 25 MICROsec
      */
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_RMT_SENSOR_READ);
     if (do_trigger == true) {
-        portENTER_CRITICAL(&jsnsr04t_spinlock);
-        gpio_set_level(param_ptr_config->trigger_gpio_num, 0);
-        ets_delay_us(60 * 1000);
-        gpio_set_level(param_ptr_config->trigger_gpio_num, 1);
-        ets_delay_us(25);
-        gpio_set_level(param_ptr_config->trigger_gpio_num, 0);
-        portEXIT_CRITICAL(&jsnsr04t_spinlock);
+        _wait_ping_period(param_ptr_config);
+        _send_ping(param_ptr_config);
     }
 
     /*
@@ -333,6 +624,7 @@ static esp_err_t _get_one_measurement(mjd_jsnsr04t_config_t* param_ptr_config, m
      *   @doc xRingbufferReceive() param#3 ticks_to_wait MAXIMUM nbr of Ticks to wait for items in the ringbuffer ELSE Timeout (NULL).
      */
     ptr_rx_item = (rmt_item32_t*) xRingbufferReceive(rb, &rx_size, RTOS_DELAY_100MILLISEC);
+    MJD_TRACE_END(MJD_TRACE_PROBE_RMT_SENSOR_READ);
     if (ptr_rx_item == NULL) {
         f_retval = ESP_ERR_TIMEOUT;
         ESP_LOGE(TAG, "%s(). ABORT. xRingbufferReceive() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
@@ -355,66 +647,15 @@ static esp_err_t _get_one_measurement(mjd_jsnsr04t_config_t* param_ptr_config, m
         temp_ptr++;
     }
 
-    // Check RMT nbr_of_items
-    if (nbr_of_items != 1) {
-        _mark_error_event(param_ptr_config, param_ptr_raw_data);
-        f_retval = ESP_ERR_INVALID_RESPONSE;
-        ESP_LOGE(TAG, "%s(). ABORT. RMT nbr_of_items != 1 (%i) | err %i (%s)", __FUNCTION__, nbr_of_items, f_retval,
-                esp_err_to_name(f_retval));
-        // GOTO
-        goto cleanup;
-    }
-
-    // Check RMT first_item level0
-    if (ptr_rx_item->level0 != 1) {
-        f_retval = ESP_ERR_INVALID_RESPONSE;
-        ESP_LOGE(TAG, "%s(). ABORT. RMT ptr_rx_item->level0 != 1 (%u) | err %i (%s)", __FUNCTION__, ptr_rx_item->level0,
-                f_retval,
-                esp_err_to_name(f_retval));
-        _mark_error_event(param_ptr_config, param_ptr_raw_data);
-        // GOTO
-        goto cleanup;
-    }
-
-    // COMPUTE
-    param_ptr_raw_data->data_received = true;
-    param_ptr_raw_data->raw = ptr_rx_item->duration0; // Unit=microseconds
-    param_ptr_raw_data->distance_cm = (param_ptr_raw_data->raw / 2) * 0.0342; // @uses Lightspeed
-
-    if (param_ptr_raw_data->distance_cm < MJD_JSNSR04T_MINIMUM_SUPPORTED_DISTANCE_CM) {
-        f_retval = ESP_ERR_INVALID_RESPONSE;
-        ESP_LOGE(TAG, "%s(). ABORT. Out Of Range: distance_cm < %f (%f) | err %i (%s)", __FUNCTION__,
-                MJD_JSNSR04T_MINIMUM_SUPPORTED_DISTANCE_CM, param_ptr_raw_data->distance_cm, f_retval,
-                esp_err_to_name(f_retval));
-        _mark_error_event(param_ptr_config, param_ptr_raw_data);
-        // GOTO
-        goto cleanup;
-    }
-    if (param_ptr_raw_data->distance_cm > MJD_JSNSR04T_MAXIMUM_SUPPORTED_DISTANCE_CM) {
-        f_retval = ESP_ERR_INVALID_RESPONSE;
-        ESP_LOGE(TAG, "%s(). ABORT. Out Of Range: distance_cm > %f (%f) | err %i (%s)", __FUNCTION__,
-                MJD_JSNSR04T_MAXIMUM_SUPPORTED_DISTANCE_CM, param_ptr_raw_data->distance_cm, f_retval,
-                esp_err_to_name(f_retval));
+    f_retval = _convert_echo_items(param_ptr_config, ptr_rx_item, nbr_of_items, param_ptr_raw_data);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid echo (nbr_of_items %i, raw %u) | err %i (%s)", __FUNCTION__, nbr_of_items,
+                param_ptr_raw_data->raw, f_retval, esp_err_to_name(f_retval));
         _mark_error_event(param_ptr_config, param_ptr_raw_data);
         // GOTO
         goto cleanup;
     }
 
-    // ADJUST with distance_sensor_to_artifact_cm (default 0cm).
-    if (param_ptr_config->distance_sensor_to_artifact_cm != 0.0) {
-        param_ptr_raw_data->distance_cm -= param_ptr_config->distance_sensor_to_artifact_cm;
-        if (param_ptr_raw_data->distance_cm <= 0.0) {
-            f_retval = ESP_ERR_INVALID_RESPONSE;
-            ESP_LOGE(TAG,
-                    "%s(). ABORT. Invalid value: adjusted distance <= 0 (subtracted sensor_artifact_cm) (%f) | err %i (%s)",
-                    __FUNCTION__,
-                    param_ptr_raw_data->distance_cm, f_retval, esp_err_to_name(f_retval));
-            _mark_error_event(param_ptr_config, param_ptr_raw_data);
-            // GOTO
-            goto cleanup;
-        }
-    }
-
     // LABEL
     cleanup: ;
 
@@ -439,6 +680,9 @@ static esp_err_t _get_one_measurement(mjd_jsnsr04t_config_t* param_ptr_config, m
  *
  * @brief Get ONE weighted Measurement
  *
+ * @doc The samples go through the median + Hampel filter: an invalid sample or an outlier is dropped (it does not abort the measurement).
+ *      The measurement is the median of the accepted samples. It is an error when less than a majority of the samples are accepted.
+ *
  */
 esp_err_t mjd_jsnsr04t_get_measurement(mjd_jsnsr04t_config_t* param_ptr_config, mjd_jsnsr04t_data_t* param_ptr_data) {
     ESP_LOGD(TAG, "%s()", __FUNCTION__);
@@ -450,47 +694,72 @@ esp_err_t mjd_jsnsr04t_get_measurement(mjd_jsnsr04t_config_t* param_ptr_config,
     param_ptr_data->is_an_error = false;
     param_ptr_data->distance_cm = 0.0;
 
+    if (param_ptr_config->is_ranging == true) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. Continuous ranging is active | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
     // Samples
     uint32_t count_errors = 0;
-    double sum_distance_cm = 0;
-    double min_distance_cm = FLT_MAX;
-    double max_distance_cm = FLT_MIN;
-    mjd_jsnsr04t_raw_data_t samples[param_ptr_config->nbr_of_samples];
+    float median_cm = 0.0f;
+    float min_distance_cm = FLT_MAX;
+    float max_distance_cm = -FLT_MAX;
+    mjd_jsnsr04t_raw_data_t sample;
+    mjd_jsnsr04t_filter_t filter;
+
+    f_retval = mjd_jsnsr04t_filter_init(&filter,
+            (param_ptr_config->nbr_of_samples < MJD_JSNSR04T_FILTER_MAX_WINDOW_SIZE) ?
+                    param_ptr_config->nbr_of_samples : MJD_JSNSR04T_FILTER_MAX_WINDOW_SIZE,
+            param_ptr_config->filter_hampel_k, param_ptr_config->filter_hampel_min_deviation_cm);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. mjd_jsnsr04t_filter_init() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
 
-    for (uint32_t j = 1; j <= param_ptr_config->nbr_of_samples; j++) {
-        f_retval = _get_one_measurement(param_ptr_config, &samples[j]);
+    for (uint32_t j = 0; j < param_ptr_config->nbr_of_samples; j++) {
+        f_retval = _get_one_measurement(param_ptr_config, &sample);
         if (f_retval != ESP_OK) {
             ESP_LOGW(TAG, "[CONTINUE-LOOP] %s(). WARNING. _get_one_measurement() | err %i (%s)", __FUNCTION__, f_retval,
                     esp_err_to_name(f_retval));
             // Do not exit loop!
         }
-        _log_raw_data(samples[j]);
+        _log_raw_data(sample);
 
         // COUNT ERRORS
-        if (samples[j].is_an_error == true) {
+        if (sample.is_an_error == true) {
             count_errors += 1;
+            continue;
         }
-        // SUM
-        sum_distance_cm += samples[j].distance_cm;
-        // IDENTIFY MIN VALUE and MAX VALUE
-        if (samples[j].distance_cm < min_distance_cm) {
-            min_distance_cm = samples[j].distance_cm;
-        }
-        if (samples[j].distance_cm > max_distance_cm) {
-            max_distance_cm = samples[j].distance_cm;
+        // FILTER
+        if (mjd_jsnsr04t_filter_add(&filter, sample.distance_cm, &median_cm) != ESP_OK) {
+            ESP_LOGW(TAG, "[CONTINUE-LOOP] %s(). WARNING. Outlier rejected (%f cm, median %f cm)", __FUNCTION__, sample.distance_cm,
+                    median_cm);
         }
     }
+    f_retval = ESP_OK;
 
     // Validation
-    if (count_errors > 0) {
+    if (filter.nbr_of_accepted < (param_ptr_config->nbr_of_samples / 2) + 1) {
         ++param_ptr_config->nbr_of_errors;
         param_ptr_data->is_an_error = true; // Mark error
         f_retval = ESP_ERR_INVALID_RESPONSE;
-        ESP_LOGE(TAG, "%s(). ABORT. At least one measurement in error (%u) | err %i (%s)", __FUNCTION__, count_errors,
-                f_retval, esp_err_to_name(f_retval));
+        ESP_LOGE(TAG, "%s(). ABORT. Not enough valid samples (accepted %u, errors %u, outliers %u) | err %i (%s)", __FUNCTION__,
+                filter.nbr_of_accepted, count_errors, filter.nbr_of_outliers, f_retval, esp_err_to_name(f_retval));
         // GOTO
         goto cleanup;
     }
+    // IDENTIFY MIN VALUE and MAX VALUE of the accepted samples
+    for (uint32_t j = 0; j < filter.nbr_of_samples; j++) {
+        if (filter.samples_cm[j] < min_distance_cm) {
+            min_distance_cm = filter.samples_cm[j];
+        }
+        if (filter.samples_cm[j] > max_distance_cm) {
+            max_distance_cm = filter.samples_cm[j];
+        }
+    }
     if ((max_distance_cm - min_distance_cm) > param_ptr_config->max_range_allowed_in_samples_cm) {
         ++param_ptr_config->nbr_of_errors;
         param_ptr_data->is_an_error = true; // Mark error
@@ -506,10 +775,265 @@ esp_err_t mjd_jsnsr04t_get_measurement(mjd_jsnsr04t_config_t* param_ptr_config,
 
     // Deduct one weighted measurement
     param_ptr_data->data_received = true;
-    param_ptr_data->distance_cm = sum_distance_cm / param_ptr_config->nbr_of_samples;
+    param_ptr_data->distance_cm = median_cm;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/**************************************
+ * PRIVATE STATIC.
+ *
+ * @brief Continuous ranging: the ping timer callback (esp_timer task)
+ */
+static void _ranging_timer_callback(void *param_ptr_arg) {
+    mjd_jsnsr04t_config_t* ptr_config = (mjd_jsnsr04t_config_t*) param_ptr_arg;
+
+    _send_ping(ptr_config);
+
+    portENTER_CRITICAL(&jsnsr04t_spinlock);
+    ++ptr_config->ranging_stats.nbr_of_pings;
+    portEXIT_CRITICAL(&jsnsr04t_spinlock);
+}
+
+/**************************************
+ * PRIVATE STATIC.
+ *
+ * @brief Continuous ranging: the task that owns the armed RMT RX channel
+ *
+ * @doc The ring buffer timeout of 100 millisec bounds the reaction time to mjd_jsnsr04t_stop_ranging().
+ */
+static void _ranging_task(void *pvParameter) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    mjd_jsnsr04t_config_t* ptr_config = (mjd_jsnsr04t_config_t*) pvParameter;
+
+    while (ptr_config->is_ranging_stop_requested == false) {
+        mjd_jsnsr04t_ranging_receive_echo(ptr_config, RTOS_DELAY_100MILLISEC);
+    }
+
+    // Restore the single shot RMT RX setup
+    rmt_rx_stop(ptr_config->rmt_channel);
+    rmt_set_rx_idle_thresh(ptr_config->rmt_channel, MJD_JSNSR04T_RMT_IDLE_THRESHOLD_SINGLE_US);
+
+    ptr_config->is_ranging = false;
+
+    /********************************************************************************
+     * Task Delete
+     * @doc Passing NULL will end the current task
+     */
+    vTaskDelete(NULL);
+}
+
+/**************************************
+ * PUBLIC.
+ *
+ */
+esp_err_t mjd_jsnsr04t_ranging_receive_echo(mjd_jsnsr04t_config_t* param_ptr_config, TickType_t param_ticks_to_wait) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    RingbufHandle_t rb = NULL;
+    size_t rx_size = 0;
+    rmt_item32_t* ptr_rx_item = NULL;
+    mjd_jsnsr04t_raw_data_t raw_data;
+    float median_cm = 0.0f;
+
+    f_retval = rmt_get_ringbuf_handle(param_ptr_config->rmt_channel, &rb);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. rmt_get_ringbuf_handle() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    ptr_rx_item = (rmt_item32_t*) xRingbufferReceive(rb, &rx_size, param_ticks_to_wait);
+    if (ptr_rx_item == NULL) {
+        f_retval = ESP_ERR_TIMEOUT;
+        // GOTO
+        goto cleanup;
+    }
+
+    f_retval = _convert_echo_items(param_ptr_config, ptr_rx_item, rx_size / sizeof(rmt_item32_t), &raw_data);
+    vRingbufferReturnItem(rb, (void*) ptr_rx_item);
+
+    // @doc The filter is read by mjd_jsnsr04t_get_ranging_data(): update it in the same critical section (a median of max
+    //      MJD_JSNSR04T_FILTER_MAX_WINDOW_SIZE floats)
+    portENTER_CRITICAL(&jsnsr04t_spinlock);
+    if (f_retval == ESP_OK) {
+        f_retval = mjd_jsnsr04t_filter_add(&param_ptr_config->ranging_filter, raw_data.distance_cm, &median_cm);
+    }
+    ++param_ptr_config->ranging_stats.nbr_of_echoes;
+    if (raw_data.is_an_error == true) {
+        ++param_ptr_config->ranging_stats.nbr_of_invalid_echoes;
+    } else if (f_retval != ESP_OK) {
+        ++param_ptr_config->ranging_stats.nbr_of_outliers;
+    } else {
+        param_ptr_config->ranging_distance_cm = median_cm;
+    }
+    portEXIT_CRITICAL(&jsnsr04t_spinlock);
 
     // LABEL
     cleanup: ;
 
     return f_retval;
 }
+
+esp_err_t mjd_jsnsr04t_start_ranging(mjd_jsnsr04t_config_t* param_ptr_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_config->is_init != true || param_ptr_config->is_ranging == true) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. The component is not init'd or continuous ranging is already active | err %i (%s)", __FUNCTION__,
+                f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (param_ptr_config->ranging_ping_period_ms < MJD_JSNSR04T_MIN_PING_PERIOD_MS) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. ranging_ping_period_ms < %u (%u) | err %i (%s)", __FUNCTION__, MJD_JSNSR04T_MIN_PING_PERIOD_MS,
+                param_ptr_config->ranging_ping_period_ms, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    f_retval = mjd_jsnsr04t_filter_init(&param_ptr_config->ranging_filter, param_ptr_config->ranging_window_size,
+            param_ptr_config->filter_hampel_k, param_ptr_config->filter_hampel_min_deviation_cm);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. mjd_jsnsr04t_filter_init() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    portENTER_CRITICAL(&jsnsr04t_spinlock);
+    memset(&param_ptr_config->ranging_stats, 0, sizeof(param_ptr_config->ranging_stats));
+    param_ptr_config->ranging_distance_cm = 0.0;
+    portEXIT_CRITICAL(&jsnsr04t_spinlock);
+
+    /**********
+     * RMT: arm the RX channel (it stays armed until the ranging task exits)
+     */
+    f_retval = rmt_set_rx_idle_thresh(param_ptr_config->rmt_channel, MJD_JSNSR04T_RMT_IDLE_THRESHOLD_RANGING_US);
+    if (f_retval == ESP_OK) {
+        f_retval = rmt_rx_start(param_ptr_config->rmt_channel, true);
+    }
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. rmt_set_rx_idle_thresh() | rmt_rx_start() | err %i (%s)", __FUNCTION__, f_retval,
+                esp_err_to_name(f_retval));
+        rmt_set_rx_idle_thresh(param_ptr_config->rmt_channel, MJD_JSNSR04T_RMT_IDLE_THRESHOLD_SINGLE_US);
+        // GOTO
+        goto cleanup;
+    }
+
+    param_ptr_config->is_ranging_stop_requested = false;
+    param_ptr_config->is_ranging = true;
+
+    /**********
+     * TASK
+     *  @important For stability (RMT + Wifi etc.): always use xTaskCreatePinnedToCore(APP_CPU_NUM)
+     */
+    BaseType_t xReturned = xTaskCreatePinnedToCore(&_ranging_task, "mjd_jsnsr04t_ranging", MJD_JSNSR04T_RANGING_TASK_STACK_SIZE,
+            param_ptr_config, MJD_JSNSR04T_RANGING_TASK_PRIORITY, &param_ptr_config->ranging_task_handle, APP_CPU_NUM);
+    if (xReturned != pdPASS) {
+        param_ptr_config->is_ranging = false;
+        rmt_rx_stop(param_ptr_config->rmt_channel);
+        rmt_set_rx_idle_thresh(param_ptr_config->rmt_channel, MJD_JSNSR04T_RMT_IDLE_THRESHOLD_SINGLE_US);
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "%s(). ABORT. xTaskCreatePinnedToCore() failed | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    /**********
+     * TIMER: the pings
+     */
+    const esp_timer_create_args_t timer_args =
+        { .callback = &_ranging_timer_callback, .arg = param_ptr_config, .dispatch_method = ESP_TIMER_TASK, .name = "mjd_jsnsr04t_ping" };
+
+    param_ptr_config->ranging_timer_handle = NULL;
+    f_retval = esp_timer_create(&timer_args, &param_ptr_config->ranging_timer_handle);
+    if (f_retval == ESP_OK) {
+        f_retval = esp_timer_start_periodic(param_ptr_config->ranging_timer_handle, param_ptr_config->ranging_ping_period_ms * 1000);
+    }
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. esp_timer failed | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        if (param_ptr_config->ranging_timer_handle != NULL) {
+            esp_timer_delete(param_ptr_config->ranging_timer_handle);
+            param_ptr_config->ranging_timer_handle = NULL;
+        }
+        // The ranging task exits by itself (and disarms the RMT RX channel)
+        param_ptr_config->is_ranging_stop_requested = true;
+        // GOTO
+        goto cleanup;
+    }
+
+    ESP_LOGI(TAG, "Continuous ranging started: 1 ping every %u millisec", param_ptr_config->ranging_ping_period_ms);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_jsnsr04t_stop_ranging(mjd_jsnsr04t_config_t* param_ptr_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_config->is_ranging != true) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. Continuous ranging is not active | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    if (param_ptr_config->ranging_timer_handle != NULL) {
+        esp_timer_stop(param_ptr_config->ranging_timer_handle);
+        esp_timer_delete(param_ptr_config->ranging_timer_handle);
+        param_ptr_config->ranging_timer_handle = NULL;
+    }
+
+    param_ptr_config->is_ranging_stop_requested = true;
+
+    // Wait for the task to process its last echo
+    for (uint32_t idx = 0; idx < 100 && param_ptr_config->is_ranging == true; idx++) {
+        vTaskDelay(RTOS_DELAY_10MILLISEC);
+    }
+    if (param_ptr_config->is_ranging == true) {
+        f_retval = ESP_ERR_TIMEOUT;
+        ESP_LOGE(TAG, "%s(). ABORT. The ranging task did not stop | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_jsnsr04t_get_ranging_data(mjd_jsnsr04t_config_t* param_ptr_config, mjd_jsnsr04t_data_t* param_ptr_data) {
+    esp_err_t f_retval = ESP_OK;
+
+    portENTER_CRITICAL(&jsnsr04t_spinlock);
+    param_ptr_data->data_received = (param_ptr_config->ranging_filter.nbr_of_accepted > 0);
+    param_ptr_data->is_an_error = false;
+    param_ptr_data->distance_cm = param_ptr_config->ranging_distance_cm;
+    portEXIT_CRITICAL(&jsnsr04t_spinlock);
+
+    return f_retval;
+}
+
+esp_err_t mjd_jsnsr04t_get_ranging_stats(mjd_jsnsr04t_config_t* param_ptr_config, mjd_jsnsr04t_ranging_stats_t* param_ptr_stats) {
+    esp_err_t f_retval = ESP_OK;
+
+    portENTER_CRITICAL(&jsnsr04t_spinlock);
+    *param_ptr_stats = param_ptr_config->ranging_stats;
+    portEXIT_CRITICAL(&jsnsr04t_spinlock);
+
+    return f_retval;
+}
@@ -8,18 +8,21 @@
 extern "C" {
 #endif
 
+#include "mjd_gpio_events.h"
+
 /**
  * Data structs
  */
 typedef struct {
     gpio_num_t data_gpio_num;
-    SemaphoreHandle_t gpio_isr_mux;
+    uint32_t debounce_ms;                    /*!< The contact bounce of the sensor is handled by mjd_gpio_events */
+    mjd_gpio_events_subscriber_t subscriber; /*!< Private */
     bool is_init;
 } mjd_ky032_config_t;
 
 #define MJD_KY032_CONFIG_DEFAULT() { \
     .data_gpio_num = GPIO_NUM_0, \
-    .gpio_isr_mux = NULL, \
+    .debounce_ms = 100, \
     .is_init = false \
 }
 
@@ -28,6 +31,7 @@ typedef struct {
  */
 esp_err_t mjd_ky032_init(mjd_ky032_config_t* ptr_param_config);
 esp_err_t mjd_ky032_deinit(mjd_ky032_config_t* ptr_param_config);
+esp_err_t mjd_ky032_wait_for_detection(mjd_ky032_config_t* ptr_param_config, mjd_gpio_events_event_t* param_ptr_event, TickType_t param_ticks_to_wait);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,134 @@
+/*
+ * Goto README.md for instructions
+ */
+#ifndef __MJD_LEDRGB_EFFECT_H__
+#define __MJD_LEDRGB_EFFECT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mjd_ledrgb.h"
+
+/**
+ * EFFECT ENGINE
+ *
+ * @doc The renderer is a pure function: (effect, frame number) => LED color values. No floating point, no malloc.
+ * @doc The engine renders the effect of each LED Strip in place in the LED color values of the strip (preallocated by mjd_ledrgb_init())
+ *      and submits all strips with a single frame sync, at a fixed frame rate (esp_timer) in a task on the APP CPU.
+ */
+#define MJD_LEDRGB_PALETTE_SIZE (16)
+#define MJD_LEDRGB_EFFECT_ENGINE_MAX_FPS (200)
+
+/**
+ * @brief The effects
+ */
+typedef enum {
+    MJD_LEDRGB_EFFECT_NONE = 0, /*!< The engine does not touch the LED Strip */
+    MJD_LEDRGB_EFFECT_SOLID, /*!< All LEDs color_a */
+    MJD_LEDRGB_EFFECT_FADE, /*!< All LEDs fade from color_a to color_b in period_frames, and back */
+    MJD_LEDRGB_EFFECT_CHASE, /*!< A segment of length LEDs in color_a moves 1 LED every period_frames over a color_b background */
+    MJD_LEDRGB_EFFECT_PALETTE, /*!< The palette is spread over length LEDs (with blending) and scrolls 1 LED every period_frames (0 = static) */
+    MJD_LEDRGB_EFFECT_MAX
+} mjd_ledrgb_effect_type_t;
+
+/**
+ * @brief The effect properties
+ */
+typedef struct {
+        mjd_ledrgb_effect_type_t type;
+        mjd_ledrgb_led_t color_a; /*!< SOLID color | FADE start color | CHASE segment color */
+        mjd_ledrgb_led_t color_b; /*!< FADE end color | CHASE background color */
+        uint32_t period_frames; /*!< FADE frames from color_a to color_b | CHASE, PALETTE frames per 1 LED step */
+        uint32_t length; /*!< CHASE nbr of LEDs of the segment | PALETTE nbr of LEDs for the full palette (0 = nbr_of_leds of the strip) */
+        const mjd_ledrgb_led_t *ptr_palette; /*!< PALETTE MJD_LEDRGB_PALETTE_SIZE colors, e.g. mjd_ledrgb_palette_rainbow */
+} mjd_ledrgb_effect_t;
+
+/**
+ * @brief Predefined palettes
+ */
+extern const mjd_ledrgb_led_t mjd_ledrgb_palette_rainbow[MJD_LEDRGB_PALETTE_SIZE];
+extern const mjd_ledrgb_led_t mjd_ledrgb_palette_heat[MJD_LEDRGB_PALETTE_SIZE];
+
+/**
+ * @brief The effect engine config
+ */
+typedef struct {
+        uint32_t fps; /*!< The fixed frame rate [1..MJD_LEDRGB_EFFECT_ENGINE_MAX_FPS] */
+        UBaseType_t task_priority;
+        uint32_t task_stack_size;
+} mjd_ledrgb_effect_engine_config_t;
+
+#define MJD_LEDRGB_EFFECT_ENGINE_CONFIG_DEFAULT() { \
+    .fps = 50, \
+    .task_priority = RTOS_TASK_PRIORITY_NORMAL, \
+    .task_stack_size = 4096 \
+}
+
+/**
+ * @brief The effect engine statistics
+ */
+typedef struct {
+        uint32_t nbr_of_frames; /*!< The number of frames rendered & submitted */
+        uint32_t nbr_of_dropped_frames; /*!< The number of timer ticks that were skipped because a frame took longer than the frame period */
+} mjd_ledrgb_effect_engine_stats_t;
+
+/**
+ * Function declarations
+ */
+
+/**
+ * @brief Render frame #frame_nbr of an effect into an array of LED color values.
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG
+ */
+esp_err_t mjd_ledrgb_effect_render(const mjd_ledrgb_effect_t* param_ptr_effect, uint32_t param_frame_nbr, mjd_ledrgb_led_t* param_ptr_leds,
+                                   uint32_t param_nbr_of_leds);
+
+/**
+ * @brief Assign an effect to an initialized LED Strip (the effect is copied). The effect starts at frame 0.
+ *        NULL or MJD_LEDRGB_EFFECT_NONE: the engine no longer touches the LED Strip.
+ *
+ * @return
+ *     - ESP_OK Success
+ */
+esp_err_t mjd_ledrgb_effect_set(mjd_ledrgb_strip_identifier_t param_strip_id, const mjd_ledrgb_effect_t* param_ptr_effect);
+
+/**
+ * @brief Render the next frame of all LED Strips that have an effect and submit them with a single frame sync.
+ *        The engine task calls it at the fixed frame rate; an app without the engine task (or a unit test) can call it directly.
+ *
+ * @return
+ *     - ESP_OK Success
+ */
+esp_err_t mjd_ledrgb_effect_engine_render_frame(void);
+
+/**
+ * @brief Start the engine task (APP CPU) and its periodic esp_timer.
+ *
+ * @return
+ *     - ESP_OK Success
+ */
+esp_err_t mjd_ledrgb_effect_engine_start(const mjd_ledrgb_effect_engine_config_t* param_ptr_config);
+
+/**
+ * @brief Stop the esp_timer and wait (max 1 second) until the engine task has finished its last frame.
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_TIMEOUT The task did not stop
+ */
+esp_err_t mjd_ledrgb_effect_engine_stop(void);
+
+/**
+ * @brief Get the engine statistics.
+ */
+esp_err_t mjd_ledrgb_effect_engine_get_stats(mjd_ledrgb_effect_engine_stats_t* param_ptr_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_LEDRGB_EFFECT_H__ */
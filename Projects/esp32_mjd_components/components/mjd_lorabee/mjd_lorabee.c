@@ -8,6 +8,7 @@
  */
 #include "mjd.h"
 #include "mjd_lorabee.h"
+#include "mjd_trace.h"
 
 /*
  * Logging
@@ -485,32 +486,49 @@ static int _response_text_to_status_code(const char *param_ptr_response) {
 /*
  * @brief Execute command and read the RX Response#1 (not #2!)
  *
+ * @param param_ptr_hex_payload Optional (NULL) binary payload. It is hex-encoded straight into the UART TX buffer after the command text.
+ *
+ * @doc Writing the command text, the hex payload and the \r\n separately avoids copying the command into a 470 bytes stack buffer.
  */
-esp_err_t mjd_lorabee_cmd(mjd_lorabee_config_t* param_ptr_config, const char* param_ptr_command,
-                          mjd_lorabee_response_t* param_ptr_response) {
+static esp_err_t _cmd_with_hex_payload(mjd_lorabee_config_t* param_ptr_config, const char* param_ptr_command,
+                                       const uint8_t* param_ptr_hex_payload, size_t param_len_hex_payload,
+                                       mjd_lorabee_response_t* param_ptr_response) {
     ESP_LOGD(TAG, "%s()", __FUNCTION__);
 
     esp_err_t f_retval = ESP_OK;
 
     _uart_flush_queue_reset(param_ptr_config);
 
-    // UART Send command
-    // @size At least = max command byte length + max Lora TX payload + \r\n
-    char command[MJD_LORABEE_TX_COMMAND_MAX_SIZE] = "";
-    strcpy(command, param_ptr_command);
-    ESP_LOGD(TAG, "command (without CarriageReturn & NewLine: len=%zu val=%s", strlen(command), command);
-    strcat(command, "\r\n");
+    // @doc The probe covers the whole round-trip: UART TX command => RX response#1 (also when it fails)
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_LORABEE_CMD);
 
-    f_retval = uart_write_bytes(param_ptr_config->uart_port_num, command, strlen(command));
-    if (f_retval == ESP_FAIL) {
+    // UART Send command (+ hex payload) + \r\n
+    ESP_LOGD(TAG, "command (without CarriageReturn & NewLine: len=%zu val=%s (+ hex payload %zu bytes)", strlen(param_ptr_command),
+            param_ptr_command, param_len_hex_payload);
+
+    if (uart_write_bytes(param_ptr_config->uart_port_num, param_ptr_command, strlen(param_ptr_command)) == ESP_FAIL) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). uart_write_bytes() err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        ++param_ptr_config->nbr_of_errors;
+        // GOTO
+        goto cleanup;
+    }
+    if (param_ptr_hex_payload != NULL) {
+        f_retval = mjd_uint8s_to_hexstring_uart(param_ptr_config->uart_port_num, param_ptr_hex_payload, param_len_hex_payload);
+        if (f_retval != ESP_OK) {
+            ESP_LOGE(TAG, "%s(). mjd_uint8s_to_hexstring_uart() err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+            ++param_ptr_config->nbr_of_errors;
+            // GOTO
+            goto cleanup;
+        }
+    }
+    if (uart_write_bytes(param_ptr_config->uart_port_num, "\r\n", 2) == ESP_FAIL) {
+        f_retval = ESP_FAIL;
         ESP_LOGE(TAG, "%s(). uart_write_bytes() err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
         ++param_ptr_config->nbr_of_errors;
         // GOTO
         goto cleanup;
     }
-
-    // Mark ESP_OK (uart_write_bytes() returns ESP_FAIL or #bytes written...)
-    f_retval = ESP_OK;
 
     // RX response#1
     ESP_LOGD(TAG, "RX response#1");
@@ -518,7 +536,7 @@ esp_err_t mjd_lorabee_cmd(mjd_lorabee_config_t* param_ptr_config, const char* pa
     int len_line_uart = 0;
 
     // ONLY relevant for `sys sleep` which gives no uart output at all (no RX response#1)
-    if (mjd_string_starts_with(command, "sys sleep") == true) {
+    if (mjd_string_starts_with(param_ptr_command, "sys sleep") == true) {
         // GOTO
         goto cleanup;
     }
@@ -544,9 +562,18 @@ esp_err_t mjd_lorabee_cmd(mjd_lorabee_config_t* param_ptr_config, const char* pa
     // LABEL
     cleanup: ;
 
+    MJD_TRACE_END(MJD_TRACE_PROBE_LORABEE_CMD);
+
     return f_retval;
 }
 
+esp_err_t mjd_lorabee_cmd(mjd_lorabee_config_t* param_ptr_config, const char* param_ptr_command,
+                          mjd_lorabee_response_t* param_ptr_response) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    return _cmd_with_hex_payload(param_ptr_config, param_ptr_command, NULL, 0, param_ptr_response);
+}
+
 static esp_err_t _mjd_lorabee_get_key_returning_string_value(mjd_lorabee_config_t* param_ptr_config,
                                                              char * param_ptr_category,
                                                              char * param_ptr_key,
@@ -1385,16 +1412,6 @@ esp_err_t mjd_lorabee_radio_tx(mjd_lorabee_config_t* param_ptr_config, uint8_t*
         goto cleanup;
     }
 
-    char command[MJD_LORABEE_TX_COMMAND_MAX_SIZE] = ""; // @important Also reserve bytes for the command prefix
-    f_retval = mjd_uint8s_to_hexstring(param_ptr_payload, param_len, command);
-    if (f_retval != ESP_OK) {
-        ESP_LOGE(TAG, "ABORT %s(). mjd_uint8s_to_hexstring() failed | err %i (%s)", __FUNCTION__, f_retval,
-                esp_err_to_name(f_retval));
-        goto cleanup;
-    }
-
-    mjd_string_prepend(command, MJD_LORABEE_REQUEST_PREFIX_RADIO_TX);
-
     uint8_t seq_execution = 0;
     while (true) {
         seq_execution++;
@@ -1409,7 +1426,8 @@ esp_err_t mjd_lorabee_radio_tx(mjd_lorabee_config_t* param_ptr_config, uint8_t*
 
         // cmd() RX Response#1
         mjd_lorabee_response_t response = MJD_LORABEE_RESPONSE_DEFAULT();
-        f_retval = mjd_lorabee_cmd(param_ptr_config, command, &response);
+        // @important The payload is hex-encoded straight into the UART TX buffer (no hex string copy of the payload)
+        f_retval = _cmd_with_hex_payload(param_ptr_config, MJD_LORABEE_REQUEST_PREFIX_RADIO_TX, param_ptr_payload, param_len, &response);
         if (f_retval == ESP_FAIL) {
             ++param_ptr_config->nbr_of_errors;
             ESP_LOGE(TAG, "    %s(). cmd-retval err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
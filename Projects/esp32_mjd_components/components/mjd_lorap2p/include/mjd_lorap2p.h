@@ -110,6 +110,9 @@ typedef struct {
     .payload = NULL, \
 }
 
+// Wire format: fixed header = prefix[3] + frame_type + source_address[3] + seq_nr + is_retry + destination_address[3] + len_payload
+#define MJD_LORAP2P_DATA_FRAME_HEADER_BYTES (13)
+
 typedef struct { /* TODO */
         uint8_t _prefix[3]; /*!< <~> */
         uint8_t frame_type; /*!< 'A'=ACK */
@@ -126,6 +129,10 @@ esp_err_t mjd_lorap2p_addr_to_string(const uint8_t param_ptr_input_addr[], size_
 esp_err_t mjd_lorap2p_log_config(mjd_lorap2p_config_t* param_ptr_config);
 esp_err_t mjd_lorap2p_log_data_frame_input(mjd_lorap2p_data_frame_input_t *param_ptr_data_frame);
 esp_err_t mjd_lorap2p_log_data_frame(mjd_lorap2p_data_frame_t *param_ptr_data_frame);
+esp_err_t mjd_lorap2p_serialize_data_frame(const mjd_lorap2p_data_frame_t *param_ptr_data_frame, uint8_t *param_ptr_output,
+                                           size_t param_size_output, size_t *param_ptr_len_output);
+esp_err_t mjd_lorap2p_deserialize_data_frame(const uint8_t *param_ptr_input, size_t param_len_input,
+                                             mjd_lorap2p_data_frame_t *param_ptr_data_frame);
 esp_err_t mjd_lorap2p_init(mjd_lorap2p_config_t* param_ptr_config);
 esp_err_t mjd_lorap2p_deinit(mjd_lorap2p_config_t* param_ptr_config);
 esp_err_t mjd_lorap2p_tx(mjd_lorap2p_config_t* param_ptr_config,
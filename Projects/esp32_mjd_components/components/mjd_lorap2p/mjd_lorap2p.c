@@ -126,7 +126,7 @@ esp_err_t mjd_lorap2p_addr_to_string(const uint8_t param_ptr_input_addr[], size_
         goto cleanup;
     }
 
-    size_t len_sprintf = sprintf(param_ptr_output, "%hhX:%hhX:%hhX",
+    size_t len_sprintf = sprintf(param_ptr_output, "%02hhX:%02hhX:%02hhX",
             param_ptr_input_addr[0], param_ptr_input_addr[1], param_ptr_input_addr[2]);
     if (len_sprintf != LEN_STRING) {
         f_retval = ESP_ERR_INVALID_ARG;
@@ -236,6 +236,116 @@ esp_err_t mjd_lorap2p_log_data_frame(mjd_lorap2p_data_frame_t *param_ptr_data) {
     return f_retval;
 }
 
+/*
+ * @brief Serialize a data frame to the wire format: the fixed header (MJD_LORAP2P_DATA_FRAME_HEADER_BYTES) followed by the payload.
+ *
+ * @doc Wire format: <~> 'D' SRC[3] SEQ RETRY DST[3] LEN PAYLOAD[LEN]
+ *      The receiver is a Node.js+USBUART app so the format is fixed and platform independent (no protobuf, no struct padding).
+ *
+ * @param param_ptr_len_output Number of bytes written to param_ptr_output.
+ */
+esp_err_t mjd_lorap2p_serialize_data_frame(const mjd_lorap2p_data_frame_t *param_ptr_data_frame, uint8_t *param_ptr_output,
+                                           size_t param_size_output, size_t *param_ptr_len_output) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    size_t pos = 0;
+
+    if (MJD_LORAP2P_DATA_FRAME_HEADER_BYTES + (size_t) param_ptr_data_frame->len_payload > param_size_output) {
+        f_retval = ESP_ERR_INVALID_SIZE;
+        ESP_LOGE(TAG, "%s(). ABORT. Output buffer too small (%zu bytes) | err %i (%s)", __FUNCTION__, param_size_output, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (param_ptr_data_frame->len_payload > 0 && param_ptr_data_frame->payload == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. payload is NULL | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    param_ptr_output[pos++] = param_ptr_data_frame->_prefix[0];
+    param_ptr_output[pos++] = param_ptr_data_frame->_prefix[1];
+    param_ptr_output[pos++] = param_ptr_data_frame->_prefix[2];
+    param_ptr_output[pos++] = param_ptr_data_frame->_frame_type;
+    param_ptr_output[pos++] = param_ptr_data_frame->source_address[0];
+    param_ptr_output[pos++] = param_ptr_data_frame->source_address[1];
+    param_ptr_output[pos++] = param_ptr_data_frame->source_address[2];
+    param_ptr_output[pos++] = param_ptr_data_frame->seq_nr;
+    param_ptr_output[pos++] = param_ptr_data_frame->is_retry;
+    param_ptr_output[pos++] = param_ptr_data_frame->destination_address[0];
+    param_ptr_output[pos++] = param_ptr_data_frame->destination_address[1];
+    param_ptr_output[pos++] = param_ptr_data_frame->destination_address[2];
+    param_ptr_output[pos++] = param_ptr_data_frame->len_payload;
+    if (param_ptr_data_frame->len_payload > 0) {
+        memcpy(&param_ptr_output[pos], param_ptr_data_frame->payload, param_ptr_data_frame->len_payload);
+        pos += param_ptr_data_frame->len_payload;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    *param_ptr_len_output = pos;
+
+    return f_retval;
+}
+
+/*
+ * @brief Deserialize the wire format into a data frame.
+ *
+ * @important Zero-copy: param_ptr_data_frame->payload points INTO param_ptr_input (keep that buffer alive).
+ */
+esp_err_t mjd_lorap2p_deserialize_data_frame(const uint8_t *param_ptr_input, size_t param_len_input,
+                                             mjd_lorap2p_data_frame_t *param_ptr_data_frame) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_len_input < MJD_LORAP2P_DATA_FRAME_HEADER_BYTES) {
+        f_retval = ESP_ERR_INVALID_SIZE;
+        ESP_LOGE(TAG, "%s(). ABORT. Input too short (%zu bytes) | err %i (%s)", __FUNCTION__, param_len_input, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (param_ptr_input[0] != '<' || param_ptr_input[1] != '~' || param_ptr_input[2] != '>') {
+        f_retval = ESP_ERR_INVALID_RESPONSE;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid frame prefix | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (param_ptr_input[3] != 'D') {
+        f_retval = ESP_ERR_NOT_SUPPORTED;
+        ESP_LOGE(TAG, "%s(). ABORT. Unsupported frame type 0x%02X | err %i (%s)", __FUNCTION__, param_ptr_input[3], f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (MJD_LORAP2P_DATA_FRAME_HEADER_BYTES + (size_t) param_ptr_input[12] != param_len_input) {
+        f_retval = ESP_ERR_INVALID_SIZE;
+        ESP_LOGE(TAG, "%s(). ABORT. Payload length %u does not match the input length %zu | err %i (%s)", __FUNCTION__,
+                param_ptr_input[12], param_len_input, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    memcpy(param_ptr_data_frame->_prefix, &param_ptr_input[0], 3);
+    param_ptr_data_frame->_frame_type = param_ptr_input[3];
+    memcpy(param_ptr_data_frame->source_address, &param_ptr_input[4], 3);
+    param_ptr_data_frame->seq_nr = param_ptr_input[7];
+    param_ptr_data_frame->is_retry = param_ptr_input[8];
+    memcpy(param_ptr_data_frame->destination_address, &param_ptr_input[9], 3);
+    param_ptr_data_frame->len_payload = param_ptr_input[12];
+    param_ptr_data_frame->payload = (param_ptr_data_frame->len_payload > 0) ? (uint8_t *) &param_ptr_input[MJD_LORAP2P_DATA_FRAME_HEADER_BYTES] : NULL;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
 /*
  * Init ^& Deinit
  */
@@ -384,7 +494,6 @@ esp_err_t mjd_lorap2p_tx(mjd_lorap2p_config_t* param_ptr_config,
 
     mjd_lorap2p_log_data_frame(&data_frame);
 
-    uint8_t* ptr_payload_data_frame;
     uint8_t payload_lorabee_[1024] = { 0 };
     size_t pos;
 
@@ -398,24 +507,12 @@ esp_err_t mjd_lorap2p_tx(mjd_lorap2p_config_t* param_ptr_config,
          * Serialize for transmission
          * TODO Use protobuf??? (I need to RX the data it in Node.js+USBUART so serdata must be platform independent!)
          */
-        pos = 0;
-        payload_lorabee_[pos++] = data_frame._prefix[0];
-        payload_lorabee_[pos++] = data_frame._prefix[1];
-        payload_lorabee_[pos++] = data_frame._prefix[2];
-        payload_lorabee_[pos++] = data_frame._frame_type;
-        payload_lorabee_[pos++] = data_frame.source_address[0];
-        payload_lorabee_[pos++] = data_frame.source_address[1];
-        payload_lorabee_[pos++] = data_frame.source_address[2];
-        payload_lorabee_[pos++] = data_frame.seq_nr;
-        payload_lorabee_[pos++] = data_frame.is_retry;
-        payload_lorabee_[pos++] = data_frame.destination_address[0];
-        payload_lorabee_[pos++] = data_frame.destination_address[1];
-        payload_lorabee_[pos++] = data_frame.destination_address[2];
-        payload_lorabee_[pos++] = data_frame.len_payload;
-        ptr_payload_data_frame = data_frame.payload;
-        for (int iter=0; iter < data_frame.len_payload; iter++) {
-            payload_lorabee_[pos++] = *(ptr_payload_data_frame);
-            ptr_payload_data_frame++;
+        f_retval = mjd_lorap2p_serialize_data_frame(&data_frame, payload_lorabee_, sizeof(payload_lorabee_), &pos);
+        if (f_retval != ESP_OK) {
+            ++param_ptr_config->_nbr_of_errors;
+            ESP_LOGE(TAG, "ABORT %s(). mjd_lorap2p_serialize_data_frame() failed | err %i (%s)", __FUNCTION__, f_retval,
+                    esp_err_to_name(f_retval));
+            goto cleanup;
         }
         size_t len_payload_lorabee = pos; // @important Can be bigger than 255 so cannot use uint8_t
 
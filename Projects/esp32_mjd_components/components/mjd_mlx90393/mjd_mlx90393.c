@@ -6,6 +6,7 @@
 // Component header file(s)
 #include "mjd.h"
 #include "mjd_mlx90393.h"
+#include "mjd_trace.h"
 
 /*
  * Logging
@@ -236,7 +237,9 @@ static esp_err_t _send_cmd(const mjd_mlx90393_config_t* param_ptr_config, mjd_ml
         goto cleanup;
     }
 
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_I2C_TRANSACTION);
     f_retval = i2c_master_cmd_begin(param_ptr_config->i2c_port_num, handle, MJD_MLX90393_I2C_TIMEOUT_DEFAULT);
+    MJD_TRACE_END(MJD_TRACE_PROBE_I2C_TRANSACTION);
     if (f_retval != ESP_OK) {
         ESP_LOGE(TAG, "%s(). ABORT. Receive response i2c_master_cmd_begin() err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
         i2c_cmd_link_delete(handle);
@@ -364,7 +367,9 @@ static esp_err_t _read_register(const mjd_mlx90393_config_t* param_ptr_config, m
         goto cleanup;
     }
 
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_I2C_TRANSACTION);
     f_retval = i2c_master_cmd_begin(param_ptr_config->i2c_port_num, handle, MJD_MLX90393_I2C_TIMEOUT_DEFAULT);
+    MJD_TRACE_END(MJD_TRACE_PROBE_I2C_TRANSACTION);
     if (f_retval != ESP_OK) {
         ESP_LOGE(TAG, "%s(). ABORT. Receive response i2c_master_cmd_begin() err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
         i2c_cmd_link_delete(handle);
@@ -504,7 +509,9 @@ static esp_err_t _write_register(const mjd_mlx90393_config_t* param_ptr_config,
         goto cleanup;
     }
 
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_I2C_TRANSACTION);
     f_retval = i2c_master_cmd_begin(param_ptr_config->i2c_port_num, handle, MJD_MLX90393_I2C_TIMEOUT_DEFAULT);
+    MJD_TRACE_END(MJD_TRACE_PROBE_I2C_TRANSACTION);
     if (f_retval != ESP_OK) {
         ESP_LOGE(TAG, "%s(). ABORT. Receive response i2c_master_cmd_begin() err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
         i2c_cmd_link_delete(handle);
@@ -2187,7 +2194,9 @@ esp_err_t mjd_mlx90393_cmd_read_measurement(const mjd_mlx90393_config_t* param_p
         goto cleanup;
     }
 
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_I2C_TRANSACTION);
     f_retval = i2c_master_cmd_begin(param_ptr_config->i2c_port_num, handle, MJD_MLX90393_I2C_TIMEOUT_DEFAULT);
+    MJD_TRACE_END(MJD_TRACE_PROBE_I2C_TRANSACTION);
     if (f_retval != ESP_OK) {
         ESP_LOGE(TAG, "%s(). ABORT. Receive response i2c_master_cmd_begin() err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
         i2c_cmd_link_delete(handle);
@@ -10,6 +10,8 @@ extern "C" {
 
 // Includes
 #include "esp_mqtt.h"
+#include "mjd_mqtt_trie.h"
+#include "mjd_mqtt_compact.h"
 
 // Defines
 #define MJD_MQTT_LOG_MQTT_PUBLISH (false)
@@ -24,16 +26,56 @@ extern "C" {
 #define MJD_MQTT_QOS_0 (0)
 #define MJD_MQTT_QOS_1 (1)
 
+// Subscriptions
+#define MJD_MQTT_MAX_SUBSCRIPTIONS (16) // @important <= MJD_MQTT_TRIE_MAX_SUBSCRIPTIONS
+#define MJD_MQTT_TOPIC_FILTER_MAX_LEN (127)
+
+// Compact readings
+#define MJD_MQTT_READINGS_QOS (MJD_MQTT_QOS_1)
+
 // TBD Constants
 
 // Typedefs
 
+/**
+ * @brief An inbound message (borrowed).
+ *
+ * @doc Zero-copy: the topic and the payload (both NUL terminated) live in a preallocated inbox slot of esp-mqtt.
+ * @rule The message is valid until the handler returns. It must not be modified.
+ * @rule To keep it longer (e.g. hand it to another task): call mjd_mqtt_message_retain() in the handler
+ *       and mjd_mqtt_message_release() when done. A retained message occupies an inbox slot (max CONFIG_ESP_MQTT_EVENT_QUEUE_SIZE).
+ */
+typedef esp_mqtt_message_t mjd_mqtt_message_t;
+
+/**
+ * @brief The handler of a subscription. It runs in the esp_mqtt task: do not block.
+ */
+typedef void (*mjd_mqtt_message_handler_t)(mjd_mqtt_message_t *ptr_message, void *ptr_arg);
+
+typedef struct {
+    uint32_t nbr_of_messages_dispatched; /*!< Handler calls */
+    uint32_t nbr_of_messages_unmatched;  /*!< No subscription matches the topic */
+    esp_mqtt_inbox_stats_t inbox;        /*!< received, dropped_full, dropped_too_big, min_free_slots */
+    mjd_mqtt_compact_stats_t readings;   /*!< bytes_per_reading vs baseline_bytes_per_reading (1 PUBLISH per reading on its long topic) */
+} mjd_mqtt_stats_t;
+
 // Function Declarations
 esp_err_t mjd_mqtt_init(size_t buffer_size, int command_timeout);
 esp_err_t mjd_mqtt_start(const char *host, const char *port, const char *client_id, const char *username, const char *password);
 esp_err_t mjd_mqtt_publish(const char *topic, uint8_t *payload, size_t len, int qos, bool retained);
 esp_err_t mjd_mqtt_stop();
 
+esp_err_t mjd_mqtt_subscribe(const char *topic_filter, int qos, mjd_mqtt_message_handler_t handler, void *ptr_arg);
+esp_err_t mjd_mqtt_unsubscribe(const char *topic_filter, mjd_mqtt_message_handler_t handler);
+void mjd_mqtt_message_retain(mjd_mqtt_message_t *ptr_message);
+void mjd_mqtt_message_release(mjd_mqtt_message_t *ptr_message);
+esp_err_t mjd_mqtt_get_stats(mjd_mqtt_stats_t *ptr_stats);
+
+esp_err_t mjd_mqtt_readings_init(const char *prefix, uint32_t max_readings_per_batch);
+esp_err_t mjd_mqtt_readings_register(const char *long_topic, uint8_t decimals, uint16_t *ptr_topic_id);
+esp_err_t mjd_mqtt_readings_publish(uint16_t topic_id, float value, int64_t timestamp_ms);
+esp_err_t mjd_mqtt_readings_flush();
+
 #ifdef __cplusplus
 }
 #endif
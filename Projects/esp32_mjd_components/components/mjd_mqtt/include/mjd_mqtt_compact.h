@@ -0,0 +1,129 @@
+/*
+ *
+ */
+#ifndef __MJD_MQTT_COMPACT_H__
+#define __MJD_MQTT_COMPACT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * COMPACT READINGS (registered topic ids + binary batches)
+ *
+ * @doc Pure logic (no RTOS, no network) so the host tests can drive it. The PUBLISH itself is done by the callback.
+ * @doc A long topic ("meteohub/current/temperature") is registered once and gets a topic id. The topic id is announced ONCE per connection
+ *      with a retained message, before its first reading:
+ *          topic   <prefix>/r/<id>
+ *          payload <decimals>:<long topic>     e.g. "2:meteohub/current/temperature"
+ * @doc max_readings_per_batch <= 1: each reading is published on its short topic with an ASCII payload:
+ *          topic   <prefix>/<id>
+ *          payload the value with <decimals> decimals, e.g. "23.46"
+ * @doc max_readings_per_batch > 1: the readings are packed in 1 binary payload per publish:
+ *          topic   <prefix>/b
+ *          payload [version=1] [varint: timestamp_ms of the 1st reading]
+ *                  then per reading: [varint: topic id] [zigzag varint: timestamp_ms - timestamp_ms of the previous reading]
+ *                                    [zigzag varint: round(value * 10^decimals)]
+ *      A varint is the base-128 encoding of protobuf (7 bits per byte, LSB group first, MSB = continuation bit).
+ *      A reading of a few bytes is typical (topic id < 128, a delta of seconds, a small value). mjd_mqtt_compact_decode() decodes a batch.
+ * @doc MQTT v5 topic aliases are not used: lwmqtt (esp-mqtt) speaks MQTT v3.1.1. The topic id scheme works with any v3.1.1 broker.
+ */
+#define MJD_MQTT_COMPACT_MAX_TOPICS         (32)
+#define MJD_MQTT_COMPACT_TOPIC_MAX_LEN      (127)
+#define MJD_MQTT_COMPACT_PREFIX_MAX_LEN     (15)
+#define MJD_MQTT_COMPACT_SHORT_TOPIC_MAX_LEN (MJD_MQTT_COMPACT_PREFIX_MAX_LEN + 8) /*!< "<prefix>/r/<id>" */
+#define MJD_MQTT_COMPACT_MAX_DECIMALS       (6)
+#define MJD_MQTT_COMPACT_BATCH_MAX_LEN      (256)
+#define MJD_MQTT_COMPACT_BATCH_VERSION      (1)
+
+/**
+ * @brief Publish 1 message (e.g. mjd_mqtt_publish()). The topic is NUL terminated, the payload is not.
+ */
+typedef esp_err_t (*mjd_mqtt_compact_publish_t)(const char *topic, const uint8_t *payload, size_t len, bool retained, void *ptr_arg);
+
+/**
+ * @brief A decoded reading of a batch (the receiving side and the tests).
+ */
+typedef void (*mjd_mqtt_compact_reading_handler_t)(uint16_t topic_id, int32_t scaled_value, int64_t timestamp_ms, void *ptr_arg);
+
+typedef struct {
+    const char *prefix;                   /*!< Unique per device, e.g. "c/gw1" */
+    uint32_t max_readings_per_batch;      /*!< 0 or 1 = no batches, 1 publish per reading */
+    int qos;                              /*!< Only used for the wire statistics (the packet id of QoS 1) */
+    mjd_mqtt_compact_publish_t publish;
+    void *ptr_publish_arg;
+} mjd_mqtt_compact_config_t;
+
+#define MJD_MQTT_COMPACT_CONFIG_DEFAULT() { \
+    .prefix = "c", \
+    .max_readings_per_batch = 0, \
+    .qos = 0, \
+    .publish = NULL, \
+    .ptr_publish_arg = NULL \
+}
+
+/**
+ * @brief The statistics.
+ *
+ * @doc wire bytes = the MQTT PUBLISH packets: fixed header + remaining length + topic + packet id (QoS 1) + payload. The announcements are included.
+ * @doc baseline bytes = the same readings as 1 PUBLISH each on the long topic with an ASCII payload (what mjd_mqtt_publish() would send).
+ */
+typedef struct {
+    uint32_t nbr_of_readings;
+    uint32_t nbr_of_publishes;             /*!< Readings or batches */
+    uint32_t nbr_of_announcements;
+    uint32_t nbr_of_publish_errors;
+    uint32_t nbr_of_wire_bytes;
+    uint32_t nbr_of_baseline_bytes;
+    float bytes_per_reading;
+    float baseline_bytes_per_reading;
+} mjd_mqtt_compact_stats_t;
+
+/**
+ * @brief A registered topic. All fields are Private.
+ */
+typedef struct {
+    bool is_used;
+    bool is_announced;
+    uint8_t decimals;
+    char long_topic[MJD_MQTT_COMPACT_TOPIC_MAX_LEN + 1];
+} mjd_mqtt_compact_topic_t;
+
+/**
+ * @brief The context. All fields are Private.
+ */
+typedef struct {
+    char prefix[MJD_MQTT_COMPACT_PREFIX_MAX_LEN + 1];
+    uint32_t max_readings_per_batch;
+    int qos;
+    mjd_mqtt_compact_publish_t publish;
+    void *ptr_publish_arg;
+
+    mjd_mqtt_compact_topic_t topics[MJD_MQTT_COMPACT_MAX_TOPICS];
+
+    uint8_t batch[MJD_MQTT_COMPACT_BATCH_MAX_LEN];
+    size_t batch_len;
+    uint32_t batch_nbr_of_readings;
+    int64_t batch_last_timestamp_ms;
+
+    mjd_mqtt_compact_stats_t stats;
+} mjd_mqtt_compact_t;
+
+/**
+ * Function declarations
+ */
+esp_err_t mjd_mqtt_compact_init(mjd_mqtt_compact_t* param_ptr_ctx, const mjd_mqtt_compact_config_t* param_ptr_config);
+esp_err_t mjd_mqtt_compact_register(mjd_mqtt_compact_t* param_ptr_ctx, const char* param_ptr_long_topic, uint8_t param_decimals,
+                                    uint16_t* param_ptr_topic_id);
+void mjd_mqtt_compact_reset_announcements(mjd_mqtt_compact_t* param_ptr_ctx);
+esp_err_t mjd_mqtt_compact_add_reading(mjd_mqtt_compact_t* param_ptr_ctx, uint16_t param_topic_id, float param_value, int64_t param_timestamp_ms);
+esp_err_t mjd_mqtt_compact_flush(mjd_mqtt_compact_t* param_ptr_ctx);
+void mjd_mqtt_compact_get_stats(const mjd_mqtt_compact_t* param_ptr_ctx, mjd_mqtt_compact_stats_t* param_ptr_stats);
+esp_err_t mjd_mqtt_compact_decode(const uint8_t* param_ptr_payload, size_t param_len, mjd_mqtt_compact_reading_handler_t param_handler,
+                                  void* param_ptr_arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_MQTT_COMPACT_H__ */
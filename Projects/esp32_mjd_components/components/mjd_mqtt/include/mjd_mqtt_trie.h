@@ -0,0 +1,63 @@
+/*
+ *
+ */
+#ifndef __MJD_MQTT_TRIE_H__
+#define __MJD_MQTT_TRIE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * TOPIC FILTER TRIE
+ *
+ * @doc Pure logic (no RTOS, no network) so the host tests can drive it.
+ * @doc 1 node per topic level, shared by the filters with the same prefix: "mjd/+/temperature" and "mjd/+/humidity" use 4 nodes.
+ *      The node at the end of a filter holds a bit per subscription. Matching a topic walks the levels once and returns the bitmask
+ *      of all the subscriptions that match (a subscription is reported once even when several of its paths match).
+ * @doc MQTT v3.1.1 wildcards: "+" = exactly 1 level, "#" = 0 or more levels (only as the last level: "a/#" also matches "a").
+ *      Topics that start with "$" ($SYS/...) do not match a wildcard in the first level.
+ * @doc The nodes are a fixed array: no heap allocations, the level names are stored in the node.
+ */
+#define MJD_MQTT_TRIE_MAX_NODES         (48)
+#define MJD_MQTT_TRIE_MAX_SUBSCRIPTIONS (32)  /*!< The bits of mjd_mqtt_trie_node_t.subscription_mask */
+#define MJD_MQTT_TRIE_LEVEL_MAX_LEN     (31)
+#define MJD_MQTT_TRIE_MAX_DEPTH         (16)
+
+#define MJD_MQTT_TRIE_NO_NODE (-1)
+
+/**
+ * @brief A topic level. All fields are Private.
+ */
+typedef struct {
+    char level[MJD_MQTT_TRIE_LEVEL_MAX_LEN + 1];
+    uint8_t level_len;
+    int16_t parent;
+    int16_t first_child;
+    int16_t next_sibling;       /*!< Also the link of the free list */
+    uint32_t subscription_mask; /*!< The subscriptions whose filter ends at this node */
+} mjd_mqtt_trie_node_t;
+
+/**
+ * @brief The trie. nodes[0] = the root (no level).
+ */
+typedef struct {
+    mjd_mqtt_trie_node_t nodes[MJD_MQTT_TRIE_MAX_NODES];
+    int16_t first_free;
+    uint32_t nbr_of_nodes_used;
+} mjd_mqtt_trie_t;
+
+/**
+ * Function declarations
+ */
+void mjd_mqtt_trie_init(mjd_mqtt_trie_t* param_ptr_trie);
+esp_err_t mjd_mqtt_trie_validate_filter(const char* param_ptr_filter);
+esp_err_t mjd_mqtt_trie_insert(mjd_mqtt_trie_t* param_ptr_trie, const char* param_ptr_filter, uint32_t param_subscription_index);
+esp_err_t mjd_mqtt_trie_remove(mjd_mqtt_trie_t* param_ptr_trie, const char* param_ptr_filter, uint32_t param_subscription_index);
+uint32_t mjd_mqtt_trie_match(const mjd_mqtt_trie_t* param_ptr_trie, const char* param_ptr_topic, size_t param_topic_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_MQTT_TRIE_H__ */
@@ -11,6 +11,7 @@
 // Component header file(s)
 #include "mjd.h"
 #include "mjd_mqtt.h"
+#include "mjd_trace.h"
 
 /**********
  * Logging
@@ -25,6 +26,43 @@ static bool is_mqtt_started = false;
 static uint32_t total_nbr_of_fatal_mqtt_publish_errors = 0;
 static uint32_t total_nbr_of_mqtt_publish_errors = 0;
 
+/**********
+ * Subscriptions
+ * @doc The trie maps a topic to a bitmask of subscription indexes (bit N = _mqtt_subscriptions[N]).
+ * @important Guarded by _mqtt_subscriptions_mutex: the handlers run in the esp_mqtt task, the API is called by the app tasks.
+ */
+typedef struct {
+    bool is_used;
+    char topic_filter[MJD_MQTT_TOPIC_FILTER_MAX_LEN + 1];
+    int qos;
+    mjd_mqtt_message_handler_t handler;
+    void *ptr_arg;
+} mjd_mqtt_subscription_t;
+
+static SemaphoreHandle_t _mqtt_subscriptions_mutex = NULL;
+static mjd_mqtt_subscription_t _mqtt_subscriptions[MJD_MQTT_MAX_SUBSCRIPTIONS];
+static mjd_mqtt_trie_t _mqtt_trie;
+
+static uint32_t _mqtt_nbr_of_messages_dispatched = 0;
+static uint32_t _mqtt_nbr_of_messages_unmatched = 0;
+
+#define MY_SUBSCRIPTIONS_LOCK()     xSemaphoreTake(_mqtt_subscriptions_mutex, portMAX_DELAY)
+#define MY_SUBSCRIPTIONS_UNLOCK()   xSemaphoreGive(_mqtt_subscriptions_mutex)
+
+/**********
+ * Compact readings
+ * @doc Registered topic ids + binary batches (mjd_mqtt_compact.c) instead of the long topic in every PUBLISH.
+ * @important Guarded by _mqtt_readings_mutex (the app tasks). The esp_mqtt task only sets _mqtt_readings_must_announce:
+ *            it must not wait for an app task that waits for a free outbox slot of esp_mqtt.
+ */
+static SemaphoreHandle_t _mqtt_readings_mutex = NULL;
+static mjd_mqtt_compact_t _mqtt_readings;
+static bool _mqtt_readings_is_init = false;
+static volatile bool _mqtt_readings_must_announce = false;
+
+#define MY_READINGS_LOCK()     xSemaphoreTake(_mqtt_readings_mutex, portMAX_DELAY)
+#define MY_READINGS_UNLOCK()   xSemaphoreGive(_mqtt_readings_mutex)
+
 /**********
  * Callback and Event Group Handler
  * @doc Use IRAM_ATTR to reduce the penalty associated with loading the code from flash. Cases when parts of application should or may be placed into IRAM:
@@ -34,9 +72,28 @@ static uint32_t total_nbr_of_mqtt_publish_errors = 0;
 static EventGroupHandle_t mqtt_event_group;
 static const int MQTT_CONNECTED_BIT = BIT0;
 
-static IRAM_ATTR void mqtt_status_callback(esp_mqtt_status_t status) {
+/*
+ * @brief (Re)send the subscriptions to the broker after each connect (the session is not persistent: clean session).
+ * @important Runs in the esp_mqtt task, the main mutex of esp_mqtt is not held.
+ */
+static void _mqtt_resubscribe(void) {
+    MY_SUBSCRIPTIONS_LOCK();
+    for (uint32_t i = 0; i < MJD_MQTT_MAX_SUBSCRIPTIONS; i++) {
+        if (_mqtt_subscriptions[i].is_used == true) {
+            if (esp_mqtt_subscribe(_mqtt_subscriptions[i].topic_filter, _mqtt_subscriptions[i].qos) == false) {
+                ESP_LOGE(TAG, "_mqtt_resubscribe(): esp_mqtt_subscribe(%s) failed", _mqtt_subscriptions[i].topic_filter);
+                break;
+            }
+        }
+    }
+    MY_SUBSCRIPTIONS_UNLOCK();
+}
+
+static void mqtt_status_callback(esp_mqtt_status_t status) {
     switch (status) {
     case ESP_MQTT_STATUS_CONNECTED:
+        _mqtt_resubscribe();
+        _mqtt_readings_must_announce = true;
         xEventGroupSetBits(mqtt_event_group, MQTT_CONNECTED_BIT);
         break;
     case ESP_MQTT_STATUS_DISCONNECTED: // @important This bitflag is not set when stopping mqtt (only when an active netconn is ABORTED)...
@@ -45,8 +102,37 @@ static IRAM_ATTR void mqtt_status_callback(esp_mqtt_status_t status) {
     }
 }
 
-static IRAM_ATTR void mqtt_message_callback(const char *topic, uint8_t *payload, size_t len) {
-    ESP_LOGI(TAG, "(not used yet) subscr msg rcvd: topic=%s => payload=%s (%d)", topic, payload, (int ) len);
+/*
+ * @brief Dispatch an inbound message to the handlers of the matching subscriptions (esp_mqtt task).
+ *
+ * @doc The handlers are called outside the mutex so a handler can (un)subscribe.
+ */
+static void mqtt_borrow_callback(esp_mqtt_message_t *ptr_message) {
+    mjd_mqtt_message_handler_t handlers[MJD_MQTT_MAX_SUBSCRIPTIONS];
+    void *args[MJD_MQTT_MAX_SUBSCRIPTIONS];
+    uint32_t nbr_of_handlers = 0;
+
+    MY_SUBSCRIPTIONS_LOCK();
+    uint32_t mask = mjd_mqtt_trie_match(&_mqtt_trie, ptr_message->topic, ptr_message->topic_len);
+    for (uint32_t i = 0; mask != 0; i++, mask >>= 1) {
+        if ((mask & 1) != 0) {
+            handlers[nbr_of_handlers] = _mqtt_subscriptions[i].handler;
+            args[nbr_of_handlers] = _mqtt_subscriptions[i].ptr_arg;
+            nbr_of_handlers++;
+        }
+    }
+    if (nbr_of_handlers == 0) {
+        _mqtt_nbr_of_messages_unmatched++;
+    }
+    _mqtt_nbr_of_messages_dispatched += nbr_of_handlers;
+    MY_SUBSCRIPTIONS_UNLOCK();
+
+    if (nbr_of_handlers == 0) {
+        ESP_LOGD(TAG, "mqtt_borrow_callback(): no subscription for topic=%s", ptr_message->topic);
+    }
+    for (uint32_t i = 0; i < nbr_of_handlers; i++) {
+        handlers[i](ptr_message, args[i]);
+    }
 }
 
 /**********
@@ -58,7 +144,30 @@ esp_err_t mjd_mqtt_init(size_t buffer_size, int command_timeout) {
     esp_err_t f_retval = ESP_OK;
 
     mqtt_event_group = xEventGroupCreate();
-    esp_mqtt_init(mqtt_status_callback, mqtt_message_callback, buffer_size, command_timeout);
+
+    // Subscriptions, Compact readings
+    _mqtt_subscriptions_mutex = xSemaphoreCreateMutex();
+    _mqtt_readings_mutex = xSemaphoreCreateMutex();
+    if (mqtt_event_group == NULL || _mqtt_subscriptions_mutex == NULL || _mqtt_readings_mutex == NULL) {
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "ABORT. xEventGroupCreate() or xSemaphoreCreateMutex() failed | err %i %s", f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    memset(_mqtt_subscriptions, 0, sizeof(_mqtt_subscriptions));
+    mjd_mqtt_trie_init(&_mqtt_trie);
+
+    // @doc The inbound messages are borrowed from the inbox slots of esp_mqtt (no mallocs per message).
+    if (esp_mqtt_init(mqtt_status_callback, NULL, buffer_size, command_timeout) == false) {
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "ABORT. esp_mqtt_init() failed | err %i %s", f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    esp_mqtt_set_borrow_callback(mqtt_borrow_callback);
+
+    // LABEL
+    cleanup:;
 
     return f_retval;
 }
@@ -119,6 +228,12 @@ esp_err_t mjd_mqtt_stop() {
     return f_retval;
 }
 
+/*
+ * @brief Publish a message. Returns when it has been delivered: sent, and acknowledged by the broker for QoS 1 and 2.
+ *
+ * @doc A failed attempt (not connected, outbox full, no PUBACK within the timeout) is retried MJD_MQTT_MAX_PUBLISH_ATTEMPTS times.
+ * @doc The trace probe MJD_TRACE_PROBE_MQTT_PUBLISH measures the delivery latency, including the retries.
+ */
 esp_err_t mjd_mqtt_publish(const char *topic, uint8_t *payload, size_t len, int qos, bool retained) {
     ESP_LOGD(TAG, "%s()", __FUNCTION__);
 
@@ -126,6 +241,8 @@ esp_err_t mjd_mqtt_publish(const char *topic, uint8_t *payload, size_t len, int
 
     uint32_t mqtt_publish_attempt_nr = 0;
 
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_MQTT_PUBLISH);
+
     while (++mqtt_publish_attempt_nr <= MJD_MQTT_MAX_PUBLISH_ATTEMPTS) {
         // MQTT Publish.
         if (MJD_MQTT_LOG_MQTT_PUBLISH == true) {
@@ -151,7 +268,297 @@ esp_err_t mjd_mqtt_publish(const char *topic, uint8_t *payload, size_t len, int
         f_retval = ESP_FAIL;
     }
 
+    MJD_TRACE_END(MJD_TRACE_PROBE_MQTT_PUBLISH);
+
     /////mjd_log_memory_statistics();
 
     return f_retval;
 }
+
+/*
+ * @brief Subscribe to a topic filter (MQTT wildcards + and #). The handler is called for each message that matches.
+ *
+ * @doc Can be called before mjd_mqtt_start(): the subscriptions are sent to the broker after each connect.
+ * @doc Several subscriptions may use the same topic filter (each with its own handler).
+ */
+esp_err_t mjd_mqtt_subscribe(const char *topic_filter, int qos, mjd_mqtt_message_handler_t handler, void *ptr_arg) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    uint32_t i;
+
+    if (_mqtt_subscriptions_mutex == NULL) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "ABORT. Call mjd_mqtt_init() first | err %i %s", f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (handler == NULL || topic_filter == NULL || strlen(topic_filter) > MJD_MQTT_TOPIC_FILTER_MAX_LEN) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "ABORT. Invalid args (no handler or topic filter longer than %u) | err %i %s", MJD_MQTT_TOPIC_FILTER_MAX_LEN, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    MY_SUBSCRIPTIONS_LOCK();
+
+    for (i = 0; i < MJD_MQTT_MAX_SUBSCRIPTIONS; i++) {
+        if (_mqtt_subscriptions[i].is_used == false) {
+            break;
+        }
+    }
+    if (i == MJD_MQTT_MAX_SUBSCRIPTIONS) {
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "ABORT. Max %u subscriptions | err %i %s", MJD_MQTT_MAX_SUBSCRIPTIONS, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto unlock;
+    }
+
+    f_retval = mjd_mqtt_trie_insert(&_mqtt_trie, topic_filter, i);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "ABORT. mjd_mqtt_trie_insert(%s) failed | err %i %s", topic_filter, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto unlock;
+    }
+
+    if ((xEventGroupGetBits(mqtt_event_group) & MQTT_CONNECTED_BIT) != 0) {
+        if (esp_mqtt_subscribe(topic_filter, qos) == false) {
+            f_retval = ESP_FAIL;
+            ESP_LOGE(TAG, "ABORT. esp_mqtt_subscribe(%s) failed | err %i %s", topic_filter, f_retval, esp_err_to_name(f_retval));
+            mjd_mqtt_trie_remove(&_mqtt_trie, topic_filter, i);
+            // GOTO
+            goto unlock;
+        }
+    }
+
+    strcpy(_mqtt_subscriptions[i].topic_filter, topic_filter);
+    _mqtt_subscriptions[i].qos = qos;
+    _mqtt_subscriptions[i].handler = handler;
+    _mqtt_subscriptions[i].ptr_arg = ptr_arg;
+    _mqtt_subscriptions[i].is_used = true;
+
+    // LABEL
+    unlock:;
+    MY_SUBSCRIPTIONS_UNLOCK();
+
+    // LABEL
+    cleanup:;
+
+    return f_retval;
+}
+
+esp_err_t mjd_mqtt_unsubscribe(const char *topic_filter, mjd_mqtt_message_handler_t handler) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_ERR_NOT_FOUND;
+    bool is_filter_still_used = false;
+
+    if (_mqtt_subscriptions_mutex == NULL || topic_filter == NULL) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "ABORT. Call mjd_mqtt_init() first | err %i %s", f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    MY_SUBSCRIPTIONS_LOCK();
+
+    for (uint32_t i = 0; i < MJD_MQTT_MAX_SUBSCRIPTIONS; i++) {
+        if (_mqtt_subscriptions[i].is_used == false || strcmp(_mqtt_subscriptions[i].topic_filter, topic_filter) != 0) {
+            continue;
+        }
+        if (_mqtt_subscriptions[i].handler != handler) {
+            is_filter_still_used = true;
+            continue;
+        }
+        mjd_mqtt_trie_remove(&_mqtt_trie, topic_filter, i);
+        _mqtt_subscriptions[i].is_used = false;
+        f_retval = ESP_OK;
+    }
+
+    // @doc The broker only knows topic filters: keep it while another handler uses the same filter.
+    if (f_retval == ESP_OK && is_filter_still_used == false && (xEventGroupGetBits(mqtt_event_group) & MQTT_CONNECTED_BIT) != 0) {
+        if (esp_mqtt_unsubscribe(topic_filter) == false) {
+            f_retval = ESP_FAIL;
+            ESP_LOGE(TAG, "esp_mqtt_unsubscribe(%s) failed | err %i %s", topic_filter, f_retval, esp_err_to_name(f_retval));
+        }
+    }
+
+    MY_SUBSCRIPTIONS_UNLOCK();
+
+    // LABEL
+    cleanup:;
+
+    return f_retval;
+}
+
+/*
+ * @brief Keep a borrowed message after the handler returned (the inbox slot stays in use).
+ */
+void mjd_mqtt_message_retain(mjd_mqtt_message_t *ptr_message) {
+    esp_mqtt_message_retain(ptr_message);
+}
+
+/*
+ * @brief Give a retained message back (any task).
+ */
+void mjd_mqtt_message_release(mjd_mqtt_message_t *ptr_message) {
+    esp_mqtt_message_release(ptr_message);
+}
+
+esp_err_t mjd_mqtt_get_stats(mjd_mqtt_stats_t *ptr_stats) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (_mqtt_subscriptions_mutex == NULL) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "ABORT. Call mjd_mqtt_init() first | err %i %s", f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    MY_SUBSCRIPTIONS_LOCK();
+    ptr_stats->nbr_of_messages_dispatched = _mqtt_nbr_of_messages_dispatched;
+    ptr_stats->nbr_of_messages_unmatched = _mqtt_nbr_of_messages_unmatched;
+    MY_SUBSCRIPTIONS_UNLOCK();
+    esp_mqtt_get_inbox_stats(&ptr_stats->inbox);
+
+    memset(&ptr_stats->readings, 0, sizeof(ptr_stats->readings));
+    MY_READINGS_LOCK();
+    if (_mqtt_readings_is_init == true) {
+        mjd_mqtt_compact_get_stats(&_mqtt_readings, &ptr_stats->readings);
+    }
+    MY_READINGS_UNLOCK();
+
+    // LABEL
+    cleanup:;
+
+    return f_retval;
+}
+
+/*
+ * @brief The PUBLISH of the compact readings (the app task that holds _mqtt_readings_mutex).
+ */
+static esp_err_t _mqtt_readings_publish_callback(const char *topic, const uint8_t *payload, size_t len, bool retained, void *ptr_arg) {
+    return mjd_mqtt_publish(topic, (uint8_t *) payload, len, MJD_MQTT_READINGS_QOS, retained);
+}
+
+/*
+ * @brief Enable the compact readings: short topics <prefix>/<topic id> (max_readings_per_batch <= 1) or binary batches <prefix>/b.
+ *
+ * @doc See mjd_mqtt_compact.h for the topics and the payload format. The topic ids are announced (retained) after each connect.
+ * @important The prefix must be unique per device, e.g. "c/<client id>".
+ */
+esp_err_t mjd_mqtt_readings_init(const char *prefix, uint32_t max_readings_per_batch) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    mjd_mqtt_compact_config_t config = MJD_MQTT_COMPACT_CONFIG_DEFAULT();
+
+    if (_mqtt_readings_mutex == NULL) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "ABORT. Call mjd_mqtt_init() first | err %i %s", f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    config.prefix = prefix;
+    config.max_readings_per_batch = max_readings_per_batch;
+    config.qos = MJD_MQTT_READINGS_QOS;
+    config.publish = _mqtt_readings_publish_callback;
+
+    MY_READINGS_LOCK();
+    f_retval = mjd_mqtt_compact_init(&_mqtt_readings, &config);
+    _mqtt_readings_is_init = (f_retval == ESP_OK);
+    MY_READINGS_UNLOCK();
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "ABORT. mjd_mqtt_compact_init() failed | err %i %s", f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // LABEL
+    cleanup:;
+
+    return f_retval;
+}
+
+/*
+ * @brief Register a long topic, e.g. "meteohub/current/temperature" with 2 decimals. Returns its topic id.
+ */
+esp_err_t mjd_mqtt_readings_register(const char *long_topic, uint8_t decimals, uint16_t *ptr_topic_id) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (_mqtt_readings_is_init == false) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "ABORT. Call mjd_mqtt_readings_init() first | err %i %s", f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    MY_READINGS_LOCK();
+    f_retval = mjd_mqtt_compact_register(&_mqtt_readings, long_topic, decimals, ptr_topic_id);
+    MY_READINGS_UNLOCK();
+
+    // LABEL
+    cleanup:;
+
+    return f_retval;
+}
+
+/*
+ * @brief Publish a reading now (no batches) or add it to the batch.
+ *
+ * @param timestamp_ms The time of the reading (only sent in a batch), e.g. the epoch in milliseconds.
+ */
+esp_err_t mjd_mqtt_readings_publish(uint16_t topic_id, float value, int64_t timestamp_ms) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (_mqtt_readings_is_init == false) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "ABORT. Call mjd_mqtt_readings_init() first | err %i %s", f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    MY_READINGS_LOCK();
+    if (_mqtt_readings_must_announce == true) {
+        _mqtt_readings_must_announce = false;
+        mjd_mqtt_compact_reset_announcements(&_mqtt_readings);
+    }
+    f_retval = mjd_mqtt_compact_add_reading(&_mqtt_readings, topic_id, value, timestamp_ms);
+    MY_READINGS_UNLOCK();
+
+    // LABEL
+    cleanup:;
+
+    return f_retval;
+}
+
+/*
+ * @brief Publish the readings of the batch now, e.g. before mjd_mqtt_stop() or a deep sleep.
+ */
+esp_err_t mjd_mqtt_readings_flush() {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (_mqtt_readings_is_init == false) {
+        // GOTO
+        goto cleanup;
+    }
+
+    MY_READINGS_LOCK();
+    f_retval = mjd_mqtt_compact_flush(&_mqtt_readings);
+    MY_READINGS_UNLOCK();
+
+    // LABEL
+    cleanup:;
+
+    return f_retval;
+}
@@ -0,0 +1,453 @@
+/*
+ * Component: MQTT - compact readings (registered topic ids + binary batches)
+ *
+ */
+
+// Component header file(s)
+#include "mjd.h"
+#include "mjd_mqtt_compact.h"
+
+/**********
+ * Logging
+ */
+static const char TAG[] = "mjd_mqtt_compact";
+
+/**********
+ * PRIVATE
+ */
+#define MY_VARINT_MAX_LEN       (10)
+#define MY_READING_MAX_LEN      (3 + MY_VARINT_MAX_LEN + 5) /*!< topic id (16 bits) + timestamp delta + value (32 bits) */
+
+static const uint32_t _pow10[MJD_MQTT_COMPACT_MAX_DECIMALS + 1] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+static inline size_t _put_varint(uint8_t* param_ptr_buf, uint64_t param_value) {
+    size_t len = 0;
+
+    while (param_value >= 0x80) {
+        param_ptr_buf[len++] = (uint8_t) (param_value | 0x80);
+        param_value >>= 7;
+    }
+    param_ptr_buf[len++] = (uint8_t) param_value;
+
+    return len;
+}
+
+static inline bool _get_varint(const uint8_t* param_ptr_buf, size_t param_len, size_t* param_ptr_pos, uint64_t* param_ptr_value) {
+    uint64_t value = 0;
+
+    for (uint32_t shift = 0; shift < 64; shift += 7) {
+        if (*param_ptr_pos >= param_len) {
+            return false;
+        }
+        const uint8_t byte = param_ptr_buf[(*param_ptr_pos)++];
+        value |= (uint64_t) (byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *param_ptr_value = value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * @doc zigzag: small negative numbers become small varints (0 => 0, -1 => 1, 1 => 2, -2 => 3, ...)
+ */
+static inline uint64_t _zigzag(int64_t param_value) {
+    return ((uint64_t) param_value << 1) ^ (uint64_t) (param_value >> 63);
+}
+
+static inline int64_t _unzigzag(uint64_t param_value) {
+    return (int64_t) (param_value >> 1) ^ -(int64_t) (param_value & 1);
+}
+
+/*
+ * @brief round(value * 10^decimals), saturated to int32.
+ *
+ * @doc The same rounding as mjd_float_to_fixed_string(): a batch and a short topic carry the same value.
+ */
+static int32_t _scale(float param_value, uint8_t param_decimals) {
+    const uint32_t scale = _pow10[param_decimals];
+    const bool is_negative = signbit(param_value);
+    int64_t scaled;
+
+    if (isnan(param_value)) {
+        return 0;
+    }
+    if (is_negative == true) {
+        param_value = -param_value;
+    }
+    if (param_value >= 2147483648.0f / (float) scale) {
+        return (is_negative == true) ? INT32_MIN : INT32_MAX;
+    }
+
+    const uint32_t int_part = (uint32_t) param_value;
+    const uint32_t frac_part = (uint32_t) ((param_value - (float) int_part) * (float) scale + 0.5f);
+    scaled = (int64_t) int_part * scale + frac_part;
+    if (is_negative == true) {
+        scaled = -scaled;
+    }
+    if (scaled > INT32_MAX) {
+        scaled = INT32_MAX;
+    }
+
+    return (int32_t) scaled;
+}
+
+/*
+ * @brief The size of the MQTT PUBLISH packet: fixed header + remaining length + topic (with its length) + packet id (QoS > 0) + payload.
+ */
+static uint32_t _wire_len(size_t param_topic_len, size_t param_payload_len, int param_qos) {
+    const uint32_t remaining_len = 2 + param_topic_len + ((param_qos > 0) ? 2 : 0) + param_payload_len;
+    uint32_t remaining_len_len = 1;
+
+    if (remaining_len >= 2097152) {
+        remaining_len_len = 4;
+    } else if (remaining_len >= 16384) {
+        remaining_len_len = 3;
+    } else if (remaining_len >= 128) {
+        remaining_len_len = 2;
+    }
+    return 1 + remaining_len_len + remaining_len;
+}
+
+static esp_err_t _publish(mjd_mqtt_compact_t* param_ptr_ctx, const char* param_ptr_topic, const uint8_t* param_ptr_payload, size_t param_len,
+                          bool param_retained) {
+    esp_err_t f_retval = ESP_OK;
+
+    f_retval = param_ptr_ctx->publish(param_ptr_topic, param_ptr_payload, param_len, param_retained, param_ptr_ctx->ptr_publish_arg);
+    if (f_retval != ESP_OK) {
+        param_ptr_ctx->stats.nbr_of_publish_errors++;
+        ESP_LOGE(TAG, "%s(). ABORT. publish(%s) failed | err %i (%s)", __FUNCTION__, param_ptr_topic, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    param_ptr_ctx->stats.nbr_of_wire_bytes += _wire_len(strlen(param_ptr_topic), param_len, param_ptr_ctx->qos);
+
+    // LABEL
+    cleanup:;
+
+    return f_retval;
+}
+
+/*
+ * @brief <prefix>/<id> or <prefix>/<middle>/<id>
+ */
+static void _short_topic(const mjd_mqtt_compact_t* param_ptr_ctx, const char* param_ptr_middle, uint32_t param_id,
+                         char param_topic[MJD_MQTT_COMPACT_SHORT_TOPIC_MAX_LEN + 1]) {
+    mjd_strbuf_t strbuf;
+
+    mjd_strbuf_init(&strbuf, param_topic, MJD_MQTT_COMPACT_SHORT_TOPIC_MAX_LEN + 1);
+    mjd_strbuf_append(&strbuf, param_ptr_ctx->prefix);
+    mjd_strbuf_append_char(&strbuf, '/');
+    if (param_ptr_middle != NULL) {
+        mjd_strbuf_append(&strbuf, param_ptr_middle);
+        mjd_strbuf_append_char(&strbuf, '/');
+    }
+    mjd_strbuf_append_uint(&strbuf, param_id, 0);
+}
+
+/*
+ * @brief The retained announcement <prefix>/r/<id> => "<decimals>:<long topic>".
+ */
+static esp_err_t _announce(mjd_mqtt_compact_t* param_ptr_ctx, uint16_t param_topic_id) {
+    esp_err_t f_retval = ESP_OK;
+    mjd_mqtt_compact_topic_t* ptr_topic = &param_ptr_ctx->topics[param_topic_id];
+    char topic[MJD_MQTT_COMPACT_SHORT_TOPIC_MAX_LEN + 1];
+    char payload[4 + MJD_MQTT_COMPACT_TOPIC_MAX_LEN + 1];
+    mjd_strbuf_t strbuf;
+
+    _short_topic(param_ptr_ctx, "r", param_topic_id, topic);
+
+    mjd_strbuf_init(&strbuf, payload, sizeof(payload));
+    mjd_strbuf_append_uint(&strbuf, ptr_topic->decimals, 0);
+    mjd_strbuf_append_char(&strbuf, ':');
+    mjd_strbuf_append(&strbuf, ptr_topic->long_topic);
+
+    f_retval = _publish(param_ptr_ctx, topic, (const uint8_t*) payload, mjd_strbuf_len(&strbuf), true);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+    ptr_topic->is_announced = true;
+    param_ptr_ctx->stats.nbr_of_announcements++;
+
+    // LABEL
+    cleanup:;
+
+    return f_retval;
+}
+
+/**********
+ * PUBLIC
+ */
+esp_err_t mjd_mqtt_compact_init(mjd_mqtt_compact_t* param_ptr_ctx, const mjd_mqtt_compact_config_t* param_ptr_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_config->publish == NULL || param_ptr_config->prefix == NULL || param_ptr_config->prefix[0] == '\0'
+            || strlen(param_ptr_config->prefix) > MJD_MQTT_COMPACT_PREFIX_MAX_LEN || strpbrk(param_ptr_config->prefix, "+#") != NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. No publish callback or invalid prefix (1..%u chars, no wildcards) | err %i (%s)", __FUNCTION__,
+                MJD_MQTT_COMPACT_PREFIX_MAX_LEN, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    memset(param_ptr_ctx, 0, sizeof(*param_ptr_ctx));
+    strcpy(param_ptr_ctx->prefix, param_ptr_config->prefix);
+    param_ptr_ctx->max_readings_per_batch = param_ptr_config->max_readings_per_batch;
+    param_ptr_ctx->qos = param_ptr_config->qos;
+    param_ptr_ctx->publish = param_ptr_config->publish;
+    param_ptr_ctx->ptr_publish_arg = param_ptr_config->ptr_publish_arg;
+
+    // LABEL
+    cleanup:;
+
+    return f_retval;
+}
+
+/*
+ * @brief Register a long topic (once). Registering the same topic again returns the same topic id.
+ *
+ * @param param_decimals The precision of the values: a value is sent as round(value * 10^decimals).
+ */
+esp_err_t mjd_mqtt_compact_register(mjd_mqtt_compact_t* param_ptr_ctx, const char* param_ptr_long_topic, uint8_t param_decimals,
+                                    uint16_t* param_ptr_topic_id) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    int32_t free_idx = -1;
+
+    if (param_ptr_long_topic == NULL || param_ptr_long_topic[0] == '\0' || strlen(param_ptr_long_topic) > MJD_MQTT_COMPACT_TOPIC_MAX_LEN
+            || strpbrk(param_ptr_long_topic, "+#") != NULL || param_decimals > MJD_MQTT_COMPACT_MAX_DECIMALS) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid topic (1..%u chars, no wildcards) or decimals > %u | err %i (%s)", __FUNCTION__,
+                MJD_MQTT_COMPACT_TOPIC_MAX_LEN, MJD_MQTT_COMPACT_MAX_DECIMALS, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    for (uint32_t i = 0; i < MJD_MQTT_COMPACT_MAX_TOPICS; i++) {
+        mjd_mqtt_compact_topic_t* ptr_topic = &param_ptr_ctx->topics[i];
+        if (ptr_topic->is_used == false) {
+            if (free_idx < 0) {
+                free_idx = i;
+            }
+            continue;
+        }
+        if (strcmp(ptr_topic->long_topic, param_ptr_long_topic) == 0) {
+            if (ptr_topic->decimals != param_decimals) {
+                f_retval = ESP_ERR_INVALID_ARG;
+                ESP_LOGE(TAG, "%s(). ABORT. %s is already registered with %u decimals | err %i (%s)", __FUNCTION__, param_ptr_long_topic,
+                        ptr_topic->decimals, f_retval, esp_err_to_name(f_retval));
+                // GOTO
+                goto cleanup;
+            }
+            *param_ptr_topic_id = i;
+            // GOTO
+            goto cleanup;
+        }
+    }
+    if (free_idx < 0) {
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "%s(). ABORT. Max %u topics | err %i (%s)", __FUNCTION__, MJD_MQTT_COMPACT_MAX_TOPICS, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    param_ptr_ctx->topics[free_idx].is_used = true;
+    param_ptr_ctx->topics[free_idx].is_announced = false;
+    param_ptr_ctx->topics[free_idx].decimals = param_decimals;
+    strcpy(param_ptr_ctx->topics[free_idx].long_topic, param_ptr_long_topic);
+    *param_ptr_topic_id = free_idx;
+
+    // LABEL
+    cleanup:;
+
+    return f_retval;
+}
+
+/*
+ * @brief Announce the topic ids again before their next reading (call it after each (re)connect).
+ */
+void mjd_mqtt_compact_reset_announcements(mjd_mqtt_compact_t* param_ptr_ctx) {
+    for (uint32_t i = 0; i < MJD_MQTT_COMPACT_MAX_TOPICS; i++) {
+        param_ptr_ctx->topics[i].is_announced = false;
+    }
+}
+
+/*
+ * @brief Publish a reading (no batches) or add it to the batch (published when it holds max_readings_per_batch readings or when it is full).
+ *
+ * @param param_timestamp_ms The time of the reading, e.g. the epoch in milliseconds. Only sent in a batch.
+ * @return An error if the announcement of the topic id or the publish fails: the reading is not sent (a batch is kept for the next try).
+ */
+esp_err_t mjd_mqtt_compact_add_reading(mjd_mqtt_compact_t* param_ptr_ctx, uint16_t param_topic_id, float param_value, int64_t param_timestamp_ms) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    mjd_mqtt_compact_topic_t* ptr_topic;
+    char digits[MJD_NUMBER_STRING_MAX_SIZE];
+    size_t digits_len;
+
+    if (param_topic_id >= MJD_MQTT_COMPACT_MAX_TOPICS || param_ptr_ctx->topics[param_topic_id].is_used == false) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Topic id %u is not registered | err %i (%s)", __FUNCTION__, param_topic_id, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    ptr_topic = &param_ptr_ctx->topics[param_topic_id];
+
+    // The batch needs room for 1 more reading
+    if (param_ptr_ctx->batch_len + MY_READING_MAX_LEN > MJD_MQTT_COMPACT_BATCH_MAX_LEN) {
+        f_retval = mjd_mqtt_compact_flush(param_ptr_ctx);
+        if (f_retval != ESP_OK) {
+            // GOTO
+            goto cleanup;
+        }
+    }
+
+    // @important The receiving side must know the topic id before its first reading
+    if (ptr_topic->is_announced == false) {
+        f_retval = _announce(param_ptr_ctx, param_topic_id);
+        if (f_retval != ESP_OK) {
+            // GOTO
+            goto cleanup;
+        }
+    }
+
+    digits_len = mjd_float_to_fixed_string(param_value, ptr_topic->decimals, digits);
+
+    if (param_ptr_ctx->max_readings_per_batch <= 1) {
+        char topic[MJD_MQTT_COMPACT_SHORT_TOPIC_MAX_LEN + 1];
+
+        _short_topic(param_ptr_ctx, NULL, param_topic_id, topic);
+        f_retval = _publish(param_ptr_ctx, topic, (const uint8_t*) digits, digits_len, false);
+        if (f_retval != ESP_OK) {
+            // GOTO
+            goto cleanup;
+        }
+        param_ptr_ctx->stats.nbr_of_publishes++;
+    } else {
+        uint8_t* ptr_batch = param_ptr_ctx->batch;
+        size_t len = param_ptr_ctx->batch_len;
+
+        if (len == 0) {
+            ptr_batch[len++] = MJD_MQTT_COMPACT_BATCH_VERSION;
+            len += _put_varint(&ptr_batch[len], (uint64_t) param_timestamp_ms);
+            param_ptr_ctx->batch_last_timestamp_ms = param_timestamp_ms;
+        }
+        len += _put_varint(&ptr_batch[len], param_topic_id);
+        len += _put_varint(&ptr_batch[len], _zigzag(param_timestamp_ms - param_ptr_ctx->batch_last_timestamp_ms));
+        len += _put_varint(&ptr_batch[len], _zigzag(_scale(param_value, ptr_topic->decimals)));
+        param_ptr_ctx->batch_len = len;
+        param_ptr_ctx->batch_last_timestamp_ms = param_timestamp_ms;
+        param_ptr_ctx->batch_nbr_of_readings++;
+    }
+
+    param_ptr_ctx->stats.nbr_of_readings++;
+    param_ptr_ctx->stats.nbr_of_baseline_bytes += _wire_len(strlen(ptr_topic->long_topic), digits_len, param_ptr_ctx->qos);
+
+    if (param_ptr_ctx->max_readings_per_batch > 1 && param_ptr_ctx->batch_nbr_of_readings >= param_ptr_ctx->max_readings_per_batch) {
+        f_retval = mjd_mqtt_compact_flush(param_ptr_ctx);
+    }
+
+    // LABEL
+    cleanup:;
+
+    return f_retval;
+}
+
+/*
+ * @brief Publish the batch now (e.g. before a deep sleep). Does nothing when the batch is empty.
+ */
+esp_err_t mjd_mqtt_compact_flush(mjd_mqtt_compact_t* param_ptr_ctx) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    char topic[MJD_MQTT_COMPACT_SHORT_TOPIC_MAX_LEN + 1];
+    mjd_strbuf_t strbuf;
+
+    if (param_ptr_ctx->batch_nbr_of_readings == 0) {
+        // GOTO
+        goto cleanup;
+    }
+
+    mjd_strbuf_init(&strbuf, topic, sizeof(topic));
+    mjd_strbuf_append(&strbuf, param_ptr_ctx->prefix);
+    mjd_strbuf_append(&strbuf, "/b");
+
+    f_retval = _publish(param_ptr_ctx, topic, param_ptr_ctx->batch, param_ptr_ctx->batch_len, false);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+    param_ptr_ctx->stats.nbr_of_publishes++;
+    param_ptr_ctx->batch_len = 0;
+    param_ptr_ctx->batch_nbr_of_readings = 0;
+
+    // LABEL
+    cleanup:;
+
+    return f_retval;
+}
+
+void mjd_mqtt_compact_get_stats(const mjd_mqtt_compact_t* param_ptr_ctx, mjd_mqtt_compact_stats_t* param_ptr_stats) {
+    *param_ptr_stats = param_ptr_ctx->stats;
+    if (param_ptr_stats->nbr_of_readings > 0) {
+        param_ptr_stats->bytes_per_reading = (float) param_ptr_stats->nbr_of_wire_bytes / param_ptr_stats->nbr_of_readings;
+        param_ptr_stats->baseline_bytes_per_reading = (float) param_ptr_stats->nbr_of_baseline_bytes / param_ptr_stats->nbr_of_readings;
+    }
+}
+
+/*
+ * @brief Decode the payload of a batch (<prefix>/b). The handler is called for each reading, in order.
+ *
+ * @doc The value of a reading is round(value * 10^decimals): the decimals are in the announcement of its topic id.
+ */
+esp_err_t mjd_mqtt_compact_decode(const uint8_t* param_ptr_payload, size_t param_len, mjd_mqtt_compact_reading_handler_t param_handler,
+                                  void* param_ptr_arg) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    size_t pos = 0;
+    uint64_t base_timestamp_ms, topic_id, delta_ms, value;
+    int64_t timestamp_ms;
+
+    if (param_len < 1 || param_ptr_payload[pos++] != MJD_MQTT_COMPACT_BATCH_VERSION) {
+        f_retval = ESP_ERR_NOT_SUPPORTED;
+        ESP_LOGE(TAG, "%s(). ABORT. Not a batch of version %u | err %i (%s)", __FUNCTION__, MJD_MQTT_COMPACT_BATCH_VERSION, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (_get_varint(param_ptr_payload, param_len, &pos, &base_timestamp_ms) == false) {
+        f_retval = ESP_ERR_INVALID_SIZE;
+        ESP_LOGE(TAG, "%s(). ABORT. Truncated header | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    timestamp_ms = (int64_t) base_timestamp_ms;
+
+    while (pos < param_len) {
+        if (_get_varint(param_ptr_payload, param_len, &pos, &topic_id) == false
+                || _get_varint(param_ptr_payload, param_len, &pos, &delta_ms) == false
+                || _get_varint(param_ptr_payload, param_len, &pos, &value) == false) {
+            f_retval = ESP_ERR_INVALID_SIZE;
+            ESP_LOGE(TAG, "%s(). ABORT. Truncated reading at byte %u | err %i (%s)", __FUNCTION__, (uint32_t) pos, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+        timestamp_ms += _unzigzag(delta_ms);
+        param_handler((uint16_t) topic_id, (int32_t) _unzigzag(value), timestamp_ms, param_ptr_arg);
+    }
+
+    // LABEL
+    cleanup:;
+
+    return f_retval;
+}
@@ -0,0 +1,296 @@
+/*
+ * Component: MQTT - topic filter trie
+ *
+ */
+
+// Component header file(s)
+#include "mjd.h"
+#include "mjd_mqtt_trie.h"
+
+/**********
+ * Logging
+ */
+static const char TAG[] = "mjd_mqtt_trie";
+
+/**********
+ * PRIVATE
+ */
+
+/*
+ * @brief The end of the level that starts at param_pos (the position of the next '/' or param_len).
+ */
+static inline size_t _level_end(const char* param_ptr_topic, size_t param_len, size_t param_pos) {
+    while (param_pos < param_len && param_ptr_topic[param_pos] != '/') {
+        param_pos++;
+    }
+    return param_pos;
+}
+
+static inline bool _is_level(const mjd_mqtt_trie_node_t* param_ptr_node, const char* param_ptr_level, size_t param_level_len) {
+    return (param_ptr_node->level_len == param_level_len && memcmp(param_ptr_node->level, param_ptr_level, param_level_len) == 0);
+}
+
+static int16_t _find_child(const mjd_mqtt_trie_t* param_ptr_trie, int16_t param_parent, const char* param_ptr_level, size_t param_level_len) {
+    int16_t idx = param_ptr_trie->nodes[param_parent].first_child;
+
+    while (idx != MJD_MQTT_TRIE_NO_NODE) {
+        if (_is_level(&param_ptr_trie->nodes[idx], param_ptr_level, param_level_len) == true) {
+            break;
+        }
+        idx = param_ptr_trie->nodes[idx].next_sibling;
+    }
+    return idx;
+}
+
+static int16_t _add_child(mjd_mqtt_trie_t* param_ptr_trie, int16_t param_parent, const char* param_ptr_level, size_t param_level_len) {
+    int16_t idx = param_ptr_trie->first_free;
+
+    if (idx == MJD_MQTT_TRIE_NO_NODE) {
+        return MJD_MQTT_TRIE_NO_NODE;
+    }
+    mjd_mqtt_trie_node_t *ptr_node = &param_ptr_trie->nodes[idx];
+    param_ptr_trie->first_free = ptr_node->next_sibling;
+    param_ptr_trie->nbr_of_nodes_used++;
+
+    memcpy(ptr_node->level, param_ptr_level, param_level_len);
+    ptr_node->level[param_level_len] = '\0';
+    ptr_node->level_len = (uint8_t) param_level_len;
+    ptr_node->parent = param_parent;
+    ptr_node->first_child = MJD_MQTT_TRIE_NO_NODE;
+    ptr_node->subscription_mask = 0;
+    ptr_node->next_sibling = param_ptr_trie->nodes[param_parent].first_child;
+    param_ptr_trie->nodes[param_parent].first_child = idx;
+
+    return idx;
+}
+
+static void _free_node(mjd_mqtt_trie_t* param_ptr_trie, int16_t param_idx) {
+    mjd_mqtt_trie_node_t *ptr_parent = &param_ptr_trie->nodes[param_ptr_trie->nodes[param_idx].parent];
+
+    // Unlink from the children of the parent
+    if (ptr_parent->first_child == param_idx) {
+        ptr_parent->first_child = param_ptr_trie->nodes[param_idx].next_sibling;
+    } else {
+        int16_t idx = ptr_parent->first_child;
+        while (param_ptr_trie->nodes[idx].next_sibling != param_idx) {
+            idx = param_ptr_trie->nodes[idx].next_sibling;
+        }
+        param_ptr_trie->nodes[idx].next_sibling = param_ptr_trie->nodes[param_idx].next_sibling;
+    }
+
+    param_ptr_trie->nodes[param_idx].next_sibling = param_ptr_trie->first_free;
+    param_ptr_trie->first_free = param_idx;
+    param_ptr_trie->nbr_of_nodes_used--;
+}
+
+/*
+ * @brief The subscriptions of the "#" child of a node (a topic that ends at the node also matches "node/#").
+ */
+static inline uint32_t _hash_child_mask(const mjd_mqtt_trie_t* param_ptr_trie, int16_t param_node) {
+    int16_t idx = _find_child(param_ptr_trie, param_node, "#", 1);
+
+    return (idx == MJD_MQTT_TRIE_NO_NODE) ? 0 : param_ptr_trie->nodes[idx].subscription_mask;
+}
+
+/*
+ * @brief Match the topic level that starts at param_pos against the children of param_node.
+ * @important Recursive: the depth is at most the number of levels of the longest filter (MJD_MQTT_TRIE_MAX_DEPTH).
+ */
+static uint32_t _match(const mjd_mqtt_trie_t* param_ptr_trie, int16_t param_node, const char* param_ptr_topic, size_t param_len,
+                       size_t param_pos) {
+    const bool is_wildcard_allowed = (param_pos > 0 || param_ptr_topic[0] != '$');
+    const size_t end = _level_end(param_ptr_topic, param_len, param_pos);
+    const bool is_last_level = (end == param_len);
+    uint32_t mask = 0;
+
+    for (int16_t idx = param_ptr_trie->nodes[param_node].first_child; idx != MJD_MQTT_TRIE_NO_NODE;
+            idx = param_ptr_trie->nodes[idx].next_sibling) {
+        const mjd_mqtt_trie_node_t *ptr_child = &param_ptr_trie->nodes[idx];
+        if (ptr_child->level_len == 1 && ptr_child->level[0] == '#') {
+            if (is_wildcard_allowed == true) {
+                mask |= ptr_child->subscription_mask;
+            }
+            continue;
+        }
+        if ((ptr_child->level_len == 1 && ptr_child->level[0] == '+' && is_wildcard_allowed == true)
+                || _is_level(ptr_child, param_ptr_topic + param_pos, end - param_pos) == true) {
+            if (is_last_level == true) {
+                mask |= ptr_child->subscription_mask | _hash_child_mask(param_ptr_trie, idx);
+            } else if (ptr_child->first_child != MJD_MQTT_TRIE_NO_NODE) {
+                mask |= _match(param_ptr_trie, idx, param_ptr_topic, param_len, end + 1);
+            }
+        }
+    }
+
+    return mask;
+}
+
+/**********
+ * PUBLIC
+ */
+void mjd_mqtt_trie_init(mjd_mqtt_trie_t* param_ptr_trie) {
+    memset(param_ptr_trie, 0, sizeof(*param_ptr_trie));
+
+    param_ptr_trie->nodes[0].parent = MJD_MQTT_TRIE_NO_NODE;
+    param_ptr_trie->nodes[0].first_child = MJD_MQTT_TRIE_NO_NODE;
+    param_ptr_trie->nodes[0].next_sibling = MJD_MQTT_TRIE_NO_NODE;
+    param_ptr_trie->nbr_of_nodes_used = 1;
+
+    // The free list: nodes 1..N-1
+    for (int16_t idx = 1; idx < MJD_MQTT_TRIE_MAX_NODES; idx++) {
+        param_ptr_trie->nodes[idx].next_sibling = (idx + 1 < MJD_MQTT_TRIE_MAX_NODES) ? idx + 1 : MJD_MQTT_TRIE_NO_NODE;
+    }
+    param_ptr_trie->first_free = (MJD_MQTT_TRIE_MAX_NODES > 1) ? 1 : MJD_MQTT_TRIE_NO_NODE;
+}
+
+/*
+ * @brief Check a topic filter (MQTT v3.1.1 section 4.7 + the limits of the trie).
+ */
+esp_err_t mjd_mqtt_trie_validate_filter(const char* param_ptr_filter) {
+    esp_err_t f_retval = ESP_OK;
+    size_t len, pos = 0;
+    uint32_t depth = 0;
+
+    if (param_ptr_filter == NULL || (len = strlen(param_ptr_filter)) == 0) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Empty topic filter | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    while (true) {
+        const size_t end = _level_end(param_ptr_filter, len, pos);
+        const size_t level_len = end - pos;
+        const char *ptr_level = param_ptr_filter + pos;
+
+        if (++depth > MJD_MQTT_TRIE_MAX_DEPTH || level_len > MJD_MQTT_TRIE_LEVEL_MAX_LEN) {
+            f_retval = ESP_ERR_INVALID_SIZE;
+            ESP_LOGE(TAG, "%s(). ABORT. Topic filter '%s' has too many levels (max %u) or a level is too long (max %u) | err %i (%s)",
+                    __FUNCTION__, param_ptr_filter, MJD_MQTT_TRIE_MAX_DEPTH, MJD_MQTT_TRIE_LEVEL_MAX_LEN, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+        if ((memchr(ptr_level, '+', level_len) != NULL && level_len != 1)
+                || (memchr(ptr_level, '#', level_len) != NULL && (level_len != 1 || end != len))) {
+            f_retval = ESP_ERR_INVALID_ARG;
+            ESP_LOGE(TAG, "%s(). ABORT. Topic filter '%s': a wildcard must be a whole level, '#' only as the last level | err %i (%s)",
+                    __FUNCTION__, param_ptr_filter, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+        if (end == len) {
+            break;
+        }
+        pos = end + 1;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_mqtt_trie_insert(mjd_mqtt_trie_t* param_ptr_trie, const char* param_ptr_filter, uint32_t param_subscription_index) {
+    esp_err_t f_retval = ESP_OK;
+    int16_t node = 0;
+    size_t len, pos = 0;
+
+    if (param_subscription_index >= MJD_MQTT_TRIE_MAX_SUBSCRIPTIONS) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid subscription index %u | err %i (%s)", __FUNCTION__, param_subscription_index, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    f_retval = mjd_mqtt_trie_validate_filter(param_ptr_filter);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+
+    len = strlen(param_ptr_filter);
+    while (true) {
+        const size_t end = _level_end(param_ptr_filter, len, pos);
+        int16_t child = _find_child(param_ptr_trie, node, param_ptr_filter + pos, end - pos);
+        if (child == MJD_MQTT_TRIE_NO_NODE) {
+            child = _add_child(param_ptr_trie, node, param_ptr_filter + pos, end - pos);
+            if (child == MJD_MQTT_TRIE_NO_NODE) {
+                f_retval = ESP_ERR_NO_MEM;
+                ESP_LOGE(TAG, "%s(). ABORT. No free trie node (max %u) | err %i (%s)", __FUNCTION__, MJD_MQTT_TRIE_MAX_NODES, f_retval,
+                        esp_err_to_name(f_retval));
+                // Give back the nodes that were added for this filter
+                while (node != 0 && param_ptr_trie->nodes[node].first_child == MJD_MQTT_TRIE_NO_NODE
+                        && param_ptr_trie->nodes[node].subscription_mask == 0) {
+                    int16_t parent = param_ptr_trie->nodes[node].parent;
+                    _free_node(param_ptr_trie, node);
+                    node = parent;
+                }
+                // GOTO
+                goto cleanup;
+            }
+        }
+        node = child;
+        if (end == len) {
+            break;
+        }
+        pos = end + 1;
+    }
+    param_ptr_trie->nodes[node].subscription_mask |= (1UL << param_subscription_index);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_mqtt_trie_remove(mjd_mqtt_trie_t* param_ptr_trie, const char* param_ptr_filter, uint32_t param_subscription_index) {
+    esp_err_t f_retval = ESP_OK;
+    int16_t node = 0;
+    size_t len, pos = 0;
+
+    if (param_ptr_filter == NULL || (len = strlen(param_ptr_filter)) == 0 || param_subscription_index >= MJD_MQTT_TRIE_MAX_SUBSCRIPTIONS) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        // GOTO
+        goto cleanup;
+    }
+
+    while (node != MJD_MQTT_TRIE_NO_NODE) {
+        const size_t end = _level_end(param_ptr_filter, len, pos);
+        node = _find_child(param_ptr_trie, node, param_ptr_filter + pos, end - pos);
+        if (end == len) {
+            break;
+        }
+        pos = end + 1;
+    }
+    if (node == MJD_MQTT_TRIE_NO_NODE || (param_ptr_trie->nodes[node].subscription_mask & (1UL << param_subscription_index)) == 0) {
+        f_retval = ESP_ERR_NOT_FOUND;
+        // GOTO
+        goto cleanup;
+    }
+    param_ptr_trie->nodes[node].subscription_mask &= ~(1UL << param_subscription_index);
+
+    // Prune the levels that are not used anymore
+    while (node != 0 && param_ptr_trie->nodes[node].first_child == MJD_MQTT_TRIE_NO_NODE
+            && param_ptr_trie->nodes[node].subscription_mask == 0) {
+        int16_t parent = param_ptr_trie->nodes[node].parent;
+        _free_node(param_ptr_trie, node);
+        node = parent;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*
+ * @brief The subscriptions that match a topic (a topic name, no wildcards).
+ *
+ * @return A bitmask: bit N = subscription index N.
+ */
+uint32_t mjd_mqtt_trie_match(const mjd_mqtt_trie_t* param_ptr_trie, const char* param_ptr_topic, size_t param_topic_len) {
+    if (param_topic_len == 0 || param_ptr_trie->nodes[0].first_child == MJD_MQTT_TRIE_NO_NODE) {
+        return 0;
+    }
+    return _match(param_ptr_trie, 0, param_ptr_topic, param_topic_len, 0);
+}
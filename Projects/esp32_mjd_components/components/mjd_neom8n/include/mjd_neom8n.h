@@ -13,12 +13,17 @@ extern "C" {
 #include "minmea.h"
 
 // MUTEX
-#define MJD_NEOM8N_SERVICE_LOCK()     xSemaphoreTake(_neom8n_service_semaphore, portMAX_DELAY)
-#define MJD_NEOM8N_SERVICE_UNLOCK()   xSemaphoreGive(_neom8n_service_semaphore)
+#define MJD_NEOM8N_SERVICE_LOCK()         xSemaphoreTake(_neom8n_service_semaphore, portMAX_DELAY)
+#define MJD_NEOM8N_SERVICE_UNLOCK()       xSemaphoreGive(_neom8n_service_semaphore)
+#define MJD_NEOM8N_UBX_COMMAND_LOCK()     xSemaphoreTake(_neom8n_ubx_command_semaphore, portMAX_DELAY)
+#define MJD_NEOM8N_UBX_COMMAND_UNLOCK()   xSemaphoreGive(_neom8n_ubx_command_semaphore)
 
 // MONITOR TASK
 #define MJD_NEOM8N_GPS_MONITOR_TASK_STACK_SIZE (4096)  // Stack size for the GPS monitor task
 
+// SCHEDULER TASK
+#define MJD_NEOM8N_SCHEDULER_TASK_STACK_SIZE (3072)  // Stack size for the duty cycling scheduler task
+
 /**
  * Data structs
  */
@@ -42,8 +47,34 @@ typedef struct {
     float latitude;     /*!< The latest latitude reading */
     float longitude;    /*!< The latest longitude reading */
     int satellites_tracked; /*!< The number of satellites that are being tracked */
+    float altitude_m;   /*!< Height above mean sea level in meters (GGA, UBX-NAV-PVT) */
+    float ground_speed_kmh; /*!< Ground speed in km/h (RMC, UBX-NAV-PVT) */
+    float horizontal_accuracy_m; /*!< Horizontal accuracy estimate in meters (UBX-NAV-PVT only; NaN when unknown) */
+    int satellites_visible; /*!< The number of satellites that are visible (UBX-NAV-SAT only; -1 when unknown) */
+    int cno_mean_dbhz;  /*!< The mean signal strength C/N0 in dBHz of the satellites used in the navigation solution (UBX-NAV-SAT only; -1 when unknown) */
+    uint32_t fix_counter; /*!< Incremented by every frame that reports a valid fix (RMC, GGA, UBX-NAV-PVT): a change = a fresh fix */
 } mjd_neom8n_data_t;
 
+/**
+ * UBX binary mode
+ *
+ * @doc The receiver only outputs UBX-NAV-PVT (+ optionally UBX-NAV-SAT) on its UART; all standard NMEA sentences are disabled.
+ * @doc A NMEA epoch (RMC VTG GGA GSA GSV GLL) is ~700 bytes; a UBX-NAV-PVT frame is 100 bytes.
+ * @rule measurement_period_ms 100 (10Hz) .. 10000
+ * @rule baud_rate 9600 19200 38400 57600 115200. The UART bandwidth must fit the output (see mjd_neom8n_ubx_get_mode_bytes_per_second()).
+ */
+typedef struct {
+    uint16_t measurement_period_ms; /*!< The measurement period = the period of UBX-NAV-PVT (100ms = 10Hz) */
+    uint8_t nav_sat_rate;         /*!< 0 = UBX-NAV-SAT off; N = UBX-NAV-SAT every N navigation solutions */
+    uint32_t baud_rate;           /*!< The new baud rate of the UART (receiver + ESP32) */
+} mjd_neom8n_ubx_mode_t;
+
+#define MJD_NEOM8N_UBX_MODE_DEFAULT() { \
+    .measurement_period_ms = 100, \
+    .nav_sat_rate = 0, \
+    .baud_rate = 38400 \
+}
+
 /**
  * Function declarations
  */
@@ -60,6 +91,9 @@ esp_err_t mjd_neom8n_gnss_start(mjd_neom8n_config_t* ptr_param_config);
 esp_err_t mjd_neom8n_set_measurement_rate_1000ms(mjd_neom8n_config_t* ptr_param_config);
 esp_err_t mjd_neom8n_set_measurement_rate_100ms(mjd_neom8n_config_t* ptr_param_config);
 esp_err_t mjd_neom8n_set_measurement_rate_5000ms(mjd_neom8n_config_t* ptr_param_config);
+esp_err_t mjd_neom8n_set_measurement_rate(mjd_neom8n_config_t* ptr_param_config, uint16_t param_measurement_period_ms);
+esp_err_t mjd_neom8n_set_message_rate(mjd_neom8n_config_t* ptr_param_config, uint8_t param_msg_class, uint8_t param_msg_id, uint8_t param_rate);
+esp_err_t mjd_neom8n_set_ubx_mode(mjd_neom8n_config_t* ptr_param_config, const mjd_neom8n_ubx_mode_t* ptr_param_mode);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,99 @@
+/*
+ * Goto README.md for instructions
+ */
+#ifndef __MJD_NEOM8N_PARSER_H__
+#define __MJD_NEOM8N_PARSER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mjd_neom8n.h"
+#include "mjd_neom8n_ubx.h"
+
+/**
+ * STREAM PARSER
+ *
+ * @doc Incremental state machine parser for the byte stream of the GPS device: NMEA sentences and UBX frames may be interleaved.
+ * @doc Zero-copy: a NMEA sentence or a UBX payload that lies completely inside the chunk that is fed is parsed from a pointer into that chunk.
+ *      Only a frame that straddles 2 chunks is staged in the (small) parser buffer. UBX payloads that are not decoded are checksummed but never buffered.
+ * @doc The NMEA checksum (XOR) and the UBX checksum (8-Bit Fletcher) are computed on the fly; a frame with a bad checksum is dropped.
+ * @doc Decoded: NMEA RMC + GGA, UBX-NAV-PVT, UBX-NAV-SAT (summarized on the fly, never buffered), UBX-ACK-ACK/NAK.
+ *      The other frames are validated, counted and skipped.
+ * @doc Pure logic (no UART, no RTOS): the monitor task feeds the chunks of uart_read_bytes(); the host tests feed recorded GPS logs.
+ */
+#define MJD_NEOM8N_NMEA_MAX_LENGTH (82)  /*!< NMEA 0183: max 82 chars incl. the '$' and the CR LF */
+
+
+/**
+ * @brief The states of the parser
+ */
+typedef enum {
+    MJD_NEOM8N_PARSER_STATE_IDLE = 0, /*!< Hunt for '$' or UBX sync char 1 */
+    MJD_NEOM8N_PARSER_STATE_NMEA_BODY,
+    MJD_NEOM8N_PARSER_STATE_NMEA_CK_1,
+    MJD_NEOM8N_PARSER_STATE_NMEA_CK_2,
+    MJD_NEOM8N_PARSER_STATE_UBX_SYNC_2,
+    MJD_NEOM8N_PARSER_STATE_UBX_CLASS,
+    MJD_NEOM8N_PARSER_STATE_UBX_ID,
+    MJD_NEOM8N_PARSER_STATE_UBX_LENGTH_1,
+    MJD_NEOM8N_PARSER_STATE_UBX_LENGTH_2,
+    MJD_NEOM8N_PARSER_STATE_UBX_PAYLOAD,
+    MJD_NEOM8N_PARSER_STATE_UBX_CK_A,
+    MJD_NEOM8N_PARSER_STATE_UBX_CK_B,
+} mjd_neom8n_parser_state_t;
+
+/**
+ * @brief The statistics of the parser
+ */
+typedef struct {
+    uint32_t nbr_of_bytes; /*!< Total bytes fed */
+    uint32_t nbr_of_skipped_bytes; /*!< Bytes outside a frame (noise, line breaks, truncated frames) */
+    uint32_t nbr_of_nmea_sentences; /*!< NMEA sentences with a valid checksum */
+    uint32_t nbr_of_nmea_checksum_errors;
+    uint32_t nbr_of_nmea_overflows; /*!< NMEA sentences longer than MJD_NEOM8N_NMEA_MAX_LENGTH (dropped) */
+    uint32_t nbr_of_nmea_parse_errors; /*!< RMC/GGA sentences with a valid checksum but an invalid data format */
+    uint32_t nbr_of_ubx_frames; /*!< UBX frames with a valid checksum */
+    uint32_t nbr_of_ubx_checksum_errors;
+    uint32_t nbr_of_ubx_nav_pvt; /*!< UBX-NAV-PVT frames decoded */
+    uint32_t nbr_of_ubx_nav_sat; /*!< UBX-NAV-SAT frames decoded */
+    uint32_t nbr_of_ubx_acks; /*!< UBX-ACK-ACK + UBX-ACK-NAK frames decoded (see last_ack) */
+} mjd_neom8n_parser_stats_t;
+
+/**
+ * @brief The parser. Initialize it with mjd_neom8n_parser_init(). All fields are Private except last_ack.
+ */
+typedef struct {
+    mjd_neom8n_parser_state_t state;
+    mjd_neom8n_parser_stats_t stats;
+    const uint8_t *ptr_frame; /*!< Private: start of the current NMEA sentence or UBX payload in the chunk that is fed (NULL = staged) */
+    uint16_t frame_length; /*!< Private: bytes of the current NMEA sentence or UBX payload so far */
+    bool is_frame_kept; /*!< Private: the current frame is decoded when complete (NMEA, UBX-NAV-PVT, UBX-ACK) */
+    uint8_t nmea_checksum; /*!< Private: running XOR */
+    uint8_t nmea_checksum_received; /*!< Private */
+    uint8_t ubx_class; /*!< Private */
+    uint8_t ubx_id; /*!< Private */
+    uint16_t ubx_payload_length; /*!< Private */
+    uint8_t ubx_ck_a; /*!< Private: running Fletcher sum A */
+    uint8_t ubx_ck_b; /*!< Private: running Fletcher sum B */
+    uint8_t nav_sat_cno; /*!< Private: UBX-NAV-SAT C/N0 of the current SV block */
+    uint16_t nav_sat_nbr_of_svs; /*!< Private: UBX-NAV-SAT running summary */
+    uint16_t nav_sat_nbr_of_svs_used; /*!< Private */
+    uint32_t nav_sat_cno_sum; /*!< Private: of the SV's used */
+    mjd_neom8n_ubx_ack_t last_ack; /*!< The last UBX-ACK-ACK/NAK (valid when stats.nbr_of_ubx_acks > 0) */
+    uint8_t staging[MJD_NEOM8N_UBX_NAV_PVT_PAYLOAD_LENGTH]; /*!< Private: a frame that straddles 2 chunks (>= MJD_NEOM8N_NMEA_MAX_LENGTH) */
+} mjd_neom8n_parser_t;
+
+/**
+ * Function declarations
+ */
+esp_err_t mjd_neom8n_parser_init(mjd_neom8n_parser_t* param_ptr_parser);
+esp_err_t mjd_neom8n_parser_feed(mjd_neom8n_parser_t* param_ptr_parser, const uint8_t* param_ptr_buf, size_t param_len_buf,
+                                 mjd_neom8n_data_t* param_ptr_data);
+esp_err_t mjd_neom8n_parser_get_stats(const mjd_neom8n_parser_t* param_ptr_parser, mjd_neom8n_parser_stats_t* param_ptr_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_NEOM8N_PARSER_H__ */
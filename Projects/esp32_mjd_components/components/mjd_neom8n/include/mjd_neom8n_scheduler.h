@@ -0,0 +1,140 @@
+/*
+ * Goto README.md for instructions
+ */
+#ifndef __MJD_NEOM8N_SCHEDULER_H__
+#define __MJD_NEOM8N_SCHEDULER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mjd_neom8n.h"
+
+/**
+ * DUTY CYCLING SCHEDULER
+ *
+ * @doc Delivers 1 fix every fix_interval_ms at the lowest power:
+ *      - interval <= continuous_max_interval_ms: the receiver stays on (continuous tracking).
+ *      - interval <= power_save_max_interval_ms: the receiver runs its own power save mode (UBX-CFG-PM2 + UBX-CFG-RXM).
+ *      - else: the receiver is put in backup mode (UBX-RXM-PMREQ) between fixes and woken up for the next fix.
+ * @doc The receiver keeps its RTC, ephemeris and almanac in backup mode, so a wakeup is a hot start while the ephemeris is fresh.
+ *      The scheduler keeps the last fix (position + time) and estimates the start type of each wakeup.
+ *      A warm/cold start is assisted with the last position (UBX-MGA-INI-POS_LLH) and the system time (UBX-MGA-INI-TIME_UTC).
+ * @doc Pure logic (no UART, no RTOS): mjd_neom8n_scheduler_step() maps (time, GPS data) to an action;
+ *      the scheduler task of mjd_neom8n executes the actions. The host tests drive it with a simulated receiver.
+ */
+#define MJD_NEOM8N_SCHEDULER_EPHEMERIS_VALIDITY_MS (2 * 60 * 60 * 1000)  /*!< Ephemeris age limit for a hot start (broadcast ephemeris ~4h, margin) */
+#define MJD_NEOM8N_SCHEDULER_ALMANAC_VALIDITY_MS (7 * 24 * 60 * 60 * 1000U)  /*!< Almanac age limit for a warm start */
+
+/**
+ * @brief The configuration
+ */
+typedef struct {
+    uint32_t fix_interval_ms;            /*!< The app wants 1 fix every ... */
+    uint32_t fix_timeout_ms;             /*!< Give up the acquisition after ... (then sleep until the next interval) */
+    uint32_t continuous_max_interval_ms; /*!< Up to this interval the receiver stays on */
+    uint32_t power_save_max_interval_ms; /*!< Up to this interval the receiver runs its power save mode, above it is put in backup mode */
+} mjd_neom8n_scheduler_config_t;
+
+#define MJD_NEOM8N_SCHEDULER_CONFIG_DEFAULT() { \
+    .fix_interval_ms = 5 * 60 * 1000, \
+    .fix_timeout_ms = 90 * 1000, \
+    .continuous_max_interval_ms = 10 * 1000, \
+    .power_save_max_interval_ms = 2 * 60 * 1000 \
+}
+
+typedef enum {
+    MJD_NEOM8N_SCHEDULER_MODE_CONTINUOUS = 0,
+    MJD_NEOM8N_SCHEDULER_MODE_POWER_SAVE,
+    MJD_NEOM8N_SCHEDULER_MODE_BACKUP,
+} mjd_neom8n_scheduler_mode_t;
+
+typedef enum {
+    MJD_NEOM8N_SCHEDULER_STATE_STOPPED = 0,
+    MJD_NEOM8N_SCHEDULER_STATE_ACQUIRING, /*!< Receiver on, waiting for a fresh fix */
+    MJD_NEOM8N_SCHEDULER_STATE_TRACKING,  /*!< Continuous or power save mode: the receiver delivers the fixes itself */
+    MJD_NEOM8N_SCHEDULER_STATE_SLEEPING,  /*!< Backup mode until the next fix is due */
+} mjd_neom8n_scheduler_state_t;
+
+typedef enum {
+    MJD_NEOM8N_START_TYPE_HOT = 0,  /*!< Valid ephemeris + time + position: TTFF ~1..5s */
+    MJD_NEOM8N_START_TYPE_WARM,     /*!< Valid almanac, ephemeris expired: TTFF ~30s */
+    MJD_NEOM8N_START_TYPE_COLD,     /*!< Nothing known: TTFF ~30..60s */
+    MJD_NEOM8N_START_TYPE_MAX,
+} mjd_neom8n_start_type_t;
+
+/**
+ * @brief The actions for the driver (the scheduler task of mjd_neom8n)
+ */
+typedef enum {
+    MJD_NEOM8N_SCHEDULER_ACTION_NONE = 0,
+    MJD_NEOM8N_SCHEDULER_ACTION_POWER_UP,         /*!< Wake up the receiver (+ aiding if is_aiding_requested) */
+    MJD_NEOM8N_SCHEDULER_ACTION_POWER_DOWN,       /*!< Backup mode for duration_ms */
+    MJD_NEOM8N_SCHEDULER_ACTION_ENABLE_POWER_SAVE, /*!< UBX-CFG-PM2 with update_period_ms + UBX-CFG-RXM power save */
+} mjd_neom8n_scheduler_action_type_t;
+
+typedef struct {
+    mjd_neom8n_scheduler_action_type_t type;
+    uint32_t duration_ms;      /*!< POWER_DOWN */
+    uint32_t update_period_ms; /*!< ENABLE_POWER_SAVE */
+    bool is_aiding_requested;  /*!< POWER_UP: send the last fix (aiding_latitude...) as the approximate position */
+    float aiding_latitude;
+    float aiding_longitude;
+    float aiding_altitude_m;
+} mjd_neom8n_scheduler_action_t;
+
+/**
+ * @brief The statistics. TTFF = time to first fix after a wakeup (or after the start).
+ */
+typedef struct {
+    uint32_t nbr_of_wakeups;
+    uint32_t nbr_of_fixes;      /*!< Wakeups that delivered a fix */
+    uint32_t nbr_of_timeouts;   /*!< Wakeups without a fix within fix_timeout_ms */
+    uint32_t nbr_of_starts[MJD_NEOM8N_START_TYPE_MAX]; /*!< The estimated start type of each wakeup */
+    uint32_t ttff_last_ms;
+    uint32_t ttff_min_ms;
+    uint32_t ttff_max_ms;
+    uint64_t ttff_sum_ms;       /*!< Mean = ttff_sum_ms / nbr_of_fixes */
+    uint64_t time_on_ms;        /*!< Receiver on (acquiring or tracking) */
+    uint64_t time_backup_ms;    /*!< Receiver in backup mode */
+} mjd_neom8n_scheduler_stats_t;
+
+/**
+ * @brief The scheduler. Initialize it with mjd_neom8n_scheduler_init(). All fields are Private except stats and the last fix.
+ */
+typedef struct {
+    mjd_neom8n_scheduler_config_t config;
+    mjd_neom8n_scheduler_mode_t mode;
+    mjd_neom8n_scheduler_state_t state;
+    mjd_neom8n_scheduler_stats_t stats;
+    int64_t last_step_us;
+    int64_t wakeup_us;          /*!< Private: start of the current acquisition */
+    int64_t sleep_until_us;     /*!< Private */
+    uint32_t fix_counter_at_wakeup; /*!< Private: mjd_neom8n_data_t.fix_counter when the acquisition started */
+    uint32_t fix_counter_last;  /*!< Private */
+    bool has_last_fix;
+    int64_t last_fix_us;        /*!< The time of the last fix (esp_timer) */
+    float last_fix_latitude;
+    float last_fix_longitude;
+    float last_fix_altitude_m;
+} mjd_neom8n_scheduler_t;
+
+/**
+ * Function declarations
+ */
+esp_err_t mjd_neom8n_scheduler_init(mjd_neom8n_scheduler_t* param_ptr_scheduler, const mjd_neom8n_scheduler_config_t* param_ptr_config);
+esp_err_t mjd_neom8n_scheduler_step(mjd_neom8n_scheduler_t* param_ptr_scheduler, int64_t param_now_us, const mjd_neom8n_data_t* param_ptr_data,
+                                    mjd_neom8n_scheduler_action_t* param_ptr_action);
+mjd_neom8n_scheduler_mode_t mjd_neom8n_scheduler_select_mode(const mjd_neom8n_scheduler_config_t* param_ptr_config);
+mjd_neom8n_start_type_t mjd_neom8n_scheduler_estimate_start_type(const mjd_neom8n_scheduler_t* param_ptr_scheduler, int64_t param_now_us);
+
+// The scheduler task (mjd_neom8n.c)
+esp_err_t mjd_neom8n_scheduler_start(mjd_neom8n_config_t* ptr_param_config, const mjd_neom8n_scheduler_config_t* ptr_param_scheduler_config);
+esp_err_t mjd_neom8n_scheduler_stop(mjd_neom8n_config_t* ptr_param_config);
+esp_err_t mjd_neom8n_scheduler_get_stats(mjd_neom8n_scheduler_stats_t* ptr_param_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_NEOM8N_SCHEDULER_H__ */
@@ -0,0 +1,103 @@
+/*
+ * Goto README.md for instructions
+ */
+#ifndef __MJD_NEOM8N_UBX_H__
+#define __MJD_NEOM8N_UBX_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mjd_neom8n.h"
+
+/**
+ * UBX PROTOCOL
+ *
+ * @doc Frame: sync char 1 + sync char 2 + class + id + length (U2, little endian) + payload + CK_A + CK_B.
+ * @doc The builders write a complete frame (checksum included) in the buffer of the caller: no malloc.
+ * @doc u-blox 8 / M8 Receiver Description incl. Protocol Specification (UBX-13003221), protocol version 18.
+ */
+#define MJD_NEOM8N_UBX_SYNC_CHAR_1 (0xB5)
+#define MJD_NEOM8N_UBX_SYNC_CHAR_2 (0x62)
+#define MJD_NEOM8N_UBX_FRAME_OVERHEAD (8)  /*!< 2 sync chars + class + id + length (2) + checksum (2) */
+
+#define MJD_NEOM8N_UBX_CLASS_NAV (0x01)
+#define MJD_NEOM8N_UBX_CLASS_RXM (0x02)
+#define MJD_NEOM8N_UBX_CLASS_ACK (0x05)
+#define MJD_NEOM8N_UBX_CLASS_CFG (0x06)
+#define MJD_NEOM8N_UBX_CLASS_MGA (0x13)
+#define MJD_NEOM8N_UBX_CLASS_NMEA (0xF0)  /*!< The standard NMEA messages (for UBX-CFG-MSG) */
+
+#define MJD_NEOM8N_UBX_ID_NAV_PVT (0x07)
+#define MJD_NEOM8N_UBX_ID_NAV_SAT (0x35)
+#define MJD_NEOM8N_UBX_ID_ACK_NAK (0x00)
+#define MJD_NEOM8N_UBX_ID_ACK_ACK (0x01)
+#define MJD_NEOM8N_UBX_ID_CFG_PRT (0x00)
+#define MJD_NEOM8N_UBX_ID_CFG_MSG (0x01)
+#define MJD_NEOM8N_UBX_ID_CFG_RATE (0x08)
+#define MJD_NEOM8N_UBX_ID_CFG_RXM (0x11)
+#define MJD_NEOM8N_UBX_ID_CFG_PM2 (0x3B)
+#define MJD_NEOM8N_UBX_ID_RXM_PMREQ (0x41)
+#define MJD_NEOM8N_UBX_ID_MGA_INI (0x40)
+
+#define MJD_NEOM8N_UBX_NAV_PVT_PAYLOAD_LENGTH (92)
+#define MJD_NEOM8N_UBX_NAV_SAT_HEADER_LENGTH (8)
+#define MJD_NEOM8N_UBX_NAV_SAT_BLOCK_LENGTH (12)  /*!< Repeated numSvs times after the header */
+#define MJD_NEOM8N_UBX_ACK_PAYLOAD_LENGTH (2)
+#define MJD_NEOM8N_UBX_CFG_PRT_PAYLOAD_LENGTH (20)
+#define MJD_NEOM8N_UBX_CFG_MSG_PAYLOAD_LENGTH (3)
+#define MJD_NEOM8N_UBX_CFG_RATE_PAYLOAD_LENGTH (6)
+#define MJD_NEOM8N_UBX_CFG_RXM_PAYLOAD_LENGTH (2)
+#define MJD_NEOM8N_UBX_CFG_PM2_PAYLOAD_LENGTH (44)
+#define MJD_NEOM8N_UBX_RXM_PMREQ_PAYLOAD_LENGTH (8)
+#define MJD_NEOM8N_UBX_MGA_INI_POS_LLH_PAYLOAD_LENGTH (20)
+#define MJD_NEOM8N_UBX_MGA_INI_TIME_UTC_PAYLOAD_LENGTH (24)
+
+#define MJD_NEOM8N_UBX_PORT_ID_UART1 (1)  /*!< The receiver UART that is wired to the ESP32 */
+#define MJD_NEOM8N_UBX_PROTO_MASK_UBX (0x0001)
+#define MJD_NEOM8N_UBX_PROTO_MASK_NMEA (0x0002)
+
+/**
+ * @brief The result of a UBX-ACK-ACK or UBX-ACK-NAK
+ */
+typedef struct {
+    uint8_t msg_class; /*!< Class of the acknowledged CFG message */
+    uint8_t msg_id; /*!< Id of the acknowledged CFG message */
+    bool is_ack; /*!< true = ACK-ACK, false = ACK-NAK */
+} mjd_neom8n_ubx_ack_t;
+
+/**
+ * Function declarations
+ */
+void mjd_neom8n_ubx_checksum(const uint8_t* param_ptr_buf, size_t param_len_buf, uint8_t* param_ptr_ck_a, uint8_t* param_ptr_ck_b);
+
+esp_err_t mjd_neom8n_ubx_build_frame(uint8_t param_class, uint8_t param_id, const uint8_t* param_ptr_payload, uint16_t param_len_payload,
+                                     uint8_t* param_ptr_buf, size_t param_len_buf, size_t* param_ptr_len_frame);
+esp_err_t mjd_neom8n_ubx_build_cfg_msg(uint8_t param_msg_class, uint8_t param_msg_id, uint8_t param_rate, uint8_t* param_ptr_buf,
+                                       size_t param_len_buf, size_t* param_ptr_len_frame);
+esp_err_t mjd_neom8n_ubx_build_cfg_rate(uint16_t param_measurement_period_ms, uint8_t* param_ptr_buf, size_t param_len_buf,
+                                        size_t* param_ptr_len_frame);
+esp_err_t mjd_neom8n_ubx_build_cfg_prt_uart(uint32_t param_baud_rate, uint16_t param_in_proto_mask, uint16_t param_out_proto_mask,
+                                            uint8_t* param_ptr_buf, size_t param_len_buf, size_t* param_ptr_len_frame);
+
+esp_err_t mjd_neom8n_ubx_build_rxm_pmreq(uint32_t param_duration_ms, uint8_t* param_ptr_buf, size_t param_len_buf, size_t* param_ptr_len_frame);
+esp_err_t mjd_neom8n_ubx_build_cfg_rxm(bool param_is_power_save, uint8_t* param_ptr_buf, size_t param_len_buf, size_t* param_ptr_len_frame);
+esp_err_t mjd_neom8n_ubx_build_cfg_pm2(uint32_t param_update_period_ms, uint32_t param_search_period_ms, uint8_t* param_ptr_buf,
+                                       size_t param_len_buf, size_t* param_ptr_len_frame);
+esp_err_t mjd_neom8n_ubx_build_mga_ini_pos_llh(float param_latitude, float param_longitude, float param_altitude_m,
+                                               uint32_t param_accuracy_m, uint8_t* param_ptr_buf, size_t param_len_buf,
+                                               size_t* param_ptr_len_frame);
+esp_err_t mjd_neom8n_ubx_build_mga_ini_time_utc(time_t param_utc_time, uint16_t param_accuracy_s, uint8_t* param_ptr_buf,
+                                                size_t param_len_buf, size_t* param_ptr_len_frame);
+
+esp_err_t mjd_neom8n_ubx_decode_nav_pvt(const uint8_t* param_ptr_payload, size_t param_len_payload, mjd_neom8n_data_t* param_ptr_data);
+esp_err_t mjd_neom8n_ubx_decode_ack(uint8_t param_id, const uint8_t* param_ptr_payload, size_t param_len_payload,
+                                    mjd_neom8n_ubx_ack_t* param_ptr_ack);
+
+uint32_t mjd_neom8n_ubx_get_mode_bytes_per_second(const mjd_neom8n_ubx_mode_t* param_ptr_mode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_NEOM8N_UBX_H__ */
@@ -3,9 +3,14 @@
  *
  */
 
+#include "esp_timer.h"
+
 // Component header file(s)
 #include "mjd.h"
 #include "mjd_neom8n.h"
+#include "mjd_neom8n_parser.h"
+#include "mjd_neom8n_scheduler.h"
+#include "mjd_neom8n_ubx.h"
 
 // Extra includes
 #include <math.h>
@@ -27,17 +32,39 @@ static const char TAG[] = "mjd_neom8n";
 #define MY_UART_BAUD_SPEED (9600)
 #define MY_UART_RX_RINGBUFFER_SIZE (2048)
 #define MY_UART_READBYTES_BUF_SIZE (512)
-#define MY_UART_READBYTES_BUF_SIZE_PLUS_ONE (513)
 #define MY_UART_READBYTES_TIMEOUT (RTOS_DELAY_MAX)
 
-#define MY_GPS_LATLONG_ACCURACY_THRESHOLD (0.00001)
+#define MY_UBX_ACK_TIMEOUT_MS (1000)
+#define MY_UBX_ACK_POLL_MS (10)
+#define MY_UBX_TX_BUF_SIZE (64)  // @doc The largest frame that is sent = UBX-CFG-PM2 (52 bytes)
+#define MY_UART_BANDWIDTH_PERCENT (80)  // @doc Keep headroom on the UART: 8N1 = 10 bits per byte
 
 static mjd_neom8n_data_t _neom8n_data;
 
+// @important static: keep the parser off the (small) task stack. Guarded by _neom8n_service_semaphore (mjd_neom8n_set_ubx_mode() waits for the ACK's).
+static mjd_neom8n_parser_t _neom8n_parser;
+
 static SemaphoreHandle_t _neom8n_service_semaphore = NULL;
+// @important 1 UBX command at a time (the app and the scheduler task): an ACK only tells the class + id, not who sent the command.
+//            Take it before _neom8n_service_semaphore, never the other way round.
+static SemaphoreHandle_t _neom8n_ubx_command_semaphore = NULL;
 
 static volatile TaskHandle_t _neom8n_gps_monitor_task_handle = NULL;
 
+#define MY_SCHEDULER_STEP_DELAY (RTOS_DELAY_1SEC)  // @doc The TTFF resolution
+#define MY_SCHEDULER_SEARCH_PERIOD_MS (10000)  // @doc UBX-CFG-PM2: retry period after a failed acquisition in the power save mode
+#define MY_SCHEDULER_AIDING_POSITION_ACCURACY_M (10000)  // @doc The device may have moved since the last fix
+#define MY_SCHEDULER_AIDING_TIME_ACCURACY_S (10)
+#define MY_SCHEDULER_VALID_TIME_MIN (1546300800)  // @doc 2019-01-01 UTC: an older system time has not been set (SNTP) and is useless for aiding
+
+// @important static: guarded by _neom8n_service_semaphore (mjd_neom8n_scheduler_get_stats() reads the stats)
+static mjd_neom8n_scheduler_t _neom8n_scheduler;
+static mjd_neom8n_config_t _neom8n_scheduler_device_config;
+static volatile TaskHandle_t _neom8n_scheduler_task_handle = NULL;
+// @important The scheduler task stops itself (it may hold _neom8n_service_semaphore): mjd_neom8n_scheduler_stop() sets the flag and waits for the exit semaphore.
+static volatile bool _neom8n_scheduler_is_stop_requested = false;
+static SemaphoreHandle_t _neom8n_scheduler_exit_semaphore = NULL;
+
 /**************************************
  * STUBS
  */
@@ -83,66 +110,12 @@ static int _stub_uart_read_bytes(uart_port_t uart_num, uint8_t* buf, uint32_t le
  * MONITOR TASK
  *
  */
-static char* _get_next_line(uart_port_t param_uart_port) {
-    static char line[MINMEA_MAX_LENGTH] = "";
-    char *ptr_line = line;
-
-    static uint8_t data_rx[MY_UART_READBYTES_BUF_SIZE_PLUS_ONE]; // @important +1 for the appended \0 character
-    static uint8_t *ptr_data_rx;
-    static int counter_data_rx = 0;    // @important 0 signals the data_rx buffer is empty
-
-    while (1) {
-        if (counter_data_rx <= 0) {   // @important POST Decrement
-            // Read data from external UART1
-            if (MY_NEOM8N_USE_STUB_UART_READBYTES == false) {
-                counter_data_rx = uart_read_bytes(param_uart_port, data_rx, MY_UART_READBYTES_BUF_SIZE,
-                MY_UART_READBYTES_TIMEOUT);
-            } else {
-                counter_data_rx = _stub_uart_read_bytes(param_uart_port, data_rx, MY_UART_READBYTES_BUF_SIZE,
-                MY_UART_READBYTES_TIMEOUT);
-            }
-
-            if (counter_data_rx == ESP_FAIL) {
-                ESP_LOGE(TAG, "    _get_next_line(): uart_read_bytes() err %i (%s)", counter_data_rx, esp_err_to_name(counter_data_rx));
-                // ABORT
-                return NULL;
-            }
-            if (counter_data_rx == 0) {
-                ESP_LOGW(TAG, "    _get_next_line(): uart_read_bytes() 0 bytes returned");
-                // ABORT
-                return NULL;
-            }
-
-            // DEVTEMP
-            ESP_LOGV(TAG, "    _get_next_line(): ESP_LOG_BUFFER_HEXDUMP(): data_rx");
-            ESP_LOG_BUFFER_HEXDUMP(TAG, data_rx, counter_data_rx, ESP_LOG_VERBOSE);
-
-            ptr_data_rx = data_rx; // reset ptr
-        }
-
-        // Detect new line.
-        // @doc 0xD 0xA => 0x0D 0x00 [0xD \r is the return character][0xA \n is the newline character]
-        if (*ptr_data_rx == '\n') {
-            *ptr_line = '\0'; // put marker BEFORE resetting the ptr_line
-            if (*(ptr_line - 1) == '\r') { // Remove the \r right before the \n as well, but only if it exists @important Handle case where \n is not prefixed with \r
-                *(ptr_line - 1) = '\0';
-            }
-            ptr_line = line; // reset ptr to line[0] BEFORE return-ing
-            ++ptr_data_rx; // advance ptr to data_rx BEFORE return-ing
-            --counter_data_rx; // DECREASE counter data_rx
-            // RETURN
-            return line;
-        }
-
-        // Copy 1 byte & advance ptr's
-        *ptr_line++ = *ptr_data_rx++;
-        --counter_data_rx; // DECREASE counter data_rx
-    }
-}
-
 static void _neom8n_gps_monitor_task(void *pvParameters) {
     ESP_LOGD(TAG, "%s()", __FUNCTION__);
 
+    // @important static: keep the UART chunk off the (small) task stack
+    static uint8_t data_rx[MY_UART_READBYTES_BUF_SIZE];
+
     mjd_neom8n_data_t *ptr_data = &_neom8n_data;
 
     while (1) {
@@ -151,91 +124,38 @@ static void _neom8n_gps_monitor_task(void *pvParameters) {
 
         /////mjd_log_memory_statistics();
 
-        char *line_uart = _get_next_line(UART_NUM_1);
-        if (line_uart == NULL) {
-            ESP_LOGW(TAG, "        _neom8n_gps_monitor_task(): line_uart == NULL (continue to next iter)");
+        // Read data from external UART1
+        int counter_data_rx;
+        if (MY_NEOM8N_USE_STUB_UART_READBYTES == false) {
+            counter_data_rx = uart_read_bytes(UART_NUM_1, data_rx, MY_UART_READBYTES_BUF_SIZE, MY_UART_READBYTES_TIMEOUT);
+        } else {
+            counter_data_rx = _stub_uart_read_bytes(UART_NUM_1, data_rx, MY_UART_READBYTES_BUF_SIZE, MY_UART_READBYTES_TIMEOUT);
+        }
+        if (counter_data_rx == ESP_FAIL) {
+            ESP_LOGE(TAG, "        _neom8n_gps_monitor_task(): uart_read_bytes() err %i (%s) (continue to next iter)", counter_data_rx,
+                    esp_err_to_name(counter_data_rx));
             // CONTINUE
             continue;
         }
-
-        // Mark data is being received (an indication that the GPS device is working)
-        MJD_NEOM8N_SERVICE_LOCK();
-        ptr_data->data_received = true;
-        MJD_NEOM8N_SERVICE_UNLOCK();
-
-        // Write data to internal UART0 (make monitor log output is mapped to that UART)
-        ESP_LOGD(TAG, "        _neom8n_gps_monitor_task(): line_uart: %s", line_uart);
-
-        // parse the line
-        //  @doc minmea_tocoord() converts a raw coordinate to a human readable notation floating point value DD.DDD... Returns NaN for "unknown" values.
-        switch (minmea_sentence_id(line_uart, false)) {
-        case MINMEA_SENTENCE_RMC: {
-            struct minmea_sentence_rmc frame;
-
-            if (minmea_parse_rmc(&frame, line_uart) == true) {
-                // latitude valid, and changed significantly?
-                float new_latitude = minmea_tocoord(&frame.latitude);
-                if ((isnan(new_latitude) == false) && (abs(new_latitude - ptr_data->latitude) > MY_GPS_LATLONG_ACCURACY_THRESHOLD)) {
-                    MJD_NEOM8N_SERVICE_LOCK();
-                    ptr_data->latitude = new_latitude;
-                    MJD_NEOM8N_SERVICE_UNLOCK();
-                    ESP_LOGD(TAG, "        _neom8n_gps_monitor_task(): $RMC Updated latitude: %f\n", ptr_data->latitude);
-                }
-                // longitude valid, and changed significantly?
-                float new_longitude = minmea_tocoord(&frame.longitude);
-                if ((isnan(new_longitude) == false) && (abs(new_longitude - ptr_data->longitude) > MY_GPS_LATLONG_ACCURACY_THRESHOLD)) {
-                    MJD_NEOM8N_SERVICE_LOCK();
-                    ptr_data->longitude = new_longitude;
-                    MJD_NEOM8N_SERVICE_UNLOCK();
-                    ESP_LOGD(TAG, "        _neom8n_gps_monitor_task(): $RMC Updated longitude: %f\n", ptr_data->longitude);
-                }
-            } else {
-                ESP_LOGW(TAG, "        _neom8n_gps_monitor_task(): minmea_parse_rmc() invalid data format");
-            }
-            break;
+        if (counter_data_rx == 0) {
+            ESP_LOGW(TAG, "        _neom8n_gps_monitor_task(): uart_read_bytes() 0 bytes returned (continue to next iter)");
+            // CONTINUE
+            continue;
         }
 
-        case MINMEA_SENTENCE_GGA: {
-            /*
-             * frame.fix_quality = GPS Quality indicator
-             *   0: Fix not valid
-             *   1: GPS fix ***OK***
-             *   2: Differential GPS fix, OmniSTAR VBS
-             *   4: Real-Time Kinematic, fixed integers
-             *   5: Real-Time Kinematic, float integers, OmniSTAR XP/HP or Location RTK
-             *
-             * frame.satellites_tracked = Number of satellites ("SV") in use, range from 00 through to 24+.
-             */
-            struct minmea_sentence_gga frame;
-
-            if (minmea_parse_gga(&frame, line_uart)) {
-                // fix quality changed?
-                if (frame.fix_quality != ptr_data->fix_quality) {
-                    MJD_NEOM8N_SERVICE_LOCK();
-                    ptr_data->fix_quality = frame.fix_quality;
-                    MJD_NEOM8N_SERVICE_UNLOCK();
-                    ESP_LOGD(TAG, "        _neom8n_gps_monitor_task(): $GGA UPDATED fix quality: %i\n", ptr_data->fix_quality);
-                }
-                // number of satellites changed?
-                if (frame.satellites_tracked != ptr_data->satellites_tracked) {
-                    MJD_NEOM8N_SERVICE_LOCK();
-                    ptr_data->satellites_tracked = frame.satellites_tracked;
-                    MJD_NEOM8N_SERVICE_UNLOCK();
-                    ESP_LOGD(TAG, "        _neom8n_gps_monitor_task(): $GGA UPDATED satellites_tracked: %d\n", ptr_data->satellites_tracked);
-                }
-            } else {
-                ESP_LOGW(TAG, "        _neom8n_gps_monitor_task(): minmea_parse_gga() invalid data format");
-            }
-            break;
-        }
+        // DEVTEMP
+        ESP_LOGV(TAG, "        _neom8n_gps_monitor_task(): ESP_LOG_BUFFER_HEXDUMP(): data_rx");
+        ESP_LOG_BUFFER_HEXDUMP(TAG, data_rx, counter_data_rx, ESP_LOG_VERBOSE);
 
-        case MINMEA_INVALID: {
-            ESP_LOGW(TAG, "        _neom8n_gps_monitor_task(): minmea_sentence_id() data MINMEA_INVALID (or unknown) for %s", line_uart);
-            break;
-        }
+        // Parse the chunk in place: NMEA RMC + GGA and UBX-NAV-PVT update the data struct directly
+        //  @doc Parsing a chunk takes microseconds so the lock is held for the whole chunk (instead of per field).
+        MJD_NEOM8N_SERVICE_LOCK();
+        esp_err_t parser_retval = mjd_neom8n_parser_feed(&_neom8n_parser, data_rx, counter_data_rx, ptr_data);
+        MJD_NEOM8N_SERVICE_UNLOCK();
 
-        default:
-            break;
+        if (parser_retval == ESP_OK) {
+            ESP_LOGD(TAG, "        _neom8n_gps_monitor_task(): UPDATED fix quality %i | satellites_tracked %i | lat %f long %f",
+                    ptr_data->fix_quality, ptr_data->satellites_tracked, ptr_data->latitude, ptr_data->longitude);
         }
     }
 
@@ -264,6 +184,15 @@ esp_err_t mjd_neom8n_init(mjd_neom8n_config_t* ptr_param_config) {
             goto cleanup;
         }
     }
+    if (!_neom8n_ubx_command_semaphore) {
+        _neom8n_ubx_command_semaphore = xSemaphoreCreateMutex();
+        if (!_neom8n_ubx_command_semaphore) {
+            f_retval = ESP_FAIL;
+            ESP_LOGE(TAG, "xSemaphoreCreateMutex() err %i (%s)", f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+    }
 
     // Configure the UART1 controller
     uart_config_t uart_config = { .baud_rate = MY_UART_BAUD_SPEED, .data_bits = UART_DATA_8_BITS, .parity =
@@ -298,6 +227,21 @@ esp_err_t mjd_neom8n_init(mjd_neom8n_config_t* ptr_param_config) {
         mjd_neom8n_cold_start_forced(ptr_param_config);
     }
 
+    // INIT My static Data structure _neom8n_data (BEFORE the monitor task starts writing to it)
+    mjd_neom8n_data_t *ptr_data = &_neom8n_data;
+    ptr_data->data_received = false;
+    ptr_data->fix_quality = -1;
+    ptr_data->latitude = NAN;
+    ptr_data->longitude = NAN;
+    ptr_data->satellites_tracked = -1;
+    ptr_data->altitude_m = NAN;
+    ptr_data->ground_speed_kmh = NAN;
+    ptr_data->horizontal_accuracy_m = NAN;
+    ptr_data->satellites_visible = -1;
+    ptr_data->cno_mean_dbhz = -1;
+    ptr_data->fix_counter = 0;
+    mjd_neom8n_parser_init(&_neom8n_parser);
+
     // RTOS Create service task
     //      @important For stability (RMT + Wifi etc.): always use xTaskCreatePinnedToCore(APP_CPU_NUM) [Opposed to xTaskCreate() which might run the code on PRO_CPU_NUM...]
     BaseType_t xReturned;
@@ -311,14 +255,6 @@ esp_err_t mjd_neom8n_init(mjd_neom8n_config_t* ptr_param_config) {
         goto cleanup;
     }
 
-    // INIT My static Data structure _neom8n_data
-    mjd_neom8n_data_t *ptr_data = &_neom8n_data;
-    ptr_data->data_received = false;
-    ptr_data->fix_quality = -1;
-    ptr_data->latitude = NAN;
-    ptr_data->longitude = NAN;
-    ptr_data->satellites_tracked = -1;
-
     // LABEL
     cleanup: ;
 
@@ -363,12 +299,7 @@ esp_err_t mjd_neom8n_read(mjd_neom8n_config_t* ptr_param_config, mjd_neom8n_data
 
     // Copy the actual data from my static Data structure (filled async'ly from the monitor task)
     MJD_NEOM8N_SERVICE_LOCK();
-    mjd_neom8n_data_t *ptr_data = &_neom8n_data;
-    ptr_param_data->data_received = ptr_data->data_received;
-    ptr_param_data->fix_quality = ptr_data->fix_quality;
-    ptr_param_data->latitude = ptr_data->latitude;
-    ptr_param_data->longitude = ptr_data->longitude;
-    ptr_param_data->satellites_tracked = ptr_data->satellites_tracked;
+    *ptr_param_data = _neom8n_data;
     MJD_NEOM8N_SERVICE_UNLOCK();
 
     // LABEL
@@ -553,6 +484,8 @@ esp_err_t mjd_neom8n_gnss_start(mjd_neom8n_config_t* ptr_param_config) {
 /**
  * @brief Set the Measurement Rate 1000ms (the default rate).
  *
+ * @deprecated Use mjd_neom8n_set_measurement_rate() (any rate, waits for the ACK).
+ *
  * Each measurement triggers the measurements generation and raw data output. 1000ms is
  *
  * @param uart_num UART_NUM_0, UART_NUM_1 or UART_NUM_2
@@ -580,6 +513,8 @@ esp_err_t mjd_neom8n_set_measurement_rate_1000ms(mjd_neom8n_config_t* ptr_param_
 /**
  * @brief Set the Measurement Rate 100ms (faster rate).
  *
+ * @deprecated Use mjd_neom8n_set_measurement_rate() (any rate, waits for the ACK).
+ *
  * Each measurement triggers the measurements generation and raw data output. 1000ms is the default rate.
  *
  * @param uart_num UART_NUM_0, UART_NUM_1 or UART_NUM_2
@@ -607,6 +542,8 @@ esp_err_t mjd_neom8n_set_measurement_rate_100ms(mjd_neom8n_config_t* ptr_param_c
 /**
  * @brief Set the Measurement Rate 5000ms (slower rate).
  *
+ * @deprecated Use mjd_neom8n_set_measurement_rate() (any rate, waits for the ACK).
+ *
  * Each measurement triggers the measurements generation and raw data output. 1000ms is the default rate.
  *
  * @param uart_num UART_NUM_0, UART_NUM_1 or UART_NUM_2
@@ -631,3 +568,498 @@ esp_err_t mjd_neom8n_set_measurement_rate_5000ms(mjd_neom8n_config_t* ptr_param_
     return f_retval;
 }
 
+
+/**************************************
+ * UBX BINARY MODE
+ *
+ * Reconfigure the receiver at runtime: UBX-NAV-PVT only (+ optionally UBX-NAV-SAT), any measurement rate up to 10Hz, a higher baud rate.
+ * The configuration is in the RAM of the receiver (not saved): it is lost after a power cycle of the GPS device.
+ *
+ */
+static esp_err_t _ubx_send(mjd_neom8n_config_t* ptr_param_config, const uint8_t* param_ptr_frame, size_t param_len_frame) {
+    esp_err_t f_retval = ESP_OK;
+
+    int nbr_of_bytes = uart_write_bytes(ptr_param_config->uart_port, (const char *) param_ptr_frame, param_len_frame);
+    if (nbr_of_bytes != (int) param_len_frame) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). ABORT. uart_write_bytes() returned %i | err %i (%s)", __FUNCTION__, nbr_of_bytes, f_retval,
+                esp_err_to_name(f_retval));
+    }
+
+    return f_retval;
+}
+
+/*
+ * @brief Send a UBX-CFG frame and wait for its UBX-ACK-ACK (decoded by the parser of the monitor task).
+ *
+ * @important The whole exchange holds _neom8n_ubx_command_semaphore: a concurrent exchange (f.e. the scheduler task that enables the power
+ *            save mode while the app calls mjd_neom8n_set_ubx_mode()) cannot take this ACK.
+ *
+ * @return
+ *     - ESP_OK ACK-ACK
+ *     - ESP_FAIL ACK-NAK (the receiver rejected the configuration) or a UART error
+ *     - ESP_ERR_TIMEOUT No ACK within MY_UBX_ACK_TIMEOUT_MS
+ */
+static esp_err_t _ubx_send_and_wait_for_ack(mjd_neom8n_config_t* ptr_param_config, const uint8_t* param_ptr_frame, size_t param_len_frame) {
+    esp_err_t f_retval = ESP_OK;
+
+    uint8_t msg_class = param_ptr_frame[2];
+    uint8_t msg_id = param_ptr_frame[3];
+    mjd_neom8n_ubx_ack_t ack;
+    uint32_t nbr_of_acks_before, nbr_of_acks;
+
+    MJD_NEOM8N_UBX_COMMAND_LOCK();
+
+    MJD_NEOM8N_SERVICE_LOCK();
+    nbr_of_acks_before = _neom8n_parser.stats.nbr_of_ubx_acks;
+    MJD_NEOM8N_SERVICE_UNLOCK();
+
+    f_retval = _ubx_send(ptr_param_config, param_ptr_frame, param_len_frame);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+
+    f_retval = ESP_ERR_TIMEOUT;
+    for (uint32_t elapsed_ms = 0; elapsed_ms < MY_UBX_ACK_TIMEOUT_MS; elapsed_ms += MY_UBX_ACK_POLL_MS) {
+        vTaskDelay(RTOS_DELAY_10MILLISEC);
+
+        MJD_NEOM8N_SERVICE_LOCK();
+        nbr_of_acks = _neom8n_parser.stats.nbr_of_ubx_acks;
+        ack = _neom8n_parser.last_ack;
+        MJD_NEOM8N_SERVICE_UNLOCK();
+
+        if (nbr_of_acks != nbr_of_acks_before && ack.msg_class == msg_class && ack.msg_id == msg_id) {
+            f_retval = (ack.is_ack == true) ? ESP_OK : ESP_FAIL;
+            break;
+        }
+    }
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. UBX msg class 0x%02X id 0x%02X not acknowledged | err %i (%s)", __FUNCTION__, msg_class, msg_id,
+                f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    MJD_NEOM8N_UBX_COMMAND_UNLOCK();
+
+    return f_retval;
+}
+
+/**
+ * @brief Set the Measurement Rate (UBX-CFG-RATE) and wait for the ACK.
+ *
+ * @param param_measurement_period_ms 100 (10Hz) .. 10000.
+ *
+ * @important The monitor task must be running (mjd_neom8n_init()) because it decodes the ACK.
+ */
+esp_err_t mjd_neom8n_set_measurement_rate(mjd_neom8n_config_t* ptr_param_config, uint16_t param_measurement_period_ms) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    uint8_t frame[MY_UBX_TX_BUF_SIZE];
+    size_t len_frame;
+
+    if (param_measurement_period_ms < 100 || param_measurement_period_ms > 10000) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid measurement period %u ms (100..10000) | err %i (%s)", __FUNCTION__,
+                param_measurement_period_ms, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (_neom8n_gps_monitor_task_handle == NULL) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. The monitor task is not running (call mjd_neom8n_init() first) | err %i (%s)", __FUNCTION__, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    f_retval = mjd_neom8n_ubx_build_cfg_rate(param_measurement_period_ms, frame, sizeof(frame), &len_frame);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+    f_retval = _ubx_send_and_wait_for_ack(ptr_param_config, frame, len_frame);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/**
+ * @brief Set the output rate of a UBX or NMEA message on the UART of the receiver (UBX-CFG-MSG) and wait for the ACK.
+ *
+ * @param param_rate 0 = off, N = every N navigation solutions.
+ *
+ * @important The monitor task must be running (mjd_neom8n_init()) because it decodes the ACK.
+ */
+esp_err_t mjd_neom8n_set_message_rate(mjd_neom8n_config_t* ptr_param_config, uint8_t param_msg_class, uint8_t param_msg_id, uint8_t param_rate) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    uint8_t frame[MY_UBX_TX_BUF_SIZE];
+    size_t len_frame;
+
+    if (_neom8n_gps_monitor_task_handle == NULL) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. The monitor task is not running (call mjd_neom8n_init() first) | err %i (%s)", __FUNCTION__, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    f_retval = mjd_neom8n_ubx_build_cfg_msg(param_msg_class, param_msg_id, param_rate, frame, sizeof(frame), &len_frame);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+    f_retval = _ubx_send_and_wait_for_ack(ptr_param_config, frame, len_frame);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/**
+ * @brief Switch the receiver to the UBX binary mode.
+ *
+ * 1. Disable the standard NMEA sentences GGA GLL GSA GSV RMC VTG.
+ * 2. Enable UBX-NAV-PVT every solution, and UBX-NAV-SAT every nav_sat_rate solutions (or disable it).
+ * 3. Set the measurement rate.
+ * 4. UART1 of the receiver: output UBX only, at the new baud rate. Then switch the baud rate of the ESP32 UART.
+ *
+ * @important The bandwidth of the UART must fit the UBX output at the requested rate (else ESP_ERR_INVALID_ARG),
+ *            f.e. UBX-NAV-PVT at 10Hz = 1000 bytes/sec which needs at least 19200 Bd.
+ * @important mjd_neom8n_init() opens the UART at 9600 Bd: power cycle the GPS device before the next init (the receiver does not save this configuration).
+ */
+esp_err_t mjd_neom8n_set_ubx_mode(mjd_neom8n_config_t* ptr_param_config, const mjd_neom8n_ubx_mode_t* ptr_param_mode) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    const uint8_t nmea_ids[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 }; // GGA GLL GSA GSV RMC VTG
+    uint8_t frame[MY_UBX_TX_BUF_SIZE];
+    size_t len_frame;
+
+    if (ptr_param_mode->baud_rate != 9600 && ptr_param_mode->baud_rate != 19200 && ptr_param_mode->baud_rate != 38400
+            && ptr_param_mode->baud_rate != 57600 && ptr_param_mode->baud_rate != 115200) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid baud rate %u | err %i (%s)", __FUNCTION__, ptr_param_mode->baud_rate, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    uint32_t bytes_per_second = mjd_neom8n_ubx_get_mode_bytes_per_second(ptr_param_mode);
+    if (bytes_per_second > ptr_param_mode->baud_rate / 10 * MY_UART_BANDWIDTH_PERCENT / 100) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. The UBX output (%u bytes/sec) does not fit %u Bd | err %i (%s)", __FUNCTION__, bytes_per_second,
+                ptr_param_mode->baud_rate, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // 1. NMEA off
+    for (uint32_t i = 0; i < ARRAY_SIZE(nmea_ids); i++) {
+        f_retval = mjd_neom8n_set_message_rate(ptr_param_config, MJD_NEOM8N_UBX_CLASS_NMEA, nmea_ids[i], 0);
+        if (f_retval != ESP_OK) {
+            // GOTO
+            goto cleanup;
+        }
+    }
+
+    // 2. UBX-NAV-PVT + UBX-NAV-SAT
+    f_retval = mjd_neom8n_set_message_rate(ptr_param_config, MJD_NEOM8N_UBX_CLASS_NAV, MJD_NEOM8N_UBX_ID_NAV_PVT, 1);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+    f_retval = mjd_neom8n_set_message_rate(ptr_param_config, MJD_NEOM8N_UBX_CLASS_NAV, MJD_NEOM8N_UBX_ID_NAV_SAT, ptr_param_mode->nav_sat_rate);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+
+    // 3. Measurement rate
+    f_retval = mjd_neom8n_set_measurement_rate(ptr_param_config, ptr_param_mode->measurement_period_ms);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+
+    // 4. Port: UBX out only + baud rate. @important No ACK wait: the receiver already answers at the new baud rate.
+    f_retval = mjd_neom8n_ubx_build_cfg_prt_uart(ptr_param_mode->baud_rate, MJD_NEOM8N_UBX_PROTO_MASK_UBX | MJD_NEOM8N_UBX_PROTO_MASK_NMEA,
+            MJD_NEOM8N_UBX_PROTO_MASK_UBX, frame, sizeof(frame), &len_frame);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+    f_retval = _ubx_send(ptr_param_config, frame, len_frame);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+    f_retval = uart_wait_tx_done(ptr_param_config->uart_port, RTOS_DELAY_1SEC);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. uart_wait_tx_done() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    vTaskDelay(RTOS_DELAY_100MILLISEC);
+
+    f_retval = uart_set_baudrate(ptr_param_config->uart_port, ptr_param_mode->baud_rate);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. uart_set_baudrate() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    // Bytes received during the switch are garbage (the parser would count them as skipped anyway)
+    uart_flush_input(ptr_param_config->uart_port);
+
+    ESP_LOGI(TAG, "%s(). UBX binary mode: UBX-NAV-PVT every %u ms, UBX-NAV-SAT rate %u, %u Bd (%u bytes/sec)", __FUNCTION__,
+            ptr_param_mode->measurement_period_ms, ptr_param_mode->nav_sat_rate, ptr_param_mode->baud_rate, bytes_per_second);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+
+/**************************************
+ * DUTY CYCLING SCHEDULER
+ *
+ * The scheduler task steps the state machine of mjd_neom8n_scheduler.c every second and executes its actions on the receiver.
+ *
+ */
+static void _scheduler_power_up(mjd_neom8n_config_t* ptr_param_config, const mjd_neom8n_scheduler_action_t* param_ptr_action) {
+    uint8_t frame[MY_UBX_TX_BUF_SIZE];
+    size_t len_frame;
+
+    mjd_neom8n_power_up(ptr_param_config);
+
+    if (param_ptr_action->is_aiding_requested == false) {
+        // RETURN
+        return;
+    }
+
+    // @doc The UBX-MGA-INI messages are not acknowledged (default UBX-CFG-NAVX5 ackAiding = 0)
+    if (mjd_neom8n_ubx_build_mga_ini_pos_llh(param_ptr_action->aiding_latitude, param_ptr_action->aiding_longitude,
+            param_ptr_action->aiding_altitude_m, MY_SCHEDULER_AIDING_POSITION_ACCURACY_M, frame, sizeof(frame), &len_frame) == ESP_OK) {
+        _ubx_send(ptr_param_config, frame, len_frame);
+    }
+
+    time_t now = time(NULL);
+    if (now >= MY_SCHEDULER_VALID_TIME_MIN
+            && mjd_neom8n_ubx_build_mga_ini_time_utc(now, MY_SCHEDULER_AIDING_TIME_ACCURACY_S, frame, sizeof(frame), &len_frame) == ESP_OK) {
+        _ubx_send(ptr_param_config, frame, len_frame);
+    }
+}
+
+static void _scheduler_power_down(mjd_neom8n_config_t* ptr_param_config, uint32_t param_duration_ms) {
+    uint8_t frame[MY_UBX_TX_BUF_SIZE];
+    size_t len_frame;
+
+    if (mjd_neom8n_ubx_build_rxm_pmreq(param_duration_ms, frame, sizeof(frame), &len_frame) == ESP_OK) {
+        _ubx_send(ptr_param_config, frame, len_frame);
+    }
+}
+
+static esp_err_t _scheduler_set_power_save(mjd_neom8n_config_t* ptr_param_config, bool param_is_power_save, uint32_t param_update_period_ms) {
+    esp_err_t f_retval = ESP_OK;
+    uint8_t frame[MY_UBX_TX_BUF_SIZE];
+    size_t len_frame;
+
+    if (param_is_power_save == true) {
+        f_retval = mjd_neom8n_ubx_build_cfg_pm2(param_update_period_ms, MY_SCHEDULER_SEARCH_PERIOD_MS, frame, sizeof(frame), &len_frame);
+        if (f_retval != ESP_OK) {
+            // GOTO
+            goto cleanup;
+        }
+        f_retval = _ubx_send_and_wait_for_ack(ptr_param_config, frame, len_frame);
+        if (f_retval != ESP_OK) {
+            // GOTO
+            goto cleanup;
+        }
+    }
+
+    f_retval = mjd_neom8n_ubx_build_cfg_rxm(param_is_power_save, frame, sizeof(frame), &len_frame);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+    f_retval = _ubx_send_and_wait_for_ack(ptr_param_config, frame, len_frame);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+static void _neom8n_scheduler_task(void *pvParameters) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    mjd_neom8n_config_t *ptr_config = &_neom8n_scheduler_device_config;
+    mjd_neom8n_scheduler_action_t action;
+
+    while (_neom8n_scheduler_is_stop_requested == false) {
+        MJD_NEOM8N_SERVICE_LOCK();
+        mjd_neom8n_scheduler_step(&_neom8n_scheduler, esp_timer_get_time(), &_neom8n_data, &action);
+        MJD_NEOM8N_SERVICE_UNLOCK();
+
+        switch (action.type) {
+        case MJD_NEOM8N_SCHEDULER_ACTION_POWER_UP:
+            _scheduler_power_up(ptr_config, &action);
+            break;
+        case MJD_NEOM8N_SCHEDULER_ACTION_POWER_DOWN:
+            ESP_LOGI(TAG, "_neom8n_scheduler_task(): fix (TTFF %u ms) => backup mode for %u ms", _neom8n_scheduler.stats.ttff_last_ms,
+                    action.duration_ms);
+            _scheduler_power_down(ptr_config, action.duration_ms);
+            break;
+        case MJD_NEOM8N_SCHEDULER_ACTION_ENABLE_POWER_SAVE:
+            ESP_LOGI(TAG, "_neom8n_scheduler_task(): fix (TTFF %u ms) => power save mode update period %u ms", _neom8n_scheduler.stats.ttff_last_ms,
+                    action.update_period_ms);
+            if (_scheduler_set_power_save(ptr_config, true, action.update_period_ms) != ESP_OK) {
+                ESP_LOGW(TAG, "_neom8n_scheduler_task(): power save mode not enabled (the receiver stays in continuous mode)");
+            }
+            break;
+        case MJD_NEOM8N_SCHEDULER_ACTION_NONE:
+            break;
+        }
+
+        // @doc Instead of vTaskDelay(): mjd_neom8n_scheduler_stop() wakes the task up with a notification
+        ulTaskNotifyTake(pdTRUE, MY_SCHEDULER_STEP_DELAY);
+    }
+
+    // @important Signal the exit outside of the lock, then delete myself
+    xSemaphoreGive(_neom8n_scheduler_exit_semaphore);
+
+    // RTOS Delete service task (void)
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Start the duty cycling scheduler: 1 fix every fix_interval_ms at the lowest power (see mjd_neom8n_scheduler.h).
+ *
+ * @important The monitor task must be running (mjd_neom8n_init()): it decodes the fixes and the ACK's.
+ * @important The last fix of a previous run is kept, so a restart within the ephemeris validity is a hot start.
+ */
+esp_err_t mjd_neom8n_scheduler_start(mjd_neom8n_config_t* ptr_param_config, const mjd_neom8n_scheduler_config_t* ptr_param_scheduler_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (_neom8n_gps_monitor_task_handle == NULL || _neom8n_scheduler_task_handle != NULL) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. The monitor task is not running or the scheduler is already running | err %i (%s)", __FUNCTION__,
+                f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    MJD_NEOM8N_SERVICE_LOCK();
+    mjd_neom8n_scheduler_t previous = _neom8n_scheduler;
+    f_retval = mjd_neom8n_scheduler_init(&_neom8n_scheduler, ptr_param_scheduler_config);
+    if (f_retval == ESP_OK && previous.has_last_fix == true) {
+        _neom8n_scheduler.has_last_fix = true;
+        _neom8n_scheduler.last_fix_us = previous.last_fix_us;
+        _neom8n_scheduler.last_fix_latitude = previous.last_fix_latitude;
+        _neom8n_scheduler.last_fix_longitude = previous.last_fix_longitude;
+        _neom8n_scheduler.last_fix_altitude_m = previous.last_fix_altitude_m;
+    }
+    MJD_NEOM8N_SERVICE_UNLOCK();
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+    _neom8n_scheduler_device_config = *ptr_param_config;
+
+    // SEMAPHORE
+    if (!_neom8n_scheduler_exit_semaphore) {
+        _neom8n_scheduler_exit_semaphore = xSemaphoreCreateBinary();
+        if (!_neom8n_scheduler_exit_semaphore) {
+            f_retval = ESP_ERR_NO_MEM;
+            ESP_LOGE(TAG, "xSemaphoreCreateBinary() err %i (%s)", f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+    }
+    _neom8n_scheduler_is_stop_requested = false;
+
+    ESP_LOGI(TAG, "%s(). fix interval %u ms => mode %i", __FUNCTION__, ptr_param_scheduler_config->fix_interval_ms, _neom8n_scheduler.mode);
+
+    // RTOS Create service task
+    //      @important For stability (RMT + Wifi etc.): always use xTaskCreatePinnedToCore(APP_CPU_NUM) [Opposed to xTaskCreate() which might run the code on PRO_CPU_NUM...]
+    BaseType_t xReturned;
+    xReturned = xTaskCreatePinnedToCore(_neom8n_scheduler_task, "_neom8n_scheduler_task",
+    MJD_NEOM8N_SCHEDULER_TASK_STACK_SIZE, NULL, RTOS_TASK_PRIORITY_NORMAL,
+            (TaskHandle_t * const ) (&_neom8n_scheduler_task_handle), APP_CPU_NUM);
+    if (xReturned != pdPASS) {
+        ESP_LOGE(TAG, "xTaskCreatePinnedToCore(_neom8n_scheduler_task() err %i (%s)", xReturned, "!=pdPASS");
+        _neom8n_scheduler_task_handle = NULL;
+        f_retval = ESP_FAIL;
+        // GOTO
+        goto cleanup;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/**
+ * @brief Stop the duty cycling scheduler and leave the receiver on in continuous mode.
+ *
+ * @doc The statistics and the last fix remain available (mjd_neom8n_scheduler_get_stats()).
+ * @doc It waits until the scheduler task has finished its current action (max. 2 UBX ACK timeouts) and has deleted itself.
+ */
+esp_err_t mjd_neom8n_scheduler_stop(mjd_neom8n_config_t* ptr_param_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (_neom8n_scheduler_task_handle == NULL) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. The scheduler is not running | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // @important Do not vTaskDelete() the task: it might hold _neom8n_service_semaphore (step, ACK polling). Ask it to stop and wait for it.
+    _neom8n_scheduler_is_stop_requested = true;
+    xTaskNotifyGive(_neom8n_scheduler_task_handle);
+    xSemaphoreTake(_neom8n_scheduler_exit_semaphore, RTOS_DELAY_MAX);
+    _neom8n_scheduler_task_handle = NULL;
+
+    MJD_NEOM8N_SERVICE_LOCK();
+    mjd_neom8n_scheduler_mode_t mode = _neom8n_scheduler.mode;
+    _neom8n_scheduler.state = MJD_NEOM8N_SCHEDULER_STATE_STOPPED;
+    MJD_NEOM8N_SERVICE_UNLOCK();
+
+    mjd_neom8n_power_up(ptr_param_config);
+    if (mode == MJD_NEOM8N_SCHEDULER_MODE_POWER_SAVE) {
+        f_retval = _scheduler_set_power_save(ptr_param_config, false, 0);
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_neom8n_scheduler_get_stats(mjd_neom8n_scheduler_stats_t* ptr_param_stats) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    MJD_NEOM8N_SERVICE_LOCK();
+    *ptr_param_stats = _neom8n_scheduler.stats;
+    MJD_NEOM8N_SERVICE_UNLOCK();
+
+    return f_retval;
+}
@@ -0,0 +1,451 @@
+/*
+ * Goto README.md for instructions
+ */
+
+// Component header file(s)
+#include "mjd.h"
+#include "mjd_neom8n.h"
+#include "mjd_neom8n_parser.h"
+
+// Extra includes
+#include <math.h>
+
+/*
+ * Logging
+ */
+static const char TAG[] = "mjd_neom8n_parser";
+
+/*
+ * Parser settings
+ *  @doc A corrupt UBX length field would otherwise swallow up to 64KB of the stream before the checksum fails.
+ *       The largest UBX output message of the NEO-M8N (UBX-NAV-SAT with 72 SV's) is < 1KB.
+ */
+#define MY_UBX_MAX_PAYLOAD_LENGTH (1024)
+#define MY_KNOTS_TO_KMH (1.852f)
+
+/**************************************
+ * PRIVATE.
+ *
+ */
+static inline int _hex_nibble(uint8_t param_char) {
+    if (param_char >= '0' && param_char <= '9') {
+        return param_char - '0';
+    }
+    if (param_char >= 'A' && param_char <= 'F') {
+        return param_char - 'A' + 10;
+    }
+    return -1;
+}
+
+static inline void _ubx_checksum_add(mjd_neom8n_parser_t* param_ptr_parser, uint8_t param_byte) {
+    param_ptr_parser->ubx_ck_a += param_byte;
+    param_ptr_parser->ubx_ck_b += param_ptr_parser->ubx_ck_a;
+}
+
+static inline void _reset_frame(mjd_neom8n_parser_t* param_ptr_parser) {
+    param_ptr_parser->state = MJD_NEOM8N_PARSER_STATE_IDLE;
+    param_ptr_parser->ptr_frame = NULL;
+    param_ptr_parser->frame_length = 0;
+    param_ptr_parser->is_frame_kept = false;
+}
+
+/*
+ * @brief Append a byte to the kept frame.
+ * @important In place (zero-copy) the byte already is at ptr_frame[frame_length]; only a staged frame is copied.
+ */
+static inline void _append(mjd_neom8n_parser_t* param_ptr_parser, uint8_t param_byte) {
+    if (param_ptr_parser->ptr_frame == NULL) {
+        param_ptr_parser->staging[param_ptr_parser->frame_length] = param_byte;
+    }
+    param_ptr_parser->frame_length++;
+}
+
+static inline const uint8_t* _frame(const mjd_neom8n_parser_t* param_ptr_parser) {
+    return (param_ptr_parser->ptr_frame != NULL) ? param_ptr_parser->ptr_frame : param_ptr_parser->staging;
+}
+
+/*
+ * @brief Decode a NMEA sentence "$...*hh" (checksum validated) into the data struct.
+ * @doc minmea_scan() stops each field at ',' or '*' so the sentence is parsed in place (no '\0' required).
+ * @return true when the data struct has been updated.
+ */
+static bool _decode_nmea(mjd_neom8n_parser_t* param_ptr_parser, mjd_neom8n_data_t* param_ptr_data) {
+    const char *ptr_sentence = (const char *) _frame(param_ptr_parser);
+    bool is_updated = false;
+
+    if (param_ptr_parser->frame_length < 7) {
+        return false;
+    }
+
+    // @doc "$GPRMC", "$GNRMC", ... => the talker ID is ignored
+    if (strncmp(ptr_sentence + 3, "RMC,", 4) == 0) {
+        struct minmea_sentence_rmc frame;
+
+        if (minmea_parse_rmc(&frame, ptr_sentence) == true) {
+            //  @doc minmea_tocoord() converts a raw coordinate to a human readable notation floating point value DD.DDD... Returns NaN for "unknown" values.
+            float new_latitude = minmea_tocoord(&frame.latitude);
+            float new_longitude = minmea_tocoord(&frame.longitude);
+            float new_speed = minmea_tofloat(&frame.speed);
+            if (isnan(new_latitude) == false && isnan(new_longitude) == false) {
+                param_ptr_data->latitude = new_latitude;
+                param_ptr_data->longitude = new_longitude;
+            }
+            if (frame.valid == true) {
+                param_ptr_data->fix_counter++;
+            }
+            if (isnan(new_speed) == false) {
+                param_ptr_data->ground_speed_kmh = new_speed * MY_KNOTS_TO_KMH;
+            }
+            is_updated = true;
+        } else {
+            param_ptr_parser->stats.nbr_of_nmea_parse_errors++;
+            ESP_LOGW(TAG, "%s(). minmea_parse_rmc() invalid data format", __FUNCTION__);
+        }
+    } else if (strncmp(ptr_sentence + 3, "GGA,", 4) == 0) {
+        /*
+         * frame.fix_quality = GPS Quality indicator
+         *   0: Fix not valid
+         *   1: GPS fix ***OK***
+         *   2: Differential GPS fix, OmniSTAR VBS
+         *   4: Real-Time Kinematic, fixed integers
+         *   5: Real-Time Kinematic, float integers, OmniSTAR XP/HP or Location RTK
+         *
+         * frame.satellites_tracked = Number of satellites ("SV") in use, range from 00 through to 24+.
+         */
+        struct minmea_sentence_gga frame;
+
+        if (minmea_parse_gga(&frame, ptr_sentence) == true) {
+            float new_altitude = minmea_tofloat(&frame.altitude);
+            param_ptr_data->fix_quality = frame.fix_quality;
+            param_ptr_data->satellites_tracked = frame.satellites_tracked;
+            if (frame.fix_quality > 0) {
+                param_ptr_data->fix_counter++;
+            }
+            if (isnan(new_altitude) == false) {
+                param_ptr_data->altitude_m = new_altitude;
+            }
+            is_updated = true;
+        } else {
+            param_ptr_parser->stats.nbr_of_nmea_parse_errors++;
+            ESP_LOGW(TAG, "%s(). minmea_parse_gga() invalid data format", __FUNCTION__);
+        }
+    }
+
+    return is_updated;
+}
+
+static inline bool _is_ubx_nav_sat(const mjd_neom8n_parser_t* param_ptr_parser) {
+    return (param_ptr_parser->ubx_class == MJD_NEOM8N_UBX_CLASS_NAV && param_ptr_parser->ubx_id == MJD_NEOM8N_UBX_ID_NAV_SAT);
+}
+
+static inline bool _is_ubx_payload_kept(const mjd_neom8n_parser_t* param_ptr_parser) {
+    if (param_ptr_parser->ubx_class == MJD_NEOM8N_UBX_CLASS_NAV && param_ptr_parser->ubx_id == MJD_NEOM8N_UBX_ID_NAV_PVT) {
+        return (param_ptr_parser->ubx_payload_length == MJD_NEOM8N_UBX_NAV_PVT_PAYLOAD_LENGTH);
+    }
+    if (param_ptr_parser->ubx_class == MJD_NEOM8N_UBX_CLASS_ACK) {
+        return (param_ptr_parser->ubx_payload_length == MJD_NEOM8N_UBX_ACK_PAYLOAD_LENGTH);
+    }
+    return false;
+}
+
+/*
+ * @brief Summarize the UBX-NAV-SAT payload byte by byte (the payload is up to 16 + 12 * 255 bytes: it is never buffered).
+ * @doc Per SV block of 12 bytes after the 8 byte header: cno@2 (dBHz), flags@8 (bit3 svUsed).
+ */
+static inline void _nav_sat_add(mjd_neom8n_parser_t* param_ptr_parser, uint8_t param_byte) {
+    if (param_ptr_parser->frame_length < MJD_NEOM8N_UBX_NAV_SAT_HEADER_LENGTH) {
+        return;
+    }
+    uint16_t offset = (param_ptr_parser->frame_length - MJD_NEOM8N_UBX_NAV_SAT_HEADER_LENGTH) % MJD_NEOM8N_UBX_NAV_SAT_BLOCK_LENGTH;
+    if (offset == 2) {
+        param_ptr_parser->nav_sat_cno = param_byte;
+    } else if (offset == 8) {
+        param_ptr_parser->nav_sat_nbr_of_svs++;
+        if ((param_byte & 0x08) != 0) {
+            param_ptr_parser->nav_sat_nbr_of_svs_used++;
+            param_ptr_parser->nav_sat_cno_sum += param_ptr_parser->nav_sat_cno;
+        }
+    }
+}
+
+/*
+ * @brief Decode a UBX frame (checksum validated).
+ * @return true when the data struct has been updated.
+ */
+static bool _decode_ubx(mjd_neom8n_parser_t* param_ptr_parser, mjd_neom8n_data_t* param_ptr_data) {
+    bool is_updated = false;
+
+    if (_is_ubx_nav_sat(param_ptr_parser) == true) {
+        param_ptr_parser->stats.nbr_of_ubx_nav_sat++;
+        param_ptr_data->satellites_visible = param_ptr_parser->nav_sat_nbr_of_svs;
+        param_ptr_data->cno_mean_dbhz =
+                (param_ptr_parser->nav_sat_nbr_of_svs_used > 0) ?
+                        (int) (param_ptr_parser->nav_sat_cno_sum / param_ptr_parser->nav_sat_nbr_of_svs_used) : 0;
+        is_updated = true;
+    } else if (param_ptr_parser->is_frame_kept == false) {
+        // Validated and skipped
+    } else if (param_ptr_parser->ubx_class == MJD_NEOM8N_UBX_CLASS_NAV) {
+        if (mjd_neom8n_ubx_decode_nav_pvt(_frame(param_ptr_parser), param_ptr_parser->frame_length, param_ptr_data) == ESP_OK) {
+            param_ptr_parser->stats.nbr_of_ubx_nav_pvt++;
+            is_updated = true;
+        }
+    } else if (param_ptr_parser->ubx_class == MJD_NEOM8N_UBX_CLASS_ACK) {
+        if (mjd_neom8n_ubx_decode_ack(param_ptr_parser->ubx_id, _frame(param_ptr_parser), param_ptr_parser->frame_length,
+                &param_ptr_parser->last_ack) == ESP_OK) {
+            param_ptr_parser->stats.nbr_of_ubx_acks++;
+        }
+    }
+
+    return is_updated;
+}
+
+/**************************************
+ * PUBLIC.
+ *
+ */
+
+esp_err_t mjd_neom8n_parser_init(mjd_neom8n_parser_t* param_ptr_parser) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_parser == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. param_ptr_parser is NULL | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    memset(param_ptr_parser, 0, sizeof(*param_ptr_parser));
+    _reset_frame(param_ptr_parser);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*
+ * @brief Feed the next chunk of the byte stream of the GPS device.
+ *
+ * @important The chunk is only read during this call: a frame in progress at the end of the chunk is staged in the parser.
+ * @important The parser is not thread safe; the caller owns the data struct (typically under MJD_NEOM8N_SERVICE_LOCK()).
+ *
+ * @return
+ *     - ESP_OK A RMC, GGA, UBX-NAV-PVT or UBX-NAV-SAT frame in this chunk has updated the data struct
+ *     - ESP_ERR_NOT_FOUND No frame in this chunk has updated the data struct
+ *     - ESP_ERR_INVALID_ARG
+ */
+esp_err_t mjd_neom8n_parser_feed(mjd_neom8n_parser_t* param_ptr_parser, const uint8_t* param_ptr_buf, size_t param_len_buf,
+                                 mjd_neom8n_data_t* param_ptr_data) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_parser == NULL || param_ptr_data == NULL || (param_ptr_buf == NULL && param_len_buf > 0)) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid args | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    mjd_neom8n_parser_t *ptr_parser = param_ptr_parser;
+    uint32_t nbr_of_updates = 0;
+
+    ptr_parser->stats.nbr_of_bytes += param_len_buf;
+
+    for (size_t i = 0; i < param_len_buf; i++) {
+        uint8_t c = param_ptr_buf[i];
+
+        switch (ptr_parser->state) {
+        case MJD_NEOM8N_PARSER_STATE_IDLE:
+            if (c == '$') {
+                ptr_parser->state = MJD_NEOM8N_PARSER_STATE_NMEA_BODY;
+                ptr_parser->ptr_frame = &param_ptr_buf[i];
+                ptr_parser->frame_length = 1;
+                ptr_parser->is_frame_kept = true;
+                ptr_parser->nmea_checksum = 0;
+            } else if (c == MJD_NEOM8N_UBX_SYNC_CHAR_1) {
+                ptr_parser->state = MJD_NEOM8N_PARSER_STATE_UBX_SYNC_2;
+            } else {
+                ptr_parser->stats.nbr_of_skipped_bytes++;
+            }
+            break;
+
+        case MJD_NEOM8N_PARSER_STATE_NMEA_BODY:
+            if (c == '*') {
+                _append(ptr_parser, c);
+                ptr_parser->state = MJD_NEOM8N_PARSER_STATE_NMEA_CK_1;
+            } else if (c < 0x20 || c > 0x7E || c == '$') {
+                // Truncated sentence (line break, UBX frame or a new sentence before the checksum): drop it and re-examine this byte
+                ptr_parser->stats.nbr_of_skipped_bytes += ptr_parser->frame_length;
+                _reset_frame(ptr_parser);
+                i--;
+            } else if (ptr_parser->frame_length >= MJD_NEOM8N_NMEA_MAX_LENGTH - 5) {
+                // @doc Room left for "*hh\r\n"
+                ptr_parser->stats.nbr_of_nmea_overflows++;
+                ptr_parser->stats.nbr_of_skipped_bytes += ptr_parser->frame_length + 1;
+                _reset_frame(ptr_parser);
+            } else {
+                ptr_parser->nmea_checksum ^= c;
+                _append(ptr_parser, c);
+            }
+            break;
+
+        case MJD_NEOM8N_PARSER_STATE_NMEA_CK_1:
+        case MJD_NEOM8N_PARSER_STATE_NMEA_CK_2: {
+            int nibble = _hex_nibble(c);
+            if (nibble < 0) {
+                ptr_parser->stats.nbr_of_nmea_checksum_errors++;
+                _reset_frame(ptr_parser);
+                i--;
+                break;
+            }
+            _append(ptr_parser, c);
+            if (ptr_parser->state == MJD_NEOM8N_PARSER_STATE_NMEA_CK_1) {
+                ptr_parser->nmea_checksum_received = (uint8_t) (nibble << 4);
+                ptr_parser->state = MJD_NEOM8N_PARSER_STATE_NMEA_CK_2;
+                break;
+            }
+            ptr_parser->nmea_checksum_received |= (uint8_t) nibble;
+            if (ptr_parser->nmea_checksum_received == ptr_parser->nmea_checksum) {
+                ptr_parser->stats.nbr_of_nmea_sentences++;
+                param_ptr_data->data_received = true;
+                if (_decode_nmea(ptr_parser, param_ptr_data) == true) {
+                    nbr_of_updates++;
+                }
+            } else {
+                ptr_parser->stats.nbr_of_nmea_checksum_errors++;
+            }
+            _reset_frame(ptr_parser);
+            break;
+        }
+
+        case MJD_NEOM8N_PARSER_STATE_UBX_SYNC_2:
+            if (c == MJD_NEOM8N_UBX_SYNC_CHAR_2) {
+                ptr_parser->state = MJD_NEOM8N_PARSER_STATE_UBX_CLASS;
+            } else {
+                // Not a UBX frame: re-examine this byte (it might be a '$' or a sync char 1)
+                ptr_parser->stats.nbr_of_skipped_bytes++;
+                _reset_frame(ptr_parser);
+                i--;
+            }
+            break;
+
+        case MJD_NEOM8N_PARSER_STATE_UBX_CLASS:
+            ptr_parser->ubx_ck_a = 0;
+            ptr_parser->ubx_ck_b = 0;
+            _ubx_checksum_add(ptr_parser, c);
+            ptr_parser->ubx_class = c;
+            ptr_parser->state = MJD_NEOM8N_PARSER_STATE_UBX_ID;
+            break;
+
+        case MJD_NEOM8N_PARSER_STATE_UBX_ID:
+            _ubx_checksum_add(ptr_parser, c);
+            ptr_parser->ubx_id = c;
+            ptr_parser->state = MJD_NEOM8N_PARSER_STATE_UBX_LENGTH_1;
+            break;
+
+        case MJD_NEOM8N_PARSER_STATE_UBX_LENGTH_1:
+            _ubx_checksum_add(ptr_parser, c);
+            ptr_parser->ubx_payload_length = c;
+            ptr_parser->state = MJD_NEOM8N_PARSER_STATE_UBX_LENGTH_2;
+            break;
+
+        case MJD_NEOM8N_PARSER_STATE_UBX_LENGTH_2:
+            _ubx_checksum_add(ptr_parser, c);
+            ptr_parser->ubx_payload_length |= (uint16_t) (c << 8);
+            if (ptr_parser->ubx_payload_length > MY_UBX_MAX_PAYLOAD_LENGTH) {
+                ptr_parser->stats.nbr_of_skipped_bytes += 6;
+                _reset_frame(ptr_parser);
+                break;
+            }
+            // @doc Only the payload of the frames that are decoded as a whole is kept (UBX-NAV-SAT is summarized on the fly)
+            ptr_parser->is_frame_kept = _is_ubx_payload_kept(ptr_parser);
+            ptr_parser->nav_sat_nbr_of_svs = 0;
+            ptr_parser->nav_sat_nbr_of_svs_used = 0;
+            ptr_parser->nav_sat_cno_sum = 0;
+            ptr_parser->frame_length = 0;
+            ptr_parser->ptr_frame = NULL;
+            ptr_parser->state =
+                    (ptr_parser->ubx_payload_length == 0) ? MJD_NEOM8N_PARSER_STATE_UBX_CK_A : MJD_NEOM8N_PARSER_STATE_UBX_PAYLOAD;
+            break;
+
+        case MJD_NEOM8N_PARSER_STATE_UBX_PAYLOAD:
+            _ubx_checksum_add(ptr_parser, c);
+            if (ptr_parser->is_frame_kept == true) {
+                if (ptr_parser->frame_length == 0) {
+                    ptr_parser->ptr_frame = &param_ptr_buf[i];
+                }
+                _append(ptr_parser, c);
+            } else {
+                if (_is_ubx_nav_sat(ptr_parser) == true) {
+                    _nav_sat_add(ptr_parser, c);
+                }
+                ptr_parser->frame_length++;
+            }
+            if (ptr_parser->frame_length == ptr_parser->ubx_payload_length) {
+                ptr_parser->state = MJD_NEOM8N_PARSER_STATE_UBX_CK_A;
+            }
+            break;
+
+        case MJD_NEOM8N_PARSER_STATE_UBX_CK_A:
+            if (c != ptr_parser->ubx_ck_a) {
+                ptr_parser->stats.nbr_of_ubx_checksum_errors++;
+                _reset_frame(ptr_parser);
+                break;
+            }
+            ptr_parser->state = MJD_NEOM8N_PARSER_STATE_UBX_CK_B;
+            break;
+
+        case MJD_NEOM8N_PARSER_STATE_UBX_CK_B:
+            if (c != ptr_parser->ubx_ck_b) {
+                ptr_parser->stats.nbr_of_ubx_checksum_errors++;
+                _reset_frame(ptr_parser);
+                break;
+            }
+            ptr_parser->stats.nbr_of_ubx_frames++;
+            param_ptr_data->data_received = true;
+            if (_decode_ubx(ptr_parser, param_ptr_data) == true) {
+                nbr_of_updates++;
+            }
+            _reset_frame(ptr_parser);
+            break;
+
+        default:
+            _reset_frame(ptr_parser);
+            break;
+        }
+    }
+
+    // Stage the kept frame that straddles the end of this chunk (the chunk is not valid after this call)
+    if (ptr_parser->is_frame_kept == true && ptr_parser->ptr_frame != NULL) {
+        memcpy(ptr_parser->staging, ptr_parser->ptr_frame, ptr_parser->frame_length);
+        ptr_parser->ptr_frame = NULL;
+    }
+
+    if (nbr_of_updates == 0) {
+        f_retval = ESP_ERR_NOT_FOUND;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_neom8n_parser_get_stats(const mjd_neom8n_parser_t* param_ptr_parser, mjd_neom8n_parser_stats_t* param_ptr_stats) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_parser == NULL || param_ptr_stats == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid args | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    *param_ptr_stats = param_ptr_parser->stats;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
@@ -0,0 +1,255 @@
+/*
+ * Goto README.md for instructions
+ */
+
+// Component header file(s)
+#include "mjd.h"
+#include "mjd_neom8n.h"
+#include "mjd_neom8n_scheduler.h"
+
+/*
+ * Logging
+ */
+static const char TAG[] = "mjd_neom8n_scheduler";
+
+/*
+ * Scheduler settings
+ *  @doc The receiver needs ~1 sec to enter backup mode and to wake up again: a shorter sleep is not worth it.
+ */
+#define MY_MIN_SLEEP_MS (1000)
+
+/**************************************
+ * PRIVATE.
+ *
+ */
+static inline bool _is_fresh_fix(const mjd_neom8n_data_t* param_ptr_data, uint32_t param_fix_counter_before) {
+    return (param_ptr_data->fix_counter != param_fix_counter_before && param_ptr_data->fix_quality > 0);
+}
+
+static void _save_last_fix(mjd_neom8n_scheduler_t* param_ptr_scheduler, int64_t param_now_us, const mjd_neom8n_data_t* param_ptr_data) {
+    param_ptr_scheduler->has_last_fix = true;
+    param_ptr_scheduler->last_fix_us = param_now_us;
+    param_ptr_scheduler->last_fix_latitude = param_ptr_data->latitude;
+    param_ptr_scheduler->last_fix_longitude = param_ptr_data->longitude;
+    param_ptr_scheduler->last_fix_altitude_m = param_ptr_data->altitude_m;
+    param_ptr_scheduler->fix_counter_last = param_ptr_data->fix_counter;
+}
+
+/*
+ * @brief Start a new acquisition: wake up the receiver (assisted unless it is a hot start).
+ */
+static void _wakeup(mjd_neom8n_scheduler_t* param_ptr_scheduler, int64_t param_now_us, const mjd_neom8n_data_t* param_ptr_data,
+                    mjd_neom8n_scheduler_action_t* param_ptr_action) {
+    mjd_neom8n_start_type_t start_type = mjd_neom8n_scheduler_estimate_start_type(param_ptr_scheduler, param_now_us);
+
+    param_ptr_scheduler->state = MJD_NEOM8N_SCHEDULER_STATE_ACQUIRING;
+    param_ptr_scheduler->wakeup_us = param_now_us;
+    param_ptr_scheduler->fix_counter_at_wakeup = param_ptr_data->fix_counter;
+    param_ptr_scheduler->stats.nbr_of_wakeups++;
+    param_ptr_scheduler->stats.nbr_of_starts[start_type]++;
+
+    param_ptr_action->type = MJD_NEOM8N_SCHEDULER_ACTION_POWER_UP;
+    // @doc A hot start does not need aiding (the receiver still has the ephemeris); aiding with a stale position would not hurt but costs UART time
+    if (start_type != MJD_NEOM8N_START_TYPE_HOT && param_ptr_scheduler->has_last_fix == true) {
+        param_ptr_action->is_aiding_requested = true;
+        param_ptr_action->aiding_latitude = param_ptr_scheduler->last_fix_latitude;
+        param_ptr_action->aiding_longitude = param_ptr_scheduler->last_fix_longitude;
+        param_ptr_action->aiding_altitude_m = param_ptr_scheduler->last_fix_altitude_m;
+    }
+
+    ESP_LOGD(TAG, "%s(). wakeup #%u start type %i aiding %i", __FUNCTION__, param_ptr_scheduler->stats.nbr_of_wakeups, start_type,
+            param_ptr_action->is_aiding_requested);
+}
+
+/*
+ * @brief Put the receiver in backup mode until the next fix is due (wakeup + fix interval).
+ */
+static void _sleep(mjd_neom8n_scheduler_t* param_ptr_scheduler, int64_t param_now_us, mjd_neom8n_scheduler_action_t* param_ptr_action) {
+    int64_t sleep_until_us = param_ptr_scheduler->wakeup_us + (int64_t) param_ptr_scheduler->config.fix_interval_ms * 1000;
+    if (sleep_until_us < param_now_us + (int64_t) MY_MIN_SLEEP_MS * 1000) {
+        sleep_until_us = param_now_us + (int64_t) MY_MIN_SLEEP_MS * 1000;
+    }
+
+    param_ptr_scheduler->state = MJD_NEOM8N_SCHEDULER_STATE_SLEEPING;
+    param_ptr_scheduler->sleep_until_us = sleep_until_us;
+
+    param_ptr_action->type = MJD_NEOM8N_SCHEDULER_ACTION_POWER_DOWN;
+    param_ptr_action->duration_ms = (uint32_t) ((sleep_until_us - param_now_us) / 1000);
+}
+
+static void _record_ttff(mjd_neom8n_scheduler_stats_t* param_ptr_stats, uint32_t param_ttff_ms) {
+    if (param_ptr_stats->nbr_of_fixes == 0 || param_ttff_ms < param_ptr_stats->ttff_min_ms) {
+        param_ptr_stats->ttff_min_ms = param_ttff_ms;
+    }
+    if (param_ttff_ms > param_ptr_stats->ttff_max_ms) {
+        param_ptr_stats->ttff_max_ms = param_ttff_ms;
+    }
+    param_ptr_stats->ttff_last_ms = param_ttff_ms;
+    param_ptr_stats->ttff_sum_ms += param_ttff_ms;
+    param_ptr_stats->nbr_of_fixes++;
+}
+
+/**************************************
+ * PUBLIC.
+ *
+ */
+esp_err_t mjd_neom8n_scheduler_init(mjd_neom8n_scheduler_t* param_ptr_scheduler, const mjd_neom8n_scheduler_config_t* param_ptr_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_scheduler == NULL || param_ptr_config == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid args | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (param_ptr_config->fix_interval_ms == 0 || param_ptr_config->fix_timeout_ms == 0
+            || param_ptr_config->continuous_max_interval_ms > param_ptr_config->power_save_max_interval_ms) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid config (interval %u timeout %u continuous max %u power save max %u) | err %i (%s)", __FUNCTION__,
+                param_ptr_config->fix_interval_ms, param_ptr_config->fix_timeout_ms, param_ptr_config->continuous_max_interval_ms,
+                param_ptr_config->power_save_max_interval_ms, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    memset(param_ptr_scheduler, 0, sizeof(*param_ptr_scheduler));
+    param_ptr_scheduler->config = *param_ptr_config;
+    param_ptr_scheduler->mode = mjd_neom8n_scheduler_select_mode(param_ptr_config);
+    param_ptr_scheduler->state = MJD_NEOM8N_SCHEDULER_STATE_STOPPED;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*
+ * @brief The power mode that delivers fix_interval_ms at the lowest power.
+ *
+ * @doc Continuous tracking draws ~25mA. The power save mode (ON/OFF operation) draws ~25mA while acquiring and ~10uA..5mA in between,
+ *      but it keeps the RF front end calibrated so it only pays off for intervals of ~10s..2min.
+ *      Backup mode draws ~15uA (RTC + backup RAM) but every wakeup is a (hot) start of 1..5s.
+ */
+mjd_neom8n_scheduler_mode_t mjd_neom8n_scheduler_select_mode(const mjd_neom8n_scheduler_config_t* param_ptr_config) {
+    if (param_ptr_config->fix_interval_ms <= param_ptr_config->continuous_max_interval_ms) {
+        return MJD_NEOM8N_SCHEDULER_MODE_CONTINUOUS;
+    }
+    if (param_ptr_config->fix_interval_ms <= param_ptr_config->power_save_max_interval_ms) {
+        return MJD_NEOM8N_SCHEDULER_MODE_POWER_SAVE;
+    }
+    return MJD_NEOM8N_SCHEDULER_MODE_BACKUP;
+}
+
+/*
+ * @brief Estimate the start type of a wakeup now from the age of the last fix.
+ *
+ * @doc The receiver refreshes its ephemeris while it has a fix, so the age of the last fix = the age of its ephemeris and almanac.
+ */
+mjd_neom8n_start_type_t mjd_neom8n_scheduler_estimate_start_type(const mjd_neom8n_scheduler_t* param_ptr_scheduler, int64_t param_now_us) {
+    if (param_ptr_scheduler->has_last_fix == false) {
+        return MJD_NEOM8N_START_TYPE_COLD;
+    }
+
+    int64_t age_ms = (param_now_us - param_ptr_scheduler->last_fix_us) / 1000;
+    if (age_ms < MJD_NEOM8N_SCHEDULER_EPHEMERIS_VALIDITY_MS) {
+        return MJD_NEOM8N_START_TYPE_HOT;
+    }
+    if (age_ms < MJD_NEOM8N_SCHEDULER_ALMANAC_VALIDITY_MS) {
+        return MJD_NEOM8N_START_TYPE_WARM;
+    }
+    return MJD_NEOM8N_START_TYPE_COLD;
+}
+
+/*
+ * @brief Advance the scheduler to param_now_us and return the action that the driver must execute now.
+ *
+ * @param param_now_us The time in microseconds (esp_timer_get_time()); it never goes backwards.
+ * @param param_ptr_data The latest GPS data (a copy, see mjd_neom8n_read()): a change of fix_counter with fix_quality > 0 = a fresh fix.
+ *
+ * @important Call it at least every second while acquiring: the TTFF resolution = the step period.
+ * @important The first call starts the scheduler (action POWER_UP).
+ */
+esp_err_t mjd_neom8n_scheduler_step(mjd_neom8n_scheduler_t* param_ptr_scheduler, int64_t param_now_us, const mjd_neom8n_data_t* param_ptr_data,
+                                    mjd_neom8n_scheduler_action_t* param_ptr_action) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_scheduler == NULL || param_ptr_data == NULL || param_ptr_action == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid args | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    memset(param_ptr_action, 0, sizeof(*param_ptr_action));
+    param_ptr_action->type = MJD_NEOM8N_SCHEDULER_ACTION_NONE;
+
+    // Time accounting of the state since the previous step (whole ms; the remainder carries over)
+    if (param_ptr_scheduler->state != MJD_NEOM8N_SCHEDULER_STATE_STOPPED && param_now_us > param_ptr_scheduler->last_step_us) {
+        int64_t elapsed_ms = (param_now_us - param_ptr_scheduler->last_step_us) / 1000;
+        if (param_ptr_scheduler->state == MJD_NEOM8N_SCHEDULER_STATE_SLEEPING) {
+            param_ptr_scheduler->stats.time_backup_ms += elapsed_ms;
+        } else {
+            param_ptr_scheduler->stats.time_on_ms += elapsed_ms;
+        }
+        param_ptr_scheduler->last_step_us += elapsed_ms * 1000;
+    }
+
+    switch (param_ptr_scheduler->state) {
+    case MJD_NEOM8N_SCHEDULER_STATE_STOPPED:
+        param_ptr_scheduler->last_step_us = param_now_us;
+        _wakeup(param_ptr_scheduler, param_now_us, param_ptr_data, param_ptr_action);
+        break;
+
+    case MJD_NEOM8N_SCHEDULER_STATE_ACQUIRING:
+        if (_is_fresh_fix(param_ptr_data, param_ptr_scheduler->fix_counter_at_wakeup) == true) {
+            _record_ttff(&param_ptr_scheduler->stats, (uint32_t) ((param_now_us - param_ptr_scheduler->wakeup_us) / 1000));
+            _save_last_fix(param_ptr_scheduler, param_now_us, param_ptr_data);
+
+            if (param_ptr_scheduler->mode == MJD_NEOM8N_SCHEDULER_MODE_CONTINUOUS) {
+                param_ptr_scheduler->state = MJD_NEOM8N_SCHEDULER_STATE_TRACKING;
+            } else if (param_ptr_scheduler->mode == MJD_NEOM8N_SCHEDULER_MODE_POWER_SAVE) {
+                // @doc The power save mode is enabled after the first fix: the receiver must have acquired the satellites to cycle
+                param_ptr_scheduler->state = MJD_NEOM8N_SCHEDULER_STATE_TRACKING;
+                param_ptr_action->type = MJD_NEOM8N_SCHEDULER_ACTION_ENABLE_POWER_SAVE;
+                param_ptr_action->update_period_ms = param_ptr_scheduler->config.fix_interval_ms;
+            } else {
+                _sleep(param_ptr_scheduler, param_now_us, param_ptr_action);
+            }
+            break;
+        }
+        if (param_now_us - param_ptr_scheduler->wakeup_us >= (int64_t) param_ptr_scheduler->config.fix_timeout_ms * 1000) {
+            param_ptr_scheduler->stats.nbr_of_timeouts++;
+            ESP_LOGW(TAG, "%s(). No fix within %u ms (wakeup #%u)", __FUNCTION__, param_ptr_scheduler->config.fix_timeout_ms,
+                    param_ptr_scheduler->stats.nbr_of_wakeups);
+
+            if (param_ptr_scheduler->mode == MJD_NEOM8N_SCHEDULER_MODE_BACKUP) {
+                // @doc No sky view (indoors, tunnel): sleep instead of draining the battery; the next wakeup is a new attempt
+                _sleep(param_ptr_scheduler, param_now_us, param_ptr_action);
+            } else {
+                // The receiver stays on: start a new acquisition window
+                param_ptr_scheduler->wakeup_us = param_now_us;
+                param_ptr_scheduler->fix_counter_at_wakeup = param_ptr_data->fix_counter;
+            }
+        }
+        break;
+
+    case MJD_NEOM8N_SCHEDULER_STATE_TRACKING:
+        if (_is_fresh_fix(param_ptr_data, param_ptr_scheduler->fix_counter_last) == true) {
+            _save_last_fix(param_ptr_scheduler, param_now_us, param_ptr_data);
+        }
+        break;
+
+    case MJD_NEOM8N_SCHEDULER_STATE_SLEEPING:
+        if (param_now_us >= param_ptr_scheduler->sleep_until_us) {
+            _wakeup(param_ptr_scheduler, param_now_us, param_ptr_data, param_ptr_action);
+        }
+        break;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
@@ -0,0 +1,344 @@
+/*
+ * Goto README.md for instructions
+ */
+
+// Component header file(s)
+#include "mjd.h"
+#include "mjd_neom8n.h"
+#include "mjd_neom8n_ubx.h"
+
+// Extra includes
+#include <math.h>
+
+/*
+ * Logging
+ */
+static const char TAG[] = "mjd_neom8n_ubx";
+
+/*
+ * UBX settings
+ *  @doc The UART bandwidth estimate of UBX-NAV-SAT assumes 32 visible SV's (GPS + GLONASS + SBAS on a clear sky).
+ */
+#define MY_NAV_SAT_ESTIMATED_NBR_OF_SVS (32)
+
+/**************************************
+ * PRIVATE.
+ *
+ */
+static inline uint32_t _get_u32_le(const uint8_t* param_ptr_buf) {
+    return (uint32_t) param_ptr_buf[0] | ((uint32_t) param_ptr_buf[1] << 8) | ((uint32_t) param_ptr_buf[2] << 16)
+            | ((uint32_t) param_ptr_buf[3] << 24);
+}
+
+static inline void _put_u16_le(uint8_t* param_ptr_buf, uint16_t param_value) {
+    param_ptr_buf[0] = (uint8_t) (param_value & 0xFF);
+    param_ptr_buf[1] = (uint8_t) (param_value >> 8);
+}
+
+static inline void _put_u32_le(uint8_t* param_ptr_buf, uint32_t param_value) {
+    param_ptr_buf[0] = (uint8_t) (param_value & 0xFF);
+    param_ptr_buf[1] = (uint8_t) ((param_value >> 8) & 0xFF);
+    param_ptr_buf[2] = (uint8_t) ((param_value >> 16) & 0xFF);
+    param_ptr_buf[3] = (uint8_t) (param_value >> 24);
+}
+
+/**************************************
+ * PUBLIC.
+ *
+ */
+
+/*
+ * @brief The 8-Bit Fletcher checksum of a UBX frame, computed over class + id + length + payload (so without the 2 sync chars).
+ */
+void mjd_neom8n_ubx_checksum(const uint8_t* param_ptr_buf, size_t param_len_buf, uint8_t* param_ptr_ck_a, uint8_t* param_ptr_ck_b) {
+    uint8_t ck_a = 0;
+    uint8_t ck_b = 0;
+
+    for (size_t i = 0; i < param_len_buf; i++) {
+        ck_a += param_ptr_buf[i];
+        ck_b += ck_a;
+    }
+
+    *param_ptr_ck_a = ck_a;
+    *param_ptr_ck_b = ck_b;
+}
+
+/*
+ * @brief Build a complete UBX frame (sync chars + header + payload + checksum) in the buffer of the caller.
+ *
+ * @param param_ptr_payload NULL is allowed when param_len_payload = 0 (a poll request).
+ * @param param_ptr_len_frame The frame length = param_len_payload + MJD_NEOM8N_UBX_FRAME_OVERHEAD.
+ */
+esp_err_t mjd_neom8n_ubx_build_frame(uint8_t param_class, uint8_t param_id, const uint8_t* param_ptr_payload, uint16_t param_len_payload,
+                                     uint8_t* param_ptr_buf, size_t param_len_buf, size_t* param_ptr_len_frame) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_buf == NULL || param_ptr_len_frame == NULL || (param_ptr_payload == NULL && param_len_payload > 0)) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid args | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (param_len_buf < (size_t) param_len_payload + MJD_NEOM8N_UBX_FRAME_OVERHEAD) {
+        f_retval = ESP_ERR_INVALID_SIZE;
+        ESP_LOGE(TAG, "%s(). ABORT. Buffer too small (%u bytes) | err %i (%s)", __FUNCTION__, (unsigned int) param_len_buf, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    param_ptr_buf[0] = MJD_NEOM8N_UBX_SYNC_CHAR_1;
+    param_ptr_buf[1] = MJD_NEOM8N_UBX_SYNC_CHAR_2;
+    param_ptr_buf[2] = param_class;
+    param_ptr_buf[3] = param_id;
+    _put_u16_le(&param_ptr_buf[4], param_len_payload);
+    if (param_len_payload > 0) {
+        memmove(&param_ptr_buf[6], param_ptr_payload, param_len_payload);
+    }
+    mjd_neom8n_ubx_checksum(&param_ptr_buf[2], 4 + param_len_payload, &param_ptr_buf[6 + param_len_payload],
+            &param_ptr_buf[7 + param_len_payload]);
+
+    *param_ptr_len_frame = param_len_payload + MJD_NEOM8N_UBX_FRAME_OVERHEAD;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*
+ * @brief UBX-CFG-MSG: set the output rate of a message on the current port (0 = off, N = every N navigation solutions).
+ */
+esp_err_t mjd_neom8n_ubx_build_cfg_msg(uint8_t param_msg_class, uint8_t param_msg_id, uint8_t param_rate, uint8_t* param_ptr_buf,
+                                       size_t param_len_buf, size_t* param_ptr_len_frame) {
+    uint8_t payload[MJD_NEOM8N_UBX_CFG_MSG_PAYLOAD_LENGTH] = { param_msg_class, param_msg_id, param_rate };
+
+    return mjd_neom8n_ubx_build_frame(MJD_NEOM8N_UBX_CLASS_CFG, MJD_NEOM8N_UBX_ID_CFG_MSG, payload, sizeof(payload), param_ptr_buf,
+            param_len_buf, param_ptr_len_frame);
+}
+
+/*
+ * @brief UBX-CFG-RATE: the measurement period in ms, 1 navigation solution per measurement, aligned to GPS time.
+ */
+esp_err_t mjd_neom8n_ubx_build_cfg_rate(uint16_t param_measurement_period_ms, uint8_t* param_ptr_buf, size_t param_len_buf,
+                                        size_t* param_ptr_len_frame) {
+    uint8_t payload[MJD_NEOM8N_UBX_CFG_RATE_PAYLOAD_LENGTH];
+
+    _put_u16_le(&payload[0], param_measurement_period_ms); // measRate
+    _put_u16_le(&payload[2], 1); // navRate
+    _put_u16_le(&payload[4], 1); // timeRef 1=GPS time
+
+    return mjd_neom8n_ubx_build_frame(MJD_NEOM8N_UBX_CLASS_CFG, MJD_NEOM8N_UBX_ID_CFG_RATE, payload, sizeof(payload), param_ptr_buf,
+            param_len_buf, param_ptr_len_frame);
+}
+
+/*
+ * @brief UBX-CFG-PRT for the receiver UART1: 8N1, the baud rate and the input/output protocols.
+ *
+ * @important The receiver switches to the new baud rate right after this message (the ACK may be lost).
+ */
+esp_err_t mjd_neom8n_ubx_build_cfg_prt_uart(uint32_t param_baud_rate, uint16_t param_in_proto_mask, uint16_t param_out_proto_mask,
+                                            uint8_t* param_ptr_buf, size_t param_len_buf, size_t* param_ptr_len_frame) {
+    uint8_t payload[MJD_NEOM8N_UBX_CFG_PRT_PAYLOAD_LENGTH] = { 0 };
+
+    payload[0] = MJD_NEOM8N_UBX_PORT_ID_UART1; // portID
+    _put_u32_le(&payload[4], 0x000008D0); // mode: 8 data bits, no parity, 1 stop bit
+    _put_u32_le(&payload[8], param_baud_rate);
+    _put_u16_le(&payload[12], param_in_proto_mask);
+    _put_u16_le(&payload[14], param_out_proto_mask);
+
+    return mjd_neom8n_ubx_build_frame(MJD_NEOM8N_UBX_CLASS_CFG, MJD_NEOM8N_UBX_ID_CFG_PRT, payload, sizeof(payload), param_ptr_buf,
+            param_len_buf, param_ptr_len_frame);
+}
+
+/*
+ * @brief UBX-RXM-PMREQ: put the receiver in backup mode for the duration (0 = infinite).
+ *
+ * @doc The receiver keeps its RTC, ephemeris and almanac (V_BCKP) so it can do a hot start when it wakes up.
+ *      It also wakes up when it receives any data on its UART (see mjd_neom8n_power_up()).
+ */
+esp_err_t mjd_neom8n_ubx_build_rxm_pmreq(uint32_t param_duration_ms, uint8_t* param_ptr_buf, size_t param_len_buf, size_t* param_ptr_len_frame) {
+    uint8_t payload[MJD_NEOM8N_UBX_RXM_PMREQ_PAYLOAD_LENGTH];
+
+    _put_u32_le(&payload[0], param_duration_ms);
+    _put_u32_le(&payload[4], 0x00000002); // flags: backup
+
+    return mjd_neom8n_ubx_build_frame(MJD_NEOM8N_UBX_CLASS_RXM, MJD_NEOM8N_UBX_ID_RXM_PMREQ, payload, sizeof(payload), param_ptr_buf,
+            param_len_buf, param_ptr_len_frame);
+}
+
+/*
+ * @brief UBX-CFG-RXM: low power mode 0 = continuous, 1 = power save mode (as configured with UBX-CFG-PM2).
+ */
+esp_err_t mjd_neom8n_ubx_build_cfg_rxm(bool param_is_power_save, uint8_t* param_ptr_buf, size_t param_len_buf, size_t* param_ptr_len_frame) {
+    uint8_t payload[MJD_NEOM8N_UBX_CFG_RXM_PAYLOAD_LENGTH] = { 0x08, (param_is_power_save == true) ? 0x01 : 0x00 };
+
+    return mjd_neom8n_ubx_build_frame(MJD_NEOM8N_UBX_CLASS_CFG, MJD_NEOM8N_UBX_ID_CFG_RXM, payload, sizeof(payload), param_ptr_buf,
+            param_len_buf, param_ptr_len_frame);
+}
+
+/*
+ * @brief UBX-CFG-PM2 (version 1): the power save mode.
+ *
+ * @doc Update periods < 10s use cyclic tracking, >= 10s use ON/OFF operation (the receiver sleeps between fixes).
+ * @doc Ephemeris updates are enabled so the receiver keeps doing hot starts.
+ */
+esp_err_t mjd_neom8n_ubx_build_cfg_pm2(uint32_t param_update_period_ms, uint32_t param_search_period_ms, uint8_t* param_ptr_buf,
+                                       size_t param_len_buf, size_t* param_ptr_len_frame) {
+    uint8_t payload[MJD_NEOM8N_UBX_CFG_PM2_PAYLOAD_LENGTH] = { 0 };
+    uint32_t flags = 0;
+
+    flags |= (1 << 12); // updateEPH
+    if (param_update_period_ms < 10000) {
+        flags |= (1 << 17); // mode: cyclic tracking
+    }
+
+    payload[0] = 0x01; // version
+    _put_u32_le(&payload[4], flags);
+    _put_u32_le(&payload[8], param_update_period_ms);
+    _put_u32_le(&payload[12], param_search_period_ms);
+
+    return mjd_neom8n_ubx_build_frame(MJD_NEOM8N_UBX_CLASS_CFG, MJD_NEOM8N_UBX_ID_CFG_PM2, payload, sizeof(payload), param_ptr_buf,
+            param_len_buf, param_ptr_len_frame);
+}
+
+/*
+ * @brief UBX-MGA-INI-POS_LLH: aid the receiver with an approximate position (f.e. the last fix).
+ */
+esp_err_t mjd_neom8n_ubx_build_mga_ini_pos_llh(float param_latitude, float param_longitude, float param_altitude_m,
+                                               uint32_t param_accuracy_m, uint8_t* param_ptr_buf, size_t param_len_buf,
+                                               size_t* param_ptr_len_frame) {
+    uint8_t payload[MJD_NEOM8N_UBX_MGA_INI_POS_LLH_PAYLOAD_LENGTH] = { 0 };
+
+    payload[0] = 0x01; // type POS_LLH
+    _put_u32_le(&payload[4], (uint32_t) (int32_t) lround(param_latitude * 1e7));
+    _put_u32_le(&payload[8], (uint32_t) (int32_t) lround(param_longitude * 1e7));
+    _put_u32_le(&payload[12], (uint32_t) (int32_t) lround((isnan(param_altitude_m) ? 0.0f : param_altitude_m) * 100.0f));
+    _put_u32_le(&payload[16], param_accuracy_m * 100);
+
+    return mjd_neom8n_ubx_build_frame(MJD_NEOM8N_UBX_CLASS_MGA, MJD_NEOM8N_UBX_ID_MGA_INI, payload, sizeof(payload), param_ptr_buf,
+            param_len_buf, param_ptr_len_frame);
+}
+
+/*
+ * @brief UBX-MGA-INI-TIME_UTC: aid the receiver with the approximate UTC time (f.e. the system time after SNTP), applied on receipt.
+ */
+esp_err_t mjd_neom8n_ubx_build_mga_ini_time_utc(time_t param_utc_time, uint16_t param_accuracy_s, uint8_t* param_ptr_buf,
+                                                size_t param_len_buf, size_t* param_ptr_len_frame) {
+    uint8_t payload[MJD_NEOM8N_UBX_MGA_INI_TIME_UTC_PAYLOAD_LENGTH] = { 0 };
+    struct tm tm_utc;
+
+    gmtime_r(&param_utc_time, &tm_utc);
+
+    payload[0] = 0x10; // type TIME_UTC
+    payload[2] = 0x00; // ref: on receipt of the message
+    payload[3] = 0x80; // leapSecs: unknown (-128)
+    _put_u16_le(&payload[4], (uint16_t) (tm_utc.tm_year + 1900));
+    payload[6] = (uint8_t) (tm_utc.tm_mon + 1);
+    payload[7] = (uint8_t) tm_utc.tm_mday;
+    payload[8] = (uint8_t) tm_utc.tm_hour;
+    payload[9] = (uint8_t) tm_utc.tm_min;
+    payload[10] = (uint8_t) tm_utc.tm_sec;
+    _put_u16_le(&payload[16], param_accuracy_s);
+
+    return mjd_neom8n_ubx_build_frame(MJD_NEOM8N_UBX_CLASS_MGA, MJD_NEOM8N_UBX_ID_MGA_INI, payload, sizeof(payload), param_ptr_buf,
+            param_len_buf, param_ptr_len_frame);
+}
+
+/*
+ * @brief Decode the payload of UBX-NAV-PVT (Navigation Position Velocity Time Solution) into the data struct.
+ *
+ * @doc Little endian. Offsets: fixType@20 flags@21 (bit0 gnssFixOK bit1 diffSoln) numSV@23 lon@24 lat@28 (1e-7 deg)
+ *      hMSL@36 (mm) hAcc@40 (mm) gSpeed@60 (mm/s).
+ * @doc fix_quality is mapped to the GGA semantics so the app sees the same values for NMEA and UBX:
+ *      fixType 2D/3D/GNSS+DR with gnssFixOK => 1 (2 with a differential solution), fixType DR only => 6, else 0.
+ * @important The position is only updated when gnssFixOK (a receiver without a fix still reports its last/seeded position).
+ */
+esp_err_t mjd_neom8n_ubx_decode_nav_pvt(const uint8_t* param_ptr_payload, size_t param_len_payload, mjd_neom8n_data_t* param_ptr_data) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_len_payload != MJD_NEOM8N_UBX_NAV_PVT_PAYLOAD_LENGTH) {
+        f_retval = ESP_ERR_INVALID_SIZE;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid payload length %u | err %i (%s)", __FUNCTION__, (unsigned int) param_len_payload, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    uint8_t fix_type = param_ptr_payload[20];
+    uint8_t flags = param_ptr_payload[21];
+    bool is_gnss_fix_ok = (flags & 0x01) != 0;
+    bool is_diff_soln = (flags & 0x02) != 0;
+
+    if (fix_type == 1) {
+        param_ptr_data->fix_quality = 6;
+    } else if ((fix_type >= 2 && fix_type <= 4) && is_gnss_fix_ok == true) {
+        param_ptr_data->fix_quality = (is_diff_soln == true) ? 2 : 1;
+    } else {
+        param_ptr_data->fix_quality = 0;
+    }
+    param_ptr_data->satellites_tracked = param_ptr_payload[23];
+
+    if (is_gnss_fix_ok == true) {
+        param_ptr_data->fix_counter++;
+        param_ptr_data->longitude = (float) ((int32_t) _get_u32_le(&param_ptr_payload[24]) / 1e7);
+        param_ptr_data->latitude = (float) ((int32_t) _get_u32_le(&param_ptr_payload[28]) / 1e7);
+        param_ptr_data->altitude_m = (float) ((int32_t) _get_u32_le(&param_ptr_payload[36]) / 1000.0);
+        param_ptr_data->horizontal_accuracy_m = (float) (_get_u32_le(&param_ptr_payload[40]) / 1000.0);
+        param_ptr_data->ground_speed_kmh = (float) ((int32_t) _get_u32_le(&param_ptr_payload[60]) * 0.0036);
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*
+ * @brief Decode the payload of UBX-ACK-ACK / UBX-ACK-NAK (the class + id of the CFG message that was (not) accepted).
+ */
+esp_err_t mjd_neom8n_ubx_decode_ack(uint8_t param_id, const uint8_t* param_ptr_payload, size_t param_len_payload,
+                                    mjd_neom8n_ubx_ack_t* param_ptr_ack) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_len_payload != MJD_NEOM8N_UBX_ACK_PAYLOAD_LENGTH
+            || (param_id != MJD_NEOM8N_UBX_ID_ACK_ACK && param_id != MJD_NEOM8N_UBX_ID_ACK_NAK)) {
+        f_retval = ESP_ERR_INVALID_SIZE;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid id 0x%02X or payload length %u | err %i (%s)", __FUNCTION__, param_id,
+                (unsigned int) param_len_payload, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    param_ptr_ack->msg_class = param_ptr_payload[0];
+    param_ptr_ack->msg_id = param_ptr_payload[1];
+    param_ptr_ack->is_ack = (param_id == MJD_NEOM8N_UBX_ID_ACK_ACK);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*
+ * @brief The UART bytes per second that the receiver outputs in this UBX binary mode.
+ *
+ * @doc UBX-NAV-PVT 100 bytes per measurement + UBX-NAV-SAT (16 + 12 bytes per SV) every nav_sat_rate measurements.
+ */
+uint32_t mjd_neom8n_ubx_get_mode_bytes_per_second(const mjd_neom8n_ubx_mode_t* param_ptr_mode) {
+    uint32_t bytes_per_second;
+
+    if (param_ptr_mode->measurement_period_ms == 0) {
+        return UINT32_MAX;
+    }
+
+    bytes_per_second = ((MJD_NEOM8N_UBX_NAV_PVT_PAYLOAD_LENGTH + MJD_NEOM8N_UBX_FRAME_OVERHEAD) * 1000)
+            / param_ptr_mode->measurement_period_ms;
+    if (param_ptr_mode->nav_sat_rate > 0) {
+        bytes_per_second += ((MJD_NEOM8N_UBX_NAV_SAT_HEADER_LENGTH + MJD_NEOM8N_UBX_FRAME_OVERHEAD
+                + MY_NAV_SAT_ESTIMATED_NBR_OF_SVS * MJD_NEOM8N_UBX_NAV_SAT_BLOCK_LENGTH) * 1000)
+                / (param_ptr_mode->measurement_period_ms * param_ptr_mode->nav_sat_rate);
+    }
+
+    return bytes_per_second;
+}
@@ -0,0 +1,155 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+#ifndef __MJD_NVS_H__
+#define __MJD_NVS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Includes: system, own
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "nvs.h"
+
+#include "sdkconfig.h"
+
+/**********
+ * KEYS & VALUES
+ *
+ * @doc The keys follow the NVS rules: max MJD_NVS_KEY_MAX_LEN characters. A string value is max MJD_NVS_STR_MAX_LEN characters
+ *      so the cache entries have a fixed size (1 NVS entry + 1 data entry of 32 bytes on flash).
+ * @doc A float is stored as a u32 with the same bits.
+ */
+#define MJD_NVS_KEY_MAX_LEN (15)
+#define MJD_NVS_STR_MAX_LEN (31)
+
+typedef enum {
+    MJD_NVS_TYPE_NONE = 0,
+    MJD_NVS_TYPE_U8,
+    MJD_NVS_TYPE_I32,
+    MJD_NVS_TYPE_U32,
+    MJD_NVS_TYPE_I64,
+    MJD_NVS_TYPE_FLOAT,
+    MJD_NVS_TYPE_STR,
+} mjd_nvs_type_t;
+
+typedef struct {
+    char key[MJD_NVS_KEY_MAX_LEN + 1];
+    mjd_nvs_type_t type;
+    bool is_present;        /*!< false = the key does not exist in NVS (a cached miss, or erased) */
+    bool is_dirty;          /*!< The RAM value differs from flash: written at the next commit */
+    bool is_erase_pending;  /*!< Dirty because of mjd_nvs_erase_key() */
+    union {
+        uint8_t u8;
+        int32_t i32;
+        uint32_t u32;
+        int64_t i64;
+        float f;
+        char str[MJD_NVS_STR_MAX_LEN + 1];
+    } value;
+} mjd_nvs_entry_t;
+
+/**********
+ * CACHE
+ *
+ * @doc A write-back cache of CONFIG_MJD_NVS_MAX_KEYS keys of 1 namespace. A set only changes RAM; the dirty keys are written to
+ *      NVS together, followed by 1 nvs_commit(), when:
+ *      - commit_interval_ms passed since the first dirty set (a one-shot esp_timer, and checked at each set), or
+ *      - max_dirty_keys keys are dirty, or
+ *      - mjd_nvs_commit() is called, e.g. right before esp_deep_sleep_start().
+ *      A key that is set 100x between 2 commits costs 1 flash write, and a set to the current value costs nothing.
+ *
+ * @doc A get is served from RAM. A key that is not cached yet is read from NVS once (and a missing key is cached as missing).
+ *      The getters copy into caller memory: nothing is allocated after mjd_nvs_init().
+ *
+ * @important The values that are dirty are lost at a reset or a deep sleep: call mjd_nvs_commit() before esp_deep_sleep_start().
+ * @important The time-based commit runs in the esp_timer task: size CONFIG_ESP_TIMER_TASK_STACK_SIZE for an NVS write (>= 3584).
+ * @important Call nvs_flash_init() first.
+ * @important Thread safe (mutex). Do not open the same namespace with nvs_open() elsewhere: the cache would not see those writes.
+ */
+typedef struct {
+    const char * partition;         /*!< NULL = NVS_DEFAULT_PART_NAME */
+    const char * namespace_name;    /*!< Max 15 characters */
+    uint32_t commit_interval_ms;    /*!< Max time a dirty key stays in RAM. 0 = no time-based commits */
+    uint32_t max_dirty_keys;        /*!< Commit when this many keys are dirty: 1..CONFIG_MJD_NVS_MAX_KEYS */
+} mjd_nvs_config_t;
+
+#define MJD_NVS_CONFIG_DEFAULT() { \
+    .partition = NULL, \
+    .namespace_name = "mjd", \
+    .commit_interval_ms = 60000, \
+    .max_dirty_keys = 8, \
+}
+
+/*
+ * @doc nbr_of_flash_writes counts the nvs_set_*() and nvs_erase_key() calls: each one writes at least 1 NVS entry of 32 bytes
+ *      (a string 2). Compare it with nbr_of_sets for the wear that the cache saved.
+ */
+typedef struct {
+    uint32_t nbr_of_sets;           /*!< mjd_nvs_set_*() calls */
+    uint32_t nbr_of_unchanged;      /*!< Sets to the current value (no flash write needed) */
+    uint32_t nbr_of_coalesced;      /*!< Sets of a key that was already dirty (the previous value never reached flash) */
+    uint32_t nbr_of_gets;
+    uint32_t nbr_of_flash_reads;    /*!< Keys that were not cached yet (a get, or the first set to compare the value) */
+    uint32_t nbr_of_evictions;      /*!< Clean keys that were dropped from the cache to make room */
+    uint32_t nbr_of_flash_writes;   /*!< nvs_set_*() + nvs_erase_key() calls */
+    uint32_t nbr_of_commits;        /*!< nvs_commit() calls */
+    uint32_t nbr_of_write_errors;   /*!< Failed flash writes (the key stays dirty) */
+    uint32_t nbr_of_dirty;          /*!< Dirty keys right now */
+} mjd_nvs_stats_t;
+
+typedef struct {
+    mjd_nvs_config_t config;
+    char partition[16];
+    char namespace_name[16];
+    nvs_handle handle;
+    mjd_nvs_entry_t entries[CONFIG_MJD_NVS_MAX_KEYS];
+    uint32_t nbr_of_dirty;
+    int64_t first_dirty_us;         /*!< esp_timer_get_time() of the first set since the last commit */
+    uint32_t next_eviction_idx;     /*!< Round robin over the clean entries */
+    esp_timer_handle_t timer;
+    bool is_closing;                /*!< mjd_nvs_deinit() started: the timer callback does nothing */
+    uint32_t nbr_of_running_callbacks;
+    mjd_nvs_stats_t stats;
+    SemaphoreHandle_t mutex;
+} mjd_nvs_t;
+
+esp_err_t mjd_nvs_init(mjd_nvs_t* param_ptr_nvs, const mjd_nvs_config_t* param_ptr_config);
+esp_err_t mjd_nvs_deinit(mjd_nvs_t* param_ptr_nvs);
+
+esp_err_t mjd_nvs_set_u8(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, uint8_t param_value);
+esp_err_t mjd_nvs_set_i32(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, int32_t param_value);
+esp_err_t mjd_nvs_set_u32(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, uint32_t param_value);
+esp_err_t mjd_nvs_set_i64(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, int64_t param_value);
+esp_err_t mjd_nvs_set_float(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, float param_value);
+esp_err_t mjd_nvs_set_str(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, const char * param_ptr_value);
+
+esp_err_t mjd_nvs_get_u8(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, uint8_t * param_ptr_value);
+esp_err_t mjd_nvs_get_i32(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, int32_t * param_ptr_value);
+esp_err_t mjd_nvs_get_u32(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, uint32_t * param_ptr_value);
+esp_err_t mjd_nvs_get_i64(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, int64_t * param_ptr_value);
+esp_err_t mjd_nvs_get_float(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, float * param_ptr_value);
+esp_err_t mjd_nvs_get_str(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, char * param_ptr_value, size_t param_size);
+
+esp_err_t mjd_nvs_erase_key(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key);
+esp_err_t mjd_nvs_commit(mjd_nvs_t* param_ptr_nvs);
+esp_err_t mjd_nvs_commit_if_due(mjd_nvs_t* param_ptr_nvs);
+esp_err_t mjd_nvs_get_stats(mjd_nvs_t* param_ptr_nvs, mjd_nvs_stats_t* param_ptr_stats);
+void mjd_nvs_log_stats(mjd_nvs_t* param_ptr_nvs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_NVS_H__ */
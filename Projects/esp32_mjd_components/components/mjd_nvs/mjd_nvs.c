@@ -0,0 +1,670 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+
+// Component header file(s)
+#include "mjd.h"
+#include "mjd_nvs.h"
+
+/**********
+ * Logging
+ */
+static const char TAG[] = "mjd_nvs";
+
+#define _LOCK(ptr_nvs)   xSemaphoreTake((ptr_nvs)->mutex, portMAX_DELAY)
+#define _UNLOCK(ptr_nvs) xSemaphoreGive((ptr_nvs)->mutex)
+
+/**********
+ * PRIVATE: ENTRIES
+ */
+static bool _is_valid_key(const char * param_ptr_key) {
+    return param_ptr_key != NULL && param_ptr_key[0] != '\0' && strlen(param_ptr_key) <= MJD_NVS_KEY_MAX_LEN;
+}
+
+static mjd_nvs_entry_t * _find_entry(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key) {
+    for (uint32_t idx = 0; idx < CONFIG_MJD_NVS_MAX_KEYS; idx++) {
+        mjd_nvs_entry_t *ptr_entry = &param_ptr_nvs->entries[idx];
+        if (ptr_entry->key[0] != '\0' && strcmp(ptr_entry->key, param_ptr_key) == 0) {
+            return ptr_entry;
+        }
+    }
+    return NULL;
+}
+
+static bool _value_equals(const mjd_nvs_entry_t* param_ptr_entry, mjd_nvs_type_t param_type, const void * param_ptr_value) {
+    if (param_ptr_entry->is_present == false || param_ptr_entry->type != param_type) {
+        return false;
+    }
+    switch (param_type) {
+    case MJD_NVS_TYPE_U8:
+        return param_ptr_entry->value.u8 == *(const uint8_t *) param_ptr_value;
+    case MJD_NVS_TYPE_I32:
+        return param_ptr_entry->value.i32 == *(const int32_t *) param_ptr_value;
+    case MJD_NVS_TYPE_U32:
+    case MJD_NVS_TYPE_FLOAT: // The bits (so a NaN equals the same NaN)
+        return param_ptr_entry->value.u32 == *(const uint32_t *) param_ptr_value;
+    case MJD_NVS_TYPE_I64:
+        return param_ptr_entry->value.i64 == *(const int64_t *) param_ptr_value;
+    case MJD_NVS_TYPE_STR:
+        return strcmp(param_ptr_entry->value.str, (const char *) param_ptr_value) == 0;
+    default:
+        return false;
+    }
+}
+
+static esp_err_t _read_entry(mjd_nvs_t* param_ptr_nvs, mjd_nvs_entry_t* param_ptr_entry, mjd_nvs_type_t param_type) {
+    esp_err_t f_retval = ESP_OK;
+    size_t len = sizeof(param_ptr_entry->value.str);
+
+    ++param_ptr_nvs->stats.nbr_of_flash_reads;
+
+    switch (param_type) {
+    case MJD_NVS_TYPE_U8:
+        f_retval = nvs_get_u8(param_ptr_nvs->handle, param_ptr_entry->key, &param_ptr_entry->value.u8);
+        break;
+    case MJD_NVS_TYPE_I32:
+        f_retval = nvs_get_i32(param_ptr_nvs->handle, param_ptr_entry->key, &param_ptr_entry->value.i32);
+        break;
+    case MJD_NVS_TYPE_U32:
+    case MJD_NVS_TYPE_FLOAT:
+        f_retval = nvs_get_u32(param_ptr_nvs->handle, param_ptr_entry->key, &param_ptr_entry->value.u32);
+        break;
+    case MJD_NVS_TYPE_I64:
+        f_retval = nvs_get_i64(param_ptr_nvs->handle, param_ptr_entry->key, &param_ptr_entry->value.i64);
+        break;
+    case MJD_NVS_TYPE_STR:
+        f_retval = nvs_get_str(param_ptr_nvs->handle, param_ptr_entry->key, param_ptr_entry->value.str, &len);
+        break;
+    default:
+        f_retval = ESP_ERR_INVALID_ARG;
+        break;
+    }
+
+    param_ptr_entry->type = param_type;
+    param_ptr_entry->is_present = (f_retval == ESP_OK);
+    if (f_retval == ESP_ERR_NVS_NOT_FOUND) {
+        f_retval = ESP_OK; // A cached miss
+    }
+    return f_retval;
+}
+
+static esp_err_t _write_entry(mjd_nvs_t* param_ptr_nvs, mjd_nvs_entry_t* param_ptr_entry) {
+    esp_err_t f_retval = ESP_OK;
+
+    ++param_ptr_nvs->stats.nbr_of_flash_writes;
+
+    if (param_ptr_entry->is_erase_pending == true) {
+        f_retval = nvs_erase_key(param_ptr_nvs->handle, param_ptr_entry->key);
+        if (f_retval == ESP_ERR_NVS_NOT_FOUND) {
+            f_retval = ESP_OK;
+        }
+        return f_retval;
+    }
+
+    switch (param_ptr_entry->type) {
+    case MJD_NVS_TYPE_U8:
+        f_retval = nvs_set_u8(param_ptr_nvs->handle, param_ptr_entry->key, param_ptr_entry->value.u8);
+        break;
+    case MJD_NVS_TYPE_I32:
+        f_retval = nvs_set_i32(param_ptr_nvs->handle, param_ptr_entry->key, param_ptr_entry->value.i32);
+        break;
+    case MJD_NVS_TYPE_U32:
+    case MJD_NVS_TYPE_FLOAT:
+        f_retval = nvs_set_u32(param_ptr_nvs->handle, param_ptr_entry->key, param_ptr_entry->value.u32);
+        break;
+    case MJD_NVS_TYPE_I64:
+        f_retval = nvs_set_i64(param_ptr_nvs->handle, param_ptr_entry->key, param_ptr_entry->value.i64);
+        break;
+    case MJD_NVS_TYPE_STR:
+        f_retval = nvs_set_str(param_ptr_nvs->handle, param_ptr_entry->key, param_ptr_entry->value.str);
+        break;
+    default:
+        f_retval = ESP_ERR_INVALID_STATE;
+        break;
+    }
+    return f_retval;
+}
+
+/**********
+ * PRIVATE: COMMITS
+ */
+static void _arm_timer(mjd_nvs_t* param_ptr_nvs) {
+    if (param_ptr_nvs->timer == NULL) {
+        return;
+    }
+    esp_timer_stop(param_ptr_nvs->timer); // ESP_ERR_INVALID_STATE when it was not armed
+    esp_timer_start_once(param_ptr_nvs->timer, (uint64_t) param_ptr_nvs->config.commit_interval_ms * 1000);
+}
+
+static void _disarm_timer(mjd_nvs_t* param_ptr_nvs) {
+    if (param_ptr_nvs->timer != NULL) {
+        esp_timer_stop(param_ptr_nvs->timer);
+    }
+}
+
+/*
+ * @doc All dirty keys, then 1 nvs_commit(). A key that fails stays dirty for the next commit; the first error is returned.
+ */
+static esp_err_t _commit(mjd_nvs_t* param_ptr_nvs) {
+    esp_err_t f_retval = ESP_OK;
+    uint32_t nbr_of_written = 0;
+
+    if (param_ptr_nvs->nbr_of_dirty == 0) {
+        return ESP_OK;
+    }
+
+    for (uint32_t idx = 0; idx < CONFIG_MJD_NVS_MAX_KEYS; idx++) {
+        mjd_nvs_entry_t *ptr_entry = &param_ptr_nvs->entries[idx];
+        if (ptr_entry->is_dirty == false) {
+            continue;
+        }
+        esp_err_t write_retval = _write_entry(param_ptr_nvs, ptr_entry);
+        if (write_retval != ESP_OK) {
+            ++param_ptr_nvs->stats.nbr_of_write_errors;
+            ESP_LOGE(TAG, "%s(). key %s (kept dirty) | err %i (%s)", __FUNCTION__, ptr_entry->key, write_retval,
+                    esp_err_to_name(write_retval));
+            if (f_retval == ESP_OK) {
+                f_retval = write_retval;
+            }
+            continue;
+        }
+        ptr_entry->is_dirty = false;
+        ptr_entry->is_erase_pending = false;
+        --param_ptr_nvs->nbr_of_dirty;
+        ++nbr_of_written;
+    }
+
+    if (nbr_of_written > 0) {
+        ++param_ptr_nvs->stats.nbr_of_commits;
+        esp_err_t commit_retval = nvs_commit(param_ptr_nvs->handle);
+        if (commit_retval != ESP_OK) {
+            ESP_LOGE(TAG, "%s(). nvs_commit() | err %i (%s)", __FUNCTION__, commit_retval, esp_err_to_name(commit_retval));
+            if (f_retval == ESP_OK) {
+                f_retval = commit_retval;
+            }
+        }
+    }
+
+    // The keys that failed get a new interval
+    if (param_ptr_nvs->nbr_of_dirty > 0) {
+        param_ptr_nvs->first_dirty_us = esp_timer_get_time();
+        _arm_timer(param_ptr_nvs);
+    } else {
+        _disarm_timer(param_ptr_nvs);
+    }
+
+    return f_retval;
+}
+
+static esp_err_t _commit_if_due(mjd_nvs_t* param_ptr_nvs) {
+    if (param_ptr_nvs->nbr_of_dirty == 0 || param_ptr_nvs->config.commit_interval_ms == 0) {
+        return ESP_OK;
+    }
+    if (esp_timer_get_time() - param_ptr_nvs->first_dirty_us < (int64_t) param_ptr_nvs->config.commit_interval_ms * 1000) {
+        return ESP_OK;
+    }
+    return _commit(param_ptr_nvs);
+}
+
+/*
+ * @important mjd_nvs_deinit() waits until nbr_of_running_callbacks is 0 before it takes the mutex (and deletes it).
+ */
+static void _timer_callback(void *arg) {
+    mjd_nvs_t *ptr_nvs = (mjd_nvs_t *) arg;
+
+    __atomic_add_fetch(&ptr_nvs->nbr_of_running_callbacks, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ptr_nvs->is_closing, __ATOMIC_SEQ_CST) == false) {
+        _LOCK(ptr_nvs);
+        _commit_if_due(ptr_nvs);
+        _UNLOCK(ptr_nvs);
+    }
+    __atomic_sub_fetch(&ptr_nvs->nbr_of_running_callbacks, 1, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * @doc The entry of the key: cached, or a free (or evicted) entry that is loaded from NVS.
+ *      When all entries are dirty they are committed first.
+ */
+static esp_err_t _get_entry(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, mjd_nvs_type_t param_type,
+                            mjd_nvs_entry_t** param_ptr_ptr_entry) {
+    esp_err_t f_retval = ESP_OK;
+    mjd_nvs_entry_t *ptr_entry = _find_entry(param_ptr_nvs, param_ptr_key);
+
+    if (ptr_entry != NULL) {
+        // A cached miss is per type (NVS looks up a key with its type): read again for another type
+        if (ptr_entry->is_present == false && ptr_entry->is_dirty == false && ptr_entry->type != param_type) {
+            f_retval = _read_entry(param_ptr_nvs, ptr_entry, param_type);
+        }
+        *param_ptr_ptr_entry = ptr_entry;
+        return f_retval;
+    }
+
+    for (uint32_t idx = 0; ptr_entry == NULL && idx < CONFIG_MJD_NVS_MAX_KEYS; idx++) {
+        if (param_ptr_nvs->entries[idx].key[0] == '\0') {
+            ptr_entry = &param_ptr_nvs->entries[idx];
+        }
+    }
+    if (ptr_entry == NULL && param_ptr_nvs->nbr_of_dirty == CONFIG_MJD_NVS_MAX_KEYS) {
+        _commit(param_ptr_nvs);
+    }
+    for (uint32_t nbr = 0; ptr_entry == NULL && nbr < CONFIG_MJD_NVS_MAX_KEYS; nbr++) {
+        uint32_t idx = param_ptr_nvs->next_eviction_idx;
+        param_ptr_nvs->next_eviction_idx = (idx + 1) % CONFIG_MJD_NVS_MAX_KEYS;
+        if (param_ptr_nvs->entries[idx].is_dirty == false) {
+            ptr_entry = &param_ptr_nvs->entries[idx];
+            ++param_ptr_nvs->stats.nbr_of_evictions;
+        }
+    }
+    if (ptr_entry == NULL) {
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "%s(). ABORT. All %u entries are dirty and the commit failed | err %i (%s)", __FUNCTION__,
+                CONFIG_MJD_NVS_MAX_KEYS, f_retval, esp_err_to_name(f_retval));
+        return f_retval;
+    }
+
+    memset(ptr_entry, 0, sizeof(*ptr_entry));
+    strcpy(ptr_entry->key, param_ptr_key);
+    if (param_type != MJD_NVS_TYPE_NONE) {
+        f_retval = _read_entry(param_ptr_nvs, ptr_entry, param_type);
+        if (f_retval != ESP_OK) {
+            ESP_LOGE(TAG, "%s(). _read_entry() key %s | err %i (%s)", __FUNCTION__, param_ptr_key, f_retval, esp_err_to_name(f_retval));
+            ptr_entry->key[0] = '\0';
+            return f_retval;
+        }
+    }
+
+    *param_ptr_ptr_entry = ptr_entry;
+    return f_retval;
+}
+
+static void _mark_dirty(mjd_nvs_t* param_ptr_nvs, mjd_nvs_entry_t* param_ptr_entry) {
+    if (param_ptr_entry->is_dirty == true) {
+        ++param_ptr_nvs->stats.nbr_of_coalesced;
+        return;
+    }
+    param_ptr_entry->is_dirty = true;
+    if (param_ptr_nvs->nbr_of_dirty++ == 0) {
+        param_ptr_nvs->first_dirty_us = esp_timer_get_time();
+        _arm_timer(param_ptr_nvs);
+    }
+}
+
+static esp_err_t _set(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, mjd_nvs_type_t param_type, const void * param_ptr_value,
+                      size_t param_size) {
+    esp_err_t f_retval = ESP_OK;
+    mjd_nvs_entry_t *ptr_entry = NULL;
+
+    if (_is_valid_key(param_ptr_key) == false) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid key (1..%u characters) | err %i (%s)", __FUNCTION__, MJD_NVS_KEY_MAX_LEN, f_retval,
+                esp_err_to_name(f_retval));
+        return f_retval;
+    }
+
+    _LOCK(param_ptr_nvs);
+
+    ++param_ptr_nvs->stats.nbr_of_sets;
+
+    f_retval = _get_entry(param_ptr_nvs, param_ptr_key, param_type, &ptr_entry);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+
+    if (_value_equals(ptr_entry, param_type, param_ptr_value) == true) {
+        ++param_ptr_nvs->stats.nbr_of_unchanged;
+    } else {
+        // A set of another type replaces the key (like nvs_set_*())
+        ptr_entry->type = param_type;
+        ptr_entry->is_present = true;
+        ptr_entry->is_erase_pending = false;
+        memcpy(&ptr_entry->value, param_ptr_value, param_size);
+        _mark_dirty(param_ptr_nvs, ptr_entry);
+    }
+
+    if (param_ptr_nvs->nbr_of_dirty >= param_ptr_nvs->config.max_dirty_keys) {
+        f_retval = _commit(param_ptr_nvs);
+    } else {
+        f_retval = _commit_if_due(param_ptr_nvs);
+    }
+    if (f_retval != ESP_OK) {
+        // The value is in the cache: the write is retried at the next commit
+        ESP_LOGW(TAG, "%s(). The commit failed (the dirty keys are kept) | err %i (%s)", __FUNCTION__, f_retval,
+                esp_err_to_name(f_retval));
+        f_retval = ESP_OK;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    _UNLOCK(param_ptr_nvs);
+
+    return f_retval;
+}
+
+static esp_err_t _get(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, mjd_nvs_type_t param_type, void * param_ptr_value,
+                      size_t param_size) {
+    esp_err_t f_retval = ESP_OK;
+    mjd_nvs_entry_t *ptr_entry = NULL;
+
+    if (_is_valid_key(param_ptr_key) == false || param_ptr_value == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    _LOCK(param_ptr_nvs);
+
+    ++param_ptr_nvs->stats.nbr_of_gets;
+
+    f_retval = _get_entry(param_ptr_nvs, param_ptr_key, param_type, &ptr_entry);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+    if (ptr_entry->is_present == false) {
+        f_retval = ESP_ERR_NVS_NOT_FOUND;
+        // GOTO
+        goto cleanup;
+    }
+    if (ptr_entry->type != param_type) {
+        f_retval = ESP_ERR_NVS_TYPE_MISMATCH;
+        ESP_LOGE(TAG, "%s(). ABORT. key %s is type %u, not %u | err %i (%s)", __FUNCTION__, param_ptr_key, ptr_entry->type, param_type,
+                f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    if (param_type == MJD_NVS_TYPE_STR) {
+        if (strlen(ptr_entry->value.str) + 1 > param_size) {
+            f_retval = ESP_ERR_NVS_INVALID_LENGTH;
+            // GOTO
+            goto cleanup;
+        }
+        strcpy((char *) param_ptr_value, ptr_entry->value.str);
+    } else {
+        memcpy(param_ptr_value, &ptr_entry->value, param_size);
+    }
+
+    // LABEL
+    cleanup: ;
+
+    _UNLOCK(param_ptr_nvs);
+
+    return f_retval;
+}
+
+/**********
+ * PUBLIC
+ */
+
+/*
+ * @brief Open the namespace. The keys are loaded lazily (at the first get or set).
+ */
+esp_err_t mjd_nvs_init(mjd_nvs_t* param_ptr_nvs, const mjd_nvs_config_t* param_ptr_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    const char *ptr_partition;
+
+    if (param_ptr_nvs == NULL || param_ptr_config == NULL || param_ptr_config->namespace_name == NULL
+            || strlen(param_ptr_config->namespace_name) >= sizeof(param_ptr_nvs->namespace_name)
+            || param_ptr_config->max_dirty_keys == 0 || param_ptr_config->max_dirty_keys > CONFIG_MJD_NVS_MAX_KEYS) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid config (namespace 1..15 characters, max_dirty_keys 1..%u) | err %i (%s)", __FUNCTION__,
+                CONFIG_MJD_NVS_MAX_KEYS, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    ptr_partition = (param_ptr_config->partition != NULL) ? param_ptr_config->partition : NVS_DEFAULT_PART_NAME;
+    if (strlen(ptr_partition) >= sizeof(param_ptr_nvs->partition)) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. The partition label is longer than 15 characters | err %i (%s)", __FUNCTION__, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    memset(param_ptr_nvs, 0, sizeof(*param_ptr_nvs));
+    param_ptr_nvs->config = *param_ptr_config;
+    strcpy(param_ptr_nvs->partition, ptr_partition);
+    strcpy(param_ptr_nvs->namespace_name, param_ptr_config->namespace_name);
+    param_ptr_nvs->config.partition = param_ptr_nvs->partition;
+    param_ptr_nvs->config.namespace_name = param_ptr_nvs->namespace_name;
+
+    param_ptr_nvs->mutex = xSemaphoreCreateMutex();
+    if (param_ptr_nvs->mutex == NULL) {
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "%s(). ABORT. xSemaphoreCreateMutex() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    f_retval = nvs_open_from_partition(param_ptr_nvs->partition, param_ptr_nvs->namespace_name, NVS_READWRITE, &param_ptr_nvs->handle);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. nvs_open_from_partition() %s/%s | err %i (%s)", __FUNCTION__, param_ptr_nvs->partition,
+                param_ptr_nvs->namespace_name, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    if (param_ptr_config->commit_interval_ms > 0) {
+        const esp_timer_create_args_t timer_args =
+            { .callback = &_timer_callback, .arg = param_ptr_nvs, .dispatch_method = ESP_TIMER_TASK, .name = "mjd_nvs_commit" };
+
+        f_retval = esp_timer_create(&timer_args, &param_ptr_nvs->timer);
+        if (f_retval != ESP_OK) {
+            ESP_LOGE(TAG, "%s(). ABORT. esp_timer_create() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+            nvs_close(param_ptr_nvs->handle);
+            // GOTO
+            goto cleanup;
+        }
+    }
+
+    ESP_LOGI(TAG, "%s(). %s/%s: %u keys, commit every %u millisec or at %u dirty keys", __FUNCTION__, param_ptr_nvs->partition,
+            param_ptr_nvs->namespace_name, CONFIG_MJD_NVS_MAX_KEYS, param_ptr_config->commit_interval_ms,
+            param_ptr_config->max_dirty_keys);
+
+    // LABEL
+    cleanup: ;
+
+    if (f_retval != ESP_OK && param_ptr_nvs != NULL && param_ptr_nvs->mutex != NULL) {
+        vSemaphoreDelete(param_ptr_nvs->mutex);
+        param_ptr_nvs->mutex = NULL;
+    }
+
+    return f_retval;
+}
+
+/*
+ * @brief Commit the dirty keys, then close the namespace.
+ *
+ * @important No other task may use the cache anymore. The time-based commit stops first: a timer callback that is running (e.g.
+ *            waiting for the mutex) finishes before the mutex is taken, and the final commit runs in the task of the caller.
+ */
+esp_err_t mjd_nvs_deinit(mjd_nvs_t* param_ptr_nvs) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_nvs->timer != NULL) {
+        __atomic_store_n(&param_ptr_nvs->is_closing, true, __ATOMIC_SEQ_CST);
+        esp_timer_stop(param_ptr_nvs->timer); // ESP_ERR_INVALID_STATE when it was not armed
+        while (__atomic_load_n(&param_ptr_nvs->nbr_of_running_callbacks, __ATOMIC_SEQ_CST) > 0) {
+            vTaskDelay(1);
+        }
+        esp_timer_delete(param_ptr_nvs->timer);
+        param_ptr_nvs->timer = NULL;
+    }
+
+    _LOCK(param_ptr_nvs);
+    f_retval = _commit(param_ptr_nvs);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). _commit() (%u dirty keys are lost) | err %i (%s)", __FUNCTION__, param_ptr_nvs->nbr_of_dirty, f_retval,
+                esp_err_to_name(f_retval));
+    }
+    nvs_close(param_ptr_nvs->handle);
+    _UNLOCK(param_ptr_nvs);
+
+    vSemaphoreDelete(param_ptr_nvs->mutex);
+    param_ptr_nvs->mutex = NULL;
+
+    return f_retval;
+}
+
+esp_err_t mjd_nvs_set_u8(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, uint8_t param_value) {
+    return _set(param_ptr_nvs, param_ptr_key, MJD_NVS_TYPE_U8, &param_value, sizeof(param_value));
+}
+
+esp_err_t mjd_nvs_set_i32(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, int32_t param_value) {
+    return _set(param_ptr_nvs, param_ptr_key, MJD_NVS_TYPE_I32, &param_value, sizeof(param_value));
+}
+
+esp_err_t mjd_nvs_set_u32(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, uint32_t param_value) {
+    return _set(param_ptr_nvs, param_ptr_key, MJD_NVS_TYPE_U32, &param_value, sizeof(param_value));
+}
+
+esp_err_t mjd_nvs_set_i64(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, int64_t param_value) {
+    return _set(param_ptr_nvs, param_ptr_key, MJD_NVS_TYPE_I64, &param_value, sizeof(param_value));
+}
+
+esp_err_t mjd_nvs_set_float(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, float param_value) {
+    return _set(param_ptr_nvs, param_ptr_key, MJD_NVS_TYPE_FLOAT, &param_value, sizeof(param_value));
+}
+
+/*
+ * @return ESP_ERR_NVS_VALUE_TOO_LONG when the string is longer than MJD_NVS_STR_MAX_LEN characters
+ */
+esp_err_t mjd_nvs_set_str(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, const char * param_ptr_value) {
+    if (param_ptr_value == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t len = strlen(param_ptr_value);
+    if (len > MJD_NVS_STR_MAX_LEN) {
+        ESP_LOGE(TAG, "%s(). ABORT. key %s: the value is longer than %u characters | err %i (%s)", __FUNCTION__,
+                (param_ptr_key != NULL) ? param_ptr_key : "", MJD_NVS_STR_MAX_LEN, ESP_ERR_NVS_VALUE_TOO_LONG,
+                esp_err_to_name(ESP_ERR_NVS_VALUE_TOO_LONG));
+        return ESP_ERR_NVS_VALUE_TOO_LONG;
+    }
+    return _set(param_ptr_nvs, param_ptr_key, MJD_NVS_TYPE_STR, param_ptr_value, len + 1);
+}
+
+/*
+ * @return ESP_ERR_NVS_NOT_FOUND when the key does not exist, ESP_ERR_NVS_TYPE_MISMATCH when it was set with another type
+ */
+esp_err_t mjd_nvs_get_u8(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, uint8_t * param_ptr_value) {
+    return _get(param_ptr_nvs, param_ptr_key, MJD_NVS_TYPE_U8, param_ptr_value, sizeof(*param_ptr_value));
+}
+
+esp_err_t mjd_nvs_get_i32(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, int32_t * param_ptr_value) {
+    return _get(param_ptr_nvs, param_ptr_key, MJD_NVS_TYPE_I32, param_ptr_value, sizeof(*param_ptr_value));
+}
+
+esp_err_t mjd_nvs_get_u32(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, uint32_t * param_ptr_value) {
+    return _get(param_ptr_nvs, param_ptr_key, MJD_NVS_TYPE_U32, param_ptr_value, sizeof(*param_ptr_value));
+}
+
+esp_err_t mjd_nvs_get_i64(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, int64_t * param_ptr_value) {
+    return _get(param_ptr_nvs, param_ptr_key, MJD_NVS_TYPE_I64, param_ptr_value, sizeof(*param_ptr_value));
+}
+
+esp_err_t mjd_nvs_get_float(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, float * param_ptr_value) {
+    return _get(param_ptr_nvs, param_ptr_key, MJD_NVS_TYPE_FLOAT, param_ptr_value, sizeof(*param_ptr_value));
+}
+
+/*
+ * @return ESP_ERR_NVS_INVALID_LENGTH when param_size is too small for the string and its terminating 0
+ */
+esp_err_t mjd_nvs_get_str(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key, char * param_ptr_value, size_t param_size) {
+    return _get(param_ptr_nvs, param_ptr_key, MJD_NVS_TYPE_STR, param_ptr_value, param_size);
+}
+
+/*
+ * @doc Like a set: the key is erased from flash at the next commit.
+ */
+esp_err_t mjd_nvs_erase_key(mjd_nvs_t* param_ptr_nvs, const char * param_ptr_key) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    mjd_nvs_entry_t *ptr_entry = NULL;
+
+    if (_is_valid_key(param_ptr_key) == false) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    _LOCK(param_ptr_nvs);
+
+    f_retval = _get_entry(param_ptr_nvs, param_ptr_key, MJD_NVS_TYPE_NONE, &ptr_entry);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+    // A new entry (type NONE) is not known to be missing in flash
+    if (ptr_entry->is_present == false && ptr_entry->type != MJD_NVS_TYPE_NONE) {
+        // GOTO
+        goto cleanup;
+    }
+    ptr_entry->type = MJD_NVS_TYPE_NONE;
+    ptr_entry->is_present = false;
+    ptr_entry->is_erase_pending = true;
+    _mark_dirty(param_ptr_nvs, ptr_entry);
+
+    if (param_ptr_nvs->nbr_of_dirty >= param_ptr_nvs->config.max_dirty_keys) {
+        f_retval = _commit(param_ptr_nvs);
+    }
+
+    // LABEL
+    cleanup: ;
+
+    _UNLOCK(param_ptr_nvs);
+
+    return f_retval;
+}
+
+/*
+ * @brief Write all dirty keys and commit them. Call it before esp_deep_sleep_start() and esp_restart().
+ */
+esp_err_t mjd_nvs_commit(mjd_nvs_t* param_ptr_nvs) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    _LOCK(param_ptr_nvs);
+    f_retval = _commit(param_ptr_nvs);
+    _UNLOCK(param_ptr_nvs);
+
+    return f_retval;
+}
+
+/*
+ * @brief Commit when the oldest dirty key waited commit_interval_ms. The esp_timer does this; call it from a main loop when
+ *        the timer task must not write flash.
+ */
+esp_err_t mjd_nvs_commit_if_due(mjd_nvs_t* param_ptr_nvs) {
+    esp_err_t f_retval = ESP_OK;
+
+    _LOCK(param_ptr_nvs);
+    f_retval = _commit_if_due(param_ptr_nvs);
+    _UNLOCK(param_ptr_nvs);
+
+    return f_retval;
+}
+
+esp_err_t mjd_nvs_get_stats(mjd_nvs_t* param_ptr_nvs, mjd_nvs_stats_t* param_ptr_stats) {
+    _LOCK(param_ptr_nvs);
+    *param_ptr_stats = param_ptr_nvs->stats;
+    param_ptr_stats->nbr_of_dirty = param_ptr_nvs->nbr_of_dirty;
+    _UNLOCK(param_ptr_nvs);
+
+    return ESP_OK;
+}
+
+void mjd_nvs_log_stats(mjd_nvs_t* param_ptr_nvs) {
+    mjd_nvs_stats_t stats;
+
+    mjd_nvs_get_stats(param_ptr_nvs, &stats);
+
+    ESP_LOGI(TAG, "%s/%s: sets %u (unchanged %u coalesced %u) gets %u | flash reads %u writes %u commits %u errors %u | dirty %u",
+            param_ptr_nvs->partition, param_ptr_nvs->namespace_name, stats.nbr_of_sets, stats.nbr_of_unchanged, stats.nbr_of_coalesced,
+            stats.nbr_of_gets, stats.nbr_of_flash_reads, stats.nbr_of_flash_writes, stats.nbr_of_commits, stats.nbr_of_write_errors,
+            stats.nbr_of_dirty);
+}
@@ -0,0 +1,351 @@
+/*
+ * Component: fixed-block memory pools and bump arenas on caller-provided storage.
+ *
+ * @doc No function in this file calls malloc() or free().
+ *
+ */
+
+// Component header file(s)
+#include "mjd.h"
+#include "mjd_pool.h"
+
+#include "linux_poison.h"
+
+/**********
+ * Logging
+ */
+static const char TAG[] = "mjd_pool";
+
+/*
+ * @important Each pool and each arena has its own spinlock: tasks using different pools never contend. No logging inside a section.
+ */
+#define _LOCK(ptr_object)   portENTER_CRITICAL(&(ptr_object)->spinlock)
+#define _UNLOCK(ptr_object) portEXIT_CRITICAL(&(ptr_object)->spinlock)
+
+/**********
+ * PRIVATE: POISONING
+ *
+ * @doc A free block is [pointer to the next free block][POISON_FREE ... POISON_FREE].
+ */
+#ifdef CONFIG_MJD_POOL_DEBUG_POISON
+static void _poison_check_free_block(const mjd_pool_t* param_ptr_pool, const uint8_t * param_ptr_block) {
+    for (size_t idx = sizeof(void *); idx < param_ptr_pool->block_size; idx++) {
+        if (param_ptr_block[idx] != POISON_FREE) {
+            ESP_LOGE(TAG, "%s(). Pool %s: block %p was modified after free (offset %u: 0x%02X != 0x%02X)", __FUNCTION__,
+                    param_ptr_pool->name, param_ptr_block, idx, param_ptr_block[idx], POISON_FREE);
+            return;
+        }
+    }
+}
+
+/*
+ * @doc O(free blocks): only compiled in the debug builds.
+ */
+static bool _is_in_free_list(const mjd_pool_t* param_ptr_pool, const void * param_ptr_block) {
+    for (const void *ptr = param_ptr_pool->ptr_free_list; ptr != NULL; ptr = *(void * const *) ptr) {
+        if (ptr == param_ptr_block) {
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+/**********
+ * FIXED-BLOCK POOL
+ */
+esp_err_t mjd_pool_init(mjd_pool_t* param_ptr_pool, const char * param_ptr_name, void * param_ptr_storage, size_t param_block_size,
+                        uint32_t param_nbr_of_blocks) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_pool == NULL || param_ptr_storage == NULL || param_block_size == 0 || param_nbr_of_blocks == 0) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param (NULL or 0) | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (((uintptr_t) param_ptr_storage % MJD_POOL_ALIGNMENT) != 0) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. The storage is not aligned to %u bytes (use MJD_POOL_DEFINE_STORAGE()) | err %i (%s)",
+                __FUNCTION__, MJD_POOL_ALIGNMENT, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    memset(param_ptr_pool, 0, sizeof(*param_ptr_pool));
+    param_ptr_pool->name = (param_ptr_name != NULL) ? param_ptr_name : "unnamed";
+    param_ptr_pool->ptr_storage = param_ptr_storage;
+    param_ptr_pool->block_size = MJD_POOL_BLOCK_SIZE(param_block_size);
+    param_ptr_pool->nbr_of_blocks = param_nbr_of_blocks;
+    param_ptr_pool->stats.nbr_of_blocks = param_nbr_of_blocks;
+    vPortCPUInitializeMutex(&param_ptr_pool->spinlock);
+
+    // Chain all blocks in address order (the first alloc returns the first block)
+    uint8_t *ptr_block = param_ptr_pool->ptr_storage;
+    for (uint32_t idx = 0; idx < param_nbr_of_blocks; idx++, ptr_block += param_ptr_pool->block_size) {
+#ifdef CONFIG_MJD_POOL_DEBUG_POISON
+        memset(ptr_block, POISON_FREE, param_ptr_pool->block_size);
+#endif
+        *(void **) ptr_block = (idx + 1 < param_nbr_of_blocks) ? (ptr_block + param_ptr_pool->block_size) : NULL;
+    }
+    param_ptr_pool->ptr_free_list = param_ptr_pool->ptr_storage;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*
+ * @return NULL when the pool is exhausted (no logging: the caller decides; the failure is counted in the stats).
+ */
+void * mjd_pool_alloc(mjd_pool_t* param_ptr_pool) {
+    _LOCK(param_ptr_pool);
+    void *ptr_block = param_ptr_pool->ptr_free_list;
+    if (ptr_block != NULL) {
+        param_ptr_pool->ptr_free_list = *(void **) ptr_block;
+    }
+#ifdef CONFIG_MJD_POOL_STATS_ENABLED
+    if (ptr_block != NULL) {
+        ++param_ptr_pool->stats.nbr_of_allocs;
+        if (++param_ptr_pool->stats.nbr_in_use > param_ptr_pool->stats.high_water_mark) {
+            param_ptr_pool->stats.high_water_mark = param_ptr_pool->stats.nbr_in_use;
+        }
+    } else {
+        ++param_ptr_pool->stats.nbr_of_failed_allocs;
+    }
+#endif
+    _UNLOCK(param_ptr_pool);
+
+#ifdef CONFIG_MJD_POOL_DEBUG_POISON
+    if (ptr_block != NULL) {
+        _poison_check_free_block(param_ptr_pool, ptr_block);
+        memset(ptr_block, POISON_INUSE, param_ptr_pool->block_size);
+    }
+#endif
+
+    return ptr_block;
+}
+
+bool mjd_pool_owns(const mjd_pool_t* param_ptr_pool, const void * param_ptr) {
+    const uint8_t *ptr = param_ptr;
+    const uint8_t *ptr_end = param_ptr_pool->ptr_storage + param_ptr_pool->block_size * param_ptr_pool->nbr_of_blocks;
+
+    return ptr >= param_ptr_pool->ptr_storage && ptr < ptr_end
+            && ((size_t) (ptr - param_ptr_pool->ptr_storage) % param_ptr_pool->block_size) == 0;
+}
+
+/*
+ * @doc mjd_pool_free(pool, NULL) is a no-op, like free(NULL).
+ */
+esp_err_t mjd_pool_free(mjd_pool_t* param_ptr_pool, void * param_ptr_block) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_block == NULL) {
+        // GOTO
+        goto cleanup;
+    }
+    if (!mjd_pool_owns(param_ptr_pool, param_ptr_block)) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Pool %s: %p is not a block of this pool | err %i (%s)", __FUNCTION__, param_ptr_pool->name,
+                param_ptr_block, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    bool is_double_free = false;
+
+    // @doc The double free check, the poisoning and the push are one critical section: a concurrent free of the same block cannot
+    //      pass the check in between (the memset is block_size bytes: small in practice).
+    _LOCK(param_ptr_pool);
+#ifdef CONFIG_MJD_POOL_DEBUG_POISON
+    is_double_free = _is_in_free_list(param_ptr_pool, param_ptr_block);
+    if (!is_double_free) {
+        memset(param_ptr_block, POISON_FREE, param_ptr_pool->block_size);
+    }
+#endif
+    if (!is_double_free) {
+        *(void **) param_ptr_block = param_ptr_pool->ptr_free_list;
+        param_ptr_pool->ptr_free_list = param_ptr_block;
+#ifdef CONFIG_MJD_POOL_STATS_ENABLED
+        --param_ptr_pool->stats.nbr_in_use;
+#endif
+    }
+    _UNLOCK(param_ptr_pool);
+
+    if (is_double_free) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. Pool %s: block %p is already free (double free) | err %i (%s)", __FUNCTION__, param_ptr_pool->name,
+                param_ptr_block, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_pool_get_stats(mjd_pool_t* param_ptr_pool, mjd_pool_stats_t* param_ptr_stats) {
+    esp_err_t f_retval = ESP_OK;
+
+#ifndef CONFIG_MJD_POOL_STATS_ENABLED
+    f_retval = ESP_ERR_NOT_SUPPORTED;
+    // GOTO
+    goto cleanup;
+#endif
+
+    if (param_ptr_pool == NULL || param_ptr_stats == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param (NULL) | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    _LOCK(param_ptr_pool);
+    *param_ptr_stats = param_ptr_pool->stats;
+    _UNLOCK(param_ptr_pool);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+void mjd_pool_log_stats(mjd_pool_t* param_ptr_pool) {
+    mjd_pool_stats_t stats;
+
+    if (mjd_pool_get_stats(param_ptr_pool, &stats) != ESP_OK) {
+        return;
+    }
+    ESP_LOGI(TAG, "pool %-12s | block %4u bytes | in use %4u of %4u | high-water %4u | allocs %8u | failed %6u", param_ptr_pool->name,
+            param_ptr_pool->block_size, stats.nbr_in_use, stats.nbr_of_blocks, stats.high_water_mark, stats.nbr_of_allocs,
+            stats.nbr_of_failed_allocs);
+}
+
+/**********
+ * BUMP ARENA
+ */
+esp_err_t mjd_arena_init(mjd_arena_t* param_ptr_arena, const char * param_ptr_name, void * param_ptr_storage, size_t param_size) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_arena == NULL || param_ptr_storage == NULL || param_size == 0) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param (NULL or 0) | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (((uintptr_t) param_ptr_storage % MJD_POOL_ALIGNMENT) != 0) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. The storage is not aligned to %u bytes (use MJD_ARENA_DEFINE_STORAGE()) | err %i (%s)",
+                __FUNCTION__, MJD_POOL_ALIGNMENT, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    memset(param_ptr_arena, 0, sizeof(*param_ptr_arena));
+    param_ptr_arena->name = (param_ptr_name != NULL) ? param_ptr_name : "unnamed";
+    param_ptr_arena->ptr_storage = param_ptr_storage;
+    param_ptr_arena->size = param_size;
+    param_ptr_arena->stats.size = param_size;
+    vPortCPUInitializeMutex(&param_ptr_arena->spinlock);
+#ifdef CONFIG_MJD_POOL_DEBUG_POISON
+    memset(param_ptr_arena->ptr_storage, POISON_FREE, param_ptr_arena->size);
+#endif
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*
+ * @return NULL when the arena is full, or for a size of 0.
+ */
+void * mjd_arena_alloc(mjd_arena_t* param_ptr_arena, size_t param_size) {
+    void *ptr_allocated = NULL;
+
+    if (param_size == 0) {
+        return NULL;
+    }
+    const size_t aligned_size = (param_size + MJD_POOL_ALIGNMENT - 1) & ~((size_t) MJD_POOL_ALIGNMENT - 1);
+
+    _LOCK(param_ptr_arena);
+    if (aligned_size >= param_size && aligned_size <= param_ptr_arena->size - param_ptr_arena->used) { // @important 1st test: size_t overflow
+        ptr_allocated = param_ptr_arena->ptr_storage + param_ptr_arena->used;
+        param_ptr_arena->used += aligned_size;
+    }
+#ifdef CONFIG_MJD_POOL_STATS_ENABLED
+    if (ptr_allocated != NULL) {
+        if (param_ptr_arena->used > param_ptr_arena->stats.high_water_mark) {
+            param_ptr_arena->stats.high_water_mark = param_ptr_arena->used;
+        }
+    } else {
+        ++param_ptr_arena->stats.nbr_of_failed_allocs;
+    }
+#endif
+    _UNLOCK(param_ptr_arena);
+
+#ifdef CONFIG_MJD_POOL_DEBUG_POISON
+    if (ptr_allocated != NULL) {
+        memset(ptr_allocated, POISON_INUSE, aligned_size);
+    }
+#endif
+
+    return ptr_allocated;
+}
+
+/*
+ * @important All the pointers returned by mjd_arena_alloc() since the previous reset become invalid.
+ */
+void mjd_arena_reset(mjd_arena_t* param_ptr_arena) {
+#ifdef CONFIG_MJD_POOL_DEBUG_POISON
+    memset(param_ptr_arena->ptr_storage, POISON_FREE, param_ptr_arena->used);
+#endif
+
+    _LOCK(param_ptr_arena);
+    param_ptr_arena->used = 0;
+    _UNLOCK(param_ptr_arena);
+}
+
+esp_err_t mjd_arena_get_stats(mjd_arena_t* param_ptr_arena, mjd_arena_stats_t* param_ptr_stats) {
+    esp_err_t f_retval = ESP_OK;
+
+#ifndef CONFIG_MJD_POOL_STATS_ENABLED
+    f_retval = ESP_ERR_NOT_SUPPORTED;
+    // GOTO
+    goto cleanup;
+#endif
+
+    if (param_ptr_arena == NULL || param_ptr_stats == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param (NULL) | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    _LOCK(param_ptr_arena);
+    *param_ptr_stats = param_ptr_arena->stats;
+    param_ptr_stats->used = param_ptr_arena->used;
+    _UNLOCK(param_ptr_arena);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+void mjd_arena_log_stats(mjd_arena_t* param_ptr_arena) {
+    mjd_arena_stats_t stats;
+
+    if (mjd_arena_get_stats(param_ptr_arena, &stats) != ESP_OK) {
+        return;
+    }
+    ESP_LOGI(TAG, "arena %-11s | used %6u of %6u bytes | high-water %6u | failed %6u", param_ptr_arena->name, stats.used, stats.size,
+            stats.high_water_mark, stats.nbr_of_failed_allocs);
+}
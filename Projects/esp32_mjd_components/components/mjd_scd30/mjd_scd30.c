@@ -7,6 +7,7 @@
 // Component header file(s)
 #include "mjd.h"
 #include "mjd_scd30.h"
+#include "mjd_trace.h"
 
 /*
  * Logging
@@ -318,7 +319,9 @@ static esp_err_t _i2c_write_bytes(const mjd_scd30_config_t* param_ptr_config,
         // GOTO
         goto cleanup;
     }
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_I2C_TRANSACTION);
     f_retval = i2c_master_cmd_begin(param_ptr_config->i2c_port_num, handle, param_ptr_config->i2c_max_ticks_to_wait);
+    MJD_TRACE_END(MJD_TRACE_PROBE_I2C_TRANSACTION);
     if (f_retval != ESP_OK) {
         ESP_LOGE(TAG, "%s(). ABORT. Receive response i2c_master_cmd_begin() err %i (%s)", __FUNCTION__, f_retval,
                 esp_err_to_name(f_retval));
@@ -430,7 +433,9 @@ static esp_err_t _i2c_read_bytes(const mjd_scd30_config_t* param_ptr_config,
         goto cleanup;
     }
 
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_I2C_TRANSACTION);
     f_retval = i2c_master_cmd_begin(param_ptr_config->i2c_port_num, handle, param_ptr_config->i2c_max_ticks_to_wait);
+    MJD_TRACE_END(MJD_TRACE_PROBE_I2C_TRANSACTION);
     if (f_retval != ESP_OK) {
         ESP_LOGE(TAG, "%s(). ABORT. Receive response i2c_master_cmd_begin() err %i (%s)", __FUNCTION__, f_retval,
                 esp_err_to_name(f_retval));
@@ -7,6 +7,7 @@
 // Component header file(s)
 #include "mjd.h"
 #include "mjd_sht3x.h"
+#include "mjd_trace.h"
 
 /*
  * Logging
@@ -184,7 +185,9 @@ static esp_err_t _send_cmd(const mjd_sht3x_config_t* param_ptr_config, mjd_sht3x
         goto cleanup;
     }
 
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_I2C_TRANSACTION);
     f_retval = i2c_master_cmd_begin(param_ptr_config->i2c_port_num, handle, param_ptr_config->i2c_max_ticks_to_wait);
+    MJD_TRACE_END(MJD_TRACE_PROBE_I2C_TRANSACTION);
     if (f_retval != ESP_OK) {
         ESP_LOGE(TAG, "%s(). ABORT. Receive response i2c_master_cmd_begin() err %i (%s)", __FUNCTION__, f_retval,
                 esp_err_to_name(f_retval));
@@ -312,7 +315,9 @@ static esp_err_t _read_register(const mjd_sht3x_config_t* param_ptr_config, mjd_
         goto cleanup;
     }
 
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_I2C_TRANSACTION);
     f_retval = i2c_master_cmd_begin(param_ptr_config->i2c_port_num, handle, param_ptr_config->i2c_max_ticks_to_wait);
+    MJD_TRACE_END(MJD_TRACE_PROBE_I2C_TRANSACTION);
     if (f_retval != ESP_OK) {
         ESP_LOGE(TAG, "%s(). ABORT. Receive response i2c_master_cmd_begin() err %i (%s)", __FUNCTION__, f_retval,
                 esp_err_to_name(f_retval));
@@ -842,7 +847,9 @@ esp_err_t mjd_sht3x_cmd_get_single_measurement(const mjd_sht3x_config_t* param_p
         goto cleanup;
     }
 
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_I2C_TRANSACTION);
     f_retval = i2c_master_cmd_begin(param_ptr_config->i2c_port_num, handle, param_ptr_config->i2c_max_ticks_to_wait);
+    MJD_TRACE_END(MJD_TRACE_PROBE_I2C_TRANSACTION);
     if (f_retval != ESP_OK) {
         ESP_LOGE(TAG, "%s(). ABORT. Receive response i2c_master_cmd_begin() err %i (%s)", __FUNCTION__, f_retval,
                 esp_err_to_name(f_retval));
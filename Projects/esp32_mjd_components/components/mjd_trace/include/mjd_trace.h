@@ -0,0 +1,122 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+#ifndef __MJD_TRACE_H__
+#define __MJD_TRACE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Includes: system, own
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#else
+#include <time.h>
+#endif
+
+/**********
+ * PROBE IDENTIFIERS
+ *
+ * @important Append new probes just before MJD_TRACE_PROBE_MAX and add the matching name in mjd_trace.c
+ */
+typedef enum {
+    MJD_TRACE_PROBE_I2C_TRANSACTION = 0, /*!< i2c_master_cmd_begin() of a sensor register read or write */
+    MJD_TRACE_PROBE_LORABEE_CMD,         /*!< mjd_lorabee_cmd() UART command round-trip (TX command => RX response#1) */
+    MJD_TRACE_PROBE_MQTT_PUBLISH,        /*!< mjd_mqtt_publish() including the retries */
+    MJD_TRACE_PROBE_RMT_SENSOR_READ,     /*!< RMT RX of one sensor reading (trigger/start signal => ringbuffer item received) */
+    MJD_TRACE_PROBE_USER_1,              /*!< Free for use in the app */
+    MJD_TRACE_PROBE_USER_2,              /*!< Free for use in the app */
+    MJD_TRACE_PROBE_USER_3,              /*!< Free for use in the app */
+    MJD_TRACE_PROBE_USER_4,              /*!< Free for use in the app */
+    MJD_TRACE_PROBE_MAX,
+} mjd_trace_probe_id_t;
+
+/**********
+ * HISTOGRAM
+ *
+ * @doc Bucket N counts the spans of [2^N .. 2^(N+1)-1] cycles (bucket 0 also counts spans of 0 cycles).
+ *      32 buckets cover the full uint32_t range: ~18 seconds @ 240MHz.
+ */
+#define MJD_TRACE_NBR_OF_BUCKETS (32)
+
+typedef struct {
+    uint32_t count;        /*!< Number of spans recorded */
+    uint32_t min_cycles;   /*!< Shortest span (cycles) */
+    uint32_t max_cycles;   /*!< Longest span (cycles) */
+    uint64_t total_cycles; /*!< Sum of all spans (cycles), used for the average */
+    uint32_t buckets[MJD_TRACE_NBR_OF_BUCKETS]; /*!< log2 latency histogram */
+} mjd_trace_stats_t;
+
+/**********
+ * CYCLE COUNTER BACKENDS
+ *
+ * @doc ESP32: the Xtensa CCOUNT special register (increments every CPU clock cycle, per core, wraps after 2^32 cycles).
+ * @doc Host (Linux): POSIX clock_gettime(CLOCK_MONOTONIC) in nanoseconds, so 1 "cycle" == 1 nanosecond.
+ *
+ * @important Spans are computed with unsigned 32-bit arithmetic so a single wrap of the counter is harmless.
+ */
+static inline uint32_t mjd_trace_get_cycles(void) {
+#ifdef ESP_PLATFORM
+    return xthal_get_ccount();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) ((uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec);
+#endif
+}
+
+/**********
+ * PUBLIC API
+ *
+ * @doc Enable the probes with `make menuconfig` => "MJD Trace" (CONFIG_MJD_TRACE_ENABLED).
+ *      When disabled all the macros below compile to nothing: no code, no RAM.
+ *
+ * @example
+ *      MJD_TRACE_BEGIN(MJD_TRACE_PROBE_I2C_TRANSACTION);
+ *      f_retval = i2c_master_cmd_begin(port, handle, timeout);
+ *      MJD_TRACE_END(MJD_TRACE_PROBE_I2C_TRANSACTION);
+ *
+ * @important BEGIN declares a local variable: put BEGIN and END in the same scope, and never jump (goto) over BEGIN to END.
+ */
+#ifdef CONFIG_MJD_TRACE_ENABLED
+
+#define MJD_TRACE_BEGIN(probe_id) \
+    const uint32_t _mjd_trace_begin_##probe_id = mjd_trace_get_cycles()
+
+#define MJD_TRACE_END(probe_id) \
+    mjd_trace_record((probe_id), mjd_trace_get_cycles() - _mjd_trace_begin_##probe_id)
+
+void mjd_trace_record(mjd_trace_probe_id_t param_probe_id, uint32_t param_cycles);
+uint32_t mjd_trace_get_cycles_per_us(void);
+esp_err_t mjd_trace_get_stats(mjd_trace_probe_id_t param_probe_id, mjd_trace_stats_t* param_ptr_stats);
+uint32_t mjd_trace_get_percentile_cycles(const mjd_trace_stats_t* param_ptr_stats, uint32_t param_percentile);
+const char * mjd_trace_probe_name(mjd_trace_probe_id_t param_probe_id);
+void mjd_trace_reset(void);
+void mjd_trace_dump(void);
+
+#else
+
+#define MJD_TRACE_BEGIN(probe_id) do {} while (0)
+#define MJD_TRACE_END(probe_id)   do {} while (0)
+
+#define mjd_trace_record(probe_id, cycles)  do {} while (0)
+#define mjd_trace_get_stats(probe_id, ptr)  (ESP_ERR_NOT_SUPPORTED)
+#define mjd_trace_reset()                   do {} while (0)
+#define mjd_trace_dump()                    do {} while (0)
+
+#endif /* CONFIG_MJD_TRACE_ENABLED */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_TRACE_H__ */
@@ -0,0 +1,194 @@
+/*
+ * Component: latency instrumentation using the CPU cycle counter.
+ *
+ * @doc The histograms live in static memory (no malloc). Everything in this file is compiled out when CONFIG_MJD_TRACE_ENABLED is not set.
+ *
+ */
+
+// Component header file(s)
+#include "mjd.h"
+#include "mjd_trace.h"
+
+#ifdef CONFIG_MJD_TRACE_ENABLED
+
+/**********
+ * Logging
+ */
+static const char TAG[] = "mjd_trace";
+
+/**********
+ * STATIC VARIABLES
+ */
+static const char * const probe_names[MJD_TRACE_PROBE_MAX] =
+    {
+        [MJD_TRACE_PROBE_I2C_TRANSACTION] = "I2C_TRANSACTION",
+        [MJD_TRACE_PROBE_LORABEE_CMD] = "LORABEE_CMD",
+        [MJD_TRACE_PROBE_MQTT_PUBLISH] = "MQTT_PUBLISH",
+        [MJD_TRACE_PROBE_RMT_SENSOR_READ] = "RMT_SENSOR_READ",
+        [MJD_TRACE_PROBE_USER_1] = "USER_1",
+        [MJD_TRACE_PROBE_USER_2] = "USER_2",
+        [MJD_TRACE_PROBE_USER_3] = "USER_3",
+        [MJD_TRACE_PROBE_USER_4] = "USER_4",
+    };
+
+static mjd_trace_stats_t probe_stats[MJD_TRACE_PROBE_MAX];
+
+/*
+ * @important The probes are hit from several RTOS tasks on both cores. The critical section only covers a handful of increments.
+ */
+static portMUX_TYPE trace_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+/**********
+ * PRIVATE
+ */
+static inline uint32_t _get_bucket_index(uint32_t param_cycles) {
+    // floor(log2(cycles)); 0 and 1 cycles both land in bucket 0
+    return 31 - __builtin_clz(param_cycles | 1);
+}
+
+static void _reset_one(mjd_trace_stats_t* param_ptr_stats) {
+    memset(param_ptr_stats, 0, sizeof(*param_ptr_stats));
+    param_ptr_stats->min_cycles = UINT32_MAX;
+}
+
+/**********
+ * PUBLIC
+ */
+void mjd_trace_record(mjd_trace_probe_id_t param_probe_id, uint32_t param_cycles) {
+    if (param_probe_id >= MJD_TRACE_PROBE_MAX) {
+        return;
+    }
+
+    mjd_trace_stats_t *ptr_stats = &probe_stats[param_probe_id];
+    const uint32_t bucket = _get_bucket_index(param_cycles);
+
+    portENTER_CRITICAL(&trace_spinlock);
+    if (ptr_stats->count == 0) {
+        ptr_stats->min_cycles = UINT32_MAX; // @important also covers the zero-initialized .bss (no reset called yet)
+    }
+    ++ptr_stats->count;
+    ptr_stats->total_cycles += param_cycles;
+    if (param_cycles < ptr_stats->min_cycles) {
+        ptr_stats->min_cycles = param_cycles;
+    }
+    if (param_cycles > ptr_stats->max_cycles) {
+        ptr_stats->max_cycles = param_cycles;
+    }
+    ++ptr_stats->buckets[bucket];
+    portEXIT_CRITICAL(&trace_spinlock);
+}
+
+uint32_t mjd_trace_get_cycles_per_us(void) {
+#ifdef ESP_PLATFORM
+    return (uint32_t) (esp_clk_cpu_freq() / 1000000);
+#else
+    return 1000; // POSIX backend: 1 cycle == 1 nanosecond
+#endif
+}
+
+esp_err_t mjd_trace_get_stats(mjd_trace_probe_id_t param_probe_id, mjd_trace_stats_t* param_ptr_stats) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_probe_id >= MJD_TRACE_PROBE_MAX || param_ptr_stats == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // @important Copy under lock so the snapshot is consistent.
+    portENTER_CRITICAL(&trace_spinlock);
+    *param_ptr_stats = probe_stats[param_probe_id];
+    portEXIT_CRITICAL(&trace_spinlock);
+
+    if (param_ptr_stats->count == 0) {
+        param_ptr_stats->min_cycles = 0;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*
+ * @brief Estimate a percentile (0..100) from the log2 histogram.
+ *
+ * @return The upper bound of the bucket that holds the percentile, clamped to the observed max. 0 when there are no samples.
+ *
+ * @important The resolution is one power of two: use it to spot tail latencies, not to compare 10% differences.
+ */
+uint32_t mjd_trace_get_percentile_cycles(const mjd_trace_stats_t* param_ptr_stats, uint32_t param_percentile) {
+    if (param_ptr_stats == NULL || param_ptr_stats->count == 0) {
+        return 0;
+    }
+    if (param_percentile > 100) {
+        param_percentile = 100;
+    }
+
+    // Rank of the sample (1-based, rounded up)
+    uint64_t rank = ((uint64_t) param_ptr_stats->count * param_percentile + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t cumulative = 0;
+    for (uint32_t idx = 0; idx < MJD_TRACE_NBR_OF_BUCKETS; idx++) {
+        cumulative += param_ptr_stats->buckets[idx];
+        if (cumulative >= rank) {
+            uint32_t upper_bound = (idx >= 31) ? UINT32_MAX : ((2U << idx) - 1);
+            return (upper_bound < param_ptr_stats->max_cycles) ? upper_bound : param_ptr_stats->max_cycles;
+        }
+    }
+
+    return param_ptr_stats->max_cycles;
+}
+
+const char * mjd_trace_probe_name(mjd_trace_probe_id_t param_probe_id) {
+    if (param_probe_id >= MJD_TRACE_PROBE_MAX || probe_names[param_probe_id] == NULL) {
+        return "UNKNOWN";
+    }
+    return probe_names[param_probe_id];
+}
+
+void mjd_trace_reset(void) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    portENTER_CRITICAL(&trace_spinlock);
+    for (uint32_t idx = 0; idx < MJD_TRACE_PROBE_MAX; idx++) {
+        _reset_one(&probe_stats[idx]);
+    }
+    portEXIT_CRITICAL(&trace_spinlock);
+}
+
+void mjd_trace_dump(void) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    const uint32_t cycles_per_us = mjd_trace_get_cycles_per_us();
+    mjd_trace_stats_t stats;
+
+    ESP_LOGI(TAG, "*** TRACE DUMP (%u cycles/us) ***", cycles_per_us);
+    for (uint32_t idx = 0; idx < MJD_TRACE_PROBE_MAX; idx++) {
+        mjd_trace_get_stats(idx, &stats);
+        if (stats.count == 0) {
+            continue;
+        }
+
+        ESP_LOGI(TAG, "  %-16s count %6u | min %8u us | avg %8u us | max %8u us | p50 <=%8u us | p99 <=%8u us",
+                mjd_trace_probe_name(idx), stats.count,
+                stats.min_cycles / cycles_per_us,
+                (uint32_t) (stats.total_cycles / stats.count / cycles_per_us),
+                stats.max_cycles / cycles_per_us,
+                mjd_trace_get_percentile_cycles(&stats, 50) / cycles_per_us,
+                mjd_trace_get_percentile_cycles(&stats, 99) / cycles_per_us);
+
+        for (uint32_t bucket = 0; bucket < MJD_TRACE_NBR_OF_BUCKETS; bucket++) {
+            if (stats.buckets[bucket] == 0) {
+                continue;
+            }
+            ESP_LOGI(TAG, "      [2^%-2u cycles] %6u", bucket, stats.buckets[bucket]);
+        }
+    }
+}
+
+#endif /* CONFIG_MJD_TRACE_ENABLED */
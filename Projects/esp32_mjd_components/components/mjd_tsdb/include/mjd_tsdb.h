@@ -0,0 +1,225 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+#ifndef __MJD_TSDB_H__
+#define __MJD_TSDB_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Includes: system, own
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+/**********
+ * SAMPLES
+ *
+ * @doc A sample is a timestamp and 1..MJD_TSDB_MAX_VALUES float values (e.g. the temperature, humidity and pressure of a BME280).
+ *      The number of values per sample is fixed per store (mjd_tsdb_config_t.nbr_of_values).
+ *
+ * @important The timestamps of a store never decrease (the time-range queries rely on it).
+ */
+#define MJD_TSDB_MAX_VALUES (4)
+
+typedef struct {
+    int64_t timestamp_ms;
+    float values[MJD_TSDB_MAX_VALUES];
+} mjd_tsdb_sample_t;
+
+/**********
+ * BLOCKS
+ *
+ * @doc A block is MJD_TSDB_BLOCK_SIZE bytes: a header and a bitstream of compressed samples (the scheme of Facebook's Gorilla TSDB):
+ *      - timestamps: the delta-of-delta, '0' when the interval did not change, else '10' + 7 bits, '110' + 9 bits, '1110' + 12 bits
+ *        or '1111' + 64 bits (zigzag).
+ *      - values: XOR with the previous value of the same column, '0' when equal, '10' + the meaningful bits when they fit in the window
+ *        of the previous XOR, else '11' + 5 bits leading zeros + 5 bits length - 1 + the meaningful bits.
+ *      The first sample of a block is stored as is, so every block decodes on its own.
+ *
+ * @doc A sample of a sensor that samples at a fixed interval and changes slowly takes 1 bit for the timestamp and 0..20 bits per value.
+ */
+#define MJD_TSDB_BLOCK_SIZE (256)
+
+#define MJD_TSDB_BLOCK_MAGIC (0xB7)
+#define MJD_TSDB_BLOCK_FLAG_SEALED (0x01) /*!< The block is full: it is never written again (until its segment is recycled) */
+
+typedef struct __attribute__((packed)) {
+    uint8_t magic;
+    uint8_t flags;
+    uint16_t nbr_of_samples;
+    uint32_t seq;               /*!< The block sequence number, +1 per block since the store was created */
+    int64_t first_timestamp_ms;
+    int64_t last_timestamp_ms;
+    uint16_t nbr_of_bits;       /*!< The used bits of the payload */
+    uint16_t checksum;          /*!< Fletcher-16 of the block (this field excluded) */
+} mjd_tsdb_block_header_t;
+
+#define MJD_TSDB_BLOCK_PAYLOAD_SIZE (MJD_TSDB_BLOCK_SIZE - sizeof(mjd_tsdb_block_header_t))
+
+/*
+ * @doc The codec state after the last sample (the encoder) or the last decoded sample (the reader).
+ */
+typedef struct {
+    uint32_t nbr_of_samples;
+    uint32_t nbr_of_bits;
+    int64_t prev_timestamp_ms;
+    int64_t prev_delta_ms;
+    uint32_t prev_values[MJD_TSDB_MAX_VALUES];     /*!< The float bits */
+    uint8_t prev_leading[MJD_TSDB_MAX_VALUES];     /*!< The XOR window: leading zeros */
+    uint8_t prev_meaningful[MJD_TSDB_MAX_VALUES];  /*!< The XOR window: meaningful bits (0 = no window yet) */
+} mjd_tsdb_codec_state_t;
+
+/*
+ * @doc The block that is being filled. The header in bytes[] is kept up to date after each append, except the checksum
+ *      (mjd_tsdb_block_finalize()).
+ */
+typedef struct {
+    uint8_t bytes[MJD_TSDB_BLOCK_SIZE];
+    uint32_t nbr_of_values;
+    mjd_tsdb_codec_state_t state;
+} mjd_tsdb_block_t;
+
+typedef struct {
+    const uint8_t * ptr_bytes;
+    uint32_t nbr_of_values;
+    uint32_t nbr_of_samples;    /*!< From the header */
+    uint32_t nbr_of_bits;       /*!< From the header */
+    mjd_tsdb_codec_state_t state;
+} mjd_tsdb_block_reader_t;
+
+esp_err_t mjd_tsdb_block_init(mjd_tsdb_block_t* param_ptr_block, uint32_t param_seq, uint32_t param_nbr_of_values);
+esp_err_t mjd_tsdb_block_append(mjd_tsdb_block_t* param_ptr_block, const mjd_tsdb_sample_t* param_ptr_sample);
+void mjd_tsdb_block_finalize(mjd_tsdb_block_t* param_ptr_block, uint8_t param_flags);
+esp_err_t mjd_tsdb_block_check(const uint8_t * param_ptr_bytes);
+esp_err_t mjd_tsdb_block_restore(mjd_tsdb_block_t* param_ptr_block, const uint8_t * param_ptr_bytes, uint32_t param_nbr_of_values);
+esp_err_t mjd_tsdb_block_reader_init(mjd_tsdb_block_reader_t* param_ptr_reader, const uint8_t * param_ptr_bytes,
+                                     uint32_t param_nbr_of_values);
+bool mjd_tsdb_block_reader_next(mjd_tsdb_block_reader_t* param_ptr_reader, mjd_tsdb_sample_t* param_ptr_sample);
+
+/**********
+ * STORE
+ *
+ * @doc The blocks are stored in a ring of nbr_of_segments segment files <base_path>/<name>.<n>, blocks_per_segment blocks each.
+ *      Block seq lives in segment (seq / blocks_per_segment) % nbr_of_segments at slot seq % blocks_per_segment.
+ *      When the ring is full the oldest segment is recycled (recreated empty) for the next block.
+ *
+ * @doc Flash writes: 1 block write when a block is full, and 1 rewrite of the open block per mjd_tsdb_flush(). The samples that
+ *      were appended after the last write of the open block are lost at a reset: call mjd_tsdb_flush() before a deep sleep.
+ *
+ * @doc RAM: the open block, 1 read buffer and an index entry of 16 bytes per block (first timestamp, time span, samples).
+ *
+ * @important The file system must be mounted first, e.g. SPIFFS with esp_vfs_spiffs_register(). The complete path of a segment
+ *            file is max MJD_TSDB_PATH_MAX_LEN characters (SPIFFS_OBJ_NAME_LEN).
+ */
+#define MJD_TSDB_MAX_SEGMENTS (16)
+#define MJD_TSDB_PATH_MAX_LEN (32)
+
+#define MJD_TSDB_SEGMENT_MAGIC (0x42445354) /*!< "TSDB" */
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t nbr_of_recycles;   /*!< The wear counter of this segment file */
+    uint32_t first_seq;         /*!< The seq of slot 0 */
+    uint16_t block_size;
+    uint8_t nbr_of_values;
+    uint8_t reserved;
+} mjd_tsdb_segment_header_t;
+
+typedef struct {
+    const char * base_path;         /*!< The mount point, e.g. "/spiffs" */
+    const char * name;              /*!< The segment files are <base_path>/<name>.<n> */
+    uint32_t nbr_of_values;         /*!< Values per sample: 1..MJD_TSDB_MAX_VALUES */
+    uint32_t nbr_of_segments;       /*!< 2..MJD_TSDB_MAX_SEGMENTS. Recycling a segment drops 1/nbr_of_segments of the history */
+    uint32_t blocks_per_segment;    /*!< >= 1 */
+} mjd_tsdb_config_t;
+
+#define MJD_TSDB_CONFIG_DEFAULT() { \
+    .base_path = "/spiffs", \
+    .name = "tsdb", \
+    .nbr_of_values = 1, \
+    .nbr_of_segments = 4, \
+    .blocks_per_segment = 32, \
+}
+
+typedef struct {
+    int64_t first_timestamp_ms;
+    uint32_t span_ms;           /*!< last - first timestamp, UINT32_MAX when it does not fit */
+    uint16_t nbr_of_samples;    /*!< 0 = no block (missing or corrupt) */
+    uint16_t reserved;
+} mjd_tsdb_index_entry_t;
+
+/*
+ * @doc The position of the next sample to read. Keep it (e.g. in RTC memory or NVS) after the upload of the samples was acked.
+ */
+typedef struct {
+    uint32_t seq;
+    uint32_t sample_idx;
+} mjd_tsdb_cursor_t;
+
+typedef struct {
+    uint32_t nbr_of_samples;           /*!< In the store now (the open block included) */
+    uint32_t nbr_of_blocks;            /*!< In the store now (the open block included) */
+    uint32_t nbr_of_appends;
+    uint32_t nbr_of_block_writes;      /*!< Full blocks + rewrites of the open block (mjd_tsdb_flush()) */
+    uint32_t nbr_of_block_reads;
+    uint32_t nbr_of_recycles;          /*!< Segments recycled since the open */
+    uint32_t nbr_of_samples_recycled;  /*!< The samples of the recycled segments (the oldest history) */
+    uint32_t nbr_of_corrupt_blocks;    /*!< Blocks with a bad checksum or header (open, reads) */
+    uint32_t nbr_of_cursor_gaps;       /*!< Cursors that pointed to recycled blocks: they jumped to the oldest sample */
+    uint32_t min_segment_recycles;     /*!< The wear of the least and the most recycled segment file */
+    uint32_t max_segment_recycles;
+    float bytes_per_sample;            /*!< Flash bytes per sample of the full blocks (headers and unused tails included) */
+    float compression_ratio;           /*!< Raw bytes (timestamp int64 + float values) / bytes_per_sample */
+} mjd_tsdb_stats_t;
+
+typedef struct {
+    mjd_tsdb_config_t config;
+    char path_prefix[MJD_TSDB_PATH_MAX_LEN + 1]; /*!< <base_path>/<name>. */
+    uint32_t nbr_of_blocks;                      /*!< nbr_of_segments * blocks_per_segment */
+    mjd_tsdb_index_entry_t * ptr_index;          /*!< nbr_of_blocks entries, entry seq % nbr_of_blocks */
+    uint32_t oldest_seq;
+    uint32_t open_seq;
+    mjd_tsdb_block_t open_block;
+    int64_t last_timestamp_ms;                   /*!< Of the newest sample in the store (INT64_MIN = none): appends must not be older */
+    uint8_t read_buffer[MJD_TSDB_BLOCK_SIZE];
+    uint32_t read_buffer_seq;
+    bool read_buffer_is_valid;
+    uint32_t segment_recycles[MJD_TSDB_MAX_SEGMENTS];
+    uint32_t nbr_of_sealed_blocks;               /*!< Since the open (bytes_per_sample) */
+    uint32_t nbr_of_sealed_samples;
+    mjd_tsdb_stats_t stats;
+    SemaphoreHandle_t mutex;
+} mjd_tsdb_t;
+
+/*
+ * @return false to stop the query
+ */
+typedef bool (*mjd_tsdb_query_handler_t)(const mjd_tsdb_sample_t* param_ptr_sample, void * param_ptr_arg);
+
+esp_err_t mjd_tsdb_open(mjd_tsdb_t* param_ptr_tsdb, const mjd_tsdb_config_t* param_ptr_config);
+esp_err_t mjd_tsdb_close(mjd_tsdb_t* param_ptr_tsdb);
+esp_err_t mjd_tsdb_append(mjd_tsdb_t* param_ptr_tsdb, const mjd_tsdb_sample_t* param_ptr_sample);
+esp_err_t mjd_tsdb_flush(mjd_tsdb_t* param_ptr_tsdb);
+esp_err_t mjd_tsdb_query(mjd_tsdb_t* param_ptr_tsdb, int64_t param_from_ms, int64_t param_to_ms, mjd_tsdb_query_handler_t param_handler,
+                         void * param_ptr_arg, uint32_t * param_ptr_nbr_of_samples);
+esp_err_t mjd_tsdb_cursor_oldest(mjd_tsdb_t* param_ptr_tsdb, mjd_tsdb_cursor_t* param_ptr_cursor);
+esp_err_t mjd_tsdb_cursor_latest(mjd_tsdb_t* param_ptr_tsdb, mjd_tsdb_cursor_t* param_ptr_cursor);
+esp_err_t mjd_tsdb_read_since(mjd_tsdb_t* param_ptr_tsdb, mjd_tsdb_cursor_t* param_ptr_cursor, mjd_tsdb_sample_t* param_ptr_samples,
+                              uint32_t param_max_samples, uint32_t * param_ptr_nbr_of_samples);
+esp_err_t mjd_tsdb_get_stats(mjd_tsdb_t* param_ptr_tsdb, mjd_tsdb_stats_t* param_ptr_stats);
+void mjd_tsdb_log_stats(mjd_tsdb_t* param_ptr_tsdb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_TSDB_H__ */
@@ -0,0 +1,732 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+
+// Component header file(s)
+#include "mjd.h"
+#include "mjd_tsdb.h"
+
+/**********
+ * Logging
+ */
+static const char TAG[] = "mjd_tsdb";
+
+#define _LOCK(ptr_tsdb)   xSemaphoreTake((ptr_tsdb)->mutex, portMAX_DELAY)
+#define _UNLOCK(ptr_tsdb) xSemaphoreGive((ptr_tsdb)->mutex)
+
+/**********
+ * PRIVATE: LAYOUT
+ */
+static inline uint32_t _segment_of(const mjd_tsdb_t* param_ptr_tsdb, uint32_t param_seq) {
+    return (param_seq / param_ptr_tsdb->config.blocks_per_segment) % param_ptr_tsdb->config.nbr_of_segments;
+}
+
+static inline uint32_t _slot_of(const mjd_tsdb_t* param_ptr_tsdb, uint32_t param_seq) {
+    return param_seq % param_ptr_tsdb->config.blocks_per_segment;
+}
+
+static inline long _offset_of(uint32_t param_slot) {
+    return (long) (sizeof(mjd_tsdb_segment_header_t) + param_slot * MJD_TSDB_BLOCK_SIZE);
+}
+
+static inline mjd_tsdb_index_entry_t * _entry_of(const mjd_tsdb_t* param_ptr_tsdb, uint32_t param_seq) {
+    return &param_ptr_tsdb->ptr_index[param_seq % param_ptr_tsdb->nbr_of_blocks];
+}
+
+static void _segment_path(const mjd_tsdb_t* param_ptr_tsdb, uint32_t param_segment, char * param_ptr_path) {
+    snprintf(param_ptr_path, MJD_TSDB_PATH_MAX_LEN + 1, "%s%u", param_ptr_tsdb->path_prefix, param_segment);
+}
+
+/*
+ * @doc The index entry of a block from its header.
+ */
+static void _index_update(mjd_tsdb_t* param_ptr_tsdb, uint32_t param_seq, const uint8_t * param_ptr_bytes) {
+    const mjd_tsdb_block_header_t *ptr_header = (const mjd_tsdb_block_header_t *) param_ptr_bytes;
+    mjd_tsdb_index_entry_t *ptr_entry = _entry_of(param_ptr_tsdb, param_seq);
+    int64_t span_ms = ptr_header->last_timestamp_ms - ptr_header->first_timestamp_ms;
+
+    ptr_entry->first_timestamp_ms = ptr_header->first_timestamp_ms;
+    ptr_entry->span_ms = (span_ms >= 0 && span_ms < UINT32_MAX) ? (uint32_t) span_ms : UINT32_MAX;
+    ptr_entry->nbr_of_samples = ptr_header->nbr_of_samples;
+}
+
+static void _update_wear_stats(mjd_tsdb_t* param_ptr_tsdb) {
+    param_ptr_tsdb->stats.min_segment_recycles = UINT32_MAX;
+    param_ptr_tsdb->stats.max_segment_recycles = 0;
+    for (uint32_t idx = 0; idx < param_ptr_tsdb->config.nbr_of_segments; idx++) {
+        uint32_t nbr = param_ptr_tsdb->segment_recycles[idx];
+        if (nbr < param_ptr_tsdb->stats.min_segment_recycles) {
+            param_ptr_tsdb->stats.min_segment_recycles = nbr;
+        }
+        if (nbr > param_ptr_tsdb->stats.max_segment_recycles) {
+            param_ptr_tsdb->stats.max_segment_recycles = nbr;
+        }
+    }
+}
+
+/**********
+ * PRIVATE: FILES
+ */
+
+/*
+ * @brief Recreate a segment file, empty, for the blocks from param_first_seq. The blocks of its previous lap are dropped.
+ *
+ * @doc The file is truncated ("wb") instead of overwritten in place: SPIFFS then frees the pages of the old blocks at once and
+ *      the round-robin order recycles every segment file equally often (the wear counter in the segment header shows it).
+ */
+static esp_err_t _recycle_segment(mjd_tsdb_t* param_ptr_tsdb, uint32_t param_first_seq) {
+    esp_err_t f_retval = ESP_OK;
+
+    uint32_t segment = _segment_of(param_ptr_tsdb, param_first_seq);
+    char path[MJD_TSDB_PATH_MAX_LEN + 1];
+    FILE *ptr_file = NULL;
+
+    // The previous lap of this segment: seq - nbr_of_blocks ... + blocks_per_segment - 1
+    if (param_first_seq >= param_ptr_tsdb->nbr_of_blocks) {
+        uint32_t dropped_seq = param_first_seq - param_ptr_tsdb->nbr_of_blocks;
+        for (uint32_t idx = 0; idx < param_ptr_tsdb->config.blocks_per_segment; idx++) {
+            if (dropped_seq + idx >= param_ptr_tsdb->oldest_seq) {
+                mjd_tsdb_index_entry_t *ptr_entry = _entry_of(param_ptr_tsdb, dropped_seq + idx);
+                param_ptr_tsdb->stats.nbr_of_samples_recycled += ptr_entry->nbr_of_samples;
+                ptr_entry->nbr_of_samples = 0;
+            }
+        }
+        if (param_ptr_tsdb->oldest_seq < dropped_seq + param_ptr_tsdb->config.blocks_per_segment) {
+            param_ptr_tsdb->oldest_seq = dropped_seq + param_ptr_tsdb->config.blocks_per_segment;
+        }
+        param_ptr_tsdb->read_buffer_is_valid = false;
+        ++param_ptr_tsdb->stats.nbr_of_recycles;
+    }
+
+    mjd_tsdb_segment_header_t header = {
+        .magic = MJD_TSDB_SEGMENT_MAGIC,
+        .nbr_of_recycles = param_ptr_tsdb->segment_recycles[segment] + 1,
+        .first_seq = param_first_seq,
+        .block_size = MJD_TSDB_BLOCK_SIZE,
+        .nbr_of_values = (uint8_t) param_ptr_tsdb->config.nbr_of_values,
+        .reserved = 0
+    };
+
+    _segment_path(param_ptr_tsdb, segment, path);
+    ptr_file = fopen(path, "wb");
+    if (ptr_file == NULL) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). ABORT. fopen(%s) failed | err %i (%s)", __FUNCTION__, path, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (fwrite(&header, sizeof(header), 1, ptr_file) != 1) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). ABORT. fwrite(%s) failed (file system full?) | err %i (%s)", __FUNCTION__, path, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    param_ptr_tsdb->segment_recycles[segment] = header.nbr_of_recycles;
+    _update_wear_stats(param_ptr_tsdb);
+
+    // LABEL
+    cleanup: ;
+
+    if (ptr_file != NULL) {
+        fclose(ptr_file);
+    }
+
+    return f_retval;
+}
+
+/*
+ * @brief Start a new (empty) open block. A block in slot 0 recycles its segment first.
+ *
+ * @doc The segment is recycled when its first block starts, not when that block is written: the open block and the blocks on
+ *      flash then never share an index entry.
+ */
+static esp_err_t _start_open_block(mjd_tsdb_t* param_ptr_tsdb, uint32_t param_seq) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (_slot_of(param_ptr_tsdb, param_seq) == 0) {
+        f_retval = _recycle_segment(param_ptr_tsdb, param_seq);
+        if (f_retval != ESP_OK) {
+            ESP_LOGE(TAG, "%s(). ABORT. _recycle_segment() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+    }
+
+    param_ptr_tsdb->open_seq = param_seq;
+    mjd_tsdb_block_init(&param_ptr_tsdb->open_block, param_seq, param_ptr_tsdb->config.nbr_of_values);
+    _entry_of(param_ptr_tsdb, param_seq)->nbr_of_samples = 0;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*
+ * @brief Write the open block to its slot.
+ */
+static esp_err_t _write_open_block(mjd_tsdb_t* param_ptr_tsdb, uint8_t param_flags) {
+    esp_err_t f_retval = ESP_OK;
+
+    uint32_t seq = param_ptr_tsdb->open_seq;
+    char path[MJD_TSDB_PATH_MAX_LEN + 1];
+    FILE *ptr_file = NULL;
+    int f_close_retval;
+
+    mjd_tsdb_block_finalize(&param_ptr_tsdb->open_block, param_flags);
+
+    _segment_path(param_ptr_tsdb, _segment_of(param_ptr_tsdb, seq), path);
+    ptr_file = fopen(path, "r+b");
+    if (ptr_file == NULL) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). ABORT. fopen(%s) failed | err %i (%s)", __FUNCTION__, path, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (fseek(ptr_file, _offset_of(_slot_of(param_ptr_tsdb, seq)), SEEK_SET) != 0
+            || fwrite(param_ptr_tsdb->open_block.bytes, MJD_TSDB_BLOCK_SIZE, 1, ptr_file) != 1) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). ABORT. fwrite(%s) block seq %u failed (file system full?) | err %i (%s)", __FUNCTION__, path, seq,
+                f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    // SPIFFS writes its cache to flash at the fclose()
+    f_close_retval = fclose(ptr_file);
+    ptr_file = NULL;
+    if (f_close_retval != 0) {
+        f_retval = ESP_FAIL;
+        ESP_LOGE(TAG, "%s(). ABORT. fclose(%s) block seq %u failed (file system full?) | err %i (%s)", __FUNCTION__, path, seq,
+                f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    ++param_ptr_tsdb->stats.nbr_of_block_writes;
+
+    // LABEL
+    cleanup: ;
+
+    if (ptr_file != NULL) {
+        fclose(ptr_file);
+    }
+
+    return f_retval;
+}
+
+/*
+ * @brief The bytes of block param_seq: the open block from RAM, the others from the file (cached in the read buffer).
+ *
+ * @return NULL when the block cannot be read or is corrupt
+ */
+static const uint8_t * _get_block(mjd_tsdb_t* param_ptr_tsdb, uint32_t param_seq) {
+    char path[MJD_TSDB_PATH_MAX_LEN + 1];
+    FILE *ptr_file = NULL;
+    const mjd_tsdb_block_header_t *ptr_header = (const mjd_tsdb_block_header_t *) param_ptr_tsdb->read_buffer;
+    bool is_ok = false;
+
+    if (param_seq == param_ptr_tsdb->open_seq) {
+        return param_ptr_tsdb->open_block.bytes;
+    }
+    if (param_ptr_tsdb->read_buffer_is_valid == true && param_ptr_tsdb->read_buffer_seq == param_seq) {
+        return param_ptr_tsdb->read_buffer;
+    }
+
+    param_ptr_tsdb->read_buffer_is_valid = false;
+    _segment_path(param_ptr_tsdb, _segment_of(param_ptr_tsdb, param_seq), path);
+    ptr_file = fopen(path, "rb");
+    if (ptr_file != NULL) {
+        is_ok = fseek(ptr_file, _offset_of(_slot_of(param_ptr_tsdb, param_seq)), SEEK_SET) == 0
+                && fread(param_ptr_tsdb->read_buffer, MJD_TSDB_BLOCK_SIZE, 1, ptr_file) == 1;
+        fclose(ptr_file);
+    }
+    ++param_ptr_tsdb->stats.nbr_of_block_reads;
+
+    if (is_ok == false || mjd_tsdb_block_check(param_ptr_tsdb->read_buffer) != ESP_OK || ptr_header->seq != param_seq) {
+        ESP_LOGW(TAG, "%s(). Block seq %u in %s is missing or corrupt: skipped", __FUNCTION__, param_seq, path);
+        ++param_ptr_tsdb->stats.nbr_of_corrupt_blocks;
+        _entry_of(param_ptr_tsdb, param_seq)->nbr_of_samples = 0;
+        return NULL;
+    }
+
+    param_ptr_tsdb->read_buffer_seq = param_seq;
+    param_ptr_tsdb->read_buffer_is_valid = true;
+
+    return param_ptr_tsdb->read_buffer;
+}
+
+/*
+ * @brief Rebuild the index from the segment files. Stops reading a segment at its first invalid block.
+ *
+ * @return false when there is no valid block. The highest valid seq in param_ptr_max_seq, and the first seq of each
+ *         segment in param_ptr_first_seqs (UINT32_MAX when the segment file is missing or invalid).
+ */
+static bool _scan_segments(mjd_tsdb_t* param_ptr_tsdb, uint32_t * param_ptr_max_seq, uint32_t * param_ptr_first_seqs) {
+    char path[MJD_TSDB_PATH_MAX_LEN + 1];
+    bool is_found = false;
+
+    for (uint32_t segment = 0; segment < param_ptr_tsdb->config.nbr_of_segments; segment++) {
+        mjd_tsdb_segment_header_t header;
+        FILE *ptr_file;
+
+        param_ptr_first_seqs[segment] = UINT32_MAX;
+        _segment_path(param_ptr_tsdb, segment, path);
+        ptr_file = fopen(path, "rb");
+        if (ptr_file == NULL) {
+            continue;
+        }
+        if (fread(&header, sizeof(header), 1, ptr_file) != 1 || header.magic != MJD_TSDB_SEGMENT_MAGIC
+                || header.block_size != MJD_TSDB_BLOCK_SIZE || header.nbr_of_values != param_ptr_tsdb->config.nbr_of_values
+                || _slot_of(param_ptr_tsdb, header.first_seq) != 0 || _segment_of(param_ptr_tsdb, header.first_seq) != segment) {
+            ESP_LOGW(TAG, "%s(). %s is not a segment of this store (other config?): it will be recycled", __FUNCTION__, path);
+            fclose(ptr_file);
+            continue;
+        }
+        param_ptr_tsdb->segment_recycles[segment] = header.nbr_of_recycles;
+        param_ptr_first_seqs[segment] = header.first_seq;
+
+        for (uint32_t slot = 0; slot < param_ptr_tsdb->config.blocks_per_segment; slot++) {
+            const mjd_tsdb_block_header_t *ptr_block_header = (const mjd_tsdb_block_header_t *) param_ptr_tsdb->read_buffer;
+            if (fread(param_ptr_tsdb->read_buffer, MJD_TSDB_BLOCK_SIZE, 1, ptr_file) != 1) {
+                break;
+            }
+            esp_err_t check = mjd_tsdb_block_check(param_ptr_tsdb->read_buffer);
+            if (check != ESP_OK || ptr_block_header->seq != header.first_seq + slot) {
+                if (check == ESP_ERR_INVALID_CRC) {
+                    ESP_LOGW(TAG, "%s(). %s slot %u is corrupt: the rest of the segment is skipped", __FUNCTION__, path, slot);
+                    ++param_ptr_tsdb->stats.nbr_of_corrupt_blocks;
+                }
+                break;
+            }
+            _index_update(param_ptr_tsdb, ptr_block_header->seq, param_ptr_tsdb->read_buffer);
+            if (is_found == false || ptr_block_header->seq > *param_ptr_max_seq) {
+                *param_ptr_max_seq = ptr_block_header->seq;
+            }
+            is_found = true;
+        }
+        fclose(ptr_file);
+    }
+
+    return is_found;
+}
+
+/**********
+ * STORE
+ */
+esp_err_t mjd_tsdb_open(mjd_tsdb_t* param_ptr_tsdb, const mjd_tsdb_config_t* param_ptr_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    uint32_t max_seq = 0;
+    uint32_t first_seqs[MJD_TSDB_MAX_SEGMENTS];
+
+    if (param_ptr_tsdb == NULL || param_ptr_config == NULL || param_ptr_config->base_path == NULL || param_ptr_config->name == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid param (NULL) | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (param_ptr_config->nbr_of_values == 0 || param_ptr_config->nbr_of_values > MJD_TSDB_MAX_VALUES
+            || param_ptr_config->nbr_of_segments < 2 || param_ptr_config->nbr_of_segments > MJD_TSDB_MAX_SEGMENTS
+            || param_ptr_config->blocks_per_segment == 0) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid config (nbr_of_values 1..%u, nbr_of_segments 2..%u, blocks_per_segment >= 1) | err %i (%s)",
+                __FUNCTION__, MJD_TSDB_MAX_VALUES, MJD_TSDB_MAX_SEGMENTS, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    memset(param_ptr_tsdb, 0, sizeof(*param_ptr_tsdb));
+    param_ptr_tsdb->config = *param_ptr_config;
+    param_ptr_tsdb->last_timestamp_ms = INT64_MIN;
+    param_ptr_tsdb->nbr_of_blocks = param_ptr_config->nbr_of_segments * param_ptr_config->blocks_per_segment;
+
+    // The longest path: <base_path>/<name>.<MJD_TSDB_MAX_SEGMENTS - 1>
+    int len = snprintf(param_ptr_tsdb->path_prefix, sizeof(param_ptr_tsdb->path_prefix), "%s/%s.", param_ptr_config->base_path,
+            param_ptr_config->name);
+    if (len < 0 || len + 2 > MJD_TSDB_PATH_MAX_LEN) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. The segment paths %s<n> are longer than %u characters | err %i (%s)", __FUNCTION__,
+                param_ptr_tsdb->path_prefix, MJD_TSDB_PATH_MAX_LEN, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    param_ptr_tsdb->ptr_index = calloc(param_ptr_tsdb->nbr_of_blocks, sizeof(mjd_tsdb_index_entry_t));
+    if (param_ptr_tsdb->ptr_index == NULL) {
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "%s(). ABORT. calloc() index of %u blocks | err %i (%s)", __FUNCTION__, param_ptr_tsdb->nbr_of_blocks, f_retval,
+                esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    param_ptr_tsdb->mutex = xSemaphoreCreateMutex();
+    if (param_ptr_tsdb->mutex == NULL) {
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "%s(). ABORT. xSemaphoreCreateMutex() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    if (_scan_segments(param_ptr_tsdb, &max_seq, first_seqs) == false) {
+        // A new store
+        f_retval = _start_open_block(param_ptr_tsdb, 0);
+        if (f_retval != ESP_OK) {
+            ESP_LOGE(TAG, "%s(). ABORT. _start_open_block() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+    } else {
+        // A segment of an older lap (it was not recycled completely) shares its index entries with the blocks of the last lap
+        uint32_t window_seq = (max_seq >= param_ptr_tsdb->nbr_of_blocks) ? max_seq - param_ptr_tsdb->nbr_of_blocks + 1 : 0;
+        for (uint32_t segment = 0; segment < param_ptr_config->nbr_of_segments; segment++) {
+            if (first_seqs[segment] != UINT32_MAX && first_seqs[segment] + param_ptr_config->blocks_per_segment <= window_seq) {
+                for (uint32_t slot = 0; slot < param_ptr_config->blocks_per_segment; slot++) {
+                    _entry_of(param_ptr_tsdb, first_seqs[segment] + slot)->nbr_of_samples = 0;
+                }
+            }
+        }
+        param_ptr_tsdb->oldest_seq = window_seq;
+        while (param_ptr_tsdb->oldest_seq < max_seq && _entry_of(param_ptr_tsdb, param_ptr_tsdb->oldest_seq)->nbr_of_samples == 0) {
+            ++param_ptr_tsdb->oldest_seq;
+        }
+
+        // The last block: continue to fill it when it is not sealed
+        param_ptr_tsdb->open_seq = max_seq + 1; // _get_block() reads max_seq from the file
+        const uint8_t *ptr_bytes = _get_block(param_ptr_tsdb, max_seq);
+        const mjd_tsdb_block_header_t *ptr_header = (const mjd_tsdb_block_header_t *) ptr_bytes;
+        const mjd_tsdb_index_entry_t *ptr_entry = _entry_of(param_ptr_tsdb, max_seq);
+
+        // @important The newest sample: a fresh open block behind a sealed block is empty but may not accept older samples
+        if (ptr_bytes != NULL) {
+            param_ptr_tsdb->last_timestamp_ms = ptr_header->last_timestamp_ms;
+        } else if (ptr_entry->span_ms != UINT32_MAX) {
+            param_ptr_tsdb->last_timestamp_ms = ptr_entry->first_timestamp_ms + ptr_entry->span_ms;
+        }
+
+        if (ptr_bytes != NULL && (ptr_header->flags & MJD_TSDB_BLOCK_FLAG_SEALED) == 0
+                && mjd_tsdb_block_restore(&param_ptr_tsdb->open_block, ptr_bytes, param_ptr_config->nbr_of_values) == ESP_OK) {
+            param_ptr_tsdb->open_seq = max_seq;
+        } else {
+            f_retval = _start_open_block(param_ptr_tsdb, max_seq + 1);
+            if (f_retval != ESP_OK) {
+                ESP_LOGE(TAG, "%s(). ABORT. _start_open_block() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+                // GOTO
+                goto cleanup;
+            }
+        }
+        param_ptr_tsdb->read_buffer_is_valid = false;
+    }
+    _update_wear_stats(param_ptr_tsdb);
+
+    ESP_LOGI(TAG, "%s(). %s*: blocks seq %u..%u, %u corrupt blocks", __FUNCTION__, param_ptr_tsdb->path_prefix,
+            param_ptr_tsdb->oldest_seq, param_ptr_tsdb->open_seq, param_ptr_tsdb->stats.nbr_of_corrupt_blocks);
+
+    // LABEL
+    cleanup: ;
+
+    if (f_retval != ESP_OK && param_ptr_tsdb != NULL) {
+        free(param_ptr_tsdb->ptr_index);
+        param_ptr_tsdb->ptr_index = NULL;
+        if (param_ptr_tsdb->mutex != NULL) {
+            vSemaphoreDelete(param_ptr_tsdb->mutex);
+            param_ptr_tsdb->mutex = NULL;
+        }
+    }
+
+    return f_retval;
+}
+
+/*
+ * @brief Flush the open block, then release the RAM.
+ */
+esp_err_t mjd_tsdb_close(mjd_tsdb_t* param_ptr_tsdb) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    f_retval = mjd_tsdb_flush(param_ptr_tsdb);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). mjd_tsdb_flush() (closing anyway) | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+    }
+
+    free(param_ptr_tsdb->ptr_index);
+    param_ptr_tsdb->ptr_index = NULL;
+    vSemaphoreDelete(param_ptr_tsdb->mutex);
+    param_ptr_tsdb->mutex = NULL;
+
+    return f_retval;
+}
+
+/*
+ * @doc A sample goes into the open block in RAM. Flash is written when the block is full (and by mjd_tsdb_flush()).
+ *
+ * @return ESP_ERR_INVALID_ARG when the timestamp is older than the last sample
+ */
+esp_err_t mjd_tsdb_append(mjd_tsdb_t* param_ptr_tsdb, const mjd_tsdb_sample_t* param_ptr_sample) {
+    esp_err_t f_retval = ESP_OK;
+
+    mjd_tsdb_block_t *ptr_block = &param_ptr_tsdb->open_block;
+
+    _LOCK(param_ptr_tsdb);
+
+    if (param_ptr_sample->timestamp_ms < param_ptr_tsdb->last_timestamp_ms) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. The timestamp %lld is older than the last sample | err %i (%s)", __FUNCTION__,
+                param_ptr_sample->timestamp_ms, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    if (mjd_tsdb_block_append(ptr_block, param_ptr_sample) == ESP_ERR_INVALID_SIZE) {
+        // The open block is full: write it and start the next one
+        f_retval = _write_open_block(param_ptr_tsdb, MJD_TSDB_BLOCK_FLAG_SEALED);
+        if (f_retval != ESP_OK) {
+            ESP_LOGE(TAG, "%s(). ABORT. _write_open_block() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+        ++param_ptr_tsdb->nbr_of_sealed_blocks;
+        param_ptr_tsdb->nbr_of_sealed_samples += ptr_block->state.nbr_of_samples;
+
+        f_retval = _start_open_block(param_ptr_tsdb, param_ptr_tsdb->open_seq + 1);
+        if (f_retval != ESP_OK) {
+            ESP_LOGE(TAG, "%s(). ABORT. _start_open_block() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+        mjd_tsdb_block_append(ptr_block, param_ptr_sample);
+    }
+    _index_update(param_ptr_tsdb, param_ptr_tsdb->open_seq, ptr_block->bytes);
+    param_ptr_tsdb->last_timestamp_ms = param_ptr_sample->timestamp_ms;
+    ++param_ptr_tsdb->stats.nbr_of_appends;
+
+    // LABEL
+    cleanup: ;
+
+    _UNLOCK(param_ptr_tsdb);
+
+    return f_retval;
+}
+
+/*
+ * @brief Write the open block (not sealed: it is filled further after a reset too). Call it before a deep sleep or a power off.
+ */
+esp_err_t mjd_tsdb_flush(mjd_tsdb_t* param_ptr_tsdb) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    _LOCK(param_ptr_tsdb);
+
+    if (param_ptr_tsdb->open_block.state.nbr_of_samples > 0) {
+        f_retval = _write_open_block(param_ptr_tsdb, 0);
+        if (f_retval != ESP_OK) {
+            ESP_LOGE(TAG, "%s(). ABORT. _write_open_block() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+    }
+
+    // LABEL
+    cleanup: ;
+
+    _UNLOCK(param_ptr_tsdb);
+
+    return f_retval;
+}
+
+/*
+ * @brief Call param_handler for each sample with a timestamp in [param_from_ms, param_to_ms].
+ *
+ * @doc The RAM index skips the blocks outside the range without reading them.
+ */
+esp_err_t mjd_tsdb_query(mjd_tsdb_t* param_ptr_tsdb, int64_t param_from_ms, int64_t param_to_ms, mjd_tsdb_query_handler_t param_handler,
+                         void * param_ptr_arg, uint32_t * param_ptr_nbr_of_samples) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    uint32_t nbr_of_samples = 0;
+    bool is_stopped = false;
+
+    if (param_handler == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. param_handler is NULL | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        return f_retval;
+    }
+
+    _LOCK(param_ptr_tsdb);
+
+    for (uint32_t seq = param_ptr_tsdb->oldest_seq; is_stopped == false && seq <= param_ptr_tsdb->open_seq; seq++) {
+        const mjd_tsdb_index_entry_t *ptr_entry = _entry_of(param_ptr_tsdb, seq);
+        if (ptr_entry->nbr_of_samples == 0 || ptr_entry->first_timestamp_ms + ptr_entry->span_ms < param_from_ms) {
+            continue;
+        }
+        if (ptr_entry->first_timestamp_ms > param_to_ms) {
+            break; // The timestamps never decrease
+        }
+
+        const uint8_t *ptr_bytes = _get_block(param_ptr_tsdb, seq);
+        mjd_tsdb_block_reader_t reader;
+        mjd_tsdb_sample_t sample;
+        if (ptr_bytes == NULL || mjd_tsdb_block_reader_init(&reader, ptr_bytes, param_ptr_tsdb->config.nbr_of_values) != ESP_OK) {
+            continue;
+        }
+        while (mjd_tsdb_block_reader_next(&reader, &sample) == true) {
+            if (sample.timestamp_ms > param_to_ms) {
+                is_stopped = true;
+                break;
+            }
+            if (sample.timestamp_ms >= param_from_ms) {
+                ++nbr_of_samples;
+                if (param_handler(&sample, param_ptr_arg) == false) {
+                    is_stopped = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    _UNLOCK(param_ptr_tsdb);
+
+    if (param_ptr_nbr_of_samples != NULL) {
+        *param_ptr_nbr_of_samples = nbr_of_samples;
+    }
+
+    return f_retval;
+}
+
+/*
+ * @brief A cursor at the oldest sample in the store (upload everything).
+ */
+esp_err_t mjd_tsdb_cursor_oldest(mjd_tsdb_t* param_ptr_tsdb, mjd_tsdb_cursor_t* param_ptr_cursor) {
+    _LOCK(param_ptr_tsdb);
+    param_ptr_cursor->seq = param_ptr_tsdb->oldest_seq;
+    param_ptr_cursor->sample_idx = 0;
+    _UNLOCK(param_ptr_tsdb);
+
+    return ESP_OK;
+}
+
+/*
+ * @brief A cursor after the last sample in the store (upload the samples that are appended from now on).
+ */
+esp_err_t mjd_tsdb_cursor_latest(mjd_tsdb_t* param_ptr_tsdb, mjd_tsdb_cursor_t* param_ptr_cursor) {
+    _LOCK(param_ptr_tsdb);
+    param_ptr_cursor->seq = param_ptr_tsdb->open_seq;
+    param_ptr_cursor->sample_idx = param_ptr_tsdb->open_block.state.nbr_of_samples;
+    _UNLOCK(param_ptr_tsdb);
+
+    return ESP_OK;
+}
+
+/*
+ * @brief Read the next max param_max_samples samples after the cursor, and move the cursor after them.
+ *
+ * @doc Call it in a loop until *param_ptr_nbr_of_samples is 0 (all read). A cursor stays valid across mjd_tsdb_close() and
+ *      mjd_tsdb_open(). When the samples of a cursor were recycled meanwhile, it jumps to the oldest sample
+ *      (stats.nbr_of_cursor_gaps).
+ */
+esp_err_t mjd_tsdb_read_since(mjd_tsdb_t* param_ptr_tsdb, mjd_tsdb_cursor_t* param_ptr_cursor, mjd_tsdb_sample_t* param_ptr_samples,
+                              uint32_t param_max_samples, uint32_t * param_ptr_nbr_of_samples) {
+    esp_err_t f_retval = ESP_OK;
+
+    uint32_t nbr_of_samples = 0;
+
+    _LOCK(param_ptr_tsdb);
+
+    if (param_ptr_cursor->seq < param_ptr_tsdb->oldest_seq || param_ptr_cursor->seq > param_ptr_tsdb->open_seq) {
+        ESP_LOGW(TAG, "%s(). The cursor (block seq %u) is not in the store anymore: it continues at the oldest sample (block seq %u)",
+                __FUNCTION__, param_ptr_cursor->seq, param_ptr_tsdb->oldest_seq);
+        ++param_ptr_tsdb->stats.nbr_of_cursor_gaps;
+        param_ptr_cursor->seq = param_ptr_tsdb->oldest_seq;
+        param_ptr_cursor->sample_idx = 0;
+    }
+
+    while (nbr_of_samples < param_max_samples) {
+        const mjd_tsdb_index_entry_t *ptr_entry = _entry_of(param_ptr_tsdb, param_ptr_cursor->seq);
+        const uint8_t *ptr_bytes = NULL;
+        mjd_tsdb_block_reader_t reader;
+        mjd_tsdb_sample_t sample;
+
+        if (param_ptr_cursor->sample_idx < ptr_entry->nbr_of_samples) {
+            ptr_bytes = _get_block(param_ptr_tsdb, param_ptr_cursor->seq);
+        }
+        if (ptr_bytes != NULL && mjd_tsdb_block_reader_init(&reader, ptr_bytes, param_ptr_tsdb->config.nbr_of_values) == ESP_OK) {
+            // Skip the samples that were read before (the bitstream is decoded from the start of the block)
+            uint32_t idx = 0;
+            while (idx < param_ptr_cursor->sample_idx && mjd_tsdb_block_reader_next(&reader, &sample) == true) {
+                ++idx;
+            }
+            while (nbr_of_samples < param_max_samples && mjd_tsdb_block_reader_next(&reader, &param_ptr_samples[nbr_of_samples]) == true) {
+                ++nbr_of_samples;
+                ++param_ptr_cursor->sample_idx;
+            }
+            if (nbr_of_samples == param_max_samples) {
+                break;
+            }
+        }
+        if (param_ptr_cursor->seq == param_ptr_tsdb->open_seq) {
+            break; // All read: the next samples are appended to this block
+        }
+        ++param_ptr_cursor->seq;
+        param_ptr_cursor->sample_idx = 0;
+    }
+
+    _UNLOCK(param_ptr_tsdb);
+
+    *param_ptr_nbr_of_samples = nbr_of_samples;
+
+    return f_retval;
+}
+
+esp_err_t mjd_tsdb_get_stats(mjd_tsdb_t* param_ptr_tsdb, mjd_tsdb_stats_t* param_ptr_stats) {
+    _LOCK(param_ptr_tsdb);
+
+    mjd_tsdb_stats_t *ptr_stats = &param_ptr_tsdb->stats;
+    const mjd_tsdb_codec_state_t *ptr_open = &param_ptr_tsdb->open_block.state;
+    uint32_t raw_bytes_per_sample = sizeof(int64_t) + param_ptr_tsdb->config.nbr_of_values * sizeof(float);
+
+    ptr_stats->nbr_of_samples = 0;
+    ptr_stats->nbr_of_blocks = 0;
+    for (uint32_t seq = param_ptr_tsdb->oldest_seq; seq <= param_ptr_tsdb->open_seq; seq++) {
+        const mjd_tsdb_index_entry_t *ptr_entry = _entry_of(param_ptr_tsdb, seq);
+        if (ptr_entry->nbr_of_samples > 0) {
+            ptr_stats->nbr_of_samples += ptr_entry->nbr_of_samples;
+            ++ptr_stats->nbr_of_blocks;
+        }
+    }
+
+    // The full blocks since the open; before the first one is full: the used part of the open block
+    ptr_stats->bytes_per_sample = 0;
+    if (param_ptr_tsdb->nbr_of_sealed_samples > 0) {
+        ptr_stats->bytes_per_sample = (float) param_ptr_tsdb->nbr_of_sealed_blocks * MJD_TSDB_BLOCK_SIZE
+                                      / param_ptr_tsdb->nbr_of_sealed_samples;
+    } else if (ptr_open->nbr_of_samples > 0) {
+        ptr_stats->bytes_per_sample = (float) (sizeof(mjd_tsdb_block_header_t) + (ptr_open->nbr_of_bits + 7) / 8)
+                                      / ptr_open->nbr_of_samples;
+    }
+    ptr_stats->compression_ratio = (ptr_stats->bytes_per_sample > 0) ? raw_bytes_per_sample / ptr_stats->bytes_per_sample : 0;
+
+    *param_ptr_stats = *ptr_stats;
+
+    _UNLOCK(param_ptr_tsdb);
+
+    return ESP_OK;
+}
+
+void mjd_tsdb_log_stats(mjd_tsdb_t* param_ptr_tsdb) {
+    mjd_tsdb_stats_t stats;
+
+    mjd_tsdb_get_stats(param_ptr_tsdb, &stats);
+
+    ESP_LOGI(TAG, "%s: %u samples in %u blocks | %.2f bytes/sample (compression ratio %.1f) | appends %u block writes %u reads %u",
+            param_ptr_tsdb->path_prefix, stats.nbr_of_samples, stats.nbr_of_blocks, stats.bytes_per_sample, stats.compression_ratio,
+            stats.nbr_of_appends, stats.nbr_of_block_writes, stats.nbr_of_block_reads);
+    ESP_LOGI(TAG, "    recycles %u (%u samples) wear per segment %u..%u | corrupt blocks %u | cursor gaps %u", stats.nbr_of_recycles,
+            stats.nbr_of_samples_recycled, stats.min_segment_recycles, stats.max_segment_recycles, stats.nbr_of_corrupt_blocks,
+            stats.nbr_of_cursor_gaps);
+}
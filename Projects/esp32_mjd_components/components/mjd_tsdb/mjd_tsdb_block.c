@@ -0,0 +1,413 @@
+/*
+ * Component: the compressed sample blocks of mjd_tsdb (pure logic, no file I/O).
+ *
+ * @doc The bitstream is written MSB first. The payload bits after nbr_of_bits are always 0.
+ *
+ */
+
+// Component header file(s)
+#include "mjd.h"
+#include "mjd_tsdb.h"
+
+/**********
+ * Logging
+ */
+static const char TAG[] = "mjd_tsdb_block";
+
+#define _PAYLOAD_CAPACITY_BITS (MJD_TSDB_BLOCK_PAYLOAD_SIZE * 8)
+
+#define _HEADER(ptr_bytes) ((mjd_tsdb_block_header_t *) (ptr_bytes))
+#define _PAYLOAD(ptr_bytes) ((ptr_bytes) + sizeof(mjd_tsdb_block_header_t))
+
+/**********
+ * PRIVATE: BITS
+ */
+typedef struct {
+    uint8_t * ptr_payload;
+    uint32_t pos;
+    bool is_overflow;
+} _bit_writer_t;
+
+typedef struct {
+    const uint8_t * ptr_payload;
+    uint32_t pos;
+    uint32_t nbr_of_bits;
+    bool is_underflow;
+} _bit_reader_t;
+
+static void _put_bits(_bit_writer_t* param_ptr_writer, uint64_t param_value, uint32_t param_nbr_of_bits) {
+    if (param_ptr_writer->pos + param_nbr_of_bits > _PAYLOAD_CAPACITY_BITS) {
+        param_ptr_writer->is_overflow = true;
+        return;
+    }
+    while (param_nbr_of_bits > 0) {
+        uint32_t room = 8 - (param_ptr_writer->pos & 7);
+        uint32_t nbr = (param_nbr_of_bits < room) ? param_nbr_of_bits : room;
+        uint8_t chunk = (uint8_t) ((param_value >> (param_nbr_of_bits - nbr)) & ((1U << nbr) - 1));
+        param_ptr_writer->ptr_payload[param_ptr_writer->pos >> 3] |= (uint8_t) (chunk << (room - nbr));
+        param_ptr_writer->pos += nbr;
+        param_nbr_of_bits -= nbr;
+    }
+}
+
+static uint64_t _get_bits(_bit_reader_t* param_ptr_reader, uint32_t param_nbr_of_bits) {
+    uint64_t value = 0;
+
+    if (param_ptr_reader->pos + param_nbr_of_bits > param_ptr_reader->nbr_of_bits) {
+        param_ptr_reader->is_underflow = true;
+        return 0;
+    }
+    while (param_nbr_of_bits > 0) {
+        uint32_t room = 8 - (param_ptr_reader->pos & 7);
+        uint32_t nbr = (param_nbr_of_bits < room) ? param_nbr_of_bits : room;
+        uint8_t byte = param_ptr_reader->ptr_payload[param_ptr_reader->pos >> 3];
+        value = (value << nbr) | ((byte >> (room - nbr)) & ((1U << nbr) - 1));
+        param_ptr_reader->pos += nbr;
+        param_nbr_of_bits -= nbr;
+    }
+    return value;
+}
+
+static inline uint64_t _zigzag_encode(int64_t param_value) {
+    return ((uint64_t) param_value << 1) ^ (uint64_t) (param_value >> 63);
+}
+
+static inline int64_t _zigzag_decode(uint64_t param_value) {
+    return (int64_t) (param_value >> 1) ^ -(int64_t) (param_value & 1);
+}
+
+static inline uint32_t _float_to_bits(float param_value) {
+    uint32_t bits;
+    memcpy(&bits, &param_value, sizeof(bits));
+    return bits;
+}
+
+static inline float _bits_to_float(uint32_t param_bits) {
+    float value;
+    memcpy(&value, &param_bits, sizeof(value));
+    return value;
+}
+
+/*
+ * @doc Fletcher-16 of the block, the checksum field excluded.
+ */
+static uint16_t _checksum(const uint8_t * param_ptr_bytes) {
+    uint32_t sum1 = 0, sum2 = 0;
+
+    for (uint32_t idx = 0; idx < MJD_TSDB_BLOCK_SIZE; idx++) {
+        if (idx == offsetof(mjd_tsdb_block_header_t, checksum)) {
+            idx += sizeof(uint16_t) - 1;
+            continue;
+        }
+        sum1 = (sum1 + param_ptr_bytes[idx]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+    return (uint16_t) ((sum2 << 8) | sum1);
+}
+
+/**********
+ * PRIVATE: CODEC
+ */
+static void _encode_timestamp(_bit_writer_t* param_ptr_writer, mjd_tsdb_codec_state_t* param_ptr_state, int64_t param_timestamp_ms) {
+    int64_t delta = param_timestamp_ms - param_ptr_state->prev_timestamp_ms;
+    uint64_t zigzag = _zigzag_encode(delta - param_ptr_state->prev_delta_ms);
+
+    if (zigzag == 0) {
+        _put_bits(param_ptr_writer, 0x0, 1);
+    } else if (zigzag < (1ULL << 7)) {
+        _put_bits(param_ptr_writer, 0x2, 2);
+        _put_bits(param_ptr_writer, zigzag, 7);
+    } else if (zigzag < (1ULL << 9)) {
+        _put_bits(param_ptr_writer, 0x6, 3);
+        _put_bits(param_ptr_writer, zigzag, 9);
+    } else if (zigzag < (1ULL << 12)) {
+        _put_bits(param_ptr_writer, 0xE, 4);
+        _put_bits(param_ptr_writer, zigzag, 12);
+    } else {
+        _put_bits(param_ptr_writer, 0xF, 4);
+        _put_bits(param_ptr_writer, zigzag, 64);
+    }
+    param_ptr_state->prev_delta_ms = delta;
+    param_ptr_state->prev_timestamp_ms = param_timestamp_ms;
+}
+
+static int64_t _decode_timestamp(_bit_reader_t* param_ptr_reader, mjd_tsdb_codec_state_t* param_ptr_state) {
+    uint64_t zigzag = 0;
+
+    if (_get_bits(param_ptr_reader, 1) == 1) {
+        if (_get_bits(param_ptr_reader, 1) == 0) {
+            zigzag = _get_bits(param_ptr_reader, 7);
+        } else if (_get_bits(param_ptr_reader, 1) == 0) {
+            zigzag = _get_bits(param_ptr_reader, 9);
+        } else if (_get_bits(param_ptr_reader, 1) == 0) {
+            zigzag = _get_bits(param_ptr_reader, 12);
+        } else {
+            zigzag = _get_bits(param_ptr_reader, 64);
+        }
+    }
+    param_ptr_state->prev_delta_ms += _zigzag_decode(zigzag);
+    param_ptr_state->prev_timestamp_ms += param_ptr_state->prev_delta_ms;
+
+    return param_ptr_state->prev_timestamp_ms;
+}
+
+static void _encode_value(_bit_writer_t* param_ptr_writer, mjd_tsdb_codec_state_t* param_ptr_state, uint32_t param_idx, float param_value) {
+    uint32_t bits = _float_to_bits(param_value);
+    uint32_t xored = bits ^ param_ptr_state->prev_values[param_idx];
+
+    param_ptr_state->prev_values[param_idx] = bits;
+    if (xored == 0) {
+        _put_bits(param_ptr_writer, 0x0, 1);
+        return;
+    }
+
+    uint32_t leading = __builtin_clz(xored);
+    uint32_t trailing = __builtin_ctz(xored);
+    uint32_t prev_leading = param_ptr_state->prev_leading[param_idx];
+    uint32_t prev_meaningful = param_ptr_state->prev_meaningful[param_idx];
+
+    if (prev_meaningful != 0 && leading >= prev_leading && trailing >= 32 - prev_leading - prev_meaningful) {
+        // The meaningful bits fit in the previous window
+        _put_bits(param_ptr_writer, 0x2, 2);
+        _put_bits(param_ptr_writer, xored >> (32 - prev_leading - prev_meaningful), prev_meaningful);
+    } else {
+        uint32_t meaningful = 32 - leading - trailing;
+        _put_bits(param_ptr_writer, 0x3, 2);
+        _put_bits(param_ptr_writer, leading, 5);
+        _put_bits(param_ptr_writer, meaningful - 1, 5);
+        _put_bits(param_ptr_writer, xored >> trailing, meaningful);
+        param_ptr_state->prev_leading[param_idx] = (uint8_t) leading;
+        param_ptr_state->prev_meaningful[param_idx] = (uint8_t) meaningful;
+    }
+}
+
+static float _decode_value(_bit_reader_t* param_ptr_reader, mjd_tsdb_codec_state_t* param_ptr_state, uint32_t param_idx) {
+    if (_get_bits(param_ptr_reader, 1) == 1) {
+        uint32_t xored;
+        if (_get_bits(param_ptr_reader, 1) == 0) {
+            uint32_t leading = param_ptr_state->prev_leading[param_idx];
+            uint32_t meaningful = param_ptr_state->prev_meaningful[param_idx];
+            if (meaningful == 0) {
+                param_ptr_reader->is_underflow = true; // Corrupt
+                return 0;
+            }
+            xored = (uint32_t) _get_bits(param_ptr_reader, meaningful) << (32 - leading - meaningful);
+        } else {
+            uint32_t leading = (uint32_t) _get_bits(param_ptr_reader, 5);
+            uint32_t meaningful = (uint32_t) _get_bits(param_ptr_reader, 5) + 1;
+            if (leading + meaningful > 32) {
+                param_ptr_reader->is_underflow = true; // Corrupt
+                return 0;
+            }
+            xored = (uint32_t) _get_bits(param_ptr_reader, meaningful) << (32 - leading - meaningful);
+            param_ptr_state->prev_leading[param_idx] = (uint8_t) leading;
+            param_ptr_state->prev_meaningful[param_idx] = (uint8_t) meaningful;
+        }
+        param_ptr_state->prev_values[param_idx] ^= xored;
+    }
+    return _bits_to_float(param_ptr_state->prev_values[param_idx]);
+}
+
+/**********
+ * BLOCK ENCODER
+ */
+esp_err_t mjd_tsdb_block_init(mjd_tsdb_block_t* param_ptr_block, uint32_t param_seq, uint32_t param_nbr_of_values) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_nbr_of_values == 0 || param_nbr_of_values > MJD_TSDB_MAX_VALUES) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. nbr_of_values %u not in 1..%u | err %i (%s)", __FUNCTION__, param_nbr_of_values,
+                MJD_TSDB_MAX_VALUES, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    memset(param_ptr_block, 0, sizeof(*param_ptr_block));
+    param_ptr_block->nbr_of_values = param_nbr_of_values;
+    _HEADER(param_ptr_block->bytes)->magic = MJD_TSDB_BLOCK_MAGIC;
+    _HEADER(param_ptr_block->bytes)->seq = param_seq;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*
+ * @return ESP_ERR_INVALID_SIZE when the sample does not fit anymore: the block is unchanged (no logging: a full block is the
+ *         normal case, the caller starts the next block).
+ */
+esp_err_t mjd_tsdb_block_append(mjd_tsdb_block_t* param_ptr_block, const mjd_tsdb_sample_t* param_ptr_sample) {
+    mjd_tsdb_codec_state_t *ptr_state = &param_ptr_block->state;
+    mjd_tsdb_block_header_t *ptr_header = _HEADER(param_ptr_block->bytes);
+    mjd_tsdb_codec_state_t saved_state = *ptr_state;
+    _bit_writer_t writer = { .ptr_payload = _PAYLOAD(param_ptr_block->bytes), .pos = ptr_state->nbr_of_bits, .is_overflow = false };
+
+    if (ptr_state->nbr_of_samples >= UINT16_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (ptr_state->nbr_of_samples == 0) {
+        // The first sample is stored as is: its timestamp in the header, its values raw
+        ptr_state->prev_timestamp_ms = param_ptr_sample->timestamp_ms;
+        ptr_state->prev_delta_ms = 0;
+        for (uint32_t idx = 0; idx < param_ptr_block->nbr_of_values; idx++) {
+            ptr_state->prev_values[idx] = _float_to_bits(param_ptr_sample->values[idx]);
+            _put_bits(&writer, ptr_state->prev_values[idx], 32);
+        }
+    } else {
+        _encode_timestamp(&writer, ptr_state, param_ptr_sample->timestamp_ms);
+        for (uint32_t idx = 0; idx < param_ptr_block->nbr_of_values; idx++) {
+            _encode_value(&writer, ptr_state, idx, param_ptr_sample->values[idx]);
+        }
+    }
+
+    if (writer.is_overflow == true) {
+        // Roll back: clear the bits of the partial sample
+        uint8_t *ptr_payload = _PAYLOAD(param_ptr_block->bytes);
+        uint32_t pos = saved_state.nbr_of_bits;
+        if ((pos & 7) != 0) {
+            ptr_payload[pos >> 3] &= (uint8_t) (0xFF << (8 - (pos & 7)));
+            pos = (pos + 7) & ~7U;
+        }
+        memset(ptr_payload + (pos >> 3), 0, MJD_TSDB_BLOCK_PAYLOAD_SIZE - (pos >> 3));
+        *ptr_state = saved_state;
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    ptr_state->nbr_of_bits = writer.pos;
+    ++ptr_state->nbr_of_samples;
+
+    if (ptr_state->nbr_of_samples == 1) {
+        ptr_header->first_timestamp_ms = param_ptr_sample->timestamp_ms;
+    }
+    ptr_header->last_timestamp_ms = param_ptr_sample->timestamp_ms;
+    ptr_header->nbr_of_samples = (uint16_t) ptr_state->nbr_of_samples;
+    ptr_header->nbr_of_bits = (uint16_t) ptr_state->nbr_of_bits;
+
+    return ESP_OK;
+}
+
+/*
+ * @brief Set the flags and the checksum before the block is written.
+ */
+void mjd_tsdb_block_finalize(mjd_tsdb_block_t* param_ptr_block, uint8_t param_flags) {
+    mjd_tsdb_block_header_t *ptr_header = _HEADER(param_ptr_block->bytes);
+
+    ptr_header->flags = param_flags;
+    ptr_header->checksum = _checksum(param_ptr_block->bytes);
+}
+
+/*
+ * @return ESP_ERR_INVALID_CRC when the block is corrupt, ESP_ERR_NOT_FOUND when it is not a block (e.g. erased flash)
+ */
+esp_err_t mjd_tsdb_block_check(const uint8_t * param_ptr_bytes) {
+    const mjd_tsdb_block_header_t *ptr_header = (const mjd_tsdb_block_header_t *) param_ptr_bytes;
+
+    if (ptr_header->magic != MJD_TSDB_BLOCK_MAGIC) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (ptr_header->checksum != _checksum(param_ptr_bytes) || ptr_header->nbr_of_samples == 0
+            || ptr_header->nbr_of_bits > _PAYLOAD_CAPACITY_BITS) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    return ESP_OK;
+}
+
+/*
+ * @brief Continue to fill a block that was written before it was full (mjd_tsdb_open() after a flush).
+ */
+esp_err_t mjd_tsdb_block_restore(mjd_tsdb_block_t* param_ptr_block, const uint8_t * param_ptr_bytes, uint32_t param_nbr_of_values) {
+    esp_err_t f_retval = ESP_OK;
+
+    mjd_tsdb_block_reader_t reader;
+    mjd_tsdb_sample_t sample;
+
+    f_retval = mjd_tsdb_block_reader_init(&reader, param_ptr_bytes, param_nbr_of_values);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. mjd_tsdb_block_reader_init() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    while (mjd_tsdb_block_reader_next(&reader, &sample) == true) {
+    }
+    if (reader.state.nbr_of_samples != reader.nbr_of_samples) {
+        f_retval = ESP_ERR_INVALID_CRC;
+        ESP_LOGE(TAG, "%s(). ABORT. Decoded %u of %u samples | err %i (%s)", __FUNCTION__, reader.state.nbr_of_samples,
+                reader.nbr_of_samples, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    memcpy(param_ptr_block->bytes, param_ptr_bytes, MJD_TSDB_BLOCK_SIZE);
+    param_ptr_block->nbr_of_values = param_nbr_of_values;
+    param_ptr_block->state = reader.state;
+    param_ptr_block->state.nbr_of_bits = reader.nbr_of_bits;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/**********
+ * BLOCK READER
+ *
+ * @important The reader does not verify the checksum (the open block in RAM has none yet): use mjd_tsdb_block_check() for a block
+ *            that was read from flash.
+ */
+esp_err_t mjd_tsdb_block_reader_init(mjd_tsdb_block_reader_t* param_ptr_reader, const uint8_t * param_ptr_bytes,
+                                     uint32_t param_nbr_of_values) {
+    const mjd_tsdb_block_header_t *ptr_header = (const mjd_tsdb_block_header_t *) param_ptr_bytes;
+
+    if (param_nbr_of_values == 0 || param_nbr_of_values > MJD_TSDB_MAX_VALUES || ptr_header->magic != MJD_TSDB_BLOCK_MAGIC
+            || ptr_header->nbr_of_bits > _PAYLOAD_CAPACITY_BITS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(param_ptr_reader, 0, sizeof(*param_ptr_reader));
+    param_ptr_reader->ptr_bytes = param_ptr_bytes;
+    param_ptr_reader->nbr_of_values = param_nbr_of_values;
+    param_ptr_reader->nbr_of_samples = ptr_header->nbr_of_samples;
+    param_ptr_reader->nbr_of_bits = ptr_header->nbr_of_bits;
+    param_ptr_reader->state.prev_timestamp_ms = ptr_header->first_timestamp_ms;
+
+    return ESP_OK;
+}
+
+/*
+ * @return false at the end of the block, or when the bitstream is corrupt (state.nbr_of_samples < nbr_of_samples)
+ */
+bool mjd_tsdb_block_reader_next(mjd_tsdb_block_reader_t* param_ptr_reader, mjd_tsdb_sample_t* param_ptr_sample) {
+    mjd_tsdb_codec_state_t *ptr_state = &param_ptr_reader->state;
+    _bit_reader_t bits = { .ptr_payload = _PAYLOAD(param_ptr_reader->ptr_bytes), .pos = ptr_state->nbr_of_bits,
+                           .nbr_of_bits = param_ptr_reader->nbr_of_bits, .is_underflow = false };
+    mjd_tsdb_codec_state_t saved_state;
+
+    if (ptr_state->nbr_of_samples >= param_ptr_reader->nbr_of_samples) {
+        return false;
+    }
+
+    saved_state = *ptr_state;
+    if (ptr_state->nbr_of_samples == 0) {
+        param_ptr_sample->timestamp_ms = ptr_state->prev_timestamp_ms;
+        for (uint32_t idx = 0; idx < param_ptr_reader->nbr_of_values; idx++) {
+            ptr_state->prev_values[idx] = (uint32_t) _get_bits(&bits, 32);
+            param_ptr_sample->values[idx] = _bits_to_float(ptr_state->prev_values[idx]);
+        }
+    } else {
+        param_ptr_sample->timestamp_ms = _decode_timestamp(&bits, ptr_state);
+        for (uint32_t idx = 0; idx < param_ptr_reader->nbr_of_values; idx++) {
+            param_ptr_sample->values[idx] = _decode_value(&bits, ptr_state, idx);
+        }
+    }
+    if (bits.is_underflow == true) {
+        *ptr_state = saved_state;
+        return false;
+    }
+
+    ptr_state->nbr_of_bits = bits.pos;
+    ++ptr_state->nbr_of_samples;
+
+    return true;
+}
@@ -0,0 +1,385 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+#include "driver/timer.h"
+#include "esp_intr_alloc.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "soc/timer_group_struct.h"
+
+// Component header file(s)
+#include "mjd.h"
+#include "mjd_wifi_sniffer.h"
+
+/*
+ * Logging
+ */
+static const char TAG[] = "mjd_wifi_sniffer";
+
+/*
+ * Timer settings
+ *  @doc APB 80MHz / 80 = 1MHz: the counter counts microseconds.
+ */
+#define MY_TIMER_DIVIDER (80)
+
+/*
+ * 802.11 header
+ *  @doc frame control (2) + duration (2) + address 1 (6) + address 2 (6) + address 3 (6) + sequence control (2)
+ */
+#define MY_80211_HEADER_LEN         (24)
+#define MY_80211_SOURCE_MAC_OFFSET  (10)
+
+/*
+ * The sniffer
+ *  @doc The RX callback (WiFi task) is the producer of the channel queues, the app task that calls mjd_wifi_sniffer_receive() the consumer.
+ *       The hopper task owns the scheduler: the timer ISR only wakes it up because esp_wifi_set_channel() is not ISR safe.
+ */
+static mjd_wifi_sniffer_core_t _wifi_sniffer_core;
+static bool _wifi_sniffer_is_init = false;
+static volatile bool _wifi_sniffer_is_stopping = false;
+static SemaphoreHandle_t _wifi_sniffer_wakeup_semaphore = NULL;
+static TaskHandle_t _wifi_sniffer_hopper_task_handle = NULL;
+static intr_handle_t _wifi_sniffer_timer_isr_handle = NULL;
+
+/**************************************
+ * INTERRUPTS + CALLBACKS
+ *
+ */
+static inline timg_dev_t * _timer_group_dev(void) {
+    return (MJD_WIFI_SNIFFER_TIMER_GROUP_ID == TIMER_GROUP_0) ? &TIMERG0 : &TIMERG1;
+}
+
+/*
+ * @brief Timer ISR (one-shot alarm at the end of a dwell): wake up the hopper task.
+ */
+static void IRAM_ATTR _timer_isr(void* arg) {
+    timg_dev_t *ptr_timg = _timer_group_dev();
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    // Clear the interrupt. @doc The alarm is disabled by the hardware: the hopper task arms the next one
+    if (MJD_WIFI_SNIFFER_TIMER_ID == TIMER_0) {
+        ptr_timg->int_clr_timers.t0 = 1;
+    } else {
+        ptr_timg->int_clr_timers.t1 = 1;
+    }
+
+    if (_wifi_sniffer_hopper_task_handle != NULL) {
+        vTaskNotifyGiveFromISR(_wifi_sniffer_hopper_task_handle, &xHigherPriorityTaskWoken);
+    }
+    if (xHigherPriorityTaskWoken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+/*
+ * @brief Promiscuous RX callback (WiFi task): keep the 16 bytes that matter, never block.
+ */
+static void IRAM_ATTR _promiscuous_rx_cb(void *recv_buf, wifi_promiscuous_pkt_type_t type) {
+    const wifi_promiscuous_pkt_t *ptr_packet = (wifi_promiscuous_pkt_t *) recv_buf;
+    mjd_wifi_sniffer_frame_t frame;
+
+    if (ptr_packet->rx_ctrl.sig_len < MY_80211_HEADER_LEN) {
+        return;
+    }
+    memcpy(frame.source_mac, &ptr_packet->payload[MY_80211_SOURCE_MAC_OFFSET], sizeof(frame.source_mac));
+    frame.channel = ptr_packet->rx_ctrl.channel;
+    frame.rssi = ptr_packet->rx_ctrl.rssi;
+    frame.frame_control = ptr_packet->payload[0];
+    frame.timestamp_us = ptr_packet->rx_ctrl.timestamp;
+
+    if (mjd_wifi_sniffer_core_capture(&_wifi_sniffer_core, &frame) == true) {
+        xSemaphoreGive(_wifi_sniffer_wakeup_semaphore);
+    }
+}
+
+/**************************************
+ * HOPPER TASK
+ *
+ */
+static void _hopper_task(void *pvParameter) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval;
+    uint8_t channel;
+    uint32_t dwell_ms;
+    int64_t dwell_start_us = esp_timer_get_time();
+
+    while (_wifi_sniffer_is_stopping == false) {
+        int64_t now_us = esp_timer_get_time();
+        mjd_wifi_sniffer_core_next_hop(&_wifi_sniffer_core, (uint32_t) ((now_us - dwell_start_us) / 1000), &channel, &dwell_ms);
+        dwell_start_us = now_us;
+
+        f_retval = esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+        if (f_retval != ESP_OK) {
+            ESP_LOGE(TAG, "%s(). esp_wifi_set_channel(%u) | err %i (%s)", __FUNCTION__, channel, f_retval, esp_err_to_name(f_retval));
+        }
+
+        // ARM the one-shot alarm
+        timer_set_counter_value(MJD_WIFI_SNIFFER_TIMER_GROUP_ID, MJD_WIFI_SNIFFER_TIMER_ID, 00000000ULL);
+        timer_set_alarm_value(MJD_WIFI_SNIFFER_TIMER_GROUP_ID, MJD_WIFI_SNIFFER_TIMER_ID, (uint64_t) dwell_ms * 1000);
+        timer_set_alarm(MJD_WIFI_SNIFFER_TIMER_GROUP_ID, MJD_WIFI_SNIFFER_TIMER_ID, TIMER_ALARM_EN);
+
+        // WAIT for the timer ISR (or mjd_wifi_sniffer_deinit())
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+
+    _wifi_sniffer_hopper_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+/*********************************************************************************
+ * PUBLIC.
+ *
+ */
+
+/*
+ * @brief Start the promiscuous capture + the channel hopping.
+ *
+ * @important Call esp_wifi_init() + esp_wifi_set_mode(WIFI_MODE_STA) first.
+ */
+esp_err_t mjd_wifi_sniffer_init(const mjd_wifi_sniffer_config_t* param_ptr_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+    BaseType_t xReturned;
+
+    if (param_ptr_config == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid args | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    if (_wifi_sniffer_is_init == true) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. The sniffer was already init'd | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    f_retval = mjd_wifi_sniffer_core_init(&_wifi_sniffer_core, &param_ptr_config->hop_config);
+    if (f_retval != ESP_OK) {
+        // GOTO
+        goto cleanup;
+    }
+
+    // @doc Binary semaphores created using xSemaphoreCreateBinary() are created in a state such that the semaphore must first be 'given' before it can be 'taken'!
+    if (_wifi_sniffer_wakeup_semaphore == NULL) {
+        _wifi_sniffer_wakeup_semaphore = xSemaphoreCreateBinary();
+        if (_wifi_sniffer_wakeup_semaphore == NULL) {
+            f_retval = ESP_FAIL;
+            ESP_LOGE(TAG, "%s(). ABORT. xSemaphoreCreateBinary() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+    }
+
+    // TIMER: one-shot alarm (no auto reload), armed by the hopper task for each dwell
+    timer_config_t tconfig = {};
+    tconfig.divider = MY_TIMER_DIVIDER;
+    tconfig.counter_dir = TIMER_COUNT_UP;
+    tconfig.counter_en = TIMER_PAUSE;
+    tconfig.alarm_en = TIMER_ALARM_DIS;
+    tconfig.intr_type = TIMER_INTR_LEVEL;
+    tconfig.auto_reload = false;
+    f_retval = timer_init(MJD_WIFI_SNIFFER_TIMER_GROUP_ID, MJD_WIFI_SNIFFER_TIMER_ID, &tconfig);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. timer_init() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    timer_enable_intr(MJD_WIFI_SNIFFER_TIMER_GROUP_ID, MJD_WIFI_SNIFFER_TIMER_ID);
+    f_retval = timer_isr_register(MJD_WIFI_SNIFFER_TIMER_GROUP_ID, MJD_WIFI_SNIFFER_TIMER_ID, _timer_isr, NULL, ESP_INTR_FLAG_LEVEL1,
+            &_wifi_sniffer_timer_isr_handle);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. timer_isr_register() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // PROMISCUOUS
+    f_retval = esp_wifi_set_promiscuous(false);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. esp_wifi_set_promiscuous(false) | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    wifi_promiscuous_filter_t filter = { .filter_mask = param_ptr_config->filter_mask };
+    f_retval = esp_wifi_set_promiscuous_filter(&filter);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. esp_wifi_set_promiscuous_filter() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    f_retval = esp_wifi_set_promiscuous_rx_cb(_promiscuous_rx_cb);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. esp_wifi_set_promiscuous_rx_cb() | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    f_retval = esp_wifi_set_promiscuous(true);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. esp_wifi_set_promiscuous(true) | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // HOPPER TASK: it sets the first channel + arms the first alarm
+    _wifi_sniffer_is_stopping = false;
+    timer_start(MJD_WIFI_SNIFFER_TIMER_GROUP_ID, MJD_WIFI_SNIFFER_TIMER_ID);
+    xReturned = xTaskCreatePinnedToCore(&_hopper_task, "mjd_wifi_sniffer_hopper", MJD_WIFI_SNIFFER_HOPPER_TASK_STACK_SIZE, NULL,
+            param_ptr_config->hopper_task_priority, &_wifi_sniffer_hopper_task_handle, APP_CPU_NUM);
+    if (xReturned != pdPASS) {
+        f_retval = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "%s(). ABORT. Cannot create the hopper task | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        esp_wifi_set_promiscuous(false);
+        // GOTO
+        goto cleanup;
+    }
+
+    _wifi_sniffer_is_init = true;
+
+    ESP_LOGI(TAG, "%s(). %u channels, cycle %u ms, dwell %u..%u ms", __FUNCTION__, param_ptr_config->hop_config.nbr_of_channels,
+            param_ptr_config->hop_config.cycle_ms, param_ptr_config->hop_config.min_dwell_ms, param_ptr_config->hop_config.max_dwell_ms);
+
+    // LABEL
+    cleanup: ;
+
+    if (f_retval != ESP_OK && _wifi_sniffer_timer_isr_handle != NULL) {
+        timer_pause(MJD_WIFI_SNIFFER_TIMER_GROUP_ID, MJD_WIFI_SNIFFER_TIMER_ID);
+        timer_disable_intr(MJD_WIFI_SNIFFER_TIMER_GROUP_ID, MJD_WIFI_SNIFFER_TIMER_ID);
+        esp_intr_free(_wifi_sniffer_timer_isr_handle);
+        _wifi_sniffer_timer_isr_handle = NULL;
+    }
+
+    return f_retval;
+}
+
+esp_err_t mjd_wifi_sniffer_deinit(void) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (_wifi_sniffer_is_init == false) {
+        f_retval = ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "%s(). ABORT. The sniffer was not init'd | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // PROMISCUOUS
+    f_retval = esp_wifi_set_promiscuous(false);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). esp_wifi_set_promiscuous(false) | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+    }
+
+    // HOPPER TASK: wake it up + wait until it deleted itself
+    _wifi_sniffer_is_stopping = true;
+    xTaskNotifyGive(_wifi_sniffer_hopper_task_handle);
+    while (_wifi_sniffer_hopper_task_handle != NULL) {
+        vTaskDelay(RTOS_DELAY_10MILLISEC);
+    }
+
+    // TIMER
+    timer_pause(MJD_WIFI_SNIFFER_TIMER_GROUP_ID, MJD_WIFI_SNIFFER_TIMER_ID);
+    timer_disable_intr(MJD_WIFI_SNIFFER_TIMER_GROUP_ID, MJD_WIFI_SNIFFER_TIMER_ID);
+    esp_intr_free(_wifi_sniffer_timer_isr_handle);
+    _wifi_sniffer_timer_isr_handle = NULL;
+
+    _wifi_sniffer_is_init = false;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/*
+ * @brief Receive the next captured frame (round robin over the channels).
+ *
+ * @return
+ *     - ESP_OK A frame
+ *     - ESP_ERR_TIMEOUT No frame within param_ticks_to_wait
+ */
+esp_err_t mjd_wifi_sniffer_receive(mjd_wifi_sniffer_frame_t* param_ptr_frame, TickType_t param_ticks_to_wait) {
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_frame == NULL || _wifi_sniffer_wakeup_semaphore == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid args | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // @doc The semaphore is only a wakeup: a frame captured between the receive and the take gives it again, so nothing is missed.
+    while (mjd_wifi_sniffer_core_receive(&_wifi_sniffer_core, param_ptr_frame) == false) {
+        if (xSemaphoreTake(_wifi_sniffer_wakeup_semaphore, param_ticks_to_wait) != pdTRUE) {
+            f_retval = ESP_ERR_TIMEOUT;
+            // GOTO
+            goto cleanup;
+        }
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+esp_err_t mjd_wifi_sniffer_get_channel_stats(uint8_t param_channel, mjd_wifi_sniffer_channel_stats_t* param_ptr_stats) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_stats == NULL) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid args | err %i (%s)", __FUNCTION__, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    f_retval = mjd_wifi_sniffer_core_get_channel_stats(&_wifi_sniffer_core, param_channel, param_ptr_stats);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid channel %u | err %i (%s)", __FUNCTION__, param_channel, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+uint32_t mjd_wifi_sniffer_get_unique_devices(void) {
+    return mjd_wifi_sniffer_core_get_unique_devices(&_wifi_sniffer_core);
+}
+
+/*
+ * @brief Start a new window for the unique-device estimates.
+ *
+ * @important Call it from the consumer task (the task that calls mjd_wifi_sniffer_receive()).
+ */
+esp_err_t mjd_wifi_sniffer_reset_window(void) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    mjd_wifi_sniffer_core_reset_window(&_wifi_sniffer_core);
+
+    return ESP_OK;
+}
+
+void mjd_wifi_sniffer_log_stats(void) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    mjd_wifi_sniffer_channel_stats_t stats;
+
+    ESP_LOGI(TAG, "WiFi sniffer: unique devices ~%u | invalid frames %u", mjd_wifi_sniffer_get_unique_devices(),
+            _wifi_sniffer_core.nbr_of_invalid);
+    for (uint32_t idx = 0; idx < _wifi_sniffer_core.config.nbr_of_channels; idx++) {
+        uint8_t channel = _wifi_sniffer_core.config.channels[idx];
+        mjd_wifi_sniffer_core_get_channel_stats(&_wifi_sniffer_core, channel, &stats);
+        ESP_LOGI(TAG, "  CH %2u | frames %6u | drops %5u | rate %7.1f/s | unique ~%4u | dwell %4u ms (%u dwells, total %u ms)", channel,
+                stats.nbr_of_frames, stats.nbr_of_drops, stats.packet_rate, stats.nbr_of_unique_devices, stats.last_dwell_ms,
+                stats.nbr_of_dwells, stats.total_dwell_ms);
+    }
+}
@@ -0,0 +1,256 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+#include <math.h>
+
+// Component header file(s)
+#include "mjd.h"
+#include "mjd_wifi_sniffer_core.h"
+
+/*
+ * Logging
+ */
+static const char TAG[] = "mjd_wifi_sniffer_core";
+
+#define MY_QUEUE_MASK (CONFIG_MJD_WIFI_SNIFFER_QUEUE_LENGTH - 1)
+
+#if (CONFIG_MJD_WIFI_SNIFFER_QUEUE_LENGTH & MY_QUEUE_MASK) != 0
+#error "CONFIG_MJD_WIFI_SNIFFER_QUEUE_LENGTH must be a power of 2"
+#endif
+
+/**************************************
+ * UNIQUE DEVICES (linear counting)
+ */
+
+/*
+ * @brief The 64-bit finalizer of MurmurHash3: the MAC addresses of 1 vendor differ in the last bytes only.
+ */
+static inline uint32_t _hash_mac(const uint8_t * param_ptr_mac) {
+    uint64_t x = ((uint64_t) param_ptr_mac[0] << 40) | ((uint64_t) param_ptr_mac[1] << 32) | ((uint64_t) param_ptr_mac[2] << 24)
+            | ((uint64_t) param_ptr_mac[3] << 16) | ((uint64_t) param_ptr_mac[4] << 8) | (uint64_t) param_ptr_mac[5];
+
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+
+    return (uint32_t) x;
+}
+
+static inline void _bitmap_set(uint32_t * param_ptr_bitmap, uint32_t param_nbr_of_bits, uint32_t param_hash) {
+    uint32_t bit = param_hash & (param_nbr_of_bits - 1);
+    param_ptr_bitmap[bit / 32] |= (1UL << (bit % 32));
+}
+
+/*
+ * @brief n = -m * ln(zeros / m). A full bitmap returns m * ln(m) (saturated).
+ */
+uint32_t mjd_wifi_sniffer_estimate_unique(const uint32_t * param_ptr_bitmap, uint32_t param_nbr_of_bits) {
+    uint32_t nbr_of_zeros = 0;
+
+    for (uint32_t idx = 0; idx < param_nbr_of_bits / 32; idx++) {
+        nbr_of_zeros += 32 - __builtin_popcount(param_ptr_bitmap[idx]);
+    }
+    if (nbr_of_zeros == 0) {
+        nbr_of_zeros = 1;
+    }
+
+    return (uint32_t) (-(float) param_nbr_of_bits * logf((float) nbr_of_zeros / (float) param_nbr_of_bits) + 0.5f);
+}
+
+/**************************************
+ * INIT
+ */
+esp_err_t mjd_wifi_sniffer_core_init(mjd_wifi_sniffer_core_t* param_ptr_core, const mjd_wifi_sniffer_hop_config_t* param_ptr_config) {
+    ESP_LOGD(TAG, "%s()", __FUNCTION__);
+
+    esp_err_t f_retval = ESP_OK;
+
+    if (param_ptr_config->nbr_of_channels == 0 || param_ptr_config->nbr_of_channels > MJD_WIFI_SNIFFER_MAX_CHANNELS
+            || param_ptr_config->min_dwell_ms == 0 || param_ptr_config->max_dwell_ms < param_ptr_config->min_dwell_ms) {
+        f_retval = ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "%s(). ABORT. Invalid hop config (1..%u channels, 0 < min_dwell_ms <= max_dwell_ms) | err %i (%s)", __FUNCTION__,
+                MJD_WIFI_SNIFFER_MAX_CHANNELS, f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
+    for (uint32_t idx = 0; idx < param_ptr_config->nbr_of_channels; idx++) {
+        if (param_ptr_config->channels[idx] < 1 || param_ptr_config->channels[idx] > MJD_WIFI_SNIFFER_MAX_CHANNELS) {
+            f_retval = ESP_ERR_INVALID_ARG;
+            ESP_LOGE(TAG, "%s(). ABORT. Invalid channel %u | err %i (%s)", __FUNCTION__, param_ptr_config->channels[idx], f_retval,
+                    esp_err_to_name(f_retval));
+            // GOTO
+            goto cleanup;
+        }
+    }
+
+    memset(param_ptr_core, 0, sizeof(*param_ptr_core));
+    param_ptr_core->config = *param_ptr_config;
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
+}
+
+/**************************************
+ * PRODUCER + CONSUMER
+ */
+
+/*
+ * @brief Producer (the promiscuous RX callback). Never blocks.
+ *
+ * @return false when the frame was dropped (its queue is full, or the channel is invalid).
+ */
+bool IRAM_ATTR mjd_wifi_sniffer_core_capture(mjd_wifi_sniffer_core_t* param_ptr_core, const mjd_wifi_sniffer_frame_t* param_ptr_frame) {
+    mjd_wifi_sniffer_channel_t *ptr_channel;
+    uint32_t head, tail;
+
+    if (param_ptr_frame->channel < 1 || param_ptr_frame->channel > MJD_WIFI_SNIFFER_MAX_CHANNELS) {
+        param_ptr_core->nbr_of_invalid++;
+        return false;
+    }
+    ptr_channel = &param_ptr_core->channels[param_ptr_frame->channel - 1];
+    ptr_channel->nbr_of_frames++;
+
+    head = ptr_channel->queue.head;
+    tail = __atomic_load_n(&ptr_channel->queue.tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= CONFIG_MJD_WIFI_SNIFFER_QUEUE_LENGTH) {
+        ptr_channel->nbr_of_drops++;
+        return false;
+    }
+    ptr_channel->queue.frames[head & MY_QUEUE_MASK] = *param_ptr_frame;
+    __atomic_store_n(&ptr_channel->queue.head, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+/*
+ * @brief Consumer: the oldest frame of the next channel (round robin) that has one.
+ *
+ * @return false when all queues are empty.
+ */
+bool mjd_wifi_sniffer_core_receive(mjd_wifi_sniffer_core_t* param_ptr_core, mjd_wifi_sniffer_frame_t* param_ptr_frame) {
+    for (uint32_t nbr = 0; nbr < MJD_WIFI_SNIFFER_MAX_CHANNELS; nbr++) {
+        uint32_t idx = (param_ptr_core->next_receive_idx + nbr) % MJD_WIFI_SNIFFER_MAX_CHANNELS;
+        mjd_wifi_sniffer_channel_t *ptr_channel = &param_ptr_core->channels[idx];
+        uint32_t tail = ptr_channel->queue.tail;
+        uint32_t head = __atomic_load_n(&ptr_channel->queue.head, __ATOMIC_ACQUIRE);
+
+        if (head == tail) {
+            continue;
+        }
+        *param_ptr_frame = ptr_channel->queue.frames[tail & MY_QUEUE_MASK];
+        __atomic_store_n(&ptr_channel->queue.tail, tail + 1, __ATOMIC_RELEASE);
+        param_ptr_core->next_receive_idx = (idx + 1) % MJD_WIFI_SNIFFER_MAX_CHANNELS;
+
+        uint32_t hash = _hash_mac(param_ptr_frame->source_mac);
+        _bitmap_set(ptr_channel->unique_bitmap, MJD_WIFI_SNIFFER_UNIQUE_BITS_PER_CHANNEL, hash);
+        _bitmap_set(param_ptr_core->unique_total_bitmap, MJD_WIFI_SNIFFER_UNIQUE_BITS_TOTAL, hash >> 16);
+
+        return true;
+    }
+
+    return false;
+}
+
+/*
+ * @brief Consumer: start a new window for the unique-device estimates.
+ */
+void mjd_wifi_sniffer_core_reset_window(mjd_wifi_sniffer_core_t* param_ptr_core) {
+    for (uint32_t idx = 0; idx < MJD_WIFI_SNIFFER_MAX_CHANNELS; idx++) {
+        memset(param_ptr_core->channels[idx].unique_bitmap, 0, sizeof(param_ptr_core->channels[idx].unique_bitmap));
+    }
+    memset(param_ptr_core->unique_total_bitmap, 0, sizeof(param_ptr_core->unique_total_bitmap));
+}
+
+/**************************************
+ * HOP SCHEDULER
+ */
+static uint32_t _plan_dwell_ms(const mjd_wifi_sniffer_core_t* param_ptr_core, uint8_t param_channel) {
+    const mjd_wifi_sniffer_hop_config_t *ptr_config = &param_ptr_core->config;
+    uint32_t min_total_ms = ptr_config->nbr_of_channels * ptr_config->min_dwell_ms;
+    uint32_t share_ms = (ptr_config->cycle_ms > min_total_ms) ? ptr_config->cycle_ms - min_total_ms : 0;
+    uint64_t sum_of_weights = 0;
+    uint64_t dwell_ms;
+
+    for (uint32_t idx = 0; idx < ptr_config->nbr_of_channels; idx++) {
+        sum_of_weights += param_ptr_core->channels[ptr_config->channels[idx] - 1].rate_x16 + 16;
+    }
+    dwell_ms = ptr_config->min_dwell_ms
+            + (uint64_t) share_ms * (param_ptr_core->channels[param_channel - 1].rate_x16 + 16) / sum_of_weights;
+
+    return (dwell_ms > ptr_config->max_dwell_ms) ? ptr_config->max_dwell_ms : (uint32_t) dwell_ms;
+}
+
+/*
+ * @brief The hopper (at the end of a dwell): close the dwell on the current channel and plan the next one.
+ *        The first call starts the hopping (param_elapsed_ms is ignored).
+ *
+ * @param param_elapsed_ms The real time on the current channel (the timer and the channel switch add latency)
+ */
+void mjd_wifi_sniffer_core_next_hop(mjd_wifi_sniffer_core_t* param_ptr_core, uint32_t param_elapsed_ms, uint8_t * param_ptr_channel,
+                                    uint32_t * param_ptr_dwell_ms) {
+    mjd_wifi_sniffer_channel_t *ptr_channel;
+    uint8_t channel;
+
+    if (param_ptr_core->is_hopping == true) {
+        ptr_channel = &param_ptr_core->channels[param_ptr_core->config.channels[param_ptr_core->hop_idx] - 1];
+        if (param_elapsed_ms > 0) {
+            uint32_t nbr_of_frames = __atomic_load_n(&ptr_channel->nbr_of_frames, __ATOMIC_RELAXED) - ptr_channel->frames_at_dwell_start;
+            uint32_t rate_x16 = (uint32_t) ((uint64_t) nbr_of_frames * 16 * 1000 / param_elapsed_ms);
+            if (ptr_channel->nbr_of_dwells == 0) {
+                ptr_channel->rate_x16 = rate_x16;
+            } else {
+                ptr_channel->rate_x16 = (uint32_t) ((int32_t) ptr_channel->rate_x16 + ((int32_t) rate_x16 - (int32_t) ptr_channel->rate_x16) / 4);
+            }
+            ptr_channel->nbr_of_dwells++;
+            ptr_channel->total_dwell_ms += param_elapsed_ms;
+        }
+        param_ptr_core->hop_idx = (param_ptr_core->hop_idx + 1) % param_ptr_core->config.nbr_of_channels;
+    } else {
+        param_ptr_core->is_hopping = true;
+        param_ptr_core->hop_idx = 0;
+    }
+
+    channel = param_ptr_core->config.channels[param_ptr_core->hop_idx];
+    ptr_channel = &param_ptr_core->channels[channel - 1];
+    ptr_channel->frames_at_dwell_start = __atomic_load_n(&ptr_channel->nbr_of_frames, __ATOMIC_RELAXED);
+    ptr_channel->last_dwell_ms = _plan_dwell_ms(param_ptr_core, channel);
+
+    *param_ptr_channel = channel;
+    *param_ptr_dwell_ms = ptr_channel->last_dwell_ms;
+}
+
+/**************************************
+ * TELEMETRY
+ */
+esp_err_t mjd_wifi_sniffer_core_get_channel_stats(const mjd_wifi_sniffer_core_t* param_ptr_core, uint8_t param_channel,
+                                                  mjd_wifi_sniffer_channel_stats_t* param_ptr_stats) {
+    const mjd_wifi_sniffer_channel_t *ptr_channel;
+
+    if (param_channel < 1 || param_channel > MJD_WIFI_SNIFFER_MAX_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ptr_channel = &param_ptr_core->channels[param_channel - 1];
+
+    param_ptr_stats->nbr_of_frames = ptr_channel->nbr_of_frames;
+    param_ptr_stats->nbr_of_drops = ptr_channel->nbr_of_drops;
+    param_ptr_stats->packet_rate = ptr_channel->rate_x16 / 16.0f;
+    param_ptr_stats->nbr_of_unique_devices = mjd_wifi_sniffer_estimate_unique(ptr_channel->unique_bitmap,
+            MJD_WIFI_SNIFFER_UNIQUE_BITS_PER_CHANNEL);
+    param_ptr_stats->nbr_of_dwells = ptr_channel->nbr_of_dwells;
+    param_ptr_stats->total_dwell_ms = ptr_channel->total_dwell_ms;
+    param_ptr_stats->last_dwell_ms = ptr_channel->last_dwell_ms;
+
+    return ESP_OK;
+}
+
+/*
+ * @brief The unique devices of all channels (a device that was seen on several channels counts once).
+ */
+uint32_t mjd_wifi_sniffer_core_get_unique_devices(const mjd_wifi_sniffer_core_t* param_ptr_core) {
+    return mjd_wifi_sniffer_estimate_unique(param_ptr_core->unique_total_bitmap, MJD_WIFI_SNIFFER_UNIQUE_BITS_TOTAL);
+}
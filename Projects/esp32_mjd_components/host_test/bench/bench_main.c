@@ -0,0 +1,746 @@
+/*
+ * HOST BENCHMARKS: hot pure-logic paths of the mjd component library
+ *
+ * @doc Run `./mjd_host_bench` (Release build) before and after a change and diff the BENCH lines.
+ */
+#include "mjd.h"
+#include "esp_mqtt_inbox.h"
+#include "mjd_bme280.h"
+#include "mjd_http.h"
+#include "mjd_ledrgb.h"
+#include "mjd_ledrgb_effect.h"
+#include "mjd_lorap2p.h"
+#include "mjd_mqtt_trie.h"
+#include "mjd_neom8n.h"
+#include "mjd_neom8n_parser.h"
+#include "mjd_pool.h"
+#include "mjd_tsdb.h"
+#include "minmea.h"
+#include "pb_decode.h"
+#include "pb_encode.h"
+
+#include "mjd_bench.h"
+#include "mjd_host.h"
+#include "mjd_host_gps_log.h"
+
+#include <unistd.h>
+
+/*
+ * The sprintf()/strtoul() implementations of mjd v1 (the "before" numbers of the SWAR hex string functions).
+ */
+static void _legacy_uint8s_to_hexstring(const uint8_t * param_ptr_input, size_t param_len_input, char * param_ptr_output) {
+    uint32_t idx_src;
+    uint32_t idx_dst;
+    for (idx_src = 0, idx_dst = 0; idx_src < param_len_input; idx_src++, idx_dst += 2) {
+        sprintf((char*) param_ptr_output + idx_dst, "%02X", param_ptr_input[idx_src]);
+    }
+    param_ptr_output[idx_dst] = '\0';
+}
+
+static void _legacy_hexstring_to_uint8s(const char * param_ptr_input, size_t param_len_input, uint8_t * param_ptr_output) {
+    char hex_chars[3];
+    uint32_t idx_src, idx_dst;
+    for (idx_src = 0, idx_dst = 0; idx_src < param_len_input; idx_src += 2, idx_dst++) {
+        hex_chars[0] = *(param_ptr_input + idx_src);
+        hex_chars[1] = *(param_ptr_input + idx_src + 1);
+        hex_chars[2] = '\0';
+        param_ptr_output[idx_dst] = (uint8_t) strtoul(hex_chars, NULL, 16);
+    }
+}
+
+static void bench_hexstring(void) {
+    static uint8_t input[MJD_LORAP2P_TX_PAYLOAD_MAX_BYTES + MJD_LORAP2P_DATA_FRAME_HEADER_BYTES];
+    static char hexstring[2 * sizeof(input) + 1];
+    static uint8_t decoded[sizeof(input) + 1];
+
+    for (size_t idx = 0; idx < sizeof(input); idx++) {
+        input[idx] = (uint8_t) (idx * 7);
+    }
+
+    MJD_BENCH_RUN("hexstring encode legacy sprintf (LoRa frame)", 20000, sizeof(input), {
+        _legacy_uint8s_to_hexstring(input, sizeof(input), hexstring);
+        MJD_BENCH_KEEP(hexstring[0]);
+    });
+    MJD_BENCH_RUN("mjd_uint8s_to_hexstring (LoRa frame)", 200000, sizeof(input), {
+        mjd_uint8s_to_hexstring(input, sizeof(input), hexstring);
+        MJD_BENCH_KEEP(hexstring[0]);
+    });
+    MJD_BENCH_RUN("mjd_uint8s_to_hexstring_uart (LoRa frame)", 200000, sizeof(input), {
+        mjd_host_uart_clear_tx(UART_NUM_1);
+        mjd_uint8s_to_hexstring_uart(UART_NUM_1, input, sizeof(input));
+    });
+    MJD_BENCH_RUN("hexstring decode legacy strtoul (LoRa frame)", 20000, sizeof(input), {
+        _legacy_hexstring_to_uint8s(hexstring, 2 * sizeof(input), decoded);
+        MJD_BENCH_KEEP(decoded[0]);
+    });
+    MJD_BENCH_RUN("mjd_hexstring_to_uint8s (LoRa frame)", 200000, sizeof(input), {
+        mjd_hexstring_to_uint8s(hexstring, 2 * sizeof(input), decoded);
+        MJD_BENCH_KEEP(decoded[0]);
+    });
+}
+
+static void bench_strbuf(void) {
+    static char line[80];
+    static char payload[1024 + 1];
+    mjd_strbuf_t strbuf;
+    uint32_t counter = 0;
+    float distance_cm = 23.456f;
+
+    // An OLED line of the jsnsr04t app: "#%u:%6.2f cm"
+    MJD_BENCH_RUN("OLED line snprintf(\"#%u:%6.2f cm\")", 1000000, 0, {
+        snprintf(line, sizeof(line), "#%u:%6.2f cm", ++counter, distance_cm);
+        MJD_BENCH_KEEP(line[0]);
+    });
+    MJD_BENCH_RUN("OLED line mjd_strbuf", 1000000, 0, {
+        mjd_strbuf_init(&strbuf, line, sizeof(line));
+        mjd_strbuf_append_char(&strbuf, '#');
+        mjd_strbuf_append_uint(&strbuf, ++counter, 0);
+        mjd_strbuf_append_char(&strbuf, ':');
+        mjd_strbuf_append_float(&strbuf, distance_cm, 6, 2);
+        mjd_strbuf_append(&strbuf, " cm");
+        MJD_BENCH_KEEP(line[0]);
+    });
+
+    // The 1KB MQTT payload of mjd_components_main.c
+    MJD_BENCH_RUN("MQTT payload mjd_string_repeat() + malloc", 100000, sizeof(payload) - 1, {
+        char *ptr_repeated = mjd_string_repeat("-", sizeof(payload) - 1);
+        MJD_BENCH_KEEP(ptr_repeated[0]);
+        free(ptr_repeated);
+    });
+    MJD_BENCH_RUN("MQTT payload mjd_strbuf", 100000, sizeof(payload) - 1, {
+        mjd_strbuf_init(&strbuf, payload, sizeof(payload));
+        mjd_strbuf_append(&strbuf, "#");
+        mjd_strbuf_append_uint(&strbuf, ++counter, 0);
+        mjd_strbuf_repeat(&strbuf, "-", sizeof(payload) - 1 - mjd_strbuf_len(&strbuf));
+        MJD_BENCH_KEEP(payload[0]);
+    });
+}
+
+/*
+ * Allocation throughput: the station list entries of the WiFi device scanner (56 bytes on the ESP32).
+ * @doc "churn": 64 live objects, each iteration frees one pseudo-random slot and allocates it again.
+ */
+#define BENCH_POOL_BLOCK_SIZE (56)
+#define BENCH_POOL_NBR_OF_LIVE (64)
+
+MJD_POOL_DEFINE_STORAGE(_bench_pool_storage, BENCH_POOL_BLOCK_SIZE, BENCH_POOL_NBR_OF_LIVE);
+MJD_ARENA_DEFINE_STORAGE(_bench_arena_storage, BENCH_POOL_BLOCK_SIZE * BENCH_POOL_NBR_OF_LIVE);
+
+static void bench_pool(void) {
+    static void *live[BENCH_POOL_NBR_OF_LIVE];
+    mjd_pool_t pool;
+    mjd_arena_t arena;
+    uint32_t seed = 1;
+
+    mjd_pool_init(&pool, "bench", _bench_pool_storage, BENCH_POOL_BLOCK_SIZE, BENCH_POOL_NBR_OF_LIVE);
+    mjd_arena_init(&arena, "bench", _bench_arena_storage, sizeof(_bench_arena_storage));
+
+    MJD_BENCH_RUN("malloc+free (56 bytes)", 5000000, 0, {
+        void *ptr = malloc(BENCH_POOL_BLOCK_SIZE);
+        MJD_BENCH_KEEP(ptr);
+        free(ptr);
+    });
+    MJD_BENCH_RUN("mjd_pool_alloc+free (56 bytes)", 5000000, 0, {
+        void *ptr = mjd_pool_alloc(&pool);
+        MJD_BENCH_KEEP(ptr);
+        mjd_pool_free(&pool, ptr);
+    });
+
+    for (uint32_t idx = 0; idx < BENCH_POOL_NBR_OF_LIVE; idx++) {
+        live[idx] = malloc(BENCH_POOL_BLOCK_SIZE);
+    }
+    MJD_BENCH_RUN("malloc+free churn (64 live)", 5000000, 0, {
+        seed = seed * 1103515245 + 12345;
+        const uint32_t slot = (seed >> 16) % BENCH_POOL_NBR_OF_LIVE;
+        free(live[slot]);
+        live[slot] = malloc(BENCH_POOL_BLOCK_SIZE);
+        MJD_BENCH_KEEP(live[slot]);
+    });
+    for (uint32_t idx = 0; idx < BENCH_POOL_NBR_OF_LIVE; idx++) {
+        free(live[idx]);
+        live[idx] = mjd_pool_alloc(&pool);
+    }
+    MJD_BENCH_RUN("mjd_pool churn (64 live)", 5000000, 0, {
+        seed = seed * 1103515245 + 12345;
+        const uint32_t slot = (seed >> 16) % BENCH_POOL_NBR_OF_LIVE;
+        mjd_pool_free(&pool, live[slot]);
+        live[slot] = mjd_pool_alloc(&pool);
+        MJD_BENCH_KEEP(live[slot]);
+    });
+
+    MJD_BENCH_RUN("mjd_arena 64 allocs + reset", 200000, 0, {
+        for (uint32_t idx = 0; idx < BENCH_POOL_NBR_OF_LIVE; idx++) {
+            MJD_BENCH_KEEP(mjd_arena_alloc(&arena, BENCH_POOL_BLOCK_SIZE));
+        }
+        mjd_arena_reset(&arena);
+    });
+    MJD_BENCH_RUN("malloc 64 + free 64", 200000, 0, {
+        for (uint32_t idx = 0; idx < BENCH_POOL_NBR_OF_LIVE; idx++) {
+            live[idx] = malloc(BENCH_POOL_BLOCK_SIZE);
+        }
+        for (uint32_t idx = 0; idx < BENCH_POOL_NBR_OF_LIVE; idx++) {
+            free(live[idx]);
+        }
+    });
+}
+
+/*
+ * mjd_ledrgb: the v1 send path (double brightness multiply + one RMT item per bit in a buffer of 96 bytes per LED)
+ *             versus the LUT render + streaming translator.
+ */
+#define BENCH_LEDRGB_NBR_OF_LEDS (300)
+
+static void _legacy_ledrgb_transform(const mjd_ledrgb_led_t *param_ptr_leds, uint8_t param_brightness, uint8_t *param_ptr_buffer,
+                                     rmt_item32_t *param_ptr_items, const rmt_item32_t *param_ptr_pulse_pairs) {
+    for (uint32_t i = 0; i < BENCH_LEDRGB_NBR_OF_LEDS; i++) {
+        param_ptr_buffer[0 + (i * 3)] = (double) param_ptr_leds[i].g * param_brightness / 100.0;
+        param_ptr_buffer[1 + (i * 3)] = (double) param_ptr_leds[i].r * param_brightness / 100.0;
+        param_ptr_buffer[2 + (i * 3)] = (double) param_ptr_leds[i].b * param_brightness / 100.0;
+    }
+    rmt_item32_t *ptr_fill_rmt_item = param_ptr_items;
+    for (uint32_t j = 0; j < BENCH_LEDRGB_NBR_OF_LEDS * 3; j++) {
+        for (int8_t bit = 7; bit >= 0; --bit) {
+            *ptr_fill_rmt_item++ = param_ptr_pulse_pairs[(param_ptr_buffer[j] >> bit) & 0x01];
+        }
+    }
+    *ptr_fill_rmt_item++ = param_ptr_pulse_pairs[MJD_RMT_PULSE_TYPE_RESET];
+    *ptr_fill_rmt_item = param_ptr_pulse_pairs[MJD_RMT_PULSE_TYPE_END_MARKER];
+}
+
+static void bench_ledrgb(void) {
+    static mjd_ledrgb_led_t leds[BENCH_LEDRGB_NBR_OF_LEDS];
+    static uint8_t buffer[BENCH_LEDRGB_NBR_OF_LEDS * 3];
+    static rmt_item32_t items[2 + BENCH_LEDRGB_NBR_OF_LEDS * 24];
+    const rmt_item32_t pulse_pairs[MJD_RMT_PULSE_TYPE_MAX] =
+        { { { { 6, 1, 21, 0 } } }, { { { 21, 1, 6, 0 } } }, { { { 1, 0, 5800, 0 } } }, { { { 0, 0, 0, 0 } } } };
+
+    for (uint32_t idx = 0; idx < BENCH_LEDRGB_NBR_OF_LEDS; idx++) {
+        leds[idx] = mjd_led_rgb(idx, idx * 3, idx * 7);
+    }
+    MJD_BENCH_RUN("ledrgb v1 double+item buffer (300 LEDs)", 2000, BENCH_LEDRGB_NBR_OF_LEDS * 3, {
+        _legacy_ledrgb_transform(leds, 25, buffer, items, pulse_pairs);
+        MJD_BENCH_KEEP(items[100].val);
+    });
+
+    mjd_ledrgb_config_t config = MJD_LEDRGB_CONFIG_DEFAULT();
+    config.strip_id = MJD_STRIP_1;
+    config.gpio_num = GPIO_NUM_18;
+    config.led_type = MJD_LED_TYPE_WS2812B_V2017;
+    config.nbr_of_leds = BENCH_LEDRGB_NBR_OF_LEDS;
+    mjd_ledrgb_init(&config);
+    for (uint32_t idx = 0; idx < BENCH_LEDRGB_NBR_OF_LEDS; idx++) {
+        mjd_ledrgb_set_strip_led(MJD_STRIP_1, idx, leds[idx], false);
+    }
+    MJD_BENCH_RUN("ledrgb LUT+translator (300 LEDs)", 2000, BENCH_LEDRGB_NBR_OF_LEDS * 3, {
+        mjd_ledrgb_send_pixels_to_strip(MJD_STRIP_1);
+        MJD_BENCH_KEEP(mjd_host_rmt_get_tx_items(RMT_CHANNEL_0)[100].val);
+    });
+    mjd_ledrgb_deinit(MJD_STRIP_1);
+
+    const mjd_ledrgb_effect_t effect_palette =
+        { .type = MJD_LEDRGB_EFFECT_PALETTE, .ptr_palette = mjd_ledrgb_palette_rainbow, .period_frames = 1 };
+    uint32_t frame_nbr = 0;
+    MJD_BENCH_RUN("mjd_ledrgb_effect_render palette (300 LEDs)", 20000, BENCH_LEDRGB_NBR_OF_LEDS * 3, {
+        mjd_ledrgb_effect_render(&effect_palette, frame_nbr++, leds, BENCH_LEDRGB_NBR_OF_LEDS);
+        MJD_BENCH_KEEP(leds[7].g);
+    });
+}
+
+static void bench_lorap2p(void) {
+    static uint8_t payload[MJD_LORAP2P_TX_PAYLOAD_MAX_BYTES];
+    static uint8_t wire[MJD_LORAP2P_DATA_FRAME_HEADER_BYTES + MJD_LORAP2P_TX_PAYLOAD_MAX_BYTES];
+    mjd_lorap2p_data_frame_t frame = MJD_LORAP2P_DATA_FRAME_DEFAULT();
+    mjd_lorap2p_data_frame_t decoded = MJD_LORAP2P_DATA_FRAME_DEFAULT();
+    size_t len_wire = 0;
+
+    frame.len_payload = sizeof(payload);
+    frame.payload = payload;
+
+    MJD_BENCH_RUN("mjd_lorap2p_serialize_data_frame (max payload)", 200000, sizeof(wire), {
+        mjd_lorap2p_serialize_data_frame(&frame, wire, sizeof(wire), &len_wire);
+        MJD_BENCH_KEEP(len_wire);
+    });
+    MJD_BENCH_RUN("mjd_lorap2p_deserialize_data_frame (max payload)", 200000, sizeof(wire), {
+        mjd_lorap2p_deserialize_data_frame(wire, len_wire, &decoded);
+        MJD_BENCH_KEEP(decoded.payload);
+    });
+}
+
+static void bench_nanopb(void) {
+    uint8_t buffer[16];
+    uint64_t decoded = 0;
+
+    MJD_BENCH_RUN("pb_encode_varint + pb_decode_varint (u32 max)", 1000000, 0, {
+        pb_ostream_t ostream = pb_ostream_from_buffer(buffer, sizeof(buffer));
+        pb_encode_varint(&ostream, UINT32_MAX);
+        pb_istream_t istream = pb_istream_from_buffer(buffer, ostream.bytes_written);
+        pb_decode_varint(&istream, &decoded);
+        MJD_BENCH_KEEP(decoded);
+    });
+}
+
+/*
+ * mjd_bme280: one forced reading (T + P + H) per compensation mode. The calibration data of the data sheet example.
+ * @doc The host CPU has a double precision FPU; the ESP32 emulates doubles in software so the FLOAT/INT gap is much larger on target.
+ */
+static void bench_bme280(void) {
+    struct bme280_calib_data calib_data =
+        { .dig_T1 = 27504, .dig_T2 = 26435, .dig_T3 = -1000, .dig_P1 = 36477, .dig_P2 = -10685, .dig_P3 = 3024, .dig_P4 = 2855,
+          .dig_P5 = 140, .dig_P6 = -7, .dig_P7 = 15500, .dig_P8 = -14600, .dig_P9 = 6000, .dig_H1 = 75, .dig_H2 = 370, .dig_H3 = 0,
+          .dig_H4 = 313, .dig_H5 = 50, .dig_H6 = 30 };
+    struct bme280_uncomp_data uncomp_data =
+        { .pressure = 415148, .temperature = 519888, .humidity = 27000 };
+    mjd_bme280_data_t data;
+
+    MJD_BENCH_RUN("mjd_bme280_compensate FLOAT (T+P+H)", 1000000, 0, {
+        uncomp_data.temperature ^= 0x10;
+        mjd_bme280_compensate(MJD_BME280_COMPENSATION_FLOAT, &calib_data, &uncomp_data, &data);
+        MJD_BENCH_KEEP(data.pressure_centipascal);
+    });
+    MJD_BENCH_RUN("mjd_bme280_compensate INT32 (T+P+H)", 1000000, 0, {
+        uncomp_data.temperature ^= 0x10;
+        mjd_bme280_compensate(MJD_BME280_COMPENSATION_INT32, &calib_data, &uncomp_data, &data);
+        MJD_BENCH_KEEP(data.pressure_centipascal);
+    });
+    MJD_BENCH_RUN("mjd_bme280_compensate INT64 (T+P+H)", 1000000, 0, {
+        uncomp_data.temperature ^= 0x10;
+        mjd_bme280_compensate(MJD_BME280_COMPENSATION_INT64, &calib_data, &uncomp_data, &data);
+        MJD_BENCH_KEEP(data.pressure_centipascal);
+    });
+}
+
+static void bench_minmea(void) {
+    static const char sentence[] = "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47";
+    struct minmea_sentence_gga frame;
+
+    MJD_BENCH_RUN("minmea_check + minmea_parse_gga", 200000, sizeof(sentence) - 1, {
+        if (minmea_check(sentence, true)) {
+            minmea_parse_gga(&frame, sentence);
+        }
+        MJD_BENCH_KEEP(frame.fix_quality);
+    });
+}
+
+/*
+ * The line-by-line copy of the mjd_neom8n monitor task v1 (_get_next_line() + minmea_sentence_id()), made bounds-safe for UBX frames.
+ */
+static void _legacy_neom8n_lines(const uint8_t * param_ptr_buf, size_t param_len_buf, mjd_neom8n_data_t * param_ptr_data) {
+    static char line[MINMEA_MAX_LENGTH];
+    static size_t len_line = 0;
+
+    for (size_t i = 0; i < param_len_buf; i++) {
+        if (param_ptr_buf[i] != '\n') {
+            if (len_line < sizeof(line) - 1) {
+                line[len_line] = (char) param_ptr_buf[i];
+            }
+            len_line++;
+            continue;
+        }
+        if (len_line >= sizeof(line)) {
+            len_line = 0;
+            continue;
+        }
+        line[len_line] = '\0';
+        if (len_line > 0 && line[len_line - 1] == '\r') {
+            line[len_line - 1] = '\0';
+        }
+        len_line = 0;
+
+        switch (minmea_sentence_id(line, false)) {
+        case MINMEA_SENTENCE_RMC: {
+            struct minmea_sentence_rmc frame;
+            if (minmea_parse_rmc(&frame, line) == true) {
+                param_ptr_data->latitude = minmea_tocoord(&frame.latitude);
+                param_ptr_data->longitude = minmea_tocoord(&frame.longitude);
+            }
+            break;
+        }
+        case MINMEA_SENTENCE_GGA: {
+            struct minmea_sentence_gga frame;
+            if (minmea_parse_gga(&frame, line) == true) {
+                param_ptr_data->fix_quality = frame.fix_quality;
+                param_ptr_data->satellites_tracked = frame.satellites_tracked;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+static void bench_neom8n(void) {
+    // @doc The recorded log fed in chunks of 120 bytes (~ what uart_read_bytes() returns per call at 9600 Bd)
+    const size_t chunk_size = 120;
+    mjd_neom8n_parser_t parser;
+    mjd_neom8n_data_t data;
+
+    memset(&data, 0, sizeof(data));
+    mjd_neom8n_parser_init(&parser);
+
+    MJD_BENCH_RUN("neom8n legacy line copy + minmea_sentence_id (GPS log)", 2000, MJD_HOST_GPS_LOG_LENGTH, {
+        for (size_t offset = 0; offset < MJD_HOST_GPS_LOG_LENGTH; offset += chunk_size) {
+            size_t n = (MJD_HOST_GPS_LOG_LENGTH - offset < chunk_size) ? (MJD_HOST_GPS_LOG_LENGTH - offset) : chunk_size;
+            _legacy_neom8n_lines((const uint8_t *) mjd_host_gps_log + offset, n, &data);
+        }
+        MJD_BENCH_KEEP(data.satellites_tracked);
+    });
+    MJD_BENCH_RUN("mjd_neom8n_parser_feed zero-copy (GPS log)", 2000, MJD_HOST_GPS_LOG_LENGTH, {
+        for (size_t offset = 0; offset < MJD_HOST_GPS_LOG_LENGTH; offset += chunk_size) {
+            size_t n = (MJD_HOST_GPS_LOG_LENGTH - offset < chunk_size) ? (MJD_HOST_GPS_LOG_LENGTH - offset) : chunk_size;
+            mjd_neom8n_parser_feed(&parser, (const uint8_t *) mjd_host_gps_log + offset, n, &data);
+        }
+        MJD_BENCH_KEEP(data.satellites_tracked);
+    });
+
+    // UBX binary mode: the same 5 epochs as UBX-NAV-PVT only (the frames of the recorded log)
+    static uint8_t ubx_only[MJD_HOST_GPS_LOG_NBR_OF_UBX_NAV_PVT * (MJD_NEOM8N_UBX_NAV_PVT_PAYLOAD_LENGTH + MJD_NEOM8N_UBX_FRAME_OVERHEAD)];
+    const uint8_t *ptr_log = (const uint8_t *) mjd_host_gps_log;
+    size_t len_ubx_only = 0;
+    for (size_t i = 0; i + 3 < MJD_HOST_GPS_LOG_LENGTH; i++) {
+        if (ptr_log[i] == MJD_NEOM8N_UBX_SYNC_CHAR_1 && ptr_log[i + 1] == MJD_NEOM8N_UBX_SYNC_CHAR_2
+                && ptr_log[i + 2] == MJD_NEOM8N_UBX_CLASS_NAV && ptr_log[i + 3] == MJD_NEOM8N_UBX_ID_NAV_PVT) {
+            memcpy(&ubx_only[len_ubx_only], &ptr_log[i], MJD_NEOM8N_UBX_NAV_PVT_PAYLOAD_LENGTH + MJD_NEOM8N_UBX_FRAME_OVERHEAD);
+            len_ubx_only += MJD_NEOM8N_UBX_NAV_PVT_PAYLOAD_LENGTH + MJD_NEOM8N_UBX_FRAME_OVERHEAD;
+        }
+    }
+    MJD_BENCH_RUN("mjd_neom8n_parser_feed UBX-NAV-PVT only (same 5 epochs)", 20000, len_ubx_only, {
+        for (size_t offset = 0; offset < len_ubx_only; offset += chunk_size) {
+            size_t n = (len_ubx_only - offset < chunk_size) ? (len_ubx_only - offset) : chunk_size;
+            mjd_neom8n_parser_feed(&parser, ubx_only + offset, n, &data);
+        }
+        MJD_BENCH_KEEP(data.satellites_tracked);
+    });
+}
+
+/*
+ * MQTT inbound path: lwmqtt parses PUBLISH packets from an in-memory network (no broker, no sockets) and hands them to
+ *   - legacy: the esp_mqtt v1 handler (3 mallocs + queue) and the dispatch loop (callback + 3 frees).
+ *   - inbox: esp_mqtt_inbox_put() (1 copy into a preallocated slot) and the dispatch via the topic filter trie.
+ * @doc 1 message per iteration: messages/s = 1e9 / (ns/iter).
+ */
+#define BENCH_MQTT_NBR_OF_PACKETS (8)
+
+typedef struct {
+    uint8_t stream[BENCH_MQTT_NBR_OF_PACKETS * 128];
+    size_t len;
+    size_t pos;
+} bench_mqtt_network_t;
+
+typedef struct {
+    lwmqtt_string_t topic;
+    lwmqtt_message_t message;
+} bench_mqtt_legacy_event_t;
+
+static QueueHandle_t _bench_mqtt_legacy_queue;
+static esp_mqtt_inbox_t _bench_mqtt_inbox;
+static mjd_mqtt_trie_t _bench_mqtt_trie;
+static uint32_t _bench_mqtt_nbr_of_handled = 0;
+
+static lwmqtt_err_t _bench_mqtt_network_read(void *ref, uint8_t *buf, size_t len, size_t *read, uint32_t timeout) {
+    bench_mqtt_network_t *ptr_network = (bench_mqtt_network_t *) ref;
+    // The stream of packets repeats forever (a read never crosses the end: the packets are read whole)
+    if (ptr_network->pos == ptr_network->len) {
+        ptr_network->pos = 0;
+    }
+    memcpy(buf, &ptr_network->stream[ptr_network->pos], len);
+    ptr_network->pos += len;
+    *read = len;
+    return LWMQTT_SUCCESS;
+}
+
+static lwmqtt_err_t _bench_mqtt_network_write(void *ref, uint8_t *buf, size_t len, size_t *sent, uint32_t timeout) {
+    *sent = len;
+    return LWMQTT_SUCCESS;
+}
+
+static void _bench_mqtt_timer_set(void *ref, uint32_t timeout) {
+}
+
+static int32_t _bench_mqtt_timer_get(void *ref) {
+    return 1000;
+}
+
+/*
+ * @brief QoS0 PUBLISH: fixed header, topic (u16 length + bytes), payload.
+ */
+static void _bench_mqtt_append_publish(bench_mqtt_network_t *ptr_network, const char *topic, const char *payload) {
+    size_t topic_len = strlen(topic);
+    size_t payload_len = strlen(payload);
+    uint8_t *ptr = &ptr_network->stream[ptr_network->len];
+
+    *ptr++ = 0x30;
+    *ptr++ = (uint8_t) (2 + topic_len + payload_len); // < 128: 1 byte remaining length
+    *ptr++ = (uint8_t) (topic_len >> 8);
+    *ptr++ = (uint8_t) topic_len;
+    memcpy(ptr, topic, topic_len);
+    ptr += topic_len;
+    memcpy(ptr, payload, payload_len);
+    ptr += payload_len;
+    ptr_network->len = ptr - ptr_network->stream;
+}
+
+static void _bench_mqtt_legacy_handler(lwmqtt_client_t *client, void *ref, lwmqtt_string_t topic, lwmqtt_message_t msg) {
+    bench_mqtt_legacy_event_t *evt = malloc(sizeof(bench_mqtt_legacy_event_t));
+    evt->topic.len = topic.len;
+    evt->topic.data = malloc((size_t) topic.len + 1);
+    memcpy(evt->topic.data, topic.data, (size_t) topic.len);
+    evt->topic.data[topic.len] = 0;
+    evt->message.retained = msg.retained;
+    evt->message.qos = msg.qos;
+    evt->message.payload_len = msg.payload_len;
+    evt->message.payload = malloc((size_t) msg.payload_len + 1);
+    memcpy(evt->message.payload, msg.payload, (size_t) msg.payload_len);
+    evt->message.payload[msg.payload_len] = 0;
+    xQueueSend(_bench_mqtt_legacy_queue, &evt, 0);
+}
+
+static void _bench_mqtt_legacy_callback(const char *topic, uint8_t *payload, size_t len) {
+    _bench_mqtt_nbr_of_handled += payload[len - 1];
+}
+
+static void _bench_mqtt_legacy_dispatch(void) {
+    bench_mqtt_legacy_event_t *evt = NULL;
+    while (xQueueReceive(_bench_mqtt_legacy_queue, &evt, 0) == pdTRUE) {
+        _bench_mqtt_legacy_callback(evt->topic.data, evt->message.payload, evt->message.payload_len);
+        free(evt->topic.data);
+        free(evt->message.payload);
+        free(evt);
+    }
+}
+
+static void _bench_mqtt_inbox_handler(lwmqtt_client_t *client, void *ref, lwmqtt_string_t topic, lwmqtt_message_t msg) {
+    esp_mqtt_inbox_put(&_bench_mqtt_inbox, topic, msg, 0);
+}
+
+static void _bench_mqtt_inbox_callback_no_match(esp_mqtt_message_t *msg, void *ref) {
+    _bench_mqtt_nbr_of_handled += msg->payload[msg->payload_len - 1];
+}
+
+static void _bench_mqtt_inbox_callback(esp_mqtt_message_t *msg, void *ref) {
+    uint32_t mask = mjd_mqtt_trie_match(&_bench_mqtt_trie, msg->topic, msg->topic_len);
+    if (mask != 0) {
+        _bench_mqtt_nbr_of_handled += msg->payload[msg->payload_len - 1];
+    }
+}
+
+static void bench_mqtt_inbound(void) {
+    static uint8_t read_buf[256];
+    static uint8_t write_buf[256];
+    static const char *topics[] = { "mjd/lora/temperature", "mjd/lora/humidity", "mjd/wifi/rssi", "mjd/gps/fix" };
+    bench_mqtt_network_t network = { .len = 0, .pos = 0 };
+    lwmqtt_client_t client;
+
+    for (uint32_t i = 0; i < BENCH_MQTT_NBR_OF_PACKETS; i++) {
+        _bench_mqtt_append_publish(&network, topics[i % ARRAY_SIZE(topics)], "{\"value\":21.53,\"unit\":\"C\"}");
+    }
+
+    lwmqtt_init(&client, write_buf, sizeof(write_buf), read_buf, sizeof(read_buf));
+    lwmqtt_set_network(&client, &network, _bench_mqtt_network_read, _bench_mqtt_network_write);
+    lwmqtt_set_timers(&client, NULL, NULL, _bench_mqtt_timer_set, _bench_mqtt_timer_get);
+
+    _bench_mqtt_legacy_queue = xQueueCreate(8, sizeof(bench_mqtt_legacy_event_t *));
+    lwmqtt_set_callback(&client, NULL, _bench_mqtt_legacy_handler);
+    MJD_BENCH_RUN("MQTT inbound legacy 3x malloc + queue (msg)", 1000000, 0, {
+        lwmqtt_yield(&client, 0, 1000);
+        _bench_mqtt_legacy_dispatch();
+        MJD_BENCH_KEEP(_bench_mqtt_nbr_of_handled);
+    });
+
+    esp_mqtt_inbox_init(&_bench_mqtt_inbox, 8, 512, false);
+    mjd_mqtt_trie_init(&_bench_mqtt_trie);
+    mjd_mqtt_trie_insert(&_bench_mqtt_trie, "mjd/lora/+", 0);
+    mjd_mqtt_trie_insert(&_bench_mqtt_trie, "mjd/wifi/#", 1);
+    mjd_mqtt_trie_insert(&_bench_mqtt_trie, "mjd/gps/fix", 2);
+    lwmqtt_set_callback(&client, NULL, _bench_mqtt_inbox_handler);
+    MJD_BENCH_RUN("MQTT inbound inbox slot (msg)", 1000000, 0, {
+        lwmqtt_yield(&client, 0, 1000);
+        esp_mqtt_inbox_dispatch(&_bench_mqtt_inbox, _bench_mqtt_inbox_callback_no_match, NULL);
+        MJD_BENCH_KEEP(_bench_mqtt_nbr_of_handled);
+    });
+    MJD_BENCH_RUN("MQTT inbound inbox slot + trie dispatch (msg)", 1000000, 0, {
+        lwmqtt_yield(&client, 0, 1000);
+        esp_mqtt_inbox_dispatch(&_bench_mqtt_inbox, _bench_mqtt_inbox_callback, NULL);
+        MJD_BENCH_KEEP(_bench_mqtt_nbr_of_handled);
+    });
+    esp_mqtt_inbox_deinit(&_bench_mqtt_inbox);
+
+    uint32_t idx_topic = 0;
+    MJD_BENCH_RUN("mjd_mqtt_trie_match (3 filters)", 5000000, 0, {
+        const char *topic = topics[idx_topic++ & 3];
+        MJD_BENCH_KEEP(mjd_mqtt_trie_match(&_bench_mqtt_trie, topic, strlen(topic)));
+    });
+}
+
+/*
+ * mjd_tsdb on a file-backed image (a temporary directory instead of the SPIFFS partition).
+ *
+ * @doc A temperature with a 0.01 resolution every 10 seconds (1 value), and a BME280 (3 values). The compression ratio is
+ *      the raw size (int64 timestamp + float values) / the flash bytes per sample of the full blocks.
+ */
+static bool _bench_tsdb_query_handler(const mjd_tsdb_sample_t* param_ptr_sample, void * param_ptr_arg) {
+    ++*(uint32_t *) param_ptr_arg;
+    return true;
+}
+
+static void _bench_tsdb_sample(uint32_t param_idx, mjd_tsdb_sample_t* param_ptr_sample) {
+    param_ptr_sample->timestamp_ms = 1546300800000LL + (int64_t) param_idx * 10000 + ((param_idx % 61 == 0) ? 1 : 0);
+    param_ptr_sample->values[0] = roundf((21.0f + 2.0f * sinf(param_idx / 500.0f) + 0.05f * (float) (param_idx % 3)) * 100.0f) / 100.0f;
+    param_ptr_sample->values[1] = roundf((55.0f + 5.0f * cosf(param_idx / 700.0f)) * 10.0f) / 10.0f;
+    param_ptr_sample->values[2] = roundf((1013.0f + 3.0f * sinf(param_idx / 3000.0f)) * 100.0f) / 100.0f;
+    param_ptr_sample->values[3] = 0;
+}
+
+static void _bench_tsdb_run(const char * param_ptr_label, uint32_t param_nbr_of_values) {
+    char base_path[32] = "/tmp/tsdb.XXXXXX"; // The segment paths are max MJD_TSDB_PATH_MAX_LEN
+    char name[96];
+    mjd_tsdb_t tsdb;
+    mjd_tsdb_config_t config = MJD_TSDB_CONFIG_DEFAULT();
+    mjd_tsdb_stats_t stats;
+    mjd_tsdb_sample_t sample;
+    mjd_tsdb_sample_t batch[64];
+    mjd_tsdb_cursor_t cursor;
+    uint32_t idx_sample = 0;
+    uint32_t nbr_of_samples;
+    const uint32_t raw_bytes = sizeof(int64_t) + param_nbr_of_values * sizeof(float);
+
+    if (mkdtemp(base_path) == NULL) {
+        perror("mkdtemp");
+        return;
+    }
+    config.base_path = base_path;
+    config.nbr_of_values = param_nbr_of_values;
+    config.nbr_of_segments = 8;
+    config.blocks_per_segment = 32;
+    if (mjd_tsdb_open(&tsdb, &config) != ESP_OK) {
+        rmdir(base_path);
+        return;
+    }
+
+    snprintf(name, sizeof(name), "mjd_tsdb_append %s (sample)", param_ptr_label);
+    MJD_BENCH_RUN(name, 200000, raw_bytes, {
+        _bench_tsdb_sample(idx_sample++, &sample);
+        mjd_tsdb_append(&tsdb, &sample);
+    });
+
+    mjd_tsdb_get_stats(&tsdb, &stats);
+    snprintf(name, sizeof(name), "mjd_tsdb_read_since %s (%u samples)", param_ptr_label, stats.nbr_of_samples);
+    MJD_BENCH_RUN(name, 200, stats.nbr_of_samples * raw_bytes, {
+        mjd_tsdb_cursor_oldest(&tsdb, &cursor);
+        do {
+            mjd_tsdb_read_since(&tsdb, &cursor, batch, ARRAY_SIZE(batch), &nbr_of_samples);
+        } while (nbr_of_samples > 0);
+    });
+
+    uint32_t nbr_of_handled = 0;
+    int64_t to_ms = batch[0].timestamp_ms;
+    snprintf(name, sizeof(name), "mjd_tsdb_query %s 1 hour", param_ptr_label);
+    MJD_BENCH_RUN(name, 20000, 0, {
+        mjd_tsdb_query(&tsdb, to_ms - 3600000, to_ms, _bench_tsdb_query_handler, &nbr_of_handled, NULL);
+    });
+
+    mjd_tsdb_get_stats(&tsdb, &stats);
+    snprintf(name, sizeof(name), "mjd_tsdb compression %s", param_ptr_label);
+    printf("BENCH %-48s %10.2f bytes/sample (raw %u) ratio %.1fx, wear per segment %u..%u\n", name, stats.bytes_per_sample,
+           raw_bytes, stats.compression_ratio, stats.min_segment_recycles, stats.max_segment_recycles);
+
+    mjd_tsdb_close(&tsdb);
+    for (uint32_t idx = 0; idx < config.nbr_of_segments; idx++) {
+        snprintf(name, sizeof(name), "%s/%s.%u", base_path, config.name, idx);
+        unlink(name);
+    }
+    rmdir(base_path);
+}
+
+static void bench_tsdb(void) {
+    _bench_tsdb_run("1 value", 1);
+    _bench_tsdb_run("BME280 3 values", 3);
+}
+
+/*
+ * mjd_http: 1MB downloads from the local stand-in server (Content-Length vs chunked, keep-alive vs a new connection per request),
+ *           and 64 sensor data POSTs (sequential vs pipelined).
+ *
+ * @doc The loopback has no latency: the numbers show the CPU cost of the client (parsing, copies) and of the connects,
+ *      not the gain of pipelining over a real WiFi link (1 round trip per batch instead of 1 per request).
+ */
+static void _bench_http_download(const char * param_ptr_label, uint32_t param_chunk_size, bool param_is_keep_alive) {
+    static mjd_http_client_t client;
+    static uint8_t buf[4096];
+    mjd_host_http_server_config_t server_config = { .file_size = 1024 * 1024, .chunk_size = param_chunk_size };
+    mjd_http_config_t config = MJD_HTTP_CONFIG_DEFAULT();
+    mjd_http_benchmark_result_t result;
+    char name[96];
+
+    config.host = "127.0.0.1";
+    config.port = mjd_host_http_server_start(&server_config);
+    config.is_keep_alive = param_is_keep_alive;
+    if (config.port == 0 || mjd_http_init(&client, &config) != ESP_OK) {
+        return;
+    }
+    mjd_http_benchmark(&client, "/1MB.zip", 20, buf, sizeof(buf), &result);
+
+    snprintf(name, sizeof(name), "mjd_http GET 1MB %s", param_ptr_label);
+    printf("BENCH %-48s %10u req %10.0f KB/s TTFB %" PRIu64 "/%" PRIu64 "/%" PRIu64 " us connects %u heap peak %i delta %i\n", name,
+           result.nbr_of_requests - result.nbr_of_errors, result.kbytes_per_sec, result.ttfb_min_us, result.ttfb_avg_us,
+           result.ttfb_max_us, result.nbr_of_connects, result.heap_peak_max_bytes, result.heap_delta_sum_bytes);
+
+    mjd_http_deinit(&client);
+    mjd_host_http_server_stop();
+}
+
+static void _bench_http_post(uint32_t param_pipeline_depth) {
+    static mjd_http_client_t client;
+    mjd_host_http_server_config_t server_config = { .file_size = 0 };
+    mjd_http_config_t config = MJD_HTTP_CONFIG_DEFAULT();
+    char payloads[64][48];
+    mjd_http_body_t bodies[64];
+    int status_codes[64];
+    char name[96];
+
+    for (uint32_t idx = 0; idx < ARRAY_SIZE(bodies); idx++) {
+        snprintf(payloads[idx], sizeof(payloads[idx]), "{\"seq\":%u,\"t\":21.%02u,\"rh\":55.%u}", idx, idx, idx % 10);
+        bodies[idx].ptr_data = payloads[idx];
+        bodies[idx].len = strlen(payloads[idx]);
+    }
+    config.host = "127.0.0.1";
+    config.port = mjd_host_http_server_start(&server_config);
+    config.pipeline_depth = param_pipeline_depth;
+    if (config.port == 0 || mjd_http_init(&client, &config) != ESP_OK) {
+        return;
+    }
+
+    snprintf(name, sizeof(name), "mjd_http POST 64 samples pipeline depth %u", param_pipeline_depth);
+    MJD_BENCH_RUN(name, 200, 0, {
+        mjd_http_post_pipelined(&client, "/samples", "application/json", bodies, ARRAY_SIZE(bodies), status_codes);
+    });
+
+    mjd_http_deinit(&client);
+    mjd_host_http_server_stop();
+}
+
+static void bench_http(void) {
+    _bench_http_download("Content-Length keep-alive", 0, true);
+    _bench_http_download("Content-Length new connection", 0, false);
+    _bench_http_download("chunked 1KB keep-alive", 1024, true);
+    _bench_http_download("chunked 16 bytes keep-alive", 16, true);
+    _bench_http_post(1);
+    _bench_http_post(8);
+}
+
+int main(void) {
+    printf("MJD host benchmarks (nanoseconds measured on the host CPU; use for before/after comparisons only)\n");
+    bench_hexstring();
+    bench_strbuf();
+    bench_pool();
+    bench_ledrgb();
+    bench_lorap2p();
+    bench_nanopb();
+    bench_minmea();
+    bench_neom8n();
+    bench_bme280();
+    bench_mqtt_inbound();
+    bench_tsdb();
+    bench_http();
+    return 0;
+}
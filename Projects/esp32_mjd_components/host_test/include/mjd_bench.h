@@ -0,0 +1,62 @@
+/*
+ * HOST TEST HARNESS: micro-benchmark helper
+ *
+ * @doc Runs a body N times, timed with clock_gettime(CLOCK_MONOTONIC) in nanoseconds.
+ *      Prints one line per benchmark so the output can be diffed between two commits.
+ *
+ * @example
+ *      MJD_BENCH_RUN("mjd_uint8s_to_hexstring 64B", 100000, 64, {
+ *          mjd_uint8s_to_hexstring(input, 64, output);
+ *      });
+ *
+ * @important The host numbers are for relative comparisons (before/after a change). They are NOT ESP32 numbers.
+ */
+#ifndef __MJD_BENCH_H__
+#define __MJD_BENCH_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline uint64_t mjd_bench_get_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/*
+ * Prevent the compiler from optimizing away a computed value.
+ */
+#define MJD_BENCH_KEEP(value) __asm__ __volatile__("" : : "g"(value) : "memory")
+
+/*
+ * @param bytes_per_iter 0 when the throughput (bytes/ns) is not relevant
+ */
+#define MJD_BENCH_RUN(name, iterations, bytes_per_iter, body) do {                          \
+        const uint32_t _iterations = (iterations);                                           \
+        for (uint32_t _warmup = 0; _warmup < _iterations / 10 + 1; _warmup++) {              \
+            body                                                                             \
+        }                                                                                    \
+        const uint64_t _begin = mjd_bench_get_ns();                                           \
+        for (uint32_t _iter = 0; _iter < _iterations; _iter++) {                             \
+            body                                                                             \
+        }                                                                                    \
+        const uint64_t _ns = mjd_bench_get_ns() - _begin;                                   \
+        const double _ns_per_iter = (double) _ns / _iterations;                              \
+        if ((bytes_per_iter) > 0) {                                                          \
+            printf("BENCH %-48s %10u iter %12.1f ns/iter %10.3f bytes/ns\n", (name), _iterations, \
+                   _ns_per_iter, (double) (bytes_per_iter) / _ns_per_iter);                  \
+        } else {                                                                             \
+            printf("BENCH %-48s %10u iter %12.1f ns/iter\n", (name), _iterations, _ns_per_iter); \
+        }                                                                                    \
+    } while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_BENCH_H__ */
@@ -0,0 +1,112 @@
+/*
+ * HOST TEST HARNESS: control API of the ESP-IDF/FreeRTOS shims (tests only, not part of the ESP-IDF API)
+ *
+ */
+#ifndef __MJD_HOST_H__
+#define __MJD_HOST_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "driver/rmt.h"
+#include "driver/uart.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**********
+ * TIME
+ *
+ * @doc The simulated clock starts at 0 and only moves forward with vTaskDelay(), ets_delay_us() or mjd_host_advance_time_us().
+ */
+void mjd_host_reset(void);
+void mjd_host_advance_time_us(uint64_t param_us);
+uint64_t mjd_host_get_time_us(void);
+
+/**********
+ * TASKS
+ *
+ * @doc Tasks are not started on the host. mjd_host_run_task_at_next_delay() runs the task function (with its parameter) once, to
+ *      its end, inside the next vTaskDelay(): e.g. a task acknowledging a stop request while the stop function waits for it.
+ */
+void mjd_host_run_task_at_next_delay(TaskHandle_t param_task_handle);
+
+/**********
+ * GPIO
+ */
+void mjd_host_gpio_set_input(gpio_num_t param_gpio_num, uint32_t param_level);
+uint32_t mjd_host_gpio_get_output(gpio_num_t param_gpio_num);
+
+/**********
+ * I2C
+ *
+ * @doc A simulated slave is a register map of 256 bytes. mjd_host_i2c_set_registers() creates it on first use (max 4 slaves).
+ *      Reads from an address without a simulated slave return 0x00.
+ */
+void mjd_host_i2c_set_cmd_begin_retval(esp_err_t param_retval);
+uint32_t mjd_host_i2c_get_nbr_of_transactions(void);
+esp_err_t mjd_host_i2c_set_registers(uint8_t param_slave_addr, uint8_t param_reg_addr, const uint8_t *param_ptr_data, size_t param_len);
+esp_err_t mjd_host_i2c_get_registers(uint8_t param_slave_addr, uint8_t param_reg_addr, uint8_t *param_ptr_buf, size_t param_len);
+
+/**********
+ * UART
+ *
+ * @doc The TX capture buffer and the RX buffer are MJD_HOST_UART_BUFFER_SIZE bytes per port.
+ */
+#define MJD_HOST_UART_BUFFER_SIZE (4096)
+
+esp_err_t mjd_host_uart_inject_rx(uart_port_t param_uart_num, const uint8_t *param_ptr_data, size_t param_len);
+size_t mjd_host_uart_get_tx(uart_port_t param_uart_num, uint8_t *param_ptr_buf, size_t param_buf_len);
+void mjd_host_uart_clear_tx(uart_port_t param_uart_num);
+
+/**********
+ * RMT
+ */
+esp_err_t mjd_host_rmt_inject_rx_items(rmt_channel_t param_channel, const rmt_item32_t *param_ptr_items, size_t param_nbr_of_items);
+size_t mjd_host_rmt_get_nbr_of_tx_items(rmt_channel_t param_channel);
+const rmt_item32_t * mjd_host_rmt_get_tx_items(rmt_channel_t param_channel);
+
+/**********
+ * NVS (see shims/include/nvs.h)
+ *
+ * @doc mjd_host_nvs_set_write_retval() makes every nvs_set_*() fail with that error (e.g. ESP_ERR_NVS_NOT_ENOUGH_SPACE) until it
+ *      is set back to ESP_OK.
+ */
+void mjd_host_nvs_set_write_retval(esp_err_t param_retval);
+uint32_t mjd_host_nvs_get_nbr_of_entries_written(void);
+uint32_t mjd_host_nvs_get_nbr_of_commits(void);
+
+/**********
+ * HTTP STAND-IN SERVER (see shims/src/host_http_server.c)
+ *
+ * @doc A real HTTP/1.1 server on 127.0.0.1 (a thread) for the mjd_http tests and benchmarks. mjd_host_http_server_start() returns
+ *      the ephemeral port (0 = failed). GET = a generated file of file_size bytes: byte i = mjd_host_http_server_file_byte(i).
+ * @important mjd_host_reset() does not stop it: call mjd_host_http_server_stop().
+ */
+typedef struct {
+    uint32_t file_size;
+    uint32_t chunk_size;                  /*!< 0 = Content-Length, else Transfer-Encoding: chunked with chunks of this size */
+    uint32_t max_requests_per_connection; /*!< 0 = unlimited. The last response says "Connection: close" */
+    bool is_range_supported;              /*!< false = a Range header is ignored (200 + the whole file) */
+} mjd_host_http_server_config_t;
+
+uint16_t mjd_host_http_server_start(const mjd_host_http_server_config_t* param_ptr_config);
+void mjd_host_http_server_stop(void);
+uint8_t mjd_host_http_server_file_byte(uint64_t param_offset);
+uint32_t mjd_host_http_server_get_nbr_of_connections(void);
+uint32_t mjd_host_http_server_get_nbr_of_requests(void);
+uint32_t mjd_host_http_server_get_nbr_of_posts(void);
+uint64_t mjd_host_http_server_get_bytes_posted(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_HOST_H__ */
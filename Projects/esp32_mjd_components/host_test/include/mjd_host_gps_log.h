@@ -0,0 +1,121 @@
+/*
+ * HOST TEST DATA: a recorded byte stream of the u-blox NEO-M8N GPS device (UART1 9600 Bd, default NMEA output + UBX-NAV-PVT enabled)
+ *
+ * @doc 5 measurement epochs at 1Hz. Epoch 1 has no fix; epochs 2..5 have a 3D fix (moving north at 1.5 m/s).
+ * @doc NMEA sentences and UBX frames are interleaved. The UBX bytes are split in separate string literals (no hex escape runs into the next char).
+ * @important Contains 0x00 bytes: use MJD_HOST_GPS_LOG_LENGTH, not strlen().
+ */
+#ifndef __MJD_HOST_GPS_LOG_H__
+#define __MJD_HOST_GPS_LOG_H__
+
+#include <stdint.h>
+
+#define MJD_HOST_GPS_LOG_NBR_OF_NMEA_SENTENCES (56)
+#define MJD_HOST_GPS_LOG_NBR_OF_UBX_FRAMES (6)
+#define MJD_HOST_GPS_LOG_NBR_OF_UBX_NAV_PVT (5)
+#define MJD_HOST_GPS_LOG_NBR_OF_EPOCHS (5)
+
+static const char mjd_host_gps_log[] =
+    "$GNTXT,01,01,02,u-blox AG - www.u-blox.com*4E\r\n"
+    /* UBX-ACK-ACK (CFG-MSG) */
+    "\xB5""\x62""\x05""\x01""\x02""\x00""\x06""\x01""\x0F""\x38"
+    "$GNRMC,141645.00,V,,,,,,,140319,,,N*6E\r\n"
+    "$GNVTG,,,,,,,,,N*2E\r\n"
+    "$GNGGA,141645.00,,,,,0,00,99.99,,,,,,*7B\r\n"
+    "$GNGSA,A,1,,,,,,,,,,,,,99.99,99.99,99.99*2E\r\n"
+    "$GNGSA,A,1,,,,,,,,,,,,,99.99,99.99,99.99*2E\r\n"
+    "$GPGSV,3,1,10,02,12,315,,12,55,267,31,15,31,068,28,19,09,190,22*75\r\n"
+    "$GPGSV,3,2,10,24,68,132,35,25,35,234,30,29,05,021,,32,02,330,*7E\r\n"
+    "$GPGSV,3,3,10,40,08,120,,41,11,210,*71\r\n"
+    "$GLGSV,2,1,06,70,21,312,18,71,48,028,27,72,25,091,26,86,40,189,29*67\r\n"
+    "$GLGSV,2,2,06,87,61,286,32,88,18,317,*6A\r\n"
+    "$GNGLL,,,,,141645.00,V,N*57\r\n"
+    /* UBX-NAV-PVT no fix */
+    "\xB5""\x62""\x01""\x07""\x5C""\x00""\xC8""\x18""\x5D""\x0D""\xE3""\x07""\x03""\x0E""\x0E""\x10"
+    "\x2D""\x30""\xFF""\xFF""\xFF""\xFF""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00"
+    "\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\xFF""\xFF"
+    "\xFF""\xFF""\x71""\x38""\x39""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00"
+    "\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x80""\x96""\x98""\x00""\xF0""\xB9"
+    "\xF5""\x05""\x0F""\x27""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00"
+    "\x00""\x00""\x85""\x52"
+    "$GNRMC,141646.00,A,6626.63658,N,03347.50630,E,2.916,0.00,140319,,,A*7B\r\n"
+    "$GNVTG,0.00,T,,M,2.916,N,5.400,K,A*2E\r\n"
+    "$GNGGA,141646.00,6626.63658,N,03347.50630,E,1,10,0.94,9.0,M,16.1,M,,*48\r\n"
+    "$GNGSA,A,3,15,24,12,19,25,,,,,,,,1.61,0.94,1.31*1A\r\n"
+    "$GNGSA,A,3,71,72,86,87,70,,,,,,,,1.61,0.94,1.31*11\r\n"
+    "$GPGSV,3,1,10,02,12,315,,12,55,267,31,15,31,068,28,19,09,190,22*75\r\n"
+    "$GPGSV,3,2,10,24,68,132,35,25,35,234,30,29,05,021,,32,02,330,*7E\r\n"
+    "$GPGSV,3,3,10,40,08,120,,41,11,210,*71\r\n"
+    "$GLGSV,2,1,06,70,21,312,18,71,48,028,27,72,25,091,26,86,40,189,29*67\r\n"
+    "$GLGSV,2,2,06,87,61,286,32,88,18,317,*6A\r\n"
+    "$GNGLL,6626.63658,N,03347.50630,E,141646.00,A,A*7E\r\n"
+    /* UBX-NAV-PVT 3D fix, 10 SV */
+    "\xB5""\x62""\x01""\x07""\x5C""\x00""\xB0""\x1C""\x5D""\x0D""\xE3""\x07""\x03""\x0E""\x0E""\x10"
+    "\x2E""\x37""\x32""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x03""\x01""\xEA""\x0A""\x15""\x37"
+    "\x24""\x14""\x86""\x8A""\x9A""\x27""\x0C""\x62""\x00""\x00""\x28""\x23""\x00""\x00""\x66""\x08"
+    "\x00""\x00""\x48""\x0D""\x00""\x00""\xDC""\x05""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00"
+    "\x00""\x00""\xDC""\x05""\x00""\x00""\x00""\x00""\x00""\x00""\xE0""\x01""\x00""\x00""\x10""\x91"
+    "\x18""\x00""\xA1""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00"
+    "\x00""\x00""\x10""\x71"
+    "$GNRMC,141647.00,A,6626.63739,N,03347.50630,E,2.916,0.00,140319,,,A*7C\r\n"
+    "$GNVTG,0.00,T,,M,2.916,N,5.400,K,A*2E\r\n"
+    "$GNGGA,141647.00,6626.63739,N,03347.50630,E,1,09,0.94,9.1,M,16.1,M,,*46\r\n"
+    "$GNGSA,A,3,15,24,12,19,25,,,,,,,,1.61,0.94,1.31*1A\r\n"
+    "$GNGSA,A,3,71,72,86,87,,,,,,,,,1.61,0.94,1.31*16\r\n"
+    "$GPGSV,3,1,10,02,12,315,,12,55,267,31,15,31,068,28,19,09,190,22*75\r\n"
+    "$GPGSV,3,2,10,24,68,132,35,25,35,234,30,29,05,021,,32,02,330,*7E\r\n"
+    "$GPGSV,3,3,10,40,08,120,,41,11,210,*71\r\n"
+    "$GLGSV,2,1,06,70,21,312,18,71,48,028,27,72,25,091,26,86,40,189,29*67\r\n"
+    "$GLGSV,2,2,06,87,61,286,32,88,18,317,*6A\r\n"
+    "$GNGLL,6626.63739,N,03347.50630,E,141647.00,A,A*79\r\n"
+    /* UBX-NAV-PVT 3D fix, 9 SV */
+    "\xB5""\x62""\x01""\x07""\x5C""\x00""\x98""\x20""\x5D""\x0D""\xE3""\x07""\x03""\x0E""\x0E""\x10"
+    "\x2F""\x37""\x32""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x03""\x01""\xEA""\x09""\x15""\x37"
+    "\x24""\x14""\x0D""\x8B""\x9A""\x27""\x70""\x62""\x00""\x00""\x8C""\x23""\x00""\x00""\x66""\x08"
+    "\x00""\x00""\x48""\x0D""\x00""\x00""\xDC""\x05""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00"
+    "\x00""\x00""\xDC""\x05""\x00""\x00""\x00""\x00""\x00""\x00""\xE0""\x01""\x00""\x00""\x10""\x91"
+    "\x18""\x00""\xA1""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00"
+    "\x00""\x00""\x4C""\x99"
+    "$GNRMC,141648.00,A,6626.63820,N,03347.50630,E,2.916,0.00,140319,,,A*74\r\n"
+    "$GNVTG,0.00,T,,M,2.916,N,5.400,K,A*2E\r\n"
+    "$GNGGA,141648.00,6626.63820,N,03347.50630,E,1,10,0.94,9.2,M,16.1,M,,*45\r\n"
+    "$GNGSA,A,3,15,24,12,19,25,,,,,,,,1.61,0.94,1.31*1A\r\n"
+    "$GNGSA,A,3,71,72,86,87,70,,,,,,,,1.61,0.94,1.31*11\r\n"
+    "$GPGSV,3,1,10,02,12,315,,12,55,267,31,15,31,068,28,19,09,190,22*75\r\n"
+    "$GPGSV,3,2,10,24,68,132,35,25,35,234,30,29,05,021,,32,02,330,*7E\r\n"
+    "$GPGSV,3,3,10,40,08,120,,41,11,210,*71\r\n"
+    "$GLGSV,2,1,06,70,21,312,18,71,48,028,27,72,25,091,26,86,40,189,29*67\r\n"
+    "$GLGSV,2,2,06,87,61,286,32,88,18,317,*6A\r\n"
+    "$GNGLL,6626.63820,N,03347.50630,E,141648.00,A,A*71\r\n"
+    /* UBX-NAV-PVT 3D fix, 10 SV */
+    "\xB5""\x62""\x01""\x07""\x5C""\x00""\x80""\x24""\x5D""\x0D""\xE3""\x07""\x03""\x0E""\x0E""\x10"
+    "\x30""\x37""\x32""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x03""\x01""\xEA""\x0A""\x15""\x37"
+    "\x24""\x14""\x93""\x8B""\x9A""\x27""\xD4""\x62""\x00""\x00""\xF0""\x23""\x00""\x00""\x66""\x08"
+    "\x00""\x00""\x48""\x0D""\x00""\x00""\xDC""\x05""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00"
+    "\x00""\x00""\xDC""\x05""\x00""\x00""\x00""\x00""\x00""\x00""\xE0""\x01""\x00""\x00""\x10""\x91"
+    "\x18""\x00""\xA1""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00"
+    "\x00""\x00""\x88""\xCC"
+    "$GNRMC,141649.00,A,6626.63901,N,03347.50630,E,2.916,0.00,140319,,,A*77\r\n"
+    "$GNVTG,0.00,T,,M,2.916,N,5.400,K,A*2E\r\n"
+    "$GNGGA,141649.00,6626.63901,N,03347.50630,E,1,09,0.94,9.3,M,16.1,M,,*4F\r\n"
+    "$GNGSA,A,3,15,24,12,19,25,,,,,,,,1.61,0.94,1.31*1A\r\n"
+    "$GNGSA,A,3,71,72,86,87,,,,,,,,,1.61,0.94,1.31*16\r\n"
+    "$GPGSV,3,1,10,02,12,315,,12,55,267,31,15,31,068,28,19,09,190,22*75\r\n"
+    "$GPGSV,3,2,10,24,68,132,35,25,35,234,30,29,05,021,,32,02,330,*7E\r\n"
+    "$GPGSV,3,3,10,40,08,120,,41,11,210,*71\r\n"
+    "$GLGSV,2,1,06,70,21,312,18,71,48,028,27,72,25,091,26,86,40,189,29*67\r\n"
+    "$GLGSV,2,2,06,87,61,286,32,88,18,317,*6A\r\n"
+    "$GNGLL,6626.63901,N,03347.50630,E,141649.00,A,A*72\r\n"
+    /* UBX-NAV-PVT 3D fix, 9 SV */
+    "\xB5""\x62""\x01""\x07""\x5C""\x00""\x68""\x28""\x5D""\x0D""\xE3""\x07""\x03""\x0E""\x0E""\x10"
+    "\x31""\x37""\x32""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x03""\x01""\xEA""\x09""\x15""\x37"
+    "\x24""\x14""\x1A""\x8C""\x9A""\x27""\x38""\x63""\x00""\x00""\x54""\x24""\x00""\x00""\x66""\x08"
+    "\x00""\x00""\x48""\x0D""\x00""\x00""\xDC""\x05""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00"
+    "\x00""\x00""\xDC""\x05""\x00""\x00""\x00""\x00""\x00""\x00""\xE0""\x01""\x00""\x00""\x10""\x91"
+    "\x18""\x00""\xA1""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00""\x00"
+    "\x00""\x00""\xC6""\x66"
+    ;
+
+#define MJD_HOST_GPS_LOG_LENGTH (sizeof(mjd_host_gps_log) - 1)
+
+#endif /* __MJD_HOST_GPS_LOG_H__ */
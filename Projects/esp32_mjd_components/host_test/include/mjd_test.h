@@ -0,0 +1,103 @@
+/*
+ * HOST TEST HARNESS: minimal unit test macros (no external framework, plain C99)
+ *
+ * @example
+ *      static void test_bcd(void) {
+ *          MJD_TEST_ASSERT_EQUAL_UINT(0x59, mjd_byte_to_bcd(59));
+ *      }
+ *
+ *      int main(void) {
+ *          MJD_TEST_RUN(test_bcd);
+ *          return MJD_TEST_REPORT();
+ *      }
+ *
+ * @doc A failed assertion logs the location and returns from the test function; the next test still runs.
+ *      mjd_host_reset() is called before each test so the simulated clock and the driver shims start clean.
+ */
+#ifndef __MJD_TEST_H__
+#define __MJD_TEST_H__
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "mjd_host.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static unsigned int _mjd_test_nbr_of_tests = 0;
+static unsigned int _mjd_test_nbr_of_failures = 0;
+static int _mjd_test_current_failed = 0;
+
+#define _MJD_TEST_FAIL(fmt, ...) do {                                                   \
+        fprintf(stderr, "    FAIL %s:%d: " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__); \
+        _mjd_test_current_failed = 1;                                                   \
+        return;                                                                         \
+    } while (0)
+
+#define MJD_TEST_ASSERT(cond) do {                                                      \
+        if (!(cond)) {                                                                  \
+            _MJD_TEST_FAIL("%s", #cond);                                                \
+        }                                                                               \
+    } while (0)
+
+#define MJD_TEST_ASSERT_EQUAL_INT(expected, actual) do {                                \
+        long long _e = (long long) (expected);                                          \
+        long long _a = (long long) (actual);                                            \
+        if (_e != _a) {                                                                 \
+            _MJD_TEST_FAIL("%s: expected %lld, actual %lld", #actual, _e, _a);          \
+        }                                                                               \
+    } while (0)
+
+#define MJD_TEST_ASSERT_EQUAL_UINT(expected, actual) do {                               \
+        unsigned long long _e = (unsigned long long) (expected);                        \
+        unsigned long long _a = (unsigned long long) (actual);                          \
+        if (_e != _a) {                                                                 \
+            _MJD_TEST_FAIL("%s: expected %llu (0x%llX), actual %llu (0x%llX)", #actual, _e, _e, _a, _a); \
+        }                                                                               \
+    } while (0)
+
+#define MJD_TEST_ASSERT_EQUAL_STRING(expected, actual) do {                             \
+        const char *_e = (expected);                                                    \
+        const char *_a = (actual);                                                      \
+        if (strcmp(_e, _a) != 0) {                                                      \
+            _MJD_TEST_FAIL("%s: expected \"%s\", actual \"%s\"", #actual, _e, _a);      \
+        }                                                                               \
+    } while (0)
+
+#define MJD_TEST_ASSERT_EQUAL_MEMORY(expected, actual, len) do {                        \
+        if (memcmp((expected), (actual), (len)) != 0) {                                 \
+            _MJD_TEST_FAIL("%s: memory differs (%u bytes)", #actual, (unsigned) (len)); \
+        }                                                                               \
+    } while (0)
+
+#define MJD_TEST_ASSERT_FLOAT_WITHIN(delta, expected, actual) do {                      \
+        double _e = (double) (expected);                                                \
+        double _a = (double) (actual);                                                  \
+        if (fabs(_e - _a) > (double) (delta)) {                                         \
+            _MJD_TEST_FAIL("%s: expected %f +/- %f, actual %f", #actual, _e, (double) (delta), _a); \
+        }                                                                               \
+    } while (0)
+
+#define MJD_TEST_RUN(test_func) do {                                                    \
+        mjd_host_reset();                                                               \
+        _mjd_test_current_failed = 0;                                                   \
+        ++_mjd_test_nbr_of_tests;                                                       \
+        test_func();                                                                    \
+        if (_mjd_test_current_failed) {                                                 \
+            ++_mjd_test_nbr_of_failures;                                                \
+        }                                                                               \
+        fprintf(stderr, "  %s %s\n", _mjd_test_current_failed ? "FAIL" : "ok  ", #test_func); \
+    } while (0)
+
+#define MJD_TEST_REPORT() (                                                             \
+        fprintf(stderr, "%u tests, %u failures\n", _mjd_test_nbr_of_tests, _mjd_test_nbr_of_failures), \
+        (_mjd_test_nbr_of_failures == 0) ? 0 : 1)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_TEST_H__ */
@@ -0,0 +1,9 @@
+/*
+ * HOST SHIM: cJSON.h
+ *
+ * @doc Included by mjd.h but not used by the sources that are built on the host: intentionally empty.
+ */
+#ifndef __MJD_HOST_CJSON_H__
+#define __MJD_HOST_CJSON_H__
+
+#endif /* __MJD_HOST_CJSON_H__ */
@@ -0,0 +1,31 @@
+/*
+ * HOST SHIM: driver/timer.h
+ *
+ * @doc Types only. The hardware timer driven code paths are exercised on the host by calling their tick function directly.
+ */
+#ifndef __MJD_HOST_DRIVER_TIMER_H__
+#define __MJD_HOST_DRIVER_TIMER_H__
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    TIMER_GROUP_0 = 0,
+    TIMER_GROUP_1 = 1,
+    TIMER_GROUP_MAX,
+} timer_group_t;
+
+typedef enum {
+    TIMER_0 = 0,
+    TIMER_1 = 1,
+    TIMER_MAX,
+} timer_idx_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_HOST_DRIVER_TIMER_H__ */
@@ -0,0 +1,19 @@
+/*
+ * HOST SHIM: esp_attr.h
+ *
+ * @doc Linker section attributes are meaningless on the host: they expand to nothing.
+ */
+#ifndef __MJD_HOST_ESP_ATTR_H__
+#define __MJD_HOST_ESP_ATTR_H__
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_RODATA_ATTR
+#define RTC_SLOW_ATTR
+#define RTC_FAST_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_IRAM_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
+
+#endif /* __MJD_HOST_ESP_ATTR_H__ */
@@ -0,0 +1,20 @@
+/*
+ * HOST SHIM: esp_clk.h
+ */
+#ifndef __MJD_HOST_ESP_CLK_H__
+#define __MJD_HOST_ESP_CLK_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int esp_clk_cpu_freq(void);
+int esp_clk_apb_freq(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_HOST_ESP_CLK_H__ */
@@ -0,0 +1,54 @@
+/*
+ * HOST SHIM: esp_err.h
+ *
+ * @doc Same names and values as ESP-IDF v3.2 so the component code compiles unchanged on Linux.
+ */
+#ifndef __MJD_HOST_ESP_ERR_H__
+#define __MJD_HOST_ESP_ERR_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int32_t esp_err_t;
+
+#define ESP_OK                    0
+#define ESP_FAIL                  -1
+
+#define ESP_ERR_NO_MEM            0x101
+#define ESP_ERR_INVALID_ARG       0x102
+#define ESP_ERR_INVALID_STATE     0x103
+#define ESP_ERR_INVALID_SIZE      0x104
+#define ESP_ERR_NOT_FOUND         0x105
+#define ESP_ERR_NOT_SUPPORTED     0x106
+#define ESP_ERR_TIMEOUT           0x107
+#define ESP_ERR_INVALID_RESPONSE  0x108
+#define ESP_ERR_INVALID_CRC       0x109
+#define ESP_ERR_INVALID_VERSION   0x10A
+#define ESP_ERR_INVALID_MAC       0x10B
+
+#define ESP_ERR_WIFI_BASE         0x3000
+#define ESP_ERR_MESH_BASE         0x4000
+
+const char *esp_err_to_name(esp_err_t code);
+
+#define ESP_ERROR_CHECK(x) do {                                                 \
+        esp_err_t __err_rc = (x);                                               \
+        if (__err_rc != ESP_OK) {                                               \
+            fprintf(stderr, "ESP_ERROR_CHECK failed: esp_err_t 0x%x (%s) at %s:%d\n", \
+                    (unsigned) __err_rc, esp_err_to_name(__err_rc), __FILE__, __LINE__); \
+            abort();                                                            \
+        }                                                                       \
+    } while(0)
+
+#define ESP_ERROR_CHECK_WITHOUT_ABORT(x) ({ esp_err_t __err_rc = (x); __err_rc; })
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_HOST_ESP_ERR_H__ */
@@ -0,0 +1,9 @@
+/*
+ * HOST SHIM: esp_event_loop.h
+ *
+ * @doc Included by mjd.h but not used by the sources that are built on the host: intentionally empty.
+ */
+#ifndef __MJD_HOST_ESP_EVENT_LOOP_H__
+#define __MJD_HOST_ESP_EVENT_LOOP_H__
+
+#endif /* __MJD_HOST_ESP_EVENT_LOOP_H__ */
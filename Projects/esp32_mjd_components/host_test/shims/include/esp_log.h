@@ -0,0 +1,57 @@
+/*
+ * HOST SHIM: esp_log.h
+ *
+ * @doc The log level is a runtime global (default WARN so the test output stays readable).
+ *      Change it with esp_log_level_set("*", ESP_LOG_DEBUG).
+ */
+#ifndef __MJD_HOST_ESP_LOG_H__
+#define __MJD_HOST_ESP_LOG_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+extern esp_log_level_t mjd_host_log_level;
+
+void esp_log_level_set(const char* tag, esp_log_level_t level);
+uint32_t esp_log_timestamp(void);
+void mjd_host_log_buffer_hexdump(const char *tag, const void *buffer, uint16_t buff_len, esp_log_level_t level);
+
+#define _MJD_HOST_LOG(level, letter, tag, format, ...) do {                          \
+        if ((level) <= mjd_host_log_level) {                                         \
+            fprintf(stderr, letter " (%u) %s: " format "\n", esp_log_timestamp(), tag, ##__VA_ARGS__); \
+        }                                                                            \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) _MJD_HOST_LOG(ESP_LOG_ERROR,   "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) _MJD_HOST_LOG(ESP_LOG_WARN,    "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) _MJD_HOST_LOG(ESP_LOG_INFO,    "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) _MJD_HOST_LOG(ESP_LOG_DEBUG,   "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) _MJD_HOST_LOG(ESP_LOG_VERBOSE, "V", tag, format, ##__VA_ARGS__)
+
+#define ESP_LOG_BUFFER_HEXDUMP(tag, buffer, buff_len, level) \
+    mjd_host_log_buffer_hexdump(tag, buffer, buff_len, level)
+#define ESP_LOG_BUFFER_HEX_LEVEL(tag, buffer, buff_len, level) \
+    mjd_host_log_buffer_hexdump(tag, buffer, buff_len, level)
+#define ESP_LOG_BUFFER_HEX(tag, buffer, buff_len) \
+    mjd_host_log_buffer_hexdump(tag, buffer, buff_len, ESP_LOG_INFO)
+#define ESP_LOG_BUFFER_CHAR(tag, buffer, buff_len) \
+    mjd_host_log_buffer_hexdump(tag, buffer, buff_len, ESP_LOG_INFO)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_HOST_ESP_LOG_H__ */
@@ -0,0 +1,32 @@
+/*
+ * HOST SHIM: esp_sleep.h
+ */
+#ifndef __MJD_HOST_ESP_SLEEP_H__
+#define __MJD_HOST_ESP_SLEEP_H__
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED,
+    ESP_SLEEP_WAKEUP_EXT0,
+    ESP_SLEEP_WAKEUP_EXT1,
+    ESP_SLEEP_WAKEUP_TIMER,
+    ESP_SLEEP_WAKEUP_TOUCHPAD,
+    ESP_SLEEP_WAKEUP_ULP,
+} esp_sleep_wakeup_cause_t;
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void);
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us);
+void esp_deep_sleep_start(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_HOST_ESP_SLEEP_H__ */
@@ -0,0 +1,19 @@
+/*
+ * HOST SHIM: esp_spi_flash.h
+ */
+#ifndef __MJD_HOST_ESP_SPI_FLASH_H__
+#define __MJD_HOST_ESP_SPI_FLASH_H__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+size_t spi_flash_get_chip_size(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_HOST_ESP_SPI_FLASH_H__ */
@@ -0,0 +1,51 @@
+/*
+ * HOST SHIM: esp_system.h
+ */
+#ifndef __MJD_HOST_ESP_SYSTEM_H__
+#define __MJD_HOST_ESP_SYSTEM_H__
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    ESP_MAC_WIFI_STA,
+    ESP_MAC_WIFI_SOFTAP,
+    ESP_MAC_BT,
+    ESP_MAC_ETH,
+} esp_mac_type_t;
+
+typedef enum {
+    CHIP_ESP32 = 1,
+} esp_chip_model_t;
+
+#define CHIP_FEATURE_EMB_FLASH      (1 << 0)
+#define CHIP_FEATURE_WIFI_BGN       (1 << 1)
+#define CHIP_FEATURE_BLE            (1 << 4)
+#define CHIP_FEATURE_BT             (1 << 5)
+
+typedef struct {
+    esp_chip_model_t model;
+    uint32_t features;
+    uint8_t cores;
+    uint8_t revision;
+} esp_chip_info_t;
+
+void esp_chip_info(esp_chip_info_t* out_info);
+uint32_t esp_get_free_heap_size(void);
+uint32_t esp_get_minimum_free_heap_size(void);
+const char* esp_get_idf_version(void);
+esp_err_t esp_efuse_mac_get_default(uint8_t* mac);
+esp_err_t esp_read_mac(uint8_t* mac, esp_mac_type_t type);
+uint32_t esp_random(void);
+void esp_restart(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_HOST_ESP_SYSTEM_H__ */
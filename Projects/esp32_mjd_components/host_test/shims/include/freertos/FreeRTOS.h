@@ -0,0 +1,71 @@
+/*
+ * HOST SHIM: freertos/FreeRTOS.h
+ *
+ * @doc Single-threaded model of the FreeRTOS API subset used by the MJD components:
+ *      - Time is a simulated tick counter that only advances in vTaskDelay() (deterministic tests).
+ *      - Critical sections and spinlocks are no-ops.
+ */
+#ifndef __MJD_HOST_FREERTOS_H__
+#define __MJD_HOST_FREERTOS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "rom/ets_sys.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t TickType_t;
+typedef TickType_t portTickType;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE   ((BaseType_t) 0)
+#define pdTRUE    ((BaseType_t) 1)
+#define pdPASS    (pdTRUE)
+#define pdFAIL    (pdFALSE)
+
+#define configTICK_RATE_HZ    (CONFIG_FREERTOS_HZ)
+#define portTICK_PERIOD_MS    ((TickType_t) 1000 / configTICK_RATE_HZ)
+#define portTICK_RATE_MS      (portTICK_PERIOD_MS)
+#define portMAX_DELAY         ((TickType_t) 0xffffffffUL)
+#define pdMS_TO_TICKS(ms)     ((TickType_t) (((TickType_t) (ms) * (TickType_t) configTICK_RATE_HZ) / (TickType_t) 1000))
+
+#define PRO_CPU_NUM (0)
+#define APP_CPU_NUM (1)
+#define portNUM_PROCESSORS (2)
+
+typedef struct {
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { .owner = 0, .count = 0 }
+
+// The host harness is single-threaded: the critical sections of the components compile to nothing
+#define portENTER_CRITICAL(mux)      do { (void) (mux); } while (0)
+#define portEXIT_CRITICAL(mux)       do { (void) (mux); } while (0)
+#define portENTER_CRITICAL_ISR(mux)  do { (void) (mux); } while (0)
+#define portEXIT_CRITICAL_ISR(mux)   do { (void) (mux); } while (0)
+#define portYIELD_FROM_ISR()         do {} while (0)
+#define xPortGetCoreID()             (0)
+
+static inline void vPortCPUInitializeMutex(portMUX_TYPE *mux) {
+    mux->owner = 0;
+    mux->count = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "freertos/task.h"
+
+#endif /* __MJD_HOST_FREERTOS_H__ */
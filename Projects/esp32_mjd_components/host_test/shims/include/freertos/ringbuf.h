@@ -0,0 +1,33 @@
+/*
+ * HOST SHIM: freertos/ringbuf.h
+ *
+ * @doc No-split ring buffer model: every item that was sent is received as one block (FIFO order).
+ */
+#ifndef __MJD_HOST_FREERTOS_RINGBUF_H__
+#define __MJD_HOST_FREERTOS_RINGBUF_H__
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct mjd_host_ringbuf * RingbufHandle_t;
+
+typedef enum {
+    RINGBUF_TYPE_NOSPLIT = 0,
+    RINGBUF_TYPE_ALLOWSPLIT,
+    RINGBUF_TYPE_BYTEBUF
+} ringbuf_type_t;
+
+RingbufHandle_t xRingbufferCreate(size_t xBufferSize, ringbuf_type_t xBufferType);
+void vRingbufferDelete(RingbufHandle_t xRingbuffer);
+BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer, const void *pvItem, size_t xItemSize, TickType_t xTicksToWait);
+void *xRingbufferReceive(RingbufHandle_t xRingbuffer, size_t *pxItemSize, TickType_t xTicksToWait);
+void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void *pvItem);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_HOST_FREERTOS_RINGBUF_H__ */
@@ -0,0 +1,29 @@
+/*
+ * HOST SHIM: freertos/semphr.h
+ *
+ * @doc Semaphores and mutexes are queues of zero-size items, exactly like in FreeRTOS.
+ */
+#ifndef __MJD_HOST_FREERTOS_SEMPHR_H__
+#define __MJD_HOST_FREERTOS_SEMPHR_H__
+
+#include "freertos/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount, UBaseType_t uxInitialCount);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore);
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t xSemaphore, BaseType_t *pxHigherPriorityTaskWoken);
+#define vSemaphoreDelete(xSemaphore) vQueueDelete((QueueHandle_t) (xSemaphore))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_HOST_FREERTOS_SEMPHR_H__ */
@@ -0,0 +1,11 @@
+/*
+ * HOST SHIM: lwip/netdb.h
+ *
+ * @doc getaddrinfo() + freeaddrinfo() of Linux.
+ */
+#ifndef __MJD_HOST_LWIP_NETDB_H__
+#define __MJD_HOST_LWIP_NETDB_H__
+
+#include <netdb.h>
+
+#endif /* __MJD_HOST_LWIP_NETDB_H__ */
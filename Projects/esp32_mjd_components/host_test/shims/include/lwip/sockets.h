@@ -0,0 +1,16 @@
+/*
+ * HOST SHIM: lwip/sockets.h
+ *
+ * @doc The BSD socket API of lwIP is the POSIX one: the host uses the real sockets of Linux (the loopback stand-in servers of the tests).
+ */
+#ifndef __MJD_HOST_LWIP_SOCKETS_H__
+#define __MJD_HOST_LWIP_SOCKETS_H__
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#endif /* __MJD_HOST_LWIP_SOCKETS_H__ */
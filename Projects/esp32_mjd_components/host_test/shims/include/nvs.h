@@ -0,0 +1,81 @@
+/*
+ * HOST SHIM: nvs.h
+ *
+ * @doc An in-memory NVS emulator (ESP-IDF v3.2 API subset). A value is written to "flash" at nvs_set_*() like the real NVS;
+ *      nvs_commit() only counts. The values survive nvs_close() and a new nvs_open() (a reboot), not mjd_host_reset().
+ * @doc The wear counter mjd_host_nvs_get_nbr_of_entries_written() counts 32-byte NVS entries: 1 per integer, 1 + the data entries
+ *      per string or blob. Every nvs_set_*() writes, also when the value did not change (worst case).
+ */
+#ifndef __MJD_HOST_NVS_H__
+#define __MJD_HOST_NVS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_ERR_NVS_BASE                (0x1100)
+#define ESP_ERR_NVS_NOT_INITIALIZED     (ESP_ERR_NVS_BASE + 0x01)
+#define ESP_ERR_NVS_NOT_FOUND           (ESP_ERR_NVS_BASE + 0x02)
+#define ESP_ERR_NVS_TYPE_MISMATCH       (ESP_ERR_NVS_BASE + 0x03)
+#define ESP_ERR_NVS_READ_ONLY           (ESP_ERR_NVS_BASE + 0x04)
+#define ESP_ERR_NVS_NOT_ENOUGH_SPACE    (ESP_ERR_NVS_BASE + 0x05)
+#define ESP_ERR_NVS_INVALID_NAME        (ESP_ERR_NVS_BASE + 0x06)
+#define ESP_ERR_NVS_INVALID_HANDLE      (ESP_ERR_NVS_BASE + 0x07)
+#define ESP_ERR_NVS_REMOVE_FAILED       (ESP_ERR_NVS_BASE + 0x08)
+#define ESP_ERR_NVS_KEY_TOO_LONG        (ESP_ERR_NVS_BASE + 0x09)
+#define ESP_ERR_NVS_PAGE_FULL           (ESP_ERR_NVS_BASE + 0x0a)
+#define ESP_ERR_NVS_INVALID_STATE       (ESP_ERR_NVS_BASE + 0x0b)
+#define ESP_ERR_NVS_INVALID_LENGTH      (ESP_ERR_NVS_BASE + 0x0c)
+#define ESP_ERR_NVS_NO_FREE_PAGES       (ESP_ERR_NVS_BASE + 0x0d)
+#define ESP_ERR_NVS_VALUE_TOO_LONG      (ESP_ERR_NVS_BASE + 0x0e)
+#define ESP_ERR_NVS_PART_NOT_FOUND      (ESP_ERR_NVS_BASE + 0x0f)
+#define ESP_ERR_NVS_NEW_VERSION_FOUND   (ESP_ERR_NVS_BASE + 0x10)
+
+#define NVS_DEFAULT_PART_NAME "nvs"
+
+typedef uint32_t nvs_handle;
+
+typedef enum {
+    NVS_READONLY,
+    NVS_READWRITE
+} nvs_open_mode;
+
+esp_err_t nvs_open(const char* name, nvs_open_mode open_mode, nvs_handle *out_handle);
+esp_err_t nvs_open_from_partition(const char *part_name, const char* name, nvs_open_mode open_mode, nvs_handle *out_handle);
+void nvs_close(nvs_handle handle);
+esp_err_t nvs_commit(nvs_handle handle);
+esp_err_t nvs_erase_key(nvs_handle handle, const char* key);
+esp_err_t nvs_erase_all(nvs_handle handle);
+
+esp_err_t nvs_set_i8(nvs_handle handle, const char* key, int8_t value);
+esp_err_t nvs_set_u8(nvs_handle handle, const char* key, uint8_t value);
+esp_err_t nvs_set_i16(nvs_handle handle, const char* key, int16_t value);
+esp_err_t nvs_set_u16(nvs_handle handle, const char* key, uint16_t value);
+esp_err_t nvs_set_i32(nvs_handle handle, const char* key, int32_t value);
+esp_err_t nvs_set_u32(nvs_handle handle, const char* key, uint32_t value);
+esp_err_t nvs_set_i64(nvs_handle handle, const char* key, int64_t value);
+esp_err_t nvs_set_u64(nvs_handle handle, const char* key, uint64_t value);
+esp_err_t nvs_set_str(nvs_handle handle, const char* key, const char* value);
+esp_err_t nvs_set_blob(nvs_handle handle, const char* key, const void* value, size_t length);
+
+esp_err_t nvs_get_i8(nvs_handle handle, const char* key, int8_t* out_value);
+esp_err_t nvs_get_u8(nvs_handle handle, const char* key, uint8_t* out_value);
+esp_err_t nvs_get_i16(nvs_handle handle, const char* key, int16_t* out_value);
+esp_err_t nvs_get_u16(nvs_handle handle, const char* key, uint16_t* out_value);
+esp_err_t nvs_get_i32(nvs_handle handle, const char* key, int32_t* out_value);
+esp_err_t nvs_get_u32(nvs_handle handle, const char* key, uint32_t* out_value);
+esp_err_t nvs_get_i64(nvs_handle handle, const char* key, int64_t* out_value);
+esp_err_t nvs_get_u64(nvs_handle handle, const char* key, uint64_t* out_value);
+esp_err_t nvs_get_str(nvs_handle handle, const char* key, char* out_value, size_t* length);
+esp_err_t nvs_get_blob(nvs_handle handle, const char* key, void* out_value, size_t* length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_HOST_NVS_H__ */
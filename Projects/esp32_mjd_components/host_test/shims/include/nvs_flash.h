@@ -0,0 +1,24 @@
+/*
+ * HOST SHIM: nvs_flash.h
+ *
+ * @doc The partitions of the NVS emulator (see nvs.h). Any partition name is valid; nvs_flash_erase_partition() drops its values.
+ */
+#ifndef __MJD_HOST_NVS_FLASH_H__
+#define __MJD_HOST_NVS_FLASH_H__
+
+#include "nvs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_init_partition(const char *partition_label);
+esp_err_t nvs_flash_erase(void);
+esp_err_t nvs_flash_erase_partition(const char *part_name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_HOST_NVS_FLASH_H__ */
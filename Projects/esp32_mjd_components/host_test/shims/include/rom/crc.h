@@ -0,0 +1,21 @@
+/*
+ * HOST SHIM: rom/crc.h
+ *
+ * @doc The CRC functions of the ESP32 mask ROM. crc32_le(0, buf, len) is the standard CRC-32 (zlib, IEEE 802.3).
+ */
+#ifndef __MJD_HOST_ROM_CRC_H__
+#define __MJD_HOST_ROM_CRC_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t crc32_le(uint32_t crc, uint8_t const * buf, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_HOST_ROM_CRC_H__ */
@@ -0,0 +1,19 @@
+/*
+ * HOST SHIM: rom/ets_sys.h
+ */
+#ifndef __MJD_HOST_ETS_SYS_H__
+#define __MJD_HOST_ETS_SYS_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void ets_delay_us(uint32_t us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_HOST_ETS_SYS_H__ */
@@ -0,0 +1,31 @@
+/*
+ * HOST SHIM: sdkconfig.h
+ *
+ * @doc The subset of the `make menuconfig` settings that the MJD components read. Defaults of ESP-IDF v3.2.
+ */
+#ifndef __MJD_HOST_SDKCONFIG_H__
+#define __MJD_HOST_SDKCONFIG_H__
+
+#define CONFIG_FREERTOS_HZ 100
+#define CONFIG_LOG_DEFAULT_LEVEL 2
+#define CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ 240
+
+// The host build always compiles the latency probes (mjd_trace unit tests)
+#define CONFIG_MJD_TRACE_ENABLED 1
+
+#define CONFIG_MJD_POOL_STATS_ENABLED 1
+// CONFIG_MJD_POOL_DEBUG_POISON: only in the test_mjd_pool_poison build (CMakeLists.txt), not in the benchmarks
+
+#define CONFIG_MJD_BOOT_MAX_PHASES 32
+
+#define CONFIG_MJD_HTTP_RX_BUFFER_SIZE 2048
+
+#define CONFIG_MJD_NVS_MAX_KEYS 16
+
+#define CONFIG_MJD_WIFI_SNIFFER_QUEUE_LENGTH 32
+
+#define CONFIG_MJD_HUZZAH32_REFERENCE_VOLTAGE_MV 1100
+#define CONFIG_MJD_HUZZAH32_VOLTAGE_REGULATOR_ENABLED 1
+#define CONFIG_MJD_HUZZAH32_ROUTE_VREF_TO_GPIO_NUM 26
+
+#endif /* __MJD_HOST_SDKCONFIG_H__ */
@@ -0,0 +1,9 @@
+/*
+ * HOST SHIM: soc/rmt_reg.h
+ *
+ * @doc Included by mjd.h but not used by the sources that are built on the host: intentionally empty.
+ */
+#ifndef __MJD_HOST_SOC_RMT_REG_H__
+#define __MJD_HOST_SOC_RMT_REG_H__
+
+#endif /* __MJD_HOST_SOC_RMT_REG_H__ */
@@ -0,0 +1,357 @@
+/*
+ * HOST SHIMS: a minimal HTTP/1.1 stand-in server on the loopback interface (the tests + benchmarks of mjd_http).
+ *
+ * @doc The only shim that runs a thread: a real server must answer while the test blocks in recv().
+ *      One connection at a time (the client has max 1), a fixed request buffer, no malloc.
+ * @doc GET <any path> = a generated "file" of config.file_size bytes (mjd_host_http_server_file_byte()), with Range support,
+ *      Content-Length or chunked framing. POST <any path> = 201 Created, the body is counted and discarded.
+ *      After config.max_requests_per_connection requests the response says "Connection: close" and the server closes.
+ *      Pipelined requests are served in order from the request buffer.
+ */
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "mjd_host.h"
+
+#define _REQUEST_BUFFER_SIZE (8192)
+#define _SEND_BUFFER_SIZE (16 * 1024)
+#define _POLL_TIMEOUT_MS (20)
+
+static mjd_host_http_server_config_t _http_config;
+static int _http_listen_socket = -1;
+static pthread_t _http_thread;
+static bool _http_is_running = false;
+static volatile bool _http_is_stop_requested = false;
+
+static uint32_t _http_nbr_of_connections;
+static uint32_t _http_nbr_of_requests;
+static uint32_t _http_nbr_of_posts;
+static uint64_t _http_bytes_posted;
+
+static char _http_request_buffer[_REQUEST_BUFFER_SIZE];
+static uint8_t _http_send_buffer[_SEND_BUFFER_SIZE];
+
+/**********
+ * PRIVATE: I/O
+ */
+
+/*
+ * @return 1 = readable, 0 = stop requested, -1 = error
+ */
+static int _wait_readable(int param_socket) {
+    struct pollfd pfd = { .fd = param_socket, .events = POLLIN };
+
+    while (_http_is_stop_requested == false) {
+        int retval = poll(&pfd, 1, _POLL_TIMEOUT_MS);
+        if (retval > 0) {
+            return 1;
+        }
+        if (retval < 0 && errno != EINTR) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static bool _send_all(int param_socket, const void * param_ptr_data, size_t param_len) {
+    const uint8_t *ptr = param_ptr_data;
+
+    while (param_len > 0) {
+        ssize_t len = send(param_socket, ptr, param_len, MSG_NOSIGNAL);
+        if (len <= 0) {
+            return false;
+        }
+        ptr += len;
+        param_len -= len;
+    }
+    return true;
+}
+
+/*
+ * @brief Find the value of a request header (case insensitive) in the head [param_ptr_head, param_ptr_end).
+ */
+static const char * _find_header(const char * param_ptr_head, const char * param_ptr_end, const char * param_ptr_name) {
+    size_t len_name = strlen(param_ptr_name);
+    const char *ptr = strstr(param_ptr_head, "\r\n");
+
+    while (ptr != NULL && ptr < param_ptr_end) {
+        ptr += 2;
+        if (strncasecmp(ptr, param_ptr_name, len_name) == 0 && ptr[len_name] == ':') {
+            ptr += len_name + 1;
+            while (*ptr == ' ') {
+                ptr++;
+            }
+            return ptr;
+        }
+        ptr = strstr(ptr, "\r\n");
+    }
+    return NULL;
+}
+
+/**********
+ * PRIVATE: RESPONSES
+ */
+static bool _send_file(int param_socket, uint64_t param_start, uint64_t param_len) {
+    uint64_t offset = param_start;
+    uint64_t end = param_start + param_len;
+
+    while (offset < end) {
+        size_t len = 0;
+        size_t max_len = (_http_config.chunk_size > 0) ? _http_config.chunk_size : _SEND_BUFFER_SIZE;
+        if (max_len > _SEND_BUFFER_SIZE - 16) {
+            max_len = _SEND_BUFFER_SIZE - 16;
+        }
+        if (max_len > end - offset) {
+            max_len = (size_t) (end - offset);
+        }
+        if (_http_config.chunk_size > 0) {
+            len = (size_t) sprintf((char *) _http_send_buffer, "%zx\r\n", max_len);
+        }
+        for (size_t idx = 0; idx < max_len; idx++) {
+            _http_send_buffer[len++] = mjd_host_http_server_file_byte(offset + idx);
+        }
+        if (_http_config.chunk_size > 0) {
+            _http_send_buffer[len++] = '\r';
+            _http_send_buffer[len++] = '\n';
+        }
+        if (_send_all(param_socket, _http_send_buffer, len) == false) {
+            return false;
+        }
+        offset += max_len;
+    }
+    if (_http_config.chunk_size > 0) {
+        return _send_all(param_socket, "0\r\n\r\n", 5);
+    }
+    return true;
+}
+
+static bool _respond_get(int param_socket, const char * param_ptr_head, const char * param_ptr_head_end, bool param_is_last) {
+    char head[256];
+    int head_len;
+    uint64_t start = 0;
+    uint64_t len = _http_config.file_size;
+    int status_code = 200;
+    const char *ptr_range = _find_header(param_ptr_head, param_ptr_head_end, "Range");
+
+    if (_http_config.is_range_supported == true && ptr_range != NULL && strncmp(ptr_range, "bytes=", 6) == 0) {
+        char *ptr_end;
+        uint64_t range_end = _http_config.file_size - 1;
+        start = strtoull(ptr_range + 6, &ptr_end, 10);
+        if (*ptr_end == '-' && ptr_end[1] >= '0' && ptr_end[1] <= '9') {
+            range_end = strtoull(ptr_end + 1, NULL, 10);
+        }
+        if (range_end >= _http_config.file_size) {
+            range_end = _http_config.file_size - 1;
+        }
+        if (start >= _http_config.file_size || range_end < start) {
+            head_len = snprintf(head, sizeof(head),
+                    "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */%u\r\nContent-Length: 0\r\n%s\r\n",
+                    _http_config.file_size, param_is_last ? "Connection: close\r\n" : "");
+            return _send_all(param_socket, head, head_len);
+        }
+        status_code = 206;
+        len = range_end - start + 1;
+    }
+
+    head_len = snprintf(head, sizeof(head), "HTTP/1.1 %i %s\r\nServer: mjd_host\r\n", status_code,
+            (status_code == 200) ? "OK" : "Partial Content");
+    if (status_code == 206) {
+        head_len += snprintf(head + head_len, sizeof(head) - head_len, "Content-Range: bytes %lu-%lu/%u\r\n", (unsigned long) start,
+                (unsigned long) (start + len - 1), _http_config.file_size);
+    }
+    if (_http_config.chunk_size > 0) {
+        head_len += snprintf(head + head_len, sizeof(head) - head_len, "Transfer-Encoding: chunked\r\n");
+    } else {
+        head_len += snprintf(head + head_len, sizeof(head) - head_len, "Content-Length: %lu\r\n", (unsigned long) len);
+    }
+    head_len += snprintf(head + head_len, sizeof(head) - head_len, "%s\r\n", param_is_last ? "Connection: close\r\n" : "");
+
+    return _send_all(param_socket, head, head_len) && _send_file(param_socket, start, len);
+}
+
+static bool _respond_post(int param_socket, uint32_t param_nbr_of_posts, bool param_is_last) {
+    char body[32];
+    char head[160];
+    int body_len = snprintf(body, sizeof(body), "OK %u", param_nbr_of_posts);
+    int head_len = snprintf(head, sizeof(head), "HTTP/1.1 201 Created\r\nContent-Length: %i\r\n%s\r\n", body_len,
+            param_is_last ? "Connection: close\r\n" : "");
+
+    return _send_all(param_socket, head, head_len) && _send_all(param_socket, body, body_len);
+}
+
+/**********
+ * PRIVATE: CONNECTION
+ */
+static void _serve_connection(int param_socket) {
+    size_t buffer_len = 0;
+    uint32_t nbr_of_requests_on_connection = 0;
+
+    for (;;) {
+        // 1. A complete request head in the buffer?
+        _http_request_buffer[buffer_len] = '\0';
+        char *ptr_head_end = strstr(_http_request_buffer, "\r\n\r\n");
+        if (ptr_head_end == NULL) {
+            if (buffer_len >= _REQUEST_BUFFER_SIZE - 1 || _wait_readable(param_socket) <= 0) {
+                return;
+            }
+            ssize_t len = recv(param_socket, &_http_request_buffer[buffer_len], _REQUEST_BUFFER_SIZE - 1 - buffer_len, 0);
+            if (len <= 0) {
+                return;
+            }
+            buffer_len += len;
+            continue;
+        }
+        ptr_head_end += 4;
+
+        // 2. The request
+        bool is_post = (strncmp(_http_request_buffer, "POST ", 5) == 0);
+        const char *ptr_value = _find_header(_http_request_buffer, ptr_head_end, "Content-Length");
+        uint64_t content_length = (ptr_value != NULL) ? strtoull(ptr_value, NULL, 10) : 0;
+        ptr_value = _find_header(_http_request_buffer, ptr_head_end, "Connection");
+        bool is_close_requested = (ptr_value != NULL && strncasecmp(ptr_value, "close", 5) == 0);
+
+        nbr_of_requests_on_connection++;
+        __atomic_add_fetch(&_http_nbr_of_requests, 1, __ATOMIC_SEQ_CST);
+        bool is_last = is_close_requested || (_http_config.max_requests_per_connection > 0
+                && nbr_of_requests_on_connection >= _http_config.max_requests_per_connection);
+
+        // 3. Consume the head + the body (the body can be larger than the buffer)
+        size_t consumed = ptr_head_end - _http_request_buffer;
+        uint64_t body_in_buffer = buffer_len - consumed;
+        if (body_in_buffer > content_length) {
+            body_in_buffer = content_length;
+        }
+        consumed += body_in_buffer;
+        uint64_t body_to_recv = content_length - body_in_buffer;
+
+        bool is_ok;
+        if (is_post == true) {
+            uint32_t nbr_of_posts = __atomic_add_fetch(&_http_nbr_of_posts, 1, __ATOMIC_SEQ_CST);
+            __atomic_add_fetch(&_http_bytes_posted, content_length, __ATOMIC_SEQ_CST);
+            memmove(_http_request_buffer, &_http_request_buffer[consumed], buffer_len - consumed);
+            buffer_len -= consumed;
+            while (body_to_recv > 0) {
+                if (_wait_readable(param_socket) <= 0) {
+                    return;
+                }
+                ssize_t len = recv(param_socket, _http_send_buffer,
+                        (body_to_recv < _SEND_BUFFER_SIZE) ? (size_t) body_to_recv : _SEND_BUFFER_SIZE, 0);
+                if (len <= 0) {
+                    return;
+                }
+                body_to_recv -= len;
+            }
+            is_ok = _respond_post(param_socket, nbr_of_posts, is_last);
+        } else {
+            is_ok = _respond_get(param_socket, _http_request_buffer, ptr_head_end, is_last);
+            memmove(_http_request_buffer, &_http_request_buffer[consumed], buffer_len - consumed);
+            buffer_len -= consumed;
+        }
+        if (is_ok == false || is_last == true) {
+            return;
+        }
+    }
+}
+
+static void * _server_thread(void * param_ptr_arg) {
+    while (_http_is_stop_requested == false) {
+        if (_wait_readable(_http_listen_socket) <= 0) {
+            break;
+        }
+        int socket = accept(_http_listen_socket, NULL, NULL);
+        if (socket < 0) {
+            continue;
+        }
+        int nodelay = 1;
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+        __atomic_add_fetch(&_http_nbr_of_connections, 1, __ATOMIC_SEQ_CST);
+        _serve_connection(socket);
+        close(socket);
+    }
+    return NULL;
+}
+
+/**********
+ * PUBLIC
+ */
+uint8_t mjd_host_http_server_file_byte(uint64_t param_offset) {
+    return (uint8_t) ((param_offset * 31) ^ (param_offset >> 8) ^ (param_offset >> 16));
+}
+
+uint16_t mjd_host_http_server_start(const mjd_host_http_server_config_t* param_ptr_config) {
+    struct sockaddr_in addr = { 0 };
+    socklen_t addr_len = sizeof(addr);
+    int reuse = 1;
+
+    mjd_host_http_server_stop();
+
+    _http_config = *param_ptr_config;
+    _http_nbr_of_connections = 0;
+    _http_nbr_of_requests = 0;
+    _http_nbr_of_posts = 0;
+    _http_bytes_posted = 0;
+    _http_is_stop_requested = false;
+
+    _http_listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (_http_listen_socket < 0) {
+        return 0;
+    }
+    setsockopt(_http_listen_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0; // an ephemeral port
+    if (bind(_http_listen_socket, (struct sockaddr *) &addr, sizeof(addr)) != 0 || listen(_http_listen_socket, 4) != 0
+            || getsockname(_http_listen_socket, (struct sockaddr *) &addr, &addr_len) != 0) {
+        close(_http_listen_socket);
+        _http_listen_socket = -1;
+        return 0;
+    }
+    if (pthread_create(&_http_thread, NULL, _server_thread, NULL) != 0) {
+        close(_http_listen_socket);
+        _http_listen_socket = -1;
+        return 0;
+    }
+    _http_is_running = true;
+
+    return ntohs(addr.sin_port);
+}
+
+void mjd_host_http_server_stop(void) {
+    if (_http_is_running == false) {
+        return;
+    }
+    _http_is_stop_requested = true;
+    pthread_join(_http_thread, NULL);
+    close(_http_listen_socket);
+    _http_listen_socket = -1;
+    _http_is_running = false;
+}
+
+uint32_t mjd_host_http_server_get_nbr_of_connections(void) {
+    return __atomic_load_n(&_http_nbr_of_connections, __ATOMIC_SEQ_CST);
+}
+
+uint32_t mjd_host_http_server_get_nbr_of_requests(void) {
+    return __atomic_load_n(&_http_nbr_of_requests, __ATOMIC_SEQ_CST);
+}
+
+uint32_t mjd_host_http_server_get_nbr_of_posts(void) {
+    return __atomic_load_n(&_http_nbr_of_posts, __ATOMIC_SEQ_CST);
+}
+
+uint64_t mjd_host_http_server_get_bytes_posted(void) {
+    return __atomic_load_n(&_http_bytes_posted, __ATOMIC_SEQ_CST);
+}
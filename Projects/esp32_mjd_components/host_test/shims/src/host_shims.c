@@ -0,0 +1,1571 @@
+/*
+ * HOST SHIMS: Linux implementation of the ESP-IDF and FreeRTOS API subset used by the MJD components.
+ *
+ * @doc Single-threaded and deterministic. Nothing here ever blocks: a "wait" that cannot be satisfied returns the timeout result immediately.
+ *
+ */
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "freertos/ringbuf.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_clk.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "esp_spi_flash.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+
+#include "driver/gpio.h"
+#include "driver/i2c.h"
+#include "driver/rmt.h"
+#include "driver/uart.h"
+#include "rom/crc.h"
+
+#include "mjd_host.h"
+
+/**********
+ * esp_err
+ */
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+        return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_RESPONSE:
+        return "ESP_ERR_INVALID_RESPONSE";
+    case ESP_ERR_INVALID_CRC:
+        return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_INVALID_VERSION:
+        return "ESP_ERR_INVALID_VERSION";
+    case ESP_ERR_INVALID_MAC:
+        return "ESP_ERR_INVALID_MAC";
+    case ESP_ERR_NVS_NOT_INITIALIZED:
+        return "ESP_ERR_NVS_NOT_INITIALIZED";
+    case ESP_ERR_NVS_NOT_FOUND:
+        return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_TYPE_MISMATCH:
+        return "ESP_ERR_NVS_TYPE_MISMATCH";
+    case ESP_ERR_NVS_READ_ONLY:
+        return "ESP_ERR_NVS_READ_ONLY";
+    case ESP_ERR_NVS_NOT_ENOUGH_SPACE:
+        return "ESP_ERR_NVS_NOT_ENOUGH_SPACE";
+    case ESP_ERR_NVS_INVALID_NAME:
+        return "ESP_ERR_NVS_INVALID_NAME";
+    case ESP_ERR_NVS_INVALID_HANDLE:
+        return "ESP_ERR_NVS_INVALID_HANDLE";
+    case ESP_ERR_NVS_KEY_TOO_LONG:
+        return "ESP_ERR_NVS_KEY_TOO_LONG";
+    case ESP_ERR_NVS_INVALID_LENGTH:
+        return "ESP_ERR_NVS_INVALID_LENGTH";
+    case ESP_ERR_NVS_VALUE_TOO_LONG:
+        return "ESP_ERR_NVS_VALUE_TOO_LONG";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
+
+/**********
+ * esp_log
+ */
+esp_log_level_t mjd_host_log_level = ESP_LOG_WARN;
+
+void esp_log_level_set(const char* tag, esp_log_level_t level) {
+    (void) tag;
+    mjd_host_log_level = level;
+}
+
+uint32_t esp_log_timestamp(void) {
+    return (uint32_t) (mjd_host_get_time_us() / 1000);
+}
+
+void mjd_host_log_buffer_hexdump(const char *tag, const void *buffer, uint16_t buff_len, esp_log_level_t level) {
+    if (level > mjd_host_log_level) {
+        return;
+    }
+    const uint8_t *ptr = buffer;
+    for (uint16_t i = 0; i < buff_len; i += 16) {
+        fprintf(stderr, "  %s: %08x ", tag, i);
+        for (uint16_t j = i; j < i + 16 && j < buff_len; j++) {
+            fprintf(stderr, " %02x", ptr[j]);
+        }
+        fprintf(stderr, "\n");
+    }
+}
+
+/**********
+ * TIME (simulated)
+ */
+static uint64_t _host_time_us = 0;
+
+void mjd_host_advance_time_us(uint64_t param_us) {
+    _host_time_us += param_us;
+}
+
+uint64_t mjd_host_get_time_us(void) {
+    return _host_time_us;
+}
+
+int64_t esp_timer_get_time(void) {
+    return (int64_t) _host_time_us;
+}
+
+struct esp_timer {
+    esp_timer_create_args_t args;
+    uint64_t period_us;
+};
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args, esp_timer_handle_t* out_handle) {
+    if (create_args == NULL || create_args->callback == NULL || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_timer_handle_t timer = calloc(1, sizeof(struct esp_timer));
+    if (timer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->args = *create_args;
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer->period_us != 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->period_us = timeout_us; // Armed (the callback never fires on the host)
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) {
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer->period_us != 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->period_us = period;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer->period_us == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->period_us = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer->period_us != 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    free(timer);
+    return ESP_OK;
+}
+
+void ets_delay_us(uint32_t us) {
+    _host_time_us += us;
+}
+
+/**********
+ * esp_clk, esp_system, esp_sleep, esp_spi_flash
+ */
+int esp_clk_cpu_freq(void) {
+    return 240 * 1000000;
+}
+
+int esp_clk_apb_freq(void) {
+    return 80 * 1000000;
+}
+
+void esp_chip_info(esp_chip_info_t* out_info) {
+    memset(out_info, 0, sizeof(*out_info));
+    out_info->model = CHIP_ESP32;
+    out_info->features = CHIP_FEATURE_WIFI_BGN | CHIP_FEATURE_BLE | CHIP_FEATURE_BT;
+    out_info->cores = 2;
+    out_info->revision = 1;
+}
+
+uint32_t esp_get_free_heap_size(void) {
+    return 200 * 1024;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void) {
+    return 200 * 1024;
+}
+
+const char* esp_get_idf_version(void) {
+    return "v3.2-host";
+}
+
+esp_err_t esp_efuse_mac_get_default(uint8_t* mac) {
+    static const uint8_t host_mac[6] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x01 };
+    memcpy(mac, host_mac, sizeof(host_mac));
+    return ESP_OK;
+}
+
+esp_err_t esp_read_mac(uint8_t* mac, esp_mac_type_t type) {
+    (void) type;
+    return esp_efuse_mac_get_default(mac);
+}
+
+uint32_t esp_random(void) {
+    // xorshift32: deterministic across runs
+    static uint32_t state = 0x2545F491;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+void esp_restart(void) {
+    fprintf(stderr, "esp_restart() called on the host\n");
+    abort();
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void) {
+    return ESP_SLEEP_WAKEUP_UNDEFINED;
+}
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us) {
+    (void) time_in_us;
+    return ESP_OK;
+}
+
+void esp_deep_sleep_start(void) {
+    fprintf(stderr, "esp_deep_sleep_start() called on the host\n");
+    abort();
+}
+
+size_t spi_flash_get_chip_size(void) {
+    return 4 * 1024 * 1024;
+}
+
+/**********
+ * ROM: CRC
+ */
+uint32_t crc32_le(uint32_t crc, uint8_t const * buf, uint32_t len) {
+    crc = ~crc;
+    for (uint32_t idx = 0; idx < len; idx++) {
+        crc ^= buf[idx];
+        for (uint32_t bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+/**********
+ * FreeRTOS: tasks
+ *
+ * @doc Tasks are not started. The shim remembers the parameter of each task function so mjd_host_run_task_at_next_delay() can
+ *      play a task (e.g. its exit after a stop request) while the caller waits in vTaskDelay().
+ */
+#define MJD_HOST_MAX_TASKS (16)
+
+typedef struct {
+    TaskFunction_t task_code;
+    void* parameters;
+} _host_task_t;
+
+static _host_task_t _tasks[MJD_HOST_MAX_TASKS];
+static TaskFunction_t _task_to_run_at_next_delay = NULL;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char * const pcName, const uint32_t usStackDepth,
+                                   void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pvCreatedTask,
+                                   const BaseType_t xCoreID) {
+    (void) usStackDepth;
+    (void) uxPriority;
+    (void) xCoreID;
+    ESP_LOGD("host", "xTaskCreatePinnedToCore(%s): task not started on the host", pcName);
+    for (uint32_t idx = 0; idx < MJD_HOST_MAX_TASKS; idx++) {
+        if (_tasks[idx].task_code == NULL || _tasks[idx].task_code == pvTaskCode) {
+            _tasks[idx].task_code = pvTaskCode;
+            _tasks[idx].parameters = pvParameters;
+            break;
+        }
+    }
+    if (pvCreatedTask != NULL) {
+        *pvCreatedTask = (TaskHandle_t) pvTaskCode;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pvTaskCode, const char * const pcName, const uint32_t usStackDepth,
+                       void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pvCreatedTask) {
+    return xTaskCreatePinnedToCore(pvTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pvCreatedTask, 0);
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete) {
+    (void) xTaskToDelete;
+}
+
+void mjd_host_run_task_at_next_delay(TaskHandle_t param_task_handle) {
+    _task_to_run_at_next_delay = (TaskFunction_t) param_task_handle;
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay) {
+    _host_time_us += (uint64_t) xTicksToDelay * portTICK_PERIOD_MS * 1000;
+
+    // One shot: the task may call vTaskDelay() itself
+    TaskFunction_t task_code = _task_to_run_at_next_delay;
+    _task_to_run_at_next_delay = NULL;
+    for (uint32_t idx = 0; task_code != NULL && idx < MJD_HOST_MAX_TASKS; idx++) {
+        if (_tasks[idx].task_code == task_code) {
+            task_code(_tasks[idx].parameters);
+            break;
+        }
+    }
+}
+
+void vTaskDelayUntil(TickType_t * const pxPreviousWakeTime, const TickType_t xTimeIncrement) {
+    const TickType_t now = xTaskGetTickCount();
+
+    *pxPreviousWakeTime += xTimeIncrement;
+    if (*pxPreviousWakeTime > now) {
+        vTaskDelay(*pxPreviousWakeTime - now);
+    }
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t) (_host_time_us / 1000 / portTICK_PERIOD_MS);
+}
+
+TickType_t xTaskGetTickCountFromISR(void) {
+    return xTaskGetTickCount();
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask) {
+    (void) xTask;
+    return 4096;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return (TaskHandle_t) &_host_time_us;
+}
+
+void vTaskSuspendAll(void) {
+}
+
+BaseType_t xTaskResumeAll(void) {
+    return pdFALSE;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify) {
+    (void) xTaskToNotify;
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait) {
+    (void) xClearCountOnExit;
+    vTaskDelay(xTicksToWait == portMAX_DELAY ? 1 : xTicksToWait); // Nobody notifies on the host: time out
+    return 0;
+}
+
+/**********
+ * FreeRTOS: queues and semaphores
+ */
+struct mjd_host_queue {
+    uint8_t *storage;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize) {
+    struct mjd_host_queue *q = calloc(1, sizeof(*q));
+    if (q == NULL) {
+        return NULL;
+    }
+    q->length = uxQueueLength;
+    q->item_size = uxItemSize;
+    if (uxItemSize > 0) {
+        q->storage = calloc(uxQueueLength, uxItemSize);
+        if (q->storage == NULL) {
+            free(q);
+            return NULL;
+        }
+    }
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t xQueue) {
+    if (xQueue == NULL) {
+        return;
+    }
+    free(xQueue->storage);
+    free(xQueue);
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t xQueue, const void * pvItemToQueue, TickType_t xTicksToWait) {
+    (void) xTicksToWait;
+    if (xQueue->count >= xQueue->length) {
+        return pdFALSE; // errQUEUE_FULL
+    }
+    if (xQueue->item_size > 0) {
+        UBaseType_t tail = (xQueue->head + xQueue->count) % xQueue->length;
+        memcpy(xQueue->storage + tail * xQueue->item_size, pvItemToQueue, xQueue->item_size);
+    }
+    xQueue->count++;
+    return pdTRUE;
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void * pvItemToQueue, TickType_t xTicksToWait) {
+    return xQueueSendToBack(xQueue, pvItemToQueue, xTicksToWait);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t xQueue, const void * pvItemToQueue, BaseType_t *pxHigherPriorityTaskWoken) {
+    if (pxHigherPriorityTaskWoken != NULL) {
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    }
+    return xQueueSendToBack(xQueue, pvItemToQueue, 0);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t xQueue, const void * pvItemToQueue) {
+    // FreeRTOS only allows this for queues of length 1
+    xQueue->head = 0;
+    xQueue->count = 0;
+    return xQueueSendToBack(xQueue, pvItemToQueue, 0);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait) {
+    (void) xTicksToWait;
+    if (xQueue->count == 0) {
+        return pdFALSE;
+    }
+    if (xQueue->item_size > 0) {
+        memcpy(pvBuffer, xQueue->storage + xQueue->head * xQueue->item_size, xQueue->item_size);
+    }
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait) {
+    if (xQueuePeek(xQueue, pvBuffer, xTicksToWait) != pdTRUE) {
+        // Model the blocking wait: the simulated time moves forward by the timeout (portMAX_DELAY excluded)
+        if (xTicksToWait != portMAX_DELAY) {
+            vTaskDelay(xTicksToWait);
+        }
+        return pdFALSE;
+    }
+    xQueue->head = (xQueue->head + 1) % xQueue->length;
+    xQueue->count--;
+    return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t xQueue) {
+    xQueue->head = 0;
+    xQueue->count = 0;
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue) {
+    return xQueue->count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(const QueueHandle_t xQueue) {
+    return xQueue->length - xQueue->count;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    SemaphoreHandle_t sem = xQueueCreate(1, 0);
+    if (sem != NULL) {
+        xQueueSendToBack(sem, NULL, 0);
+    }
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount, UBaseType_t uxInitialCount) {
+    SemaphoreHandle_t sem = xQueueCreate(uxMaxCount, 0);
+    if (sem != NULL) {
+        sem->count = uxInitialCount;
+    }
+    return sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime) {
+    return xQueueReceive(xSemaphore, NULL, xBlockTime);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore) {
+    return xQueueSendToBack(xSemaphore, NULL, 0);
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t xSemaphore, BaseType_t *pxHigherPriorityTaskWoken) {
+    return xQueueSendFromISR(xSemaphore, NULL, pxHigherPriorityTaskWoken);
+}
+
+/**********
+ * FreeRTOS: event groups
+ */
+struct mjd_host_event_group {
+    EventBits_t bits;
+};
+
+EventGroupHandle_t xEventGroupCreate(void) {
+    return calloc(1, sizeof(struct mjd_host_event_group));
+}
+
+void vEventGroupDelete(EventGroupHandle_t xEventGroup) {
+    free(xEventGroup);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet) {
+    xEventGroup->bits |= uxBitsToSet;
+    return xEventGroup->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToClear) {
+    EventBits_t previous = xEventGroup->bits;
+    xEventGroup->bits &= ~uxBitsToClear;
+    return previous;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t xEventGroup) {
+    return xEventGroup->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToWaitFor, const BaseType_t xClearOnExit,
+                                const BaseType_t xWaitForAllBits, TickType_t xTicksToWait) {
+    EventBits_t current = xEventGroup->bits;
+    bool satisfied = (xWaitForAllBits == pdTRUE) ? ((current & uxBitsToWaitFor) == uxBitsToWaitFor) : ((current & uxBitsToWaitFor) != 0);
+    if (satisfied && xClearOnExit == pdTRUE) {
+        xEventGroup->bits &= ~uxBitsToWaitFor;
+    }
+    if (!satisfied && xTicksToWait != portMAX_DELAY) {
+        vTaskDelay(xTicksToWait);
+    }
+    return current;
+}
+
+/**********
+ * FreeRTOS: ring buffers (no-split model)
+ */
+typedef struct mjd_host_ringbuf_item {
+    struct mjd_host_ringbuf_item *next;
+    size_t size;
+    uint8_t data[];
+} mjd_host_ringbuf_item_t;
+
+struct mjd_host_ringbuf {
+    size_t capacity;
+    size_t used;
+    mjd_host_ringbuf_item_t *head;
+    mjd_host_ringbuf_item_t *tail;
+};
+
+RingbufHandle_t xRingbufferCreate(size_t xBufferSize, ringbuf_type_t xBufferType) {
+    (void) xBufferType;
+    RingbufHandle_t rb = calloc(1, sizeof(*rb));
+    if (rb != NULL) {
+        rb->capacity = xBufferSize;
+    }
+    return rb;
+}
+
+void vRingbufferDelete(RingbufHandle_t xRingbuffer) {
+    if (xRingbuffer == NULL) {
+        return;
+    }
+    while (xRingbuffer->head != NULL) {
+        mjd_host_ringbuf_item_t *next = xRingbuffer->head->next;
+        free(xRingbuffer->head);
+        xRingbuffer->head = next;
+    }
+    free(xRingbuffer);
+}
+
+BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer, const void *pvItem, size_t xItemSize, TickType_t xTicksToWait) {
+    (void) xTicksToWait;
+    if (xRingbuffer->used + xItemSize > xRingbuffer->capacity) {
+        return pdFALSE;
+    }
+    mjd_host_ringbuf_item_t *item = malloc(sizeof(*item) + xItemSize);
+    if (item == NULL) {
+        return pdFALSE;
+    }
+    item->next = NULL;
+    item->size = xItemSize;
+    memcpy(item->data, pvItem, xItemSize);
+    if (xRingbuffer->tail == NULL) {
+        xRingbuffer->head = item;
+    } else {
+        xRingbuffer->tail->next = item;
+    }
+    xRingbuffer->tail = item;
+    xRingbuffer->used += xItemSize;
+    return pdTRUE;
+}
+
+void *xRingbufferReceive(RingbufHandle_t xRingbuffer, size_t *pxItemSize, TickType_t xTicksToWait) {
+    mjd_host_ringbuf_item_t *item = xRingbuffer->head;
+    if (item == NULL) {
+        if (xTicksToWait != portMAX_DELAY) {
+            vTaskDelay(xTicksToWait);
+        }
+        return NULL;
+    }
+    xRingbuffer->head = item->next;
+    if (xRingbuffer->head == NULL) {
+        xRingbuffer->tail = NULL;
+    }
+    xRingbuffer->used -= item->size;
+    if (pxItemSize != NULL) {
+        *pxItemSize = item->size;
+    }
+    return item->data;
+}
+
+void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void *pvItem) {
+    (void) xRingbuffer;
+    if (pvItem == NULL) {
+        return;
+    }
+    free((uint8_t *) pvItem - offsetof(mjd_host_ringbuf_item_t, data));
+}
+
+/**********
+ * GPIO
+ */
+static uint32_t _gpio_input_levels[GPIO_NUM_MAX];
+static uint32_t _gpio_output_levels[GPIO_NUM_MAX];
+
+void mjd_host_gpio_set_input(gpio_num_t param_gpio_num, uint32_t param_level) {
+    if (param_gpio_num < GPIO_NUM_MAX) {
+        _gpio_input_levels[param_gpio_num] = param_level;
+    }
+}
+
+uint32_t mjd_host_gpio_get_output(gpio_num_t param_gpio_num) {
+    return (param_gpio_num < GPIO_NUM_MAX) ? _gpio_output_levels[param_gpio_num] : 0;
+}
+
+esp_err_t gpio_config(const gpio_config_t *pGPIOConfig) {
+    return (pGPIOConfig == NULL) ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+    if (gpio_num >= GPIO_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    _gpio_output_levels[gpio_num] = level;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+    return (gpio_num < GPIO_NUM_MAX) ? (int) _gpio_input_levels[gpio_num] : 0;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode) {
+    (void) mode;
+    return (gpio_num < GPIO_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_pullup_en(gpio_num_t gpio_num) {
+    return (gpio_num < GPIO_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_pullup_dis(gpio_num_t gpio_num) {
+    return (gpio_num < GPIO_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num) {
+    return (gpio_num < GPIO_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_pulldown_en(gpio_num_t gpio_num) {
+    return (gpio_num < GPIO_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_pulldown_dis(gpio_num_t gpio_num) {
+    return (gpio_num < GPIO_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type) {
+    (void) intr_type;
+    return (gpio_num < GPIO_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags) {
+    (void) intr_alloc_flags;
+    return ESP_OK;
+}
+
+void gpio_uninstall_isr_service(void) {
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void* args) {
+    (void) isr_handler;
+    (void) args;
+    return (gpio_num < GPIO_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num) {
+    return (gpio_num < GPIO_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num) {
+    return (gpio_num < GPIO_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num) {
+    return (gpio_num < GPIO_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+/**********
+ * I2C: a command link records its operations, i2c_master_cmd_begin() executes them against the register map of a simulated slave.
+ *
+ * @doc The first byte written after a START is the address byte. The first byte of a write transfer sets the register pointer,
+ *      the next bytes are stored in the registers. Reads copy the registers. The register pointer auto-increments (wraps at 256).
+ * @doc No simulated slave at the address: the writes are ignored and the reads return 0x00 (the transaction succeeds).
+ */
+#define I2C_CMD_LINK_MAX_OPS (32)
+#define I2C_MAX_SLAVES (4)
+
+typedef enum {
+    I2C_OP_START = 0,
+    I2C_OP_STOP,
+    I2C_OP_WRITE,
+    I2C_OP_READ,
+} i2c_op_type_t;
+
+typedef struct {
+    i2c_op_type_t type;
+    uint8_t byte; /* write_byte() */
+    uint8_t* ptr_data; /* write() | read() | read_byte(): the caller's buffer (as ESP-IDF: valid until cmd_begin) */
+    size_t data_len;
+} i2c_op_t;
+
+typedef struct {
+    i2c_op_t ops[I2C_CMD_LINK_MAX_OPS];
+    uint32_t nbr_of_ops;
+} i2c_cmd_link_t;
+
+typedef struct {
+    bool is_active;
+    uint8_t slave_addr;
+    uint8_t registers[256];
+} i2c_slave_t;
+
+static esp_err_t _i2c_cmd_begin_retval = ESP_OK;
+static uint32_t _i2c_nbr_of_transactions = 0;
+static i2c_slave_t _i2c_slaves[I2C_MAX_SLAVES];
+
+void mjd_host_i2c_set_cmd_begin_retval(esp_err_t param_retval) {
+    _i2c_cmd_begin_retval = param_retval;
+}
+
+uint32_t mjd_host_i2c_get_nbr_of_transactions(void) {
+    return _i2c_nbr_of_transactions;
+}
+
+static i2c_slave_t * _i2c_find_slave(uint8_t slave_addr) {
+    for (uint32_t idx = 0; idx < I2C_MAX_SLAVES; idx++) {
+        if (_i2c_slaves[idx].is_active == true && _i2c_slaves[idx].slave_addr == slave_addr) {
+            return &_i2c_slaves[idx];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t mjd_host_i2c_set_registers(uint8_t param_slave_addr, uint8_t param_reg_addr, const uint8_t *param_ptr_data, size_t param_len) {
+    i2c_slave_t* ptr_slave = _i2c_find_slave(param_slave_addr);
+
+    if (ptr_slave == NULL) {
+        for (uint32_t idx = 0; idx < I2C_MAX_SLAVES && ptr_slave == NULL; idx++) {
+            if (_i2c_slaves[idx].is_active == false) {
+                ptr_slave = &_i2c_slaves[idx];
+                memset(ptr_slave, 0, sizeof(*ptr_slave));
+                ptr_slave->is_active = true;
+                ptr_slave->slave_addr = param_slave_addr;
+            }
+        }
+    }
+    if (ptr_slave == NULL || param_reg_addr + param_len > sizeof(ptr_slave->registers)) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(&ptr_slave->registers[param_reg_addr], param_ptr_data, param_len);
+    return ESP_OK;
+}
+
+esp_err_t mjd_host_i2c_get_registers(uint8_t param_slave_addr, uint8_t param_reg_addr, uint8_t *param_ptr_buf, size_t param_len) {
+    i2c_slave_t* ptr_slave = _i2c_find_slave(param_slave_addr);
+
+    if (ptr_slave == NULL || param_reg_addr + param_len > sizeof(ptr_slave->registers)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    memcpy(param_ptr_buf, &ptr_slave->registers[param_reg_addr], param_len);
+    return ESP_OK;
+}
+
+esp_err_t i2c_param_config(i2c_port_t i2c_num, const i2c_config_t* i2c_conf) {
+    (void) i2c_conf;
+    return (i2c_num < I2C_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t i2c_driver_install(i2c_port_t i2c_num, i2c_mode_t mode, size_t slv_rx_buf_len, size_t slv_tx_buf_len, int intr_alloc_flags) {
+    (void) mode;
+    (void) slv_rx_buf_len;
+    (void) slv_tx_buf_len;
+    (void) intr_alloc_flags;
+    return (i2c_num < I2C_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t i2c_driver_delete(i2c_port_t i2c_num) {
+    return (i2c_num < I2C_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+i2c_cmd_handle_t i2c_cmd_link_create(void) {
+    return calloc(1, sizeof(i2c_cmd_link_t));
+}
+
+void i2c_cmd_link_delete(i2c_cmd_handle_t cmd_handle) {
+    free(cmd_handle);
+}
+
+static esp_err_t _i2c_add_op(i2c_cmd_handle_t cmd_handle, i2c_op_type_t type, uint8_t byte, uint8_t* ptr_data, size_t data_len) {
+    i2c_cmd_link_t* ptr_link = (i2c_cmd_link_t*) cmd_handle;
+
+    if (ptr_link == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (ptr_link->nbr_of_ops >= I2C_CMD_LINK_MAX_OPS) {
+        return ESP_ERR_NO_MEM;
+    }
+    ptr_link->ops[ptr_link->nbr_of_ops].type = type;
+    ptr_link->ops[ptr_link->nbr_of_ops].byte = byte;
+    ptr_link->ops[ptr_link->nbr_of_ops].ptr_data = ptr_data;
+    ptr_link->ops[ptr_link->nbr_of_ops].data_len = data_len;
+    ++ptr_link->nbr_of_ops;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd_handle) {
+    return _i2c_add_op(cmd_handle, I2C_OP_START, 0, NULL, 0);
+}
+
+esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd_handle) {
+    return _i2c_add_op(cmd_handle, I2C_OP_STOP, 0, NULL, 0);
+}
+
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd_handle, uint8_t data, bool ack_en) {
+    (void) ack_en;
+    return _i2c_add_op(cmd_handle, I2C_OP_WRITE, data, NULL, 1);
+}
+
+esp_err_t i2c_master_write(i2c_cmd_handle_t cmd_handle, uint8_t* data, size_t data_len, bool ack_en) {
+    (void) ack_en;
+    return _i2c_add_op(cmd_handle, I2C_OP_WRITE, 0, data, data_len);
+}
+
+esp_err_t i2c_master_read_byte(i2c_cmd_handle_t cmd_handle, uint8_t* data, i2c_ack_type_t ack) {
+    (void) ack;
+    return _i2c_add_op(cmd_handle, I2C_OP_READ, 0, data, 1);
+}
+
+esp_err_t i2c_master_read(i2c_cmd_handle_t cmd_handle, uint8_t* data, size_t data_len, i2c_ack_type_t ack) {
+    (void) ack;
+    return _i2c_add_op(cmd_handle, I2C_OP_READ, 0, data, data_len);
+}
+
+esp_err_t i2c_master_cmd_begin(i2c_port_t i2c_num, i2c_cmd_handle_t cmd_handle, TickType_t ticks_to_wait) {
+    (void) ticks_to_wait;
+    if (i2c_num >= I2C_NUM_MAX || cmd_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ++_i2c_nbr_of_transactions;
+    if (_i2c_cmd_begin_retval != ESP_OK) {
+        return _i2c_cmd_begin_retval;
+    }
+
+    const i2c_cmd_link_t* ptr_link = (const i2c_cmd_link_t*) cmd_handle;
+    i2c_slave_t* ptr_slave = NULL;
+    bool expect_address_byte = false;
+    bool expect_register_pointer = false;
+    uint8_t register_pointer = 0;
+
+    for (uint32_t idx_op = 0; idx_op < ptr_link->nbr_of_ops; idx_op++) {
+        const i2c_op_t* ptr_op = &ptr_link->ops[idx_op];
+
+        switch (ptr_op->type) {
+        case I2C_OP_START:
+            expect_address_byte = true;
+            break;
+        case I2C_OP_STOP:
+            ptr_slave = NULL;
+            break;
+        case I2C_OP_WRITE:
+            for (size_t idx = 0; idx < ptr_op->data_len; idx++) {
+                const uint8_t byte = (ptr_op->ptr_data != NULL) ? ptr_op->ptr_data[idx] : ptr_op->byte;
+                if (expect_address_byte == true) {
+                    uint8_t slave_addr = byte >> 1;
+                    if (ptr_slave == NULL || ptr_slave->slave_addr != slave_addr) {
+                        // A repeated START to the same slave keeps the register pointer
+                        register_pointer = 0;
+                    }
+                    ptr_slave = _i2c_find_slave(slave_addr);
+                    expect_address_byte = false;
+                    expect_register_pointer = ((byte & 0x01) == I2C_MASTER_WRITE);
+                } else if (expect_register_pointer == true) {
+                    register_pointer = byte;
+                    expect_register_pointer = false;
+                } else if (ptr_slave != NULL) {
+                    ptr_slave->registers[register_pointer++] = byte;
+                }
+            }
+            break;
+        case I2C_OP_READ:
+            for (size_t idx = 0; idx < ptr_op->data_len; idx++) {
+                ptr_op->ptr_data[idx] = (ptr_slave != NULL) ? ptr_slave->registers[register_pointer++] : 0x00;
+            }
+            break;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t i2c_set_timeout(i2c_port_t i2c_num, int timeout) {
+    (void) timeout;
+    return (i2c_num < I2C_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+/**********
+ * UART: TX capture + injected RX
+ */
+typedef struct {
+    uint8_t tx[MJD_HOST_UART_BUFFER_SIZE];
+    size_t tx_len;
+    uint8_t rx[MJD_HOST_UART_BUFFER_SIZE];
+    size_t rx_head;
+    size_t rx_len;
+    uint32_t baudrate;
+} mjd_host_uart_t;
+
+static mjd_host_uart_t _uarts[UART_NUM_MAX];
+
+esp_err_t mjd_host_uart_inject_rx(uart_port_t param_uart_num, const uint8_t *param_ptr_data, size_t param_len) {
+    if (param_uart_num >= UART_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    mjd_host_uart_t *uart = &_uarts[param_uart_num];
+    // Compact the consumed bytes first
+    memmove(uart->rx, uart->rx + uart->rx_head, uart->rx_len);
+    uart->rx_head = 0;
+    if (uart->rx_len + param_len > sizeof(uart->rx)) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(uart->rx + uart->rx_len, param_ptr_data, param_len);
+    uart->rx_len += param_len;
+    return ESP_OK;
+}
+
+size_t mjd_host_uart_get_tx(uart_port_t param_uart_num, uint8_t *param_ptr_buf, size_t param_buf_len) {
+    if (param_uart_num >= UART_NUM_MAX) {
+        return 0;
+    }
+    mjd_host_uart_t *uart = &_uarts[param_uart_num];
+    size_t len = (uart->tx_len < param_buf_len) ? uart->tx_len : param_buf_len;
+    memcpy(param_ptr_buf, uart->tx, len);
+    return len;
+}
+
+void mjd_host_uart_clear_tx(uart_port_t param_uart_num) {
+    if (param_uart_num < UART_NUM_MAX) {
+        _uarts[param_uart_num].tx_len = 0;
+    }
+}
+
+esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t *uart_config) {
+    if (uart_num >= UART_NUM_MAX || uart_config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    _uarts[uart_num].baudrate = uart_config->baud_rate;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io_num, int rx_io_num, int rts_io_num, int cts_io_num) {
+    (void) tx_io_num;
+    (void) rx_io_num;
+    (void) rts_io_num;
+    (void) cts_io_num;
+    return (uart_num < UART_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size, int queue_size, QueueHandle_t* uart_queue, int intr_alloc_flags) {
+    (void) rx_buffer_size;
+    (void) tx_buffer_size;
+    (void) intr_alloc_flags;
+    if (uart_num >= UART_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (uart_queue != NULL) {
+        *uart_queue = (queue_size > 0) ? xQueueCreate(queue_size, sizeof(uart_event_t)) : NULL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t uart_driver_delete(uart_port_t uart_num) {
+    return (uart_num < UART_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t uart_set_baudrate(uart_port_t uart_num, uint32_t baudrate) {
+    if (uart_num >= UART_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    _uarts[uart_num].baudrate = baudrate;
+    return ESP_OK;
+}
+
+esp_err_t uart_get_baudrate(uart_port_t uart_num, uint32_t* baudrate) {
+    if (uart_num >= UART_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *baudrate = _uarts[uart_num].baudrate;
+    return ESP_OK;
+}
+
+int uart_write_bytes(uart_port_t uart_num, const char* src, size_t size) {
+    if (uart_num >= UART_NUM_MAX) {
+        return -1;
+    }
+    mjd_host_uart_t *uart = &_uarts[uart_num];
+    size_t room = sizeof(uart->tx) - uart->tx_len;
+    size_t len = (size < room) ? size : room;
+    memcpy(uart->tx + uart->tx_len, src, len);
+    uart->tx_len += len;
+    return (int) size;
+}
+
+int uart_read_bytes(uart_port_t uart_num, uint8_t* buf, uint32_t length, TickType_t ticks_to_wait) {
+    if (uart_num >= UART_NUM_MAX) {
+        return -1;
+    }
+    mjd_host_uart_t *uart = &_uarts[uart_num];
+    size_t len = (length < uart->rx_len) ? length : uart->rx_len;
+    if (len == 0 && ticks_to_wait != portMAX_DELAY) {
+        vTaskDelay(ticks_to_wait);
+    }
+    memcpy(buf, uart->rx + uart->rx_head, len);
+    uart->rx_head += len;
+    uart->rx_len -= len;
+    return (int) len;
+}
+
+esp_err_t uart_set_line_inverse(uart_port_t uart_num, uint32_t inverse_mask) {
+    (void) inverse_mask;
+    return (uart_num < UART_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t uart_flush_input(uart_port_t uart_num) {
+    if (uart_num >= UART_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    _uarts[uart_num].rx_head = 0;
+    _uarts[uart_num].rx_len = 0;
+    return ESP_OK;
+}
+
+esp_err_t uart_flush(uart_port_t uart_num) {
+    return uart_flush_input(uart_num);
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t uart_num, size_t* size) {
+    if (uart_num >= UART_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *size = _uarts[uart_num].rx_len;
+    return ESP_OK;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t uart_num, TickType_t ticks_to_wait) {
+    (void) ticks_to_wait;
+    return (uart_num < UART_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+/**********
+ * RMT: TX recording + RX ring buffer per channel
+ */
+#define MJD_HOST_RMT_MAX_TX_ITEMS (8192)
+
+typedef struct {
+    RingbufHandle_t rx_ringbuf;
+    sample_to_rmt_t translator;
+    rmt_item32_t tx_items[MJD_HOST_RMT_MAX_TX_ITEMS];
+    size_t nbr_of_tx_items;
+} mjd_host_rmt_t;
+
+static mjd_host_rmt_t _rmts[RMT_CHANNEL_MAX];
+
+esp_err_t mjd_host_rmt_inject_rx_items(rmt_channel_t param_channel, const rmt_item32_t *param_ptr_items, size_t param_nbr_of_items) {
+    if (param_channel >= RMT_CHANNEL_MAX || _rmts[param_channel].rx_ringbuf == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xRingbufferSend(_rmts[param_channel].rx_ringbuf, param_ptr_items, param_nbr_of_items * sizeof(rmt_item32_t), 0) != pdTRUE) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+size_t mjd_host_rmt_get_nbr_of_tx_items(rmt_channel_t param_channel) {
+    return (param_channel < RMT_CHANNEL_MAX) ? _rmts[param_channel].nbr_of_tx_items : 0;
+}
+
+const rmt_item32_t * mjd_host_rmt_get_tx_items(rmt_channel_t param_channel) {
+    return (param_channel < RMT_CHANNEL_MAX) ? _rmts[param_channel].tx_items : NULL;
+}
+
+esp_err_t rmt_config(const rmt_config_t* rmt_param) {
+    return (rmt_param != NULL && rmt_param->channel < RMT_CHANNEL_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags) {
+    (void) intr_alloc_flags;
+    if (channel >= RMT_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (rx_buf_size > 0 && _rmts[channel].rx_ringbuf == NULL) {
+        _rmts[channel].rx_ringbuf = xRingbufferCreate(rx_buf_size, RINGBUF_TYPE_NOSPLIT);
+    }
+    _rmts[channel].nbr_of_tx_items = 0;
+    return ESP_OK;
+}
+
+esp_err_t rmt_driver_uninstall(rmt_channel_t channel) {
+    if (channel >= RMT_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    vRingbufferDelete(_rmts[channel].rx_ringbuf);
+    _rmts[channel].rx_ringbuf = NULL;
+    _rmts[channel].translator = NULL;
+    return ESP_OK;
+}
+
+esp_err_t rmt_rx_start(rmt_channel_t channel, bool rx_idx_rst) {
+    (void) rx_idx_rst;
+    return (channel < RMT_CHANNEL_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t rmt_rx_stop(rmt_channel_t channel) {
+    return (channel < RMT_CHANNEL_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t rmt_set_rx_idle_thresh(rmt_channel_t channel, uint16_t thresh) {
+    (void) thresh;
+    return (channel < RMT_CHANNEL_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t rmt_tx_start(rmt_channel_t channel, bool tx_idx_rst) {
+    (void) tx_idx_rst;
+    return (channel < RMT_CHANNEL_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t rmt_tx_stop(rmt_channel_t channel) {
+    return (channel < RMT_CHANNEL_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t rmt_get_ringbuf_handle(rmt_channel_t channel, RingbufHandle_t* buf_handle) {
+    if (channel >= RMT_CHANNEL_MAX || buf_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *buf_handle = _rmts[channel].rx_ringbuf;
+    return ESP_OK;
+}
+
+esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t* rmt_item, int item_num, bool wait_tx_done) {
+    (void) wait_tx_done;
+    if (channel >= RMT_CHANNEL_MAX || rmt_item == NULL || item_num <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    mjd_host_rmt_t *rmt = &_rmts[channel];
+    size_t len = (size_t) item_num;
+    if (len > MJD_HOST_RMT_MAX_TX_ITEMS) {
+        len = MJD_HOST_RMT_MAX_TX_ITEMS;
+    }
+    memcpy(rmt->tx_items, rmt_item, len * sizeof(rmt_item32_t));
+    rmt->nbr_of_tx_items = len;
+    return ESP_OK;
+}
+
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait_time) {
+    (void) wait_time;
+    return (channel < RMT_CHANNEL_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t rmt_translator_init(rmt_channel_t channel, sample_to_rmt_t fn) {
+    if (channel >= RMT_CHANNEL_MAX || fn == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    _rmts[channel].translator = fn;
+    return ESP_OK;
+}
+
+esp_err_t rmt_write_sample(rmt_channel_t channel, const uint8_t *src, size_t src_size, bool wait_tx_done) {
+    (void) wait_tx_done;
+    if (channel >= RMT_CHANNEL_MAX || _rmts[channel].translator == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // Same contract as the IDF driver: the translator is called repeatedly with a bounded number of wanted items
+    mjd_host_rmt_t *rmt = &_rmts[channel];
+    rmt->nbr_of_tx_items = 0;
+    size_t offset = 0;
+    while (offset < src_size) {
+        size_t translated_size = 0;
+        size_t item_num = 0;
+        size_t wanted_num = 64;
+        if (rmt->nbr_of_tx_items + wanted_num > MJD_HOST_RMT_MAX_TX_ITEMS) {
+            return ESP_ERR_NO_MEM;
+        }
+        rmt->translator(src + offset, rmt->tx_items + rmt->nbr_of_tx_items, src_size - offset, wanted_num, &translated_size, &item_num);
+        if (translated_size == 0) {
+            return ESP_FAIL;
+        }
+        offset += translated_size;
+        rmt->nbr_of_tx_items += item_num;
+    }
+    return ESP_OK;
+}
+
+esp_err_t rmt_set_tx_intr_en(rmt_channel_t channel, bool en) {
+    (void) en;
+    return (channel < RMT_CHANNEL_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t rmt_set_pin(rmt_channel_t channel, rmt_mode_t mode, gpio_num_t gpio_num) {
+    (void) mode;
+    (void) gpio_num;
+    return (channel < RMT_CHANNEL_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+/**********
+ * NVS: in-memory emulator
+ *
+ * @doc The integers are stored as 8 bytes (the type tells the size), strings and blobs as is (max MJD_HOST_NVS_VALUE_MAX_SIZE).
+ */
+#define MJD_HOST_NVS_MAX_ITEMS      (128)
+#define MJD_HOST_NVS_MAX_HANDLES    (8)
+#define MJD_HOST_NVS_NAME_MAX_SIZE  (16)
+#define MJD_HOST_NVS_VALUE_MAX_SIZE (256)
+#define MJD_HOST_NVS_ENTRY_SIZE     (32)
+
+typedef enum {
+    _NVS_TYPE_I8 = 1, _NVS_TYPE_U8, _NVS_TYPE_I16, _NVS_TYPE_U16, _NVS_TYPE_I32, _NVS_TYPE_U32, _NVS_TYPE_I64, _NVS_TYPE_U64,
+    _NVS_TYPE_STR, _NVS_TYPE_BLOB
+} _nvs_type_t;
+
+typedef struct {
+    bool is_used;
+    char partition[MJD_HOST_NVS_NAME_MAX_SIZE];
+    char name_space[MJD_HOST_NVS_NAME_MAX_SIZE];
+    char key[MJD_HOST_NVS_NAME_MAX_SIZE];
+    _nvs_type_t type;
+    size_t len;
+    uint8_t data[MJD_HOST_NVS_VALUE_MAX_SIZE];
+} _nvs_item_t;
+
+typedef struct {
+    bool is_open;
+    char partition[MJD_HOST_NVS_NAME_MAX_SIZE];
+    char name_space[MJD_HOST_NVS_NAME_MAX_SIZE];
+    nvs_open_mode open_mode;
+} _nvs_open_handle_t;
+
+static _nvs_item_t _nvs_items[MJD_HOST_NVS_MAX_ITEMS];
+static _nvs_open_handle_t _nvs_handles[MJD_HOST_NVS_MAX_HANDLES];
+static bool _nvs_is_initialized = false;
+static esp_err_t _nvs_write_retval = ESP_OK;
+static uint32_t _nvs_nbr_of_entries_written = 0;
+static uint32_t _nvs_nbr_of_commits = 0;
+
+static _nvs_open_handle_t * _nvs_get_handle(nvs_handle handle) {
+    if (handle == 0 || handle > MJD_HOST_NVS_MAX_HANDLES || _nvs_handles[handle - 1].is_open == false) {
+        return NULL;
+    }
+    return &_nvs_handles[handle - 1];
+}
+
+static _nvs_item_t * _nvs_find(const _nvs_open_handle_t *ptr_handle, const char *key) {
+    for (uint32_t idx = 0; idx < MJD_HOST_NVS_MAX_ITEMS; idx++) {
+        _nvs_item_t *ptr_item = &_nvs_items[idx];
+        if (ptr_item->is_used == true && strcmp(ptr_item->partition, ptr_handle->partition) == 0
+                && strcmp(ptr_item->name_space, ptr_handle->name_space) == 0 && strcmp(ptr_item->key, key) == 0) {
+            return ptr_item;
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t _nvs_set(nvs_handle handle, const char *key, _nvs_type_t type, const void *data, size_t len) {
+    _nvs_open_handle_t *ptr_handle = _nvs_get_handle(handle);
+    _nvs_item_t *ptr_item;
+
+    if (ptr_handle == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (ptr_handle->open_mode == NVS_READONLY) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    if (key == NULL || strlen(key) >= MJD_HOST_NVS_NAME_MAX_SIZE) {
+        return ESP_ERR_NVS_KEY_TOO_LONG;
+    }
+    if (len > MJD_HOST_NVS_VALUE_MAX_SIZE) {
+        return ESP_ERR_NVS_VALUE_TOO_LONG;
+    }
+    if (_nvs_write_retval != ESP_OK) {
+        return _nvs_write_retval;
+    }
+
+    ptr_item = _nvs_find(ptr_handle, key);
+    for (uint32_t idx = 0; ptr_item == NULL && idx < MJD_HOST_NVS_MAX_ITEMS; idx++) {
+        if (_nvs_items[idx].is_used == false) {
+            ptr_item = &_nvs_items[idx];
+        }
+    }
+    if (ptr_item == NULL) {
+        return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+
+    ptr_item->is_used = true;
+    strcpy(ptr_item->partition, ptr_handle->partition);
+    strcpy(ptr_item->name_space, ptr_handle->name_space);
+    strcpy(ptr_item->key, key);
+    ptr_item->type = type;
+    ptr_item->len = len;
+    memcpy(ptr_item->data, data, len);
+
+    _nvs_nbr_of_entries_written += 1;
+    if (type == _NVS_TYPE_STR || type == _NVS_TYPE_BLOB) {
+        _nvs_nbr_of_entries_written += (uint32_t) ((len + MJD_HOST_NVS_ENTRY_SIZE - 1) / MJD_HOST_NVS_ENTRY_SIZE);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _nvs_get(nvs_handle handle, const char *key, _nvs_type_t type, void *out_data, size_t *ptr_len) {
+    _nvs_open_handle_t *ptr_handle = _nvs_get_handle(handle);
+    _nvs_item_t *ptr_item;
+
+    if (ptr_handle == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    ptr_item = (key != NULL) ? _nvs_find(ptr_handle, key) : NULL;
+    if (ptr_item == NULL || ptr_item->type != type) {
+        return ESP_ERR_NVS_NOT_FOUND; // Like the real NVS: a key is looked up with its type
+    }
+    if (out_data != NULL) {
+        if (*ptr_len < ptr_item->len) {
+            return ESP_ERR_NVS_INVALID_LENGTH;
+        }
+        memcpy(out_data, ptr_item->data, ptr_item->len);
+    }
+    *ptr_len = ptr_item->len;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_init(void) {
+    return nvs_flash_init_partition(NVS_DEFAULT_PART_NAME);
+}
+
+esp_err_t nvs_flash_init_partition(const char *partition_label) {
+    (void) partition_label;
+    _nvs_is_initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+    return nvs_flash_erase_partition(NVS_DEFAULT_PART_NAME);
+}
+
+esp_err_t nvs_flash_erase_partition(const char *part_name) {
+    for (uint32_t idx = 0; idx < MJD_HOST_NVS_MAX_ITEMS; idx++) {
+        if (_nvs_items[idx].is_used == true && strcmp(_nvs_items[idx].partition, part_name) == 0) {
+            _nvs_items[idx].is_used = false;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode open_mode, nvs_handle *out_handle) {
+    return nvs_open_from_partition(NVS_DEFAULT_PART_NAME, name, open_mode, out_handle);
+}
+
+esp_err_t nvs_open_from_partition(const char *part_name, const char* name, nvs_open_mode open_mode, nvs_handle *out_handle) {
+    if (_nvs_is_initialized == false) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    if (part_name == NULL || name == NULL || strlen(part_name) >= MJD_HOST_NVS_NAME_MAX_SIZE
+            || strlen(name) >= MJD_HOST_NVS_NAME_MAX_SIZE) {
+        return ESP_ERR_NVS_INVALID_NAME;
+    }
+    for (uint32_t idx = 0; idx < MJD_HOST_NVS_MAX_HANDLES; idx++) {
+        if (_nvs_handles[idx].is_open == false) {
+            _nvs_handles[idx].is_open = true;
+            strcpy(_nvs_handles[idx].partition, part_name);
+            strcpy(_nvs_handles[idx].name_space, name);
+            _nvs_handles[idx].open_mode = open_mode;
+            *out_handle = idx + 1;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+void nvs_close(nvs_handle handle) {
+    _nvs_open_handle_t *ptr_handle = _nvs_get_handle(handle);
+    if (ptr_handle != NULL) {
+        ptr_handle->is_open = false;
+    }
+}
+
+esp_err_t nvs_commit(nvs_handle handle) {
+    if (_nvs_get_handle(handle) == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    ++_nvs_nbr_of_commits;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle handle, const char* key) {
+    _nvs_open_handle_t *ptr_handle = _nvs_get_handle(handle);
+    _nvs_item_t *ptr_item;
+
+    if (ptr_handle == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (ptr_handle->open_mode == NVS_READONLY) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    ptr_item = _nvs_find(ptr_handle, key);
+    if (ptr_item == NULL) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    ptr_item->is_used = false;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_all(nvs_handle handle) {
+    _nvs_open_handle_t *ptr_handle = _nvs_get_handle(handle);
+
+    if (ptr_handle == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (ptr_handle->open_mode == NVS_READONLY) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    for (uint32_t idx = 0; idx < MJD_HOST_NVS_MAX_ITEMS; idx++) {
+        _nvs_item_t *ptr_item = &_nvs_items[idx];
+        if (ptr_item->is_used == true && strcmp(ptr_item->partition, ptr_handle->partition) == 0
+                && strcmp(ptr_item->name_space, ptr_handle->name_space) == 0) {
+            ptr_item->is_used = false;
+        }
+    }
+    return ESP_OK;
+}
+
+#define _NVS_INTEGER_FUNCTIONS(suffix, ctype, nvs_type)                                                  \
+    esp_err_t nvs_set_##suffix(nvs_handle handle, const char* key, ctype value) {                         \
+        return _nvs_set(handle, key, nvs_type, &value, sizeof(value));                                     \
+    }                                                                                                      \
+    esp_err_t nvs_get_##suffix(nvs_handle handle, const char* key, ctype* out_value) {                    \
+        size_t len = sizeof(*out_value);                                                                   \
+        return _nvs_get(handle, key, nvs_type, out_value, &len);                                           \
+    }
+
+_NVS_INTEGER_FUNCTIONS(i8, int8_t, _NVS_TYPE_I8)
+_NVS_INTEGER_FUNCTIONS(u8, uint8_t, _NVS_TYPE_U8)
+_NVS_INTEGER_FUNCTIONS(i16, int16_t, _NVS_TYPE_I16)
+_NVS_INTEGER_FUNCTIONS(u16, uint16_t, _NVS_TYPE_U16)
+_NVS_INTEGER_FUNCTIONS(i32, int32_t, _NVS_TYPE_I32)
+_NVS_INTEGER_FUNCTIONS(u32, uint32_t, _NVS_TYPE_U32)
+_NVS_INTEGER_FUNCTIONS(i64, int64_t, _NVS_TYPE_I64)
+_NVS_INTEGER_FUNCTIONS(u64, uint64_t, _NVS_TYPE_U64)
+
+esp_err_t nvs_set_str(nvs_handle handle, const char* key, const char* value) {
+    return _nvs_set(handle, key, _NVS_TYPE_STR, value, strlen(value) + 1);
+}
+
+esp_err_t nvs_set_blob(nvs_handle handle, const char* key, const void* value, size_t length) {
+    return _nvs_set(handle, key, _NVS_TYPE_BLOB, value, length);
+}
+
+esp_err_t nvs_get_str(nvs_handle handle, const char* key, char* out_value, size_t* length) {
+    return _nvs_get(handle, key, _NVS_TYPE_STR, out_value, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle handle, const char* key, void* out_value, size_t* length) {
+    return _nvs_get(handle, key, _NVS_TYPE_BLOB, out_value, length);
+}
+
+void mjd_host_nvs_set_write_retval(esp_err_t param_retval) {
+    _nvs_write_retval = param_retval;
+}
+
+uint32_t mjd_host_nvs_get_nbr_of_entries_written(void) {
+    return _nvs_nbr_of_entries_written;
+}
+
+uint32_t mjd_host_nvs_get_nbr_of_commits(void) {
+    return _nvs_nbr_of_commits;
+}
+
+/**********
+ * RESET (between test cases)
+ */
+void mjd_host_reset(void) {
+    _host_time_us = 0;
+    memset(_tasks, 0, sizeof(_tasks));
+    _task_to_run_at_next_delay = NULL;
+    memset(_gpio_input_levels, 0, sizeof(_gpio_input_levels));
+    memset(_gpio_output_levels, 0, sizeof(_gpio_output_levels));
+    _i2c_cmd_begin_retval = ESP_OK;
+    _i2c_nbr_of_transactions = 0;
+    memset(_i2c_slaves, 0, sizeof(_i2c_slaves));
+    memset(_uarts, 0, sizeof(_uarts));
+    for (uint32_t idx = 0; idx < RMT_CHANNEL_MAX; idx++) {
+        rmt_driver_uninstall(idx);
+        _rmts[idx].nbr_of_tx_items = 0;
+    }
+    memset(_nvs_items, 0, sizeof(_nvs_items));
+    memset(_nvs_handles, 0, sizeof(_nvs_handles));
+    _nvs_is_initialized = false;
+    _nvs_write_retval = ESP_OK;
+    _nvs_nbr_of_entries_written = 0;
+    _nvs_nbr_of_commits = 0;
+}
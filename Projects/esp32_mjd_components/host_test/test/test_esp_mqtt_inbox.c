@@ -0,0 +1,236 @@
+/*
+ * HOST TEST: esp-mqtt inbox (preallocated message slots, borrow/retain/release, tracked outbound messages)
+ */
+#include "mjd.h"
+#include "esp_mqtt_inbox.h"
+
+#include "mjd_test.h"
+
+#define TEST_NBR_OF_SLOTS (4)
+#define TEST_SLOT_SIZE    (64)
+
+static esp_mqtt_message_t *_ptr_last_message = NULL;
+static uint32_t _nbr_of_callbacks = 0;
+static bool _do_retain = false;
+
+static void _callback(esp_mqtt_message_t *ptr_message, void *ptr_ref) {
+    _ptr_last_message = ptr_message;
+    _nbr_of_callbacks++;
+    (*(uint32_t *) ptr_ref)++;
+    if (_do_retain == true) {
+        esp_mqtt_message_retain(ptr_message);
+    }
+}
+
+static bool _put(esp_mqtt_inbox_t *ptr_inbox, const char *topic, const char *payload) {
+    lwmqtt_string_t lw_topic = lwmqtt_string(topic);
+    lwmqtt_message_t lw_message = { .qos = LWMQTT_QOS1, .retained = true, .payload = (uint8_t *) payload, .payload_len = strlen(payload) };
+    return esp_mqtt_inbox_put(ptr_inbox, lw_topic, lw_message, 0);
+}
+
+static void _reset(void) {
+    _ptr_last_message = NULL;
+    _nbr_of_callbacks = 0;
+    _do_retain = false;
+}
+
+static void test_put_and_dispatch(void) {
+    esp_mqtt_inbox_t inbox;
+    uint32_t ref_count = 0;
+    char read_buf[32];
+
+    _reset();
+    MJD_TEST_ASSERT(esp_mqtt_inbox_init(&inbox, TEST_NBR_OF_SLOTS, TEST_SLOT_SIZE, false) == true);
+
+    // The read buffer of lwmqtt is reused for the next packet: the slot must hold its own copy
+    strcpy(read_buf, "mjd/lora/temperature");
+    MJD_TEST_ASSERT(_put(&inbox, read_buf, "21.5") == true);
+    memset(read_buf, 'X', sizeof(read_buf));
+
+    MJD_TEST_ASSERT_EQUAL_UINT(1, esp_mqtt_inbox_dispatch(&inbox, _callback, &ref_count));
+    MJD_TEST_ASSERT_EQUAL_UINT(1, ref_count);
+    MJD_TEST_ASSERT_EQUAL_STRING("mjd/lora/temperature", _ptr_last_message->topic);
+    MJD_TEST_ASSERT_EQUAL_UINT(20, _ptr_last_message->topic_len);
+    MJD_TEST_ASSERT_EQUAL_STRING("21.5", (char *) _ptr_last_message->payload); // NUL terminated
+    MJD_TEST_ASSERT_EQUAL_UINT(4, _ptr_last_message->payload_len);
+    MJD_TEST_ASSERT_EQUAL_INT(1, _ptr_last_message->qos);
+    MJD_TEST_ASSERT(_ptr_last_message->retained == true);
+
+    // The slot is back
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_NBR_OF_SLOTS, uxQueueMessagesWaiting(inbox.free_queue));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, esp_mqtt_inbox_dispatch(&inbox, _callback, &ref_count));
+
+    // FIFO
+    MJD_TEST_ASSERT(_put(&inbox, "a", "1") == true);
+    MJD_TEST_ASSERT(_put(&inbox, "b", "2") == true);
+    MJD_TEST_ASSERT(_put(&inbox, "c", "") == true);
+    MJD_TEST_ASSERT_EQUAL_UINT(3, esp_mqtt_inbox_dispatch(&inbox, _callback, &ref_count));
+    MJD_TEST_ASSERT_EQUAL_STRING("c", _ptr_last_message->topic);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _ptr_last_message->payload_len);
+    MJD_TEST_ASSERT_EQUAL_STRING("", (char *) _ptr_last_message->payload);
+
+    // A NULL callback only gives the slots back
+    MJD_TEST_ASSERT(_put(&inbox, "d", "4") == true);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, esp_mqtt_inbox_dispatch(&inbox, NULL, NULL));
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_NBR_OF_SLOTS, uxQueueMessagesWaiting(inbox.free_queue));
+
+    esp_mqtt_inbox_deinit(&inbox);
+}
+
+static void test_too_big(void) {
+    esp_mqtt_inbox_t inbox;
+    char payload[TEST_SLOT_SIZE];
+
+    _reset();
+    MJD_TEST_ASSERT(esp_mqtt_inbox_init(&inbox, TEST_NBR_OF_SLOTS, TEST_SLOT_SIZE, false) == true);
+
+    // topic 4 + payload 58 + 2 NULs = 64: fits exactly
+    memset(payload, 'p', sizeof(payload));
+    payload[58] = '\0';
+    MJD_TEST_ASSERT(_put(&inbox, "abcd", payload) == true);
+    payload[58] = 'p';
+    payload[59] = '\0';
+    MJD_TEST_ASSERT(_put(&inbox, "abcd", payload) == false);
+
+    esp_mqtt_inbox_stats_t stats;
+    esp_mqtt_inbox_get_stats(&inbox, &stats);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, stats.received);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, stats.dropped_too_big);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, stats.dropped_full);
+
+    esp_mqtt_inbox_deinit(&inbox);
+}
+
+static void test_full(void) {
+    esp_mqtt_inbox_t inbox;
+    uint32_t ref_count = 0;
+
+    _reset();
+    MJD_TEST_ASSERT(esp_mqtt_inbox_init(&inbox, TEST_NBR_OF_SLOTS, TEST_SLOT_SIZE, false) == true);
+
+    for (uint32_t i = 0; i < TEST_NBR_OF_SLOTS; i++) {
+        MJD_TEST_ASSERT(_put(&inbox, "t", "x") == true);
+    }
+    // Never blocks: the message is dropped
+    MJD_TEST_ASSERT(_put(&inbox, "t", "x") == false);
+
+    esp_mqtt_inbox_stats_t stats;
+    esp_mqtt_inbox_get_stats(&inbox, &stats);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, stats.dropped_full);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, stats.min_free_slots);
+
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_NBR_OF_SLOTS, esp_mqtt_inbox_dispatch(&inbox, _callback, &ref_count));
+    MJD_TEST_ASSERT(_put(&inbox, "t", "x") == true);
+
+    esp_mqtt_inbox_get_stats(&inbox, &stats);
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_NBR_OF_SLOTS + 2, stats.received);
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_NBR_OF_SLOTS, stats.dispatched);
+
+    esp_mqtt_inbox_deinit(&inbox);
+}
+
+static void test_retain_release(void) {
+    esp_mqtt_inbox_t inbox;
+    esp_mqtt_message_t *retained[TEST_NBR_OF_SLOTS];
+    uint32_t ref_count = 0;
+
+    _reset();
+    MJD_TEST_ASSERT(esp_mqtt_inbox_init(&inbox, TEST_NBR_OF_SLOTS, TEST_SLOT_SIZE, false) == true);
+
+    // The handler keeps every message: the slots stay in use after the dispatch
+    _do_retain = true;
+    for (uint32_t i = 0; i < TEST_NBR_OF_SLOTS; i++) {
+        MJD_TEST_ASSERT(_put(&inbox, "mjd/retained", "v") == true);
+        MJD_TEST_ASSERT_EQUAL_UINT(1, esp_mqtt_inbox_dispatch(&inbox, _callback, &ref_count));
+        retained[i] = _ptr_last_message;
+    }
+    MJD_TEST_ASSERT_EQUAL_UINT(0, uxQueueMessagesWaiting(inbox.free_queue));
+    MJD_TEST_ASSERT(_put(&inbox, "t", "x") == false);
+
+    // Still valid after the callback returned
+    MJD_TEST_ASSERT_EQUAL_STRING("mjd/retained", retained[0]->topic);
+
+    // A second owner
+    esp_mqtt_message_retain(retained[0]);
+    esp_mqtt_message_release(retained[0]);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, uxQueueMessagesWaiting(inbox.free_queue));
+
+    for (uint32_t i = 0; i < TEST_NBR_OF_SLOTS; i++) {
+        esp_mqtt_message_release(retained[i]);
+    }
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_NBR_OF_SLOTS, uxQueueMessagesWaiting(inbox.free_queue));
+    MJD_TEST_ASSERT(_put(&inbox, "t", "x") == true);
+
+    esp_mqtt_inbox_deinit(&inbox);
+}
+
+static void test_init_deinit(void) {
+    esp_mqtt_inbox_t inbox;
+
+    _reset();
+    MJD_TEST_ASSERT(esp_mqtt_inbox_init(&inbox, 0, TEST_SLOT_SIZE, false) == false);
+    MJD_TEST_ASSERT(inbox.free_queue == NULL && inbox.ready_queue == NULL && inbox.storage == NULL);
+
+    MJD_TEST_ASSERT(esp_mqtt_inbox_init(&inbox, 2, TEST_SLOT_SIZE, true) == true);
+    MJD_TEST_ASSERT(_put(&inbox, "t", "x") == true);
+    MJD_TEST_ASSERT(_put(&inbox, "t", "x") == true);
+    MJD_TEST_ASSERT(_put(&inbox, "t", "x") == false);
+
+    // The queued messages are given back
+    esp_mqtt_inbox_deinit(&inbox);
+    MJD_TEST_ASSERT(inbox.free_queue == NULL && inbox.ready_queue == NULL && inbox.storage == NULL);
+}
+
+static void test_tracked(void) {
+    esp_mqtt_inbox_t inbox;
+    lwmqtt_err_t result;
+
+    _reset();
+    lwmqtt_message_t lw_message = { .qos = LWMQTT_QOS1, .retained = false, .payload = (uint8_t *) "1", .payload_len = 1 };
+
+    // Only a tracked inbox has the semaphores
+    MJD_TEST_ASSERT(esp_mqtt_inbox_init(&inbox, TEST_NBR_OF_SLOTS, TEST_SLOT_SIZE, false) == true);
+    MJD_TEST_ASSERT(esp_mqtt_inbox_put_tracked(&inbox, lwmqtt_string("mjd/out"), lw_message, 0) == NULL);
+    esp_mqtt_inbox_deinit(&inbox);
+
+    MJD_TEST_ASSERT(esp_mqtt_inbox_init(&inbox, TEST_NBR_OF_SLOTS, TEST_SLOT_SIZE, true) == true);
+
+    // The consumer completes the message before the publisher waits
+    esp_mqtt_message_t *ptr_tracked = esp_mqtt_inbox_put_tracked(&inbox, lwmqtt_string("mjd/out"), lw_message, 0);
+    MJD_TEST_ASSERT(ptr_tracked != NULL);
+    MJD_TEST_ASSERT(esp_mqtt_inbox_take(&inbox) == ptr_tracked);
+    esp_mqtt_message_complete(ptr_tracked, LWMQTT_NETWORK_FAILED_WRITE);
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_NBR_OF_SLOTS - 1, uxQueueMessagesWaiting(inbox.free_queue)); // The publisher holds it
+    MJD_TEST_ASSERT(esp_mqtt_message_wait(ptr_tracked, 100, &result) == true);
+    MJD_TEST_ASSERT_EQUAL_INT(LWMQTT_NETWORK_FAILED_WRITE, result);
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_NBR_OF_SLOTS, uxQueueMessagesWaiting(inbox.free_queue));
+
+    // The publisher gives up: the slot is given back when the consumer completes it
+    ptr_tracked = esp_mqtt_inbox_put_tracked(&inbox, lwmqtt_string("mjd/out"), lw_message, 0);
+    MJD_TEST_ASSERT(esp_mqtt_message_wait(ptr_tracked, 10, &result) == false);
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_NBR_OF_SLOTS - 1, uxQueueMessagesWaiting(inbox.free_queue));
+    MJD_TEST_ASSERT(esp_mqtt_inbox_take(&inbox) == ptr_tracked);
+    esp_mqtt_message_complete(ptr_tracked, LWMQTT_SUCCESS);
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_NBR_OF_SLOTS, uxQueueMessagesWaiting(inbox.free_queue));
+
+    // The completion that nobody waited for does not complete the next message in that slot
+    for (uint32_t i = 0; i < TEST_NBR_OF_SLOTS; i++) {
+        ptr_tracked = esp_mqtt_inbox_put_tracked(&inbox, lwmqtt_string("mjd/out"), lw_message, 0);
+        MJD_TEST_ASSERT(esp_mqtt_message_wait(ptr_tracked, 10, &result) == false);
+        MJD_TEST_ASSERT(esp_mqtt_inbox_take(&inbox) == ptr_tracked);
+        esp_mqtt_message_complete(ptr_tracked, LWMQTT_SUCCESS);
+    }
+
+    esp_mqtt_inbox_deinit(&inbox);
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_put_and_dispatch);
+    MJD_TEST_RUN(test_too_big);
+    MJD_TEST_RUN(test_full);
+    MJD_TEST_RUN(test_retain_release);
+    MJD_TEST_RUN(test_init_deinit);
+    MJD_TEST_RUN(test_tracked);
+
+    return MJD_TEST_REPORT();
+}
@@ -0,0 +1,542 @@
+/*
+ * HOST TEST: esp-mqtt event-driven process loop (esp_mqtt_loop.c) vs the v1 select/yield loop
+ *
+ * @doc The real lwmqtt client talks to a simulated broker on the simulated clock: every packet of the broker has an
+ *      arrival time, a QoS1 PUBLISH of the client is acknowledged after 1 round trip and a PINGREQ is answered after
+ *      1 round trip. The process task and the publisher task of both designs are played in a single thread:
+ *      - v1: the process task blocks in select() for data or the command timeout. A publisher takes the main mutex and
+ *        runs lwmqtt_publish() itself (waits for the PUBACK). The messages that lwmqtt reads meanwhile are queued but
+ *        only dispatched after the next select() wakeup of the process task.
+ *      - event-driven: the process task blocks until data arrives, the doorbell rings (publish) or the keep alive is
+ *        due. A publisher queues the message in the outbox and waits until the process task completes it (after the
+ *        PUBACK).
+ * @doc The latency percentiles are printed (LATENCY lines) and the expected bounds are asserted.
+ */
+#include "mjd.h"
+#include "esp_mqtt_inbox.h"
+#include "esp_mqtt_loop.h"
+
+#include "mjd_host.h"
+#include "mjd_test.h"
+
+#define SIM_RTT_MS             (40)
+#define SIM_COMMAND_TIMEOUT_MS (2000)
+#define SIM_KEEP_ALIVE_S       (10)
+#define SIM_BUFFER_SIZE        (256)
+
+// The MQTT packet types (the first 4 bits)
+#define SIM_PACKET_CONNECT (1)
+#define SIM_PACKET_PUBLISH (3)
+#define SIM_PACKET_PINGREQ (12)
+
+#define SIM_MAX_PENDING   (64)
+#define SIM_MAX_SAMPLES   (1024)
+#define SIM_RX_SIZE       (4096)
+
+/**********
+ * Simulated broker
+ */
+typedef struct {
+    uint32_t arrival_ms;
+    uint8_t data[32];
+    size_t len;
+} sim_packet_t;
+
+typedef struct {
+    sim_packet_t pending[SIM_MAX_PENDING]; /*!< Sorted by arrival_ms */
+    uint32_t nbr_of_pending;
+    uint8_t rx[SIM_RX_SIZE];               /*!< The bytes that arrived at the client (not read yet) */
+    size_t rx_head;
+    size_t rx_len;
+    uint32_t nbr_of_pings;
+} sim_broker_t;
+
+typedef struct {
+    uint32_t values[SIM_MAX_SAMPLES];
+    uint32_t count;
+} sim_samples_t;
+
+static sim_broker_t _broker;
+static sim_samples_t _inbound_latencies;
+static sim_samples_t _publish_call_latencies;
+static sim_samples_t _publish_wire_latencies;
+
+static uint32_t _now_ms(void) {
+    return (uint32_t) (mjd_host_get_time_us() / 1000);
+}
+
+static void _advance_to_ms(uint32_t param_ms) {
+    uint32_t now_ms = _now_ms();
+    if (param_ms > now_ms) {
+        mjd_host_advance_time_us((uint64_t) (param_ms - now_ms) * 1000);
+    }
+}
+
+static void _sim_schedule(uint32_t param_arrival_ms, const uint8_t *param_ptr_data, size_t param_len) {
+    uint32_t i = _broker.nbr_of_pending;
+
+    // sorted insert (stable: same arrival keeps the order)
+    while (i > 0 && _broker.pending[i - 1].arrival_ms > param_arrival_ms) {
+        _broker.pending[i] = _broker.pending[i - 1];
+        i--;
+    }
+    _broker.pending[i].arrival_ms = param_arrival_ms;
+    memcpy(_broker.pending[i].data, param_ptr_data, param_len);
+    _broker.pending[i].len = param_len;
+    _broker.nbr_of_pending++;
+}
+
+static void _sim_schedule_publish(uint32_t param_arrival_ms) {
+    char payload[12];
+    uint8_t packet[32];
+    const char topic[] = "mjd/in";
+
+    // QoS0 PUBLISH, the payload is the time it arrives at the client
+    size_t payload_len = sprintf(payload, "%u", param_arrival_ms);
+    packet[0] = 0x30;
+    packet[1] = (uint8_t) (2 + strlen(topic) + payload_len);
+    packet[2] = 0;
+    packet[3] = (uint8_t) strlen(topic);
+    memcpy(&packet[4], topic, strlen(topic));
+    memcpy(&packet[4 + strlen(topic)], payload, payload_len);
+    _sim_schedule(param_arrival_ms, packet, 4 + strlen(topic) + payload_len);
+}
+
+static void _sim_deliver(void) {
+    uint32_t now_ms = _now_ms();
+
+    while (_broker.nbr_of_pending > 0 && _broker.pending[0].arrival_ms <= now_ms) {
+        memcpy(&_broker.rx[_broker.rx_head + _broker.rx_len], _broker.pending[0].data, _broker.pending[0].len);
+        _broker.rx_len += _broker.pending[0].len;
+        _broker.nbr_of_pending--;
+        memmove(&_broker.pending[0], &_broker.pending[1], _broker.nbr_of_pending * sizeof(sim_packet_t));
+    }
+    if (_broker.rx_len == 0) {
+        _broker.rx_head = 0;
+    }
+}
+
+/*
+ * @brief The time the process task wakes up for data (UINT32_MAX = no data is coming).
+ */
+static uint32_t _sim_next_data_ms(void) {
+    _sim_deliver();
+    if (_broker.rx_len > 0) {
+        return _now_ms();
+    }
+    if (_broker.nbr_of_pending > 0) {
+        return _broker.pending[0].arrival_ms;
+    }
+    return UINT32_MAX;
+}
+
+static lwmqtt_err_t _sim_read(void *ref, uint8_t *buf, size_t len, size_t *read, uint32_t timeout) {
+    _sim_deliver();
+
+    // a blocking read waits for the next packet
+    if (_broker.rx_len == 0) {
+        if (_broker.nbr_of_pending > 0 && _broker.pending[0].arrival_ms <= _now_ms() + timeout) {
+            _advance_to_ms(_broker.pending[0].arrival_ms);
+            _sim_deliver();
+        } else {
+            _advance_to_ms(_now_ms() + timeout);
+            return LWMQTT_SUCCESS;
+        }
+    }
+
+    size_t n = (len < _broker.rx_len) ? len : _broker.rx_len;
+    memcpy(buf, &_broker.rx[_broker.rx_head], n);
+    _broker.rx_head += n;
+    _broker.rx_len -= n;
+    *read += n;
+
+    return LWMQTT_SUCCESS;
+}
+
+static lwmqtt_err_t _sim_write(void *ref, uint8_t *buf, size_t len, size_t *sent, uint32_t timeout) {
+    uint32_t now_ms = _now_ms();
+    uint8_t packet_type = buf[0] >> 4;
+
+    if (packet_type == SIM_PACKET_CONNECT) {
+        const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+        _sim_schedule(now_ms + SIM_RTT_MS, connack, sizeof(connack));
+    } else if (packet_type == SIM_PACKET_PUBLISH) {
+        // fixed header (remaining length < 128), topic, [packet id], payload = the time the publisher called publish
+        size_t topic_len = (buf[2] << 8) | buf[3];
+        size_t offset = 4 + topic_len;
+        if (((buf[0] >> 1) & 0x03) == LWMQTT_QOS1) {
+            const uint8_t puback[] = { 0x40, 0x02, buf[offset], buf[offset + 1] };
+            _sim_schedule(now_ms + SIM_RTT_MS, puback, sizeof(puback));
+            offset += 2;
+        }
+        char payload[12] = { 0 };
+        memcpy(payload, &buf[offset], 2 + buf[1] - offset);
+        uint32_t requested_ms = (uint32_t) strtoul(payload, NULL, 10);
+        _publish_wire_latencies.values[_publish_wire_latencies.count++] = now_ms - requested_ms;
+    } else if (packet_type == SIM_PACKET_PINGREQ) {
+        const uint8_t pingresp[] = { 0xD0, 0x00 };
+        _sim_schedule(now_ms + SIM_RTT_MS, pingresp, sizeof(pingresp));
+        _broker.nbr_of_pings++;
+    }
+
+    *sent = len;
+    return LWMQTT_SUCCESS;
+}
+
+static lwmqtt_err_t _sim_peek(void *ref, size_t *available) {
+    _sim_deliver();
+    *available = _broker.rx_len;
+    return LWMQTT_SUCCESS;
+}
+
+/**********
+ * Client
+ */
+typedef struct {
+    uint32_t deadline;
+} sim_timer_t;
+
+static void _sim_timer_set(void *ref, uint32_t timeout) {
+    ((sim_timer_t *) ref)->deadline = _now_ms() + timeout;
+}
+
+static int32_t _sim_timer_get(void *ref) {
+    return (int32_t) ((sim_timer_t *) ref)->deadline - (int32_t) _now_ms();
+}
+
+static lwmqtt_client_t _client;
+static uint8_t _read_buf[SIM_BUFFER_SIZE];
+static uint8_t _write_buf[SIM_BUFFER_SIZE];
+static sim_timer_t _keep_alive_timer;
+static sim_timer_t _command_timer;
+static esp_mqtt_inbox_t _inbox;
+static esp_mqtt_inbox_t _outbox;
+
+static void _client_message_handler(lwmqtt_client_t *client, void *ref, lwmqtt_string_t topic, lwmqtt_message_t msg) {
+    esp_mqtt_inbox_put(&_inbox, topic, msg, 0);
+}
+
+static void _client_dispatch_callback(esp_mqtt_message_t *msg, void *ref) {
+    uint32_t arrival_ms = (uint32_t) strtoul((char *) msg->payload, NULL, 10);
+    _inbound_latencies.values[_inbound_latencies.count++] = _now_ms() - arrival_ms;
+}
+
+static void _setup(void) {
+    mjd_host_reset();
+    memset(&_broker, 0, sizeof(_broker));
+    memset(&_inbound_latencies, 0, sizeof(_inbound_latencies));
+    memset(&_publish_call_latencies, 0, sizeof(_publish_call_latencies));
+    memset(&_publish_wire_latencies, 0, sizeof(_publish_wire_latencies));
+
+    MJD_TEST_ASSERT(esp_mqtt_inbox_init(&_inbox, 8, 128, false) == true);
+    MJD_TEST_ASSERT(esp_mqtt_inbox_init(&_outbox, 4, 128, true) == true);
+
+    lwmqtt_init(&_client, _write_buf, sizeof(_write_buf), _read_buf, sizeof(_read_buf));
+    lwmqtt_set_network(&_client, &_broker, _sim_read, _sim_write);
+    lwmqtt_set_timers(&_client, &_keep_alive_timer, &_command_timer, _sim_timer_set, _sim_timer_get);
+    lwmqtt_set_callback(&_client, NULL, _client_message_handler);
+
+    lwmqtt_options_t options = lwmqtt_default_options;
+    options.keep_alive = SIM_KEEP_ALIVE_S;
+    options.client_id = lwmqtt_string("host_test");
+    lwmqtt_return_code_t return_code;
+    MJD_TEST_ASSERT_EQUAL_INT(LWMQTT_SUCCESS, lwmqtt_connect(&_client, options, NULL, &return_code, SIM_COMMAND_TIMEOUT_MS));
+}
+
+static void _teardown(void) {
+    esp_mqtt_inbox_deinit(&_inbox);
+    esp_mqtt_inbox_deinit(&_outbox);
+}
+
+static lwmqtt_message_t _make_message(char *ptr_payload, uint32_t param_requested_ms) {
+    lwmqtt_message_t message;
+    message.qos = LWMQTT_QOS1;
+    message.retained = false;
+    message.payload = (uint8_t *) ptr_payload;
+    message.payload_len = sprintf(ptr_payload, "%u", param_requested_ms);
+    return message;
+}
+
+/**********
+ * Workload: sparse inbound messages (500ms on average) and a publisher that publishes QoS1 every 100ms
+ */
+#define SIM_DURATION_MS         (60000)
+#define SIM_INBOUND_MEAN_MS     (500)
+#define SIM_PUBLISH_INTERVAL_MS (100)
+#define SIM_DRAIN_MS            (2 * SIM_COMMAND_TIMEOUT_MS) /*!< No new messages: the last ones are dispatched */
+
+static uint32_t _lcg_state;
+
+static uint32_t _lcg_next(uint32_t param_max) {
+    _lcg_state = _lcg_state * 1664525 + 1013904223;
+    return (_lcg_state >> 8) % param_max;
+}
+
+static uint32_t _next_inbound_ms = 0;
+
+/*
+ * @brief Keep the pending queue of the broker short: schedule the inbound messages of the next seconds only.
+ */
+static void _workload_feed(void) {
+    while (_next_inbound_ms < SIM_DURATION_MS && _next_inbound_ms < _now_ms() + 5000) {
+        _sim_schedule_publish(_next_inbound_ms);
+        _next_inbound_ms += 1 + _lcg_next(2 * SIM_INBOUND_MEAN_MS);
+    }
+}
+
+static void _workload_reset(void) {
+    _lcg_state = 12345;
+    _next_inbound_ms = _now_ms() + _lcg_next(2 * SIM_INBOUND_MEAN_MS);
+    _workload_feed();
+}
+
+/**********
+ * Percentiles
+ */
+static int _compare_uint32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *) a;
+    uint32_t y = *(const uint32_t *) b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t _percentile(sim_samples_t *ptr_samples, uint32_t param_percent) {
+    qsort(ptr_samples->values, ptr_samples->count, sizeof(uint32_t), _compare_uint32);
+    uint32_t idx = (ptr_samples->count * param_percent + 99) / 100;
+    return ptr_samples->values[(idx == 0) ? 0 : idx - 1];
+}
+
+static void _print_latencies(const char *param_name, sim_samples_t *ptr_samples) {
+    printf("LATENCY %-44s n=%4u p50=%5u p90=%5u p99=%5u max=%5u ms\n", param_name, ptr_samples->count,
+            _percentile(ptr_samples, 50), _percentile(ptr_samples, 90), _percentile(ptr_samples, 99),
+            _percentile(ptr_samples, 100));
+}
+
+/**********
+ * The 2 designs
+ */
+static void _run_v1(uint32_t *param_ptr_nbr_of_wakeups) {
+    uint32_t nbr_of_wakeups = 0;
+    uint32_t next_publish_ms = _now_ms() + SIM_PUBLISH_INTERVAL_MS;
+    uint32_t select_deadline_ms = _now_ms() + SIM_COMMAND_TIMEOUT_MS;
+    char payload[12];
+
+    while (_now_ms() < SIM_DURATION_MS + SIM_DRAIN_MS) {
+        _workload_feed();
+        uint32_t wake_ms = _sim_next_data_ms();
+        if (select_deadline_ms < wake_ms) {
+            wake_ms = select_deadline_ms;
+        }
+
+        if (next_publish_ms <= wake_ms && next_publish_ms < SIM_DURATION_MS) {
+            // the publisher task: main mutex + lwmqtt_publish() (waits for the PUBACK)
+            _advance_to_ms(next_publish_ms);
+            MJD_TEST_ASSERT_EQUAL_INT(LWMQTT_SUCCESS,
+                    lwmqtt_publish(&_client, lwmqtt_string("mjd/out"), _make_message(payload, next_publish_ms), SIM_COMMAND_TIMEOUT_MS));
+            _publish_call_latencies.values[_publish_call_latencies.count++] = _now_ms() - next_publish_ms;
+            next_publish_ms += SIM_PUBLISH_INTERVAL_MS;
+            continue;
+        }
+
+        // the process task: select() returned
+        _advance_to_ms(wake_ms);
+        nbr_of_wakeups++;
+        size_t available = 0;
+        _sim_peek(NULL, &available);
+        if (available > 0) {
+            MJD_TEST_ASSERT_EQUAL_INT(LWMQTT_SUCCESS, lwmqtt_yield(&_client, available, SIM_COMMAND_TIMEOUT_MS));
+        }
+        MJD_TEST_ASSERT_EQUAL_INT(LWMQTT_SUCCESS, lwmqtt_keep_alive(&_client, SIM_COMMAND_TIMEOUT_MS));
+        esp_mqtt_inbox_dispatch(&_inbox, _client_dispatch_callback, NULL);
+        select_deadline_ms = _now_ms() + SIM_COMMAND_TIMEOUT_MS;
+    }
+
+    *param_ptr_nbr_of_wakeups = nbr_of_wakeups;
+}
+
+static void _run_event_driven(uint32_t *param_ptr_nbr_of_wakeups) {
+    uint32_t nbr_of_wakeups = 0;
+    uint32_t next_publish_ms = _now_ms() + SIM_PUBLISH_INTERVAL_MS;
+    char payload[12];
+    esp_mqtt_message_t *waiting[4];
+    uint32_t waiting_requested_ms[4];
+    uint32_t nbr_of_waiting = 0;
+
+    while (_now_ms() < SIM_DURATION_MS + SIM_DRAIN_MS) {
+        _workload_feed();
+
+        // the process task blocks until data arrives, the doorbell rings or the keep alive is due
+        uint32_t wake_ms = _sim_next_data_ms();
+        uint32_t timeout = esp_mqtt_loop_timeout(&_client);
+        if (timeout != ESP_MQTT_LOOP_WAIT_FOREVER && _now_ms() + timeout < wake_ms) {
+            wake_ms = _now_ms() + timeout;
+        }
+        if (next_publish_ms < wake_ms && next_publish_ms < SIM_DURATION_MS) {
+            wake_ms = next_publish_ms;
+        }
+        _advance_to_ms(wake_ms);
+        nbr_of_wakeups++;
+
+        // the publisher task: queue the messages (also the ones that were published while the process task was busy)
+        while (next_publish_ms <= _now_ms() && next_publish_ms < SIM_DURATION_MS) {
+            MJD_TEST_ASSERT(nbr_of_waiting < ARRAY_SIZE(waiting));
+            waiting[nbr_of_waiting] = esp_mqtt_inbox_put_tracked(&_outbox, lwmqtt_string("mjd/out"), _make_message(payload, next_publish_ms), 0);
+            MJD_TEST_ASSERT(waiting[nbr_of_waiting] != NULL);
+            waiting_requested_ms[nbr_of_waiting++] = next_publish_ms;
+            next_publish_ms += SIM_PUBLISH_INTERVAL_MS;
+        }
+
+        MJD_TEST_ASSERT_EQUAL_INT(LWMQTT_SUCCESS, esp_mqtt_loop_process(&_client, _sim_peek, NULL, &_outbox, SIM_COMMAND_TIMEOUT_MS));
+        esp_mqtt_inbox_dispatch(&_inbox, _client_dispatch_callback, NULL);
+
+        // the publisher task: the publish returns after the PUBACK (the process task publishes its queue in one round)
+        for (uint32_t i = 0; i < nbr_of_waiting; i++) {
+            lwmqtt_err_t result = LWMQTT_NETWORK_TIMEOUT;
+            MJD_TEST_ASSERT(esp_mqtt_message_wait(waiting[i], 0, &result) == true);
+            MJD_TEST_ASSERT_EQUAL_INT(LWMQTT_SUCCESS, result);
+            _publish_call_latencies.values[_publish_call_latencies.count++] = _now_ms() - waiting_requested_ms[i];
+        }
+        nbr_of_waiting = 0;
+    }
+
+    *param_ptr_nbr_of_wakeups = nbr_of_wakeups;
+}
+
+/**********
+ * Tests
+ */
+static void test_timeout_follows_keep_alive(void) {
+    _setup();
+
+    // 75% of the keep alive interval after the CONNECT
+    MJD_TEST_ASSERT_EQUAL_UINT(SIM_KEEP_ALIVE_S * 750 - SIM_RTT_MS, esp_mqtt_loop_timeout(&_client));
+    _advance_to_ms(_now_ms() + 1000);
+    MJD_TEST_ASSERT_EQUAL_UINT(SIM_KEEP_ALIVE_S * 750 - SIM_RTT_MS - 1000, esp_mqtt_loop_timeout(&_client));
+
+    // Due: the ping is sent and the timer restarts
+    _advance_to_ms(SIM_KEEP_ALIVE_S * 750 + 1);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, esp_mqtt_loop_timeout(&_client));
+    MJD_TEST_ASSERT_EQUAL_INT(LWMQTT_SUCCESS, esp_mqtt_loop_process(&_client, _sim_peek, NULL, &_outbox, SIM_COMMAND_TIMEOUT_MS));
+    MJD_TEST_ASSERT_EQUAL_UINT(1, _broker.nbr_of_pings);
+    MJD_TEST_ASSERT(esp_mqtt_loop_timeout(&_client) > 0);
+
+    // No keep alive: wait for events only
+    _client.keep_alive_interval = 0;
+    MJD_TEST_ASSERT_EQUAL_UINT(ESP_MQTT_LOOP_WAIT_FOREVER, esp_mqtt_loop_timeout(&_client));
+
+    _teardown();
+}
+
+static void test_several_packets_per_wakeup(void) {
+    _setup();
+
+    uint32_t now_ms = _now_ms();
+    for (uint32_t i = 0; i < 5; i++) {
+        _sim_schedule_publish(now_ms + 10);
+    }
+    _advance_to_ms(now_ms + 10);
+
+    // 1 wakeup handles the 5 messages
+    MJD_TEST_ASSERT_EQUAL_INT(LWMQTT_SUCCESS, esp_mqtt_loop_process(&_client, _sim_peek, NULL, &_outbox, SIM_COMMAND_TIMEOUT_MS));
+    MJD_TEST_ASSERT_EQUAL_UINT(5, esp_mqtt_inbox_dispatch(&_inbox, _client_dispatch_callback, NULL));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _broker.rx_len);
+
+    _teardown();
+}
+
+static void test_outbox_is_published(void) {
+    char payload[12];
+
+    _setup();
+
+    MJD_TEST_ASSERT(esp_mqtt_inbox_put(&_outbox, lwmqtt_string("mjd/out"), _make_message(payload, _now_ms()), 0) == true);
+    esp_mqtt_message_t *ptr_tracked = esp_mqtt_inbox_put_tracked(&_outbox, lwmqtt_string("mjd/out"), _make_message(payload, _now_ms()), 0);
+    MJD_TEST_ASSERT(ptr_tracked != NULL);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, uxQueueSpacesAvailable(_outbox.free_queue));
+
+    // QoS1: each publish waits for its PUBACK
+    uint32_t begin_ms = _now_ms();
+    MJD_TEST_ASSERT_EQUAL_INT(LWMQTT_SUCCESS, esp_mqtt_loop_process(&_client, _sim_peek, NULL, &_outbox, SIM_COMMAND_TIMEOUT_MS));
+    MJD_TEST_ASSERT_EQUAL_UINT(2, _publish_wire_latencies.count);
+    MJD_TEST_ASSERT_EQUAL_UINT(2 * SIM_RTT_MS, _now_ms() - begin_ms);
+
+    // The publisher gets the result after the PUBACK
+    lwmqtt_err_t result = LWMQTT_NETWORK_TIMEOUT;
+    MJD_TEST_ASSERT(esp_mqtt_message_wait(ptr_tracked, 0, &result) == true);
+    MJD_TEST_ASSERT_EQUAL_INT(LWMQTT_SUCCESS, result);
+
+    // The slots are back
+    MJD_TEST_ASSERT_EQUAL_UINT(4, uxQueueMessagesWaiting(_outbox.free_queue));
+
+    _teardown();
+}
+
+static void test_latency_percentiles(void) {
+    _setup();
+    _workload_reset();
+    uint32_t nbr_of_wakeups_v1 = 0;
+    _run_v1(&nbr_of_wakeups_v1);
+    _print_latencies("v1 inbound (arrival -> dispatch)", &_inbound_latencies);
+    _print_latencies("v1 publish call", &_publish_call_latencies);
+    _print_latencies("v1 publish (call -> wire)", &_publish_wire_latencies);
+    uint32_t inbound_p90_v1 = _percentile(&_inbound_latencies, 90);
+    uint32_t nbr_of_inbound_v1 = _inbound_latencies.count;
+    _teardown();
+
+    _setup();
+    _workload_reset();
+    uint32_t nbr_of_wakeups = 0;
+    _run_event_driven(&nbr_of_wakeups);
+    _print_latencies("event-driven inbound (arrival -> dispatch)", &_inbound_latencies);
+    _print_latencies("event-driven publish call", &_publish_call_latencies);
+    _print_latencies("event-driven publish (call -> wire)", &_publish_wire_latencies);
+    printf("LATENCY wakeups of the process task: v1 %u, event-driven %u\n", nbr_of_wakeups_v1, nbr_of_wakeups);
+
+    // The same messages
+    MJD_TEST_ASSERT_EQUAL_UINT(nbr_of_inbound_v1, _inbound_latencies.count);
+
+    // A message that arrives while the process task waits for a PUBACK is dispatched after that round trip
+    MJD_TEST_ASSERT(_percentile(&_inbound_latencies, 100) <= SIM_RTT_MS);
+
+    // v1: the messages that the publisher reads wait for the next select() wakeup
+    MJD_TEST_ASSERT(inbound_p90_v1 > 5 * SIM_RTT_MS);
+
+    // The publisher waits for the PUBACK in both designs: 1 round trip, plus the messages queued before it
+    MJD_TEST_ASSERT(_percentile(&_publish_call_latencies, 50) <= SIM_RTT_MS);
+    MJD_TEST_ASSERT(_percentile(&_publish_call_latencies, 99) <= 2 * SIM_RTT_MS);
+    MJD_TEST_ASSERT(_percentile(&_publish_wire_latencies, 99) <= SIM_RTT_MS);
+
+    _teardown();
+}
+
+static void test_no_periodic_wakeups(void) {
+    _setup();
+
+    // Idle connection for 60s: only the keep alive (ping + pong) wakes the process task up
+    uint32_t nbr_of_wakeups = 0;
+    while (_now_ms() < 60000) {
+        uint32_t wake_ms = _sim_next_data_ms();
+        uint32_t timeout = esp_mqtt_loop_timeout(&_client);
+        if (_now_ms() + timeout < wake_ms) {
+            wake_ms = _now_ms() + timeout;
+        }
+        _advance_to_ms(wake_ms);
+        nbr_of_wakeups++;
+        MJD_TEST_ASSERT_EQUAL_INT(LWMQTT_SUCCESS, esp_mqtt_loop_process(&_client, _sim_peek, NULL, &_outbox, SIM_COMMAND_TIMEOUT_MS));
+    }
+
+    // 60s / 7.5s = 8 pings (v1: 1 select() timeout per command timeout = 30 wakeups)
+    MJD_TEST_ASSERT_EQUAL_UINT(8, _broker.nbr_of_pings);
+    MJD_TEST_ASSERT(nbr_of_wakeups <= 2 * _broker.nbr_of_pings + 1);
+
+    _teardown();
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_timeout_follows_keep_alive);
+    MJD_TEST_RUN(test_several_packets_per_wakeup);
+    MJD_TEST_RUN(test_outbox_is_published);
+    MJD_TEST_RUN(test_latency_percentiles);
+    MJD_TEST_RUN(test_no_periodic_wakeups);
+
+    return MJD_TEST_REPORT();
+}
@@ -0,0 +1,102 @@
+/*
+ * HOST TEST: esp-mqtt TLS session record (RTC memory cache for session resumption)
+ */
+#include "mjd.h"
+#include "esp_tls_lwmqtt_session.h"
+
+#include "mjd_test.h"
+
+#define TEST_NOW     (1546300800LL) // 2019-01-01
+#define TEST_MAX_AGE (86400)
+
+static void _fill(esp_tls_lwmqtt_session_t *ptr_session) {
+    esp_tls_lwmqtt_session_clear(ptr_session);
+    ptr_session->ciphersuite = 0xC02B; // TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256
+    ptr_session->id_len = 32;
+    memset(ptr_session->id, 0x11, sizeof(ptr_session->id));
+    memset(ptr_session->master, 0x22, sizeof(ptr_session->master));
+    ptr_session->ticket_len = 160;
+    memset(ptr_session->ticket, 0x33, ptr_session->ticket_len);
+}
+
+static void test_seal_and_use(void) {
+    esp_tls_lwmqtt_session_t session;
+
+    _fill(&session);
+    MJD_TEST_ASSERT(esp_tls_lwmqtt_session_usable(&session, "broker.local", "8883", TEST_NOW, TEST_MAX_AGE) == false);
+
+    esp_tls_lwmqtt_session_seal(&session, "broker.local", "8883", TEST_NOW);
+    MJD_TEST_ASSERT(esp_tls_lwmqtt_session_usable(&session, "broker.local", "8883", TEST_NOW, TEST_MAX_AGE) == true);
+    MJD_TEST_ASSERT(esp_tls_lwmqtt_session_usable(&session, "broker.local", "8883", TEST_NOW + TEST_MAX_AGE - 1, TEST_MAX_AGE) == true);
+
+    // Another broker
+    MJD_TEST_ASSERT(esp_tls_lwmqtt_session_usable(&session, "broker.local", "8884", TEST_NOW, TEST_MAX_AGE) == false);
+    MJD_TEST_ASSERT(esp_tls_lwmqtt_session_usable(&session, "broker.remote", "8883", TEST_NOW, TEST_MAX_AGE) == false);
+    MJD_TEST_ASSERT(esp_tls_lwmqtt_session_usable(&session, "broker.local8", "883", TEST_NOW, TEST_MAX_AGE) == false);
+
+    // Cleared
+    esp_tls_lwmqtt_session_clear(&session);
+    MJD_TEST_ASSERT(esp_tls_lwmqtt_session_usable(&session, "broker.local", "8883", TEST_NOW, TEST_MAX_AGE) == false);
+}
+
+static void test_expiry(void) {
+    esp_tls_lwmqtt_session_t session;
+
+    _fill(&session);
+    esp_tls_lwmqtt_session_seal(&session, "broker.local", "8883", TEST_NOW);
+    MJD_TEST_ASSERT(esp_tls_lwmqtt_session_usable(&session, "broker.local", "8883", TEST_NOW + TEST_MAX_AGE, TEST_MAX_AGE) == false);
+
+    // The clock was set backwards (e.g. no SNTP sync yet after a power cycle)
+    MJD_TEST_ASSERT(esp_tls_lwmqtt_session_usable(&session, "broker.local", "8883", TEST_NOW - 1, TEST_MAX_AGE) == false);
+
+    // The lifetime hint of the ticket is shorter than the max age
+    _fill(&session);
+    session.lifetime = 7200;
+    esp_tls_lwmqtt_session_seal(&session, "broker.local", "8883", TEST_NOW);
+    MJD_TEST_ASSERT(esp_tls_lwmqtt_session_usable(&session, "broker.local", "8883", TEST_NOW + 7199, TEST_MAX_AGE) == true);
+    MJD_TEST_ASSERT(esp_tls_lwmqtt_session_usable(&session, "broker.local", "8883", TEST_NOW + 7200, TEST_MAX_AGE) == false);
+}
+
+static void test_corruption(void) {
+    esp_tls_lwmqtt_session_t session;
+
+    // A flipped bit in the master secret, the ticket or the saved time
+    _fill(&session);
+    esp_tls_lwmqtt_session_seal(&session, "broker.local", "8883", TEST_NOW);
+    session.master[47] ^= 0x01;
+    MJD_TEST_ASSERT(esp_tls_lwmqtt_session_usable(&session, "broker.local", "8883", TEST_NOW, TEST_MAX_AGE) == false);
+
+    _fill(&session);
+    esp_tls_lwmqtt_session_seal(&session, "broker.local", "8883", TEST_NOW);
+    session.ticket[159] ^= 0x80;
+    MJD_TEST_ASSERT(esp_tls_lwmqtt_session_usable(&session, "broker.local", "8883", TEST_NOW, TEST_MAX_AGE) == false);
+
+    _fill(&session);
+    esp_tls_lwmqtt_session_seal(&session, "broker.local", "8883", TEST_NOW);
+    session.saved_at += 1;
+    MJD_TEST_ASSERT(esp_tls_lwmqtt_session_usable(&session, "broker.local", "8883", TEST_NOW + 10, TEST_MAX_AGE) == false);
+
+    // The unused part of the ticket buffer does not matter
+    _fill(&session);
+    esp_tls_lwmqtt_session_seal(&session, "broker.local", "8883", TEST_NOW);
+    session.ticket[200] = 0xFF;
+    MJD_TEST_ASSERT(esp_tls_lwmqtt_session_usable(&session, "broker.local", "8883", TEST_NOW, TEST_MAX_AGE) == true);
+
+    // Lengths out of range are never used
+    _fill(&session);
+    session.ticket_len = ESP_TLS_LWMQTT_SESSION_TICKET_MAX_LEN + 1;
+    esp_tls_lwmqtt_session_seal(&session, "broker.local", "8883", TEST_NOW);
+    MJD_TEST_ASSERT(esp_tls_lwmqtt_session_usable(&session, "broker.local", "8883", TEST_NOW, TEST_MAX_AGE) == false);
+    _fill(&session);
+    session.id_len = 33;
+    esp_tls_lwmqtt_session_seal(&session, "broker.local", "8883", TEST_NOW);
+    MJD_TEST_ASSERT(esp_tls_lwmqtt_session_usable(&session, "broker.local", "8883", TEST_NOW, TEST_MAX_AGE) == false);
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_seal_and_use);
+    MJD_TEST_RUN(test_expiry);
+    MJD_TEST_RUN(test_corruption);
+
+    return MJD_TEST_REPORT();
+}
@@ -0,0 +1,92 @@
+/*
+ * HOST TEST: mjd_lorap2p data frame wire format
+ */
+#include "mjd.h"
+#include "mjd_lorap2p.h"
+
+#include "mjd_test.h"
+
+static void test_serialize_data_frame(void) {
+    uint8_t payload[] = { 0x08, 0x96, 0x01 };
+    mjd_lorap2p_data_frame_t frame = MJD_LORAP2P_DATA_FRAME_DEFAULT();
+    frame.source_address[0] = 0x01;
+    frame.source_address[2] = 0x01;
+    frame.seq_nr = 7;
+    frame.is_retry = 1;
+    frame.destination_address[0] = 0x01;
+    frame.len_payload = sizeof(payload);
+    frame.payload = payload;
+
+    uint8_t output[64];
+    size_t len_output = 0;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_lorap2p_serialize_data_frame(&frame, output, sizeof(output), &len_output));
+    MJD_TEST_ASSERT_EQUAL_UINT(MJD_LORAP2P_DATA_FRAME_HEADER_BYTES + sizeof(payload), len_output);
+
+    const uint8_t expected[] = { '<', '~', '>', 'D', 0x01, 0x00, 0x01, 7, 1, 0x01, 0x00, 0x00, 3, 0x08, 0x96, 0x01 };
+    MJD_TEST_ASSERT_EQUAL_MEMORY(expected, output, sizeof(expected));
+}
+
+static void test_serialize_buffer_too_small(void) {
+    uint8_t payload[8] = { 0 };
+    mjd_lorap2p_data_frame_t frame = MJD_LORAP2P_DATA_FRAME_DEFAULT();
+    frame.len_payload = sizeof(payload);
+    frame.payload = payload;
+
+    uint8_t output[MJD_LORAP2P_DATA_FRAME_HEADER_BYTES + 4];
+    size_t len_output = 0;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, mjd_lorap2p_serialize_data_frame(&frame, output, sizeof(output), &len_output));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, len_output);
+}
+
+static void test_roundtrip(void) {
+    uint8_t payload[MJD_LORAP2P_TX_PAYLOAD_MAX_BYTES];
+    for (size_t idx = 0; idx < sizeof(payload); idx++) {
+        payload[idx] = (uint8_t) idx;
+    }
+    mjd_lorap2p_data_frame_t frame = MJD_LORAP2P_DATA_FRAME_DEFAULT();
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_lorap2p_string_to_addr(MJD_LORAP2P_ADDR_NET_1_DEVICE_2, frame.source_address, 3));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_lorap2p_string_to_addr(MJD_LORAP2P_ADDR_NET_1_EDGE_GATEWAY, frame.destination_address, 3));
+    frame.seq_nr = 255;
+    frame.len_payload = sizeof(payload);
+    frame.payload = payload;
+
+    uint8_t wire[MJD_LORAP2P_DATA_FRAME_HEADER_BYTES + sizeof(payload)];
+    size_t len_wire = 0;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_lorap2p_serialize_data_frame(&frame, wire, sizeof(wire), &len_wire));
+
+    mjd_lorap2p_data_frame_t decoded = MJD_LORAP2P_DATA_FRAME_DEFAULT();
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_lorap2p_deserialize_data_frame(wire, len_wire, &decoded));
+    MJD_TEST_ASSERT_EQUAL_MEMORY(frame.source_address, decoded.source_address, 3);
+    MJD_TEST_ASSERT_EQUAL_MEMORY(frame.destination_address, decoded.destination_address, 3);
+    MJD_TEST_ASSERT_EQUAL_UINT(255, decoded.seq_nr);
+    MJD_TEST_ASSERT_EQUAL_UINT(sizeof(payload), decoded.len_payload);
+    MJD_TEST_ASSERT(decoded.payload == &wire[MJD_LORAP2P_DATA_FRAME_HEADER_BYTES]); // zero-copy
+    MJD_TEST_ASSERT_EQUAL_MEMORY(payload, decoded.payload, sizeof(payload));
+}
+
+static void test_deserialize_invalid(void) {
+    mjd_lorap2p_data_frame_t decoded = MJD_LORAP2P_DATA_FRAME_DEFAULT();
+    const uint8_t bad_prefix[] = { '<', '-', '>', 'D', 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    const uint8_t bad_length[] = { '<', '~', '>', 'D', 0, 0, 0, 0, 0, 0, 0, 0, 5, 0xAA };
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, mjd_lorap2p_deserialize_data_frame(bad_prefix, 4, &decoded));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_RESPONSE, mjd_lorap2p_deserialize_data_frame(bad_prefix, sizeof(bad_prefix), &decoded));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, mjd_lorap2p_deserialize_data_frame(bad_length, sizeof(bad_length), &decoded));
+}
+
+static void test_addr_strings(void) {
+    uint8_t addr[3];
+    char addr_string[8 + 1];
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_lorap2p_string_to_addr("01:00:02", addr, sizeof(addr)));
+    MJD_TEST_ASSERT_EQUAL_MEMORY("\x01\x00\x02", addr, 3);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_lorap2p_addr_to_string(addr, sizeof(addr), addr_string));
+    MJD_TEST_ASSERT_EQUAL_STRING("01:00:02", addr_string);
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_serialize_data_frame);
+    MJD_TEST_RUN(test_serialize_buffer_too_small);
+    MJD_TEST_RUN(test_roundtrip);
+    MJD_TEST_RUN(test_deserialize_invalid);
+    MJD_TEST_RUN(test_addr_strings);
+    return MJD_TEST_REPORT();
+}
@@ -0,0 +1,54 @@
+/*
+ * HOST TEST: minmea NMEA parser (the GPS component mjd_neom8n)
+ */
+#include "mjd.h"
+#include "minmea.h"
+
+#include "mjd_test.h"
+
+static const char RMC_SENTENCE[] = "$GPRMC,081836,A,3751.65,S,14507.36,E,000.0,360.0,130998,011.3,E*62";
+static const char GGA_SENTENCE[] = "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47";
+
+static void test_checksum(void) {
+    MJD_TEST_ASSERT(minmea_check(RMC_SENTENCE, true));
+    MJD_TEST_ASSERT(minmea_check(GGA_SENTENCE, true));
+    MJD_TEST_ASSERT(!minmea_check("$GPRMC,081836,A,3751.65,S,14507.36,E,000.0,360.0,130998,011.3,E*63", true));
+}
+
+static void test_sentence_id(void) {
+    MJD_TEST_ASSERT_EQUAL_INT(MINMEA_SENTENCE_RMC, minmea_sentence_id(RMC_SENTENCE, true));
+    MJD_TEST_ASSERT_EQUAL_INT(MINMEA_SENTENCE_GGA, minmea_sentence_id(GGA_SENTENCE, true));
+    MJD_TEST_ASSERT_EQUAL_INT(MINMEA_INVALID, minmea_sentence_id("garbage", true));
+}
+
+static void test_parse_rmc(void) {
+    struct minmea_sentence_rmc frame;
+    MJD_TEST_ASSERT(minmea_parse_rmc(&frame, RMC_SENTENCE));
+    MJD_TEST_ASSERT(frame.valid);
+    MJD_TEST_ASSERT_EQUAL_INT(8, frame.time.hours);
+    MJD_TEST_ASSERT_EQUAL_INT(18, frame.time.minutes);
+    MJD_TEST_ASSERT_EQUAL_INT(36, frame.time.seconds);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.0001, -37.860833, minmea_tocoord(&frame.latitude));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.0001, 145.122667, minmea_tocoord(&frame.longitude));
+    MJD_TEST_ASSERT_EQUAL_INT(13, frame.date.day);
+    MJD_TEST_ASSERT_EQUAL_INT(9, frame.date.month);
+    MJD_TEST_ASSERT_EQUAL_INT(98, frame.date.year);
+}
+
+static void test_parse_gga(void) {
+    struct minmea_sentence_gga frame;
+    MJD_TEST_ASSERT(minmea_parse_gga(&frame, GGA_SENTENCE));
+    MJD_TEST_ASSERT_EQUAL_INT(1, frame.fix_quality);
+    MJD_TEST_ASSERT_EQUAL_INT(8, frame.satellites_tracked);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 0.9, minmea_tofloat(&frame.hdop));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 545.4, minmea_tofloat(&frame.altitude));
+    MJD_TEST_ASSERT_EQUAL_INT('M', frame.altitude_units);
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_checksum);
+    MJD_TEST_RUN(test_sentence_id);
+    MJD_TEST_RUN(test_parse_rmc);
+    MJD_TEST_RUN(test_parse_gga);
+    return MJD_TEST_REPORT();
+}
@@ -0,0 +1,415 @@
+/*
+ * HOST TEST: mjd (bytes, strings, hex strings, crypto, RTC sample ring) and mjd_list
+ */
+#include "mjd.h"
+#include "mjd_list.h"
+
+#include "mjd_test.h"
+
+static void test_bcd(void) {
+    MJD_TEST_ASSERT_EQUAL_UINT(0x00, mjd_byte_to_bcd(0));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x59, mjd_byte_to_bcd(59));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x99, mjd_byte_to_bcd(99));
+    for (uint8_t val = 0; val < 100; val++) {
+        MJD_TEST_ASSERT_EQUAL_UINT(val, mjd_bcd_to_byte(mjd_byte_to_bcd(val)));
+    }
+}
+
+static void test_binary_string(void) {
+    char byte_string[8 + 1] = "XXXXXXXX";
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_byte_to_binary_string(0xA5, byte_string));
+    MJD_TEST_ASSERT_EQUAL_STRING("10100101", byte_string);
+
+    char word_string[16 + 1] = "XXXXXXXXXXXXXXXX";
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_word_to_binary_string(0x8001, word_string));
+    MJD_TEST_ASSERT_EQUAL_STRING("1000000000000001", word_string);
+
+    // @important The output string must be pre-filled (strlen check)
+    char too_short[8 + 1] = "";
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_FAIL, mjd_byte_to_binary_string(0xA5, too_short));
+}
+
+static void test_string_basics(void) {
+    MJD_TEST_ASSERT(mjd_string_starts_with("mjd_components", "mjd_"));
+    MJD_TEST_ASSERT(!mjd_string_starts_with("mjd", "mjd_components"));
+    MJD_TEST_ASSERT(!mjd_string_starts_with(NULL, "mjd"));
+    MJD_TEST_ASSERT(mjd_string_ends_with("radio_tx_ok", "_ok"));
+    MJD_TEST_ASSERT(!mjd_string_ends_with("radio_err", "_ok"));
+
+    char *repeated = mjd_string_repeat("ab", 3);
+    MJD_TEST_ASSERT_EQUAL_STRING("ababab", repeated);
+    free(repeated);
+
+    char prepended[32] = "world";
+    mjd_string_prepend(prepended, "hello ");
+    MJD_TEST_ASSERT_EQUAL_STRING("hello world", prepended);
+}
+
+static void test_number_formatters(void) {
+    char output[MJD_NUMBER_STRING_MAX_SIZE];
+    char expected[64];
+    const uint32_t uint_values[] = { 0, 1, 9, 10, 99, 100, 101, 999, 1000, 65535, 1000000, 123456789, 999999999, 1000000000, UINT32_MAX };
+    for (size_t idx = 0; idx < ARRAY_SIZE(uint_values); idx++) {
+        sprintf(expected, "%u", uint_values[idx]);
+        MJD_TEST_ASSERT_EQUAL_UINT(strlen(expected), mjd_uint32_to_string(uint_values[idx], output));
+        MJD_TEST_ASSERT_EQUAL_STRING(expected, output);
+    }
+
+    const int32_t int_values[] = { 0, -1, 1, -99, -100, 2147483647, INT32_MIN };
+    for (size_t idx = 0; idx < ARRAY_SIZE(int_values); idx++) {
+        sprintf(expected, "%i", int_values[idx]);
+        MJD_TEST_ASSERT_EQUAL_UINT(strlen(expected), mjd_int32_to_string(int_values[idx], output));
+        MJD_TEST_ASSERT_EQUAL_STRING(expected, output);
+    }
+
+    // The same output as printf("%.Nf") for values that are exact enough in a float
+    const float float_values[] = { 0.0f, 1.5f, -3.14159f, 23.456f, 9.996f, 1013.27f, -0.001f, 100000.0f, 4000000000.0f };
+    for (size_t idx = 0; idx < ARRAY_SIZE(float_values); idx++) {
+        for (uint32_t decimals = 0; decimals <= 3; decimals++) {
+            sprintf(expected, "%.*f", (int) decimals, float_values[idx]);
+            MJD_TEST_ASSERT_EQUAL_UINT(strlen(expected), mjd_float_to_fixed_string(float_values[idx], decimals, output));
+            MJD_TEST_ASSERT_EQUAL_STRING(expected, output);
+        }
+    }
+    mjd_float_to_fixed_string(0.000001f, 6, output);
+    MJD_TEST_ASSERT_EQUAL_STRING("0.000001", output);
+    mjd_float_to_fixed_string(1.0f, 99, output); // Clamped to MJD_FLOAT_STRING_MAX_DECIMALS
+    MJD_TEST_ASSERT_EQUAL_STRING("1.000000", output);
+    mjd_float_to_fixed_string(NAN, 2, output);
+    MJD_TEST_ASSERT_EQUAL_STRING("nan", output);
+    mjd_float_to_fixed_string(-INFINITY, 2, output);
+    MJD_TEST_ASSERT_EQUAL_STRING("-inf", output);
+    mjd_float_to_fixed_string(5e9f, 2, output);
+    MJD_TEST_ASSERT_EQUAL_STRING("ovf", output);
+}
+
+static void test_strbuf(void) {
+    char storage[16];
+    mjd_strbuf_t strbuf;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_strbuf_init(&strbuf, NULL, sizeof(storage)));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_strbuf_init(&strbuf, storage, sizeof(storage)));
+    MJD_TEST_ASSERT_EQUAL_STRING("", mjd_strbuf_c_str(&strbuf));
+
+    // The jsnsr04t OLED line: sprintf(str_line, "#%u:%6.2f cm", ...)
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_strbuf_append_char(&strbuf, '#'));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_strbuf_append_uint(&strbuf, 12, 0));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_strbuf_append(&strbuf, ":"));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_strbuf_append_float(&strbuf, 23.456f, 6, 2));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_strbuf_append(&strbuf, " cm"));
+    MJD_TEST_ASSERT_EQUAL_STRING("#12: 23.46 cm", mjd_strbuf_c_str(&strbuf));
+    MJD_TEST_ASSERT_EQUAL_UINT(13, mjd_strbuf_len(&strbuf));
+
+    mjd_strbuf_reset(&strbuf);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_strbuf_append_int(&strbuf, -42, 5));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_strbuf_prepend(&strbuf, "T="));
+    MJD_TEST_ASSERT_EQUAL_STRING("T=  -42", mjd_strbuf_c_str(&strbuf));
+
+    mjd_strbuf_reset(&strbuf);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_strbuf_repeat(&strbuf, "ab", 3));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_strbuf_repeat(&strbuf, "-", 4));
+    MJD_TEST_ASSERT_EQUAL_STRING("ababab----", mjd_strbuf_c_str(&strbuf));
+    MJD_TEST_ASSERT(!strbuf.is_truncated);
+}
+
+static void test_strbuf_truncation(void) {
+    char storage[8 + 1] = "XXXXXXXX";
+    char canary[4] = "ZZZ";
+    mjd_strbuf_t strbuf;
+
+    mjd_strbuf_init(&strbuf, storage, sizeof(storage));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, mjd_strbuf_append(&strbuf, "0123456789"));
+    MJD_TEST_ASSERT_EQUAL_STRING("01234567", mjd_strbuf_c_str(&strbuf));
+    MJD_TEST_ASSERT(strbuf.is_truncated);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, mjd_strbuf_append_char(&strbuf, 'X'));
+    MJD_TEST_ASSERT_EQUAL_UINT(8, mjd_strbuf_len(&strbuf));
+
+    mjd_strbuf_reset(&strbuf);
+    MJD_TEST_ASSERT(!strbuf.is_truncated);
+    mjd_strbuf_append(&strbuf, "abcdef");
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, mjd_strbuf_prepend(&strbuf, "123")); // The tail is cut off
+    MJD_TEST_ASSERT_EQUAL_STRING("123abcde", mjd_strbuf_c_str(&strbuf));
+
+    mjd_strbuf_reset(&strbuf);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, mjd_strbuf_prepend(&strbuf, "0123456789"));
+    MJD_TEST_ASSERT_EQUAL_STRING("01234567", mjd_strbuf_c_str(&strbuf));
+
+    mjd_strbuf_reset(&strbuf);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, mjd_strbuf_repeat(&strbuf, "abc", 1000));
+    MJD_TEST_ASSERT_EQUAL_STRING("abcabcab", mjd_strbuf_c_str(&strbuf));
+
+    mjd_strbuf_reset(&strbuf);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, mjd_strbuf_append_float(&strbuf, 1.0f, 12, 2)); // The padding alone overflows
+    MJD_TEST_ASSERT_EQUAL_STRING("        ", mjd_strbuf_c_str(&strbuf));
+
+    MJD_TEST_ASSERT_EQUAL_STRING("ZZZ", canary);
+}
+
+static void test_hexstring(void) {
+    const uint8_t input[] = { 0x00, 0x01, 0x0e, 0x0f, 0xf0, 0xf1, 0xfe, 0xff };
+    char hexstring[2 * sizeof(input) + 1];
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_uint8s_to_hexstring(input, sizeof(input), hexstring));
+    MJD_TEST_ASSERT_EQUAL_STRING("00010E0FF0F1FEFF", hexstring);
+
+    uint8_t decoded[sizeof(input) + 1];
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_hexstring_to_uint8s(hexstring, strlen(hexstring), decoded));
+    MJD_TEST_ASSERT_EQUAL_MEMORY(input, decoded, sizeof(input));
+
+    char string_hex[2 * 3 + 1];
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_string_to_hexstring("ABC", 3, string_hex));
+    MJD_TEST_ASSERT_EQUAL_STRING("414243", string_hex);
+
+    char string[3 + 1] = { 0 };
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_hexstring_to_string("414243", 6, string));
+    MJD_TEST_ASSERT_EQUAL_STRING("ABC", string);
+}
+
+static void test_hexstring_all_byte_values(void) {
+    // All 256 values, and every tail length of the word-at-a-time loops (0..7 bytes)
+    uint8_t input[256 + 7];
+    char hexstring[2 * sizeof(input) + 1];
+    uint8_t decoded[sizeof(input)];
+    char expected[3];
+
+    for (size_t idx = 0; idx < sizeof(input); idx++) {
+        input[idx] = (uint8_t) idx;
+    }
+    for (size_t len = 256; len < sizeof(input); len++) {
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_uint8s_to_hexstring(input, len, hexstring));
+        MJD_TEST_ASSERT_EQUAL_UINT(2 * len, strlen(hexstring));
+        for (size_t idx = 0; idx < len; idx++) {
+            sprintf(expected, "%02X", input[idx]);
+            MJD_TEST_ASSERT_EQUAL_MEMORY(expected, &hexstring[2 * idx], 2);
+        }
+        memset(decoded, 0xAA, sizeof(decoded));
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_hexstring_to_uint8s(hexstring, 2 * len, decoded));
+        MJD_TEST_ASSERT_EQUAL_MEMORY(input, decoded, len);
+    }
+}
+
+static void test_hexstring_strict_validation(void) {
+    uint8_t decoded[8];
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_hexstring_to_uint8s("abcdefAB", 8, decoded)); // lower case is accepted
+    MJD_TEST_ASSERT_EQUAL_MEMORY("\xAB\xCD\xEF\xAB", decoded, 4);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, mjd_hexstring_to_uint8s("ABC", 3, decoded));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_hexstring_to_uint8s(NULL, 2, decoded));
+
+    // Each char that borders the valid ranges, in each position of a word and in the tail
+    const char invalid_chars[] = { '/', ':', '@', 'G', '`', 'g', ' ', '\x10', '\x19', '\xB0', '\xC1' };
+    char input[6 + 1];
+    for (size_t idx_char = 0; idx_char < sizeof(invalid_chars); idx_char++) {
+        for (size_t pos = 0; pos < 6; pos++) {
+            strcpy(input, "0A1b2C");
+            input[pos] = invalid_chars[idx_char];
+            MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_hexstring_to_uint8s(input, 6, decoded));
+        }
+    }
+}
+
+static void test_hexstring_uart_stream(void) {
+    uint8_t input[100];
+    char expected[2 * sizeof(input) + 1];
+    uint8_t tx[2 * sizeof(input) + 1];
+
+    for (size_t idx = 0; idx < sizeof(input); idx++) {
+        input[idx] = (uint8_t) (255 - idx);
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_uint8s_to_hexstring(input, sizeof(input), expected));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_uint8s_to_hexstring_uart(UART_NUM_1, input, sizeof(input)));
+    MJD_TEST_ASSERT_EQUAL_UINT(2 * sizeof(input), mjd_host_uart_get_tx(UART_NUM_1, tx, sizeof(tx)));
+    MJD_TEST_ASSERT_EQUAL_MEMORY(expected, tx, 2 * sizeof(input));
+}
+
+static void test_xor_cipher(void) {
+    uint8_t values[] = { 'M', 'J', 'D' };
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_crypto_xor_cipher(0x5A, values, sizeof(values)));
+    MJD_TEST_ASSERT_EQUAL_UINT('M' ^ 0x5A, values[0]);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_crypto_xor_cipher(0x5A, values, sizeof(values)));
+    MJD_TEST_ASSERT_EQUAL_MEMORY("MJD", values, sizeof(values));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_crypto_xor_cipher(0x5A, NULL, 1));
+}
+
+static void test_compare_ints(void) {
+    int values[] = { 10, 20, 30, 40, 50 };
+    int key = 40;
+    int *found = bsearch(&key, values, ARRAY_SIZE(values), sizeof(int), mjd_compare_ints);
+    MJD_TEST_ASSERT(found == &values[3]);
+    key = 35;
+    MJD_TEST_ASSERT(bsearch(&key, values, ARRAY_SIZE(values), sizeof(int), mjd_compare_ints) == NULL);
+}
+
+typedef struct {
+    int value;
+    struct mjd_list_head list;
+} test_list_item_t;
+
+static void test_list(void) {
+    MJD_LIST_HEAD(head);
+    test_list_item_t items[3] = { { .value = 1 }, { .value = 2 }, { .value = 3 } };
+    uint32_t count;
+
+    MJD_TEST_ASSERT(mjd_list_empty(&head));
+    for (int idx = 0; idx < 3; idx++) {
+        mjd_list_add_tail(&items[idx].list, &head);
+    }
+    mjd_list_count(&head, &count);
+    MJD_TEST_ASSERT_EQUAL_UINT(3, count);
+
+    int expected = 1;
+    test_list_item_t *pos;
+    mjd_list_for_each_entry(pos, &head, list) {
+        MJD_TEST_ASSERT_EQUAL_INT(expected, pos->value);
+        ++expected;
+    }
+
+    mjd_list_del(&items[1].list);
+    MJD_TEST_ASSERT(items[1].list.next == LIST_POISON1);
+    mjd_list_count(&head, &count);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, count);
+    MJD_TEST_ASSERT_EQUAL_INT(3, mjd_list_last_entry(&head, test_list_item_t, list)->value);
+}
+
+/*
+ * @doc The storage is a plain static array on the host: "a deep sleep" is a new mjd_rtc_ring_init() on the same storage.
+ */
+typedef struct {
+    float temperature;
+    uint8_t humidity;
+} test_rtc_sample_t;
+
+#define TEST_RTC_RING_SIZE (8)
+
+MJD_RTC_RING_DEFINE_STORAGE(_test_rtc_ring_storage, sizeof(test_rtc_sample_t), TEST_RTC_RING_SIZE);
+
+static void test_rtc_ring(void) {
+    mjd_rtc_ring_t *ptr_ring = (mjd_rtc_ring_t *) _test_rtc_ring_storage;
+    test_rtc_sample_t sample;
+    uint32_t timestamp_s = 0;
+    bool is_restored = true;
+
+    MJD_TEST_ASSERT_EQUAL_UINT(sizeof(mjd_rtc_ring_t) + 12 * TEST_RTC_RING_SIZE, sizeof(_test_rtc_ring_storage));
+
+    // Cold boot: the storage is zero
+    memset(_test_rtc_ring_storage, 0, sizeof(_test_rtc_ring_storage));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_rtc_ring_init(ptr_ring, sizeof(test_rtc_sample_t), TEST_RTC_RING_SIZE, 1, &is_restored));
+    MJD_TEST_ASSERT(is_restored == false);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, mjd_rtc_ring_count(ptr_ring));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_NOT_FOUND, mjd_rtc_ring_peek(ptr_ring, 0, &sample, NULL));
+
+    // 1 sample per wakeup
+    for (uint32_t idx = 0; idx < 5; idx++) {
+        sample.temperature = 20.0f + idx;
+        sample.humidity = 50 + idx;
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_rtc_ring_init(ptr_ring, sizeof(test_rtc_sample_t), TEST_RTC_RING_SIZE, 1, &is_restored));
+        MJD_TEST_ASSERT(is_restored == true);
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_rtc_ring_push(ptr_ring, 1000 + idx * 60, &sample));
+    }
+    MJD_TEST_ASSERT_EQUAL_UINT(5, mjd_rtc_ring_count(ptr_ring));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_rtc_ring_peek(ptr_ring, 0, &sample, &timestamp_s));
+    MJD_TEST_ASSERT_EQUAL_UINT(1000, timestamp_s);
+    MJD_TEST_ASSERT(sample.temperature == 20.0f);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_rtc_ring_peek(ptr_ring, 4, &sample, &timestamp_s));
+    MJD_TEST_ASSERT_EQUAL_UINT(1240, timestamp_s);
+    MJD_TEST_ASSERT_EQUAL_UINT(54, sample.humidity);
+
+    // Full: the oldest records are overwritten
+    for (uint32_t idx = 5; idx < 11; idx++) {
+        sample.temperature = 20.0f + idx;
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_rtc_ring_push(ptr_ring, 1000 + idx * 60, &sample));
+    }
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_RTC_RING_SIZE, mjd_rtc_ring_count(ptr_ring));
+    MJD_TEST_ASSERT_EQUAL_UINT(3, ptr_ring->nbr_of_dropped);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_rtc_ring_peek(ptr_ring, 0, &sample, &timestamp_s));
+    MJD_TEST_ASSERT(sample.temperature == 23.0f);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_rtc_ring_peek(ptr_ring, TEST_RTC_RING_SIZE - 1, &sample, &timestamp_s));
+    MJD_TEST_ASSERT(sample.temperature == 30.0f);
+
+    // The uplink sent 5 records
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_rtc_ring_uplink_done(ptr_ring, 5, 30.0f, 1700));
+    MJD_TEST_ASSERT_EQUAL_UINT(3, mjd_rtc_ring_count(ptr_ring));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_rtc_ring_peek(ptr_ring, 0, &sample, NULL));
+    MJD_TEST_ASSERT(sample.temperature == 28.0f);
+
+    // A new firmware with another record layout starts an empty ring
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_rtc_ring_init(ptr_ring, sizeof(test_rtc_sample_t), TEST_RTC_RING_SIZE, 2, &is_restored));
+    MJD_TEST_ASSERT(is_restored == false);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, mjd_rtc_ring_count(ptr_ring));
+
+    // A corrupt header is detected
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_rtc_ring_push(ptr_ring, 2000, &sample));
+    ptr_ring->count = 7;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_CRC, mjd_rtc_ring_push(ptr_ring, 2060, &sample));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, mjd_rtc_ring_count(ptr_ring));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_rtc_ring_init(ptr_ring, sizeof(test_rtc_sample_t), TEST_RTC_RING_SIZE, 2, &is_restored));
+    MJD_TEST_ASSERT(is_restored == false);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_rtc_ring_push(ptr_ring, 2060, &sample));
+    MJD_TEST_ASSERT_EQUAL_UINT(1, mjd_rtc_ring_count(ptr_ring));
+    mjd_rtc_ring_log(ptr_ring);
+}
+
+static void test_rtc_uplink_policy(void) {
+    mjd_rtc_ring_t *ptr_ring = (mjd_rtc_ring_t *) _test_rtc_ring_storage;
+    mjd_rtc_uplink_policy_t policy = MJD_RTC_UPLINK_POLICY_DEFAULT();
+    test_rtc_sample_t sample = { 21.0f, 50 };
+
+    memset(_test_rtc_ring_storage, 0, sizeof(_test_rtc_ring_storage));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_rtc_ring_init(ptr_ring, sizeof(test_rtc_sample_t), TEST_RTC_RING_SIZE, 1, NULL));
+    policy.max_records = 4;
+    policy.max_age_s = 600;
+    policy.value_change_threshold = 0;
+
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_RTC_UPLINK_NOT_NEEDED, mjd_rtc_ring_evaluate_policy(ptr_ring, &policy, 0, 21.0f));
+
+    // Count
+    for (uint32_t idx = 0; idx < 3; idx++) {
+        mjd_rtc_ring_push(ptr_ring, 100 + idx * 60, &sample);
+        MJD_TEST_ASSERT_EQUAL_INT(MJD_RTC_UPLINK_NOT_NEEDED, mjd_rtc_ring_evaluate_policy(ptr_ring, &policy, 100 + idx * 60, 21.0f));
+    }
+    mjd_rtc_ring_push(ptr_ring, 280, &sample);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_RTC_UPLINK_COUNT, mjd_rtc_ring_evaluate_policy(ptr_ring, &policy, 280, 21.0f));
+    mjd_rtc_ring_uplink_done(ptr_ring, 4, 21.0f, 280);
+
+    // Age of the oldest record
+    mjd_rtc_ring_push(ptr_ring, 1000, &sample);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_RTC_UPLINK_NOT_NEEDED, mjd_rtc_ring_evaluate_policy(ptr_ring, &policy, 1599, 21.0f));
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_RTC_UPLINK_AGE, mjd_rtc_ring_evaluate_policy(ptr_ring, &policy, 1600, 21.0f));
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_RTC_UPLINK_NOT_NEEDED, mjd_rtc_ring_evaluate_policy(ptr_ring, &policy, 900, 21.0f)); // Clock set back
+
+    // Value change against the value of the last uplink
+    policy.value_change_threshold = 0.5f;
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_RTC_UPLINK_NOT_NEEDED, mjd_rtc_ring_evaluate_policy(ptr_ring, &policy, 1060, 21.4f));
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_RTC_UPLINK_VALUE_CHANGE, mjd_rtc_ring_evaluate_policy(ptr_ring, &policy, 1060, 20.5f));
+    MJD_TEST_ASSERT_EQUAL_STRING("VALUE_CHANGE", mjd_rtc_uplink_reason_to_name(MJD_RTC_UPLINK_VALUE_CHANGE));
+
+    // Full beats the other thresholds
+    policy.max_records = 0;
+    policy.max_age_s = 0;
+    policy.value_change_threshold = 0;
+    for (uint32_t idx = 1; idx < TEST_RTC_RING_SIZE; idx++) {
+        mjd_rtc_ring_push(ptr_ring, 1000 + idx, &sample);
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_RTC_UPLINK_RING_FULL, mjd_rtc_ring_evaluate_policy(ptr_ring, &policy, 1100, 21.0f));
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_bcd);
+    MJD_TEST_RUN(test_binary_string);
+    MJD_TEST_RUN(test_string_basics);
+    MJD_TEST_RUN(test_number_formatters);
+    MJD_TEST_RUN(test_strbuf);
+    MJD_TEST_RUN(test_strbuf_truncation);
+    MJD_TEST_RUN(test_hexstring);
+    MJD_TEST_RUN(test_hexstring_all_byte_values);
+    MJD_TEST_RUN(test_hexstring_strict_validation);
+    MJD_TEST_RUN(test_hexstring_uart_stream);
+    MJD_TEST_RUN(test_xor_cipher);
+    MJD_TEST_RUN(test_compare_ints);
+    MJD_TEST_RUN(test_list);
+    MJD_TEST_RUN(test_rtc_ring);
+    MJD_TEST_RUN(test_rtc_uplink_policy);
+    return MJD_TEST_REPORT();
+}
@@ -0,0 +1,274 @@
+/*
+ * HOST TEST: mjd_bme280 compensation modes (FLOAT, INT32, INT64)
+ *
+ * @doc Golden values: the calibration example of the Bosch data sheet (T and P: adc_T 519888 = 25.08 C, adc_P 415148 = 100653.27 Pa)
+ *      + typical humidity trimming values.
+ * @doc The integer modes are compared with the double precision mode over the operating range of the sensor.
+ * @doc Normal mode: the sensor is a simulated I2C slave (register map) so the Bosch driver, the burst read and the sample queue run
+ *      for real. The sampling task does not run on the host: the test calls mjd_bme280_sampling_read_burst() once per period.
+ */
+#include "mjd.h"
+#include "mjd_bme280.h"
+
+#include "mjd_host.h"
+#include "mjd_test.h"
+
+static const struct bme280_calib_data GOLDEN_CALIB_DATA =
+    { .dig_T1 = 27504, .dig_T2 = 26435, .dig_T3 = -1000, .dig_P1 = 36477, .dig_P2 = -10685, .dig_P3 = 3024, .dig_P4 = 2855, .dig_P5 = 140,
+      .dig_P6 = -7, .dig_P7 = 15500, .dig_P8 = -14600, .dig_P9 = 6000, .dig_H1 = 75, .dig_H2 = 370, .dig_H3 = 0, .dig_H4 = 313,
+      .dig_H5 = 50, .dig_H6 = 30 };
+
+static const struct bme280_uncomp_data GOLDEN_UNCOMP_DATA =
+    { .pressure = 415148, .temperature = 519888, .humidity = 27000 };
+
+static void test_golden_float(void) {
+    struct bme280_calib_data calib_data = GOLDEN_CALIB_DATA;
+    mjd_bme280_data_t data;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bme280_compensate(MJD_BME280_COMPENSATION_FLOAT, &calib_data, &GOLDEN_UNCOMP_DATA, &data));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.005, 25.08, data.temperature_celsius);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 1006.5327, data.pressure_hpascal);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 39.116, data.humidity_percent);
+    MJD_TEST_ASSERT_EQUAL_INT(2508, data.temperature_centicelsius);
+    MJD_TEST_ASSERT_EQUAL_UINT(10065326, data.pressure_centipascal);
+    MJD_TEST_ASSERT_EQUAL_UINT(40055, data.humidity_percent_q10);
+}
+
+static void test_golden_int32(void) {
+    struct bme280_calib_data calib_data = GOLDEN_CALIB_DATA;
+    mjd_bme280_data_t data =
+        { 0 };
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bme280_compensate(MJD_BME280_COMPENSATION_INT32, &calib_data, &GOLDEN_UNCOMP_DATA, &data));
+    MJD_TEST_ASSERT_EQUAL_INT(128423, calib_data.t_fine);
+    MJD_TEST_ASSERT_EQUAL_INT(2508, data.temperature_centicelsius);
+    MJD_TEST_ASSERT_EQUAL_UINT(10065400, data.pressure_centipascal); // 1 Pa resolution
+    MJD_TEST_ASSERT_EQUAL_UINT(40052, data.humidity_percent_q10);
+    // The integer modes do not set the doubles
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.0, 0.0, data.temperature_celsius);
+}
+
+static void test_golden_int64(void) {
+    struct bme280_calib_data calib_data = GOLDEN_CALIB_DATA;
+    mjd_bme280_data_t data;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bme280_compensate(MJD_BME280_COMPENSATION_INT64, &calib_data, &GOLDEN_UNCOMP_DATA, &data));
+    MJD_TEST_ASSERT_EQUAL_INT(2508, data.temperature_centicelsius);
+    MJD_TEST_ASSERT_EQUAL_UINT(10065328, data.pressure_centipascal);
+    MJD_TEST_ASSERT_EQUAL_UINT(40052, data.humidity_percent_q10);
+}
+
+/*
+ * Sweep: -20..+60 C, 800..1100 hPa, 10..90 %RH (raw ADC values)
+ */
+static void test_integer_accuracy_versus_float(void) {
+    struct bme280_calib_data calib_data = GOLDEN_CALIB_DATA;
+    mjd_bme280_data_t data_float;
+    mjd_bme280_data_t data_int32;
+    mjd_bme280_data_t data_int64;
+    double max_error_temperature = 0;
+    double max_error_pressure_int32 = 0;
+    double max_error_pressure_int64 = 0;
+    double max_error_humidity = 0;
+
+    for (uint32_t adc_t = 420000; adc_t <= 580000; adc_t += 8000) {
+        for (uint32_t adc_p = 260000; adc_p <= 480000; adc_p += 11000) {
+            for (uint32_t adc_h = 18000; adc_h <= 40000; adc_h += 2200) {
+                const struct bme280_uncomp_data uncomp_data =
+                    { .pressure = adc_p, .temperature = adc_t, .humidity = adc_h };
+
+                mjd_bme280_compensate(MJD_BME280_COMPENSATION_FLOAT, &calib_data, &uncomp_data, &data_float);
+                mjd_bme280_compensate(MJD_BME280_COMPENSATION_INT32, &calib_data, &uncomp_data, &data_int32);
+                mjd_bme280_compensate(MJD_BME280_COMPENSATION_INT64, &calib_data, &uncomp_data, &data_int64);
+
+                max_error_temperature = fmax(max_error_temperature,
+                        fabs(data_int64.temperature_centicelsius / 100.0 - data_float.temperature_celsius));
+                max_error_pressure_int32 = fmax(max_error_pressure_int32,
+                        fabs(data_int32.pressure_centipascal / 100.0 - data_float.pressure_hpascal * 100));
+                max_error_pressure_int64 = fmax(max_error_pressure_int64,
+                        fabs(data_int64.pressure_centipascal / 100.0 - data_float.pressure_hpascal * 100));
+                max_error_humidity = fmax(max_error_humidity, fabs(data_int64.humidity_percent_q10 / 1024.0 - data_float.humidity_percent));
+            }
+        }
+    }
+    printf("  max error versus FLOAT: temperature %.4f C | pressure INT32 %.3f Pa INT64 %.3f Pa | humidity %.4f %%RH\n",
+            max_error_temperature, max_error_pressure_int32, max_error_pressure_int64, max_error_humidity);
+
+    MJD_TEST_ASSERT(max_error_temperature <= 0.02);
+    MJD_TEST_ASSERT(max_error_pressure_int32 <= 6.0);
+    MJD_TEST_ASSERT(max_error_pressure_int64 <= 0.1);
+    MJD_TEST_ASSERT(max_error_humidity <= 0.01);
+}
+
+static void test_invalid_args(void) {
+    struct bme280_calib_data calib_data = GOLDEN_CALIB_DATA;
+    mjd_bme280_data_t data;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_bme280_compensate(MJD_BME280_COMPENSATION_MAX, &calib_data, &GOLDEN_UNCOMP_DATA, &data));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_bme280_compensate(MJD_BME280_COMPENSATION_INT64, NULL, &GOLDEN_UNCOMP_DATA, &data));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_bme280_compensate(MJD_BME280_COMPENSATION_INT64, &calib_data, &GOLDEN_UNCOMP_DATA, NULL));
+
+    // Invalid calibration data (dig_P1 = 0): no division by zero, the pressure is clamped
+    calib_data.dig_P1 = 0;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bme280_compensate(MJD_BME280_COMPENSATION_INT32, &calib_data, &GOLDEN_UNCOMP_DATA, &data));
+    MJD_TEST_ASSERT_EQUAL_UINT(3000000, data.pressure_centipascal);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bme280_compensate(MJD_BME280_COMPENSATION_INT64, &calib_data, &GOLDEN_UNCOMP_DATA, &data));
+    MJD_TEST_ASSERT_EQUAL_UINT(3000000, data.pressure_centipascal);
+}
+
+/*
+ * Normal mode: the register map of a BME280 with the golden calibration data and the golden raw ADC values
+ */
+#define SLAVE_ADDR (0x76)
+
+static void _setup_slave_registers(void) {
+    const struct bme280_calib_data* ptr_calib = &GOLDEN_CALIB_DATA;
+    const int32_t calib_tp[12] =
+        { ptr_calib->dig_T1, ptr_calib->dig_T2, ptr_calib->dig_T3, ptr_calib->dig_P1, ptr_calib->dig_P2, ptr_calib->dig_P3,
+          ptr_calib->dig_P4, ptr_calib->dig_P5, ptr_calib->dig_P6, ptr_calib->dig_P7, ptr_calib->dig_P8, ptr_calib->dig_P9 };
+    uint8_t calib_regs[26] =
+        { 0 };
+    uint8_t calib_h_regs[7] =
+        { 0 };
+    uint8_t data_regs[8] =
+        { 0 };
+    const uint8_t chip_id = BME280_CHIP_ID;
+
+    // 0x88..0xA1: dig_T1..dig_P9 (little endian) + dig_H1
+    for (uint32_t idx = 0; idx < ARRAY_SIZE(calib_tp); idx++) {
+        calib_regs[idx * 2] = (uint8_t) (calib_tp[idx] & 0xFF);
+        calib_regs[idx * 2 + 1] = (uint8_t) ((calib_tp[idx] >> 8) & 0xFF);
+    }
+    calib_regs[25] = ptr_calib->dig_H1;
+
+    // 0xE1..0xE7: dig_H2 (little endian), dig_H3, dig_H4 (12 bits) and dig_H5 (12 bits) share 0xE5, dig_H6
+    calib_h_regs[0] = (uint8_t) (ptr_calib->dig_H2 & 0xFF);
+    calib_h_regs[1] = (uint8_t) ((ptr_calib->dig_H2 >> 8) & 0xFF);
+    calib_h_regs[2] = ptr_calib->dig_H3;
+    calib_h_regs[3] = (uint8_t) (ptr_calib->dig_H4 >> 4);
+    calib_h_regs[4] = (uint8_t) (((ptr_calib->dig_H5 & 0x0F) << 4) | (ptr_calib->dig_H4 & 0x0F));
+    calib_h_regs[5] = (uint8_t) (ptr_calib->dig_H5 >> 4);
+    calib_h_regs[6] = (uint8_t) ptr_calib->dig_H6;
+
+    // 0xF7..0xFE: press (20 bits), temp (20 bits), hum (16 bits)
+    data_regs[0] = (uint8_t) (GOLDEN_UNCOMP_DATA.pressure >> 12);
+    data_regs[1] = (uint8_t) (GOLDEN_UNCOMP_DATA.pressure >> 4);
+    data_regs[2] = (uint8_t) ((GOLDEN_UNCOMP_DATA.pressure & 0x0F) << 4);
+    data_regs[3] = (uint8_t) (GOLDEN_UNCOMP_DATA.temperature >> 12);
+    data_regs[4] = (uint8_t) (GOLDEN_UNCOMP_DATA.temperature >> 4);
+    data_regs[5] = (uint8_t) ((GOLDEN_UNCOMP_DATA.temperature & 0x0F) << 4);
+    data_regs[6] = (uint8_t) (GOLDEN_UNCOMP_DATA.humidity >> 8);
+    data_regs[7] = (uint8_t) (GOLDEN_UNCOMP_DATA.humidity & 0xFF);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_host_i2c_set_registers(SLAVE_ADDR, BME280_CHIP_ID_ADDR, &chip_id, 1));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_host_i2c_set_registers(SLAVE_ADDR, 0x88, calib_regs, sizeof(calib_regs)));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_host_i2c_set_registers(SLAVE_ADDR, 0xE1, calib_h_regs, sizeof(calib_h_regs)));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_host_i2c_set_registers(SLAVE_ADDR, BME280_DATA_ADDR, data_regs, sizeof(data_regs)));
+}
+
+static void test_normal_mode_period(void) {
+    mjd_bme280_config_t config = MJD_BME280_CONFIG_DEFAULT();
+    struct bme280_settings settings =
+        { .osr_p = BME280_OVERSAMPLING_16X, .osr_t = BME280_OVERSAMPLING_2X, .osr_h = BME280_OVERSAMPLING_1X, .filter =
+                BME280_FILTER_COEFF_16, .standby_time = BME280_STANDBY_TIME_1_MS };
+
+    // Default: 1.25 + 2.3 + (9.2 + 0.575) + (2.3 + 0.575) + 62.5 millisec
+    MJD_TEST_ASSERT_EQUAL_UINT(78700, mjd_bme280_get_normal_mode_period_us(&config.normal_mode_settings));
+    // Data sheet chapter 3.5.3 indoor navigation: t_measure,max 46.1 millisec (+ 0.5 standby)
+    MJD_TEST_ASSERT_EQUAL_UINT(46600, mjd_bme280_get_normal_mode_period_us(&settings));
+    // Humidity and pressure skipped
+    settings.osr_p = BME280_NO_OVERSAMPLING;
+    settings.osr_h = BME280_NO_OVERSAMPLING;
+    settings.standby_time = BME280_STANDBY_TIME_20_MS;
+    MJD_TEST_ASSERT_EQUAL_UINT(25850, mjd_bme280_get_normal_mode_period_us(&settings));
+}
+
+static void test_normal_mode_sampling(void) {
+    mjd_bme280_config_t config = MJD_BME280_CONFIG_DEFAULT();
+    mjd_bme280_sampling_stats_t stats;
+    mjd_bme280_sample_t sample;
+    mjd_bme280_data_t data;
+    uint8_t regs[2];
+
+    config.compensation = MJD_BME280_COMPENSATION_INT64;
+    config.sampling_queue_length = 4;
+    config.i2c_scl_gpio_num = GPIO_NUM_22;
+    config.i2c_sda_gpio_num = GPIO_NUM_21;
+
+    _setup_slave_registers();
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, mjd_bme280_start_sampling(&config)); // Not init'd
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bme280_init(&config));
+    MJD_TEST_ASSERT_EQUAL_INT(BME280_CHIP_ID, config.bme280_device.chip_id);
+    MJD_TEST_ASSERT_EQUAL_INT(GOLDEN_CALIB_DATA.dig_H4, config.bme280_device.calib_data.dig_H4);
+    MJD_TEST_ASSERT_EQUAL_INT(GOLDEN_CALIB_DATA.dig_H5, config.bme280_device.calib_data.dig_H5);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, mjd_bme280_sampling_read_burst(&config));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bme280_start_sampling(&config));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, mjd_bme280_start_sampling(&config));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, mjd_bme280_read_forced(&config, &data));
+
+    // ctrl_meas 0xF4: osr_t x1, osr_p x4, normal mode | config 0xF5: standby 62.5 ms, filter 4
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_host_i2c_get_registers(SLAVE_ADDR, 0xF4, regs, sizeof(regs)));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x2F, regs[0]);
+    MJD_TEST_ASSERT_EQUAL_UINT(0x28, regs[1]);
+
+    // 5 samples in a queue of 4: the 5th one is dropped
+    for (uint32_t idx = 0; idx < 5; idx++) {
+        const uint32_t nbr_of_transactions = mjd_host_i2c_get_nbr_of_transactions();
+
+        mjd_host_advance_time_us(78700);
+        MJD_TEST_ASSERT_EQUAL_INT((idx < 4) ? ESP_OK : ESP_ERR_NO_MEM, mjd_bme280_sampling_read_burst(&config));
+        MJD_TEST_ASSERT_EQUAL_UINT(nbr_of_transactions + 1, mjd_host_i2c_get_nbr_of_transactions()); // 1 burst read
+    }
+
+    for (uint32_t idx = 0; idx < 4; idx++) {
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bme280_receive_sample(&config, &sample, 0));
+        MJD_TEST_ASSERT_EQUAL_UINT(idx + 1, sample.sample_nbr);
+        MJD_TEST_ASSERT_EQUAL_INT(2508, sample.data.temperature_centicelsius);
+        MJD_TEST_ASSERT_EQUAL_UINT(10065328, sample.data.pressure_centipascal);
+        MJD_TEST_ASSERT_EQUAL_UINT(40052, sample.data.humidity_percent_q10);
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_TIMEOUT, mjd_bme280_receive_sample(&config, &sample, 0));
+    MJD_TEST_ASSERT(sample.timestamp_us >= 4 * 78700);
+
+    // A burst read that fails
+    mjd_host_i2c_set_cmd_begin_retval(ESP_FAIL);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_FAIL, mjd_bme280_sampling_read_burst(&config));
+    mjd_host_i2c_set_cmd_begin_retval(ESP_OK);
+
+    // 1 sample late
+    mjd_host_advance_time_us(2 * 78700);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bme280_sampling_read_burst(&config));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bme280_receive_sample(&config, &sample, 0));
+    MJD_TEST_ASSERT_EQUAL_UINT(6, sample.sample_nbr);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bme280_get_sampling_stats(&config, &stats));
+    MJD_TEST_ASSERT_EQUAL_UINT(6, stats.nbr_of_samples);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, stats.nbr_of_dropped_samples);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, stats.nbr_of_read_errors);
+    MJD_TEST_ASSERT_EQUAL_UINT(78700, stats.expected_period_us);
+    MJD_TEST_ASSERT_EQUAL_UINT(78700, stats.min_interval_us);
+    MJD_TEST_ASSERT_EQUAL_UINT(2 * 78700, stats.max_interval_us);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.01, 5.0 * 1000000.0 / (6 * 78700), stats.achieved_rate_hz);
+
+    // Stop: the sampling task exits while mjd_bme280_stop_sampling() waits for it, the sensor goes back to sleep mode
+    mjd_host_run_task_at_next_delay(config.sampling_task_handle);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bme280_stop_sampling(&config));
+    MJD_TEST_ASSERT(config.is_sampling == false);
+    MJD_TEST_ASSERT(config.sampling_queue_handle == NULL);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_host_i2c_get_registers(SLAVE_ADDR, 0xF4, regs, sizeof(regs)));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x2C, regs[0]);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, mjd_bme280_stop_sampling(&config));
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_golden_float);
+    MJD_TEST_RUN(test_golden_int32);
+    MJD_TEST_RUN(test_golden_int64);
+    MJD_TEST_RUN(test_integer_accuracy_versus_float);
+    MJD_TEST_RUN(test_invalid_args);
+    MJD_TEST_RUN(test_normal_mode_period);
+    MJD_TEST_RUN(test_normal_mode_sampling);
+    return MJD_TEST_REPORT();
+}
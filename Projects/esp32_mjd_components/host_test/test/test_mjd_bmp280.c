@@ -0,0 +1,207 @@
+/*
+ * HOST TEST: mjd_bmp280 compensation modes (FLOAT, INT32, INT64) with the Bosch BMP280 driver
+ *
+ * @doc Golden values: the calibration example of the BMP280 data sheet chapter 3.12 (adc_T 519888 = 25.08 C, adc_P 415148 = 100653.27 Pa).
+ *      The Bosch driver reads the calibration data from a fake register map (bmp280_init()).
+ * @doc Normal mode: the sensor is a simulated I2C slave (the same register map) so the Bosch driver, the burst read and the sample queue
+ *      run for real. The sampling task does not run on the host: the test calls mjd_bmp280_sampling_read_burst() once per period.
+ */
+#include "mjd.h"
+#include "mjd_bmp280.h"
+
+#include "mjd_host.h"
+#include "mjd_test.h"
+
+#define GOLDEN_ADC_T (519888)
+#define GOLDEN_ADC_P (415148)
+
+/*
+ * Register map: chip id (0xD0) + the calibration data dig_T1..dig_P9 (0x88..0x9F, little endian)
+ */
+static uint8_t _registers[256];
+
+static s8 _fake_bus_read(u8 dev_addr, u8 reg_addr, u8 *reg_data, u8 cnt) {
+    (void) dev_addr;
+    memcpy(reg_data, &_registers[reg_addr], cnt);
+    return SUCCESS;
+}
+
+static s8 _fake_bus_write(u8 dev_addr, u8 reg_addr, u8 *reg_data, u8 cnt) {
+    (void) dev_addr;
+    memcpy(&_registers[reg_addr], reg_data, cnt);
+    return SUCCESS;
+}
+
+static void _fake_delay_msec(u32 millisec) {
+    (void) millisec;
+}
+
+static struct bmp280_t _bmp280;
+
+static void _init_bosch_driver(void) {
+    const int32_t calib[12] =
+        { 27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000 };
+
+    memset(_registers, 0, sizeof(_registers));
+    _registers[0xD0] = 0x58;
+    for (uint32_t idx = 0; idx < ARRAY_SIZE(calib); idx++) {
+        _registers[0x88 + (idx * 2)] = (uint8_t) (calib[idx] & 0xFF);
+        _registers[0x88 + (idx * 2) + 1] = (uint8_t) ((calib[idx] >> 8) & 0xFF);
+    }
+
+    memset(&_bmp280, 0, sizeof(_bmp280));
+    _bmp280.bus_read = _fake_bus_read;
+    _bmp280.bus_write = _fake_bus_write;
+    _bmp280.delay_msec = _fake_delay_msec;
+    MJD_TEST_ASSERT_EQUAL_INT(SUCCESS, bmp280_init(&_bmp280));
+    MJD_TEST_ASSERT_EQUAL_INT(-10685, _bmp280.calib_param.dig_P2);
+}
+
+static void test_golden_values(void) {
+    mjd_bmp280_data_t data;
+
+    _init_bosch_driver();
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bmp280_compensate(MJD_BMP280_COMPENSATION_FLOAT, GOLDEN_ADC_P, GOLDEN_ADC_T, &data));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.005, 25.08, data.temperature_celsius);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 1006.5327, data.pressure_hpascal);
+    MJD_TEST_ASSERT_EQUAL_INT(2508, data.temperature_centicelsius);
+
+    memset(&data, 0, sizeof(data));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bmp280_compensate(MJD_BMP280_COMPENSATION_INT32, GOLDEN_ADC_P, GOLDEN_ADC_T, &data));
+    MJD_TEST_ASSERT_EQUAL_INT(2508, data.temperature_centicelsius);
+    MJD_TEST_ASSERT_EQUAL_UINT(10065600, data.pressure_centipascal); // 1 Pa resolution, the 32-bit formula is 3 Pa off here
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.0, 0.0, data.pressure_hpascal); // The integer modes do not set the doubles
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bmp280_compensate(MJD_BMP280_COMPENSATION_INT64, GOLDEN_ADC_P, GOLDEN_ADC_T, &data));
+    MJD_TEST_ASSERT_EQUAL_INT(2508, data.temperature_centicelsius);
+    MJD_TEST_ASSERT_EQUAL_UINT(10065325, data.pressure_centipascal); // Q24.8 25767232 (data sheet: 100653.27 Pa)
+}
+
+static void test_integer_accuracy_versus_float(void) {
+    mjd_bmp280_data_t data_float;
+    mjd_bmp280_data_t data_int32;
+    mjd_bmp280_data_t data_int64;
+    double max_error_temperature = 0;
+    double max_error_pressure_int32 = 0;
+    double max_error_pressure_int64 = 0;
+
+    _init_bosch_driver();
+
+    for (s32 adc_t = 420000; adc_t <= 580000; adc_t += 4000) {
+        for (s32 adc_p = 260000; adc_p <= 480000; adc_p += 5000) {
+            mjd_bmp280_compensate(MJD_BMP280_COMPENSATION_FLOAT, adc_p, adc_t, &data_float);
+            mjd_bmp280_compensate(MJD_BMP280_COMPENSATION_INT32, adc_p, adc_t, &data_int32);
+            mjd_bmp280_compensate(MJD_BMP280_COMPENSATION_INT64, adc_p, adc_t, &data_int64);
+
+            max_error_temperature = fmax(max_error_temperature,
+                    fabs(data_int64.temperature_centicelsius / 100.0 - data_float.temperature_celsius));
+            max_error_pressure_int32 = fmax(max_error_pressure_int32,
+                    fabs(data_int32.pressure_centipascal / 100.0 - data_float.pressure_hpascal * 100));
+            max_error_pressure_int64 = fmax(max_error_pressure_int64,
+                    fabs(data_int64.pressure_centipascal / 100.0 - data_float.pressure_hpascal * 100));
+        }
+    }
+    printf("  max error versus FLOAT: temperature %.4f C | pressure INT32 %.3f Pa INT64 %.3f Pa\n", max_error_temperature,
+            max_error_pressure_int32, max_error_pressure_int64);
+
+    MJD_TEST_ASSERT(max_error_temperature <= 0.02);
+    MJD_TEST_ASSERT(max_error_pressure_int32 <= 8.0);
+    MJD_TEST_ASSERT(max_error_pressure_int64 <= 0.1);
+}
+
+static void test_invalid_args(void) {
+    mjd_bmp280_data_t data;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_bmp280_compensate(MJD_BMP280_COMPENSATION_MAX, GOLDEN_ADC_P, GOLDEN_ADC_T, &data));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_bmp280_compensate(MJD_BMP280_COMPENSATION_INT64, GOLDEN_ADC_P, GOLDEN_ADC_T, NULL));
+}
+
+static void test_normal_mode_period(void) {
+    // Standard resolution (osr_p x4, osr_t x1) + standby 62.5 ms: 1.25 + 2.3 + (9.2 + 0.575) + 62.5 millisec
+    MJD_TEST_ASSERT_EQUAL_UINT(75825,
+            mjd_bmp280_get_normal_mode_period_us(BMP280_OVERSAMP_4X, BMP280_OVERSAMP_1X, BMP280_STANDBY_TIME_63_MS));
+    // Data sheet chapter 3.8.1 ultra high resolution: t_measure,max 43.2 millisec (43.225 + 0.5 standby)
+    MJD_TEST_ASSERT_EQUAL_UINT(43725,
+            mjd_bmp280_get_normal_mode_period_us(BMP280_OVERSAMP_16X, BMP280_OVERSAMP_2X, BMP280_STANDBY_TIME_1_MS));
+    // Pressure skipped
+    MJD_TEST_ASSERT_EQUAL_UINT(4003550,
+            mjd_bmp280_get_normal_mode_period_us(BMP280_OVERSAMP_SKIPPED, BMP280_OVERSAMP_1X, BMP280_STANDBY_TIME_4000_MS));
+}
+
+static void test_normal_mode_sampling(void) {
+    mjd_bmp280_config_t config = MJD_BMP280_CONFIG_DEFAULT();
+    mjd_bmp280_sampling_stats_t stats;
+    mjd_bmp280_sample_t sample;
+    mjd_bmp280_data_t data;
+    uint8_t regs[2];
+    const uint8_t data_regs[6] =
+        { GOLDEN_ADC_P >> 12, (GOLDEN_ADC_P >> 4) & 0xFF, (GOLDEN_ADC_P & 0x0F) << 4, GOLDEN_ADC_T >> 12, (GOLDEN_ADC_T >> 4) & 0xFF,
+          (GOLDEN_ADC_T & 0x0F) << 4 };
+
+    // The simulated I2C slave: chip id + calibration data + the golden raw ADC values (0xF7..0xFC)
+    _init_bosch_driver();
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_host_i2c_set_registers(config.i2c_slave_addr, 0x00, _registers, sizeof(_registers)));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_host_i2c_set_registers(config.i2c_slave_addr, 0xF7, data_regs, sizeof(data_regs)));
+
+    config.bmp280_work_mode = BMP280_STANDARD_RESOLUTION_MODE;
+    config.bmp280_filter_coefficient = BMP280_FILTER_COEFF_4;
+    config.compensation = MJD_BMP280_COMPENSATION_INT64;
+
+    config.sampling_queue_length = 0;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_bmp280_start_sampling(&config));
+    config.sampling_queue_length = 2;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bmp280_start_sampling(&config));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, mjd_bmp280_start_sampling(&config));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, mjd_bmp280_read_forced(&config, &data));
+
+    // ctrl_meas 0xF4: osr_t x1, osr_p x4, normal mode | config 0xF5: standby 62.5 ms, filter 4
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_host_i2c_get_registers(config.i2c_slave_addr, 0xF4, regs, sizeof(regs)));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x2F, regs[0]);
+    MJD_TEST_ASSERT_EQUAL_UINT(0x28, regs[1]);
+
+    // 3 samples in a queue of 2: the 3rd one is dropped
+    for (uint32_t idx = 0; idx < 3; idx++) {
+        const uint32_t nbr_of_transactions = mjd_host_i2c_get_nbr_of_transactions();
+
+        mjd_host_advance_time_us(75825);
+        MJD_TEST_ASSERT_EQUAL_INT((idx < 2) ? ESP_OK : ESP_ERR_NO_MEM, mjd_bmp280_sampling_read_burst(&config));
+        MJD_TEST_ASSERT_EQUAL_UINT(nbr_of_transactions + 1, mjd_host_i2c_get_nbr_of_transactions()); // 1 burst read
+    }
+
+    for (uint32_t idx = 0; idx < 2; idx++) {
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bmp280_receive_sample(&config, &sample, 0));
+        MJD_TEST_ASSERT_EQUAL_UINT(idx + 1, sample.sample_nbr);
+        MJD_TEST_ASSERT_EQUAL_INT((int64_t) (idx + 1) * 75825, sample.timestamp_us);
+        MJD_TEST_ASSERT_EQUAL_INT(2508, sample.data.temperature_centicelsius);
+        MJD_TEST_ASSERT_EQUAL_UINT(10065325, sample.data.pressure_centipascal);
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_TIMEOUT, mjd_bmp280_receive_sample(&config, &sample, 0));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bmp280_get_sampling_stats(&config, &stats));
+    MJD_TEST_ASSERT_EQUAL_UINT(3, stats.nbr_of_samples);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, stats.nbr_of_dropped_samples);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, stats.nbr_of_read_errors);
+    MJD_TEST_ASSERT_EQUAL_UINT(75825, stats.expected_period_us);
+    MJD_TEST_ASSERT_EQUAL_UINT(75825, stats.min_interval_us);
+    MJD_TEST_ASSERT_EQUAL_UINT(75825, stats.max_interval_us);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.01, 1000000.0 / 75825, stats.achieved_rate_hz);
+
+    // Stop: the sampling task exits while mjd_bmp280_stop_sampling() waits for it, the sensor goes back to sleep mode
+    mjd_host_run_task_at_next_delay(config.sampling_task_handle);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_bmp280_stop_sampling(&config));
+    MJD_TEST_ASSERT(config.is_sampling == false);
+    MJD_TEST_ASSERT(config.sampling_queue_handle == NULL);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_host_i2c_get_registers(config.i2c_slave_addr, 0xF4, regs, sizeof(regs)));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x2C, regs[0]);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, mjd_bmp280_stop_sampling(&config));
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_golden_values);
+    MJD_TEST_RUN(test_integer_accuracy_versus_float);
+    MJD_TEST_RUN(test_invalid_args);
+    MJD_TEST_RUN(test_normal_mode_period);
+    MJD_TEST_RUN(test_normal_mode_sampling);
+    return MJD_TEST_REPORT();
+}
@@ -0,0 +1,184 @@
+/*
+ * HOST TEST: mjd_boot boot-time profiler, lazy init and parallel init (with the simulated clock of the shims)
+ */
+#include "mjd.h"
+#include "mjd_boot.h"
+
+#include "mjd_host.h"
+#include "mjd_test.h"
+
+/*
+ * @brief A fake driver init: it takes *param_ptr_arg microseconds (simulated).
+ */
+static esp_err_t _init_sleep(void * param_ptr_arg) {
+    mjd_host_advance_time_us(*(const uint32_t *) param_ptr_arg);
+    return ESP_OK;
+}
+
+static esp_err_t _init_fail(void * param_ptr_arg) {
+    mjd_host_advance_time_us(100);
+    return ESP_ERR_TIMEOUT;
+}
+
+static void test_phases(void) {
+    mjd_boot_phase_t phases[8];
+    uint32_t duration_us = 25000;
+
+    mjd_boot_reset();
+    mjd_host_advance_time_us(1000);
+
+    int32_t idx = mjd_boot_phase_begin("nvs_flash_init");
+    mjd_host_advance_time_us(12000);
+    mjd_boot_phase_end(idx, ESP_OK);
+    MJD_TEST_ASSERT(MJD_BOOT_PHASE("bme280", _init_sleep(&duration_us)) == ESP_OK);
+    MJD_TEST_ASSERT(mjd_boot_phase_run("ds3231", _init_fail, NULL) == ESP_ERR_TIMEOUT);
+    mjd_boot_mark("first reading");
+
+    MJD_TEST_ASSERT_EQUAL_UINT(4, mjd_boot_get_phases(phases, ARRAY_SIZE(phases)));
+    MJD_TEST_ASSERT_EQUAL_STRING("nvs_flash_init", phases[0].name);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_BOOT_PHASE_KIND_SERIAL, phases[0].kind);
+    MJD_TEST_ASSERT_EQUAL_INT(1000, phases[0].start_us);
+    MJD_TEST_ASSERT_EQUAL_INT(13000, phases[0].end_us);
+    MJD_TEST_ASSERT(phases[0].is_ended == true);
+    MJD_TEST_ASSERT_EQUAL_INT(13000, phases[1].start_us);
+    MJD_TEST_ASSERT_EQUAL_INT(38000, phases[1].end_us);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_TIMEOUT, phases[2].retval);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_BOOT_PHASE_KIND_MARK, phases[3].kind);
+    MJD_TEST_ASSERT_EQUAL_INT(38100, phases[3].start_us);
+    MJD_TEST_ASSERT_EQUAL_INT(phases[3].start_us, phases[3].end_us);
+
+    mjd_boot_log_report();
+}
+
+static void test_table_full(void) {
+    mjd_boot_phase_t phases[CONFIG_MJD_BOOT_MAX_PHASES];
+
+    mjd_boot_reset();
+    for (uint32_t idx = 0; idx < CONFIG_MJD_BOOT_MAX_PHASES; idx++) {
+        MJD_TEST_ASSERT_EQUAL_INT(idx, mjd_boot_phase_begin("phase"));
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(-1, mjd_boot_phase_begin("dropped"));
+    mjd_boot_phase_end(-1, ESP_OK); // ignored
+    mjd_boot_mark("dropped too");
+    MJD_TEST_ASSERT_EQUAL_UINT(2, mjd_boot_get_nbr_of_dropped());
+    MJD_TEST_ASSERT_EQUAL_UINT(CONFIG_MJD_BOOT_MAX_PHASES, mjd_boot_get_phases(phases, ARRAY_SIZE(phases)));
+    MJD_TEST_ASSERT(phases[0].is_ended == false);
+
+    mjd_boot_reset();
+    MJD_TEST_ASSERT_EQUAL_UINT(0, mjd_boot_get_phases(phases, ARRAY_SIZE(phases)));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, mjd_boot_get_nbr_of_dropped());
+}
+
+static void test_parallel(void) {
+    uint32_t durations_us[3] = { 30000, 50000, 20000 };
+    mjd_boot_init_t inits[3] = {
+            MJD_BOOT_INIT("bme280", _init_sleep, &durations_us[0]),
+            MJD_BOOT_INIT("wifi", _init_sleep, &durations_us[1]),
+            MJD_BOOT_INIT("sdcard", _init_sleep, &durations_us[2]),
+        };
+    mjd_boot_parallel_result_t result;
+    mjd_boot_phase_t phases[8];
+
+    mjd_boot_reset();
+    MJD_TEST_ASSERT(mjd_boot_run_parallel("sensors", inits, ARRAY_SIZE(inits), &result) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(100000, result.serial_sum_us);
+    MJD_TEST_ASSERT_EQUAL_UINT(100000, result.wall_us); // The host runs them one after the other
+    MJD_TEST_ASSERT_EQUAL_INT(0, result.saved_us);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, result.nbr_of_errors);
+
+    MJD_TEST_ASSERT_EQUAL_UINT(4, mjd_boot_get_phases(phases, ARRAY_SIZE(phases)));
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_BOOT_PHASE_KIND_GROUP, phases[0].kind);
+    for (uint32_t idx = 1; idx < 4; idx++) {
+        MJD_TEST_ASSERT_EQUAL_INT(MJD_BOOT_PHASE_KIND_PARALLEL, phases[idx].kind);
+        MJD_TEST_ASSERT_EQUAL_INT(0, phases[idx].group_idx);
+    }
+
+    // 1 init fails: the others still run, the first error is returned
+    inits[1].init_fn = _init_fail;
+    MJD_TEST_ASSERT(mjd_boot_run_parallel("sensors", inits, ARRAY_SIZE(inits), &result) == ESP_ERR_TIMEOUT);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, inits[0].retval);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_TIMEOUT, inits[1].retval);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, inits[2].retval);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, result.nbr_of_errors);
+    MJD_TEST_ASSERT_EQUAL_UINT(50100, result.serial_sum_us);
+
+    MJD_TEST_ASSERT(mjd_boot_run_parallel("none", inits, 0, &result) == ESP_ERR_INVALID_ARG);
+    inits[2].init_fn = NULL;
+    MJD_TEST_ASSERT(mjd_boot_run_parallel("no fn", inits, ARRAY_SIZE(inits), &result) == ESP_ERR_INVALID_ARG);
+}
+
+static uint32_t _nbr_of_flaky_calls = 0;
+
+static esp_err_t _init_flaky(void * param_ptr_arg) {
+    // Fails the first time (e.g. the sensor was still powering up)
+    mjd_host_advance_time_us(1000);
+    return (++_nbr_of_flaky_calls == 1) ? ESP_ERR_NOT_FOUND : ESP_OK;
+}
+
+static mjd_boot_lazy_t _recursive_lazy;
+
+static esp_err_t _init_recursive(void * param_ptr_arg) {
+    return mjd_boot_lazy_ensure(&_recursive_lazy);
+}
+
+static void test_lazy(void) {
+    mjd_boot_lazy_t lazy = MJD_BOOT_LAZY_INITIALIZER("mlx90393", _init_flaky, NULL);
+    mjd_boot_phase_t phases[8];
+
+    mjd_boot_reset();
+    _nbr_of_flaky_calls = 0;
+
+    MJD_TEST_ASSERT(mjd_boot_lazy_is_done(&lazy) == false);
+    MJD_TEST_ASSERT(mjd_boot_lazy_ensure(&lazy) == ESP_ERR_NOT_FOUND);
+    MJD_TEST_ASSERT(mjd_boot_lazy_is_done(&lazy) == false);
+    MJD_TEST_ASSERT(mjd_boot_lazy_ensure(&lazy) == ESP_OK);
+    MJD_TEST_ASSERT(mjd_boot_lazy_is_done(&lazy) == true);
+    for (uint32_t idx = 0; idx < 10; idx++) {
+        MJD_TEST_ASSERT(mjd_boot_lazy_ensure(&lazy) == ESP_OK);
+    }
+    MJD_TEST_ASSERT_EQUAL_UINT(2, _nbr_of_flaky_calls);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, lazy.nbr_of_attempts);
+
+    // 1 phase per attempt
+    MJD_TEST_ASSERT_EQUAL_UINT(2, mjd_boot_get_phases(phases, ARRAY_SIZE(phases)));
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_BOOT_PHASE_KIND_LAZY, phases[0].kind);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_NOT_FOUND, phases[0].retval);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, phases[1].retval);
+
+    // A recursive init is an error, not a deadlock
+    _recursive_lazy = (mjd_boot_lazy_t) MJD_BOOT_LAZY_INITIALIZER("recursive", _init_recursive, NULL);
+    MJD_TEST_ASSERT(mjd_boot_lazy_ensure(&_recursive_lazy) == ESP_ERR_INVALID_STATE);
+    MJD_TEST_ASSERT(_recursive_lazy.state == MJD_BOOT_LAZY_STATE_NOT_STARTED);
+}
+
+static void test_export_csv(void) {
+    char buf[512];
+    size_t len;
+    uint32_t duration_us = 2500;
+
+    mjd_boot_reset();
+    MJD_BOOT_PHASE("bme280", _init_sleep(&duration_us));
+    mjd_boot_mark("first reading");
+
+    MJD_TEST_ASSERT(mjd_boot_export_csv(buf, sizeof(buf), &len) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(strlen(buf), len);
+    MJD_TEST_ASSERT_EQUAL_STRING("idx,name,kind,group,core,start_us,end_us,duration_us,retval\n"
+            "0,bme280,serial,-1,0,0,2500,2500,0\n"
+            "1,first reading,mark,-1,0,2500,2500,0,0\n", buf);
+
+    // Too small: only complete lines
+    MJD_TEST_ASSERT(mjd_boot_export_csv(buf, 100, &len) == ESP_ERR_INVALID_SIZE);
+    MJD_TEST_ASSERT_EQUAL_STRING("idx,name,kind,group,core,start_us,end_us,duration_us,retval\n"
+            "0,bme280,serial,-1,0,0,2500,2500,0\n", buf);
+    MJD_TEST_ASSERT(mjd_boot_export_csv(buf, 10, &len) == ESP_ERR_INVALID_SIZE);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, len);
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_phases);
+    MJD_TEST_RUN(test_table_full);
+    MJD_TEST_RUN(test_parallel);
+    MJD_TEST_RUN(test_lazy);
+    MJD_TEST_RUN(test_export_csv);
+    return MJD_TEST_REPORT();
+}
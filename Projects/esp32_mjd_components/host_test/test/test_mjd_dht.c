@@ -0,0 +1,238 @@
+/*
+ * HOST TEST: mjd_dht RMT pulse train decoder (DHT11 + DHT22), single and concurrent reads, the mjd_dht11 + mjd_dht22 wrappers
+ *
+ * @doc The pulse trains are recorded durations in microseconds, alternating HIGH/LOW and starting with the released data line (HIGH):
+ *      release + response LOW 80us + response HIGH 80us + 40x (LOW 50us + HIGH 26-28us|70us) + the final LOW 50us.
+ *      The start signal timer never fires on the host: the tests inject the frame in the RX ring buffer before the read.
+ */
+#include "mjd.h"
+#include "mjd_dht.h"
+#include "mjd_dht11.h"
+#include "mjd_dht22.h"
+
+#include "mjd_host.h"
+#include "mjd_test.h"
+
+#define TEST_MAX_NBR_OF_ITEMS (64)
+
+/*
+ * DHT22: 02 8C 80 65 73 => humidity 65.2% temperature -10.1C
+ */
+static const uint32_t RECORDED_DHT22_US[] =
+    { 30, 79, 84,
+      48, 23, 56, 23, 53, 22, 56, 25, 48, 23, 54, 28, 49, 69, 49, 28,
+      48, 67, 51, 22, 54, 22, 51, 22, 56, 68, 52, 72, 50, 23, 52, 24,
+      49, 69, 53, 23, 56, 23, 48, 25, 55, 28, 53, 29, 55, 27, 52, 25,
+      50, 25, 49, 70, 56, 73, 53, 29, 52, 23, 49, 74, 54, 24, 53, 68,
+      55, 28, 48, 67, 56, 71, 53, 71, 55, 29, 49, 23, 52, 73, 49, 66,
+      52 };
+
+/*
+ * DHT11: 2D 00 17 05 49 => humidity 45.0% temperature 23.5C
+ */
+static const uint32_t RECORDED_DHT11_US[] =
+    { 40, 82, 85,
+      52, 28, 53, 22, 55, 71, 50, 23, 55, 66, 51, 70, 50, 25, 54, 72,
+      55, 23, 50, 29, 54, 26, 50, 28, 56, 26, 54, 27, 54, 25, 50, 23,
+      50, 24, 51, 25, 48, 29, 50, 70, 52, 22, 50, 72, 56, 71, 53, 68,
+      56, 22, 55, 28, 54, 28, 54, 23, 55, 28, 48, 69, 49, 25, 55, 68,
+      49, 27, 48, 67, 48, 24, 56, 23, 53, 66, 49, 25, 54, 24, 52, 71,
+      53 };
+
+/*
+ * Pack the durations in RMT items (level HIGH first) and append the end marker (duration 0). Returns the nbr of items.
+ */
+static size_t _pack_items(const uint32_t* param_ptr_durations_us, size_t param_nbr_of_durations, rmt_item32_t* param_ptr_items) {
+    memset(param_ptr_items, 0, TEST_MAX_NBR_OF_ITEMS * sizeof(rmt_item32_t));
+    for (size_t idx = 0; idx < param_nbr_of_durations; idx++) {
+        rmt_item32_t* ptr_item = &param_ptr_items[idx / 2];
+        if (idx % 2 == 0) {
+            ptr_item->level0 = 1;
+            ptr_item->duration0 = param_ptr_durations_us[idx];
+        } else {
+            ptr_item->level1 = 0;
+            ptr_item->duration1 = param_ptr_durations_us[idx];
+        }
+    }
+    // The end marker is duration1 of the last item (odd nbr of durations) or a new item (even nbr of durations)
+    return (param_nbr_of_durations / 2) + 1;
+}
+
+static void _init_sensor(mjd_dht_config_t* param_ptr_config, mjd_dht_type_t param_type, gpio_num_t param_gpio_num,
+                         rmt_channel_t param_rmt_channel) {
+    mjd_dht_config_t config = MJD_DHT_CONFIG_DEFAULT();
+    config.type = param_type;
+    config.gpio_num = param_gpio_num;
+    config.rmt_channel = param_rmt_channel;
+    *param_ptr_config = config;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_dht_init(param_ptr_config));
+}
+
+static void _inject_trace(rmt_channel_t param_rmt_channel, const uint32_t* param_ptr_durations_us, size_t param_nbr_of_durations) {
+    rmt_item32_t items[TEST_MAX_NBR_OF_ITEMS];
+    size_t nbr_of_items = _pack_items(param_ptr_durations_us, param_nbr_of_durations, items);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_host_rmt_inject_rx_items(param_rmt_channel, items, nbr_of_items));
+}
+
+static void test_decode_dht22_negative_temperature(void) {
+    rmt_item32_t items[TEST_MAX_NBR_OF_ITEMS];
+    mjd_dht_data_t data;
+    size_t nbr_of_items = _pack_items(RECORDED_DHT22_US, ARRAY_SIZE(RECORDED_DHT22_US), items);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_dht_decode_items(MJD_DHT_TYPE_DHT22, items, nbr_of_items, &data));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 65.2, data.humidity_percent);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, -10.1, data.temperature_celsius);
+}
+
+static void test_decode_dht11(void) {
+    rmt_item32_t items[TEST_MAX_NBR_OF_ITEMS];
+    mjd_dht_data_t data;
+    size_t nbr_of_items = _pack_items(RECORDED_DHT11_US, ARRAY_SIZE(RECORDED_DHT11_US), items);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_dht_decode_items(MJD_DHT_TYPE_DHT11, items, nbr_of_items, &data));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 45.0, data.humidity_percent);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 23.5, data.temperature_celsius);
+}
+
+static void test_decode_skips_leading_glitches(void) {
+    rmt_item32_t items[TEST_MAX_NBR_OF_ITEMS];
+    uint32_t durations_us[ARRAY_SIZE(RECORDED_DHT11_US) + 4];
+    mjd_dht_data_t data;
+
+    // 2 glitches on the released line + the idle HIGH level before the response (> 100us)
+    durations_us[0] = 3;
+    durations_us[1] = 2;
+    durations_us[2] = 5;
+    durations_us[3] = 1;
+    memcpy(&durations_us[4], RECORDED_DHT11_US, sizeof(RECORDED_DHT11_US));
+    durations_us[4] = 450;
+    size_t nbr_of_items = _pack_items(durations_us, ARRAY_SIZE(durations_us), items);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_dht_decode_items(MJD_DHT_TYPE_DHT11, items, nbr_of_items, &data));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 45.0, data.humidity_percent);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 23.5, data.temperature_celsius);
+}
+
+static void test_decode_checksum_failure(void) {
+    rmt_item32_t items[TEST_MAX_NBR_OF_ITEMS];
+    uint32_t durations_us[ARRAY_SIZE(RECORDED_DHT22_US)];
+    mjd_dht_data_t data;
+
+    // Bit 0 (MSB of the humidity) 0 => 1
+    memcpy(durations_us, RECORDED_DHT22_US, sizeof(RECORDED_DHT22_US));
+    durations_us[4] = 70;
+    size_t nbr_of_items = _pack_items(durations_us, ARRAY_SIZE(durations_us), items);
+
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_ERR_CHECKSUM, mjd_dht_decode_items(MJD_DHT_TYPE_DHT22, items, nbr_of_items, &data));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 0.0, data.humidity_percent);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 0.0, data.temperature_celsius);
+}
+
+static void test_decode_truncated_frame(void) {
+    rmt_item32_t items[TEST_MAX_NBR_OF_ITEMS];
+    mjd_dht_data_t data;
+
+    // The frame stops after 30 bits (the end marker)
+    size_t nbr_of_items = _pack_items(RECORDED_DHT22_US, 3 + (30 * 2), items);
+
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_ERR_INVALID_DATA, mjd_dht_decode_items(MJD_DHT_TYPE_DHT22, items, nbr_of_items, &data));
+}
+
+static void test_read(void) {
+    mjd_dht_config_t config;
+    mjd_dht_data_t data;
+
+    _init_sensor(&config, MJD_DHT_TYPE_DHT22, GPIO_NUM_32, RMT_CHANNEL_1);
+    _inject_trace(config.rmt_channel, RECORDED_DHT22_US, ARRAY_SIZE(RECORDED_DHT22_US));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_dht_read(&config, &data));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 65.2, data.humidity_percent);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, -10.1, data.temperature_celsius);
+
+    // No response
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_TIMEOUT, mjd_dht_read(&config, &data));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_dht_deinit(&config));
+}
+
+static void test_read_multiple(void) {
+    mjd_dht_config_t configs[3];
+    mjd_dht_data_t datas[3];
+    esp_err_t retvals[3];
+    uint32_t corrupted_us[ARRAY_SIZE(RECORDED_DHT22_US)];
+
+    _init_sensor(&configs[0], MJD_DHT_TYPE_DHT22, GPIO_NUM_32, RMT_CHANNEL_1);
+    _init_sensor(&configs[1], MJD_DHT_TYPE_DHT11, GPIO_NUM_33, RMT_CHANNEL_2);
+    _init_sensor(&configs[2], MJD_DHT_TYPE_DHT22, GPIO_NUM_25, RMT_CHANNEL_3);
+
+    memcpy(corrupted_us, RECORDED_DHT22_US, sizeof(RECORDED_DHT22_US));
+    corrupted_us[ARRAY_SIZE(corrupted_us) - 2] = 23; // The LSB of the checksum 1 => 0
+
+    _inject_trace(configs[0].rmt_channel, RECORDED_DHT22_US, ARRAY_SIZE(RECORDED_DHT22_US));
+    _inject_trace(configs[1].rmt_channel, RECORDED_DHT11_US, ARRAY_SIZE(RECORDED_DHT11_US));
+    _inject_trace(configs[2].rmt_channel, corrupted_us, ARRAY_SIZE(corrupted_us));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_FAIL, mjd_dht_read_multiple(configs, 3, datas, retvals));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, retvals[0]);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, retvals[1]);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_ERR_CHECKSUM, retvals[2]);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 65.2, datas[0].humidity_percent);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, -10.1, datas[0].temperature_celsius);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 45.0, datas[1].humidity_percent);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 23.5, datas[1].temperature_celsius);
+
+    // Invalid args
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_dht_read_multiple(configs, 0, datas, retvals));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_dht_read_multiple(configs, MJD_DHT_MAX_NBR_OF_SENSORS + 1, datas, retvals));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_dht_read_multiple(NULL, 1, datas, retvals));
+}
+
+static void test_init_invalid_config(void) {
+    mjd_dht_config_t config = MJD_DHT_CONFIG_DEFAULT();
+
+    config.type = MJD_DHT_TYPE_MAX;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_dht_init(&config));
+    config.type = MJD_DHT_TYPE_DHT22;
+    config.rmt_channel = RMT_CHANNEL_MAX;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_dht_init(&config));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_dht_init(NULL));
+}
+
+static void test_dht11_dht22_wrappers(void) {
+    mjd_dht11_config_t dht11_config = { .gpio_pin = GPIO_NUM_33, .rmt_channel = RMT_CHANNEL_2 };
+    mjd_dht22_config_t dht22_config = { .gpio_pin = GPIO_NUM_32, .rmt_channel = RMT_CHANNEL_1 };
+    mjd_dht11_data_t dht11_data;
+    mjd_dht22_data_t dht22_data;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_dht11_init(&dht11_config));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_dht22_init(&dht22_config));
+
+    _inject_trace(dht11_config.rmt_channel, RECORDED_DHT11_US, ARRAY_SIZE(RECORDED_DHT11_US));
+    _inject_trace(dht22_config.rmt_channel, RECORDED_DHT22_US, ARRAY_SIZE(RECORDED_DHT22_US));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_dht11_read(&dht11_config, &dht11_data));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 45.0, dht11_data.humidity_percent);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 23.5, dht11_data.temperature_celsius);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_dht22_read(&dht22_config, &dht22_data));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 65.2, dht22_data.humidity_percent);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, -10.1, dht22_data.temperature_celsius);
+
+    // The wrapper retries 2 times (2 seconds apart) before it gives up
+    uint64_t start_us = mjd_host_get_time_us();
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_FAIL, mjd_dht22_read(&dht22_config, &dht22_data));
+    MJD_TEST_ASSERT(mjd_host_get_time_us() - start_us >= 4 * 1000 * 1000);
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_decode_dht22_negative_temperature);
+    MJD_TEST_RUN(test_decode_dht11);
+    MJD_TEST_RUN(test_decode_skips_leading_glitches);
+    MJD_TEST_RUN(test_decode_checksum_failure);
+    MJD_TEST_RUN(test_decode_truncated_frame);
+    MJD_TEST_RUN(test_read);
+    MJD_TEST_RUN(test_read_multiple);
+    MJD_TEST_RUN(test_init_invalid_config);
+    MJD_TEST_RUN(test_dht11_dht22_wrappers);
+    return MJD_TEST_REPORT();
+}
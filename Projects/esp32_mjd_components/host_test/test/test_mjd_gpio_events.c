@@ -0,0 +1,277 @@
+/*
+ * HOST TEST: mjd_gpio_events debouncer + lock-free event queue
+ *
+ * @doc The edges and the time are simulated: the test plays the role of the GPIO ISR (edges) and of the timer ISR (ticks).
+ */
+#include "mjd.h"
+#include "mjd_gpio_events_core.h"
+
+#include "mjd_test.h"
+
+#define SIM_TICK_US (1000)
+
+/*
+ * @brief The timer ISR: tick every SIM_TICK_US from param_from_us until param_to_us (excl).
+ * @return the nbr of events (the last one in param_ptr_event).
+ */
+static uint32_t _sim_ticks(mjd_gpio_events_debounce_t* ptr_debounce, uint8_t level, int64_t param_from_us, int64_t param_to_us,
+                           mjd_gpio_events_event_t* param_ptr_event) {
+    uint32_t nbr_of_events = 0;
+
+    for (int64_t now_us = param_from_us; now_us < param_to_us; now_us += SIM_TICK_US) {
+        if (mjd_gpio_events_debounce_tick(ptr_debounce, level, now_us, param_ptr_event) == true) {
+            nbr_of_events++;
+        }
+    }
+    return nbr_of_events;
+}
+
+static void test_debounce_bouncing_contact(void) {
+    mjd_gpio_events_debounce_t debounce;
+    mjd_gpio_events_event_t event;
+
+    mjd_gpio_events_debounce_init(&debounce, GPIO_NUM_14, 50000, 1);
+
+    // A reed contact closing: 5 edges within 3ms, settles LOW
+    mjd_gpio_events_debounce_edge(&debounce, 100000);
+    mjd_gpio_events_debounce_edge(&debounce, 100400);
+    mjd_gpio_events_debounce_edge(&debounce, 101100);
+    mjd_gpio_events_debounce_edge(&debounce, 102000);
+    mjd_gpio_events_debounce_edge(&debounce, 103000);
+
+    // Not settled before 50ms after the LAST edge
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _sim_ticks(&debounce, 0, 101000, 153000, &event));
+    MJD_TEST_ASSERT(debounce.is_settling == true);
+
+    MJD_TEST_ASSERT_EQUAL_UINT(1, _sim_ticks(&debounce, 0, 153000, 200000, &event));
+    MJD_TEST_ASSERT(debounce.is_settling == false);
+    MJD_TEST_ASSERT_EQUAL_INT(GPIO_NUM_14, event.gpio_num);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, event.level);
+    MJD_TEST_ASSERT_EQUAL_UINT(4, event.nbr_of_coalesced_edges);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, event.sequence);
+    MJD_TEST_ASSERT(event.timestamp_us == 100000); // the first edge, not the time it settled
+
+    MJD_TEST_ASSERT_EQUAL_UINT(5, debounce.stats.nbr_of_edges);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, debounce.stats.nbr_of_events);
+    MJD_TEST_ASSERT_EQUAL_UINT(4, debounce.stats.nbr_of_coalesced_edges);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, debounce.stats.nbr_of_glitches);
+
+    // The contact opens again (1 clean edge)
+    mjd_gpio_events_debounce_edge(&debounce, 500000);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, _sim_ticks(&debounce, 1, 500000, 600000, &event));
+    MJD_TEST_ASSERT_EQUAL_UINT(1, event.level);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, event.nbr_of_coalesced_edges);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, event.sequence);
+    MJD_TEST_ASSERT(event.timestamp_us == 500000);
+}
+
+static void test_debounce_glitch(void) {
+    mjd_gpio_events_debounce_t debounce;
+    mjd_gpio_events_event_t event;
+
+    mjd_gpio_events_debounce_init(&debounce, GPIO_NUM_27, 20000, 0);
+
+    // A 2ms spike: up + down, the pin is back at the stable level
+    mjd_gpio_events_debounce_edge(&debounce, 10000);
+    mjd_gpio_events_debounce_edge(&debounce, 12000);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _sim_ticks(&debounce, 0, 10000, 100000, &event));
+    MJD_TEST_ASSERT(debounce.is_settling == false);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, debounce.stats.nbr_of_events);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, debounce.stats.nbr_of_glitches);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, debounce.stats.nbr_of_coalesced_edges);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, debounce.stable_level);
+
+    // The sequence does not count glitches
+    mjd_gpio_events_debounce_edge(&debounce, 200000);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, _sim_ticks(&debounce, 1, 200000, 300000, &event));
+    MJD_TEST_ASSERT_EQUAL_UINT(1, event.sequence);
+}
+
+static void test_debounce_zero(void) {
+    mjd_gpio_events_debounce_t debounce;
+    mjd_gpio_events_event_t event;
+
+    // debounce 0 = settled at the next tick
+    mjd_gpio_events_debounce_init(&debounce, GPIO_NUM_4, 0, 0);
+    mjd_gpio_events_debounce_edge(&debounce, 5500);
+    MJD_TEST_ASSERT(mjd_gpio_events_debounce_tick(&debounce, 1, 6000, &event) == true);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, event.level);
+
+    // A tick without edges does nothing (even when the level differs: only edges start a window)
+    MJD_TEST_ASSERT(mjd_gpio_events_debounce_tick(&debounce, 0, 7000, &event) == false);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, debounce.stable_level);
+}
+
+static void test_edge_filter(void) {
+    mjd_gpio_events_event_t rising = { .gpio_num = GPIO_NUM_4, .level = 1 };
+    mjd_gpio_events_event_t falling = { .gpio_num = GPIO_NUM_4, .level = 0 };
+
+    MJD_TEST_ASSERT(mjd_gpio_events_is_edge_wanted(GPIO_INTR_POSEDGE, &rising) == true);
+    MJD_TEST_ASSERT(mjd_gpio_events_is_edge_wanted(GPIO_INTR_POSEDGE, &falling) == false);
+    MJD_TEST_ASSERT(mjd_gpio_events_is_edge_wanted(GPIO_INTR_NEGEDGE, &rising) == false);
+    MJD_TEST_ASSERT(mjd_gpio_events_is_edge_wanted(GPIO_INTR_NEGEDGE, &falling) == true);
+    MJD_TEST_ASSERT(mjd_gpio_events_is_edge_wanted(GPIO_INTR_ANYEDGE, &rising) == true);
+    MJD_TEST_ASSERT(mjd_gpio_events_is_edge_wanted(GPIO_INTR_ANYEDGE, &falling) == true);
+    MJD_TEST_ASSERT(mjd_gpio_events_is_edge_wanted(GPIO_INTR_HIGH_LEVEL, &rising) == false);
+}
+
+static void test_queue_capacity(void) {
+    mjd_gpio_events_queue_t queue;
+    mjd_gpio_events_event_t storage[4];
+
+    MJD_TEST_ASSERT_EQUAL_UINT(2, mjd_gpio_events_queue_get_capacity(0));
+    MJD_TEST_ASSERT_EQUAL_UINT(2, mjd_gpio_events_queue_get_capacity(2));
+    MJD_TEST_ASSERT_EQUAL_UINT(4, mjd_gpio_events_queue_get_capacity(3));
+    MJD_TEST_ASSERT_EQUAL_UINT(16, mjd_gpio_events_queue_get_capacity(16));
+    MJD_TEST_ASSERT_EQUAL_UINT(32, mjd_gpio_events_queue_get_capacity(17));
+    MJD_TEST_ASSERT_EQUAL_UINT(65536, mjd_gpio_events_queue_get_capacity(1000000));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_gpio_events_queue_init(&queue, storage, 3));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_gpio_events_queue_init(&queue, storage, 1));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_gpio_events_queue_init(&queue, NULL, 4));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_gpio_events_queue_init(&queue, storage, 4));
+}
+
+static void test_queue_full_and_fifo(void) {
+    mjd_gpio_events_queue_t queue;
+    mjd_gpio_events_event_t storage[4];
+    mjd_gpio_events_event_t event = { .gpio_num = GPIO_NUM_14 };
+    mjd_gpio_events_event_t popped;
+
+    mjd_gpio_events_queue_init(&queue, storage, 4);
+    MJD_TEST_ASSERT(mjd_gpio_events_queue_pop(&queue, &popped) == false);
+
+    for (uint32_t i = 1; i <= 4; i++) {
+        event.sequence = i;
+        MJD_TEST_ASSERT(mjd_gpio_events_queue_push(&queue, &event) == true);
+    }
+    MJD_TEST_ASSERT_EQUAL_UINT(4, mjd_gpio_events_queue_get_count(&queue));
+    event.sequence = 5;
+    MJD_TEST_ASSERT(mjd_gpio_events_queue_push(&queue, &event) == false); // full: dropped, the queued events are kept
+
+    for (uint32_t i = 1; i <= 4; i++) {
+        MJD_TEST_ASSERT(mjd_gpio_events_queue_pop(&queue, &popped) == true);
+        MJD_TEST_ASSERT_EQUAL_UINT(i, popped.sequence);
+    }
+    MJD_TEST_ASSERT(mjd_gpio_events_queue_pop(&queue, &popped) == false);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, mjd_gpio_events_queue_get_count(&queue));
+}
+
+static void test_queue_counter_wrap(void) {
+    mjd_gpio_events_queue_t queue;
+    mjd_gpio_events_event_t storage[8];
+    mjd_gpio_events_event_t event = { .gpio_num = GPIO_NUM_14 };
+    mjd_gpio_events_event_t popped;
+
+    // The free running counters wrap around UINT32_MAX in the middle of a batch
+    mjd_gpio_events_queue_init(&queue, storage, 8);
+    queue.head = UINT32_MAX - 2;
+    queue.tail = UINT32_MAX - 2;
+
+    for (uint32_t i = 1; i <= 8; i++) {
+        event.sequence = i;
+        MJD_TEST_ASSERT(mjd_gpio_events_queue_push(&queue, &event) == true);
+    }
+    MJD_TEST_ASSERT(mjd_gpio_events_queue_push(&queue, &event) == false);
+    MJD_TEST_ASSERT_EQUAL_UINT(8, mjd_gpio_events_queue_get_count(&queue));
+    for (uint32_t i = 1; i <= 8; i++) {
+        MJD_TEST_ASSERT(mjd_gpio_events_queue_pop(&queue, &popped) == true);
+        MJD_TEST_ASSERT_EQUAL_UINT(i, popped.sequence);
+    }
+    MJD_TEST_ASSERT_EQUAL_UINT(0, mjd_gpio_events_queue_get_count(&queue));
+}
+
+/*
+ * @brief The timer ISR dispatch of the driver: 2 pins, a PIR subscriber (rising edges of 1 pin) with a small queue
+ *        and a logger subscriber (both pins, any edge) that is slow.
+ */
+static void test_dispatch_to_subscribers(void) {
+    mjd_gpio_events_debounce_t pins[2];
+    mjd_gpio_events_queue_t queue_pir, queue_logger;
+    mjd_gpio_events_event_t storage_pir[2], storage_logger[8];
+    uint32_t queued_pir = 0, dropped_pir = 0, queued_logger = 0, dropped_logger = 0;
+    mjd_gpio_events_event_t event;
+    uint8_t levels[2] = { 0, 1 };
+
+    mjd_gpio_events_debounce_init(&pins[0], GPIO_NUM_14, 10000, levels[0]);
+    mjd_gpio_events_debounce_init(&pins[1], GPIO_NUM_27, 10000, levels[1]);
+    mjd_gpio_events_queue_init(&queue_pir, storage_pir, 2);
+    mjd_gpio_events_queue_init(&queue_logger, storage_logger, 8);
+
+    // 4 motions on GPIO#14 (each a rising + a falling edge with bounces), 1 falling edge on GPIO#27
+    int64_t now_us = 0;
+    for (uint32_t motion = 0; motion < 4; motion++) {
+        for (uint32_t half = 0; half < 2; half++) {
+            levels[0] = !levels[0];
+            mjd_gpio_events_debounce_edge(&pins[0], now_us);
+            mjd_gpio_events_debounce_edge(&pins[0], now_us + 300);
+            mjd_gpio_events_debounce_edge(&pins[0], now_us + 600);
+            if (motion == 2 && half == 0) {
+                levels[1] = 0;
+                mjd_gpio_events_debounce_edge(&pins[1], now_us);
+            }
+            for (int64_t end_us = now_us + 50000; now_us < end_us; now_us += SIM_TICK_US) {
+                for (uint32_t slot = 0; slot < 2; slot++) {
+                    if (mjd_gpio_events_debounce_tick(&pins[slot], levels[slot], now_us, &event) == false) {
+                        continue;
+                    }
+                    if (event.gpio_num == GPIO_NUM_14 && mjd_gpio_events_is_edge_wanted(GPIO_INTR_POSEDGE, &event) == true) {
+                        if (mjd_gpio_events_queue_push(&queue_pir, &event) == true) {
+                            queued_pir++;
+                        } else {
+                            dropped_pir++;
+                        }
+                    }
+                    if (mjd_gpio_events_queue_push(&queue_logger, &event) == true) {
+                        queued_logger++;
+                    } else {
+                        dropped_logger++;
+                    }
+                }
+            }
+        }
+    }
+
+    // PIR: 4 rising edges, room for 2 (the subscriber task did not run)
+    MJD_TEST_ASSERT_EQUAL_UINT(2, queued_pir);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, dropped_pir);
+    MJD_TEST_ASSERT(mjd_gpio_events_queue_pop(&queue_pir, &event) == true);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, event.level);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, event.sequence);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, event.nbr_of_coalesced_edges);
+    MJD_TEST_ASSERT(mjd_gpio_events_queue_pop(&queue_pir, &event) == true);
+    MJD_TEST_ASSERT_EQUAL_UINT(3, event.sequence); // the gap = the falling edge that this subscriber filtered out
+
+    // Logger: 8 + 1 events, room for 8
+    MJD_TEST_ASSERT_EQUAL_UINT(8, queued_logger);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, dropped_logger);
+    uint32_t nbr_gpio27 = 0;
+    int64_t previous_timestamp_us = -1;
+    while (mjd_gpio_events_queue_pop(&queue_logger, &event) == true) {
+        MJD_TEST_ASSERT(event.timestamp_us >= previous_timestamp_us);
+        previous_timestamp_us = event.timestamp_us;
+        if (event.gpio_num == GPIO_NUM_27) {
+            nbr_gpio27++;
+            MJD_TEST_ASSERT_EQUAL_UINT(0, event.level);
+        }
+    }
+    MJD_TEST_ASSERT_EQUAL_UINT(1, nbr_gpio27);
+
+    MJD_TEST_ASSERT_EQUAL_UINT(24, pins[0].stats.nbr_of_edges);
+    MJD_TEST_ASSERT_EQUAL_UINT(8, pins[0].stats.nbr_of_events);
+    MJD_TEST_ASSERT_EQUAL_UINT(16, pins[0].stats.nbr_of_coalesced_edges);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, pins[1].stats.nbr_of_events);
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_debounce_bouncing_contact);
+    MJD_TEST_RUN(test_debounce_glitch);
+    MJD_TEST_RUN(test_debounce_zero);
+    MJD_TEST_RUN(test_edge_filter);
+    MJD_TEST_RUN(test_queue_capacity);
+    MJD_TEST_RUN(test_queue_full_and_fifo);
+    MJD_TEST_RUN(test_queue_counter_wrap);
+    MJD_TEST_RUN(test_dispatch_to_subscribers);
+
+    return MJD_TEST_REPORT();
+}
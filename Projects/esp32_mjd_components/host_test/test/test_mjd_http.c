@@ -0,0 +1,434 @@
+/*
+ * HOST TEST: mjd_http response parser + streaming client (against the HTTP stand-in server of the shims on 127.0.0.1)
+ */
+#include "mjd.h"
+#include "mjd_http.h"
+
+#include "mjd_host.h"
+#include "mjd_test.h"
+
+/*
+ * @brief Feed the response in pieces of param_piece_len bytes. Collects the body into param_ptr_body.
+ *
+ * @return The bytes that were not consumed (after the end of the response), -1 = a parser error.
+ */
+static int _parse_in_pieces(mjd_http_parser_t* param_ptr_parser, const char * param_ptr_text, size_t param_piece_len,
+                            char * param_ptr_body, size_t * param_ptr_body_len) {
+    size_t total = strlen(param_ptr_text);
+    size_t pos = 0;
+
+    *param_ptr_body_len = 0;
+    while (pos < total && mjd_http_parser_is_done(param_ptr_parser) == false) {
+        size_t piece_end = (pos + param_piece_len < total) ? pos + param_piece_len : total;
+        while (pos < piece_end && mjd_http_parser_is_done(param_ptr_parser) == false) {
+            const uint8_t *ptr_body;
+            size_t body_len, consumed;
+            if (mjd_http_parser_execute(param_ptr_parser, (const uint8_t *) &param_ptr_text[pos], piece_end - pos, SIZE_MAX, &consumed,
+                    &ptr_body, &body_len) != ESP_OK) {
+                return -1;
+            }
+            if (body_len > 0) {
+                memcpy(&param_ptr_body[*param_ptr_body_len], ptr_body, body_len);
+            }
+            *param_ptr_body_len += body_len;
+            pos += consumed;
+        }
+    }
+    param_ptr_body[*param_ptr_body_len] = '\0';
+    return (int) (total - pos);
+}
+
+static void test_parser_content_length_byte_by_byte(void) {
+    const char *text = "HTTP/1.1 200 OK\r\ncontent-length: 11\r\nX-Long: abc\r\n\r\nhello worldHTTP/1.1 204";
+    mjd_http_parser_t parser;
+    char body[64];
+    size_t body_len;
+
+    for (size_t piece_len = 1; piece_len <= strlen(text); piece_len++) {
+        mjd_http_parser_init(&parser, false);
+        MJD_TEST_ASSERT_EQUAL_INT(strlen("HTTP/1.1 204"), _parse_in_pieces(&parser, text, piece_len, body, &body_len));
+        MJD_TEST_ASSERT(parser.is_head_complete == true);
+        MJD_TEST_ASSERT_EQUAL_INT(200, parser.response.status_code);
+        MJD_TEST_ASSERT_EQUAL_INT(11, parser.response.content_length);
+        MJD_TEST_ASSERT(parser.response.is_keep_alive == true);
+        MJD_TEST_ASSERT(parser.response.is_chunked == false);
+        MJD_TEST_ASSERT_EQUAL_STRING("hello world", body);
+    }
+}
+
+static void test_parser_chunked_every_split(void) {
+    const char *text = "HTTP/1.1 200 OK\r\nTransfer-Encoding: gzip, Chunked\r\n\r\n"
+            "5;name=value\r\nhello\r\n1\r\n \r\nA\r\n0123456789\r\n0\r\nX-Trailer: 1\r\n\r\n";
+    mjd_http_parser_t parser;
+    char body[64];
+    size_t body_len;
+
+    for (size_t piece_len = 1; piece_len <= strlen(text); piece_len++) {
+        mjd_http_parser_init(&parser, false);
+        MJD_TEST_ASSERT_EQUAL_INT(0, _parse_in_pieces(&parser, text, piece_len, body, &body_len));
+        MJD_TEST_ASSERT(mjd_http_parser_is_done(&parser) == true);
+        MJD_TEST_ASSERT(parser.response.is_chunked == true);
+        MJD_TEST_ASSERT_EQUAL_INT(-1, parser.response.content_length);
+        MJD_TEST_ASSERT_EQUAL_STRING("hello 0123456789", body);
+        MJD_TEST_ASSERT_EQUAL_UINT(16, parser.nbr_of_body_bytes);
+    }
+}
+
+static void test_parser_headers(void) {
+    mjd_http_parser_t parser;
+    char body[64];
+    size_t body_len;
+
+    // Content-Range + an interim 100 Continue
+    mjd_http_parser_init(&parser, false);
+    MJD_TEST_ASSERT_EQUAL_INT(0, _parse_in_pieces(&parser,
+            "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 206 Partial Content\r\nContent-Range: bytes 100-103/5000\r\nContent-Length: 4\r\n\r\nabcd",
+            7, body, &body_len));
+    MJD_TEST_ASSERT_EQUAL_INT(206, parser.response.status_code);
+    MJD_TEST_ASSERT_EQUAL_INT(100, parser.response.range_start);
+    MJD_TEST_ASSERT_EQUAL_INT(103, parser.response.range_end);
+    MJD_TEST_ASSERT_EQUAL_INT(5000, parser.response.total_length);
+    MJD_TEST_ASSERT_EQUAL_STRING("abcd", body);
+
+    // Connection: close on HTTP/1.1, keep-alive on HTTP/1.0
+    mjd_http_parser_init(&parser, false);
+    MJD_TEST_ASSERT_EQUAL_INT(0, _parse_in_pieces(&parser, "HTTP/1.1 200 OK\r\nConnection: Close\r\nContent-Length: 0\r\n\r\n", 100,
+            body, &body_len));
+    MJD_TEST_ASSERT(parser.response.is_keep_alive == false);
+    mjd_http_parser_init(&parser, false);
+    MJD_TEST_ASSERT_EQUAL_INT(0, _parse_in_pieces(&parser, "HTTP/1.0 200 OK\r\nContent-Length: 0\r\n\r\n", 100, body, &body_len));
+    MJD_TEST_ASSERT(parser.response.is_keep_alive == false);
+    mjd_http_parser_init(&parser, false);
+    MJD_TEST_ASSERT_EQUAL_INT(0, _parse_in_pieces(&parser, "HTTP/1.0 200 OK\r\nConnection: keep-alive\r\nContent-Length: 0\r\n\r\n", 100,
+            body, &body_len));
+    MJD_TEST_ASSERT(parser.response.is_keep_alive == true);
+
+    // No body: HEAD, 204, 304
+    mjd_http_parser_init(&parser, true);
+    MJD_TEST_ASSERT_EQUAL_INT(0, _parse_in_pieces(&parser, "HTTP/1.1 200 OK\r\nContent-Length: 1000\r\n\r\n", 100, body, &body_len));
+    MJD_TEST_ASSERT(mjd_http_parser_is_done(&parser) == true);
+    mjd_http_parser_init(&parser, false);
+    MJD_TEST_ASSERT_EQUAL_INT(0, _parse_in_pieces(&parser, "HTTP/1.1 304 Not Modified\r\n\r\n", 100, body, &body_len));
+    MJD_TEST_ASSERT(mjd_http_parser_is_done(&parser) == true);
+}
+
+static void test_parser_body_until_close(void) {
+    mjd_http_parser_t parser;
+    char body[64];
+    size_t body_len;
+
+    mjd_http_parser_init(&parser, false);
+    MJD_TEST_ASSERT_EQUAL_INT(0, _parse_in_pieces(&parser, "HTTP/1.1 200 OK\r\n\r\nuntil the end", 3, body, &body_len));
+    MJD_TEST_ASSERT(parser.response.is_keep_alive == false);
+    MJD_TEST_ASSERT(mjd_http_parser_is_done(&parser) == false);
+    MJD_TEST_ASSERT_EQUAL_STRING("until the end", body);
+    MJD_TEST_ASSERT(mjd_http_parser_finish_on_close(&parser) == ESP_OK);
+    MJD_TEST_ASSERT(mjd_http_parser_is_done(&parser) == true);
+
+    // A truncated Content-Length body is an error
+    mjd_http_parser_init(&parser, false);
+    MJD_TEST_ASSERT_EQUAL_INT(0, _parse_in_pieces(&parser, "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nabc", 100, body, &body_len));
+    MJD_TEST_ASSERT_EQUAL_UINT(7, mjd_http_parser_get_raw_body_len(&parser));
+    MJD_TEST_ASSERT(mjd_http_parser_finish_on_close(&parser) == ESP_ERR_INVALID_RESPONSE);
+}
+
+static void test_parser_malformed(void) {
+    mjd_http_parser_t parser;
+    char body[64];
+    size_t body_len;
+
+    mjd_http_parser_init(&parser, false);
+    MJD_TEST_ASSERT_EQUAL_INT(-1, _parse_in_pieces(&parser, "SSH-2.0-OpenSSH\r\n", 100, body, &body_len));
+    mjd_http_parser_init(&parser, false);
+    MJD_TEST_ASSERT_EQUAL_INT(-1, _parse_in_pieces(&parser, "HTTP/1.1 200 OK\r\nContent-Length: x\r\n\r\n", 100, body, &body_len));
+    mjd_http_parser_init(&parser, false);
+    MJD_TEST_ASSERT_EQUAL_INT(-1, _parse_in_pieces(&parser, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n", 100, body,
+            &body_len));
+    mjd_http_parser_init(&parser, false);
+    MJD_TEST_ASSERT_EQUAL_INT(-1, _parse_in_pieces(&parser, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabcX\r\n", 100,
+            body, &body_len));
+}
+
+/**************************************
+ * CLIENT (stand-in server)
+ */
+static bool _init_client(mjd_http_client_t* param_ptr_client, const mjd_host_http_server_config_t* param_ptr_server_config,
+                         bool param_is_keep_alive) {
+    mjd_http_config_t config = MJD_HTTP_CONFIG_DEFAULT();
+    uint16_t port = mjd_host_http_server_start(param_ptr_server_config);
+
+    config.host = "127.0.0.1";
+    config.port = port;
+    config.timeout_ms = 2000;
+    config.is_keep_alive = param_is_keep_alive;
+    return (port != 0 && mjd_http_init(param_ptr_client, &config) == ESP_OK);
+}
+
+static bool _is_file_content(const uint8_t * param_ptr_buf, uint64_t param_offset, size_t param_len) {
+    for (size_t idx = 0; idx < param_len; idx++) {
+        if (param_ptr_buf[idx] != mjd_host_http_server_file_byte(param_offset + idx)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+typedef struct {
+    uint64_t offset;
+    bool is_ok;
+} _download_check_t;
+
+static bool _download_cb(const uint8_t * param_ptr_data, size_t param_len, void * param_ptr_arg) {
+    _download_check_t *ptr_check = param_ptr_arg;
+
+    if (_is_file_content(param_ptr_data, ptr_check->offset, param_len) == false) {
+        ptr_check->is_ok = false;
+    }
+    ptr_check->offset += param_len;
+    return true;
+}
+
+static void test_client_keep_alive_reuse(void) {
+    static mjd_http_client_t client;
+    mjd_host_http_server_config_t server_config = { .file_size = 10000, .is_range_supported = true };
+    mjd_http_request_stats_t request_stats;
+    mjd_http_stats_t stats;
+    uint8_t buf[3000];
+    _download_check_t check;
+
+    MJD_TEST_ASSERT(_init_client(&client, &server_config, true) == true);
+
+    for (uint32_t idx = 0; idx < 3; idx++) {
+        check.offset = 0;
+        check.is_ok = true;
+        MJD_TEST_ASSERT(mjd_http_download(&client, "/file.bin", buf, sizeof(buf), _download_cb, &check) == ESP_OK);
+        MJD_TEST_ASSERT(check.is_ok == true);
+        MJD_TEST_ASSERT_EQUAL_UINT(10000, check.offset);
+        MJD_TEST_ASSERT(mjd_http_get_last_request_stats(&client, &request_stats) == ESP_OK);
+        MJD_TEST_ASSERT_EQUAL_INT(200, request_stats.status_code);
+        MJD_TEST_ASSERT(request_stats.is_reused == (idx > 0));
+        MJD_TEST_ASSERT(request_stats.total_us >= request_stats.ttfb_us);
+    }
+
+    MJD_TEST_ASSERT(mjd_http_get_stats(&client, &stats) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(3, stats.nbr_of_requests);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, stats.nbr_of_connects);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, stats.nbr_of_reuses);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, stats.nbr_of_errors);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, mjd_host_http_server_get_nbr_of_connections());
+
+    MJD_TEST_ASSERT(mjd_http_deinit(&client) == ESP_OK);
+    mjd_host_http_server_stop();
+}
+
+static void test_client_max_requests_per_connection(void) {
+    static mjd_http_client_t client;
+    mjd_host_http_server_config_t server_config = { .file_size = 2000, .max_requests_per_connection = 2 };
+    mjd_http_stats_t stats;
+    uint8_t buf[512];
+    _download_check_t check = { 0, true };
+
+    MJD_TEST_ASSERT(_init_client(&client, &server_config, true) == true);
+
+    for (uint32_t idx = 0; idx < 5; idx++) {
+        check.offset = 0;
+        MJD_TEST_ASSERT(mjd_http_download(&client, "/", buf, sizeof(buf), _download_cb, &check) == ESP_OK);
+        MJD_TEST_ASSERT_EQUAL_UINT(2000, check.offset);
+    }
+    MJD_TEST_ASSERT(check.is_ok == true);
+
+    // 1+2, 3+4, 5: the client follows "Connection: close" (no failed request on a dead connection)
+    MJD_TEST_ASSERT(mjd_http_get_stats(&client, &stats) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(3, stats.nbr_of_connects);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, stats.nbr_of_stale_retries);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, stats.nbr_of_errors);
+    MJD_TEST_ASSERT_EQUAL_UINT(3, mjd_host_http_server_get_nbr_of_connections());
+
+    // No keep-alive: 1 connection per request
+    mjd_http_deinit(&client);
+    MJD_TEST_ASSERT(_init_client(&client, &server_config, false) == true);
+    for (uint32_t idx = 0; idx < 3; idx++) {
+        check.offset = 0;
+        MJD_TEST_ASSERT(mjd_http_download(&client, "/", buf, sizeof(buf), _download_cb, &check) == ESP_OK);
+    }
+    MJD_TEST_ASSERT(mjd_http_get_stats(&client, &stats) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(3, stats.nbr_of_connects);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, stats.nbr_of_reuses);
+
+    mjd_http_deinit(&client);
+    mjd_host_http_server_stop();
+}
+
+static void test_client_chunked_download(void) {
+    static mjd_http_client_t client;
+    static uint8_t buf[100000];
+    mjd_host_http_server_config_t server_config = { .file_size = 100000, .chunk_size = 777 };
+    mjd_http_response_t response;
+    size_t total = 0;
+    size_t len;
+
+    MJD_TEST_ASSERT(_init_client(&client, &server_config, true) == true);
+
+    MJD_TEST_ASSERT(mjd_http_get(&client, "/chunked", -1, -1, &response) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_INT(200, response.status_code);
+    MJD_TEST_ASSERT(response.is_chunked == true);
+    do {
+        // Odd read sizes: the chunk boundaries fall everywhere
+        MJD_TEST_ASSERT(mjd_http_read(&client, &buf[total], (sizeof(buf) - total < 1000) ? sizeof(buf) - total : 1000 - (total % 7),
+                &len) == ESP_OK);
+        total += len;
+    } while (len > 0 && total < sizeof(buf));
+    MJD_TEST_ASSERT_EQUAL_UINT(100000, total);
+    MJD_TEST_ASSERT(mjd_http_read(&client, buf, 10, &len) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, len);
+    MJD_TEST_ASSERT(_is_file_content(buf, 0, total) == true);
+
+    // The connection is reusable after the last chunk
+    MJD_TEST_ASSERT(mjd_http_get(&client, "/chunked", -1, -1, &response) == ESP_OK);
+    MJD_TEST_ASSERT(client.last_request_stats.is_reused == true);
+
+    mjd_http_deinit(&client);
+    mjd_host_http_server_stop();
+}
+
+static void test_client_range_download(void) {
+    static mjd_http_client_t client;
+    mjd_host_http_server_config_t server_config = { .file_size = 5000, .is_range_supported = true };
+    uint8_t buf[1024];
+    size_t received;
+    uint64_t offset = 0;
+
+    MJD_TEST_ASSERT(_init_client(&client, &server_config, true) == true);
+
+    // 5000 bytes in ranges of 1024: the last range is short, then past the end (416)
+    do {
+        MJD_TEST_ASSERT(mjd_http_download_range(&client, "/file.bin", offset, buf, sizeof(buf), &received) == ESP_OK);
+        MJD_TEST_ASSERT(_is_file_content(buf, offset, received) == true);
+        offset += received;
+    } while (received == sizeof(buf));
+    MJD_TEST_ASSERT_EQUAL_UINT(5000, offset);
+    MJD_TEST_ASSERT(mjd_http_download_range(&client, "/file.bin", 5000, buf, sizeof(buf), &received) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, received);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, mjd_host_http_server_get_nbr_of_connections());
+
+    // A server without Range support
+    server_config.is_range_supported = false;
+    mjd_http_deinit(&client);
+    MJD_TEST_ASSERT(_init_client(&client, &server_config, true) == true);
+    MJD_TEST_ASSERT(mjd_http_download_range(&client, "/file.bin", 0, buf, sizeof(buf), &received) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(sizeof(buf), received);
+    MJD_TEST_ASSERT(mjd_http_download_range(&client, "/file.bin", 1024, buf, sizeof(buf), &received) == ESP_ERR_NOT_SUPPORTED);
+
+    mjd_http_deinit(&client);
+    mjd_host_http_server_stop();
+}
+
+static void test_client_pipelined_post(void) {
+    static mjd_http_client_t client;
+    mjd_host_http_server_config_t server_config = { .file_size = 100 };
+    char payloads[8][32];
+    mjd_http_body_t bodies[8];
+    int status_codes[8];
+    uint64_t nbr_of_bytes = 0;
+    mjd_http_stats_t stats;
+
+    for (uint32_t idx = 0; idx < 8; idx++) {
+        snprintf(payloads[idx], sizeof(payloads[idx]), "{\"seq\":%u,\"t\":21.%u}", idx, idx);
+        bodies[idx].ptr_data = payloads[idx];
+        bodies[idx].len = strlen(payloads[idx]);
+        nbr_of_bytes += bodies[idx].len;
+    }
+
+    MJD_TEST_ASSERT(_init_client(&client, &server_config, true) == true);
+    MJD_TEST_ASSERT(mjd_http_post_pipelined(&client, "/samples", "application/json", bodies, 8, status_codes) == ESP_OK);
+    for (uint32_t idx = 0; idx < 8; idx++) {
+        MJD_TEST_ASSERT_EQUAL_INT(201, status_codes[idx]);
+    }
+    MJD_TEST_ASSERT_EQUAL_UINT(8, mjd_host_http_server_get_nbr_of_posts());
+    MJD_TEST_ASSERT_EQUAL_UINT(nbr_of_bytes, mjd_host_http_server_get_bytes_posted());
+    MJD_TEST_ASSERT_EQUAL_UINT(1, mjd_host_http_server_get_nbr_of_connections());
+
+    // A GET on the same connection after the pipelined batch
+    uint8_t buf[128];
+    size_t received;
+    MJD_TEST_ASSERT(mjd_http_download_range(&client, "/", 0, buf, sizeof(buf), &received) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(100, received);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, mjd_host_http_server_get_nbr_of_connections());
+
+    // The server closes after 3 requests: the requests that were pipelined after the 3rd are sent again
+    server_config.max_requests_per_connection = 3;
+    mjd_http_deinit(&client);
+    MJD_TEST_ASSERT(_init_client(&client, &server_config, true) == true);
+    MJD_TEST_ASSERT(mjd_http_post_pipelined(&client, "/samples", "application/json", bodies, 8, status_codes) == ESP_OK);
+    for (uint32_t idx = 0; idx < 8; idx++) {
+        MJD_TEST_ASSERT_EQUAL_INT(201, status_codes[idx]);
+    }
+    MJD_TEST_ASSERT_EQUAL_UINT(8, mjd_host_http_server_get_nbr_of_posts());
+    MJD_TEST_ASSERT_EQUAL_UINT(nbr_of_bytes, mjd_host_http_server_get_bytes_posted());
+    MJD_TEST_ASSERT_EQUAL_UINT(3, mjd_host_http_server_get_nbr_of_connections());
+    MJD_TEST_ASSERT(mjd_http_get_stats(&client, &stats) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, stats.nbr_of_errors);
+
+    mjd_http_deinit(&client);
+    mjd_host_http_server_stop();
+}
+
+static void test_client_errors(void) {
+    static mjd_http_client_t client;
+    mjd_http_config_t config = MJD_HTTP_CONFIG_DEFAULT();
+    mjd_http_response_t response;
+    mjd_host_http_server_config_t server_config = { .file_size = 100 };
+    uint16_t port;
+
+    MJD_TEST_ASSERT(mjd_http_init(&client, &config) == ESP_ERR_INVALID_ARG); // no host
+    config.host = "127.0.0.1";
+    config.pipeline_depth = MJD_HTTP_MAX_PIPELINE_DEPTH + 1;
+    MJD_TEST_ASSERT(mjd_http_init(&client, &config) == ESP_ERR_INVALID_ARG);
+
+    // Nothing listens on the port anymore
+    port = mjd_host_http_server_start(&server_config);
+    mjd_host_http_server_stop();
+    config = (mjd_http_config_t) MJD_HTTP_CONFIG_DEFAULT();
+    config.host = "127.0.0.1";
+    config.port = port;
+    MJD_TEST_ASSERT(mjd_http_init(&client, &config) == ESP_OK);
+    MJD_TEST_ASSERT(mjd_http_get(&client, "/", -1, -1, &response) != ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, client.stats.nbr_of_errors);
+}
+
+static void test_client_benchmark(void) {
+    static mjd_http_client_t client;
+    static uint8_t buf[4096];
+    mjd_host_http_server_config_t server_config = { .file_size = 64 * 1024 };
+    mjd_http_benchmark_result_t result;
+
+    MJD_TEST_ASSERT(_init_client(&client, &server_config, true) == true);
+    MJD_TEST_ASSERT(mjd_http_benchmark(&client, "/bench", 4, buf, sizeof(buf), &result) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(4, result.nbr_of_requests);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, result.nbr_of_errors);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, result.nbr_of_connects);
+    MJD_TEST_ASSERT_EQUAL_UINT(4 * 64 * 1024, result.bytes_received);
+    MJD_TEST_ASSERT(result.kbytes_per_sec > 0);
+    MJD_TEST_ASSERT(result.ttfb_min_us <= result.ttfb_avg_us && result.ttfb_avg_us <= result.ttfb_max_us);
+    mjd_http_log_benchmark("test", &result);
+
+    mjd_http_deinit(&client);
+    mjd_host_http_server_stop();
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_parser_content_length_byte_by_byte);
+    MJD_TEST_RUN(test_parser_chunked_every_split);
+    MJD_TEST_RUN(test_parser_headers);
+    MJD_TEST_RUN(test_parser_body_until_close);
+    MJD_TEST_RUN(test_parser_malformed);
+    MJD_TEST_RUN(test_client_keep_alive_reuse);
+    MJD_TEST_RUN(test_client_max_requests_per_connection);
+    MJD_TEST_RUN(test_client_chunked_download);
+    MJD_TEST_RUN(test_client_range_download);
+    MJD_TEST_RUN(test_client_pipelined_post);
+    MJD_TEST_RUN(test_client_errors);
+    MJD_TEST_RUN(test_client_benchmark);
+    mjd_host_http_server_stop();
+    return MJD_TEST_REPORT();
+}
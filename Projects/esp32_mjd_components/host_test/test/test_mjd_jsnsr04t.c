@@ -0,0 +1,213 @@
+/*
+ * HOST TEST: mjd_jsnsr04t median + Hampel filter, temperature compensation, single shot and continuous ranging
+ *
+ * @doc The echo pulses are recorded RMT RX frames (one item: level 1 for the echo duration) injected in the RX ring buffer.
+ *      The ranging task and the ping timer never run on the host: the tests call mjd_jsnsr04t_ranging_receive_echo() (= one echo).
+ */
+#include "mjd.h"
+#include "mjd_jsnsr04t.h"
+
+#include "mjd_host.h"
+#include "mjd_test.h"
+
+#define TEST_RMT_CHANNEL (RMT_CHANNEL_4)
+
+/*
+ * A recorded stilling well session: the water level at +-120cm, a reflection of the pipe wall at 40cm,
+ * a double echo at 240cm, and a ping without an echo (the 38 millisec "no obstacle" pulse, cut at the 25 millisec RMT idle threshold).
+ */
+static const uint32_t RECORDED_ECHO_US[] =
+    { 7018, 7030, 7006, 2339, 7018, 25000, 7041, 14035, 7012, 7024 };
+
+static esp_err_t _init_sensor(mjd_jsnsr04t_config_t* param_ptr_config) {
+    mjd_jsnsr04t_config_t config = MJD_JSNSR04T_CONFIG_DEFAULT();
+    config.trigger_gpio_num = GPIO_NUM_17;
+    config.echo_gpio_num = GPIO_NUM_16;
+    config.rmt_channel = TEST_RMT_CHANNEL;
+    *param_ptr_config = config;
+    return mjd_jsnsr04t_init(param_ptr_config);
+}
+
+static void _inject_echo(uint32_t param_echo_us) {
+    rmt_item32_t item = { .level0 = 1, .duration0 = param_echo_us, .level1 = 0, .duration1 = 0 };
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_host_rmt_inject_rx_items(TEST_RMT_CHANNEL, &item, 1));
+}
+
+static void test_filter_rejects_outliers(void) {
+    mjd_jsnsr04t_filter_t filter;
+    const float samples_cm[] =
+        { 100.0, 101.0, 100.0, 180.0, 99.0, 100.0, 30.0, 101.0 };
+    const esp_err_t expected[] =
+        { ESP_OK, ESP_OK, ESP_OK, ESP_ERR_INVALID_RESPONSE, ESP_OK, ESP_OK, ESP_ERR_INVALID_RESPONSE, ESP_OK };
+    float median_cm = 0.0f;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_jsnsr04t_filter_init(&filter, 5, 3.0f, 2.0f));
+    for (size_t idx = 0; idx < ARRAY_SIZE(samples_cm); idx++) {
+        MJD_TEST_ASSERT_EQUAL_INT(expected[idx], mjd_jsnsr04t_filter_add(&filter, samples_cm[idx], &median_cm));
+    }
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 100.0, median_cm);
+    MJD_TEST_ASSERT_EQUAL_UINT(6, filter.nbr_of_accepted);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, filter.nbr_of_outliers);
+    MJD_TEST_ASSERT_EQUAL_UINT(5, filter.nbr_of_samples);
+}
+
+static void test_filter_follows_step_change(void) {
+    mjd_jsnsr04t_filter_t filter;
+    float median_cm = 0.0f;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_jsnsr04t_filter_init(&filter, 5, 3.0f, 2.0f));
+    for (uint32_t idx = 0; idx < 5; idx++) {
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_jsnsr04t_filter_add(&filter, 100.0f, &median_cm));
+    }
+
+    // The level jumps to 150cm: the first window_size/2 samples are outliers, then the filter follows
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_RESPONSE, mjd_jsnsr04t_filter_add(&filter, 150.0f, &median_cm));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_RESPONSE, mjd_jsnsr04t_filter_add(&filter, 150.0f, &median_cm));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 100.0, median_cm);
+    for (uint32_t idx = 0; idx < 3; idx++) {
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_jsnsr04t_filter_add(&filter, 150.0f, &median_cm));
+    }
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 150.0, median_cm);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_jsnsr04t_filter_add(&filter, 151.0f, &median_cm));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, filter.nbr_of_consecutive_outliers);
+}
+
+static void test_filter_invalid_args(void) {
+    mjd_jsnsr04t_filter_t filter;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_jsnsr04t_filter_init(&filter, 0, 3.0f, 2.0f));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG,
+            mjd_jsnsr04t_filter_init(&filter, MJD_JSNSR04T_FILTER_MAX_WINDOW_SIZE + 1, 3.0f, 2.0f));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_jsnsr04t_filter_init(&filter, 5, 0.0f, 2.0f));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_jsnsr04t_filter_init(NULL, 5, 3.0f, 2.0f));
+}
+
+static void test_temperature_compensation(void) {
+    mjd_jsnsr04t_config_t config;
+    mjd_jsnsr04t_data_t data;
+
+    mjd_host_reset();
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, _init_sensor(&config));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_jsnsr04t_set_temperature(&config, -41.0f));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_jsnsr04t_set_temperature(&config, 86.0f));
+
+    // 0 degrees Celsius: 331.3 m/s
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_jsnsr04t_set_temperature(&config, 0.0f));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.000001, 0.03313, config.speed_of_sound_cm_per_us);
+    for (uint32_t idx = 0; idx < config.nbr_of_samples; idx++) {
+        _inject_echo(7018);
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_jsnsr04t_get_measurement(&config, &data));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.01, 116.25, data.distance_cm);
+
+    // 30 degrees Celsius: 349.48 m/s
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_jsnsr04t_set_temperature(&config, 30.0f));
+    for (uint32_t idx = 0; idx < config.nbr_of_samples; idx++) {
+        _inject_echo(7018);
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_jsnsr04t_get_measurement(&config, &data));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.01, 122.63, data.distance_cm);
+}
+
+static void test_get_measurement_rejects_outlier(void) {
+    mjd_jsnsr04t_config_t config;
+    mjd_jsnsr04t_data_t data;
+
+    mjd_host_reset();
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, _init_sensor(&config));
+    config.distance_sensor_to_artifact_cm = 20.0;
+
+    // One reflection and one ping without echo do not abort the measurement
+    const uint32_t echo_us[] =
+        { 7018, 7030, 25000, 7006, 2339 };
+    for (size_t idx = 0; idx < ARRAY_SIZE(echo_us); idx++) {
+        _inject_echo(echo_us[idx]);
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_jsnsr04t_get_measurement(&config, &data));
+    MJD_TEST_ASSERT(data.data_received == true);
+    MJD_TEST_ASSERT(data.is_an_error == false);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.01, 120.01 - 20.0, data.distance_cm);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, config.nbr_of_errors); // The ping without echo
+
+    // The pings are MJD_JSNSR04T_MIN_PING_PERIOD_MS apart (the first ping waits the full period)
+    MJD_TEST_ASSERT(mjd_host_get_time_us() >= ARRAY_SIZE(echo_us) * MJD_JSNSR04T_MIN_PING_PERIOD_MS * 1000);
+    MJD_TEST_ASSERT(mjd_host_get_time_us() < (ARRAY_SIZE(echo_us) + 1) * MJD_JSNSR04T_MIN_PING_PERIOD_MS * 1000);
+}
+
+static void test_get_measurement_not_enough_samples(void) {
+    mjd_jsnsr04t_config_t config;
+    mjd_jsnsr04t_data_t data;
+
+    mjd_host_reset();
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, _init_sensor(&config));
+
+    // 3 of 5 pings without a valid echo (the last one times out: nothing in the ring buffer)
+    const uint32_t echo_us[] =
+        { 7018, 25000, 7030, 100 };
+    for (size_t idx = 0; idx < ARRAY_SIZE(echo_us); idx++) {
+        _inject_echo(echo_us[idx]);
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_RESPONSE, mjd_jsnsr04t_get_measurement(&config, &data));
+    MJD_TEST_ASSERT(data.data_received == false);
+    MJD_TEST_ASSERT(data.is_an_error == true);
+}
+
+static void test_ranging_recorded_trace(void) {
+    mjd_jsnsr04t_config_t config;
+    mjd_jsnsr04t_data_t data;
+    mjd_jsnsr04t_ranging_stats_t stats;
+
+    mjd_host_reset();
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, _init_sensor(&config));
+
+    config.ranging_ping_period_ms = MJD_JSNSR04T_MIN_PING_PERIOD_MS - 1;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_jsnsr04t_start_ranging(&config));
+    config.ranging_ping_period_ms = MJD_JSNSR04T_MIN_PING_PERIOD_MS;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_jsnsr04t_start_ranging(&config));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, mjd_jsnsr04t_start_ranging(&config));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, mjd_jsnsr04t_get_measurement(&config, &data));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_jsnsr04t_get_ranging_data(&config, &data));
+    MJD_TEST_ASSERT(data.data_received == false);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_TIMEOUT, mjd_jsnsr04t_ranging_receive_echo(&config, 0));
+
+    for (size_t idx = 0; idx < ARRAY_SIZE(RECORDED_ECHO_US); idx++) {
+        _inject_echo(RECORDED_ECHO_US[idx]);
+        mjd_jsnsr04t_ranging_receive_echo(&config, 0);
+    }
+
+    // A noise spike splits the echo in 2 RMT items
+    const rmt_item32_t noise_items[] = {
+            { .level0 = 1, .duration0 = 3000, .level1 = 0, .duration1 = 300 },
+            { .level0 = 1, .duration0 = 3700, .level1 = 0, .duration1 = 0 } };
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_host_rmt_inject_rx_items(TEST_RMT_CHANNEL, noise_items, ARRAY_SIZE(noise_items)));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_RESPONSE, mjd_jsnsr04t_ranging_receive_echo(&config, 0));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_jsnsr04t_get_ranging_data(&config, &data));
+    MJD_TEST_ASSERT(data.data_received == true);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.01, 120.01, data.distance_cm); // The median of the last 5 accepted echoes (7018 microsec)
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_jsnsr04t_get_ranging_stats(&config, &stats));
+    MJD_TEST_ASSERT_EQUAL_UINT(ARRAY_SIZE(RECORDED_ECHO_US) + 1, stats.nbr_of_echoes);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, stats.nbr_of_invalid_echoes);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, stats.nbr_of_outliers);
+
+    // Stop: the ranging task acknowledges the request while mjd_jsnsr04t_stop_ranging() waits for it
+    mjd_host_run_task_at_next_delay(config.ranging_task_handle);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_jsnsr04t_stop_ranging(&config));
+    MJD_TEST_ASSERT(config.is_ranging_stop_requested == true);
+    MJD_TEST_ASSERT(config.is_ranging == false);
+    MJD_TEST_ASSERT(config.ranging_timer_handle == NULL);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, mjd_jsnsr04t_stop_ranging(&config));
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_filter_rejects_outliers);
+    MJD_TEST_RUN(test_filter_follows_step_change);
+    MJD_TEST_RUN(test_filter_invalid_args);
+    MJD_TEST_RUN(test_temperature_compensation);
+    MJD_TEST_RUN(test_get_measurement_rejects_outlier);
+    MJD_TEST_RUN(test_get_measurement_not_enough_samples);
+    MJD_TEST_RUN(test_ranging_recorded_trace);
+    return MJD_TEST_REPORT();
+}
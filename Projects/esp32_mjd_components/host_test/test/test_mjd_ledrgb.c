@@ -0,0 +1,215 @@
+/*
+ * HOST TEST: mjd_ledrgb frame rendering and the streaming RMT translator
+ *
+ * @doc The RMT shim calls the translator in chunks of 64 items and records the items per channel.
+ */
+#include "mjd.h"
+#include "mjd_ledrgb.h"
+
+#include "mjd_host.h"
+#include "mjd_test.h"
+
+// WS2812B_V2017 timings in RMT ticks of 50ns
+#define TEST_T1HIGH_TICKS (1090 / 50)
+#define TEST_T0HIGH_TICKS (300 / 50)
+#define TEST_TRESET_TICKS (290000 / 50)
+
+static esp_err_t _init_strip(mjd_ledrgb_strip_identifier_t param_strip_id, uint32_t param_nbr_of_leds, uint8_t param_brightness,
+                             bool param_is_gamma_corrected) {
+    mjd_ledrgb_config_t config = MJD_LEDRGB_CONFIG_DEFAULT();
+    config.strip_id = param_strip_id;
+    config.gpio_num = GPIO_NUM_18;
+    config.led_type = MJD_LED_TYPE_WS2812B_V2017;
+    config.nbr_of_leds = param_nbr_of_leds;
+    config.relative_brightness = param_brightness;
+    config.is_gamma_corrected = param_is_gamma_corrected;
+    return mjd_ledrgb_init(&config);
+}
+
+/*
+ * Decode the transmitted byte #idx (8 items, MSB first) from the recorded RMT items.
+ */
+static uint8_t _get_tx_byte(rmt_channel_t param_channel, uint32_t param_idx_byte) {
+    const rmt_item32_t *ptr_items = mjd_host_rmt_get_tx_items(param_channel) + (param_idx_byte * 8);
+    uint8_t value = 0;
+    for (uint32_t bit = 0; bit < 8; bit++) {
+        value = (value << 1) | ((ptr_items[bit].duration0 == TEST_T1HIGH_TICKS) ? 1 : 0);
+    }
+    return value;
+}
+
+static void test_init_invalid(void) {
+    mjd_host_reset();
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_FAIL, mjd_ledrgb_init(NULL));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_FAIL, _init_strip(MJD_STRIP_1, 0, 25, false));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_FAIL, _init_strip(MJD_STRIP_1, 8, 101, false));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_FAIL, mjd_ledrgb_submit_pixels_to_strip(MJD_STRIP_1)); // Not initialized
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_FAIL, mjd_ledrgb_deinit(MJD_STRIP_1));
+}
+
+static void test_items_grb_msb_first(void) {
+    mjd_host_reset();
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, _init_strip(MJD_STRIP_3, 3, 100, false));
+
+    mjd_ledrgb_set_strip_led(MJD_STRIP_3, MJD_LED_1, mjd_led_rgb(0x80, 0x01, 0xA5), false);
+    mjd_ledrgb_set_strip_led(MJD_STRIP_3, MJD_LED_3, mjd_led_rgb(0x12, 0x34, 0x56), false);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_send_pixels_to_strip(MJD_STRIP_3));
+
+    MJD_TEST_ASSERT_EQUAL_UINT(3 * 24 + 1, mjd_host_rmt_get_nbr_of_tx_items(RMT_CHANNEL_2));
+
+    const rmt_item32_t *ptr_items = mjd_host_rmt_get_tx_items(RMT_CHANNEL_2);
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_T0HIGH_TICKS, ptr_items[0].duration0); // G=0x01: MSB 0 first
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_T1HIGH_TICKS, ptr_items[7].duration0);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, ptr_items[7].level0);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, ptr_items[7].level1);
+
+    MJD_TEST_ASSERT_EQUAL_UINT(0x01, _get_tx_byte(RMT_CHANNEL_2, 0));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x80, _get_tx_byte(RMT_CHANNEL_2, 1));
+    MJD_TEST_ASSERT_EQUAL_UINT(0xA5, _get_tx_byte(RMT_CHANNEL_2, 2));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x00, _get_tx_byte(RMT_CHANNEL_2, 3));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x34, _get_tx_byte(RMT_CHANNEL_2, 6));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x12, _get_tx_byte(RMT_CHANNEL_2, 7));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x56, _get_tx_byte(RMT_CHANNEL_2, 8));
+
+    // The Treset latch pulse follows the last bit
+    MJD_TEST_ASSERT_EQUAL_UINT(0, ptr_items[3 * 24].level1);
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_TRESET_TICKS, ptr_items[3 * 24].duration1);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_deinit(MJD_STRIP_3));
+}
+
+static void test_long_strip_chunked(void) {
+    const uint32_t nbr_of_leds = 300;
+
+    mjd_host_reset();
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, _init_strip(MJD_STRIP_1, nbr_of_leds, 100, false));
+
+    for (uint32_t idx = 0; idx < nbr_of_leds; idx++) {
+        mjd_ledrgb_set_strip_led(MJD_STRIP_1, idx, mjd_led_rgb(idx & 0xFF, 0xFF - (idx & 0xFF), 0x3C), false);
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_send_pixels_to_strip(MJD_STRIP_1));
+
+    // 64-item chunks: the last byte is kept back until it fits together with the Treset item
+    MJD_TEST_ASSERT_EQUAL_UINT(nbr_of_leds * 24 + 1, mjd_host_rmt_get_nbr_of_tx_items(RMT_CHANNEL_0));
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_TRESET_TICKS, mjd_host_rmt_get_tx_items(RMT_CHANNEL_0)[nbr_of_leds * 24].duration1);
+
+    uint32_t nbr_of_mismatches = 0;
+    for (uint32_t idx = 0; idx < nbr_of_leds; idx++) {
+        nbr_of_mismatches += (_get_tx_byte(RMT_CHANNEL_0, idx * 3 + 0) != 0xFF - (idx & 0xFF));
+        nbr_of_mismatches += (_get_tx_byte(RMT_CHANNEL_0, idx * 3 + 1) != (idx & 0xFF));
+        nbr_of_mismatches += (_get_tx_byte(RMT_CHANNEL_0, idx * 3 + 2) != 0x3C);
+    }
+    MJD_TEST_ASSERT_EQUAL_UINT(0, nbr_of_mismatches);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_deinit(MJD_STRIP_1));
+}
+
+static void test_brightness_lut(void) {
+    mjd_host_reset();
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, _init_strip(MJD_STRIP_1, 1, 50, false));
+
+    mjd_ledrgb_set_strip_led(MJD_STRIP_1, MJD_LED_1, mjd_led_rgb(255, 100, 1), true);
+    MJD_TEST_ASSERT_EQUAL_UINT(50, _get_tx_byte(RMT_CHANNEL_0, 0)); // G 100 * 50%
+    MJD_TEST_ASSERT_EQUAL_UINT(128, _get_tx_byte(RMT_CHANNEL_0, 1)); // R 255 * 50% rounded
+    MJD_TEST_ASSERT_EQUAL_UINT(1, _get_tx_byte(RMT_CHANNEL_0, 2)); // B 1 * 50% rounded
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_set_strip_brightness(MJD_STRIP_1, 0));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_send_pixels_to_strip(MJD_STRIP_1));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _get_tx_byte(RMT_CHANNEL_0, 1));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_set_strip_brightness(MJD_STRIP_1, 100));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_send_pixels_to_strip(MJD_STRIP_1));
+    MJD_TEST_ASSERT_EQUAL_UINT(100, _get_tx_byte(RMT_CHANNEL_0, 0));
+    MJD_TEST_ASSERT_EQUAL_UINT(255, _get_tx_byte(RMT_CHANNEL_0, 1));
+    MJD_TEST_ASSERT_EQUAL_UINT(1, _get_tx_byte(RMT_CHANNEL_0, 2));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_ledrgb_set_strip_brightness(MJD_STRIP_1, 101));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_deinit(MJD_STRIP_1));
+}
+
+static void test_gamma_lut(void) {
+    mjd_host_reset();
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, _init_strip(MJD_STRIP_1, 1, 100, true));
+
+    mjd_ledrgb_set_strip_led(MJD_STRIP_1, MJD_LED_1, mjd_led_rgb(255, 128, 27), true);
+    MJD_TEST_ASSERT_EQUAL_UINT(37, _get_tx_byte(RMT_CHANNEL_0, 0)); // round((128/255)^2.8 * 255)
+    MJD_TEST_ASSERT_EQUAL_UINT(255, _get_tx_byte(RMT_CHANNEL_0, 1));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _get_tx_byte(RMT_CHANNEL_0, 2));
+
+    // Gamma first, then the brightness
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_set_strip_brightness(MJD_STRIP_1, 50));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_send_pixels_to_strip(MJD_STRIP_1));
+    MJD_TEST_ASSERT_EQUAL_UINT(19, _get_tx_byte(RMT_CHANNEL_0, 0));
+    MJD_TEST_ASSERT_EQUAL_UINT(128, _get_tx_byte(RMT_CHANNEL_0, 1));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_deinit(MJD_STRIP_1));
+}
+
+static void test_submit_double_buffer(void) {
+    mjd_host_reset();
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, _init_strip(MJD_STRIP_2, 2, 100, false));
+
+    // Frame N+1 is rendered in the other frame buffer; each frame is transmitted from its own snapshot
+    for (uint32_t frame = 0; frame < 5; frame++) {
+        mjd_ledrgb_set_strip_led(MJD_STRIP_2, MJD_LED_2, mjd_led_rgb(frame, 0, 0), false);
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_submit_pixels_to_strip(MJD_STRIP_2));
+        mjd_ledrgb_set_strip_led(MJD_STRIP_2, MJD_LED_2, mjd_led_rgb(0xEE, 0, 0), false); // After the submit: not in this frame
+        MJD_TEST_ASSERT_EQUAL_UINT(frame, _get_tx_byte(RMT_CHANNEL_1, 4));
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_wait_strip_tx_done(MJD_STRIP_2, portMAX_DELAY));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_deinit(MJD_STRIP_2));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_FAIL, mjd_ledrgb_wait_strip_tx_done(MJD_STRIP_2, 0));
+
+    // Re-init after deinit
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, _init_strip(MJD_STRIP_2, 4, 100, false));
+    MJD_TEST_ASSERT_EQUAL_UINT(4 * 24 + 1, mjd_host_rmt_get_nbr_of_tx_items(RMT_CHANNEL_1)); // The reset frame of init
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_deinit(MJD_STRIP_2));
+}
+
+static void test_submit_multi_strip(void) {
+    const uint32_t strip_mask = MJD_LEDRGB_STRIP_MASK(MJD_STRIP_1) | MJD_LEDRGB_STRIP_MASK(MJD_STRIP_4);
+
+    mjd_host_reset();
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, _init_strip(MJD_STRIP_1, 2, 100, false));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, _init_strip(MJD_STRIP_4, 5, 100, false));
+
+    mjd_ledrgb_get_strip_leds(MJD_STRIP_1)[1] = mjd_led_rgb(0x11, 0x22, 0x33);
+    mjd_ledrgb_get_strip_leds(MJD_STRIP_4)[4] = mjd_led_rgb(0x44, 0x55, 0x66);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_submit_pixels_to_strips(strip_mask));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_wait_strips_tx_done(strip_mask, portMAX_DELAY));
+
+    MJD_TEST_ASSERT_EQUAL_UINT(2 * 24 + 1, mjd_host_rmt_get_nbr_of_tx_items(RMT_CHANNEL_0));
+    MJD_TEST_ASSERT_EQUAL_UINT(5 * 24 + 1, mjd_host_rmt_get_nbr_of_tx_items(RMT_CHANNEL_3));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x22, _get_tx_byte(RMT_CHANNEL_0, 3));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x66, _get_tx_byte(RMT_CHANNEL_3, 14));
+
+    // Invalid masks: empty, out of range, a strip that is not initialized
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_FAIL, mjd_ledrgb_submit_pixels_to_strips(0));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_FAIL, mjd_ledrgb_submit_pixels_to_strips(MJD_LEDRGB_STRIP_MASK(MJD_STRIP_IDENTIFIER_MAX)));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_FAIL, mjd_ledrgb_submit_pixels_to_strips(strip_mask | MJD_LEDRGB_STRIP_MASK(MJD_STRIP_2)));
+    MJD_TEST_ASSERT(mjd_ledrgb_get_strip_leds(MJD_STRIP_2) == NULL);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_deinit(MJD_STRIP_1));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_deinit(MJD_STRIP_4));
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_init_invalid);
+    MJD_TEST_RUN(test_items_grb_msb_first);
+    MJD_TEST_RUN(test_long_strip_chunked);
+    MJD_TEST_RUN(test_brightness_lut);
+    MJD_TEST_RUN(test_gamma_lut);
+    MJD_TEST_RUN(test_submit_double_buffer);
+    MJD_TEST_RUN(test_submit_multi_strip);
+
+    return MJD_TEST_REPORT();
+}
@@ -0,0 +1,199 @@
+/*
+ * HOST TEST: mjd_ledrgb effect renderer and effect engine
+ *
+ * @doc The frames are compared with golden pixel buffers. The engine task never runs on the host: the tests call
+ *      mjd_ledrgb_effect_engine_render_frame() (= one timer tick).
+ */
+#include "mjd.h"
+#include "mjd_ledrgb.h"
+#include "mjd_ledrgb_effect.h"
+
+#include "mjd_host.h"
+#include "mjd_test.h"
+
+#define TEST_COLOR_A (mjd_led_rgb(10, 20, 30))
+#define TEST_COLOR_B (mjd_led_rgb(0, 0, 1))
+
+static esp_err_t _init_strip(mjd_ledrgb_strip_identifier_t param_strip_id, uint32_t param_nbr_of_leds) {
+    mjd_ledrgb_config_t config = MJD_LEDRGB_CONFIG_DEFAULT();
+    config.strip_id = param_strip_id;
+    config.gpio_num = GPIO_NUM_18;
+    config.led_type = MJD_LED_TYPE_WS2812B_V2017;
+    config.nbr_of_leds = param_nbr_of_leds;
+    config.relative_brightness = 100;
+    return mjd_ledrgb_init(&config);
+}
+
+/*
+ * A readable diff of a two-color frame: 'A' = TEST_COLOR_A, '.' = TEST_COLOR_B, '?' = other.
+ */
+static const char * _pattern(const mjd_ledrgb_led_t *param_ptr_leds, uint32_t param_nbr_of_leds) {
+    static char pattern[64];
+    const mjd_ledrgb_led_t a = TEST_COLOR_A;
+    const mjd_ledrgb_led_t b = TEST_COLOR_B;
+    for (uint32_t idx = 0; idx < param_nbr_of_leds; idx++) {
+        if (memcmp(&param_ptr_leds[idx], &a, sizeof(a)) == 0) {
+            pattern[idx] = 'A';
+        } else if (memcmp(&param_ptr_leds[idx], &b, sizeof(b)) == 0) {
+            pattern[idx] = '.';
+        } else {
+            pattern[idx] = '?';
+        }
+    }
+    pattern[param_nbr_of_leds] = '\0';
+    return pattern;
+}
+
+static void test_render_solid(void) {
+    mjd_ledrgb_led_t leds[4];
+    const mjd_ledrgb_effect_t effect =
+        { .type = MJD_LEDRGB_EFFECT_SOLID, .color_a = TEST_COLOR_A };
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_render(&effect, 12345, leds, 4));
+    MJD_TEST_ASSERT_EQUAL_STRING("AAAA", _pattern(leds, 4));
+}
+
+static void test_render_fade(void) {
+    mjd_ledrgb_led_t led;
+    const mjd_ledrgb_effect_t effect =
+        { .type = MJD_LEDRGB_EFFECT_FADE, .color_a = mjd_led_rgb(0, 0, 0), .color_b = mjd_led_rgb(200, 100, 255), .period_frames = 4 };
+    // Triangle wave: up in 4 frames, down in 4 frames
+    const uint8_t golden_r[] =
+        { 0, 50, 100, 150, 200, 150, 100, 50, 0, 50 };
+
+    for (uint32_t frame = 0; frame < ARRAY_SIZE(golden_r); frame++) {
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_render(&effect, frame, &led, 1));
+        MJD_TEST_ASSERT_EQUAL_UINT(golden_r[frame], led.r);
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_render(&effect, 4, &led, 1));
+    MJD_TEST_ASSERT_EQUAL_UINT(100, led.g);
+    MJD_TEST_ASSERT_EQUAL_UINT(255, led.b);
+}
+
+static void test_render_chase(void) {
+    mjd_ledrgb_led_t leds[8];
+    const mjd_ledrgb_effect_t effect =
+        { .type = MJD_LEDRGB_EFFECT_CHASE, .color_a = TEST_COLOR_A, .color_b = TEST_COLOR_B, .period_frames = 2, .length = 3 };
+    const char *golden[] =
+        { "A.....AA", "A.....AA", "AA.....A", "AA.....A", "AAA.....", "AAA.....", ".AAA....", ".AAA....", "..AAA...", "..AAA..." };
+
+    for (uint32_t frame = 0; frame < ARRAY_SIZE(golden); frame++) {
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_render(&effect, frame, leds, 8));
+        MJD_TEST_ASSERT_EQUAL_STRING(golden[frame], _pattern(leds, 8));
+    }
+
+    // One full loop over the strip
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_render(&effect, 2 * 8, leds, 8));
+    MJD_TEST_ASSERT_EQUAL_STRING("A.....AA", _pattern(leds, 8));
+}
+
+static void test_render_palette(void) {
+    mjd_ledrgb_led_t leds[32];
+    mjd_ledrgb_effect_t effect =
+        { .type = MJD_LEDRGB_EFFECT_PALETTE, .ptr_palette = mjd_ledrgb_palette_rainbow, .period_frames = 3 };
+
+    // 16 LEDs = 1 LED per palette entry
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_render(&effect, 0, leds, 16));
+    MJD_TEST_ASSERT_EQUAL_MEMORY(mjd_ledrgb_palette_rainbow, leds, sizeof(mjd_ledrgb_palette_rainbow));
+
+    // Scroll 1 LED every 3 frames
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_render(&effect, 2, leds, 16));
+    MJD_TEST_ASSERT_EQUAL_MEMORY(&mjd_ledrgb_palette_rainbow[0], &leds[0], sizeof(mjd_ledrgb_led_t));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_render(&effect, 3, leds, 16));
+    MJD_TEST_ASSERT_EQUAL_MEMORY(&mjd_ledrgb_palette_rainbow[1], &leds[0], sizeof(mjd_ledrgb_led_t));
+    MJD_TEST_ASSERT_EQUAL_MEMORY(&mjd_ledrgb_palette_rainbow[0], &leds[15], sizeof(mjd_ledrgb_led_t)); // Wraps around
+
+    // 32 LEDs: the odd LEDs blend 2 palette entries 50/50
+    effect.period_frames = 0;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_render(&effect, 99, leds, 32));
+    MJD_TEST_ASSERT_EQUAL_MEMORY(&mjd_ledrgb_palette_rainbow[1], &leds[2], sizeof(mjd_ledrgb_led_t));
+    MJD_TEST_ASSERT_EQUAL_UINT(255, leds[1].r);
+    MJD_TEST_ASSERT_EQUAL_UINT(48, leds[1].g);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, leds[1].b);
+    MJD_TEST_ASSERT_EQUAL_UINT(255, leds[31].r); // Entry 15 => entry 0
+    MJD_TEST_ASSERT_EQUAL_UINT(0, leds[31].g);
+    MJD_TEST_ASSERT_EQUAL_UINT(48, leds[31].b);
+}
+
+static void test_render_invalid(void) {
+    mjd_ledrgb_led_t leds[4];
+    const mjd_ledrgb_effect_t effect_no_palette =
+        { .type = MJD_LEDRGB_EFFECT_PALETTE };
+    const mjd_ledrgb_effect_t effect_solid =
+        { .type = MJD_LEDRGB_EFFECT_SOLID, .color_a = TEST_COLOR_A };
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_ledrgb_effect_render(NULL, 0, leds, 4));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_ledrgb_effect_render(&effect_no_palette, 0, leds, 4));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_ledrgb_effect_render(&effect_solid, 0, leds, 0));
+
+    mjd_host_reset();
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_ledrgb_effect_set(MJD_STRIP_5, &effect_solid)); // Not initialized
+}
+
+static void test_engine_render_frame(void) {
+    mjd_ledrgb_effect_engine_stats_t stats;
+    const mjd_ledrgb_effect_t effect_solid =
+        { .type = MJD_LEDRGB_EFFECT_SOLID, .color_a = TEST_COLOR_A };
+    const mjd_ledrgb_effect_t effect_chase =
+        { .type = MJD_LEDRGB_EFFECT_CHASE, .color_a = TEST_COLOR_A, .color_b = TEST_COLOR_B, .period_frames = 1, .length = 2 };
+
+    mjd_host_reset();
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, _init_strip(MJD_STRIP_1, 4));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, _init_strip(MJD_STRIP_2, 6));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_engine_get_stats(&stats));
+    const uint32_t nbr_of_frames_before = stats.nbr_of_frames;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_set(MJD_STRIP_1, &effect_solid));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_set(MJD_STRIP_2, &effect_chase));
+
+    // Both strips are rendered in place and submitted in the same frame
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_engine_render_frame());
+    MJD_TEST_ASSERT_EQUAL_STRING("AAAA", _pattern(mjd_ledrgb_get_strip_leds(MJD_STRIP_1), 4));
+    MJD_TEST_ASSERT_EQUAL_STRING("A....A", _pattern(mjd_ledrgb_get_strip_leds(MJD_STRIP_2), 6));
+    MJD_TEST_ASSERT_EQUAL_UINT(4 * 24 + 1, mjd_host_rmt_get_nbr_of_tx_items(RMT_CHANNEL_0));
+    MJD_TEST_ASSERT_EQUAL_UINT(6 * 24 + 1, mjd_host_rmt_get_nbr_of_tx_items(RMT_CHANNEL_1));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_engine_render_frame());
+    MJD_TEST_ASSERT_EQUAL_STRING("AA....", _pattern(mjd_ledrgb_get_strip_leds(MJD_STRIP_2), 6));
+
+    // A new effect starts at its frame 0; the other strip is no longer touched
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_set(MJD_STRIP_1, NULL));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_set(MJD_STRIP_2, &effect_chase));
+    mjd_ledrgb_set_strip_led(MJD_STRIP_1, MJD_LED_1, TEST_COLOR_B, false);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_engine_render_frame());
+    MJD_TEST_ASSERT_EQUAL_STRING(".AAA", _pattern(mjd_ledrgb_get_strip_leds(MJD_STRIP_1), 4));
+    MJD_TEST_ASSERT_EQUAL_STRING("A....A", _pattern(mjd_ledrgb_get_strip_leds(MJD_STRIP_2), 6));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_engine_get_stats(&stats));
+    MJD_TEST_ASSERT_EQUAL_UINT(nbr_of_frames_before + 3, stats.nbr_of_frames);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_set(MJD_STRIP_2, NULL));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_effect_engine_render_frame()); // No strips: no-op
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_deinit(MJD_STRIP_1));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_ledrgb_deinit(MJD_STRIP_2));
+}
+
+static void test_engine_config(void) {
+    mjd_ledrgb_effect_engine_config_t config = MJD_LEDRGB_EFFECT_ENGINE_CONFIG_DEFAULT();
+
+    config.fps = 0;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_ledrgb_effect_engine_start(&config));
+    config.fps = MJD_LEDRGB_EFFECT_ENGINE_MAX_FPS + 1;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_ledrgb_effect_engine_start(&config));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, mjd_ledrgb_effect_engine_stop()); // Not running
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_render_solid);
+    MJD_TEST_RUN(test_render_fade);
+    MJD_TEST_RUN(test_render_chase);
+    MJD_TEST_RUN(test_render_palette);
+    MJD_TEST_RUN(test_render_invalid);
+    MJD_TEST_RUN(test_engine_render_frame);
+    MJD_TEST_RUN(test_engine_config);
+
+    return MJD_TEST_REPORT();
+}
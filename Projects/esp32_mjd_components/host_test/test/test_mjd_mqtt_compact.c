@@ -0,0 +1,463 @@
+/*
+ * HOST TEST: mjd_mqtt compact readings (registered topic ids + binary batches)
+ *
+ * @doc The readings are published by a real lwmqtt client to a broker stand-in: an in-memory network that parses the PUBLISH packets,
+ *      acknowledges QoS 1, counts the bytes on the wire and decodes the announcements, the short topics and the batches.
+ */
+#include "mjd.h"
+#include "mjd_mqtt_compact.h"
+#include "lwmqtt.h"
+
+#include "mjd_test.h"
+
+#define TEST_PREFIX          "c/gw1"
+#define TEST_QOS             (1)
+#define TEST_MAX_READINGS    (1200)
+#define TEST_BUF_SIZE        (512)
+
+/**********
+ * Broker stand-in
+ */
+typedef struct {
+    uint16_t topic_id;
+    int32_t scaled_value;
+    int64_t timestamp_ms;
+} _reading_t;
+
+typedef struct {
+    uint8_t tx[TEST_BUF_SIZE];
+    size_t tx_len;
+    uint8_t rx[16];
+    size_t rx_len;
+    size_t rx_pos;
+
+    uint32_t nbr_of_wire_bytes;
+    uint32_t nbr_of_publishes;
+
+    bool is_announced[MJD_MQTT_COMPACT_MAX_TOPICS];
+    bool is_retained[MJD_MQTT_COMPACT_MAX_TOPICS];
+    uint8_t decimals[MJD_MQTT_COMPACT_MAX_TOPICS];
+    char long_topics[MJD_MQTT_COMPACT_MAX_TOPICS][MJD_MQTT_COMPACT_TOPIC_MAX_LEN + 1];
+    uint32_t nbr_of_announcements;
+
+    _reading_t readings[TEST_MAX_READINGS];
+    uint32_t nbr_of_readings;
+    uint32_t nbr_of_unknown_topic_ids;
+    uint32_t nbr_of_decode_errors;
+} _broker_t;
+
+static _broker_t _broker;
+static lwmqtt_client_t _client;
+static uint8_t _client_write_buf[TEST_BUF_SIZE];
+static uint8_t _client_read_buf[TEST_BUF_SIZE];
+static bool _is_network_down = false;
+
+static void _broker_add_reading(uint16_t topic_id, int32_t scaled_value, int64_t timestamp_ms, void *ptr_arg) {
+    if (topic_id >= MJD_MQTT_COMPACT_MAX_TOPICS || _broker.is_announced[topic_id] == false) {
+        _broker.nbr_of_unknown_topic_ids++;
+        return;
+    }
+    if (_broker.nbr_of_readings < TEST_MAX_READINGS) {
+        _broker.readings[_broker.nbr_of_readings++] = (_reading_t) { topic_id, scaled_value, timestamp_ms };
+    }
+}
+
+static void _broker_on_publish(const char *topic, const uint8_t *payload, size_t len, bool retained) {
+    const size_t prefix_len = strlen(TEST_PREFIX "/");
+    char text[MJD_MQTT_COMPACT_TOPIC_MAX_LEN + 8] = "";
+
+    _broker.nbr_of_publishes++;
+    if (strncmp(topic, TEST_PREFIX "/", prefix_len) != 0) {
+        _broker.nbr_of_decode_errors++;
+        return;
+    }
+    topic += prefix_len;
+    if (len < sizeof(text)) {
+        memcpy(text, payload, len);
+        text[len] = '\0';
+    }
+
+    if (strncmp(topic, "r/", 2) == 0) {
+        // Announcement "<decimals>:<long topic>"
+        uint32_t id = strtoul(topic + 2, NULL, 10);
+        char *ptr_colon = strchr(text, ':');
+        if (id >= MJD_MQTT_COMPACT_MAX_TOPICS || ptr_colon == NULL) {
+            _broker.nbr_of_decode_errors++;
+            return;
+        }
+        _broker.is_announced[id] = true;
+        _broker.is_retained[id] = retained;
+        _broker.decimals[id] = strtoul(text, NULL, 10);
+        strcpy(_broker.long_topics[id], ptr_colon + 1);
+        _broker.nbr_of_announcements++;
+    } else if (strcmp(topic, "b") == 0) {
+        if (mjd_mqtt_compact_decode(payload, len, _broker_add_reading, NULL) != ESP_OK) {
+            _broker.nbr_of_decode_errors++;
+        }
+    } else {
+        // Short topic "<id>" with an ASCII value
+        uint32_t id = strtoul(topic, NULL, 10);
+        double scale = 1.0;
+        if (id >= MJD_MQTT_COMPACT_MAX_TOPICS) {
+            _broker.nbr_of_decode_errors++;
+            return;
+        }
+        for (uint32_t i = 0; i < _broker.decimals[id]; i++) {
+            scale *= 10.0;
+        }
+        _broker_add_reading(id, (int32_t) lround(strtod(text, NULL) * scale), 0, NULL);
+    }
+}
+
+/*
+ * @brief Parse the complete PUBLISH packets in the tx buffer. QoS 1 => queue a PUBACK for the client.
+ */
+static void _broker_parse(void) {
+    while (_broker.tx_len >= 2) {
+        size_t pos = 1;
+        uint32_t remaining_len = 0;
+        for (uint32_t shift = 0; pos < _broker.tx_len; shift += 7) {
+            const uint8_t byte = _broker.tx[pos++];
+            remaining_len |= (uint32_t) (byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                break;
+            }
+        }
+        const size_t packet_len = pos + remaining_len;
+        if (_broker.tx_len < packet_len) {
+            return;
+        }
+
+        const uint8_t header = _broker.tx[0];
+        if ((header >> 4) == 3) {
+            const int qos = (header >> 1) & 0x3;
+            const bool retained = (header & 0x1) != 0;
+            const size_t topic_len = ((size_t) _broker.tx[pos] << 8) | _broker.tx[pos + 1];
+            char topic[MJD_MQTT_COMPACT_TOPIC_MAX_LEN + 1];
+            memcpy(topic, &_broker.tx[pos + 2], topic_len);
+            topic[topic_len] = '\0';
+            pos += 2 + topic_len;
+            if (qos > 0) {
+                // PUBACK
+                _broker.rx[_broker.rx_len++] = 0x40;
+                _broker.rx[_broker.rx_len++] = 0x02;
+                _broker.rx[_broker.rx_len++] = _broker.tx[pos];
+                _broker.rx[_broker.rx_len++] = _broker.tx[pos + 1];
+                pos += 2;
+            }
+            _broker_on_publish(topic, &_broker.tx[pos], packet_len - pos, retained);
+        }
+        _broker.nbr_of_wire_bytes += packet_len;
+        memmove(_broker.tx, &_broker.tx[packet_len], _broker.tx_len - packet_len);
+        _broker.tx_len -= packet_len;
+    }
+}
+
+static lwmqtt_err_t _net_write(void *ref, uint8_t *buf, size_t len, size_t *sent, uint32_t timeout) {
+    if (_is_network_down == true || _broker.tx_len + len > sizeof(_broker.tx)) {
+        return LWMQTT_NETWORK_FAILED_WRITE;
+    }
+    memcpy(&_broker.tx[_broker.tx_len], buf, len);
+    _broker.tx_len += len;
+    *sent = len;
+    _broker_parse();
+    return LWMQTT_SUCCESS;
+}
+
+static lwmqtt_err_t _net_read(void *ref, uint8_t *buf, size_t len, size_t *read, uint32_t timeout) {
+    size_t available = _broker.rx_len - _broker.rx_pos;
+    if (len > available) {
+        len = available;
+    }
+    memcpy(buf, &_broker.rx[_broker.rx_pos], len);
+    _broker.rx_pos += len;
+    if (_broker.rx_pos == _broker.rx_len) {
+        _broker.rx_pos = 0;
+        _broker.rx_len = 0;
+    }
+    *read = len;
+    return LWMQTT_SUCCESS;
+}
+
+static void _timer_set(void *ref, uint32_t timeout) {
+}
+
+static int32_t _timer_get(void *ref) {
+    return 1000;
+}
+
+static esp_err_t _lwmqtt_publish(const char *topic, const uint8_t *payload, size_t len, bool retained, void *ptr_arg) {
+    lwmqtt_message_t message = { .qos = TEST_QOS, .retained = retained, .payload = (uint8_t *) payload, .payload_len = len };
+
+    return (lwmqtt_publish(&_client, lwmqtt_string(topic), message, 1000) == LWMQTT_SUCCESS) ? ESP_OK : ESP_FAIL;
+}
+
+static void _setup(mjd_mqtt_compact_t *ptr_ctx, uint32_t max_readings_per_batch) {
+    mjd_mqtt_compact_config_t config = MJD_MQTT_COMPACT_CONFIG_DEFAULT();
+
+    memset(&_broker, 0, sizeof(_broker));
+    _is_network_down = false;
+
+    lwmqtt_init(&_client, _client_write_buf, sizeof(_client_write_buf), _client_read_buf, sizeof(_client_read_buf));
+    lwmqtt_set_network(&_client, NULL, _net_read, _net_write);
+    lwmqtt_set_timers(&_client, NULL, NULL, _timer_set, _timer_get);
+
+    config.prefix = TEST_PREFIX;
+    config.max_readings_per_batch = max_readings_per_batch;
+    config.qos = TEST_QOS;
+    config.publish = _lwmqtt_publish;
+    mjd_mqtt_compact_init(ptr_ctx, &config);
+}
+
+/**********
+ * Workload: the meteohub sensor values of mjd_components_main.c, every 10 seconds for 1 hour
+ */
+#define TEST_NBR_OF_SENSORS  (3)
+#define TEST_INTERVAL_MS     (10 * 1000)
+#define TEST_NBR_OF_SAMPLES  (360)
+#define TEST_EPOCH_MS        (1546300800000LL) // 2019-01-01
+
+static const char *_sensor_topics[TEST_NBR_OF_SENSORS] = { "meteohub/current/temperature", "meteohub/current/humidity",
+        "meteohub/current/pressure" };
+static const uint8_t _sensor_decimals[TEST_NBR_OF_SENSORS] = { 2, 1, 1 };
+
+static float _sensor_value(uint32_t sensor, uint32_t sample) {
+    static const float base[TEST_NBR_OF_SENSORS] = { 21.0f, 55.0f, 1013.0f };
+    // Slow drift + small deterministic noise
+    return base[sensor] + 0.01f * (float) ((sample * 7 + sensor * 13) % 50) - 0.25f;
+}
+
+/*
+ * @brief The value as the receiving side sees it: the ASCII value of mjd_mqtt_publish() * 10^decimals.
+ */
+static int32_t _sensor_scaled_value(uint32_t sensor, uint32_t sample) {
+    char digits[MJD_NUMBER_STRING_MAX_SIZE];
+
+    mjd_float_to_fixed_string(_sensor_value(sensor, sample), _sensor_decimals[sensor], digits);
+    return (int32_t) lround(strtod(digits, NULL) * ((_sensor_decimals[sensor] == 2) ? 100.0 : 10.0));
+}
+
+static void _run_workload(mjd_mqtt_compact_t *ptr_ctx, uint16_t topic_ids[TEST_NBR_OF_SENSORS]) {
+    for (uint32_t i = 0; i < TEST_NBR_OF_SENSORS; i++) {
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_register(ptr_ctx, _sensor_topics[i], _sensor_decimals[i], &topic_ids[i]));
+    }
+    for (uint32_t sample = 0; sample < TEST_NBR_OF_SAMPLES; sample++) {
+        for (uint32_t i = 0; i < TEST_NBR_OF_SENSORS; i++) {
+            MJD_TEST_ASSERT_EQUAL_INT(ESP_OK,
+                    mjd_mqtt_compact_add_reading(ptr_ctx, topic_ids[i], _sensor_value(i, sample), TEST_EPOCH_MS + sample * TEST_INTERVAL_MS));
+        }
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_flush(ptr_ctx));
+}
+
+/*
+ * @brief The readings that the broker decoded are exactly the readings of the workload.
+ */
+static void _check_workload_readings(bool param_has_timestamps) {
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _broker.nbr_of_decode_errors);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _broker.nbr_of_unknown_topic_ids);
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_NBR_OF_SAMPLES * TEST_NBR_OF_SENSORS, _broker.nbr_of_readings);
+    for (uint32_t n = 0; n < _broker.nbr_of_readings; n++) {
+        const uint32_t sample = n / TEST_NBR_OF_SENSORS;
+        const uint32_t sensor = n % TEST_NBR_OF_SENSORS;
+        const _reading_t *ptr_reading = &_broker.readings[n];
+        MJD_TEST_ASSERT_EQUAL_STRING(_sensor_topics[sensor], _broker.long_topics[ptr_reading->topic_id]);
+        MJD_TEST_ASSERT_EQUAL_INT(_sensor_scaled_value(sensor, sample), ptr_reading->scaled_value);
+        if (param_has_timestamps == true) {
+            MJD_TEST_ASSERT(ptr_reading->timestamp_ms == TEST_EPOCH_MS + sample * TEST_INTERVAL_MS);
+        }
+    }
+}
+
+/**********
+ * Tests
+ */
+static void test_register(void) {
+    mjd_mqtt_compact_t ctx;
+    uint16_t id_a, id_b, id;
+    char topic[32];
+
+    _setup(&ctx, 0);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_register(&ctx, "meteohub/current/temperature", 2, &id_a));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_register(&ctx, "meteohub/current/humidity", 1, &id_b));
+    MJD_TEST_ASSERT(id_a != id_b);
+
+    // Again: the same topic id; other decimals: rejected
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_register(&ctx, "meteohub/current/temperature", 2, &id));
+    MJD_TEST_ASSERT_EQUAL_UINT(id_a, id);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_mqtt_compact_register(&ctx, "meteohub/current/temperature", 3, &id));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_mqtt_compact_register(&ctx, "meteohub/+/temperature", 2, &id));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_mqtt_compact_register(&ctx, "", 2, &id));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_mqtt_compact_register(&ctx, "x", MJD_MQTT_COMPACT_MAX_DECIMALS + 1, &id));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_mqtt_compact_add_reading(&ctx, MJD_MQTT_COMPACT_MAX_TOPICS - 1, 1.0f, 0));
+
+    for (uint32_t i = 2; i < MJD_MQTT_COMPACT_MAX_TOPICS; i++) {
+        sprintf(topic, "t/%u", i);
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_register(&ctx, topic, 0, &id));
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_NO_MEM, mjd_mqtt_compact_register(&ctx, "t/full", 0, &id));
+
+    // Nothing is published before the first reading
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _broker.nbr_of_publishes);
+}
+
+static void test_short_topics(void) {
+    mjd_mqtt_compact_t ctx;
+    uint16_t id;
+
+    _setup(&ctx, 0);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_register(&ctx, "meteohub/current/temperature", 2, &id));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_add_reading(&ctx, id, 23.456f, 0));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_add_reading(&ctx, id, -3.14159f, 0));
+
+    // 1 retained announcement before the 1st reading, then 1 publish per reading
+    MJD_TEST_ASSERT_EQUAL_UINT(3, _broker.nbr_of_publishes);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, _broker.nbr_of_announcements);
+    MJD_TEST_ASSERT(_broker.is_retained[id] == true);
+    MJD_TEST_ASSERT_EQUAL_STRING("meteohub/current/temperature", _broker.long_topics[id]);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, _broker.decimals[id]);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, _broker.nbr_of_readings);
+    MJD_TEST_ASSERT_EQUAL_INT(2346, _broker.readings[0].scaled_value);
+    MJD_TEST_ASSERT_EQUAL_INT(-314, _broker.readings[1].scaled_value);
+
+    // After a reconnect the topic id is announced again (once)
+    mjd_mqtt_compact_reset_announcements(&ctx);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_add_reading(&ctx, id, 1.0f, 0));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_add_reading(&ctx, id, 2.0f, 0));
+    MJD_TEST_ASSERT_EQUAL_UINT(2, _broker.nbr_of_announcements);
+    MJD_TEST_ASSERT_EQUAL_UINT(4, _broker.nbr_of_readings);
+}
+
+static void test_batch_roundtrip(void) {
+    mjd_mqtt_compact_t ctx;
+    uint16_t id_a, id_b;
+    mjd_mqtt_compact_stats_t stats;
+
+    _setup(&ctx, 4);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_register(&ctx, "a", 0, &id_a));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_register(&ctx, "b", 3, &id_b));
+
+    // Negative values, a timestamp that goes back and the int32 limits
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_add_reading(&ctx, id_a, 0.0f, TEST_EPOCH_MS));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_add_reading(&ctx, id_b, -1.5f, TEST_EPOCH_MS + 1));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_add_reading(&ctx, id_a, 1e12f, TEST_EPOCH_MS - 5000));
+    MJD_TEST_ASSERT_EQUAL_UINT(2, _broker.nbr_of_publishes); // The announcements only
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_add_reading(&ctx, id_a, -1e12f, 0));
+    MJD_TEST_ASSERT_EQUAL_UINT(3, _broker.nbr_of_publishes); // max_readings_per_batch
+
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _broker.nbr_of_decode_errors);
+    MJD_TEST_ASSERT_EQUAL_UINT(4, _broker.nbr_of_readings);
+    MJD_TEST_ASSERT_EQUAL_INT(0, _broker.readings[0].scaled_value);
+    MJD_TEST_ASSERT(_broker.readings[0].timestamp_ms == TEST_EPOCH_MS);
+    MJD_TEST_ASSERT_EQUAL_INT(-1500, _broker.readings[1].scaled_value);
+    MJD_TEST_ASSERT(_broker.readings[1].timestamp_ms == TEST_EPOCH_MS + 1);
+    MJD_TEST_ASSERT_EQUAL_INT(INT32_MAX, _broker.readings[2].scaled_value);
+    MJD_TEST_ASSERT(_broker.readings[2].timestamp_ms == TEST_EPOCH_MS - 5000);
+    MJD_TEST_ASSERT_EQUAL_INT(INT32_MIN, _broker.readings[3].scaled_value);
+    MJD_TEST_ASSERT(_broker.readings[3].timestamp_ms == 0);
+
+    // Empty flush: nothing
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_flush(&ctx));
+    MJD_TEST_ASSERT_EQUAL_UINT(3, _broker.nbr_of_publishes);
+
+    // A batch that would overflow its buffer is published first
+    _setup(&ctx, 100000);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_register(&ctx, "a", 0, &id_a));
+    for (uint32_t i = 0; i < 200; i++) {
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_add_reading(&ctx, id_a, (float) i * 1000.0f, TEST_EPOCH_MS + i * 60000LL));
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_flush(&ctx));
+    MJD_TEST_ASSERT_EQUAL_UINT(200, _broker.nbr_of_readings);
+    MJD_TEST_ASSERT(_broker.nbr_of_publishes > 2);
+    mjd_mqtt_compact_get_stats(&ctx, &stats);
+    MJD_TEST_ASSERT_EQUAL_UINT(_broker.nbr_of_publishes - 1, stats.nbr_of_publishes);
+
+    // Garbage
+    const uint8_t bad_version[] = { 2, 0 };
+    const uint8_t truncated[] = { MJD_MQTT_COMPACT_BATCH_VERSION, 0, 1, 0x80 };
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_NOT_SUPPORTED, mjd_mqtt_compact_decode(bad_version, sizeof(bad_version), _broker_add_reading, NULL));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, mjd_mqtt_compact_decode(truncated, sizeof(truncated), _broker_add_reading, NULL));
+}
+
+static void test_publish_error_keeps_batch(void) {
+    mjd_mqtt_compact_t ctx;
+    uint16_t id;
+    mjd_mqtt_compact_stats_t stats;
+
+    _setup(&ctx, 2);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_register(&ctx, "a", 1, &id));
+
+    // No announcement => the reading is not taken
+    _is_network_down = true;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_FAIL, mjd_mqtt_compact_add_reading(&ctx, id, 1.0f, 1000));
+    _is_network_down = false;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_add_reading(&ctx, id, 1.0f, 1000));
+
+    // The batch is kept when its publish fails and sent by the next flush
+    _is_network_down = true;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_FAIL, mjd_mqtt_compact_add_reading(&ctx, id, 2.0f, 2000));
+    _is_network_down = false;
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _broker.nbr_of_readings);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_compact_flush(&ctx));
+    MJD_TEST_ASSERT_EQUAL_UINT(2, _broker.nbr_of_readings);
+    MJD_TEST_ASSERT_EQUAL_INT(20, _broker.readings[1].scaled_value);
+
+    mjd_mqtt_compact_get_stats(&ctx, &stats);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, stats.nbr_of_publish_errors);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, stats.nbr_of_readings);
+    MJD_TEST_ASSERT_EQUAL_UINT(_broker.nbr_of_wire_bytes, stats.nbr_of_wire_bytes);
+}
+
+/*
+ * @brief Bytes per reading: long topics (baseline) vs short topics vs batches. The wire statistics must match the bytes of the broker.
+ */
+static void test_bytes_per_reading(void) {
+    mjd_mqtt_compact_t ctx;
+    uint16_t topic_ids[TEST_NBR_OF_SENSORS];
+    mjd_mqtt_compact_stats_t stats_short, stats_batch;
+    uint32_t baseline_wire_bytes = 0;
+
+    // Baseline: the long topic and an ASCII payload in every PUBLISH (mjd_mqtt_publish())
+    _setup(&ctx, 0);
+    for (uint32_t sample = 0; sample < TEST_NBR_OF_SAMPLES; sample++) {
+        for (uint32_t i = 0; i < TEST_NBR_OF_SENSORS; i++) {
+            char digits[MJD_NUMBER_STRING_MAX_SIZE];
+            size_t len = mjd_float_to_fixed_string(_sensor_value(i, sample), _sensor_decimals[i], digits);
+            MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, _lwmqtt_publish(_sensor_topics[i], (const uint8_t *) digits, len, false, NULL));
+        }
+    }
+    baseline_wire_bytes = _broker.nbr_of_wire_bytes;
+
+    _setup(&ctx, 0);
+    _run_workload(&ctx, topic_ids);
+    _check_workload_readings(false);
+    mjd_mqtt_compact_get_stats(&ctx, &stats_short);
+    MJD_TEST_ASSERT_EQUAL_UINT(_broker.nbr_of_wire_bytes, stats_short.nbr_of_wire_bytes);
+    MJD_TEST_ASSERT_EQUAL_UINT(baseline_wire_bytes, stats_short.nbr_of_baseline_bytes);
+
+    _setup(&ctx, 30);
+    _run_workload(&ctx, topic_ids);
+    _check_workload_readings(true);
+    mjd_mqtt_compact_get_stats(&ctx, &stats_batch);
+    MJD_TEST_ASSERT_EQUAL_UINT(_broker.nbr_of_wire_bytes, stats_batch.nbr_of_wire_bytes);
+    MJD_TEST_ASSERT_EQUAL_UINT(baseline_wire_bytes, stats_batch.nbr_of_baseline_bytes);
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_NBR_OF_SAMPLES * TEST_NBR_OF_SENSORS / 30, stats_batch.nbr_of_publishes);
+
+    printf("BYTES %-32s %7.2f bytes/reading\n", "long topics (baseline)", stats_short.baseline_bytes_per_reading);
+    printf("BYTES %-32s %7.2f bytes/reading\n", "short topic ids", stats_short.bytes_per_reading);
+    printf("BYTES %-32s %7.2f bytes/reading\n", "batches of 30 readings", stats_batch.bytes_per_reading);
+
+    MJD_TEST_ASSERT(stats_short.bytes_per_reading < stats_short.baseline_bytes_per_reading / 2);
+    MJD_TEST_ASSERT(stats_batch.bytes_per_reading < stats_short.bytes_per_reading / 2);
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_register);
+    MJD_TEST_RUN(test_short_topics);
+    MJD_TEST_RUN(test_batch_roundtrip);
+    MJD_TEST_RUN(test_publish_error_keeps_batch);
+    MJD_TEST_RUN(test_bytes_per_reading);
+
+    return MJD_TEST_REPORT();
+}
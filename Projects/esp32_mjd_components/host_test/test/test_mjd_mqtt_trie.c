@@ -0,0 +1,175 @@
+/*
+ * HOST TEST: mjd_mqtt topic filter trie (MQTT v3.1.1 wildcards)
+ */
+#include "mjd.h"
+#include "mjd_mqtt_trie.h"
+
+#include "mjd_test.h"
+
+static uint32_t _match(const mjd_mqtt_trie_t* ptr_trie, const char* topic) {
+    return mjd_mqtt_trie_match(ptr_trie, topic, strlen(topic));
+}
+
+static void test_exact_match(void) {
+    mjd_mqtt_trie_t trie;
+
+    mjd_mqtt_trie_init(&trie);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "mjd/lora/temperature", 0));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "mjd/lora/humidity", 1));
+
+    MJD_TEST_ASSERT_EQUAL_UINT(0x1, _match(&trie, "mjd/lora/temperature"));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x2, _match(&trie, "mjd/lora/humidity"));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _match(&trie, "mjd/lora"));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _match(&trie, "mjd/lora/temperature/x"));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _match(&trie, "mjd/lora/temp"));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _match(&trie, "mjd/lora/temperaturex"));
+
+    // The topic is not NUL terminated at topic_len (it points into a receive buffer)
+    MJD_TEST_ASSERT_EQUAL_UINT(0x2, mjd_mqtt_trie_match(&trie, "mjd/lora/humidity/extra", 17));
+
+    // The prefix "mjd/lora/" is shared: root + mjd + lora + temperature + humidity
+    MJD_TEST_ASSERT_EQUAL_UINT(5, trie.nbr_of_nodes_used);
+}
+
+static void test_single_level_wildcard(void) {
+    mjd_mqtt_trie_t trie;
+
+    mjd_mqtt_trie_init(&trie);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "mjd/+/temperature", 0));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "+/+", 1));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "mjd/lora/temperature", 2));
+
+    MJD_TEST_ASSERT_EQUAL_UINT(0x5, _match(&trie, "mjd/lora/temperature"));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x1, _match(&trie, "mjd/wifi/temperature"));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x2, _match(&trie, "mjd/wifi"));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _match(&trie, "mjd/a/b/temperature"));
+
+    // "+" matches an empty level
+    MJD_TEST_ASSERT_EQUAL_UINT(0x1, _match(&trie, "mjd//temperature"));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x2, _match(&trie, "/x"));
+}
+
+static void test_multi_level_wildcard(void) {
+    mjd_mqtt_trie_t trie;
+
+    mjd_mqtt_trie_init(&trie);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "mjd/#", 0));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "#", 1));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "mjd/+/#", 2));
+
+    // "mjd/#" also matches the parent level "mjd"
+    MJD_TEST_ASSERT_EQUAL_UINT(0x3, _match(&trie, "mjd"));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x7, _match(&trie, "mjd/lora"));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x7, _match(&trie, "mjd/lora/a/b/c"));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x2, _match(&trie, "other/topic"));
+}
+
+static void test_dollar_topics(void) {
+    mjd_mqtt_trie_t trie;
+
+    mjd_mqtt_trie_init(&trie);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "#", 0));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "+/broker/uptime", 1));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "$SYS/#", 2));
+
+    // The wildcards in the first level do not match $ topics
+    MJD_TEST_ASSERT_EQUAL_UINT(0x4, _match(&trie, "$SYS/broker/uptime"));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x3, _match(&trie, "mjd/broker/uptime"));
+}
+
+static void test_same_subscription_several_paths(void) {
+    mjd_mqtt_trie_t trie;
+
+    mjd_mqtt_trie_init(&trie);
+    // A subscription index is reported once
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "a/b", 3));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "a/+", 3));
+    MJD_TEST_ASSERT_EQUAL_UINT(1U << 3, _match(&trie, "a/b"));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "a/b", 31));
+    MJD_TEST_ASSERT_EQUAL_UINT((1U << 3) | (1U << 31), _match(&trie, "a/b"));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_mqtt_trie_insert(&trie, "a/b", 32));
+}
+
+static void test_remove_and_node_reuse(void) {
+    mjd_mqtt_trie_t trie;
+
+    mjd_mqtt_trie_init(&trie);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "mjd/lora/temperature", 0));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "mjd/lora/temperature", 1));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "mjd/wifi/#", 2));
+    uint32_t nbr_of_nodes_used = trie.nbr_of_nodes_used;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_NOT_FOUND, mjd_mqtt_trie_remove(&trie, "mjd/lora/temperature", 5));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_NOT_FOUND, mjd_mqtt_trie_remove(&trie, "mjd/unknown", 0));
+
+    // Still used by subscription 1: the nodes stay
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_remove(&trie, "mjd/lora/temperature", 0));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x2, _match(&trie, "mjd/lora/temperature"));
+    MJD_TEST_ASSERT_EQUAL_UINT(nbr_of_nodes_used, trie.nbr_of_nodes_used);
+
+    // The branch "lora/temperature" is pruned, "mjd" stays for "mjd/wifi/#"
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_remove(&trie, "mjd/lora/temperature", 1));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _match(&trie, "mjd/lora/temperature"));
+    MJD_TEST_ASSERT_EQUAL_UINT(nbr_of_nodes_used - 2, trie.nbr_of_nodes_used);
+    MJD_TEST_ASSERT_EQUAL_UINT(0x4, _match(&trie, "mjd/wifi/rssi"));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_remove(&trie, "mjd/wifi/#", 2));
+    MJD_TEST_ASSERT_EQUAL_UINT(1, trie.nbr_of_nodes_used);
+
+    // The freed nodes are reused: subscribe/unsubscribe forever without running out
+    for (uint32_t i = 0; i < 10 * MJD_MQTT_TRIE_MAX_NODES; i++) {
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "a/b/c/d/e/f", i % MJD_MQTT_TRIE_MAX_SUBSCRIPTIONS));
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_remove(&trie, "a/b/c/d/e/f", i % MJD_MQTT_TRIE_MAX_SUBSCRIPTIONS));
+    }
+    MJD_TEST_ASSERT_EQUAL_UINT(1, trie.nbr_of_nodes_used);
+}
+
+static void test_validate_filter(void) {
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_validate_filter("a/b/c"));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_validate_filter("+"));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_validate_filter("a/+/#"));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_validate_filter("/a//"));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_mqtt_trie_validate_filter(""));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_mqtt_trie_validate_filter("a/#/b"));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_mqtt_trie_validate_filter("a/b#"));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_mqtt_trie_validate_filter("a/b+/c"));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, mjd_mqtt_trie_validate_filter("a/0123456789012345678901234567890123456789"));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, mjd_mqtt_trie_validate_filter("1/2/3/4/5/6/7/8/9/10/11/12/13/14/15/16/17"));
+}
+
+static void test_out_of_nodes_rollback(void) {
+    mjd_mqtt_trie_t trie;
+    char filter[16];
+    uint32_t i;
+
+    mjd_mqtt_trie_init(&trie);
+    // 1 new node per filter until the nodes are exhausted
+    for (i = 0; i < MJD_MQTT_TRIE_MAX_NODES - 3; i++) {
+        sprintf(filter, "t%u", i);
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, filter, 0));
+    }
+    MJD_TEST_ASSERT_EQUAL_UINT(MJD_MQTT_TRIE_MAX_NODES - 2, trie.nbr_of_nodes_used);
+
+    // Needs 4 nodes, only 2 free: nothing is left behind
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_NO_MEM, mjd_mqtt_trie_insert(&trie, "x/y/z/w", 1));
+    MJD_TEST_ASSERT_EQUAL_UINT(MJD_MQTT_TRIE_MAX_NODES - 2, trie.nbr_of_nodes_used);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _match(&trie, "x/y"));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_mqtt_trie_insert(&trie, "x/y", 1));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x2, _match(&trie, "x/y"));
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_exact_match);
+    MJD_TEST_RUN(test_single_level_wildcard);
+    MJD_TEST_RUN(test_multi_level_wildcard);
+    MJD_TEST_RUN(test_dollar_topics);
+    MJD_TEST_RUN(test_same_subscription_several_paths);
+    MJD_TEST_RUN(test_remove_and_node_reuse);
+    MJD_TEST_RUN(test_validate_filter);
+    MJD_TEST_RUN(test_out_of_nodes_rollback);
+
+    return MJD_TEST_REPORT();
+}
@@ -0,0 +1,271 @@
+/*
+ * HOST TEST: mjd_neom8n stream parser (NMEA + UBX, zero-copy, chunked)
+ */
+#include "mjd.h"
+#include "mjd_neom8n.h"
+#include "mjd_neom8n_parser.h"
+
+#include "mjd_host_gps_log.h"
+#include "mjd_test.h"
+
+static void _init_data(mjd_neom8n_data_t* ptr_data) {
+    ptr_data->data_received = false;
+    ptr_data->fix_quality = -1;
+    ptr_data->latitude = NAN;
+    ptr_data->longitude = NAN;
+    ptr_data->satellites_tracked = -1;
+    ptr_data->altitude_m = NAN;
+    ptr_data->ground_speed_kmh = NAN;
+    ptr_data->horizontal_accuracy_m = NAN;
+    ptr_data->satellites_visible = -1;
+    ptr_data->cno_mean_dbhz = -1;
+    ptr_data->fix_counter = 0;
+}
+
+static void _feed_in_chunks(mjd_neom8n_parser_t* ptr_parser, const uint8_t* ptr_buf, size_t len, size_t chunk_size,
+                            mjd_neom8n_data_t* ptr_data) {
+    for (size_t offset = 0; offset < len; offset += chunk_size) {
+        size_t n = (len - offset < chunk_size) ? (len - offset) : chunk_size;
+        mjd_neom8n_parser_feed(ptr_parser, ptr_buf + offset, n, ptr_data);
+    }
+}
+
+/*
+ * Build a UBX frame (sync chars + header + payload + checksum). Returns the frame length.
+ */
+static size_t _build_ubx(uint8_t* ptr_frame, uint8_t class, uint8_t id, const uint8_t* ptr_payload, uint16_t len_payload) {
+    ptr_frame[0] = MJD_NEOM8N_UBX_SYNC_CHAR_1;
+    ptr_frame[1] = MJD_NEOM8N_UBX_SYNC_CHAR_2;
+    ptr_frame[2] = class;
+    ptr_frame[3] = id;
+    ptr_frame[4] = (uint8_t) (len_payload & 0xFF);
+    ptr_frame[5] = (uint8_t) (len_payload >> 8);
+    memcpy(&ptr_frame[6], ptr_payload, len_payload);
+    mjd_neom8n_ubx_checksum(&ptr_frame[2], 4 + len_payload, &ptr_frame[6 + len_payload], &ptr_frame[7 + len_payload]);
+    return 8 + len_payload;
+}
+
+static void test_ubx_checksum(void) {
+    // UBX-ACK-ACK for CFG-MSG (from the recorded log)
+    const uint8_t ack[] = { 0x05, 0x01, 0x02, 0x00, 0x06, 0x01 };
+    uint8_t ck_a, ck_b;
+
+    mjd_neom8n_ubx_checksum(ack, sizeof(ack), &ck_a, &ck_b);
+    MJD_TEST_ASSERT_EQUAL_INT(0x0F, ck_a);
+    MJD_TEST_ASSERT_EQUAL_INT(0x38, ck_b);
+}
+
+static void test_recorded_log(void) {
+    mjd_neom8n_parser_t parser;
+    mjd_neom8n_parser_stats_t stats;
+    mjd_neom8n_data_t data;
+
+    _init_data(&data);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_neom8n_parser_init(&parser));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK,
+            mjd_neom8n_parser_feed(&parser, (const uint8_t *) mjd_host_gps_log, MJD_HOST_GPS_LOG_LENGTH, &data));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_neom8n_parser_get_stats(&parser, &stats));
+
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_HOST_GPS_LOG_LENGTH, stats.nbr_of_bytes);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_HOST_GPS_LOG_NBR_OF_NMEA_SENTENCES, stats.nbr_of_nmea_sentences);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_HOST_GPS_LOG_NBR_OF_UBX_FRAMES, stats.nbr_of_ubx_frames);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_HOST_GPS_LOG_NBR_OF_UBX_NAV_PVT, stats.nbr_of_ubx_nav_pvt);
+    MJD_TEST_ASSERT_EQUAL_INT(0, stats.nbr_of_nmea_checksum_errors);
+    MJD_TEST_ASSERT_EQUAL_INT(0, stats.nbr_of_nmea_overflows);
+    MJD_TEST_ASSERT_EQUAL_INT(0, stats.nbr_of_nmea_parse_errors);
+    MJD_TEST_ASSERT_EQUAL_INT(0, stats.nbr_of_ubx_checksum_errors);
+    // Only the CR LF of each sentence is outside a frame
+    MJD_TEST_ASSERT_EQUAL_INT(2 * MJD_HOST_GPS_LOG_NBR_OF_NMEA_SENTENCES, stats.nbr_of_skipped_bytes);
+
+    // The last epoch (UBX-NAV-PVT after the NMEA sentences)
+    MJD_TEST_ASSERT(data.data_received);
+    MJD_TEST_ASSERT_EQUAL_INT(1, data.fix_quality);
+    MJD_TEST_ASSERT_EQUAL_INT(9, data.satellites_tracked);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.00001, 66.443983, data.latitude);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.00001, 33.791772, data.longitude);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 9.3, data.altitude_m);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 2.15, data.horizontal_accuracy_m);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 5.4, data.ground_speed_kmh);
+}
+
+static void test_recorded_log_chunked(void) {
+    const size_t chunk_sizes[] = { 1, 2, 7, 64, 91, 120, 512 };
+    mjd_neom8n_parser_t parser;
+    mjd_neom8n_parser_stats_t expected_stats, stats;
+    mjd_neom8n_data_t expected_data, data;
+
+    _init_data(&expected_data);
+    mjd_neom8n_parser_init(&parser);
+    mjd_neom8n_parser_feed(&parser, (const uint8_t *) mjd_host_gps_log, MJD_HOST_GPS_LOG_LENGTH, &expected_data);
+    mjd_neom8n_parser_get_stats(&parser, &expected_stats);
+
+    // Frames that straddle 2 (or many) chunks are staged: the result does not depend on the chunk size
+    for (size_t i = 0; i < ARRAY_SIZE(chunk_sizes); i++) {
+        _init_data(&data);
+        mjd_neom8n_parser_init(&parser);
+        _feed_in_chunks(&parser, (const uint8_t *) mjd_host_gps_log, MJD_HOST_GPS_LOG_LENGTH, chunk_sizes[i], &data);
+        mjd_neom8n_parser_get_stats(&parser, &stats);
+
+        MJD_TEST_ASSERT_EQUAL_INT(0, memcmp(&expected_stats, &stats, sizeof(stats)));
+        MJD_TEST_ASSERT_EQUAL_INT(expected_data.fix_quality, data.fix_quality);
+        MJD_TEST_ASSERT_EQUAL_INT(expected_data.satellites_tracked, data.satellites_tracked);
+        MJD_TEST_ASSERT_FLOAT_WITHIN(0.0000001, expected_data.latitude, data.latitude);
+        MJD_TEST_ASSERT_FLOAT_WITHIN(0.0000001, expected_data.longitude, data.longitude);
+        MJD_TEST_ASSERT_FLOAT_WITHIN(0.0000001, expected_data.horizontal_accuracy_m, data.horizontal_accuracy_m);
+    }
+}
+
+static void test_nav_pvt_no_fix(void) {
+    mjd_neom8n_parser_t parser;
+    mjd_neom8n_data_t data;
+    uint8_t payload[MJD_NEOM8N_UBX_NAV_PVT_PAYLOAD_LENGTH] = { 0 };
+    uint8_t frame[MJD_NEOM8N_UBX_NAV_PVT_PAYLOAD_LENGTH + 8];
+
+    // A receiver without a fix still reports the seeded position: it must not be used
+    payload[20] = 0; // fixType no fix
+    payload[21] = 0x00; // !gnssFixOK
+    payload[23] = 3;
+    payload[28] = 0x10;
+    size_t len = _build_ubx(frame, MJD_NEOM8N_UBX_CLASS_NAV, MJD_NEOM8N_UBX_ID_NAV_PVT, payload, sizeof(payload));
+
+    _init_data(&data);
+    mjd_neom8n_parser_init(&parser);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_neom8n_parser_feed(&parser, frame, len, &data));
+    MJD_TEST_ASSERT(data.data_received);
+    MJD_TEST_ASSERT_EQUAL_INT(0, data.fix_quality);
+    MJD_TEST_ASSERT_EQUAL_INT(3, data.satellites_tracked);
+    MJD_TEST_ASSERT(isnan(data.latitude));
+
+    // Dead reckoning only => GGA fix quality 6; DGNSS => 2
+    payload[20] = 1;
+    len = _build_ubx(frame, MJD_NEOM8N_UBX_CLASS_NAV, MJD_NEOM8N_UBX_ID_NAV_PVT, payload, sizeof(payload));
+    mjd_neom8n_parser_feed(&parser, frame, len, &data);
+    MJD_TEST_ASSERT_EQUAL_INT(6, data.fix_quality);
+
+    payload[20] = 3;
+    payload[21] = 0x03;
+    len = _build_ubx(frame, MJD_NEOM8N_UBX_CLASS_NAV, MJD_NEOM8N_UBX_ID_NAV_PVT, payload, sizeof(payload));
+    mjd_neom8n_parser_feed(&parser, frame, len, &data);
+    MJD_TEST_ASSERT_EQUAL_INT(2, data.fix_quality);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.0000001, 0.0000016, data.latitude);
+}
+
+static void test_checksum_errors(void) {
+    static uint8_t log[sizeof(mjd_host_gps_log)];
+    mjd_neom8n_parser_t parser;
+    mjd_neom8n_parser_stats_t stats;
+    mjd_neom8n_data_t data;
+
+    memcpy(log, mjd_host_gps_log, sizeof(log));
+
+    // Corrupt the last GGA sentence (NMEA) and the last UBX-NAV-PVT payload (@important no strstr(): the log contains 0x00 bytes)
+    size_t gga_offset = 0;
+    size_t pvt_offset = 0;
+    for (size_t i = 0; i + 6 < MJD_HOST_GPS_LOG_LENGTH; i++) {
+        if (memcmp(&log[i], "$GNGGA", 6) == 0) {
+            gga_offset = i;
+        }
+        if (log[i] == MJD_NEOM8N_UBX_SYNC_CHAR_1 && log[i + 1] == MJD_NEOM8N_UBX_SYNC_CHAR_2 && log[i + 2] == MJD_NEOM8N_UBX_CLASS_NAV
+                && log[i + 3] == MJD_NEOM8N_UBX_ID_NAV_PVT) {
+            pvt_offset = i;
+        }
+    }
+    MJD_TEST_ASSERT(gga_offset > 0);
+    MJD_TEST_ASSERT(pvt_offset > 0);
+    log[gga_offset + 20] ^= 0x01;
+    log[pvt_offset + 6 + 23] = 42; // numSV
+
+    _init_data(&data);
+    mjd_neom8n_parser_init(&parser);
+    _feed_in_chunks(&parser, log, MJD_HOST_GPS_LOG_LENGTH, 64, &data);
+    mjd_neom8n_parser_get_stats(&parser, &stats);
+
+    MJD_TEST_ASSERT_EQUAL_INT(1, stats.nbr_of_nmea_checksum_errors);
+    MJD_TEST_ASSERT_EQUAL_INT(1, stats.nbr_of_ubx_checksum_errors);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_HOST_GPS_LOG_NBR_OF_NMEA_SENTENCES - 1, stats.nbr_of_nmea_sentences);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_HOST_GPS_LOG_NBR_OF_UBX_NAV_PVT - 1, stats.nbr_of_ubx_nav_pvt);
+    // The corrupted frames are dropped: the satellites are from the previous epoch (10)
+    MJD_TEST_ASSERT_EQUAL_INT(10, data.satellites_tracked);
+}
+
+static void test_garbage_and_overflow(void) {
+    // A truncated sentence, line noise, an over-long sentence, a false UBX sync char, then a valid sentence
+    static const char stream[] = "$GNGSA,A,3,15,24,12,,,,,,,,,,,,,,,,,3.31,1.6"
+            "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n"
+            "BL1\r\nBL2\r\n"
+            "$GNTXT,01,01,02,u-blox AG - www.u-blox.com u-blox AG - www.u-blox.com u-blox AG - www.u-blox.com*4E\r\n"
+            "\xB5" "$GPRMC,081836,A,3751.65,S,14507.36,E,000.0,360.0,130998,011.3,E*62\r\n";
+    mjd_neom8n_parser_t parser;
+    mjd_neom8n_parser_stats_t stats;
+    mjd_neom8n_data_t data;
+
+    _init_data(&data);
+    mjd_neom8n_parser_init(&parser);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_neom8n_parser_feed(&parser, (const uint8_t *) stream, sizeof(stream) - 1, &data));
+    mjd_neom8n_parser_get_stats(&parser, &stats);
+
+    MJD_TEST_ASSERT_EQUAL_INT(2, stats.nbr_of_nmea_sentences);
+    MJD_TEST_ASSERT_EQUAL_INT(1, stats.nbr_of_nmea_overflows);
+    MJD_TEST_ASSERT_EQUAL_INT(0, stats.nbr_of_nmea_checksum_errors);
+    MJD_TEST_ASSERT_EQUAL_INT(8, data.satellites_tracked);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.0001, -37.860833, data.latitude);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.0001, 145.122667, data.longitude);
+
+    // Nothing decodable => ESP_ERR_NOT_FOUND
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_NOT_FOUND, mjd_neom8n_parser_feed(&parser, (const uint8_t *) "BL3\r\n", 5, &data));
+}
+
+static void test_long_ubx_frame_not_buffered(void) {
+    // UBX-NAV-SAT with 50 SV's (8 + 12 * 50 bytes): larger than the parser, checksummed in place
+    static uint8_t payload[8 + 12 * 50];
+    static uint8_t frame[sizeof(payload) + 8];
+    mjd_neom8n_parser_t parser;
+    mjd_neom8n_parser_stats_t stats;
+    mjd_neom8n_data_t data;
+
+    for (size_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = (uint8_t) (i * 7);
+    }
+    size_t len = _build_ubx(frame, MJD_NEOM8N_UBX_CLASS_NAV, 0x35, payload, sizeof(payload));
+
+    _init_data(&data);
+    mjd_neom8n_parser_init(&parser);
+    _feed_in_chunks(&parser, frame, len, 100, &data);
+    mjd_neom8n_parser_feed(&parser, (const uint8_t *) mjd_host_gps_log, MJD_HOST_GPS_LOG_LENGTH, &data);
+    mjd_neom8n_parser_get_stats(&parser, &stats);
+
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_HOST_GPS_LOG_NBR_OF_UBX_FRAMES + 1, stats.nbr_of_ubx_frames);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_HOST_GPS_LOG_NBR_OF_UBX_NAV_PVT, stats.nbr_of_ubx_nav_pvt);
+    MJD_TEST_ASSERT_EQUAL_INT(0, stats.nbr_of_ubx_checksum_errors);
+
+    // A corrupt length field (> 1KB) is rejected right away instead of swallowing the stream
+    const uint8_t bogus[] = { MJD_NEOM8N_UBX_SYNC_CHAR_1, MJD_NEOM8N_UBX_SYNC_CHAR_2, 0x01, 0x07, 0xFF, 0xFF };
+    mjd_neom8n_parser_init(&parser);
+    mjd_neom8n_parser_feed(&parser, bogus, sizeof(bogus), &data);
+    mjd_neom8n_parser_feed(&parser, (const uint8_t *) mjd_host_gps_log, MJD_HOST_GPS_LOG_LENGTH, &data);
+    mjd_neom8n_parser_get_stats(&parser, &stats);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_HOST_GPS_LOG_NBR_OF_NMEA_SENTENCES, stats.nbr_of_nmea_sentences);
+}
+
+static void test_invalid_args(void) {
+    mjd_neom8n_parser_t parser;
+    mjd_neom8n_data_t data;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_neom8n_parser_init(NULL));
+    mjd_neom8n_parser_init(&parser);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_neom8n_parser_feed(&parser, NULL, 10, &data));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_neom8n_parser_feed(&parser, (const uint8_t *) "$", 1, NULL));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, mjd_neom8n_ubx_decode_nav_pvt((const uint8_t *) "", 0, &data));
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_ubx_checksum);
+    MJD_TEST_RUN(test_recorded_log);
+    MJD_TEST_RUN(test_recorded_log_chunked);
+    MJD_TEST_RUN(test_nav_pvt_no_fix);
+    MJD_TEST_RUN(test_checksum_errors);
+    MJD_TEST_RUN(test_garbage_and_overflow);
+    MJD_TEST_RUN(test_long_ubx_frame_not_buffered);
+    MJD_TEST_RUN(test_invalid_args);
+    return MJD_TEST_REPORT();
+}
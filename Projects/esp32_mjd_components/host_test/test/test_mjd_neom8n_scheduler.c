@@ -0,0 +1,339 @@
+/*
+ * HOST TEST: mjd_neom8n duty cycling scheduler against a simulated receiver
+ *
+ * @doc The simulated receiver follows the actions of the scheduler (power up, backup mode, power save mode) and delivers a fix
+ *      after a TTFF that depends on the age of its own ephemeris/almanac and on the aiding it received (u-blox M8 datasheet orders of magnitude).
+ */
+#include "mjd.h"
+#include "mjd_neom8n.h"
+#include "mjd_neom8n_scheduler.h"
+
+#include "mjd_test.h"
+
+#define SIM_SEC (1000000LL)
+#define SIM_TTFF_HOT_MS (2000)
+#define SIM_TTFF_WARM_MS (30000)
+#define SIM_TTFF_WARM_AIDED_MS (15000)
+#define SIM_TTFF_COLD_MS (35000)
+
+typedef struct {
+    bool has_sky_view;
+    bool is_on;
+    bool is_power_save;
+    uint32_t power_save_update_period_ms;
+    bool is_aided;
+    int64_t on_since_us;
+    uint32_t ttff_ms;
+    bool has_fix;
+    int64_t last_fix_us;    /*!< Receiver side: the age of its ephemeris/almanac */
+    bool has_ever_fixed;
+    mjd_neom8n_data_t data; /*!< What the parser of the monitor task would deliver */
+    uint32_t nbr_of_power_ups;
+    uint32_t nbr_of_power_downs;
+    uint32_t nbr_of_aidings;
+    uint32_t last_power_down_ms;
+} sim_receiver_t;
+
+static void _sim_init(sim_receiver_t* ptr_sim) {
+    memset(ptr_sim, 0, sizeof(*ptr_sim));
+    ptr_sim->has_sky_view = true;
+    ptr_sim->data.fix_quality = -1;
+    ptr_sim->data.latitude = NAN;
+    ptr_sim->data.longitude = NAN;
+    ptr_sim->data.satellites_tracked = -1;
+    ptr_sim->data.altitude_m = NAN;
+    ptr_sim->data.ground_speed_kmh = NAN;
+    ptr_sim->data.horizontal_accuracy_m = NAN;
+    ptr_sim->data.satellites_visible = -1;
+    ptr_sim->data.cno_mean_dbhz = -1;
+    ptr_sim->data.fix_counter = 0;
+}
+
+static void _sim_power_up(sim_receiver_t* ptr_sim, int64_t now_us, bool is_aided) {
+    int64_t age_ms = (now_us - ptr_sim->last_fix_us) / 1000;
+
+    ptr_sim->is_on = true;
+    ptr_sim->has_fix = false;
+    ptr_sim->on_since_us = now_us;
+    ptr_sim->is_aided = is_aided;
+    if (ptr_sim->has_ever_fixed == true && age_ms < 4 * 60 * 60 * 1000) {
+        ptr_sim->ttff_ms = SIM_TTFF_HOT_MS;
+    } else if (ptr_sim->has_ever_fixed == true || is_aided == true) {
+        ptr_sim->ttff_ms = (is_aided == true) ? SIM_TTFF_WARM_AIDED_MS : SIM_TTFF_WARM_MS;
+    } else {
+        ptr_sim->ttff_ms = SIM_TTFF_COLD_MS;
+    }
+    ptr_sim->nbr_of_power_ups++;
+}
+
+/*
+ * Advance the simulated receiver to now: 1 navigation solution per second while it is on.
+ */
+static void _sim_advance(sim_receiver_t* ptr_sim, int64_t now_us) {
+    if (ptr_sim->is_on == false || ptr_sim->has_sky_view == false) {
+        return;
+    }
+    if (now_us - ptr_sim->on_since_us < (int64_t) ptr_sim->ttff_ms * 1000) {
+        return;
+    }
+    ptr_sim->has_fix = true;
+    ptr_sim->has_ever_fixed = true;
+    ptr_sim->last_fix_us = now_us;
+    ptr_sim->data.data_received = true;
+    ptr_sim->data.fix_quality = 1;
+    ptr_sim->data.latitude = 50.8798;
+    ptr_sim->data.longitude = 4.7005;
+    ptr_sim->data.altitude_m = 31.5;
+    ptr_sim->data.fix_counter++;
+}
+
+static void _sim_execute(sim_receiver_t* ptr_sim, int64_t now_us, const mjd_neom8n_scheduler_action_t* ptr_action) {
+    switch (ptr_action->type) {
+    case MJD_NEOM8N_SCHEDULER_ACTION_POWER_UP:
+        if (ptr_action->is_aiding_requested == true) {
+            ptr_sim->nbr_of_aidings++;
+        }
+        _sim_power_up(ptr_sim, now_us, ptr_action->is_aiding_requested);
+        break;
+    case MJD_NEOM8N_SCHEDULER_ACTION_POWER_DOWN:
+        ptr_sim->is_on = false;
+        ptr_sim->nbr_of_power_downs++;
+        ptr_sim->last_power_down_ms = ptr_action->duration_ms;
+        break;
+    case MJD_NEOM8N_SCHEDULER_ACTION_ENABLE_POWER_SAVE:
+        ptr_sim->is_power_save = true;
+        ptr_sim->power_save_update_period_ms = ptr_action->update_period_ms;
+        break;
+    case MJD_NEOM8N_SCHEDULER_ACTION_NONE:
+        break;
+    }
+}
+
+/*
+ * Run the scheduler task loop (1 step per second) from from_s up to (not incl.) to_s.
+ */
+static void _run(mjd_neom8n_scheduler_t* ptr_scheduler, sim_receiver_t* ptr_sim, int64_t from_s, int64_t to_s) {
+    mjd_neom8n_scheduler_action_t action;
+
+    for (int64_t t = from_s; t < to_s; t++) {
+        int64_t now_us = t * SIM_SEC;
+        _sim_advance(ptr_sim, now_us);
+        mjd_neom8n_scheduler_step(ptr_scheduler, now_us, &ptr_sim->data, &action);
+        _sim_execute(ptr_sim, now_us, &action);
+    }
+}
+
+static void test_select_mode(void) {
+    mjd_neom8n_scheduler_config_t config = MJD_NEOM8N_SCHEDULER_CONFIG_DEFAULT();
+
+    config.fix_interval_ms = 1000;
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_SCHEDULER_MODE_CONTINUOUS, mjd_neom8n_scheduler_select_mode(&config));
+    config.fix_interval_ms = 10000;
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_SCHEDULER_MODE_CONTINUOUS, mjd_neom8n_scheduler_select_mode(&config));
+    config.fix_interval_ms = 60000;
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_SCHEDULER_MODE_POWER_SAVE, mjd_neom8n_scheduler_select_mode(&config));
+    config.fix_interval_ms = 120000;
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_SCHEDULER_MODE_POWER_SAVE, mjd_neom8n_scheduler_select_mode(&config));
+    config.fix_interval_ms = 300000;
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_SCHEDULER_MODE_BACKUP, mjd_neom8n_scheduler_select_mode(&config));
+}
+
+static void test_init_invalid_args(void) {
+    mjd_neom8n_scheduler_config_t config = MJD_NEOM8N_SCHEDULER_CONFIG_DEFAULT();
+    mjd_neom8n_scheduler_t scheduler;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_neom8n_scheduler_init(NULL, &config));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_neom8n_scheduler_init(&scheduler, NULL));
+
+    config.fix_interval_ms = 0;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_neom8n_scheduler_init(&scheduler, &config));
+
+    config = (mjd_neom8n_scheduler_config_t) MJD_NEOM8N_SCHEDULER_CONFIG_DEFAULT();
+    config.continuous_max_interval_ms = config.power_save_max_interval_ms + 1;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_neom8n_scheduler_init(&scheduler, &config));
+}
+
+static void test_estimate_start_type(void) {
+    mjd_neom8n_scheduler_config_t config = MJD_NEOM8N_SCHEDULER_CONFIG_DEFAULT();
+    mjd_neom8n_scheduler_t scheduler;
+
+    mjd_neom8n_scheduler_init(&scheduler, &config);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_START_TYPE_COLD, mjd_neom8n_scheduler_estimate_start_type(&scheduler, 0));
+
+    scheduler.has_last_fix = true;
+    scheduler.last_fix_us = 1000 * SIM_SEC;
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_START_TYPE_HOT, mjd_neom8n_scheduler_estimate_start_type(&scheduler, (1000 + 3600) * SIM_SEC));
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_START_TYPE_WARM, mjd_neom8n_scheduler_estimate_start_type(&scheduler, (1000 + 3 * 3600) * SIM_SEC));
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_START_TYPE_COLD,
+            mjd_neom8n_scheduler_estimate_start_type(&scheduler, (1000 + 8 * 24 * 3600) * SIM_SEC));
+}
+
+static void test_backup_duty_cycle(void) {
+    mjd_neom8n_scheduler_config_t config = MJD_NEOM8N_SCHEDULER_CONFIG_DEFAULT();
+    mjd_neom8n_scheduler_t scheduler;
+    sim_receiver_t sim;
+
+    // 1 fix every 5 minutes for 30 minutes
+    config.fix_interval_ms = 300000;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_neom8n_scheduler_init(&scheduler, &config));
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_SCHEDULER_MODE_BACKUP, scheduler.mode);
+    _sim_init(&sim);
+
+    // The first start is a cold start; then backup mode until t=300s (not 300s after the fix)
+    _run(&scheduler, &sim, 0, 36);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_SCHEDULER_STATE_SLEEPING, scheduler.state);
+    MJD_TEST_ASSERT_EQUAL_INT(SIM_TTFF_COLD_MS, scheduler.stats.ttff_last_ms);
+    MJD_TEST_ASSERT_EQUAL_INT(300000 - SIM_TTFF_COLD_MS, sim.last_power_down_ms);
+    MJD_TEST_ASSERT(sim.is_on == false);
+
+    _run(&scheduler, &sim, 36, 1800);
+    MJD_TEST_ASSERT_EQUAL_INT(6, scheduler.stats.nbr_of_wakeups);
+    MJD_TEST_ASSERT_EQUAL_INT(6, scheduler.stats.nbr_of_fixes);
+    MJD_TEST_ASSERT_EQUAL_INT(0, scheduler.stats.nbr_of_timeouts);
+    MJD_TEST_ASSERT_EQUAL_INT(1, scheduler.stats.nbr_of_starts[MJD_NEOM8N_START_TYPE_COLD]);
+    MJD_TEST_ASSERT_EQUAL_INT(5, scheduler.stats.nbr_of_starts[MJD_NEOM8N_START_TYPE_HOT]);
+    MJD_TEST_ASSERT_EQUAL_INT(SIM_TTFF_HOT_MS, scheduler.stats.ttff_min_ms);
+    MJD_TEST_ASSERT_EQUAL_INT(SIM_TTFF_COLD_MS, scheduler.stats.ttff_max_ms);
+    MJD_TEST_ASSERT_EQUAL_INT(SIM_TTFF_HOT_MS, scheduler.stats.ttff_last_ms);
+    MJD_TEST_ASSERT_EQUAL_INT(SIM_TTFF_COLD_MS + 5 * SIM_TTFF_HOT_MS, scheduler.stats.ttff_sum_ms);
+    MJD_TEST_ASSERT_EQUAL_INT(6, sim.nbr_of_power_downs);
+    // A hot start is never aided
+    MJD_TEST_ASSERT_EQUAL_INT(0, sim.nbr_of_aidings);
+
+    // The receiver is on 45s out of 1799s
+    MJD_TEST_ASSERT_EQUAL_INT(SIM_TTFF_COLD_MS + 5 * SIM_TTFF_HOT_MS, scheduler.stats.time_on_ms);
+    MJD_TEST_ASSERT_EQUAL_INT(1799000, scheduler.stats.time_on_ms + scheduler.stats.time_backup_ms);
+}
+
+static void test_warm_start_aided(void) {
+    mjd_neom8n_scheduler_config_t config = MJD_NEOM8N_SCHEDULER_CONFIG_DEFAULT();
+    mjd_neom8n_scheduler_t scheduler;
+    mjd_neom8n_scheduler_action_t action;
+    sim_receiver_t sim;
+
+    // 1 fix every 6 hours: the ephemeris has expired at every wakeup
+    config.fix_interval_ms = 6 * 60 * 60 * 1000;
+    mjd_neom8n_scheduler_init(&scheduler, &config);
+    _sim_init(&sim);
+
+    _run(&scheduler, &sim, 0, 60);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_SCHEDULER_STATE_SLEEPING, scheduler.state);
+    MJD_TEST_ASSERT(scheduler.has_last_fix == true);
+
+    // The wakeup requests aiding with the last fix
+    int64_t wakeup_us = 6 * 60 * 60 * SIM_SEC;
+    _sim_advance(&sim, wakeup_us);
+    mjd_neom8n_scheduler_step(&scheduler, wakeup_us, &sim.data, &action);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_SCHEDULER_ACTION_POWER_UP, action.type);
+    MJD_TEST_ASSERT(action.is_aiding_requested == true);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.00001, 50.8798, action.aiding_latitude);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.00001, 4.7005, action.aiding_longitude);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 31.5, action.aiding_altitude_m);
+    _sim_execute(&sim, wakeup_us, &action);
+
+    _run(&scheduler, &sim, wakeup_us / SIM_SEC + 1, wakeup_us / SIM_SEC + 60);
+    MJD_TEST_ASSERT_EQUAL_INT(1, scheduler.stats.nbr_of_starts[MJD_NEOM8N_START_TYPE_WARM]);
+    MJD_TEST_ASSERT_EQUAL_INT(SIM_TTFF_WARM_AIDED_MS, scheduler.stats.ttff_last_ms);
+    MJD_TEST_ASSERT_EQUAL_INT(1, sim.nbr_of_aidings);
+}
+
+static void test_power_save_mode(void) {
+    mjd_neom8n_scheduler_config_t config = MJD_NEOM8N_SCHEDULER_CONFIG_DEFAULT();
+    mjd_neom8n_scheduler_t scheduler;
+    sim_receiver_t sim;
+
+    config.fix_interval_ms = 60000;
+    mjd_neom8n_scheduler_init(&scheduler, &config);
+    _sim_init(&sim);
+
+    // The power save mode is enabled after the first fix, once
+    _run(&scheduler, &sim, 0, 600);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_SCHEDULER_STATE_TRACKING, scheduler.state);
+    MJD_TEST_ASSERT(sim.is_power_save == true);
+    MJD_TEST_ASSERT_EQUAL_INT(60000, sim.power_save_update_period_ms);
+    MJD_TEST_ASSERT_EQUAL_INT(1, scheduler.stats.nbr_of_wakeups);
+    MJD_TEST_ASSERT_EQUAL_INT(0, sim.nbr_of_power_downs);
+    // The last fix follows the receiver
+    MJD_TEST_ASSERT_EQUAL_INT(599 * SIM_SEC, scheduler.last_fix_us);
+    MJD_TEST_ASSERT_EQUAL_INT(599000, scheduler.stats.time_on_ms);
+}
+
+static void test_continuous_mode(void) {
+    mjd_neom8n_scheduler_config_t config = MJD_NEOM8N_SCHEDULER_CONFIG_DEFAULT();
+    mjd_neom8n_scheduler_t scheduler;
+    sim_receiver_t sim;
+
+    config.fix_interval_ms = 1000;
+    mjd_neom8n_scheduler_init(&scheduler, &config);
+    _sim_init(&sim);
+
+    _run(&scheduler, &sim, 0, 120);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_SCHEDULER_STATE_TRACKING, scheduler.state);
+    MJD_TEST_ASSERT(sim.is_power_save == false);
+    MJD_TEST_ASSERT_EQUAL_INT(1, scheduler.stats.nbr_of_fixes);
+    MJD_TEST_ASSERT_EQUAL_INT(0, sim.nbr_of_power_downs);
+}
+
+static void test_timeout_without_sky_view(void) {
+    mjd_neom8n_scheduler_config_t config = MJD_NEOM8N_SCHEDULER_CONFIG_DEFAULT();
+    mjd_neom8n_scheduler_t scheduler;
+    sim_receiver_t sim;
+
+    config.fix_interval_ms = 300000;
+    mjd_neom8n_scheduler_init(&scheduler, &config);
+    _sim_init(&sim);
+    sim.has_sky_view = false;
+
+    // No fix within 90s: sleep until the next interval instead of draining the battery
+    _run(&scheduler, &sim, 0, 91);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_SCHEDULER_STATE_SLEEPING, scheduler.state);
+    MJD_TEST_ASSERT_EQUAL_INT(1, scheduler.stats.nbr_of_timeouts);
+    MJD_TEST_ASSERT_EQUAL_INT(0, scheduler.stats.nbr_of_fixes);
+    MJD_TEST_ASSERT_EQUAL_INT(210000, sim.last_power_down_ms);
+
+    // Outdoors again: the next wakeup is still a cold start (no fix yet, nothing to aid with)
+    sim.has_sky_view = true;
+    _run(&scheduler, &sim, 91, 400);
+    MJD_TEST_ASSERT_EQUAL_INT(2, scheduler.stats.nbr_of_wakeups);
+    MJD_TEST_ASSERT_EQUAL_INT(2, scheduler.stats.nbr_of_starts[MJD_NEOM8N_START_TYPE_COLD]);
+    MJD_TEST_ASSERT_EQUAL_INT(1, scheduler.stats.nbr_of_fixes);
+    MJD_TEST_ASSERT_EQUAL_INT(SIM_TTFF_COLD_MS, scheduler.stats.ttff_last_ms);
+    MJD_TEST_ASSERT_EQUAL_INT(0, sim.nbr_of_aidings);
+}
+
+static void test_stale_fix_is_ignored(void) {
+    mjd_neom8n_scheduler_config_t config = MJD_NEOM8N_SCHEDULER_CONFIG_DEFAULT();
+    mjd_neom8n_scheduler_t scheduler;
+    mjd_neom8n_scheduler_action_t action;
+    mjd_neom8n_data_t data;
+
+    // The data struct still holds the fix of before the wakeup: only a change of fix_counter is a fresh fix
+    mjd_neom8n_scheduler_init(&scheduler, &config);
+    memset(&data, 0, sizeof(data));
+    data.fix_quality = 1;
+    data.fix_counter = 42;
+
+    mjd_neom8n_scheduler_step(&scheduler, 0, &data, &action);
+    mjd_neom8n_scheduler_step(&scheduler, 10 * SIM_SEC, &data, &action);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_SCHEDULER_STATE_ACQUIRING, scheduler.state);
+    MJD_TEST_ASSERT_EQUAL_INT(0, scheduler.stats.nbr_of_fixes);
+
+    data.fix_counter++;
+    mjd_neom8n_scheduler_step(&scheduler, 11 * SIM_SEC, &data, &action);
+    MJD_TEST_ASSERT_EQUAL_INT(1, scheduler.stats.nbr_of_fixes);
+    MJD_TEST_ASSERT_EQUAL_INT(11000, scheduler.stats.ttff_last_ms);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_SCHEDULER_ACTION_POWER_DOWN, action.type);
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_select_mode);
+    MJD_TEST_RUN(test_init_invalid_args);
+    MJD_TEST_RUN(test_estimate_start_type);
+    MJD_TEST_RUN(test_backup_duty_cycle);
+    MJD_TEST_RUN(test_warm_start_aided);
+    MJD_TEST_RUN(test_power_save_mode);
+    MJD_TEST_RUN(test_continuous_mode);
+    MJD_TEST_RUN(test_timeout_without_sky_view);
+    MJD_TEST_RUN(test_stale_fix_is_ignored);
+    return MJD_TEST_REPORT();
+}
@@ -0,0 +1,308 @@
+/*
+ * HOST TEST: mjd_neom8n UBX message builder + decoders (UBX binary mode)
+ */
+#include "mjd.h"
+#include "mjd_neom8n.h"
+#include "mjd_neom8n_parser.h"
+#include "mjd_neom8n_ubx.h"
+
+#include "mjd_test.h"
+
+static void _init_data(mjd_neom8n_data_t* ptr_data) {
+    ptr_data->data_received = false;
+    ptr_data->fix_quality = -1;
+    ptr_data->latitude = NAN;
+    ptr_data->longitude = NAN;
+    ptr_data->satellites_tracked = -1;
+    ptr_data->altitude_m = NAN;
+    ptr_data->ground_speed_kmh = NAN;
+    ptr_data->horizontal_accuracy_m = NAN;
+    ptr_data->satellites_visible = -1;
+    ptr_data->cno_mean_dbhz = -1;
+    ptr_data->fix_counter = 0;
+}
+
+static void test_build_cfg_rate(void) {
+    // The hard-coded frames of mjd_neom8n_set_measurement_rate_1000ms/100ms/5000ms()
+    const uint8_t rate_1000ms[] = { 0xB5, 0x62, 0x06, 0x08, 0x06, 0x00, 0xE8, 0x03, 0x01, 0x00, 0x01, 0x00, 0x01, 0x39 };
+    const uint8_t rate_100ms[] = { 0xB5, 0x62, 0x06, 0x08, 0x06, 0x00, 0x64, 0x00, 0x01, 0x00, 0x01, 0x00, 0x7A, 0x12 };
+    const uint8_t rate_5000ms[] = { 0xB5, 0x62, 0x06, 0x08, 0x06, 0x00, 0x88, 0x13, 0x01, 0x00, 0x01, 0x00, 0xB1, 0x49 };
+    uint8_t frame[32];
+    size_t len;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_neom8n_ubx_build_cfg_rate(1000, frame, sizeof(frame), &len));
+    MJD_TEST_ASSERT_EQUAL_INT(sizeof(rate_1000ms), len);
+    MJD_TEST_ASSERT_EQUAL_MEMORY(rate_1000ms, frame, len);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_neom8n_ubx_build_cfg_rate(100, frame, sizeof(frame), &len));
+    MJD_TEST_ASSERT_EQUAL_MEMORY(rate_100ms, frame, len);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_neom8n_ubx_build_cfg_rate(5000, frame, sizeof(frame), &len));
+    MJD_TEST_ASSERT_EQUAL_MEMORY(rate_5000ms, frame, len);
+}
+
+static void test_build_frame(void) {
+    // The hard-coded UBX-CFG-RST GNSS stop frame of mjd_neom8n_gnss_stop()
+    const uint8_t gnss_stop[] = { 0xB5, 0x62, 0x06, 0x04, 0x04, 0x00, 0x00, 0x00, 0x08, 0x00, 0x16, 0x74 };
+    const uint8_t gnss_stop_payload[] = { 0x00, 0x00, 0x08, 0x00 };
+    // A poll request (no payload)
+    const uint8_t poll_nav_pvt[] = { 0xB5, 0x62, 0x01, 0x07, 0x00, 0x00, 0x08, 0x19 };
+    uint8_t frame[32];
+    size_t len;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK,
+            mjd_neom8n_ubx_build_frame(0x06, 0x04, gnss_stop_payload, sizeof(gnss_stop_payload), frame, sizeof(frame), &len));
+    MJD_TEST_ASSERT_EQUAL_INT(sizeof(gnss_stop), len);
+    MJD_TEST_ASSERT_EQUAL_MEMORY(gnss_stop, frame, len);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK,
+            mjd_neom8n_ubx_build_frame(MJD_NEOM8N_UBX_CLASS_NAV, MJD_NEOM8N_UBX_ID_NAV_PVT, NULL, 0, frame, sizeof(frame), &len));
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_UBX_FRAME_OVERHEAD, len);
+    MJD_TEST_ASSERT_EQUAL_MEMORY(poll_nav_pvt, frame, len);
+
+    // Errors
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE,
+            mjd_neom8n_ubx_build_frame(0x06, 0x04, gnss_stop_payload, sizeof(gnss_stop_payload), frame, sizeof(gnss_stop) - 1, &len));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_neom8n_ubx_build_frame(0x06, 0x04, NULL, 4, frame, sizeof(frame), &len));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_neom8n_ubx_build_frame(0x06, 0x04, NULL, 0, NULL, sizeof(frame), &len));
+}
+
+static void test_build_cfg_msg_and_prt(void) {
+    // NMEA GGA off
+    const uint8_t gga_off[] = { 0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0xF0, 0x00, 0x00, 0xFA, 0x0F };
+    // UART1 8N1 38400 Bd, in UBX+NMEA, out UBX
+    const uint8_t prt_38400[] = { 0xB5, 0x62, 0x06, 0x00, 0x14, 0x00, 0x01, 0x00, 0x00, 0x00, 0xD0, 0x08, 0x00, 0x00, 0x00, 0x96, 0x00, 0x00,
+            0x03, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x8D, 0x64 };
+    uint8_t frame[32];
+    size_t len;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_neom8n_ubx_build_cfg_msg(MJD_NEOM8N_UBX_CLASS_NMEA, 0x00, 0, frame, sizeof(frame), &len));
+    MJD_TEST_ASSERT_EQUAL_INT(sizeof(gga_off), len);
+    MJD_TEST_ASSERT_EQUAL_MEMORY(gga_off, frame, len);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK,
+            mjd_neom8n_ubx_build_cfg_prt_uart(38400, MJD_NEOM8N_UBX_PROTO_MASK_UBX | MJD_NEOM8N_UBX_PROTO_MASK_NMEA,
+                    MJD_NEOM8N_UBX_PROTO_MASK_UBX, frame, sizeof(frame), &len));
+    MJD_TEST_ASSERT_EQUAL_INT(sizeof(prt_38400), len);
+    MJD_TEST_ASSERT_EQUAL_MEMORY(prt_38400, frame, len);
+}
+
+static void test_parse_ack(void) {
+    const uint8_t ack_payload[] = { MJD_NEOM8N_UBX_CLASS_CFG, MJD_NEOM8N_UBX_ID_CFG_RATE };
+    mjd_neom8n_parser_t parser;
+    mjd_neom8n_parser_stats_t stats;
+    mjd_neom8n_data_t data;
+    uint8_t frame[32];
+    size_t len;
+
+    _init_data(&data);
+    mjd_neom8n_parser_init(&parser);
+
+    // An ACK does not update the position data
+    mjd_neom8n_ubx_build_frame(MJD_NEOM8N_UBX_CLASS_ACK, MJD_NEOM8N_UBX_ID_ACK_ACK, ack_payload, sizeof(ack_payload), frame, sizeof(frame), &len);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_NOT_FOUND, mjd_neom8n_parser_feed(&parser, frame, len, &data));
+    mjd_neom8n_parser_get_stats(&parser, &stats);
+    MJD_TEST_ASSERT_EQUAL_INT(1, stats.nbr_of_ubx_acks);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_UBX_CLASS_CFG, parser.last_ack.msg_class);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_UBX_ID_CFG_RATE, parser.last_ack.msg_id);
+    MJD_TEST_ASSERT(parser.last_ack.is_ack);
+
+    // NAK, split over 2 chunks (staged)
+    mjd_neom8n_ubx_build_frame(MJD_NEOM8N_UBX_CLASS_ACK, MJD_NEOM8N_UBX_ID_ACK_NAK, ack_payload, sizeof(ack_payload), frame, sizeof(frame), &len);
+    mjd_neom8n_parser_feed(&parser, frame, 7, &data);
+    mjd_neom8n_parser_feed(&parser, frame + 7, len - 7, &data);
+    mjd_neom8n_parser_get_stats(&parser, &stats);
+    MJD_TEST_ASSERT_EQUAL_INT(2, stats.nbr_of_ubx_acks);
+    MJD_TEST_ASSERT(!parser.last_ack.is_ack);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_UBX_ID_CFG_RATE, parser.last_ack.msg_id);
+
+    // Decoder errors
+    mjd_neom8n_ubx_ack_t ack;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, mjd_neom8n_ubx_decode_ack(MJD_NEOM8N_UBX_ID_ACK_ACK, ack_payload, 1, &ack));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, mjd_neom8n_ubx_decode_ack(0x02, ack_payload, sizeof(ack_payload), &ack));
+}
+
+static void test_parse_nav_sat(void) {
+    // UBX-NAV-SAT: 40 SV's of which 12 used in the navigation solution (C/N0 30..41 dBHz)
+    static uint8_t payload[MJD_NEOM8N_UBX_NAV_SAT_HEADER_LENGTH + 40 * MJD_NEOM8N_UBX_NAV_SAT_BLOCK_LENGTH];
+    static uint8_t frame[sizeof(payload) + MJD_NEOM8N_UBX_FRAME_OVERHEAD];
+    mjd_neom8n_parser_t parser;
+    mjd_neom8n_parser_stats_t stats;
+    mjd_neom8n_data_t data;
+    size_t len;
+    uint32_t cno_sum = 0;
+
+    memset(payload, 0, sizeof(payload));
+    payload[4] = 1; // version
+    payload[5] = 40; // numSvs
+    for (uint32_t sv = 0; sv < 40; sv++) {
+        uint8_t *ptr_block = &payload[MJD_NEOM8N_UBX_NAV_SAT_HEADER_LENGTH + sv * MJD_NEOM8N_UBX_NAV_SAT_BLOCK_LENGTH];
+        ptr_block[1] = (uint8_t) (sv + 1); // svId
+        ptr_block[2] = (uint8_t) (sv < 12 ? 30 + sv : 12); // cno
+        ptr_block[8] = (sv < 12) ? 0x0F : 0x01; // flags: qualityInd + svUsed
+        if (sv < 12) {
+            cno_sum += ptr_block[2];
+        }
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK,
+            mjd_neom8n_ubx_build_frame(MJD_NEOM8N_UBX_CLASS_NAV, MJD_NEOM8N_UBX_ID_NAV_SAT, payload, sizeof(payload), frame, sizeof(frame),
+                    &len));
+
+    _init_data(&data);
+    mjd_neom8n_parser_init(&parser);
+    // @doc Fed in chunks of 33 bytes: the SV blocks straddle the chunks (NAV-SAT is summarized on the fly, never staged)
+    for (size_t offset = 0; offset < len; offset += 33) {
+        mjd_neom8n_parser_feed(&parser, frame + offset, (len - offset < 33) ? (len - offset) : 33, &data);
+    }
+    mjd_neom8n_parser_get_stats(&parser, &stats);
+
+    MJD_TEST_ASSERT_EQUAL_INT(1, stats.nbr_of_ubx_nav_sat);
+    MJD_TEST_ASSERT_EQUAL_INT(0, stats.nbr_of_ubx_checksum_errors);
+    MJD_TEST_ASSERT_EQUAL_INT(40, data.satellites_visible);
+    MJD_TEST_ASSERT_EQUAL_INT(cno_sum / 12, data.cno_mean_dbhz);
+    // NAV-SAT does not touch the position
+    MJD_TEST_ASSERT(isnan(data.latitude));
+}
+
+static void test_parse_nav_pvt_round_trip(void) {
+    uint8_t payload[MJD_NEOM8N_UBX_NAV_PVT_PAYLOAD_LENGTH] = { 0 };
+    uint8_t frame[sizeof(payload) + MJD_NEOM8N_UBX_FRAME_OVERHEAD];
+    mjd_neom8n_parser_t parser;
+    mjd_neom8n_data_t data;
+    size_t len;
+
+    // 3D fix, 14 SV's, lon 4.7005 lat 50.8798 (Leuven), hMSL 31.5m, hAcc 1.8m, gSpeed 2500 mm/s
+    const int32_t lon = 47005000, lat = 508798000, h_msl = 31500;
+    const uint32_t h_acc = 1800;
+    const int32_t g_speed = 2500;
+    payload[20] = 3;
+    payload[21] = 0x01;
+    payload[23] = 14;
+    memcpy(&payload[24], &lon, 4);
+    memcpy(&payload[28], &lat, 4);
+    memcpy(&payload[36], &h_msl, 4);
+    memcpy(&payload[40], &h_acc, 4);
+    memcpy(&payload[60], &g_speed, 4);
+    mjd_neom8n_ubx_build_frame(MJD_NEOM8N_UBX_CLASS_NAV, MJD_NEOM8N_UBX_ID_NAV_PVT, payload, sizeof(payload), frame, sizeof(frame), &len);
+
+    _init_data(&data);
+    mjd_neom8n_parser_init(&parser);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_neom8n_parser_feed(&parser, frame, len, &data));
+    MJD_TEST_ASSERT_EQUAL_INT(1, data.fix_quality);
+    MJD_TEST_ASSERT_EQUAL_INT(14, data.satellites_tracked);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.000001, 4.7005, data.longitude);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.00001, 50.8798, data.latitude);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 31.5, data.altitude_m);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 1.8, data.horizontal_accuracy_m);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.001, 9.0, data.ground_speed_kmh);
+    MJD_TEST_ASSERT_EQUAL_INT(1, data.fix_counter);
+
+    // No fix (gnssFixOK clear): the fix counter does not change
+    payload[21] = 0x00;
+    mjd_neom8n_ubx_build_frame(MJD_NEOM8N_UBX_CLASS_NAV, MJD_NEOM8N_UBX_ID_NAV_PVT, payload, sizeof(payload), frame, sizeof(frame), &len);
+    mjd_neom8n_parser_feed(&parser, frame, len, &data);
+    MJD_TEST_ASSERT_EQUAL_INT(0, data.fix_quality);
+    MJD_TEST_ASSERT_EQUAL_INT(1, data.fix_counter);
+}
+
+static void test_build_power_management(void) {
+    // The hard-coded UBX-RXM-PMREQ frames of mjd_neom8n_power_down_for_15_seconds() and mjd_neom8n_power_down()
+    const uint8_t pmreq_15s[] = { 0xB5, 0x62, 0x02, 0x41, 0x08, 0x00, 0x98, 0x3A, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x1F, 0x91 };
+    const uint8_t pmreq_infinite[] = { 0xB5, 0x62, 0x02, 0x41, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x4D, 0x3B };
+    const uint8_t rxm_power_save[] = { 0xB5, 0x62, 0x06, 0x11, 0x02, 0x00, 0x08, 0x01, 0x22, 0x92 };
+    uint8_t frame[64];
+    size_t len;
+    uint32_t value;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_neom8n_ubx_build_rxm_pmreq(15000, frame, sizeof(frame), &len));
+    MJD_TEST_ASSERT_EQUAL_INT(sizeof(pmreq_15s), len);
+    MJD_TEST_ASSERT_EQUAL_MEMORY(pmreq_15s, frame, len);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_neom8n_ubx_build_rxm_pmreq(0, frame, sizeof(frame), &len));
+    MJD_TEST_ASSERT_EQUAL_MEMORY(pmreq_infinite, frame, len);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_neom8n_ubx_build_cfg_rxm(true, frame, sizeof(frame), &len));
+    MJD_TEST_ASSERT_EQUAL_INT(sizeof(rxm_power_save), len);
+    MJD_TEST_ASSERT_EQUAL_MEMORY(rxm_power_save, frame, len);
+
+    // UBX-CFG-PM2: 60s = ON/OFF operation, 5s = cyclic tracking
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_neom8n_ubx_build_cfg_pm2(60000, 10000, frame, sizeof(frame), &len));
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_UBX_CFG_PM2_PAYLOAD_LENGTH + MJD_NEOM8N_UBX_FRAME_OVERHEAD, len);
+    MJD_TEST_ASSERT_EQUAL_INT(0x01, frame[6]);
+    memcpy(&value, &frame[6 + 4], 4);
+    MJD_TEST_ASSERT_EQUAL_INT(1 << 12, value);
+    memcpy(&value, &frame[6 + 8], 4);
+    MJD_TEST_ASSERT_EQUAL_INT(60000, value);
+    memcpy(&value, &frame[6 + 12], 4);
+    MJD_TEST_ASSERT_EQUAL_INT(10000, value);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_neom8n_ubx_build_cfg_pm2(5000, 10000, frame, sizeof(frame), &len));
+    memcpy(&value, &frame[6 + 4], 4);
+    MJD_TEST_ASSERT_EQUAL_INT((1 << 12) | (1 << 17), value);
+
+    // The buffer must hold the whole frame
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, mjd_neom8n_ubx_build_cfg_pm2(60000, 10000, frame, 32, &len));
+}
+
+static void test_build_mga_ini(void) {
+    uint8_t frame[64];
+    size_t len;
+    int32_t value;
+    uint32_t accuracy;
+
+    // Leuven, 31.5m, 10km
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_neom8n_ubx_build_mga_ini_pos_llh(50.8798, 4.7005, 31.5, 10000, frame, sizeof(frame), &len));
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_UBX_MGA_INI_POS_LLH_PAYLOAD_LENGTH + MJD_NEOM8N_UBX_FRAME_OVERHEAD, len);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_UBX_CLASS_MGA, frame[2]);
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_UBX_ID_MGA_INI, frame[3]);
+    MJD_TEST_ASSERT_EQUAL_INT(0x01, frame[6]);
+    memcpy(&value, &frame[6 + 4], 4);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(50, 508798000, value); // float precision
+    memcpy(&value, &frame[6 + 8], 4);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(5, 47005000, value);
+    memcpy(&value, &frame[6 + 12], 4);
+    MJD_TEST_ASSERT_EQUAL_INT(3150, value);
+    memcpy(&accuracy, &frame[6 + 16], 4);
+    MJD_TEST_ASSERT_EQUAL_INT(1000000, accuracy);
+
+    // 2019-03-14 15:09:26 UTC
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_neom8n_ubx_build_mga_ini_time_utc(1552576166, 10, frame, sizeof(frame), &len));
+    MJD_TEST_ASSERT_EQUAL_INT(MJD_NEOM8N_UBX_MGA_INI_TIME_UTC_PAYLOAD_LENGTH + MJD_NEOM8N_UBX_FRAME_OVERHEAD, len);
+    MJD_TEST_ASSERT_EQUAL_INT(0x10, frame[6]);
+    MJD_TEST_ASSERT_EQUAL_INT(2019, frame[6 + 4] | (frame[6 + 5] << 8));
+    MJD_TEST_ASSERT_EQUAL_INT(3, frame[6 + 6]);
+    MJD_TEST_ASSERT_EQUAL_INT(14, frame[6 + 7]);
+    MJD_TEST_ASSERT_EQUAL_INT(15, frame[6 + 8]);
+    MJD_TEST_ASSERT_EQUAL_INT(9, frame[6 + 9]);
+    MJD_TEST_ASSERT_EQUAL_INT(26, frame[6 + 10]);
+    MJD_TEST_ASSERT_EQUAL_INT(10, frame[6 + 16] | (frame[6 + 17] << 8));
+}
+
+static void test_mode_bandwidth(void) {
+    mjd_neom8n_ubx_mode_t mode = MJD_NEOM8N_UBX_MODE_DEFAULT();
+
+    // UBX-NAV-PVT at 10Hz
+    MJD_TEST_ASSERT_EQUAL_INT(1000, mjd_neom8n_ubx_get_mode_bytes_per_second(&mode));
+
+    // + UBX-NAV-SAT at 1Hz (estimate 32 SV's: 16 + 12 * 32 = 400 bytes)
+    mode.nav_sat_rate = 10;
+    MJD_TEST_ASSERT_EQUAL_INT(1400, mjd_neom8n_ubx_get_mode_bytes_per_second(&mode));
+
+    // 1Hz both
+    mode.measurement_period_ms = 1000;
+    mode.nav_sat_rate = 1;
+    MJD_TEST_ASSERT_EQUAL_INT(500, mjd_neom8n_ubx_get_mode_bytes_per_second(&mode));
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_build_cfg_rate);
+    MJD_TEST_RUN(test_build_frame);
+    MJD_TEST_RUN(test_build_cfg_msg_and_prt);
+    MJD_TEST_RUN(test_parse_ack);
+    MJD_TEST_RUN(test_parse_nav_sat);
+    MJD_TEST_RUN(test_parse_nav_pvt_round_trip);
+    MJD_TEST_RUN(test_mode_bandwidth);
+    MJD_TEST_RUN(test_build_power_management);
+    MJD_TEST_RUN(test_build_mga_ini);
+    return MJD_TEST_REPORT();
+}
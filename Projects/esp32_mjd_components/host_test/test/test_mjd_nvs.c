@@ -0,0 +1,198 @@
+/*
+ * HOST TEST: mjd_nvs write-coalescing cache (against the NVS emulator of the shims)
+ */
+#include "mjd.h"
+#include "mjd_nvs.h"
+
+#include "mjd_host.h"
+#include "mjd_test.h"
+
+static mjd_nvs_config_t _config(uint32_t param_commit_interval_ms, uint32_t param_max_dirty_keys) {
+    mjd_nvs_config_t config = MJD_NVS_CONFIG_DEFAULT();
+    config.namespace_name = "test";
+    config.commit_interval_ms = param_commit_interval_ms;
+    config.max_dirty_keys = param_max_dirty_keys;
+    return config;
+}
+
+static void test_typed_roundtrip_and_reload(void) {
+    mjd_nvs_t nvs;
+    mjd_nvs_config_t config = _config(0, 8);
+    uint8_t u8 = 0;
+    int32_t i32 = 0;
+    uint32_t u32 = 0;
+    int64_t i64 = 0;
+    float f = 0;
+    char str[MJD_NVS_STR_MAX_LEN + 1];
+
+    MJD_TEST_ASSERT(mjd_nvs_init(&nvs, &config) == ESP_ERR_NVS_NOT_INITIALIZED);
+    MJD_TEST_ASSERT(nvs_flash_init() == ESP_OK);
+    MJD_TEST_ASSERT(mjd_nvs_init(&nvs, &config) == ESP_OK);
+
+    MJD_TEST_ASSERT(mjd_nvs_get_u32(&nvs, "boots", &u32) == ESP_ERR_NVS_NOT_FOUND);
+    MJD_TEST_ASSERT(mjd_nvs_set_u8(&nvs, "mode", 3) == ESP_OK);
+    MJD_TEST_ASSERT(mjd_nvs_set_i32(&nvs, "offset", -1234) == ESP_OK);
+    MJD_TEST_ASSERT(mjd_nvs_set_u32(&nvs, "boots", 42) == ESP_OK);
+    MJD_TEST_ASSERT(mjd_nvs_set_i64(&nvs, "last_sync", 1546300800000LL) == ESP_OK);
+    MJD_TEST_ASSERT(mjd_nvs_set_float(&nvs, "calib", 1.0625f) == ESP_OK);
+    MJD_TEST_ASSERT(mjd_nvs_set_str(&nvs, "ssid", "MjdWiFi") == ESP_OK);
+    MJD_TEST_ASSERT(mjd_nvs_set_str(&nvs, "too_long", "0123456789012345678901234567890123456789") == ESP_ERR_NVS_VALUE_TOO_LONG);
+    MJD_TEST_ASSERT(mjd_nvs_set_u32(&nvs, "a_key_longer_than_15", 1) == ESP_ERR_INVALID_ARG);
+
+    // Served from RAM: nothing was written yet
+    MJD_TEST_ASSERT_EQUAL_UINT(0, mjd_host_nvs_get_nbr_of_entries_written());
+    MJD_TEST_ASSERT(mjd_nvs_get_u32(&nvs, "boots", &u32) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(42, u32);
+    MJD_TEST_ASSERT(mjd_nvs_get_i32(&nvs, "boots", &i32) == ESP_ERR_NVS_TYPE_MISMATCH);
+    MJD_TEST_ASSERT(mjd_nvs_get_str(&nvs, "ssid", str, 4) == ESP_ERR_NVS_INVALID_LENGTH);
+
+    // Reload from flash
+    MJD_TEST_ASSERT(mjd_nvs_deinit(&nvs) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, mjd_host_nvs_get_nbr_of_commits());
+    MJD_TEST_ASSERT_EQUAL_UINT(7, mjd_host_nvs_get_nbr_of_entries_written()); // 5 integers + a string (2 entries)
+    MJD_TEST_ASSERT(mjd_nvs_init(&nvs, &config) == ESP_OK);
+
+    MJD_TEST_ASSERT(mjd_nvs_get_u8(&nvs, "mode", &u8) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(3, u8);
+    MJD_TEST_ASSERT(mjd_nvs_get_i32(&nvs, "offset", &i32) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_INT(-1234, i32);
+    MJD_TEST_ASSERT(mjd_nvs_get_u32(&nvs, "boots", &u32) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(42, u32);
+    MJD_TEST_ASSERT(mjd_nvs_get_i64(&nvs, "last_sync", &i64) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_INT(1546300800000LL, i64);
+    MJD_TEST_ASSERT(mjd_nvs_get_float(&nvs, "calib", &f) == ESP_OK);
+    MJD_TEST_ASSERT(f == 1.0625f);
+    MJD_TEST_ASSERT(mjd_nvs_get_str(&nvs, "ssid", str, sizeof(str)) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_STRING("MjdWiFi", str);
+
+    // Erase
+    MJD_TEST_ASSERT(mjd_nvs_erase_key(&nvs, "ssid") == ESP_OK);
+    MJD_TEST_ASSERT(mjd_nvs_get_str(&nvs, "ssid", str, sizeof(str)) == ESP_ERR_NVS_NOT_FOUND);
+    MJD_TEST_ASSERT(mjd_nvs_deinit(&nvs) == ESP_OK);
+    MJD_TEST_ASSERT(mjd_nvs_init(&nvs, &config) == ESP_OK);
+    MJD_TEST_ASSERT(mjd_nvs_get_str(&nvs, "ssid", str, sizeof(str)) == ESP_ERR_NVS_NOT_FOUND);
+    MJD_TEST_ASSERT(mjd_nvs_deinit(&nvs) == ESP_OK);
+}
+
+static void test_coalescing(void) {
+    mjd_nvs_t nvs;
+    mjd_nvs_config_t config = _config(0, 8);
+    mjd_nvs_stats_t stats;
+
+    MJD_TEST_ASSERT(nvs_flash_init() == ESP_OK);
+    MJD_TEST_ASSERT(mjd_nvs_init(&nvs, &config) == ESP_OK);
+
+    // A counter that is updated every second, and a setting that is written with the same value again and again
+    for (uint32_t idx = 1; idx <= 1000; idx++) {
+        MJD_TEST_ASSERT(mjd_nvs_set_u32(&nvs, "uptime_s", idx) == ESP_OK);
+        MJD_TEST_ASSERT(mjd_nvs_set_u8(&nvs, "mode", 2) == ESP_OK);
+    }
+    MJD_TEST_ASSERT(mjd_nvs_commit(&nvs) == ESP_OK);
+    MJD_TEST_ASSERT(mjd_nvs_commit(&nvs) == ESP_OK); // Nothing dirty: no commit
+
+    mjd_nvs_get_stats(&nvs, &stats);
+    MJD_TEST_ASSERT_EQUAL_UINT(2000, stats.nbr_of_sets);
+    MJD_TEST_ASSERT_EQUAL_UINT(999, stats.nbr_of_unchanged);
+    MJD_TEST_ASSERT_EQUAL_UINT(999, stats.nbr_of_coalesced);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, stats.nbr_of_flash_writes);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, stats.nbr_of_commits);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, mjd_host_nvs_get_nbr_of_entries_written());
+    MJD_TEST_ASSERT_EQUAL_UINT(1, mjd_host_nvs_get_nbr_of_commits());
+
+    // Unchanged against flash: no write
+    MJD_TEST_ASSERT(mjd_nvs_set_u8(&nvs, "mode", 2) == ESP_OK);
+    MJD_TEST_ASSERT(mjd_nvs_commit(&nvs) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, mjd_host_nvs_get_nbr_of_entries_written());
+
+    mjd_nvs_log_stats(&nvs);
+    MJD_TEST_ASSERT(mjd_nvs_deinit(&nvs) == ESP_OK);
+}
+
+static void test_dirty_and_time_thresholds(void) {
+    mjd_nvs_t nvs;
+    mjd_nvs_config_t config = _config(60000, 4);
+    mjd_nvs_stats_t stats;
+    char key[MJD_NVS_KEY_MAX_LEN + 1];
+
+    MJD_TEST_ASSERT(nvs_flash_init() == ESP_OK);
+    MJD_TEST_ASSERT(mjd_nvs_init(&nvs, &config) == ESP_OK);
+
+    // 4 dirty keys: 1 commit of 4 keys
+    for (uint32_t idx = 0; idx < 4; idx++) {
+        snprintf(key, sizeof(key), "k%u", idx);
+        MJD_TEST_ASSERT(mjd_nvs_set_i32(&nvs, key, (int32_t) idx) == ESP_OK);
+    }
+    MJD_TEST_ASSERT_EQUAL_UINT(1, mjd_host_nvs_get_nbr_of_commits());
+    MJD_TEST_ASSERT_EQUAL_UINT(4, mjd_host_nvs_get_nbr_of_entries_written());
+
+    // The time threshold counts from the first dirty set
+    MJD_TEST_ASSERT(mjd_nvs_set_i32(&nvs, "k0", 100) == ESP_OK);
+    mjd_host_advance_time_us(59 * 1000000ULL);
+    MJD_TEST_ASSERT(mjd_nvs_set_i32(&nvs, "k1", 101) == ESP_OK);
+    MJD_TEST_ASSERT(mjd_nvs_commit_if_due(&nvs) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, mjd_host_nvs_get_nbr_of_commits());
+    mjd_host_advance_time_us(1 * 1000000ULL);
+    MJD_TEST_ASSERT(mjd_nvs_commit_if_due(&nvs) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, mjd_host_nvs_get_nbr_of_commits());
+    MJD_TEST_ASSERT_EQUAL_UINT(6, mjd_host_nvs_get_nbr_of_entries_written());
+
+    // A set also checks the time threshold
+    MJD_TEST_ASSERT(mjd_nvs_set_i32(&nvs, "k2", 102) == ESP_OK);
+    mjd_host_advance_time_us(61 * 1000000ULL);
+    MJD_TEST_ASSERT(mjd_nvs_set_i32(&nvs, "k3", 103) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(3, mjd_host_nvs_get_nbr_of_commits());
+
+    mjd_nvs_get_stats(&nvs, &stats);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, stats.nbr_of_dirty);
+    MJD_TEST_ASSERT_EQUAL_UINT(8, stats.nbr_of_flash_writes);
+    MJD_TEST_ASSERT(mjd_nvs_deinit(&nvs) == ESP_OK);
+}
+
+static void test_write_error_and_eviction(void) {
+    mjd_nvs_t nvs;
+    mjd_nvs_config_t config = _config(0, CONFIG_MJD_NVS_MAX_KEYS);
+    mjd_nvs_stats_t stats;
+    char key[MJD_NVS_KEY_MAX_LEN + 1];
+    uint32_t u32 = 0;
+
+    MJD_TEST_ASSERT(nvs_flash_init() == ESP_OK);
+    MJD_TEST_ASSERT(mjd_nvs_init(&nvs, &config) == ESP_OK);
+
+    // A failed commit keeps the keys dirty
+    MJD_TEST_ASSERT(mjd_nvs_set_u32(&nvs, "a", 1) == ESP_OK);
+    MJD_TEST_ASSERT(mjd_nvs_set_u32(&nvs, "b", 2) == ESP_OK);
+    mjd_host_nvs_set_write_retval(ESP_ERR_NVS_NOT_ENOUGH_SPACE);
+    MJD_TEST_ASSERT(mjd_nvs_commit(&nvs) == ESP_ERR_NVS_NOT_ENOUGH_SPACE);
+    mjd_nvs_get_stats(&nvs, &stats);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, stats.nbr_of_dirty);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, stats.nbr_of_write_errors);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, mjd_host_nvs_get_nbr_of_commits());
+    mjd_host_nvs_set_write_retval(ESP_OK);
+    MJD_TEST_ASSERT(mjd_nvs_commit(&nvs) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, mjd_host_nvs_get_nbr_of_commits());
+
+    // More keys than entries: the clean keys are evicted and read again from flash
+    for (uint32_t idx = 0; idx < 2 * CONFIG_MJD_NVS_MAX_KEYS; idx++) {
+        snprintf(key, sizeof(key), "key%u", idx);
+        MJD_TEST_ASSERT(mjd_nvs_set_u32(&nvs, key, idx * 10) == ESP_OK);
+    }
+    for (uint32_t idx = 0; idx < 2 * CONFIG_MJD_NVS_MAX_KEYS; idx++) {
+        snprintf(key, sizeof(key), "key%u", idx);
+        MJD_TEST_ASSERT(mjd_nvs_get_u32(&nvs, key, &u32) == ESP_OK);
+        MJD_TEST_ASSERT_EQUAL_UINT(idx * 10, u32);
+    }
+    mjd_nvs_get_stats(&nvs, &stats);
+    MJD_TEST_ASSERT(stats.nbr_of_evictions > 0);
+    MJD_TEST_ASSERT_EQUAL_UINT(2 + 2 * CONFIG_MJD_NVS_MAX_KEYS, mjd_host_nvs_get_nbr_of_entries_written());
+
+    MJD_TEST_ASSERT(mjd_nvs_deinit(&nvs) == ESP_OK);
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_typed_roundtrip_and_reload);
+    MJD_TEST_RUN(test_coalescing);
+    MJD_TEST_RUN(test_dirty_and_time_thresholds);
+    MJD_TEST_RUN(test_write_error_and_eviction);
+
+    return MJD_TEST_REPORT();
+}
@@ -0,0 +1,157 @@
+/*
+ * HOST TEST: mjd_pool fixed-block pools and bump arenas
+ *
+ * @doc Built twice: test_mjd_pool (stats) and test_mjd_pool_poison (stats + CONFIG_MJD_POOL_DEBUG_POISON).
+ */
+#include "mjd.h"
+#include "mjd_pool.h"
+
+#include "linux_poison.h"
+
+#include "mjd_test.h"
+
+typedef struct {
+    uint8_t bssid[6];
+    int8_t rssi;
+    uint64_t timestamp_ms;
+} test_item_t;
+
+#define TEST_NBR_OF_BLOCKS (8)
+
+MJD_POOL_DEFINE_STORAGE(_pool_storage, sizeof(test_item_t), TEST_NBR_OF_BLOCKS);
+MJD_ARENA_DEFINE_STORAGE(_arena_storage, 100);
+
+static void test_block_size(void) {
+    MJD_TEST_ASSERT_EQUAL_UINT(MJD_POOL_ALIGNMENT, MJD_POOL_BLOCK_SIZE(1)); // Room for the free list pointer
+    MJD_TEST_ASSERT_EQUAL_UINT(8, MJD_POOL_BLOCK_SIZE(8));
+    MJD_TEST_ASSERT_EQUAL_UINT(16, MJD_POOL_BLOCK_SIZE(9));
+    MJD_TEST_ASSERT_EQUAL_UINT(16, MJD_POOL_BLOCK_SIZE(sizeof(test_item_t)));
+    MJD_TEST_ASSERT_EQUAL_UINT(16 * TEST_NBR_OF_BLOCKS, sizeof(_pool_storage));
+}
+
+static void test_pool_alloc_free(void) {
+    mjd_pool_t pool;
+    mjd_pool_stats_t stats;
+    test_item_t *items[TEST_NBR_OF_BLOCKS];
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_pool_init(&pool, "items", _pool_storage, sizeof(test_item_t), TEST_NBR_OF_BLOCKS));
+
+    for (uint32_t idx = 0; idx < TEST_NBR_OF_BLOCKS; idx++) {
+        items[idx] = mjd_pool_alloc(&pool);
+        MJD_TEST_ASSERT(items[idx] != NULL);
+        MJD_TEST_ASSERT(mjd_pool_owns(&pool, items[idx]));
+        MJD_TEST_ASSERT_EQUAL_UINT(0, (uintptr_t) items[idx] % MJD_POOL_ALIGNMENT);
+        memset(items[idx], (int) idx, sizeof(test_item_t));
+    }
+    // Exhausted
+    MJD_TEST_ASSERT(mjd_pool_alloc(&pool) == NULL);
+    // No overlap
+    for (uint32_t idx = 0; idx < TEST_NBR_OF_BLOCKS; idx++) {
+        MJD_TEST_ASSERT_EQUAL_UINT(idx, items[idx]->bssid[0]);
+        MJD_TEST_ASSERT_EQUAL_UINT(idx, ((uint8_t *) &items[idx]->timestamp_ms)[7]);
+    }
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_pool_get_stats(&pool, &stats));
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_NBR_OF_BLOCKS, stats.nbr_of_blocks);
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_NBR_OF_BLOCKS, stats.nbr_in_use);
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_NBR_OF_BLOCKS, stats.high_water_mark);
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_NBR_OF_BLOCKS, stats.nbr_of_allocs);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, stats.nbr_of_failed_allocs);
+
+    // LIFO reuse: the last freed block is allocated first
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_pool_free(&pool, items[3]));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_pool_free(&pool, items[5]));
+    MJD_TEST_ASSERT(mjd_pool_alloc(&pool) == items[5]);
+    MJD_TEST_ASSERT(mjd_pool_alloc(&pool) == items[3]);
+
+    for (uint32_t idx = 0; idx < TEST_NBR_OF_BLOCKS; idx++) {
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_pool_free(&pool, items[idx]));
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_pool_free(&pool, NULL));
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_pool_get_stats(&pool, &stats));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, stats.nbr_in_use);
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_NBR_OF_BLOCKS, stats.high_water_mark);
+    MJD_TEST_ASSERT_EQUAL_UINT(TEST_NBR_OF_BLOCKS + 2, stats.nbr_of_allocs);
+
+    mjd_pool_log_stats(&pool);
+}
+
+static void test_pool_invalid(void) {
+    mjd_pool_t pool;
+    int not_a_block;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_pool_init(&pool, "x", NULL, 8, 1));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_pool_init(&pool, "x", _pool_storage, 0, 1));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_pool_init(&pool, "x", (uint8_t *) _pool_storage + 4, 8, 1)); // Misaligned
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_pool_init(&pool, "x", _pool_storage, sizeof(test_item_t), TEST_NBR_OF_BLOCKS));
+    uint8_t *ptr_block = mjd_pool_alloc(&pool);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_pool_free(&pool, &not_a_block));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_pool_free(&pool, ptr_block + 1)); // Not the start of a block
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_pool_free(&pool, ptr_block));
+}
+
+static void test_arena(void) {
+    mjd_arena_t arena;
+    mjd_arena_stats_t stats;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_arena_init(&arena, "scratch", _arena_storage, 100));
+
+    uint8_t *ptr_a = mjd_arena_alloc(&arena, 1);
+    uint8_t *ptr_b = mjd_arena_alloc(&arena, 20);
+    MJD_TEST_ASSERT(ptr_a != NULL && ptr_b != NULL);
+    MJD_TEST_ASSERT_EQUAL_UINT(MJD_POOL_ALIGNMENT, ptr_b - ptr_a);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, (uintptr_t) ptr_b % MJD_POOL_ALIGNMENT);
+    MJD_TEST_ASSERT(mjd_arena_alloc(&arena, 0) == NULL);
+    MJD_TEST_ASSERT(mjd_arena_alloc(&arena, 100) == NULL); // Does not fit anymore
+    MJD_TEST_ASSERT(mjd_arena_alloc(&arena, SIZE_MAX) == NULL); // size_t overflow of the alignment
+    MJD_TEST_ASSERT(mjd_arena_alloc(&arena, 68) == NULL); // Rounded up to 72: 8 + 24 + 72 > 100
+    MJD_TEST_ASSERT(mjd_arena_alloc(&arena, 64) != NULL);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_arena_get_stats(&arena, &stats));
+    MJD_TEST_ASSERT_EQUAL_UINT(100, stats.size);
+    MJD_TEST_ASSERT_EQUAL_UINT(8 + 24 + 64, stats.used);
+    MJD_TEST_ASSERT_EQUAL_UINT(3, stats.nbr_of_failed_allocs);
+
+    mjd_arena_reset(&arena);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_arena_get_stats(&arena, &stats));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, stats.used);
+    MJD_TEST_ASSERT_EQUAL_UINT(8 + 24 + 64, stats.high_water_mark);
+    MJD_TEST_ASSERT(mjd_arena_alloc(&arena, 8) == ptr_a);
+
+    mjd_arena_log_stats(&arena);
+}
+
+#ifdef CONFIG_MJD_POOL_DEBUG_POISON
+static void test_poison(void) {
+    mjd_pool_t pool;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_pool_init(&pool, "poison", _pool_storage, sizeof(test_item_t), TEST_NBR_OF_BLOCKS));
+
+    uint8_t *ptr_block = mjd_pool_alloc(&pool);
+    for (size_t idx = 0; idx < MJD_POOL_BLOCK_SIZE(sizeof(test_item_t)); idx++) {
+        MJD_TEST_ASSERT_EQUAL_UINT(POISON_INUSE, ptr_block[idx]);
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_pool_free(&pool, ptr_block));
+    for (size_t idx = sizeof(void *); idx < MJD_POOL_BLOCK_SIZE(sizeof(test_item_t)); idx++) {
+        MJD_TEST_ASSERT_EQUAL_UINT(POISON_FREE, ptr_block[idx]);
+    }
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, mjd_pool_free(&pool, ptr_block)); // Double free
+    ptr_block[12] = 0x00; // Use-after-free: logged by the next alloc of this block (the alloc itself succeeds)
+    MJD_TEST_ASSERT(mjd_pool_alloc(&pool) == ptr_block);
+    MJD_TEST_ASSERT_EQUAL_UINT(POISON_INUSE, ptr_block[12]);
+}
+#endif
+
+int main(void) {
+    MJD_TEST_RUN(test_block_size);
+    MJD_TEST_RUN(test_pool_alloc_free);
+    MJD_TEST_RUN(test_pool_invalid);
+    MJD_TEST_RUN(test_arena);
+#ifdef CONFIG_MJD_POOL_DEBUG_POISON
+    MJD_TEST_RUN(test_poison);
+#endif
+
+    return MJD_TEST_REPORT();
+}
@@ -0,0 +1,50 @@
+/*
+ * HOST TEST: mjd_trace histograms (POSIX cycle counter backend)
+ */
+#include "mjd.h"
+#include "mjd_trace.h"
+
+#include "mjd_test.h"
+
+static void test_record_and_stats(void) {
+    mjd_trace_stats_t stats;
+    mjd_trace_reset();
+
+    mjd_trace_record(MJD_TRACE_PROBE_USER_1, 100);  // bucket 6 [64..127]
+    mjd_trace_record(MJD_TRACE_PROBE_USER_1, 1000); // bucket 9 [512..1023]
+    mjd_trace_record(MJD_TRACE_PROBE_USER_1, 0);    // bucket 0
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_trace_get_stats(MJD_TRACE_PROBE_USER_1, &stats));
+    MJD_TEST_ASSERT_EQUAL_UINT(3, stats.count);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, stats.min_cycles);
+    MJD_TEST_ASSERT_EQUAL_UINT(1000, stats.max_cycles);
+    MJD_TEST_ASSERT_EQUAL_UINT(1100, stats.total_cycles);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, stats.buckets[0]);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, stats.buckets[6]);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, stats.buckets[9]);
+
+    MJD_TEST_ASSERT_EQUAL_UINT(127, mjd_trace_get_percentile_cycles(&stats, 50));
+    MJD_TEST_ASSERT_EQUAL_UINT(1000, mjd_trace_get_percentile_cycles(&stats, 99)); // clamped to max
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_trace_get_stats(MJD_TRACE_PROBE_USER_2, &stats));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, stats.count);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, stats.min_cycles);
+}
+
+static void test_begin_end(void) {
+    mjd_trace_stats_t stats;
+    mjd_trace_reset();
+
+    MJD_TRACE_BEGIN(MJD_TRACE_PROBE_USER_3);
+    MJD_TRACE_END(MJD_TRACE_PROBE_USER_3);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_trace_get_stats(MJD_TRACE_PROBE_USER_3, &stats));
+    MJD_TEST_ASSERT_EQUAL_UINT(1, stats.count);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_trace_get_stats(MJD_TRACE_PROBE_MAX, &stats));
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_record_and_stats);
+    MJD_TEST_RUN(test_begin_end);
+    return MJD_TEST_REPORT();
+}
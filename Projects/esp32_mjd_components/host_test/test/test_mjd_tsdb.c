@@ -0,0 +1,354 @@
+/*
+ * HOST TEST: mjd_tsdb time-series store (the segment files live in a temporary directory instead of SPIFFS)
+ */
+#include "mjd.h"
+#include "mjd_tsdb.h"
+
+#include "mjd_test.h"
+
+#include <unistd.h>
+
+#define TEST_T0_MS       (1546300800000LL) // 2019-01-01
+#define TEST_INTERVAL_MS (10000)
+
+static char _base_path[64];
+
+static void _make_base_path(void) {
+    strcpy(_base_path, "/tmp/mjd_tsdb.XXXXXX");
+    if (mkdtemp(_base_path) == NULL) {
+        perror("mkdtemp");
+        exit(1);
+    }
+}
+
+static void _remove_base_path(void) {
+    char path[MJD_TSDB_PATH_MAX_LEN + 64];
+    for (uint32_t idx = 0; idx < MJD_TSDB_MAX_SEGMENTS; idx++) {
+        snprintf(path, sizeof(path), "%s/t.%u", _base_path, idx);
+        unlink(path);
+    }
+    rmdir(_base_path);
+}
+
+static mjd_tsdb_config_t _config(uint32_t param_nbr_of_values, uint32_t param_nbr_of_segments, uint32_t param_blocks_per_segment) {
+    mjd_tsdb_config_t config = MJD_TSDB_CONFIG_DEFAULT();
+    config.base_path = _base_path;
+    config.name = "t";
+    config.nbr_of_values = param_nbr_of_values;
+    config.nbr_of_segments = param_nbr_of_segments;
+    config.blocks_per_segment = param_blocks_per_segment;
+    return config;
+}
+
+/*
+ * @doc A temperature (0.01 resolution), a humidity and a pressure; the interval jitters now and then.
+ */
+static void _sample(uint32_t param_idx, mjd_tsdb_sample_t* param_ptr_sample) {
+    int64_t jitter = (param_idx % 17 == 0) ? 3 : 0;
+    param_ptr_sample->timestamp_ms = TEST_T0_MS + (int64_t) param_idx * TEST_INTERVAL_MS + jitter;
+    param_ptr_sample->values[0] = roundf((21.0f + 2.0f * sinf(param_idx / 500.0f)) * 100.0f) / 100.0f;
+    param_ptr_sample->values[1] = (float) (55 + (param_idx / 40) % 5);
+    param_ptr_sample->values[2] = 1013.25f + (float) ((param_idx * 7) % 11) / 10.0f;
+    param_ptr_sample->values[3] = 0;
+}
+
+static bool _is_equal(const mjd_tsdb_sample_t* param_ptr_a, const mjd_tsdb_sample_t* param_ptr_b, uint32_t param_nbr_of_values) {
+    return param_ptr_a->timestamp_ms == param_ptr_b->timestamp_ms
+            && memcmp(param_ptr_a->values, param_ptr_b->values, param_nbr_of_values * sizeof(float)) == 0;
+}
+
+static void test_block_roundtrip(void) {
+    static const float specials[] = { 0.0f, -0.0f, 1e-30f, -3.4e38f, 123456.789f, 21.53f };
+    mjd_tsdb_block_t block;
+    mjd_tsdb_block_reader_t reader;
+    mjd_tsdb_sample_t samples[512];
+    mjd_tsdb_sample_t sample;
+    uint32_t nbr_of_samples = 0;
+
+    MJD_TEST_ASSERT(mjd_tsdb_block_init(&block, 7, 2) == ESP_OK);
+    for (uint32_t idx = 0; idx < ARRAY_SIZE(samples); idx++) {
+        memset(&samples[idx], 0, sizeof(samples[idx]));
+        // Regular intervals, jitter, a gap of 1 day, a step back of the interval
+        samples[idx].timestamp_ms = TEST_T0_MS + idx * 1000 + ((idx % 5 == 0) ? 40 : 0) + ((idx > 20) ? 86400000LL : 0)
+                                    - ((idx > 30) ? 500 : 0);
+        samples[idx].values[0] = specials[idx % ARRAY_SIZE(specials)];
+        samples[idx].values[1] = (idx < 10) ? 42.0f : (float) idx / 3.0f;
+        if (mjd_tsdb_block_append(&block, &samples[idx]) != ESP_OK) {
+            break;
+        }
+        ++nbr_of_samples;
+    }
+    MJD_TEST_ASSERT(nbr_of_samples > 20 && nbr_of_samples < ARRAY_SIZE(samples)); // Full before the end
+
+    // A full block rejects the sample and stays unchanged
+    MJD_TEST_ASSERT(mjd_tsdb_block_append(&block, &samples[nbr_of_samples]) == ESP_ERR_INVALID_SIZE);
+    mjd_tsdb_block_finalize(&block, MJD_TSDB_BLOCK_FLAG_SEALED);
+    MJD_TEST_ASSERT(mjd_tsdb_block_check(block.bytes) == ESP_OK);
+
+    MJD_TEST_ASSERT(mjd_tsdb_block_reader_init(&reader, block.bytes, 2) == ESP_OK);
+    for (uint32_t idx = 0; idx < nbr_of_samples; idx++) {
+        MJD_TEST_ASSERT(mjd_tsdb_block_reader_next(&reader, &sample) == true);
+        MJD_TEST_ASSERT_EQUAL_INT(samples[idx].timestamp_ms, sample.timestamp_ms);
+        MJD_TEST_ASSERT(_is_equal(&samples[idx], &sample, 2) == true);
+    }
+    MJD_TEST_ASSERT(mjd_tsdb_block_reader_next(&reader, &sample) == false);
+
+    // Restore = continue to fill a block that was written half full
+    mjd_tsdb_block_t restored;
+    mjd_tsdb_block_init(&block, 8, 2);
+    for (uint32_t idx = 0; idx < 10; idx++) {
+        mjd_tsdb_block_append(&block, &samples[idx]);
+    }
+    mjd_tsdb_block_finalize(&block, 0);
+    MJD_TEST_ASSERT(mjd_tsdb_block_restore(&restored, block.bytes, 2) == ESP_OK);
+    for (uint32_t idx = 10; idx < 20; idx++) {
+        MJD_TEST_ASSERT(mjd_tsdb_block_append(&block, &samples[idx]) == ESP_OK);
+        MJD_TEST_ASSERT(mjd_tsdb_block_append(&restored, &samples[idx]) == ESP_OK);
+    }
+    MJD_TEST_ASSERT_EQUAL_MEMORY(block.bytes, restored.bytes, MJD_TSDB_BLOCK_SIZE);
+
+    // Corruption
+    block.bytes[MJD_TSDB_BLOCK_SIZE / 2] ^= 0x10;
+    MJD_TEST_ASSERT(mjd_tsdb_block_check(block.bytes) == ESP_ERR_INVALID_CRC);
+    memset(block.bytes, 0xFF, sizeof(block.bytes)); // Erased flash
+    MJD_TEST_ASSERT(mjd_tsdb_block_check(block.bytes) == ESP_ERR_NOT_FOUND);
+}
+
+static uint32_t _nbr_of_handled;
+static int64_t _last_handled_ms;
+
+static bool _query_handler(const mjd_tsdb_sample_t* param_ptr_sample, void * param_ptr_arg) {
+    mjd_tsdb_sample_t expected;
+    _sample((uint32_t) ((param_ptr_sample->timestamp_ms - TEST_T0_MS) / TEST_INTERVAL_MS), &expected);
+    if (_is_equal(&expected, param_ptr_sample, *(uint32_t *) param_ptr_arg) == false || param_ptr_sample->timestamp_ms < _last_handled_ms) {
+        return false;
+    }
+    _last_handled_ms = param_ptr_sample->timestamp_ms;
+    ++_nbr_of_handled;
+    return true;
+}
+
+static void test_store_query_and_recycling(void) {
+    mjd_tsdb_t tsdb;
+    mjd_tsdb_config_t config = _config(3, 4, 4);
+    mjd_tsdb_stats_t stats;
+    mjd_tsdb_sample_t sample;
+    mjd_tsdb_cursor_t cursor;
+    uint32_t nbr_of_samples;
+    const uint32_t total = 10000;
+
+    _make_base_path();
+    MJD_TEST_ASSERT(mjd_tsdb_open(&tsdb, &config) == ESP_OK);
+    for (uint32_t idx = 0; idx < total; idx++) {
+        _sample(idx, &sample);
+        MJD_TEST_ASSERT(mjd_tsdb_append(&tsdb, &sample) == ESP_OK);
+    }
+    _sample(total - 2, &sample);
+    MJD_TEST_ASSERT(mjd_tsdb_append(&tsdb, &sample) == ESP_ERR_INVALID_ARG); // Older than the last sample
+
+    // The ring of 16 blocks wrapped: the oldest samples were recycled, the store holds 13..16 blocks
+    mjd_tsdb_get_stats(&tsdb, &stats);
+    MJD_TEST_ASSERT(stats.nbr_of_recycles > 0);
+    MJD_TEST_ASSERT(stats.nbr_of_blocks > 12 && stats.nbr_of_blocks <= 16);
+    MJD_TEST_ASSERT_EQUAL_UINT(total, stats.nbr_of_samples + stats.nbr_of_samples_recycled);
+    MJD_TEST_ASSERT(stats.max_segment_recycles - stats.min_segment_recycles <= 1); // Even wear
+    MJD_TEST_ASSERT(stats.compression_ratio > 3.0f);
+
+    // Read everything from the oldest sample: the samples are contiguous and end with the last sample
+    mjd_tsdb_cursor_oldest(&tsdb, &cursor);
+    uint32_t first_idx = total - stats.nbr_of_samples;
+    uint32_t idx = first_idx;
+    mjd_tsdb_sample_t batch[100];
+    do {
+        MJD_TEST_ASSERT(mjd_tsdb_read_since(&tsdb, &cursor, batch, ARRAY_SIZE(batch), &nbr_of_samples) == ESP_OK);
+        for (uint32_t k = 0; k < nbr_of_samples; k++, idx++) {
+            _sample(idx, &sample);
+            MJD_TEST_ASSERT(_is_equal(&sample, &batch[k], 3) == true);
+        }
+    } while (nbr_of_samples > 0);
+    MJD_TEST_ASSERT_EQUAL_UINT(total, idx);
+
+    // Time range: 100 samples in the middle (a few blocks, the others are skipped by the index)
+    uint32_t from_idx = first_idx + stats.nbr_of_samples / 2;
+    _nbr_of_handled = 0;
+    _last_handled_ms = 0;
+    mjd_tsdb_get_stats(&tsdb, &stats);
+    uint32_t reads_before = stats.nbr_of_block_reads;
+    MJD_TEST_ASSERT(mjd_tsdb_query(&tsdb, TEST_T0_MS + (int64_t) from_idx * TEST_INTERVAL_MS,
+            TEST_T0_MS + (int64_t) (from_idx + 99) * TEST_INTERVAL_MS + 5, _query_handler, &config.nbr_of_values,
+            &nbr_of_samples) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(100, nbr_of_samples);
+    MJD_TEST_ASSERT_EQUAL_UINT(100, _nbr_of_handled);
+    mjd_tsdb_get_stats(&tsdb, &stats);
+    MJD_TEST_ASSERT(stats.nbr_of_block_reads - reads_before <= 3);
+
+    // A range before the oldest sample
+    MJD_TEST_ASSERT(mjd_tsdb_query(&tsdb, 0, TEST_T0_MS + first_idx * TEST_INTERVAL_MS - 1, _query_handler,
+            &config.nbr_of_values, &nbr_of_samples) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, nbr_of_samples);
+
+    MJD_TEST_ASSERT(mjd_tsdb_close(&tsdb) == ESP_OK);
+    _remove_base_path();
+}
+
+static void test_reopen_and_cursor(void) {
+    mjd_tsdb_t tsdb;
+    mjd_tsdb_config_t config = _config(1, 3, 6);
+    mjd_tsdb_sample_t sample;
+    mjd_tsdb_sample_t batch[64];
+    mjd_tsdb_cursor_t cursor;
+    mjd_tsdb_stats_t stats;
+    uint32_t nbr_of_samples;
+    uint32_t idx_read = 0;
+
+    _make_base_path();
+    MJD_TEST_ASSERT(mjd_tsdb_open(&tsdb, &config) == ESP_OK);
+    mjd_tsdb_cursor_oldest(&tsdb, &cursor);
+
+    // Append, upload part of it, "deep sleep" (flush + close) and wake up (open) a few times
+    for (uint32_t cycle = 0, idx = 0; cycle < 5; cycle++) {
+        for (uint32_t k = 0; k < 150; k++, idx++) {
+            _sample(idx, &sample);
+            MJD_TEST_ASSERT(mjd_tsdb_append(&tsdb, &sample) == ESP_OK);
+        }
+        MJD_TEST_ASSERT(mjd_tsdb_read_since(&tsdb, &cursor, batch, ARRAY_SIZE(batch), &nbr_of_samples) == ESP_OK);
+        MJD_TEST_ASSERT_EQUAL_UINT(ARRAY_SIZE(batch), nbr_of_samples);
+        for (uint32_t k = 0; k < nbr_of_samples; k++, idx_read++) {
+            _sample(idx_read, &sample);
+            MJD_TEST_ASSERT(_is_equal(&sample, &batch[k], 1) == true);
+        }
+
+        MJD_TEST_ASSERT(mjd_tsdb_close(&tsdb) == ESP_OK);
+        MJD_TEST_ASSERT(mjd_tsdb_open(&tsdb, &config) == ESP_OK);
+    }
+
+    // The cursor continues after the reopen, until the last sample (the restored open block included)
+    mjd_tsdb_get_stats(&tsdb, &stats);
+    MJD_TEST_ASSERT_EQUAL_UINT(750, stats.nbr_of_samples);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, stats.nbr_of_corrupt_blocks);
+    do {
+        MJD_TEST_ASSERT(mjd_tsdb_read_since(&tsdb, &cursor, batch, ARRAY_SIZE(batch), &nbr_of_samples) == ESP_OK);
+        for (uint32_t k = 0; k < nbr_of_samples; k++, idx_read++) {
+            _sample(idx_read, &sample);
+            MJD_TEST_ASSERT(_is_equal(&sample, &batch[k], 1) == true);
+        }
+    } while (nbr_of_samples > 0);
+    MJD_TEST_ASSERT_EQUAL_UINT(750, idx_read);
+
+    // New samples after "all read"
+    _sample(750, &sample);
+    mjd_tsdb_append(&tsdb, &sample);
+    MJD_TEST_ASSERT(mjd_tsdb_read_since(&tsdb, &cursor, batch, ARRAY_SIZE(batch), &nbr_of_samples) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, nbr_of_samples);
+    MJD_TEST_ASSERT(_is_equal(&sample, &batch[0], 1) == true);
+    mjd_tsdb_cursor_latest(&tsdb, &cursor);
+    MJD_TEST_ASSERT(mjd_tsdb_read_since(&tsdb, &cursor, batch, ARRAY_SIZE(batch), &nbr_of_samples) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, nbr_of_samples);
+
+    // A cursor that fell behind the ring (never uploaded) jumps to the oldest sample
+    mjd_tsdb_cursor_t stale_cursor = { .seq = 0, .sample_idx = 3 };
+    for (uint32_t idx = 751; idx < 8000; idx++) {
+        _sample(idx, &sample);
+        mjd_tsdb_append(&tsdb, &sample);
+    }
+    MJD_TEST_ASSERT(mjd_tsdb_read_since(&tsdb, &stale_cursor, batch, 1, &nbr_of_samples) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, nbr_of_samples);
+    mjd_tsdb_get_stats(&tsdb, &stats);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, stats.nbr_of_cursor_gaps);
+    MJD_TEST_ASSERT_EQUAL_UINT(8000 - stats.nbr_of_samples, (uint32_t) ((batch[0].timestamp_ms - TEST_T0_MS) / TEST_INTERVAL_MS));
+
+    MJD_TEST_ASSERT(mjd_tsdb_close(&tsdb) == ESP_OK);
+    _remove_base_path();
+}
+
+static void test_reopen_behind_sealed_block(void) {
+    mjd_tsdb_t tsdb;
+    mjd_tsdb_t tsdb_after_power_loss;
+    mjd_tsdb_config_t config = _config(1, 2, 4);
+    mjd_tsdb_sample_t sample;
+    uint32_t nbr_of_samples;
+    uint32_t idx = 0;
+
+    _make_base_path();
+    MJD_TEST_ASSERT(mjd_tsdb_open(&tsdb, &config) == ESP_OK);
+    MJD_TEST_ASSERT(tsdb.last_timestamp_ms == INT64_MIN);
+    while (tsdb.nbr_of_sealed_blocks == 0) {
+        _sample(idx++, &sample);
+        MJD_TEST_ASSERT(mjd_tsdb_append(&tsdb, &sample) == ESP_OK);
+    }
+
+    // A power loss before the flush: the newest block on flash is sealed, the open starts a fresh (empty) block behind it
+    MJD_TEST_ASSERT(mjd_tsdb_open(&tsdb_after_power_loss, &config) == ESP_OK);
+    _sample(idx - 2, &sample); // The last sample of the sealed block
+    MJD_TEST_ASSERT(tsdb_after_power_loss.last_timestamp_ms == sample.timestamp_ms);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, tsdb_after_power_loss.open_block.state.nbr_of_samples);
+    _sample(idx - 10, &sample);
+    MJD_TEST_ASSERT(mjd_tsdb_append(&tsdb_after_power_loss, &sample) == ESP_ERR_INVALID_ARG); // Older than the sealed block
+    _sample(idx - 1, &sample);
+    MJD_TEST_ASSERT(mjd_tsdb_append(&tsdb_after_power_loss, &sample) == ESP_OK);
+
+    // The query stops at the first block after the range: every sample is found
+    _nbr_of_handled = 0;
+    _last_handled_ms = 0;
+    MJD_TEST_ASSERT(mjd_tsdb_query(&tsdb_after_power_loss, TEST_T0_MS, sample.timestamp_ms, _query_handler, &config.nbr_of_values,
+            &nbr_of_samples) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(idx, nbr_of_samples);
+
+    MJD_TEST_ASSERT(mjd_tsdb_close(&tsdb_after_power_loss) == ESP_OK);
+    // The RAM of the store that lost power (no flush)
+    free(tsdb.ptr_index);
+    vSemaphoreDelete(tsdb.mutex);
+    _remove_base_path();
+}
+
+static void test_corrupt_segment(void) {
+    mjd_tsdb_t tsdb;
+    mjd_tsdb_config_t config = _config(1, 2, 8);
+    mjd_tsdb_sample_t sample;
+    mjd_tsdb_stats_t stats;
+    char path[MJD_TSDB_PATH_MAX_LEN + 64];
+    uint32_t nbr_of_samples;
+
+    _make_base_path();
+    MJD_TEST_ASSERT(mjd_tsdb_open(&tsdb, &config) == ESP_OK);
+    for (uint32_t idx = 0; idx < 1000; idx++) {
+        _sample(idx, &sample);
+        mjd_tsdb_append(&tsdb, &sample);
+    }
+    mjd_tsdb_get_stats(&tsdb, &stats);
+    uint32_t nbr_of_blocks = stats.nbr_of_blocks;
+    MJD_TEST_ASSERT(nbr_of_blocks > 4 && nbr_of_blocks < 8); // Segment 0 only
+    MJD_TEST_ASSERT(mjd_tsdb_close(&tsdb) == ESP_OK);
+
+    // Flip a bit in block slot 2 of segment 0: slots 2.. are dropped at the open
+    snprintf(path, sizeof(path), "%s/t.0", _base_path);
+    FILE *ptr_file = fopen(path, "r+b");
+    MJD_TEST_ASSERT(ptr_file != NULL);
+    fseek(ptr_file, sizeof(mjd_tsdb_segment_header_t) + 2 * MJD_TSDB_BLOCK_SIZE + 100, SEEK_SET);
+    uint8_t byte = (uint8_t) fgetc(ptr_file);
+    fseek(ptr_file, -1, SEEK_CUR);
+    fputc(byte ^ 0x01, ptr_file);
+    fclose(ptr_file);
+
+    MJD_TEST_ASSERT(mjd_tsdb_open(&tsdb, &config) == ESP_OK);
+    mjd_tsdb_get_stats(&tsdb, &stats);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, stats.nbr_of_corrupt_blocks);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, stats.nbr_of_blocks);
+    _nbr_of_handled = 0;
+    _last_handled_ms = 0;
+    MJD_TEST_ASSERT(mjd_tsdb_query(&tsdb, 0, INT64_MAX, _query_handler, &config.nbr_of_values, &nbr_of_samples) == ESP_OK);
+    MJD_TEST_ASSERT_EQUAL_UINT(stats.nbr_of_samples, nbr_of_samples);
+
+    MJD_TEST_ASSERT(mjd_tsdb_close(&tsdb) == ESP_OK);
+    _remove_base_path();
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_block_roundtrip);
+    MJD_TEST_RUN(test_store_query_and_recycling);
+    MJD_TEST_RUN(test_reopen_and_cursor);
+    MJD_TEST_RUN(test_reopen_behind_sealed_block);
+    MJD_TEST_RUN(test_corrupt_segment);
+
+    return MJD_TEST_REPORT();
+}
@@ -0,0 +1,305 @@
+/*
+ * HOST TEST: mjd_wifi_sniffer channel queues + hop scheduler + unique devices
+ *
+ * @doc The captures are synthetic: the test plays the role of the RX callback (capture), of the hopper (next_hop with the elapsed
+ *      time) and of the consumer task (receive).
+ */
+#include "mjd.h"
+#include "mjd_wifi_sniffer_core.h"
+
+#include "mjd_test.h"
+
+static mjd_wifi_sniffer_core_t _core; // @doc ~10KB: not on the stack
+
+static mjd_wifi_sniffer_frame_t _make_frame(uint8_t param_channel, uint32_t param_device_id, uint32_t param_timestamp_us) {
+    mjd_wifi_sniffer_frame_t frame = { 0 };
+
+    // A locally administered MAC: 02:00:<device id>
+    frame.source_mac[0] = 0x02;
+    frame.source_mac[2] = (param_device_id >> 24) & 0xFF;
+    frame.source_mac[3] = (param_device_id >> 16) & 0xFF;
+    frame.source_mac[4] = (param_device_id >> 8) & 0xFF;
+    frame.source_mac[5] = param_device_id & 0xFF;
+    frame.channel = param_channel;
+    frame.rssi = -60;
+    frame.frame_control = 0x40; // probe request
+    frame.timestamp_us = param_timestamp_us;
+
+    return frame;
+}
+
+static uint32_t _drain(void) {
+    mjd_wifi_sniffer_frame_t frame;
+    uint32_t nbr_of_frames = 0;
+
+    while (mjd_wifi_sniffer_core_receive(&_core, &frame) == true) {
+        nbr_of_frames++;
+    }
+    return nbr_of_frames;
+}
+
+static void test_init_validation(void) {
+    mjd_wifi_sniffer_hop_config_t config = MJD_WIFI_SNIFFER_HOP_CONFIG_DEFAULT();
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_wifi_sniffer_core_init(&_core, &config));
+
+    config.nbr_of_channels = 0;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_wifi_sniffer_core_init(&_core, &config));
+
+    config = (mjd_wifi_sniffer_hop_config_t) MJD_WIFI_SNIFFER_HOP_CONFIG_DEFAULT();
+    config.channels[3] = 15;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_wifi_sniffer_core_init(&_core, &config));
+
+    config = (mjd_wifi_sniffer_hop_config_t) MJD_WIFI_SNIFFER_HOP_CONFIG_DEFAULT();
+    config.max_dwell_ms = config.min_dwell_ms - 1;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_wifi_sniffer_core_init(&_core, &config));
+}
+
+static void test_queue_full_and_fifo(void) {
+    mjd_wifi_sniffer_hop_config_t config = MJD_WIFI_SNIFFER_HOP_CONFIG_DEFAULT();
+    mjd_wifi_sniffer_channel_stats_t stats;
+    mjd_wifi_sniffer_frame_t frame;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_wifi_sniffer_core_init(&_core, &config));
+
+    // A burst of 40 frames on channel 6 while the consumer is busy: 8 drops, the other channels are not affected
+    for (uint32_t idx = 0; idx < 40; idx++) {
+        frame = _make_frame(6, idx, idx);
+        MJD_TEST_ASSERT(mjd_wifi_sniffer_core_capture(&_core, &frame) == (idx < CONFIG_MJD_WIFI_SNIFFER_QUEUE_LENGTH));
+    }
+    frame = _make_frame(11, 1000, 1000);
+    MJD_TEST_ASSERT(mjd_wifi_sniffer_core_capture(&_core, &frame) == true);
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_wifi_sniffer_core_get_channel_stats(&_core, 6, &stats));
+    MJD_TEST_ASSERT_EQUAL_UINT(40, stats.nbr_of_frames);
+    MJD_TEST_ASSERT_EQUAL_UINT(40 - CONFIG_MJD_WIFI_SNIFFER_QUEUE_LENGTH, stats.nbr_of_drops);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_wifi_sniffer_core_get_channel_stats(&_core, 11, &stats));
+    MJD_TEST_ASSERT_EQUAL_UINT(1, stats.nbr_of_frames);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, stats.nbr_of_drops);
+
+    // FIFO per channel
+    uint32_t expected_timestamp_us = 0;
+    while (mjd_wifi_sniffer_core_receive(&_core, &frame) == true) {
+        if (frame.channel == 6) {
+            MJD_TEST_ASSERT_EQUAL_UINT(expected_timestamp_us, frame.timestamp_us);
+            expected_timestamp_us++;
+        }
+    }
+    MJD_TEST_ASSERT_EQUAL_UINT(CONFIG_MJD_WIFI_SNIFFER_QUEUE_LENGTH, expected_timestamp_us);
+
+    // Room again
+    frame = _make_frame(6, 99, 99);
+    MJD_TEST_ASSERT(mjd_wifi_sniffer_core_capture(&_core, &frame) == true);
+}
+
+static void test_invalid_channel(void) {
+    mjd_wifi_sniffer_hop_config_t config = MJD_WIFI_SNIFFER_HOP_CONFIG_DEFAULT();
+    mjd_wifi_sniffer_channel_stats_t stats;
+    mjd_wifi_sniffer_frame_t frame;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_wifi_sniffer_core_init(&_core, &config));
+
+    frame = _make_frame(0, 1, 0);
+    MJD_TEST_ASSERT(mjd_wifi_sniffer_core_capture(&_core, &frame) == false);
+    frame = _make_frame(15, 1, 0);
+    MJD_TEST_ASSERT(mjd_wifi_sniffer_core_capture(&_core, &frame) == false);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, _core.nbr_of_invalid);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, _drain());
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_wifi_sniffer_core_get_channel_stats(&_core, 0, &stats));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, mjd_wifi_sniffer_core_get_channel_stats(&_core, 15, &stats));
+}
+
+static void test_receive_round_robin(void) {
+    mjd_wifi_sniffer_hop_config_t config = MJD_WIFI_SNIFFER_HOP_CONFIG_DEFAULT();
+    mjd_wifi_sniffer_frame_t frame;
+    uint8_t channels[14];
+    uint32_t nbr_of_frames = 0;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_wifi_sniffer_core_init(&_core, &config));
+
+    // A busy channel 1 does not starve channel 11
+    for (uint32_t idx = 0; idx < 10; idx++) {
+        frame = _make_frame(1, idx, idx);
+        mjd_wifi_sniffer_core_capture(&_core, &frame);
+    }
+    for (uint32_t idx = 0; idx < 2; idx++) {
+        frame = _make_frame(11, 100 + idx, idx);
+        mjd_wifi_sniffer_core_capture(&_core, &frame);
+    }
+    while (mjd_wifi_sniffer_core_receive(&_core, &frame) == true && nbr_of_frames < ARRAY_SIZE(channels)) {
+        channels[nbr_of_frames++] = frame.channel;
+    }
+    MJD_TEST_ASSERT_EQUAL_UINT(12, nbr_of_frames);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, channels[0]);
+    MJD_TEST_ASSERT_EQUAL_UINT(11, channels[1]);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, channels[2]);
+    MJD_TEST_ASSERT_EQUAL_UINT(11, channels[3]);
+    for (uint32_t idx = 4; idx < nbr_of_frames; idx++) {
+        MJD_TEST_ASSERT_EQUAL_UINT(1, channels[idx]);
+    }
+}
+
+static void test_hop_equal_when_quiet(void) {
+    mjd_wifi_sniffer_hop_config_t config = MJD_WIFI_SNIFFER_HOP_CONFIG_DEFAULT();
+    uint8_t channel;
+    uint32_t dwell_ms;
+    uint32_t total_ms = 0;
+    uint32_t visited_mask = 0;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_wifi_sniffer_core_init(&_core, &config));
+
+    // No traffic: every channel gets cycle_ms / nbr_of_channels, in the configured order
+    dwell_ms = 0;
+    for (uint32_t idx = 0; idx < config.nbr_of_channels; idx++) {
+        mjd_wifi_sniffer_core_next_hop(&_core, dwell_ms, &channel, &dwell_ms);
+        MJD_TEST_ASSERT_EQUAL_UINT(config.channels[idx], channel);
+        MJD_TEST_ASSERT_EQUAL_UINT(300, dwell_ms);
+        visited_mask |= (1UL << channel);
+        total_ms += dwell_ms;
+    }
+    MJD_TEST_ASSERT_EQUAL_UINT(0x3FFE, visited_mask); // channels 1..13
+    MJD_TEST_ASSERT_EQUAL_UINT(config.cycle_ms, total_ms);
+
+    // The next cycle starts over
+    mjd_wifi_sniffer_core_next_hop(&_core, dwell_ms, &channel, &dwell_ms);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, channel);
+}
+
+static void test_hop_weights_busy_channel(void) {
+    mjd_wifi_sniffer_hop_config_t config = MJD_WIFI_SNIFFER_HOP_CONFIG_DEFAULT();
+    mjd_wifi_sniffer_channel_stats_t stats;
+    mjd_wifi_sniffer_frame_t frame;
+    uint8_t channel;
+    uint32_t dwell_ms;
+    uint32_t dwell_by_channel[MJD_WIFI_SNIFFER_MAX_CHANNELS + 1];
+    uint32_t device_id = 0;
+
+    config.max_dwell_ms = 2000;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_wifi_sniffer_core_init(&_core, &config));
+
+    // Cycle 1 (every dwell takes 500 ms in real time): channel 6 carries 100 frames/sec, channel 11 20 frames/sec, the others nothing
+    mjd_wifi_sniffer_core_next_hop(&_core, 0, &channel, &dwell_ms);
+    for (uint32_t idx = 0; idx < config.nbr_of_channels; idx++) {
+        uint32_t nbr_of_frames = (channel == 6) ? 50 : (channel == 11) ? 10 : 0;
+        for (uint32_t i = 0; i < nbr_of_frames; i++) {
+            frame = _make_frame(channel, device_id++, 0);
+            mjd_wifi_sniffer_core_capture(&_core, &frame);
+            _drain();
+        }
+        mjd_wifi_sniffer_core_next_hop(&_core, 500, &channel, &dwell_ms);
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_wifi_sniffer_core_get_channel_stats(&_core, 6, &stats));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.1f, 100.0f, stats.packet_rate);
+    MJD_TEST_ASSERT_EQUAL_UINT(1, stats.nbr_of_dwells);
+    MJD_TEST_ASSERT_EQUAL_UINT(500, stats.total_dwell_ms);
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_wifi_sniffer_core_get_channel_stats(&_core, 11, &stats));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.1f, 20.0f, stats.packet_rate);
+
+    // Cycle 2 (quiet): the dwells follow the rates of cycle 1
+    memset(dwell_by_channel, 0, sizeof(dwell_by_channel));
+    for (uint32_t idx = 0; idx < config.nbr_of_channels; idx++) {
+        MJD_TEST_ASSERT(dwell_by_channel[channel] == 0); // each channel once per cycle
+        dwell_by_channel[channel] = dwell_ms;
+        MJD_TEST_ASSERT(dwell_ms >= config.min_dwell_ms && dwell_ms <= config.max_dwell_ms);
+        mjd_wifi_sniffer_core_next_hop(&_core, dwell_ms, &channel, &dwell_ms);
+    }
+    MJD_TEST_ASSERT(dwell_by_channel[6] > dwell_by_channel[11]);
+    MJD_TEST_ASSERT(dwell_by_channel[11] > dwell_by_channel[1]);
+    MJD_TEST_ASSERT(dwell_by_channel[6] > 1000);
+    MJD_TEST_ASSERT(dwell_by_channel[1] < 200);
+    MJD_TEST_ASSERT(dwell_by_channel[13] < 200);
+
+    // EWMA: the quiet dwell of cycle 2 pulls the rate of channel 6 down by 1/4
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_wifi_sniffer_core_get_channel_stats(&_core, 6, &stats));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.1f, 75.0f, stats.packet_rate);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, stats.nbr_of_dwells);
+
+    // max_dwell_ms clips a single busy channel
+    config.max_dwell_ms = 500;
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_wifi_sniffer_core_init(&_core, &config));
+    mjd_wifi_sniffer_core_next_hop(&_core, 0, &channel, &dwell_ms);
+    for (uint32_t i = 0; i < 200; i++) {
+        frame = _make_frame(channel, i, 0);
+        mjd_wifi_sniffer_core_capture(&_core, &frame);
+        _drain();
+    }
+    for (uint32_t idx = 0; idx < config.nbr_of_channels; idx++) {
+        mjd_wifi_sniffer_core_next_hop(&_core, dwell_ms, &channel, &dwell_ms);
+    }
+    MJD_TEST_ASSERT_EQUAL_UINT(1, channel);
+    MJD_TEST_ASSERT_EQUAL_UINT(500, dwell_ms);
+}
+
+static void test_unique_devices(void) {
+    mjd_wifi_sniffer_hop_config_t config = MJD_WIFI_SNIFFER_HOP_CONFIG_DEFAULT();
+    mjd_wifi_sniffer_channel_stats_t stats;
+    mjd_wifi_sniffer_frame_t frame;
+    const uint32_t NBR_OF_DEVICES = 300;
+
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_wifi_sniffer_core_init(&_core, &config));
+
+    // 300 devices on channel 1, each one seen 3x
+    for (uint32_t round = 0; round < 3; round++) {
+        for (uint32_t id = 0; id < NBR_OF_DEVICES; id++) {
+            frame = _make_frame(1, id, 0);
+            mjd_wifi_sniffer_core_capture(&_core, &frame);
+            _drain();
+        }
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_wifi_sniffer_core_get_channel_stats(&_core, 1, &stats));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(30.0f, (float) NBR_OF_DEVICES, (float) stats.nbr_of_unique_devices);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(15.0f, (float) NBR_OF_DEVICES, (float) mjd_wifi_sniffer_core_get_unique_devices(&_core));
+
+    // The same devices probe on channel 6 too: counted on channel 6, but once in the total
+    for (uint32_t id = 0; id < NBR_OF_DEVICES; id++) {
+        frame = _make_frame(6, id, 0);
+        mjd_wifi_sniffer_core_capture(&_core, &frame);
+        _drain();
+    }
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_wifi_sniffer_core_get_channel_stats(&_core, 6, &stats));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(30.0f, (float) NBR_OF_DEVICES, (float) stats.nbr_of_unique_devices);
+    MJD_TEST_ASSERT_FLOAT_WITHIN(15.0f, (float) NBR_OF_DEVICES, (float) mjd_wifi_sniffer_core_get_unique_devices(&_core));
+
+    // 300 other devices on channel 11
+    for (uint32_t id = 0; id < NBR_OF_DEVICES; id++) {
+        frame = _make_frame(11, 10000 + id, 0);
+        mjd_wifi_sniffer_core_capture(&_core, &frame);
+        _drain();
+    }
+    MJD_TEST_ASSERT_FLOAT_WITHIN(30.0f, 2.0f * NBR_OF_DEVICES, (float) mjd_wifi_sniffer_core_get_unique_devices(&_core));
+
+    // A new window
+    mjd_wifi_sniffer_core_reset_window(&_core);
+    MJD_TEST_ASSERT_EQUAL_UINT(0, mjd_wifi_sniffer_core_get_unique_devices(&_core));
+    MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_wifi_sniffer_core_get_channel_stats(&_core, 1, &stats));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, stats.nbr_of_unique_devices);
+    MJD_TEST_ASSERT_EQUAL_UINT(3 * NBR_OF_DEVICES, stats.nbr_of_frames); // the counters are not part of the window
+}
+
+static void test_estimate_unique_saturates(void) {
+    uint32_t bitmap[MJD_WIFI_SNIFFER_UNIQUE_BITS_PER_CHANNEL / 32];
+
+    memset(bitmap, 0, sizeof(bitmap));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, mjd_wifi_sniffer_estimate_unique(bitmap, MJD_WIFI_SNIFFER_UNIQUE_BITS_PER_CHANNEL));
+
+    bitmap[0] = 0x1;
+    MJD_TEST_ASSERT_EQUAL_UINT(1, mjd_wifi_sniffer_estimate_unique(bitmap, MJD_WIFI_SNIFFER_UNIQUE_BITS_PER_CHANNEL));
+
+    // Full: m * ln(m) (no division by 0, no infinity)
+    memset(bitmap, 0xFF, sizeof(bitmap));
+    MJD_TEST_ASSERT_EQUAL_UINT(3194, mjd_wifi_sniffer_estimate_unique(bitmap, MJD_WIFI_SNIFFER_UNIQUE_BITS_PER_CHANNEL));
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_init_validation);
+    MJD_TEST_RUN(test_queue_full_and_fifo);
+    MJD_TEST_RUN(test_invalid_channel);
+    MJD_TEST_RUN(test_receive_round_robin);
+    MJD_TEST_RUN(test_hop_equal_when_quiet);
+    MJD_TEST_RUN(test_hop_weights_busy_channel);
+    MJD_TEST_RUN(test_unique_devices);
+    MJD_TEST_RUN(test_estimate_unique_saturates);
+
+    return MJD_TEST_REPORT();
+}
@@ -0,0 +1,84 @@
+/*
+ * HOST TEST: nanopb encode/decode primitives (the wire format used by the LoRa payloads)
+ */
+#include "mjd.h"
+#include "pb_decode.h"
+#include "pb_encode.h"
+
+#include "mjd_test.h"
+
+static void test_varint_roundtrip(void) {
+    const uint64_t values[] = { 0, 1, 127, 128, 300, 16383, 16384, UINT32_MAX, UINT64_MAX };
+    uint8_t buffer[16];
+
+    for (size_t idx = 0; idx < ARRAY_SIZE(values); idx++) {
+        pb_ostream_t ostream = pb_ostream_from_buffer(buffer, sizeof(buffer));
+        MJD_TEST_ASSERT(pb_encode_varint(&ostream, values[idx]));
+
+        uint64_t decoded = 0;
+        pb_istream_t istream = pb_istream_from_buffer(buffer, ostream.bytes_written);
+        MJD_TEST_ASSERT(pb_decode_varint(&istream, &decoded));
+        MJD_TEST_ASSERT_EQUAL_UINT(values[idx], decoded);
+        MJD_TEST_ASSERT_EQUAL_UINT(0, istream.bytes_left);
+    }
+}
+
+static void test_varint_wire_bytes(void) {
+    // @doc https://developers.google.com/protocol-buffers/docs/encoding#varints 300 => AC 02
+    uint8_t buffer[4];
+    pb_ostream_t ostream = pb_ostream_from_buffer(buffer, sizeof(buffer));
+    MJD_TEST_ASSERT(pb_encode_varint(&ostream, 300));
+    MJD_TEST_ASSERT_EQUAL_UINT(2, ostream.bytes_written);
+    MJD_TEST_ASSERT_EQUAL_MEMORY("\xAC\x02", buffer, 2);
+}
+
+static void test_svarint_and_fixed32(void) {
+    uint8_t buffer[16];
+    pb_ostream_t ostream = pb_ostream_from_buffer(buffer, sizeof(buffer));
+    MJD_TEST_ASSERT(pb_encode_svarint(&ostream, -2));
+    MJD_TEST_ASSERT_EQUAL_UINT(0x03, buffer[0]); // zigzag(-2) = 3
+
+    float temperature = 21.5f;
+    MJD_TEST_ASSERT(pb_encode_fixed32(&ostream, &temperature));
+
+    pb_istream_t istream = pb_istream_from_buffer(buffer, ostream.bytes_written);
+    int64_t svalue = 0;
+    float decoded_temperature = 0;
+    MJD_TEST_ASSERT(pb_decode_svarint(&istream, &svalue));
+    MJD_TEST_ASSERT_EQUAL_INT(-2, svalue);
+    MJD_TEST_ASSERT(pb_decode_fixed32(&istream, &decoded_temperature));
+    MJD_TEST_ASSERT_FLOAT_WITHIN(0.0001, 21.5, decoded_temperature);
+}
+
+static void test_string_field(void) {
+    uint8_t buffer[32];
+    pb_ostream_t ostream = pb_ostream_from_buffer(buffer, sizeof(buffer));
+    MJD_TEST_ASSERT(pb_encode_tag(&ostream, PB_WT_STRING, 2));
+    MJD_TEST_ASSERT(pb_encode_string(&ostream, (const pb_byte_t *) "huzzah32", 8));
+    MJD_TEST_ASSERT_EQUAL_UINT(1 + 1 + 8, ostream.bytes_written);
+
+    pb_istream_t istream = pb_istream_from_buffer(buffer, ostream.bytes_written);
+    pb_wire_type_t wire_type;
+    uint32_t tag;
+    bool eof;
+    MJD_TEST_ASSERT(pb_decode_tag(&istream, &wire_type, &tag, &eof));
+    MJD_TEST_ASSERT_EQUAL_UINT(PB_WT_STRING, wire_type);
+    MJD_TEST_ASSERT_EQUAL_UINT(2, tag);
+    MJD_TEST_ASSERT(pb_skip_field(&istream, wire_type));
+    MJD_TEST_ASSERT_EQUAL_UINT(0, istream.bytes_left);
+}
+
+static void test_buffer_overflow(void) {
+    uint8_t buffer[1];
+    pb_ostream_t ostream = pb_ostream_from_buffer(buffer, sizeof(buffer));
+    MJD_TEST_ASSERT(!pb_encode_varint(&ostream, 300));
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_varint_roundtrip);
+    MJD_TEST_RUN(test_varint_wire_bytes);
+    MJD_TEST_RUN(test_svarint_and_fixed32);
+    MJD_TEST_RUN(test_string_field);
+    MJD_TEST_RUN(test_buffer_overflow);
+    return MJD_TEST_REPORT();
+}
@@ -0,0 +1,30 @@
+/*
+ * HOST TEST: sensor conversion math
+ */
+#include "mjd.h"
+#include "mjd_tmp36.h"
+
+#include "mjd_test.h"
+
+static void test_tmp36_volts_to_degrees_celsius(void) {
+    const struct {
+        float in_volts;
+        float out_degrees_celsius;
+    } cases[] = {
+        { 0.100f, -40.0f }, // Datasheet: lower end of the range
+        { 0.500f, 0.0f },
+        { 0.750f, 25.0f },
+        { 1.750f, 125.0f }, // Datasheet: upper end of the range
+    };
+
+    for (size_t idx = 0; idx < ARRAY_SIZE(cases); idx++) {
+        mjd_tmp36_data_t data = { .in_volts = cases[idx].in_volts };
+        MJD_TEST_ASSERT_EQUAL_INT(ESP_OK, mjd_tmp36_convert_volts_to_degrees_celsius(&data));
+        MJD_TEST_ASSERT_FLOAT_WITHIN(0.01, cases[idx].out_degrees_celsius, data.out_degrees_celsius);
+    }
+}
+
+int main(void) {
+    MJD_TEST_RUN(test_tmp36_volts_to_degrees_celsius);
+    return MJD_TEST_REPORT();
+}
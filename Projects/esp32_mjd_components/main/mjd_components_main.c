@@ -8,9 +8,11 @@
  * Includes: system, own
  */
 #include "mjd.h"
+#include "mjd_boot.h"
 #include "mjd_list.h"
 #include "mjd_mqtt.h"
 #include "mjd_net.h"
+#include "mjd_trace.h"
 #include "mjd_wifi.h"
 
 /*
@@ -37,6 +39,7 @@ static const char *MY_WIFI_PASSWORD = CONFIG_MY_WIFI_PASSWORD;
 /*
  * FreeRTOS settings
  */
+#define MYAPP_RTOS_TASK_STACK_SIZE_8K (8 * 1024)
 #define MYAPP_RTOS_TASK_STACK_SIZE_16K (16 * 1024)
 #define MYAPP_RTOS_TASK_PRIORITY_NORMAL (RTOS_TASK_PRIORITY_NORMAL)
 
@@ -57,6 +60,17 @@ static const char *MY_WIFI_PASSWORD = CONFIG_MY_WIFI_PASSWORD;
 #define MY_MQTT_BUFFER_SIZE  (4096)  // @suggested 256 @used 4096 [must be >= longest topic/payload that you will send]
 #define MY_MQTT_TIMEOUT      (5000)  // @suggested 2000 @used Feb2018: 2000 @used Jun2018: 5000 (less timeouts now)
 
+/*
+ * Boot: the WiFi driver init and the MQTT init do not depend on each other so they run in parallel (mjd_boot_run_parallel())
+ */
+static esp_err_t _wifi_init(void * param_ptr_arg) {
+    return mjd_wifi_sta_init(MY_WIFI_SSID, MY_WIFI_PASSWORD);
+}
+
+static esp_err_t _mqtt_init(void * param_ptr_arg) {
+    return mjd_mqtt_init(MY_MQTT_BUFFER_SIZE, MY_MQTT_TIMEOUT);
+}
+
 /*
  * TASK
  */
@@ -72,6 +86,7 @@ void main_task(void *pvParameter) {
     int i;
     int total;
     esp_err_t f_retval;
+    esp_err_t mqtt_init_retval = ESP_FAIL;
 
     /********************************************************************************
      * SOC init
@@ -86,6 +101,7 @@ void main_task(void *pvParameter) {
 // DEVTEMP-END
 
     ESP_LOGI(TAG, "@doc exec nvs_flash_init() - mandatory for Wifi to work later on");
+    int32_t boot_phase_idx = mjd_boot_phase_begin("nvs_flash_init");
     esp_err_t err = nvs_flash_init();
     if (err == ESP_ERR_NVS_NO_FREE_PAGES) {
         ESP_LOGW(TAG, "  ESP_ERR_NVS_NO_FREE_PAGES - do nvs_flash_erase()");
@@ -96,6 +112,7 @@ void main_task(void *pvParameter) {
         ESP_ERROR_CHECK(nvs_flash_erase());
         err = nvs_flash_init();
     }
+    mjd_boot_phase_end(boot_phase_idx, err);
     ESP_ERROR_CHECK(err);
 
     /********************************************************************************
@@ -251,6 +268,22 @@ void main_task(void *pvParameter) {
     ESP_LOGI(TAG, "    final_string:  %s", final_string);
     ESP_LOGI(TAG, "    add_to_string: %s", add_to_string);
 
+    ESP_LOGI(TAG, "mjd_strbuf (string builder on caller-provided storage, no malloc, no printf):");
+    char strbuf_storage[32];
+    mjd_strbuf_t strbuf;
+    mjd_strbuf_init(&strbuf, strbuf_storage, sizeof(strbuf_storage));
+    mjd_strbuf_append(&strbuf, "T=");
+    mjd_strbuf_append_float(&strbuf, 23.456, 6, 2);
+    mjd_strbuf_append(&strbuf, " RH=");
+    mjd_strbuf_append_uint(&strbuf, 65, 0);
+    mjd_strbuf_append_char(&strbuf, '%');
+    mjd_strbuf_prepend(&strbuf, "123456789 ");
+    ESP_LOGI(TAG, "    strbuf: (%u) %s", mjd_strbuf_len(&strbuf), mjd_strbuf_c_str(&strbuf));
+    mjd_strbuf_reset(&strbuf);
+    if (mjd_strbuf_repeat(&strbuf, "0123456789", 5) != ESP_OK) {
+        ESP_LOGI(TAG, "    strbuf is_truncated=%u: (%u) %s", strbuf.is_truncated, mjd_strbuf_len(&strbuf), mjd_strbuf_c_str(&strbuf));
+    }
+
     /*
      * HEX strings
      */
@@ -949,7 +982,19 @@ void main_task(void *pvParameter) {
 
     mjd_log_memory_statistics();
 
-    f_retval = mjd_wifi_sta_init(MY_WIFI_SSID, MY_WIFI_PASSWORD);
+    // WiFi Init + MQTT Init in parallel (@important both run only ONCE in the whole app)
+    mjd_boot_init_t boot_inits[] = {
+            MJD_BOOT_INIT("mjd_wifi_sta_init", _wifi_init, NULL),
+            MJD_BOOT_INIT("mjd_mqtt_init", _mqtt_init, NULL),
+        };
+    boot_inits[0].stack_size = MYAPP_RTOS_TASK_STACK_SIZE_8K; // The WiFi driver init needs more than the default stack
+    mjd_boot_parallel_result_t boot_result;
+    f_retval = mjd_boot_run_parallel("wifi+mqtt init", boot_inits, ARRAY_SIZE(boot_inits), &boot_result);
+    ESP_LOGI(TAG, "mjd_boot_run_parallel(wifi+mqtt init): %" PRIu64 " us instead of %" PRIu64 " us (saved %" PRIi64 " us)",
+            boot_result.wall_us, boot_result.serial_sum_us, boot_result.saved_us);
+    ESP_LOGI(TAG, "  %u init(s) failed | err %i (%s)", boot_result.nbr_of_errors, f_retval, esp_err_to_name(f_retval));
+    mqtt_init_retval = boot_inits[1].retval;
+    f_retval = boot_inits[0].retval;
     if (f_retval != ESP_OK) {
         ESP_LOGE(TAG, "mjd_wifi_sta_init() err %i (%s)", f_retval, esp_err_to_name(f_retval));
         goto wifi_cleanup;
@@ -1067,7 +1112,7 @@ void main_task(void *pvParameter) {
         goto sntp_cleanup;
     }
 
-    f_retval = mjd_net_sync_current_datetime(false);
+    f_retval = MJD_BOOT_PHASE("mjd_net_sync_current_datetime", mjd_net_sync_current_datetime(false));
     if (f_retval != ESP_OK) {
         ESP_LOGE(TAG, "mjd_net_sync_current_datetime(false) err %i (%s)", f_retval, esp_err_to_name(f_retval));
         ESP_LOGE(TAG, "COULD NOT sync datetime due to error");
@@ -1095,22 +1140,6 @@ void main_task(void *pvParameter) {
 
     // DEVTEMP: HALT
     /////mjd_rtos_wait_forever();
-    /********************************************************************************
-     * MQTT INIT
-     * @important Do this only ONCE in the whole app!
-     *
-     */
-    ESP_LOGI(TAG, "\n\n***SECTION: MQTT INIT***");
-
-    mjd_log_memory_statistics();
-
-    f_retval = mjd_mqtt_init(MY_MQTT_BUFFER_SIZE, MY_MQTT_TIMEOUT);
-    if (f_retval != ESP_OK) {
-        ESP_LOGE(TAG, "ABORT. mjd_mqtt_init() failed");
-        // GOTO
-        goto mqtt_cleanup1;
-    }
-
     /********************************************************************************
      * MQTT
      * @dep mjd_wifi_sta_init() in previous section.
@@ -1128,6 +1157,13 @@ void main_task(void *pvParameter) {
         goto mqtt_cleanup1;
     }
 
+    // MQTT Init: done in parallel with the WiFi Init (section WIFI)
+    if (mqtt_init_retval != ESP_OK) {
+        ESP_LOGE(TAG, "ABORT. mjd_mqtt_init() failed | err %i (%s)", mqtt_init_retval, esp_err_to_name(mqtt_init_retval));
+        // GOTO
+        goto mqtt_cleanup1;
+    }
+
     // MQTT Start
     f_retval = mjd_mqtt_start(MY_MQTT_HOST, MY_MQTT_PORT, "esp32_mjd_components_main", MY_MQTT_USER, MY_MQTT_PASS);
     if (f_retval != ESP_OK) {
@@ -1140,7 +1176,8 @@ void main_task(void *pvParameter) {
     char topic[] = "meteohub/current/temporary";
 
     char payload[MY_MQTT_BUFFER_SIZE - 1] = ""; // IF task stackoverflow Then increase mqtt buffer size
-    memset(payload, '-', 1024);
+    mjd_strbuf_t payload_strbuf;
+    mjd_strbuf_init(&payload_strbuf, payload, 1024 + 1);
 
     total = 100;  // DEVTEMP 10 25 100 1000 50000
     ESP_LOGI(TAG, "MQTT publish: %i times", total);
@@ -1150,19 +1187,32 @@ void main_task(void *pvParameter) {
 
         mjd_log_memory_statistics();
 
-        /////ESP_LOGI(TAG, "MQTT publish: (%u) topic=%s => (%u) payload=%s \n", strlen(topic), topic, strlen(payload), payload);
+        // Payload: "#<loop>:" + filler up to 1024 chars (rebuilt in place, no malloc)
+        mjd_strbuf_reset(&payload_strbuf);
+        mjd_strbuf_append_char(&payload_strbuf, '#');
+        mjd_strbuf_append_uint(&payload_strbuf, i, 0);
+        mjd_strbuf_append_char(&payload_strbuf, ':');
+        mjd_strbuf_repeat(&payload_strbuf, "-", 1024 - mjd_strbuf_len(&payload_strbuf));
+
+        /////ESP_LOGI(TAG, "MQTT publish: (%u) topic=%s => (%u) payload=%s \n", strlen(topic), topic, mjd_strbuf_len(&payload_strbuf), payload);
 
-        f_retval = mjd_mqtt_publish(topic, (uint8_t *) payload, strlen(payload), MJD_MQTT_QOS_1, false);
+        f_retval = mjd_mqtt_publish(topic, (uint8_t *) payload, mjd_strbuf_len(&payload_strbuf), MJD_MQTT_QOS_1, false);
         if (f_retval != ESP_OK) {
             ESP_LOGE(TAG, "ABORT. mjd_mqtt_publish() failed");
             // GOTO (ERROR)
             goto mqtt_cleanup2;
         }
+        if (i == 1) {
+            mjd_boot_mark("first MQTT publish");
+        }
     }
 
     //---LABEL---
     mqtt_cleanup2: ;
 
+    // @doc Latency histograms of the MQTT publishes (only when CONFIG_MJD_TRACE_ENABLED)
+    mjd_trace_dump();
+
     mjd_log_memory_statistics();
 
     // MQTT Stop
@@ -1178,6 +1228,9 @@ void main_task(void *pvParameter) {
 
     mjd_log_memory_statistics();
 
+    // @doc Boot profile: the init phases and the time from the start of the app to the first MQTT publish
+    mjd_boot_log_report();
+
     // DEVTEMP: HALT
     /////mjd_rtos_wait_forever();
 
@@ -7,6 +7,7 @@
 #include <float.h>
 #include <inttypes.h>
 #include <limits.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -114,9 +115,71 @@ esp_err_t mjd_word_to_binary_string(uint16_t input_word, char * output_string);
  */
 bool mjd_string_starts_with(const char *str, const char *pre);
 bool mjd_string_ends_with(const char *str, const char *post);
-char * mjd_string_repeat(const char * s, int n);
+char * mjd_string_repeat(const char * s, int n); // @important Returns a malloc'd string (the caller must free() it). Use mjd_strbuf_repeat() in loops.
 void mjd_string_prepend(char* param_ptr_string, const char* param_ptr_part);
 
+/**********
+ * NUMBER FORMATTERS (no printf)
+ *
+ * @doc Write the decimal representation + a NULL terminator into param_ptr_output and return the number of chars (excl. the NULL terminator).
+ *      The output buffer must be at least MJD_NUMBER_STRING_MAX_SIZE bytes.
+ * @doc mjd_float_to_fixed_string() is fixed-point: it does not use newlib's float printf path (which is large and slow on the ESP32).
+ *      Supported range: |value| < 4294967040 (uint32_t integer part), max MJD_FLOAT_STRING_MAX_DECIMALS decimals. Out of range => "ovf".
+ *      Rounds half up (printf rounds an exact tie such as 0.125 to even).
+ *
+ * @example mjd_float_to_fixed_string(-3.14159, 2, buf) => "-3.14" (returns 5)
+ */
+#define MJD_NUMBER_STRING_MAX_SIZE   (24)
+#define MJD_FLOAT_STRING_MAX_DECIMALS (6)
+
+size_t mjd_uint32_to_string(uint32_t param_value, char * param_ptr_output);
+size_t mjd_int32_to_string(int32_t param_value, char * param_ptr_output);
+size_t mjd_float_to_fixed_string(float param_value, uint32_t param_decimals, char * param_ptr_output);
+
+/**********
+ * STRING BUILDER (mjd_strbuf)
+ *
+ * @doc A bounded string builder on caller-provided storage (a stack array, a static buffer or a pooled block). It never calls malloc().
+ *      The string is always NULL terminated. The length is tracked so appends do not strlen() the whole string again.
+ * @doc When an operation does not fit then the output is truncated at the capacity, is_truncated is set (sticky until the next reset)
+ *      and the function returns ESP_ERR_INVALID_SIZE.
+ *
+ * @example
+ *      char storage[32];
+ *      mjd_strbuf_t strbuf;
+ *      mjd_strbuf_init(&strbuf, storage, sizeof(storage));
+ *      mjd_strbuf_append(&strbuf, "#");
+ *      mjd_strbuf_append_uint(&strbuf, 12, 0);
+ *      mjd_strbuf_append(&strbuf, " ");
+ *      mjd_strbuf_append_float(&strbuf, 23.456, 6, 2);   // "%6.2f" => "#12  23.46"
+ *      mjd_ssd1306_cmd_write_line(&ssd1306_config, MJD_SSD1306_LINE_NR_1, mjd_strbuf_c_str(&strbuf));
+ */
+typedef struct {
+    char * ptr_buffer;  /*!< Caller-provided storage */
+    size_t size;        /*!< Size of the storage in bytes (incl. the NULL terminator) */
+    size_t len;         /*!< Current string length (excl. the NULL terminator) */
+    bool is_truncated;  /*!< An operation did not fit since the last reset */
+} mjd_strbuf_t;
+
+esp_err_t mjd_strbuf_init(mjd_strbuf_t* param_ptr_strbuf, char * param_ptr_storage, size_t param_size);
+void mjd_strbuf_reset(mjd_strbuf_t* param_ptr_strbuf);
+esp_err_t mjd_strbuf_append(mjd_strbuf_t* param_ptr_strbuf, const char * param_ptr_string);
+esp_err_t mjd_strbuf_append_n(mjd_strbuf_t* param_ptr_strbuf, const char * param_ptr_chars, size_t param_len);
+esp_err_t mjd_strbuf_append_char(mjd_strbuf_t* param_ptr_strbuf, char param_char);
+esp_err_t mjd_strbuf_prepend(mjd_strbuf_t* param_ptr_strbuf, const char * param_ptr_string);
+esp_err_t mjd_strbuf_repeat(mjd_strbuf_t* param_ptr_strbuf, const char * param_ptr_string, uint32_t param_count);
+esp_err_t mjd_strbuf_append_uint(mjd_strbuf_t* param_ptr_strbuf, uint32_t param_value, uint32_t param_min_width);
+esp_err_t mjd_strbuf_append_int(mjd_strbuf_t* param_ptr_strbuf, int32_t param_value, uint32_t param_min_width);
+esp_err_t mjd_strbuf_append_float(mjd_strbuf_t* param_ptr_strbuf, float param_value, uint32_t param_min_width, uint32_t param_decimals);
+
+static inline const char * mjd_strbuf_c_str(const mjd_strbuf_t* param_ptr_strbuf) {
+    return param_ptr_strbuf->ptr_buffer;
+}
+
+static inline size_t mjd_strbuf_len(const mjd_strbuf_t* param_ptr_strbuf) {
+    return param_ptr_strbuf->len;
+}
+
 /**********
  * HEX STRINGS
  */
@@ -129,7 +192,8 @@ esp_err_t mjd_uint8s_to_hexstring(const uint8_t * param_ptr_input, size_t param_
 
 /*
  * @example "00010E0FF0F1FEFF" = [0 0x00, 1 0x01, 14 0x0e, 15 0x0f, 240 0xf0, 241 0xf1, 254 0xfe, 255 0xff] => "00010E0FF0F1FEFF"
- * @dep param_ptr_output must point to an array of uint8 at least HALF the size of the param_ptr_input buffer PLUS 1
+ * @dep param_ptr_output must point to an array of uint8 at least HALF the size of the param_ptr_input buffer
+ * @return ESP_ERR_INVALID_SIZE for an uneven number of characters, ESP_ERR_INVALID_ARG for a non-hex character (upper and lower case are accepted)
  */
 esp_err_t mjd_hexstring_to_uint8s(const char * param_ptr_input, size_t param_len_input, uint8_t * param_ptr_output);
 
@@ -141,10 +205,17 @@ esp_err_t mjd_string_to_hexstring(const char * param_ptr_input, size_t param_len
 
 /*
  * @example "414243" => "ABC"
- * @dep param_ptr_output must point to an array of chars at least HALF the size of the param_ptr_input buffer PLUS 1
+ * @dep param_ptr_output must point to an array of at least (param_len_input / 2) + 1 chars
+ * @important The NULL terminator is written at param_ptr_output[param_len_input / 2]
  */
 esp_err_t mjd_hexstring_to_string(const char * param_ptr_input, size_t param_len_input, char * param_ptr_output);
 
+/*
+ * @brief Streaming variant of mjd_uint8s_to_hexstring(): writes the hex chars directly to the UART (no NULL terminator, no output buffer)
+ * @example [0x41, 0x42] => uart_write_bytes("4142")
+ */
+esp_err_t mjd_uint8s_to_hexstring_uart(uart_port_t param_uart_num, const uint8_t * param_ptr_input, size_t param_len_input);
+
 /**********
  * CRYPTO
  */
@@ -233,9 +233,14 @@ void peripheral_task(void *pvParameter) {
         // OLED
         if (MY_SSD1306_OLED_ENABLED == 1) {
             char str_line[80];
-            sprintf(str_line, "#%u ppm:", j);
+            mjd_strbuf_t line_strbuf;
+            mjd_strbuf_init(&line_strbuf, str_line, sizeof(str_line));
+            mjd_strbuf_append_char(&line_strbuf, '#');
+            mjd_strbuf_append_uint(&line_strbuf, j, 0);
+            mjd_strbuf_append(&line_strbuf, " ppm:");
             mjd_ssd1306_cmd_write_line(&ssd1306_config, MJD_SSD1306_LINE_NR_1, str_line);
-            sprintf(str_line, "%6.1f", scd30_data.co2_ppm);
+            mjd_strbuf_reset(&line_strbuf);
+            mjd_strbuf_append_float(&line_strbuf, scd30_data.co2_ppm, 6, 1);
             mjd_ssd1306_cmd_write_line(&ssd1306_config, MJD_SSD1306_LINE_NR_2, str_line);
         }
 
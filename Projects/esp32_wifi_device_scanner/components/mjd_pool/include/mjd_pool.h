@@ -0,0 +1,113 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+#ifndef __MJD_POOL_H__
+#define __MJD_POOL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Includes: system, own
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "freertos/FreeRTOS.h"
+
+/**********
+ * ALIGNMENT & STORAGE
+ *
+ * @doc Every block and every arena allocation is aligned to 8 bytes (uint64_t, double).
+ * @doc The storage is provided by the caller (static memory, or one malloc at boot) so the pools never touch the heap afterwards.
+ *
+ * @example
+ *      MJD_POOL_DEFINE_STORAGE(_stations_pool_storage, sizeof(station_info_t), 128);
+ *      mjd_pool_init(&_stations_pool, "stations", _stations_pool_storage, sizeof(station_info_t), 128);
+ */
+#define MJD_POOL_ALIGNMENT (8)
+
+#define MJD_POOL_BLOCK_SIZE(size) \
+    ((((size) < sizeof(void *) ? sizeof(void *) : (size)) + MJD_POOL_ALIGNMENT - 1) & ~((size_t) MJD_POOL_ALIGNMENT - 1))
+
+#define MJD_POOL_STORAGE_SIZE(block_size, nbr_of_blocks) \
+    (MJD_POOL_BLOCK_SIZE(block_size) * (nbr_of_blocks))
+
+#define MJD_POOL_DEFINE_STORAGE(name, block_size, nbr_of_blocks) \
+    static uint64_t name[(MJD_POOL_STORAGE_SIZE(block_size, nbr_of_blocks) + sizeof(uint64_t) - 1) / sizeof(uint64_t)]
+
+#define MJD_ARENA_DEFINE_STORAGE(name, size) \
+    static uint64_t name[((size) + sizeof(uint64_t) - 1) / sizeof(uint64_t)]
+
+/**********
+ * FIXED-BLOCK POOL
+ *
+ * @doc O(1) alloc and free of equally sized blocks from an intrusive free list. No fragmentation: a freed block is reused as is.
+ *
+ * @important Thread safe (spinlock): a pool can be shared by RTOS tasks on both cores.
+ *            The poisoning memsets of CONFIG_MJD_POOL_DEBUG_POISON run outside the critical section.
+ */
+typedef struct {
+    uint32_t nbr_of_blocks;        /*!< Capacity */
+    uint32_t nbr_in_use;           /*!< Blocks allocated right now */
+    uint32_t high_water_mark;      /*!< Max nbr_in_use since the init */
+    uint32_t nbr_of_allocs;        /*!< Successful allocations */
+    uint32_t nbr_of_failed_allocs; /*!< Allocations that returned NULL (pool exhausted) */
+} mjd_pool_stats_t;
+
+typedef struct {
+    const char * name;      /*!< For the logs */
+    uint8_t * ptr_storage;  /*!< Caller-provided storage, MJD_POOL_STORAGE_SIZE() bytes */
+    size_t block_size;      /*!< Rounded up with MJD_POOL_BLOCK_SIZE() */
+    uint32_t nbr_of_blocks;
+    void * ptr_free_list;   /*!< The first free block; each free block starts with the pointer to the next one */
+    mjd_pool_stats_t stats;
+    portMUX_TYPE spinlock;
+} mjd_pool_t;
+
+esp_err_t mjd_pool_init(mjd_pool_t* param_ptr_pool, const char * param_ptr_name, void * param_ptr_storage, size_t param_block_size,
+                        uint32_t param_nbr_of_blocks);
+void * mjd_pool_alloc(mjd_pool_t* param_ptr_pool);
+esp_err_t mjd_pool_free(mjd_pool_t* param_ptr_pool, void * param_ptr_block);
+bool mjd_pool_owns(const mjd_pool_t* param_ptr_pool, const void * param_ptr);
+esp_err_t mjd_pool_get_stats(mjd_pool_t* param_ptr_pool, mjd_pool_stats_t* param_ptr_stats);
+void mjd_pool_log_stats(mjd_pool_t* param_ptr_pool);
+
+/**********
+ * BUMP ARENA
+ *
+ * @doc Allocations of any size that are released all at once with mjd_arena_reset(), e.g. the scratch buffers of one
+ *      sensor-read-and-publish cycle or the setup buffers of a driver. An allocation is one add and one compare.
+ */
+typedef struct {
+    size_t size;                   /*!< Capacity (bytes) */
+    size_t used;                   /*!< Bytes allocated since the last reset (incl. the alignment padding) */
+    size_t high_water_mark;        /*!< Max used since the init */
+    uint32_t nbr_of_failed_allocs; /*!< Allocations that returned NULL (arena full) */
+} mjd_arena_stats_t;
+
+typedef struct {
+    const char * name;
+    uint8_t * ptr_storage;
+    size_t size;
+    size_t used;
+    mjd_arena_stats_t stats;
+    portMUX_TYPE spinlock;
+} mjd_arena_t;
+
+esp_err_t mjd_arena_init(mjd_arena_t* param_ptr_arena, const char * param_ptr_name, void * param_ptr_storage, size_t param_size);
+void * mjd_arena_alloc(mjd_arena_t* param_ptr_arena, size_t param_size);
+void mjd_arena_reset(mjd_arena_t* param_ptr_arena);
+esp_err_t mjd_arena_get_stats(mjd_arena_t* param_ptr_arena, mjd_arena_stats_t* param_ptr_stats);
+void mjd_arena_log_stats(mjd_arena_t* param_ptr_arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_POOL_H__ */
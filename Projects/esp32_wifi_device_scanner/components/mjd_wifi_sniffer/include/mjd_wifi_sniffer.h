@@ -0,0 +1,60 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+#ifndef __MJD_WIFI_SNIFFER_H__
+#define __MJD_WIFI_SNIFFER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_wifi.h"
+
+#include "mjd_wifi_sniffer_core.h"
+
+/**********
+ * SETTINGS
+ *
+ * @important The hardware timer (Kconfig) must not be used by another component:
+ *            TIMER_GROUP_0 TIMER_0 = mjd_mlx90393, TIMER_GROUP_0 TIMER_1 = mjd_ads1115, TIMER_GROUP_1 TIMER_0 = mjd_gpio_events.
+ */
+#define MJD_WIFI_SNIFFER_TIMER_GROUP_ID  ((timer_group_t) CONFIG_MJD_WIFI_SNIFFER_TIMER_GROUP_ID)
+#define MJD_WIFI_SNIFFER_TIMER_ID        ((timer_idx_t) CONFIG_MJD_WIFI_SNIFFER_TIMER_ID)
+
+#define MJD_WIFI_SNIFFER_HOPPER_TASK_STACK_SIZE (3072)
+
+/**
+ * @brief The configuration of the sniffer.
+ */
+typedef struct {
+    mjd_wifi_sniffer_hop_config_t hop_config;
+    uint32_t filter_mask;           /*!< WIFI_PROMIS_FILTER_MASK_MGMT | WIFI_PROMIS_FILTER_MASK_DATA ... (a bit mask: use |) */
+    UBaseType_t hopper_task_priority; /*!< Above the consumer task: a late channel switch stretches the dwell */
+} mjd_wifi_sniffer_config_t;
+
+#define MJD_WIFI_SNIFFER_CONFIG_DEFAULT() { \
+    .hop_config = MJD_WIFI_SNIFFER_HOP_CONFIG_DEFAULT(), \
+    .filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT, \
+    .hopper_task_priority = (RTOS_TASK_PRIORITY_NORMAL + 1), \
+}
+
+/**
+ * Function declarations
+ *
+ * @important Call esp_wifi_init() + esp_wifi_set_mode(WIFI_MODE_STA) first (and do not connect to an AP: the sniffer owns the channel).
+ * @important mjd_wifi_sniffer_receive() + mjd_wifi_sniffer_reset_window() are for 1 consumer task.
+ */
+esp_err_t mjd_wifi_sniffer_init(const mjd_wifi_sniffer_config_t* param_ptr_config);
+esp_err_t mjd_wifi_sniffer_deinit(void);
+esp_err_t mjd_wifi_sniffer_receive(mjd_wifi_sniffer_frame_t* param_ptr_frame, TickType_t param_ticks_to_wait);
+esp_err_t mjd_wifi_sniffer_get_channel_stats(uint8_t param_channel, mjd_wifi_sniffer_channel_stats_t* param_ptr_stats);
+uint32_t mjd_wifi_sniffer_get_unique_devices(void);
+esp_err_t mjd_wifi_sniffer_reset_window(void);
+void mjd_wifi_sniffer_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_WIFI_SNIFFER_H__ */
@@ -0,0 +1,141 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+#ifndef __MJD_WIFI_SNIFFER_CORE_H__
+#define __MJD_WIFI_SNIFFER_CORE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * CHANNEL QUEUES + HOP SCHEDULER + UNIQUE DEVICES
+ *
+ * @doc Pure logic (no WiFi, no timer, no RTOS) so the host tests can drive it with synthetic captures:
+ *      - The promiscuous RX callback (WiFi task) calls mjd_wifi_sniffer_core_capture() with the compact frame: it goes into the
+ *        queue of its channel. A full queue drops the frame and counts it.
+ *      - The consumer task calls mjd_wifi_sniffer_core_receive(): round robin over the channel queues, so a busy channel cannot
+ *        starve the others. It also marks the source MAC in the unique-device bitmaps.
+ *      - The hopper calls mjd_wifi_sniffer_core_next_hop() at the end of each dwell: it closes the dwell (the packet rate of that
+ *        channel) and returns the next channel and its dwell time.
+ * @doc Each queue is a lock-free ring buffer for 1 producer (the RX callback) and 1 consumer (the consumer task):
+ *      the producer only writes head, the consumer only writes tail.
+ */
+
+/**
+ * @brief The channels 1..14 (2.4GHz).
+ */
+#define MJD_WIFI_SNIFFER_MAX_CHANNELS (14)
+
+/**
+ * @brief The unique-device estimates (linear counting): a bitmap of hashed MAC addresses. The estimate is accurate (a few %) up to
+ *        about the number of bits, and saturates at a few times that. Reset the window (mjd_wifi_sniffer_core_reset_window()) in time.
+ */
+#define MJD_WIFI_SNIFFER_UNIQUE_BITS_PER_CHANNEL (512)
+#define MJD_WIFI_SNIFFER_UNIQUE_BITS_TOTAL       (2048)
+
+/**
+ * @brief A captured frame: only the fields that a device scanner needs (16 bytes instead of a copy of the whole packet).
+ */
+typedef struct {
+    uint8_t source_mac[6];  /*!< Address 2 of the 802.11 header (the transmitter) */
+    uint8_t channel;        /*!< rx_ctrl.channel */
+    int8_t rssi;            /*!< rx_ctrl.rssi */
+    uint8_t frame_control;  /*!< The first byte of the 802.11 header (type + subtype), e.g. 0x40 = probe request */
+    uint8_t reserved[3];
+    uint32_t timestamp_us;  /*!< rx_ctrl.timestamp: the local time of the MAC (wraps) */
+} mjd_wifi_sniffer_frame_t;
+
+/**
+ * @brief The hop scheduler.
+ *
+ * @doc Every channel is visited once per cycle (in the order of channels[]), so no channel is starved. A channel gets min_dwell_ms plus a
+ *      share of the rest of cycle_ms that is proportional to its packet rate (+ 1 frame/sec, so quiet channels keep a share),
+ *      max max_dwell_ms. The packet rate is an EWMA (1/4) of the frames per second during its dwells.
+ */
+typedef struct {
+    uint8_t channels[MJD_WIFI_SNIFFER_MAX_CHANNELS]; /*!< The hop order */
+    uint32_t nbr_of_channels;
+    uint32_t cycle_ms;          /*!< The time of a round over all channels (when no dwell is clipped) */
+    uint32_t min_dwell_ms;
+    uint32_t max_dwell_ms;
+} mjd_wifi_sniffer_hop_config_t;
+
+#define MJD_WIFI_SNIFFER_HOP_CONFIG_DEFAULT() { \
+    .channels = { 1, 6, 11, 2, 7, 12, 3, 8, 13, 4, 9, 5, 10 }, \
+    .nbr_of_channels = 13, \
+    .cycle_ms = 3900, \
+    .min_dwell_ms = 100, \
+    .max_dwell_ms = 1000, \
+}
+
+/**
+ * @brief The telemetry of a channel.
+ */
+typedef struct {
+    uint32_t nbr_of_frames;         /*!< Captured on this channel (queued + dropped) */
+    uint32_t nbr_of_drops;          /*!< The queue of the channel was full */
+    float packet_rate;              /*!< Frames per second while the radio is on this channel (EWMA) */
+    uint32_t nbr_of_unique_devices; /*!< Estimate since the last reset of the window */
+    uint32_t nbr_of_dwells;
+    uint32_t total_dwell_ms;
+    uint32_t last_dwell_ms;         /*!< The dwell that the scheduler planned the last time */
+} mjd_wifi_sniffer_channel_stats_t;
+
+/**
+ * @brief The queue of a channel. All fields are Private.
+ */
+typedef struct {
+    mjd_wifi_sniffer_frame_t frames[CONFIG_MJD_WIFI_SNIFFER_QUEUE_LENGTH];
+    volatile uint32_t head;         /*!< Written by the producer only: free running, slot = head & (length - 1) */
+    volatile uint32_t tail;         /*!< Written by the consumer only */
+} mjd_wifi_sniffer_queue_t;
+
+/**
+ * @brief A channel. All fields are Private.
+ */
+typedef struct {
+    mjd_wifi_sniffer_queue_t queue;
+    volatile uint32_t nbr_of_frames;   /*!< Producer */
+    volatile uint32_t nbr_of_drops;    /*!< Producer */
+    uint32_t frames_at_dwell_start;    /*!< Hopper */
+    uint32_t rate_x16;                 /*!< Hopper: EWMA frames per second * 16 */
+    uint32_t last_dwell_ms;            /*!< Hopper */
+    uint32_t nbr_of_dwells;            /*!< Hopper */
+    uint32_t total_dwell_ms;           /*!< Hopper */
+    uint32_t unique_bitmap[MJD_WIFI_SNIFFER_UNIQUE_BITS_PER_CHANNEL / 32]; /*!< Consumer */
+} mjd_wifi_sniffer_channel_t;
+
+/**
+ * @brief The sniffer. All fields are Private.
+ */
+typedef struct {
+    mjd_wifi_sniffer_hop_config_t config;
+    mjd_wifi_sniffer_channel_t channels[MJD_WIFI_SNIFFER_MAX_CHANNELS]; /*!< [channel - 1] */
+    uint32_t hop_idx;                  /*!< config.channels[hop_idx] is the current channel */
+    bool is_hopping;
+    uint32_t next_receive_idx;
+    volatile uint32_t nbr_of_invalid;  /*!< Frames with a channel outside 1..14 */
+    uint32_t unique_total_bitmap[MJD_WIFI_SNIFFER_UNIQUE_BITS_TOTAL / 32];
+} mjd_wifi_sniffer_core_t;
+
+/**
+ * Function declarations
+ */
+esp_err_t mjd_wifi_sniffer_core_init(mjd_wifi_sniffer_core_t* param_ptr_core, const mjd_wifi_sniffer_hop_config_t* param_ptr_config);
+bool mjd_wifi_sniffer_core_capture(mjd_wifi_sniffer_core_t* param_ptr_core, const mjd_wifi_sniffer_frame_t* param_ptr_frame);
+bool mjd_wifi_sniffer_core_receive(mjd_wifi_sniffer_core_t* param_ptr_core, mjd_wifi_sniffer_frame_t* param_ptr_frame);
+void mjd_wifi_sniffer_core_next_hop(mjd_wifi_sniffer_core_t* param_ptr_core, uint32_t param_elapsed_ms, uint8_t * param_ptr_channel,
+                                    uint32_t * param_ptr_dwell_ms);
+esp_err_t mjd_wifi_sniffer_core_get_channel_stats(const mjd_wifi_sniffer_core_t* param_ptr_core, uint8_t param_channel,
+                                                  mjd_wifi_sniffer_channel_stats_t* param_ptr_stats);
+uint32_t mjd_wifi_sniffer_core_get_unique_devices(const mjd_wifi_sniffer_core_t* param_ptr_core);
+void mjd_wifi_sniffer_core_reset_window(mjd_wifi_sniffer_core_t* param_ptr_core);
+uint32_t mjd_wifi_sniffer_estimate_unique(const uint32_t * param_ptr_bitmap, uint32_t param_nbr_of_bits);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_WIFI_SNIFFER_CORE_H__ */
@@ -1,11 +1,9 @@
 #include "mjd.h"
 #include "mjd_list.h"
 #include "mjd_net.h"
+#include "mjd_pool.h"
 #include "mjd_wifi.h"
-
-#include "driver/timer.h"
-#include "esp_timer.h"
-#include "freertos/ringbuf.h"
+#include "mjd_wifi_sniffer.h"
 
 #include "include/mac_addresses.h"
 
@@ -29,10 +27,11 @@ static const int MY_LED_ON_DEVBOARD_WIRING_TYPE = CONFIG_MY_LED_ON_DEVBOARD_WIRI
 /*
  * defines typedefs vars
  */
-RingbufHandle_t *ringbuf_packet;
-
 static SemaphoreHandle_t _stations_data_semaphore = NULL;
 
+// @doc The purger asks, the parser task (the consumer of the sniffer) starts a new unique-devices window
+static volatile bool _is_sniffer_window_reset_requested = false;
+
 typedef struct {
     uint8_t bssid[6];
     uint8_t channel;
@@ -42,24 +41,22 @@ typedef struct {
     struct mjd_list_head list; // Linked List
 } station_info_t;
 
-typedef struct {
-    uint8_t header[4];
-    uint8_t dest_mac[6];
-    uint8_t source_mac[6];
-    uint8_t bssid[6];
-    uint8_t payload[0];
-} payload_t;
-
 static MJD_LIST_HEAD(_stations_list);
 
+// Station entries: a fixed-block pool instead of a malloc() per new station (no heap fragmentation over weeks of uptime)
+// @rule Size it with the high-water mark that _log_stations() reports after a busy day
+#define STATIONS_POOL_NBR_OF_BLOCKS (256)
+static mjd_pool_t _stations_pool;
+MJD_POOL_DEFINE_STORAGE(_stations_pool_storage, sizeof(station_info_t), STATIONS_POOL_NBR_OF_BLOCKS);
+
 // Purge params
 // @rule Purge period > STA max age
 const uint32_t STATION_MAXIMUM_AGE_MINUTES = 14; // DEV 1 minutes, PRD 14 minutes
 const uint32_t STATION_PURGE_PERIOD_MINUTES = 15; // DEV 2 minutes, PRD 15 minutes
 
-// Wifi Channel switcher params
-// @doc Change channel regularly to find all devices
-const uint32_t CHANNEL_SWITCHER_PERIOD_MS = RTOS_DELAY_1SEC;
+// Wifi sniffer params
+// @doc mjd_wifi_sniffer hops over all channels on a hardware timer: busy channels get longer dwells, every channel is visited each cycle
+const uint32_t SNIFFER_CYCLE_MS = 3900;
 
 /*
  * Helper funcs
@@ -84,31 +81,6 @@ static esp_err_t _wifi_event_handler(void *ctx, system_event_t *event) {
     return ESP_OK;
 }
 
-static IRAM_ATTR void _promiscuous_rx_cb(void *recv_buf, wifi_promiscuous_pkt_type_t type) {
-    wifi_promiscuous_pkt_t *ptr_packet = (wifi_promiscuous_pkt_t *) recv_buf;
-    // @doc packet= wifi_pkt_rx_ctrl_t + payload. Length of payload is described by rx_ctrl.sig_len
-    size_t len_packet = sizeof(wifi_pkt_rx_ctrl_t) + ptr_packet->rx_ctrl.sig_len;
-
-    // DEVTEMP
-    printf(".");
-    fflush(stdout);
-
-    // DEVTEMP
-    /*printf("[CB: len_packet=%u]", len_packet); fflush(stdout);*/
-    /*payload_t *ptr_payload = (payload_t *) ptr_packet->payload;
-     printf("[CB: len_packet=%u MAC "MJDMACFMT"]", len_packet, MJDMAC2STR(ptr_payload->source_mac)); fflush(stdout);*/
-
-    BaseType_t bt_retval = xRingbufferSend(ringbuf_packet, ptr_packet, len_packet, portMAX_DELAY);
-    if (bt_retval != pdTRUE) {
-        ESP_LOGE(TAG, "xRingbufferSend() err %d ?time-out or output buffer too large?", bt_retval);
-        // GOTO
-        goto cleanup;
-    }
-
-    // LABEL
-    cleanup: ;
-}
-
 /*
  * TASK
  */
@@ -119,9 +91,7 @@ static void _packet_parser_task(void *pvParameter) {
      * Reuseable variables
      *
      */
-    wifi_promiscuous_pkt_t *ptr_packet;
-    size_t len_packet;
-    payload_t *ptr_payload;
+    mjd_wifi_sniffer_frame_t frame;
     station_info_t *ptr_one_station = NULL;
 
     /********************************************************************************
@@ -129,32 +99,27 @@ static void _packet_parser_task(void *pvParameter) {
      *
      */
     while (1) {
-        // TAKE Mutex!
-        xSemaphoreTake(_stations_data_semaphore, portMAX_DELAY);
-
-        // DEVTEMP
-        /////printf("[parser]"); fflush(stdout);
-
-        // Ringbuffer RX
-        ptr_packet = (wifi_promiscuous_pkt_t *) xRingbufferReceive(ringbuf_packet, &len_packet, portMAX_DELAY);
-        if (ptr_packet == NULL) {
-            ESP_LOGE(TAG, "xRingbufferReceive() err TIMEOUT");
-            // GOTO
-            goto cleanup_inside_loop;
-
+        // WAIT for a frame (outside the mutex: the purger must not wait for the next frame)
+        if (mjd_wifi_sniffer_receive(&frame, RTOS_DELAY_1SEC) != ESP_OK) {
+            frame.channel = 0; // @doc No frame (timeout): only check the window reset below
+        }
+        if (_is_sniffer_window_reset_requested == true) {
+            mjd_wifi_sniffer_reset_window();
+            _is_sniffer_window_reset_requested = false;
+        }
+        if (frame.channel == 0) {
+            continue;
         }
-        ptr_payload = (payload_t *) ptr_packet->payload;
 
-        // DEVTEMP
-        /*printf("[CB: len_packet=%u]", len_packet); fflush(stdout);*/
-        /*printf("[CB: len_packet=%u MAC "MJDMACFMT"]", len_packet, MJDMAC2STR(ptr_payload->source_mac)); fflush(stdout);*/
+        // TAKE Mutex!
+        xSemaphoreTake(_stations_data_semaphore, portMAX_DELAY);
 
         /* Filter out non-people sources (some ESP32 boards and some network equipment) */
         for (int i = 0; i < ARRAY_SIZE(not_people_mac_addresses); ++i) {
-            if (memcmp(ptr_payload->source_mac, not_people_mac_addresses[i], 3) == 0) {  // first 3 bytes (not all 6!)
+            if (memcmp(frame.source_mac, not_people_mac_addresses[i], 3) == 0) {  // first 3 bytes (not all 6!)
                 /*ESP_LOGD(TAG, "Ignored a non-people source");
-                 ESP_LOGD(TAG, "  header[0]: %hhu\n", ptr_payload->header[0]);
-                 ESP_LOGD(TAG, "  MAC: "MJDMACFMT", rssi: %i", MJDMAC2STR(ptr_payload->source_mac), ptr_packet->rx_ctrl.rssi);*/
+                 ESP_LOGD(TAG, "  frame_control: 0x%02X\n", frame.frame_control);
+                 ESP_LOGD(TAG, "  MAC: "MJDMACFMT", rssi: %i", MJDMAC2STR(frame.source_mac), frame.rssi);*/
                 // GOTO
                 goto cleanup_inside_loop;
             }
@@ -163,10 +128,10 @@ static void _packet_parser_task(void *pvParameter) {
         /* Process already detected devices: update timestamp */
         mjd_list_for_each_entry(ptr_one_station, &_stations_list, list)
         {
-            if (memcmp(ptr_one_station->bssid, ptr_payload->source_mac, sizeof(ptr_one_station->bssid)) == 0) { // all 6 bytes
+            if (memcmp(ptr_one_station->bssid, frame.source_mac, sizeof(ptr_one_station->bssid)) == 0) { // all 6 bytes
                 ESP_LOGD(TAG, "Update a device that was already detected");
-                ptr_one_station->channel = ptr_packet->rx_ctrl.channel;
-                ptr_one_station->rssi = ptr_packet->rx_ctrl.rssi;
+                ptr_one_station->channel = frame.channel;
+                ptr_one_station->rssi = frame.rssi;
                 ptr_one_station->timestamp_ms = _get_log_timestamp64(); // 64b milliseconds
                 mjd_get_current_time_yyyymmddhhmmss(ptr_one_station->timestamp_str); // fmt datetime string
                 // log
@@ -180,10 +145,16 @@ static void _packet_parser_task(void *pvParameter) {
         }
         /* Add the device information to list */
         ESP_LOGI(TAG, "Adding a new device");
-        ptr_one_station = malloc(sizeof(*ptr_one_station));
-        memcpy(ptr_one_station->bssid, ptr_payload->source_mac, sizeof(ptr_one_station->bssid));
-        ptr_one_station->channel = ptr_packet->rx_ctrl.channel;
-        ptr_one_station->rssi = ptr_packet->rx_ctrl.rssi;
+        ptr_one_station = mjd_pool_alloc(&_stations_pool);
+        if (ptr_one_station == NULL) {
+            ESP_LOGW(TAG, "  The stations pool is full (%u): ignored bssid/MAC "MJDMACFMT, STATIONS_POOL_NBR_OF_BLOCKS,
+                    MJDMAC2STR(frame.source_mac));
+            // GOTO
+            goto cleanup_inside_loop;
+        }
+        memcpy(ptr_one_station->bssid, frame.source_mac, sizeof(ptr_one_station->bssid));
+        ptr_one_station->channel = frame.channel;
+        ptr_one_station->rssi = frame.rssi;
         ptr_one_station->timestamp_ms = _get_log_timestamp64(); // 64b milliseconds
         mjd_get_current_time_yyyymmddhhmmss(ptr_one_station->timestamp_str);
         mjd_list_add_tail(&ptr_one_station->list, &_stations_list);  // add_tail!
@@ -197,12 +168,6 @@ static void _packet_parser_task(void *pvParameter) {
 
         // GIVE Mutex!
         xSemaphoreGive(_stations_data_semaphore);
-
-        // Return RB
-        if (ptr_packet != NULL) {
-            vRingbufferReturnItem(ringbuf_packet, ptr_packet);
-        }
-
     }
 
     /********************************************************************************
@@ -210,78 +175,6 @@ static void _packet_parser_task(void *pvParameter) {
      * Task Cleanup & Delete
      * @doc Passing NULL will end the current task
      */
-    vRingbufferDelete(ringbuf_packet);
-    vTaskDelete(NULL);
-}
-
-static void _wifi_channel_switcher_task(void *pvParameter) {
-    ESP_LOGD(TAG, "%s()", __FUNCTION__);
-
-    /********************************************************************************
-     * Reuseable variables
-     *
-     */
-    esp_err_t f_retval;
-
-    /********************************************************************************
-     * INIT
-     */
-
-    /********************************************************************************
-     * MAIN
-     * Channels: 1..13 switch every 100ms
-     * Bandwidth: always HT40 (no HT20 narrow bands on ESP32)
-     *
-     */
-    const uint8_t MIN_CHANNEL_ID = 1;  // The min channel on EU Routers
-    const uint8_t MAX_CHANNEL_ID = 11; // The max channel on EU Routers
-    uint8_t primary_channel = MIN_CHANNEL_ID;
-    const wifi_second_chan_t secondary_channel = WIFI_SECOND_CHAN_NONE;
-    while (1) {
-        f_retval = esp_wifi_set_channel(primary_channel, secondary_channel);
-        if (f_retval != ESP_OK) {
-            ESP_LOGE(TAG, "esp_wifi_set_channel() err %d %s", f_retval, esp_err_to_name(f_retval));
-            // GOTO
-            goto cleanup_inside_loop;
-        }
-        ESP_LOGD(TAG, "[SWTCH: CH %u (%u)]", primary_channel, secondary_channel);
-
-        // DEBUG
-        /*uint8_t get_primary_channel;
-         wifi_second_chan_t get_secondary_channel;
-         f_retval = esp_wifi_get_channel(&get_primary_channel, &get_secondary_channel);
-         if (f_retval != ESP_OK) {
-         ESP_LOGE(TAG, "esp_wifi_get_channel() err %d %s", f_retval, esp_err_to_name(f_retval));
-         // GOTO
-         goto cleanup_inside_loop;
-         }
-         wifi_bandwidth_t get_bandwidth;
-         f_retval = esp_wifi_get_bandwidth(WIFI_MODE_STA, &get_bandwidth);
-         if (f_retval != ESP_OK) {
-         ESP_LOGE(TAG, "esp_wifi_get_bandwidth() err %d %s", f_retval, esp_err_to_name(f_retval));
-         // GOTO
-         goto cleanup_inside_loop;
-         }
-         printf("[MON: CH %u (%u)| BW %u]", get_primary_channel, get_secondary_channel, get_bandwidth);
-         fflush(stdout);*/
-
-        // LABEL
-        cleanup_inside_loop: ;
-
-        // WAIT
-        vTaskDelay(CHANNEL_SWITCHER_PERIOD_MS);
-
-        // NEXT
-        if (++primary_channel > MAX_CHANNEL_ID) {
-            primary_channel = MIN_CHANNEL_ID;
-        }
-    }
-
-    /********************************************************************************
-     * TODO NEVER GETS HERE...
-     * Task Delete
-     * @doc Passing NULL will end the current task
-     */
     vTaskDelete(NULL);
 }
 
@@ -291,6 +184,7 @@ static void _log_stations() {
     uint32_t nbr_of_stations;
     mjd_list_count(&_stations_list, &nbr_of_stations);
     ESP_LOGI(TAG, "#Stations: %u", nbr_of_stations);
+    mjd_pool_log_stats(&_stations_pool);
 
     station_info_t *ptr_one_station = NULL;
     mjd_list_for_each_entry(ptr_one_station, &_stations_list, list)
@@ -331,7 +225,7 @@ static void _purge_stations() {
                     MJDMAC2STR(ptr_one_station->bssid), ptr_one_station->channel, ptr_one_station->rssi,
                     ptr_one_station->timestamp_ms, ptr_one_station->timestamp_str);
             mjd_list_del(&ptr_one_station->list);
-            free(ptr_one_station);
+            mjd_pool_free(&_stations_pool, ptr_one_station);
         }
     }
 
@@ -371,6 +265,8 @@ static void _station_purger_task(void *pvParameter) {
         // MAIN
         _purge_stations();
         _log_stations();
+        mjd_wifi_sniffer_log_stats();
+        _is_sniffer_window_reset_requested = true;
 
         // GIVE Mutex!
         xSemaphoreGive(_stations_data_semaphore);
@@ -444,24 +340,12 @@ void app_main() {
     // INIT Mutex data_stations
     _stations_data_semaphore = xSemaphoreCreateMutex();
 
-    // INIT RingBuffer
-    //  @doc Wifi promiscious packets are variable length
-    ringbuf_packet = xRingbufferCreate(12 * 1024, RINGBUF_TYPE_NOSPLIT);
-    if (ringbuf_packet == NULL) {
-        ESP_LOGE(TAG, "xRingbufferCreate() returned NULL pointer");
-        // GOTO
-        goto cleanup;
-    }
-
-    // TASK MGT: packet_parser_task
-    xReturned = xTaskCreatePinnedToCore(&_packet_parser_task, "_packet_parser_task (name)", MYAPP_RTOS_TASK_STACK_SIZE_16K,
-    NULL,
-    MYAPP_RTOS_TASK_PRIORITY_NORMAL, NULL, APP_CPU_NUM);
-    if (xReturned != pdPASS) {
-        ESP_LOGE(TAG, "Cannot create task _packet_parser_task");
+    // INIT Pool station entries
+    f_retval = mjd_pool_init(&_stations_pool, "stations", _stations_pool_storage, sizeof(station_info_t), STATIONS_POOL_NBR_OF_BLOCKS);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "mjd_pool_init() err %i (%s)", f_retval, esp_err_to_name(f_retval));
         // GOTO
         goto cleanup;
-
     }
 
     // wifi init
@@ -493,46 +377,27 @@ void app_main() {
         goto cleanup;
     }
 
-    // wifi kick off promiscious RX callback
-    // @important Include only MGMT and AMPDU packets (low volume). Exclude DATA packets (too high volume!)
-    f_retval = esp_wifi_set_promiscuous(false);
+    // wifi sniffer: promiscuous RX + channel hopping
+    // @important Include only MGMT packets (low volume: probe requests + beacons). Exclude DATA packets (too high volume!)
+    mjd_wifi_sniffer_config_t sniffer_config = MJD_WIFI_SNIFFER_CONFIG_DEFAULT();
+    sniffer_config.hop_config.cycle_ms = SNIFFER_CYCLE_MS;
+    sniffer_config.filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT;
+    f_retval = mjd_wifi_sniffer_init(&sniffer_config);
     if (f_retval != ESP_OK) {
-        ESP_LOGE(TAG, "esp_wifi_set_promiscuous(false) err %d %s\n", f_retval, esp_err_to_name(f_retval));
+        ESP_LOGE(TAG, "mjd_wifi_sniffer_init() err %d %s", f_retval, esp_err_to_name(f_retval));
         // GOTO
         goto cleanup;
     }
 
-    wifi_promiscuous_filter_t filter =
-        { .filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT || WIFI_PROMIS_FILTER_MASK_DATA_AMPDU };
-    f_retval = esp_wifi_set_promiscuous_filter(&filter);  // Only MGMT frames (no DATA or MISC frames)
-    if (f_retval != ESP_OK) {
-        ESP_LOGE(TAG, "esp_wifi_set_promiscuous_filter(&filter) err %d %s\n", f_retval, esp_err_to_name(f_retval));
-        // GOTO
-        goto cleanup;
-    }
-
-    f_retval = esp_wifi_set_promiscuous_rx_cb(_promiscuous_rx_cb);
-    if (f_retval != ESP_OK) {
-        ESP_LOGE(TAG, "esp_wifi_set_promiscuous_rx_cb() err %d %s\n", f_retval, esp_err_to_name(f_retval));
-        // GOTO
-        goto cleanup;
-    }
-
-    f_retval = esp_wifi_set_promiscuous(true);
-    if (f_retval != ESP_OK) {
-        ESP_LOGE(TAG, "esp_wifi_set_promiscuous(true) err %d %s\n", f_retval, esp_err_to_name(f_retval));
-        // GOTO
-        goto cleanup;
-    }
-
-    // TASK MGT: wifi_channel_switcher_task
-    xReturned = xTaskCreatePinnedToCore(&_wifi_channel_switcher_task, "_wifi_channel_switcher_task (name)",
-    MYAPP_RTOS_TASK_STACK_SIZE_16K, NULL,
+    // TASK MGT: packet_parser_task (the consumer of the sniffer)
+    xReturned = xTaskCreatePinnedToCore(&_packet_parser_task, "_packet_parser_task (name)", MYAPP_RTOS_TASK_STACK_SIZE_16K,
+    NULL,
     MYAPP_RTOS_TASK_PRIORITY_NORMAL, NULL, APP_CPU_NUM);
     if (xReturned != pdPASS) {
-        ESP_LOGE(TAG, "Cannot create task _wifi_channel_switcher_task");
+        ESP_LOGE(TAG, "Cannot create task _packet_parser_task");
         // GOTO
         goto cleanup;
+
     }
 
     // TASK MGT: station_purger_task
@@ -0,0 +1,89 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+#ifndef __MJD_HTTP_PARSER_H__
+#define __MJD_HTTP_PARSER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Includes: system, own
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/**********
+ * HTTP/1.1 RESPONSE PARSER
+ *
+ * @doc Pure logic (no sockets) so the host tests can feed it any split of the bytes:
+ *      - The status line and the headers are parsed incrementally, byte by byte, into a fixed line buffer (no malloc).
+ *        Only the headers that the client needs are kept: Content-Length, Transfer-Encoding, Connection, Content-Range.
+ *      - The body is framed by Content-Length, by the chunked transfer coding (decoded here) or by the end of the connection.
+ *      - The parser stops at the end of the response: the bytes of the next response (pipelining) are not consumed.
+ * @doc The body bytes are returned as segments that point into the input: no copy. Raw body bytes (Content-Length, chunk data)
+ *      can also be received by the caller directly into its own buffer: mjd_http_parser_get_raw_body_len() + mjd_http_parser_skip_body().
+ *
+ * @important A header line longer than MJD_HTTP_PARSER_MAX_LINE_LEN is truncated (its value is lost): fine for the headers above.
+ */
+#define MJD_HTTP_PARSER_MAX_LINE_LEN (256)
+
+typedef enum {
+    MJD_HTTP_PARSER_STATE_STATUS_LINE = 0,
+    MJD_HTTP_PARSER_STATE_HEADER_LINE,
+    MJD_HTTP_PARSER_STATE_BODY_LENGTH,      /*!< Content-Length */
+    MJD_HTTP_PARSER_STATE_BODY_UNTIL_CLOSE, /*!< No Content-Length, not chunked: the body ends when the server closes */
+    MJD_HTTP_PARSER_STATE_CHUNK_SIZE_LINE,
+    MJD_HTTP_PARSER_STATE_CHUNK_DATA,
+    MJD_HTTP_PARSER_STATE_CHUNK_DATA_END,   /*!< The CRLF after the chunk data */
+    MJD_HTTP_PARSER_STATE_TRAILER_LINE,
+    MJD_HTTP_PARSER_STATE_DONE,
+    MJD_HTTP_PARSER_STATE_ERROR,
+} mjd_http_parser_state_t;
+
+/**
+ * @brief The response head. Valid when is_head_complete.
+ */
+typedef struct {
+    int status_code;
+    int64_t content_length;  /*!< -1 = not known (chunked, or until close) */
+    bool is_chunked;
+    bool is_keep_alive;      /*!< The server keeps the connection open after this response */
+    int64_t range_start;     /*!< Content-Range: bytes <start>-<end>/<total>. -1 = no Content-Range */
+    int64_t range_end;
+    int64_t total_length;    /*!< -1 = no Content-Range, or the total is unknown (an asterisk) */
+} mjd_http_response_t;
+
+typedef struct {
+    mjd_http_parser_state_t state;
+    bool is_head_request;    /*!< A response to HEAD has no body */
+    bool is_head_complete;
+    mjd_http_response_t response;
+    uint64_t remaining;      /*!< The bytes left of the body (Content-Length) or of the chunk */
+    uint64_t nbr_of_body_bytes;
+    uint32_t line_len;
+    char line[MJD_HTTP_PARSER_MAX_LINE_LEN];
+} mjd_http_parser_t;
+
+/**
+ * Function declarations
+ */
+void mjd_http_parser_init(mjd_http_parser_t* param_ptr_parser, bool param_is_head_request);
+esp_err_t mjd_http_parser_execute(mjd_http_parser_t* param_ptr_parser, const uint8_t * param_ptr_data, size_t param_len,
+                                  size_t param_max_body_len, size_t * param_ptr_consumed, const uint8_t ** param_ptr_body,
+                                  size_t * param_ptr_body_len);
+esp_err_t mjd_http_parser_finish_on_close(mjd_http_parser_t* param_ptr_parser);
+size_t mjd_http_parser_get_raw_body_len(const mjd_http_parser_t* param_ptr_parser);
+void mjd_http_parser_skip_body(mjd_http_parser_t* param_ptr_parser, size_t param_len);
+bool mjd_http_parser_is_done(const mjd_http_parser_t* param_ptr_parser);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MJD_HTTP_PARSER_H__ */
@@ -0,0 +1,361 @@
+/*
+ * Goto the README.md for instructions
+ *
+ */
+
+#include <strings.h>
+
+// Component header file(s)
+#include "mjd.h"
+#include "mjd_http_parser.h"
+
+/*
+ * Logging
+ */
+static const char TAG[] = "mjd_http_parser";
+
+/**************************************
+ * HELPERS
+ */
+
+/*
+ * @brief The value of the header param_ptr_name (case insensitive), leading spaces skipped. NULL = another header.
+ */
+static const char * _header_value(const char * param_ptr_line, const char * param_ptr_name) {
+    size_t len_name = strlen(param_ptr_name);
+
+    if (strncasecmp(param_ptr_line, param_ptr_name, len_name) != 0 || param_ptr_line[len_name] != ':') {
+        return NULL;
+    }
+    param_ptr_line += len_name + 1;
+    while (*param_ptr_line == ' ' || *param_ptr_line == '\t') {
+        param_ptr_line++;
+    }
+    return param_ptr_line;
+}
+
+/*
+ * @brief Is param_ptr_token an element of the comma separated list param_ptr_value (case insensitive)?
+ */
+static bool _has_token(const char * param_ptr_value, const char * param_ptr_token) {
+    size_t len_token = strlen(param_ptr_token);
+
+    while (*param_ptr_value != '\0') {
+        while (*param_ptr_value == ' ' || *param_ptr_value == '\t' || *param_ptr_value == ',') {
+            param_ptr_value++;
+        }
+        if (strncasecmp(param_ptr_value, param_ptr_token, len_token) == 0
+                && (param_ptr_value[len_token] == '\0' || param_ptr_value[len_token] == ',' || param_ptr_value[len_token] == ' '
+                        || param_ptr_value[len_token] == ';')) {
+            return true;
+        }
+        while (*param_ptr_value != '\0' && *param_ptr_value != ',') {
+            param_ptr_value++;
+        }
+    }
+    return false;
+}
+
+/*
+ * @brief A decimal (param_base 10) or hex (16) number. Stops at the first other character.
+ *
+ * @return false when there is no digit, or on an overflow.
+ */
+static bool _parse_uint64(const char * param_ptr_text, uint32_t param_base, uint64_t * param_ptr_value, const char ** param_ptr_end) {
+    uint64_t value = 0;
+    const char *ptr = param_ptr_text;
+
+    for (;; ptr++) {
+        uint32_t digit;
+        if (*ptr >= '0' && *ptr <= '9') {
+            digit = *ptr - '0';
+        } else if (param_base == 16 && *ptr >= 'a' && *ptr <= 'f') {
+            digit = *ptr - 'a' + 10;
+        } else if (param_base == 16 && *ptr >= 'A' && *ptr <= 'F') {
+            digit = *ptr - 'A' + 10;
+        } else {
+            break;
+        }
+        if (value > (UINT64_MAX - digit) / param_base) {
+            return false;
+        }
+        value = value * param_base + digit;
+    }
+    *param_ptr_value = value;
+    if (param_ptr_end != NULL) {
+        *param_ptr_end = ptr;
+    }
+    return (ptr != param_ptr_text);
+}
+
+static void _set_error(mjd_http_parser_t* param_ptr_parser, const char * param_ptr_reason) {
+    ESP_LOGE(TAG, "%s(). Invalid response: %s | line \"%.40s\"", __FUNCTION__, param_ptr_reason, param_ptr_parser->line);
+    param_ptr_parser->state = MJD_HTTP_PARSER_STATE_ERROR;
+}
+
+/**************************************
+ * LINES
+ */
+static void _on_status_line(mjd_http_parser_t* param_ptr_parser) {
+    const char *ptr = param_ptr_parser->line;
+    uint64_t status_code;
+
+    // HTTP/1.x SSS Reason
+    if (strncmp(ptr, "HTTP/1.", 7) != 0 || (ptr[7] != '0' && ptr[7] != '1') || ptr[8] != ' ') {
+        _set_error(param_ptr_parser, "status line");
+        return;
+    }
+    if (_parse_uint64(ptr + 9, 10, &status_code, &ptr) == false || status_code < 100 || status_code > 999) {
+        _set_error(param_ptr_parser, "status code");
+        return;
+    }
+    param_ptr_parser->response.status_code = (int) status_code;
+    param_ptr_parser->response.is_keep_alive = (param_ptr_parser->line[7] == '1'); // @doc The default of HTTP/1.1 is keep-alive
+    param_ptr_parser->state = MJD_HTTP_PARSER_STATE_HEADER_LINE;
+}
+
+static void _on_end_of_head(mjd_http_parser_t* param_ptr_parser) {
+    mjd_http_response_t *ptr_response = &param_ptr_parser->response;
+
+    // 1xx: an interim response (e.g. 100 Continue), the real one follows
+    if (ptr_response->status_code < 200) {
+        param_ptr_parser->state = MJD_HTTP_PARSER_STATE_STATUS_LINE;
+        return;
+    }
+
+    param_ptr_parser->is_head_complete = true;
+    if (param_ptr_parser->is_head_request == true || ptr_response->status_code == 204 || ptr_response->status_code == 304) {
+        param_ptr_parser->state = MJD_HTTP_PARSER_STATE_DONE;
+    } else if (ptr_response->is_chunked == true) {
+        ptr_response->content_length = -1;
+        param_ptr_parser->state = MJD_HTTP_PARSER_STATE_CHUNK_SIZE_LINE;
+    } else if (ptr_response->content_length == 0) {
+        param_ptr_parser->state = MJD_HTTP_PARSER_STATE_DONE;
+    } else if (ptr_response->content_length > 0) {
+        param_ptr_parser->remaining = (uint64_t) ptr_response->content_length;
+        param_ptr_parser->state = MJD_HTTP_PARSER_STATE_BODY_LENGTH;
+    } else {
+        ptr_response->is_keep_alive = false;
+        param_ptr_parser->state = MJD_HTTP_PARSER_STATE_BODY_UNTIL_CLOSE;
+    }
+}
+
+static void _on_header_line(mjd_http_parser_t* param_ptr_parser) {
+    mjd_http_response_t *ptr_response = &param_ptr_parser->response;
+    const char *ptr_value;
+    uint64_t value;
+
+    if (param_ptr_parser->line_len == 0) {
+        _on_end_of_head(param_ptr_parser);
+        return;
+    }
+
+    if ((ptr_value = _header_value(param_ptr_parser->line, "Content-Length")) != NULL) {
+        if (_parse_uint64(ptr_value, 10, &value, NULL) == false || value > INT64_MAX) {
+            _set_error(param_ptr_parser, "Content-Length");
+            return;
+        }
+        ptr_response->content_length = (int64_t) value;
+    } else if ((ptr_value = _header_value(param_ptr_parser->line, "Transfer-Encoding")) != NULL) {
+        ptr_response->is_chunked = _has_token(ptr_value, "chunked");
+    } else if ((ptr_value = _header_value(param_ptr_parser->line, "Connection")) != NULL) {
+        if (_has_token(ptr_value, "close") == true) {
+            ptr_response->is_keep_alive = false;
+        } else if (_has_token(ptr_value, "keep-alive") == true) {
+            ptr_response->is_keep_alive = true;
+        }
+    } else if ((ptr_value = _header_value(param_ptr_parser->line, "Content-Range")) != NULL) {
+        // bytes <start>-<end>/<total> | bytes <start>-<end>/* | bytes */<total>
+        const char *ptr = ptr_value;
+        if (strncasecmp(ptr, "bytes ", 6) == 0) {
+            ptr += 6;
+            if (_parse_uint64(ptr, 10, &value, &ptr) == true && *ptr == '-') {
+                ptr_response->range_start = (int64_t) value;
+                if (_parse_uint64(ptr + 1, 10, &value, &ptr) == true) {
+                    ptr_response->range_end = (int64_t) value;
+                }
+            }
+            ptr = strchr(ptr, '/');
+            if (ptr != NULL && _parse_uint64(ptr + 1, 10, &value, NULL) == true) {
+                ptr_response->total_length = (int64_t) value;
+            }
+        }
+    }
+}
+
+static void _on_chunk_size_line(mjd_http_parser_t* param_ptr_parser) {
+    uint64_t chunk_size;
+    const char *ptr_end;
+
+    // <hex size>[;extensions]
+    if (_parse_uint64(param_ptr_parser->line, 16, &chunk_size, &ptr_end) == false
+            || (*ptr_end != '\0' && *ptr_end != ';' && *ptr_end != ' ' && *ptr_end != '\t')) {
+        _set_error(param_ptr_parser, "chunk size");
+        return;
+    }
+    if (chunk_size == 0) {
+        param_ptr_parser->state = MJD_HTTP_PARSER_STATE_TRAILER_LINE;
+    } else {
+        param_ptr_parser->remaining = chunk_size;
+        param_ptr_parser->state = MJD_HTTP_PARSER_STATE_CHUNK_DATA;
+    }
+}
+
+static void _on_line(mjd_http_parser_t* param_ptr_parser) {
+    switch (param_ptr_parser->state) {
+    case MJD_HTTP_PARSER_STATE_STATUS_LINE:
+        if (param_ptr_parser->line_len == 0) {
+            break; // @doc Tolerate an empty line before the status line (RFC 7230 3.5)
+        }
+        _on_status_line(param_ptr_parser);
+        break;
+    case MJD_HTTP_PARSER_STATE_HEADER_LINE:
+        _on_header_line(param_ptr_parser);
+        break;
+    case MJD_HTTP_PARSER_STATE_CHUNK_SIZE_LINE:
+        _on_chunk_size_line(param_ptr_parser);
+        break;
+    case MJD_HTTP_PARSER_STATE_CHUNK_DATA_END:
+        if (param_ptr_parser->line_len != 0) {
+            _set_error(param_ptr_parser, "no CRLF after the chunk data");
+            break;
+        }
+        param_ptr_parser->state = MJD_HTTP_PARSER_STATE_CHUNK_SIZE_LINE;
+        break;
+    case MJD_HTTP_PARSER_STATE_TRAILER_LINE:
+        if (param_ptr_parser->line_len == 0) {
+            param_ptr_parser->state = MJD_HTTP_PARSER_STATE_DONE;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/**************************************
+ * PUBLIC
+ */
+
+/*
+ * @brief Reset the parser for the next response.
+ */
+void mjd_http_parser_init(mjd_http_parser_t* param_ptr_parser, bool param_is_head_request) {
+    memset(param_ptr_parser, 0, sizeof(*param_ptr_parser));
+    param_ptr_parser->state = MJD_HTTP_PARSER_STATE_STATUS_LINE;
+    param_ptr_parser->is_head_request = param_is_head_request;
+    param_ptr_parser->response.content_length = -1;
+    param_ptr_parser->response.range_start = -1;
+    param_ptr_parser->response.range_end = -1;
+    param_ptr_parser->response.total_length = -1;
+}
+
+/*
+ * @brief Parse the next bytes of the response. It returns (with the bytes that it consumed) when:
+ *        - the head just completed (is_head_complete), or
+ *        - it found a body segment: *param_ptr_body points into param_ptr_data (max param_max_body_len bytes), or
+ *        - the response is done (the rest of the input is not consumed), or
+ *        - all the input was consumed.
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_RESPONSE The response is malformed (the parser stays in the ERROR state)
+ */
+esp_err_t mjd_http_parser_execute(mjd_http_parser_t* param_ptr_parser, const uint8_t * param_ptr_data, size_t param_len,
+                                  size_t param_max_body_len, size_t * param_ptr_consumed, const uint8_t ** param_ptr_body,
+                                  size_t * param_ptr_body_len) {
+    size_t pos = 0;
+
+    *param_ptr_body = NULL;
+    *param_ptr_body_len = 0;
+
+    while (pos < param_len) {
+        mjd_http_parser_state_t state = param_ptr_parser->state;
+
+        if (state == MJD_HTTP_PARSER_STATE_DONE || state == MJD_HTTP_PARSER_STATE_ERROR) {
+            break;
+        }
+        if (state == MJD_HTTP_PARSER_STATE_BODY_LENGTH || state == MJD_HTTP_PARSER_STATE_CHUNK_DATA
+                || state == MJD_HTTP_PARSER_STATE_BODY_UNTIL_CLOSE) {
+            size_t len = param_len - pos;
+            if (len > param_max_body_len) {
+                len = param_max_body_len;
+            }
+            if (state != MJD_HTTP_PARSER_STATE_BODY_UNTIL_CLOSE && len > param_ptr_parser->remaining) {
+                len = (size_t) param_ptr_parser->remaining;
+            }
+            if (len == 0) {
+                break;
+            }
+            *param_ptr_body = param_ptr_data + pos;
+            *param_ptr_body_len = len;
+            pos += len;
+            mjd_http_parser_skip_body(param_ptr_parser, len);
+            break;
+        }
+
+        // A line state
+        char c = (char) param_ptr_data[pos++];
+        if (c != '\n') {
+            if (param_ptr_parser->line_len < MJD_HTTP_PARSER_MAX_LINE_LEN - 1) {
+                param_ptr_parser->line[param_ptr_parser->line_len++] = c;
+            }
+            continue;
+        }
+        if (param_ptr_parser->line_len > 0 && param_ptr_parser->line[param_ptr_parser->line_len - 1] == '\r') {
+            param_ptr_parser->line_len--;
+        }
+        param_ptr_parser->line[param_ptr_parser->line_len] = '\0';
+        bool was_head_complete = param_ptr_parser->is_head_complete;
+        _on_line(param_ptr_parser);
+        param_ptr_parser->line_len = 0;
+        if (was_head_complete == false && param_ptr_parser->is_head_complete == true) {
+            break;
+        }
+    }
+
+    *param_ptr_consumed = pos;
+
+    return (param_ptr_parser->state == MJD_HTTP_PARSER_STATE_ERROR) ? ESP_ERR_INVALID_RESPONSE : ESP_OK;
+}
+
+/*
+ * @brief The server closed the connection: that ends a body without a length, any other state is a truncated response.
+ */
+esp_err_t mjd_http_parser_finish_on_close(mjd_http_parser_t* param_ptr_parser) {
+    if (param_ptr_parser->state == MJD_HTTP_PARSER_STATE_BODY_UNTIL_CLOSE || param_ptr_parser->state == MJD_HTTP_PARSER_STATE_DONE) {
+        param_ptr_parser->state = MJD_HTTP_PARSER_STATE_DONE;
+        return ESP_OK;
+    }
+    param_ptr_parser->state = MJD_HTTP_PARSER_STATE_ERROR;
+    return ESP_ERR_INVALID_RESPONSE;
+}
+
+/*
+ * @brief The number of body bytes that follow as is (no framing in between): the caller may receive them directly into its buffer
+ *        and then call mjd_http_parser_skip_body(). 0 = the next bytes must go through mjd_http_parser_execute().
+ */
+size_t mjd_http_parser_get_raw_body_len(const mjd_http_parser_t* param_ptr_parser) {
+    if (param_ptr_parser->state == MJD_HTTP_PARSER_STATE_BODY_LENGTH || param_ptr_parser->state == MJD_HTTP_PARSER_STATE_CHUNK_DATA) {
+        return (param_ptr_parser->remaining > SIZE_MAX) ? SIZE_MAX : (size_t) param_ptr_parser->remaining;
+    }
+    if (param_ptr_parser->state == MJD_HTTP_PARSER_STATE_BODY_UNTIL_CLOSE) {
+        return SIZE_MAX;
+    }
+    return 0;
+}
+
+void mjd_http_parser_skip_body(mjd_http_parser_t* param_ptr_parser, size_t param_len) {
+    param_ptr_parser->nbr_of_body_bytes += param_len;
+    if (param_ptr_parser->state == MJD_HTTP_PARSER_STATE_BODY_UNTIL_CLOSE) {
+        return;
+    }
+    param_ptr_parser->remaining -= param_len;
+    if (param_ptr_parser->remaining == 0) {
+        param_ptr_parser->state = (param_ptr_parser->state == MJD_HTTP_PARSER_STATE_BODY_LENGTH) ?
+                MJD_HTTP_PARSER_STATE_DONE : MJD_HTTP_PARSER_STATE_CHUNK_DATA_END;
+    }
+}
+
+bool mjd_http_parser_is_done(const mjd_http_parser_t* param_ptr_parser) {
+    return (param_ptr_parser->state == MJD_HTTP_PARSER_STATE_DONE);
+}
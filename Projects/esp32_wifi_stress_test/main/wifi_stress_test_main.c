@@ -3,9 +3,8 @@
  *  *NONE
  *
  */
-#include "esp_http_client.h"
-
 #include "mjd.h"
+#include "mjd_http.h"
 #include "mjd_huzzah32.h"
 #include "mjd_net.h"
 #include "mjd_wifi.h"
@@ -36,43 +35,6 @@ static const char *MY_WIFI_PASSWORD = CONFIG_MY_WIFI_PASSWORD;
 #define MYAPP_RTOS_TASK_STACK_SIZE_LARGE (8192)
 #define MYAPP_RTOS_TASK_PRIORITY_NORMAL (RTOS_TASK_PRIORITY_NORMAL)
 
-/*
- * HELPERS
- */
-extern const char howsmyssl_com_root_cert_pem_start[] asm("_binary_howsmyssl_com_root_cert_pem_start");
-extern const char howsmyssl_com_root_cert_pem_end[] asm("_binary_howsmyssl_com_root_cert_pem_end");
-
-esp_err_t _http_event_handler(esp_http_client_event_t *evt) {
-    switch (evt->event_id) {
-    case HTTP_EVENT_ERROR:
-        ESP_LOGD(TAG, "HTTP_EVENT_ERROR");
-        break;
-    case HTTP_EVENT_ON_CONNECTED:
-        ESP_LOGD(TAG, "HTTP_EVENT_ON_CONNECTED");
-        break;
-    case HTTP_EVENT_HEADER_SENT:
-        ESP_LOGD(TAG, "HTTP_EVENT_HEADER_SENT");
-        break;
-    case HTTP_EVENT_ON_HEADER:
-        ESP_LOGD(TAG, "HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
-        break;
-    case HTTP_EVENT_ON_DATA:
-        ESP_LOGD(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-        if (!esp_http_client_is_chunked_response(evt->client)) {
-            // Write out data
-            // printf("%.*s", evt->data_len, (char*)evt->data);
-        }
-        break;
-    case HTTP_EVENT_ON_FINISH:
-        ESP_LOGD(TAG, "HTTP_EVENT_ON_FINISH");
-        break;
-    case HTTP_EVENT_DISCONNECTED:
-        ESP_LOGD(TAG, "HTTP_EVENT_DISCONNECTED");
-        break;
-    }
-    return ESP_OK;
-}
-
 /*
  * WIFI SCANNER
  */
@@ -126,30 +88,50 @@ static esp_err_t _wifi_scanner() {
 }
 
 /*
- * HTTPS
+ * HTTP DOWNLOAD BENCHMARK
+ *
+ * @doc 3 downloads of a 1MB file on 1 kept-alive connection: the throughput (KB/s), the time to first byte and the heap churn
+ *      per request. The body is streamed through a 4KB buffer (nothing is stored).
  */
-static void _https() {
-    /*esp_http_client_config_t config =
-        { .url = "https://www.howsmyssl.com", .event_handler = _http_event_handler, .cert_pem = howsmyssl_com_root_cert_pem_start, };*/
+#define MYAPP_HTTP_HOST "ipv4.download.thinkbroadband.com"
+#define MYAPP_HTTP_PATH "/1MB.zip"
+#define MYAPP_HTTP_NBR_OF_REQUESTS (3)
 
-    /*esp_http_client_config_t config =
-        { .url = "http://ipv4.download.thinkbroadband.com/10MB.zip", .event_handler = _http_event_handler };*/
+static mjd_http_client_t _http_client;
+static uint8_t _http_buffer[4096];
+
+static esp_err_t _http_benchmark() {
+    esp_err_t f_retval = ESP_OK;
 
-    esp_http_client_config_t config =
-        { .url = "http://ipv4.download.thinkbroadband.com/1MB.zip", .event_handler = _http_event_handler };
+    mjd_http_config_t http_config = MJD_HTTP_CONFIG_DEFAULT();
+    mjd_http_benchmark_result_t result;
 
-    ESP_LOGI(TAG, "    URL: %s", config.url);
-    esp_http_client_handle_t client = esp_http_client_init(&config);
+    ESP_LOGI(TAG, "    URL: http://%s%s", MYAPP_HTTP_HOST, MYAPP_HTTP_PATH);
 
-    esp_err_t err = esp_http_client_perform(client);
+    http_config.host = MYAPP_HTTP_HOST;
+    f_retval = mjd_http_init(&_http_client, &http_config);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "mjd_http_init() err %i (%s)", f_retval, esp_err_to_name(f_retval));
+        // GOTO
+        goto cleanup;
+    }
 
-    if (err == ESP_OK) {
-        ESP_LOGI(TAG, "  OK. HTTP(S) Status = %d, content_length = %d", esp_http_client_get_status_code(client), esp_http_client_get_content_length(client));
+    f_retval = mjd_http_benchmark(&_http_client, MYAPP_HTTP_PATH, MYAPP_HTTP_NBR_OF_REQUESTS, _http_buffer, sizeof(_http_buffer),
+            &result);
+    if (f_retval != ESP_OK) {
+        ESP_LOGE(TAG, "  ERROR. mjd_http_benchmark() err %i (%s)", f_retval, esp_err_to_name(f_retval));
     } else {
-        ESP_LOGE(TAG, "  ERROR. HTTP(S) request err %s", esp_err_to_name(err));
+        ESP_LOGI(TAG, "  OK");
     }
+    mjd_http_log_benchmark(MYAPP_HTTP_PATH, &result);
+    mjd_http_log_stats(&_http_client);
 
-    esp_http_client_cleanup(client);
+    mjd_http_deinit(&_http_client);
+
+    // LABEL
+    cleanup: ;
+
+    return f_retval;
 }
 
 /*
@@ -306,12 +288,9 @@ void main_task(void *pvParameter) {
         // ***Wifi scanner
         _wifi_scanner();
 
-        // ***HTTPS/TLS REQUEST 2x times
-        ESP_LOGI(TAG, "HTTPS requests (3x)");
-        for (uint32_t u = 1; u <= 3; u++) {
-            ESP_LOGI(TAG, "  START #%u", u);
-            _https();
-        }
+        // ***HTTP download benchmark (3 requests, 1 kept-alive connection)
+        ESP_LOGI(TAG, "HTTP download benchmark (%ux)", MYAPP_HTTP_NBR_OF_REQUESTS);
+        _http_benchmark();
 
         // Disconnect
         f_retval = mjd_wifi_sta_disconnect_stop();